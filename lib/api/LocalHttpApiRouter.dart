@@ -0,0 +1,133 @@
+import 'package:vertree/api/LocalHttpApiContract.dart';
+
+class LocalHttpApiRouteMatch {
+  const LocalHttpApiRouteMatch({
+    required this.route,
+    required this.pathParameters,
+  });
+
+  final LocalHttpApiRoute route;
+  final Map<String, String> pathParameters;
+}
+
+/// 构造时把路由模板编译成按路径段组织的前缀树。
+///
+/// 匹配时逐段下降，字面量段优先于 `{param}` 段（必要时回溯），
+/// 因此一次请求只访问与路径深度成正比的节点，而不是逐个比对所有路由。
+class LocalHttpApiRouter {
+  LocalHttpApiRouter(Iterable<LocalHttpApiRoute> routes) {
+    for (final route in routes) {
+      _insert(route);
+    }
+  }
+
+  final _RouteTrieNode _root = _RouteTrieNode();
+
+  LocalHttpApiRouteMatch? match(String method, List<String> pathSegments) {
+    final parameterValues = <String>[];
+    final node = _find(_root, pathSegments, 0, parameterValues, method);
+    final entry = node?.routesByMethod[method];
+    if (entry == null) {
+      return null;
+    }
+
+    final pathParameters = <String, String>{};
+    for (var index = 0; index < entry.parameterNames.length; index++) {
+      pathParameters[entry.parameterNames[index]] = parameterValues[index];
+    }
+    return LocalHttpApiRouteMatch(
+      route: entry.route,
+      pathParameters: pathParameters,
+    );
+  }
+
+  /// 路径存在但方法不匹配时返回该路径支持的方法，便于返回 405
+  List<String> allowedMethods(List<String> pathSegments) {
+    final node = _find(_root, pathSegments, 0, <String>[], null);
+    return node?.routesByMethod.keys.toList(growable: false) ?? const [];
+  }
+
+  void _insert(LocalHttpApiRoute route) {
+    var node = _root;
+    final parameterNames = <String>[];
+    for (final segment in route.templateSegments) {
+      if (segment.startsWith('{') && segment.endsWith('}')) {
+        parameterNames.add(segment.substring(1, segment.length - 1));
+        node = node.parameterChild ??= _RouteTrieNode();
+      } else {
+        node = node.literalChildren.putIfAbsent(segment, _RouteTrieNode.new);
+      }
+    }
+
+    if (node.routesByMethod.containsKey(route.method)) {
+      throw ArgumentError(
+        'Duplicate local HTTP API route: ${route.method} ${route.pathTemplate}',
+      );
+    }
+    node.routesByMethod[route.method] = _RouteEntry(
+      route,
+      List.unmodifiable(parameterNames),
+    );
+  }
+
+  _RouteTrieNode? _find(
+    _RouteTrieNode node,
+    List<String> segments,
+    int index,
+    List<String> parameterValues,
+    String? method,
+  ) {
+    if (index == segments.length) {
+      final hasRoute = method == null
+          ? node.routesByMethod.isNotEmpty
+          : node.routesByMethod.containsKey(method);
+      return hasRoute ? node : null;
+    }
+
+    final segment = segments[index];
+    final literal = node.literalChildren[segment];
+    if (literal != null) {
+      final found = _find(
+        literal,
+        segments,
+        index + 1,
+        parameterValues,
+        method,
+      );
+      if (found != null) {
+        return found;
+      }
+    }
+
+    final parameterChild = node.parameterChild;
+    if (parameterChild != null) {
+      parameterValues.add(segment);
+      final found = _find(
+        parameterChild,
+        segments,
+        index + 1,
+        parameterValues,
+        method,
+      );
+      if (found != null) {
+        return found;
+      }
+      parameterValues.removeLast();
+    }
+    return null;
+  }
+}
+
+class _RouteTrieNode {
+  final Map<String, _RouteTrieNode> literalChildren =
+      <String, _RouteTrieNode>{};
+  final Map<String, _RouteEntry> routesByMethod = <String, _RouteEntry>{};
+  _RouteTrieNode? parameterChild;
+}
+
+class _RouteEntry {
+  const _RouteEntry(this.route, this.parameterNames);
+
+  final LocalHttpApiRoute route;
+  final List<String> parameterNames;
+}
@@ -1,23 +1,55 @@
 import 'dart:async';
 import 'dart:convert';
 import 'dart:io';
+import 'dart:typed_data';
 
 import 'package:vertree/api/LocalHttpApiContract.dart';
 import 'package:vertree/api/LocalHttpApiDocumentation.dart';
+import 'package:vertree/api/LocalHttpApiRouter.dart';
+import 'package:vertree/component/AppMetrics.dart';
+import 'package:vertree/core/Result.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/FileBatchService.dart';
 import 'package:vertree/service/LanFileShareServer.dart';
+import 'package:vertree/service/LineDiffService.dart';
 import 'package:vertree/service/LocalHttpApiService.dart';
+import 'package:vertree/service/VersionSearchService.dart';
+import 'package:vertree/service/VersionTreeCache.dart';
 
 class LocalHttpApiServer {
   LocalHttpApiServer({required this.apiService}) : _routes = [] {
     _routes.addAll(_buildRoutes());
+    _router = LocalHttpApiRouter(_routes);
   }
 
   static const int defaultPort = 31414;
   static const int maxPortSearchSpan = 200;
+  static const Duration eventStreamHeartbeatInterval = Duration(seconds: 15);
+  static const Duration keepAliveIdleTimeout = Duration(seconds: 30);
+  static const int maxBatchOperations = 200;
+  static const int maxBatchConcurrency = 8;
+  static const int maxFileBatchPaths = 10000;
+
+  /// 请求体上限；超过时回复 413 并关闭连接
+  static const int maxRequestBodyBytes = 4 << 20;
+
+  /// 复用的 JSON 编码器：直接编码为 UTF-8 分块写入响应，不构造中间字符串
+  static const JsonUtf8Encoder _jsonEncoder = JsonUtf8Encoder(
+    '  ',
+    null,
+    16 * 1024,
+  );
 
   final LocalHttpApiService apiService;
   final List<LocalHttpApiRoute> _routes;
+  late final LocalHttpApiRouter _router;
+
+  /// 每个请求的请求体只读取一次；在分发前就开始读取，保证 keep-alive
+  /// 连接上的请求体总被完整消费，后续（含 pipelined）请求可以继续复用连接。
+  /// 只有声明了请求体的路由把它读进内存，见 [_readBodyLimited] 与
+  /// [_discardBody]。
+  final Expando<Future<String>> _requestBodies = Expando<Future<String>>();
 
   HttpServer? _server;
   int? _port;
@@ -53,6 +85,7 @@ class LocalHttpApiServer {
           InternetAddress.loopbackIPv4,
           candidate,
         );
+        server.idleTimeout = keepAliveIdleTimeout;
         _server = server;
         _port = candidate;
         unawaited(_listen(server));
@@ -76,6 +109,7 @@ class LocalHttpApiServer {
     _port = null;
     if (server != null) {
       await server.close(force: true);
+      await apiService.versionTreeCache.clear();
       logger.info('Local HTTP API stopped');
     }
   }
@@ -95,6 +129,7 @@ class LocalHttpApiServer {
 
     try {
       if (!_isLoopbackRequest(request)) {
+        _discardBody(request);
         await _writeJson(
           request,
           statusCode: HttpStatus.forbidden,
@@ -112,6 +147,7 @@ class LocalHttpApiServer {
       if (pathSegments.length < 2 ||
           pathSegments[0] != 'api' ||
           pathSegments[1] != 'v1') {
+        _discardBody(request);
         await _writeJson(
           request,
           statusCode: HttpStatus.notFound,
@@ -129,6 +165,10 @@ class LocalHttpApiServer {
           .skip(2)
           .where((segment) => segment.isNotEmpty)
           .toList();
+      if (request.contentLength > maxRequestBodyBytes) {
+        await _writeBodyTooLarge(request, startedAt);
+        return;
+      }
       await _dispatch(request, route, startedAt);
     } catch (e) {
       logger.error('Local HTTP API request failed: $e');
@@ -145,15 +185,55 @@ class LocalHttpApiServer {
     List<String> route,
     DateTime startedAt,
   ) async {
-    for (final definition in _routes) {
-      if (!definition.matches(method: request.method, pathSegments: route)) {
-        continue;
+    final match = _router.match(request.method, route);
+    if (match != null) {
+      final definition = match.route;
+      if (definition.requestBody != null) {
+        _requestBodies[request] = _readBodyLimited(request)..ignore();
+      } else {
+        _discardBody(request);
+      }
+      final stopwatch = Stopwatch()..start();
+      try {
+        await definition.handler(request, match.pathParameters, startedAt);
+      } on _RequestBodyTooLarge {
+        await _writeBodyTooLarge(request, startedAt);
+      } finally {
+        _recordRequestMetrics(request, definition, stopwatch.elapsed);
       }
-      final pathParameters = definition.extractPathParameters(route);
-      await definition.handler(request, pathParameters, startedAt);
       return;
     }
 
+    _discardBody(request);
+    final allowedMethods = _router.allowedMethods(route);
+    if (allowedMethods.isNotEmpty) {
+      appMetrics.httpRequestsTotal.inc([
+        request.method,
+        'unmatched',
+        '${HttpStatus.methodNotAllowed}',
+      ]);
+      request.response.headers.set(
+        HttpHeaders.allowHeader,
+        allowedMethods.join(', '),
+      );
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.methodNotAllowed,
+        body: _errorBody(
+          request,
+          'METHOD_NOT_ALLOWED',
+          'Supported methods: ${allowedMethods.join(', ')}.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    appMetrics.httpRequestsTotal.inc([
+      request.method,
+      'unmatched',
+      '${HttpStatus.notFound}',
+    ]);
     await _writeJson(
       request,
       statusCode: HttpStatus.notFound,
@@ -161,6 +241,22 @@ class LocalHttpApiServer {
     );
   }
 
+  void _recordRequestMetrics(
+    HttpRequest request,
+    LocalHttpApiRoute definition,
+    Duration elapsed,
+  ) {
+    final labels = [request.method, definition.pathTemplate];
+    // 长连接的事件流只计数，不计入延迟直方图
+    if (definition.responseContentType != 'text/event-stream') {
+      appMetrics.httpRequestSeconds.observeDuration(elapsed, labels);
+    }
+    appMetrics.httpRequestsTotal.inc([
+      ...labels,
+      '${request.response.statusCode}',
+    ]);
+  }
+
   List<LocalHttpApiRoute> _buildRoutes() {
     return [
       LocalHttpApiRoute(
@@ -201,6 +297,16 @@ class LocalHttpApiServer {
         tags: const ['system'],
         handler: _handleHealth,
       ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/metrics',
+        summary: 'Read runtime metrics in Prometheus format',
+        description:
+            'Returns counters, gauges and latency histograms for snapshots, monitor events, tree builds and API requests in the Prometheus text exposition format.',
+        tags: const ['system'],
+        responseContentType: 'text/plain',
+        handler: _handleMetrics,
+      ),
       LocalHttpApiRoute(
         method: 'POST',
         pathTemplate: '/app/quit',
@@ -422,6 +528,98 @@ class LocalHttpApiServer {
         ),
         handler: _handleUiScreenshot,
       ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/batch',
+        summary: 'Run many API operations in one round trip',
+        description:
+            'Runs a list of named service operations with bounded parallelism and returns one result per operation in request order.',
+        tags: const ['automation'],
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'Operations to run and optional parallelism.',
+          fields: [
+            LocalHttpApiField(
+              name: 'operations',
+              type: 'array',
+              description:
+                  'Items of {"id"?: string, "op": string, "params"?: object}. Supported op values: health, listMonitorTasks, getMonitorTask, createMonitorTask, updateMonitorTask, deleteMonitorTask, createBackup, listBackups, listVersionFiles, getVersionTree, compareFiles, searchVersions, getIntegrityScrub, getVersionPack, getDiskUsage, getColdPack, listFileShares.',
+              required: true,
+              example: [
+                {'id': 'tasks', 'op': 'listMonitorTasks'},
+                {
+                  'id': 'tree',
+                  'op': 'getVersionTree',
+                  'params': {'path': r'D:\project\storyboard.0.1.txt'},
+                },
+              ],
+            ),
+            LocalHttpApiField(
+              name: 'concurrency',
+              type: 'integer',
+              description:
+                  'How many operations may run at once (1-8). Defaults to 1, which keeps mutating operations in order.',
+              required: false,
+              example: 4,
+            ),
+            LocalHttpApiField(
+              name: 'stopOnError',
+              type: 'boolean',
+              description:
+                  'Skip operations that have not started yet once one fails.',
+              required: false,
+              example: false,
+            ),
+          ],
+        ),
+        handler: _handleBatch,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/file-batches',
+        summary: 'Back up or monitor many files at once',
+        description:
+            'Runs one action for every given file with bounded parallelism, the same way a multi-selection from a file manager does. Files of one version family run in order; the response lists one result per path in request order.',
+        tags: const ['backup'],
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'The action, the files and optional parallelism.',
+          fields: [
+            LocalHttpApiField(
+              name: 'action',
+              type: 'string',
+              description: 'One of backup, express-backup or monit.',
+              required: true,
+              example: 'express-backup',
+            ),
+            LocalHttpApiField(
+              name: 'paths',
+              type: 'array',
+              description:
+                  'Absolute file paths. Duplicates are dropped; missing files and folders are reported as failed items.',
+              required: true,
+              example: [
+                r'D:\project\storyboard.0.1.txt',
+                r'D:\project\notes.txt',
+              ],
+            ),
+            LocalHttpApiField(
+              name: 'label',
+              type: 'string',
+              description: 'Optional label for every backup.',
+              required: false,
+              example: 'baseline',
+            ),
+            LocalHttpApiField(
+              name: 'concurrency',
+              type: 'integer',
+              description:
+                  'How many version families may run at once (1-8). Defaults to the app setting.',
+              required: false,
+              example: 4,
+            ),
+          ],
+        ),
+        handler: _handleFileBatch,
+      ),
       LocalHttpApiRoute(
         method: 'GET',
         pathTemplate: '/monitor-tasks',
@@ -548,7 +746,7 @@ class LocalHttpApiServer {
         pathTemplate: '/backups',
         summary: 'List backups for one file',
         description:
-            'Lists files in the derived backup directory for the given source file path.',
+            'Lists snapshots in the derived backup directory for the given source file path, newest first. Sharded backup directories are answered from their snapshot index.',
         tags: const ['backup'],
         queryParameters: const [
           LocalHttpApiField(
@@ -558,9 +756,51 @@ class LocalHttpApiServer {
             required: true,
             example: r'D:\project\storyboard.0.1.txt',
           ),
+          LocalHttpApiField(
+            name: 'from',
+            type: 'string',
+            description:
+                'ISO 8601 time; only snapshots taken at or after it are listed.',
+            required: false,
+            example: '2026-01-01T00:00:00',
+          ),
+          LocalHttpApiField(
+            name: 'to',
+            type: 'string',
+            description:
+                'ISO 8601 time; only snapshots taken before it are listed.',
+            required: false,
+            example: '2026-02-01T00:00:00',
+          ),
         ],
         handler: _handleListBackups,
       ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/version-copies',
+        summary: 'List running version copies',
+        description:
+            'Lists backups and branches whose copy is still running, with bytes copied so far, total bytes and the offset a resumed copy started from. Large copies also report progress as version.copy-progress events.',
+        tags: const ['backup'],
+        handler: _handleListVersionCopies,
+      ),
+      LocalHttpApiRoute(
+        method: 'DELETE',
+        pathTemplate: '/version-copies/{id}',
+        summary: 'Cancel one version copy',
+        description:
+            'Stops a running backup or branch copy before its next chunk and deletes the temporary file. The request that started the copy fails; no version file is created.',
+        tags: const ['backup'],
+        pathParameters: const [
+          LocalHttpApiField(
+            name: 'id',
+            type: 'string',
+            description: 'Copy id from GET /version-copies.',
+            required: true,
+          ),
+        ],
+        handler: _handleCancelVersionCopy,
+      ),
       LocalHttpApiRoute(
         method: 'GET',
         pathTemplate: '/version-files',
@@ -656,7 +896,7 @@ class LocalHttpApiServer {
         pathTemplate: '/version-trees',
         summary: 'Build a version tree',
         description:
-            'Builds the version tree for the given file and returns the nested structure.',
+            'Builds the version tree for the given file. Returns the nested structure by default, or a cursor-paginated flat node list with format=flat. Responses carry a strong ETag derived from the version files in the directory; send it back in If-None-Match to get 304 Not Modified while nothing changed.',
         tags: const ['version-tree'],
         queryParameters: const [
           LocalHttpApiField(
@@ -666,95 +906,513 @@ class LocalHttpApiServer {
             required: true,
             example: r'D:\project\storyboard.0.1.txt',
           ),
+          LocalHttpApiField(
+            name: 'format',
+            type: 'string',
+            description:
+                'nested (default) returns the tree under root; flat returns one page of nodes with parentVersion and relation.',
+            example: 'flat',
+          ),
+          LocalHttpApiField(
+            name: 'depth',
+            type: 'integer',
+            description:
+                'Maximum branch nesting level to include. 0 returns only the main line.',
+            example: '1',
+          ),
+          LocalHttpApiField(
+            name: 'maxBranches',
+            type: 'integer',
+            description:
+                'Maximum number of branches returned per node. Omitted branches are reported as truncatedBranchCount.',
+            example: '20',
+          ),
+          LocalHttpApiField(
+            name: 'limit',
+            type: 'integer',
+            description:
+                'Nodes per page when format=flat. Default 500, maximum 5000.',
+            example: '500',
+          ),
+          LocalHttpApiField(
+            name: 'cursor',
+            type: 'string',
+            description:
+                'page.nextCursor from the previous flat page. Cursors expire when the tree changes.',
+          ),
+          LocalHttpApiField(
+            name: 'changes',
+            type: 'boolean',
+            description:
+                'When true, every node carries changeFromParent: the estimated fraction (0-1) of content that changed since its parent version, from content-defined chunk sketches. Works for binary files; null when no estimate is available. The first request computes sketches for versions that have none yet.',
+            example: 'true',
+          ),
         ],
         handler: _handleVersionTree,
       ),
       LocalHttpApiRoute(
         method: 'GET',
-        pathTemplate: '/monitor-tasks/{id}/backups',
-        summary: 'List monitor backups for one task',
+        pathTemplate: '/diffs',
+        summary: 'Compare two file versions line by line',
         description:
-            'Lists timestamped files from the monitor backup directory for a specific monitor task.',
-        tags: const ['monitoring'],
-        pathParameters: const [
+            'Runs the native line diff between two text files. Returns structured hunks by default; format=unified streams a unified diff as text/plain instead, so very large results never have to be held in memory. Binary files are rejected with 400.',
+        tags: const ['version-tree'],
+        queryParameters: const [
           LocalHttpApiField(
-            name: 'id',
+            name: 'old',
             type: 'string',
-            description: 'base64url-encoded normalized file path.',
+            description: 'Absolute path of the older version.',
+            required: true,
+            example: r'D:\project\storyboard.0.1.txt',
+          ),
+          LocalHttpApiField(
+            name: 'new',
+            type: 'string',
+            description: 'Absolute path of the newer version.',
             required: true,
+            example: r'D:\project\storyboard.0.2.txt',
+          ),
+          LocalHttpApiField(
+            name: 'format',
+            type: 'string',
+            description:
+                'hunks (default) returns JSON hunks with per-line kinds and line numbers; unified returns the text/plain unified diff.',
+            example: 'unified',
+          ),
+          LocalHttpApiField(
+            name: 'context',
+            type: 'integer',
+            description: 'Unchanged lines around each change. Default 3.',
+            example: '3',
+          ),
+          LocalHttpApiField(
+            name: 'maxLines',
+            type: 'integer',
+            description:
+                'Maximum number of hunk lines returned with format=hunks. Default 20000; truncated reports whether the limit was hit.',
+            example: '20000',
           ),
         ],
-        handler: _handleListMonitorTaskBackups,
+        handler: _handleDiff,
       ),
       LocalHttpApiRoute(
-        method: 'POST',
-        pathTemplate: '/monitor-tasks/{id}/verification-writes',
-        summary: 'Write to a monitored file and verify backup creation',
+        method: 'GET',
+        pathTemplate: '/version-searches',
+        summary: 'Search the text of every version in a tree',
         description:
-            'Appends text to the monitored file, waits briefly, and reports whether a new monitor backup was created.',
-        tags: const ['monitoring', 'testing'],
-        pathParameters: const [
+            'Finds the versions of a file family whose content contains a substring or matches a regular expression. A trigram index narrows the candidates and every hit is confirmed against the file content. Binary files and files over 16 MB are skipped.',
+        tags: const ['version-tree'],
+        queryParameters: const [
           LocalHttpApiField(
-            name: 'id',
+            name: 'path',
             type: 'string',
-            description: 'base64url-encoded normalized file path.',
+            description: 'Absolute path of any version in the tree.',
+            required: true,
+            example: r'D:\project\storyboard.0.1.txt',
+          ),
+          LocalHttpApiField(
+            name: 'q',
+            type: 'string',
+            description: 'Substring to find, or the pattern when regex=true.',
             required: true,
+            example: 'opening scene',
+          ),
+          LocalHttpApiField(
+            name: 'regex',
+            type: 'boolean',
+            description:
+                'Treat q as a Dart (JavaScript-style) regular expression. Default false.',
+            example: 'true',
+          ),
+          LocalHttpApiField(
+            name: 'caseSensitive',
+            type: 'boolean',
+            description: 'Default false.',
+            example: 'true',
+          ),
+          LocalHttpApiField(
+            name: 'includeBackups',
+            type: 'boolean',
+            description:
+                'Also search monitor snapshots in the _bak directories. Default false.',
+            example: 'true',
+          ),
+          LocalHttpApiField(
+            name: 'limit',
+            type: 'integer',
+            description:
+                'Maximum number of matching files, in version order. Default 200, maximum 5000.',
+            example: '200',
           ),
         ],
+        handler: _handleVersionSearch,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/integrity-scrubs',
+        summary: 'Start an integrity scrub of versions and backups',
+        description:
+            'Re-reads version files and monitor snapshots in the background and compares them with the checksum manifests written when they were copied. Reports corrupted, truncated, missing and unreadable files. Returns 409 while another scrub is running; poll GET /integrity-scrubs or listen for scrub.finished.',
+        tags: const ['monitoring', 'version-tree'],
+        successStatusCode: HttpStatus.accepted,
         requestBody: const LocalHttpApiRequestBody(
-          description: 'Verification write payload.',
+          description: 'Optional scope and options.',
           fields: [
             LocalHttpApiField(
-              name: 'appendText',
-              type: 'string',
+              name: 'paths',
+              type: 'array',
               description:
-                  'Text appended to the monitored file during verification.',
-              required: true,
-              example: '\napi-verification-write',
+                  'Absolute file paths whose version family and _bak directory are scrubbed. Defaults to every monitor task.',
+              required: false,
+              example: [r'D:\project\storyboard.0.1.txt'],
             ),
             LocalHttpApiField(
-              name: 'waitMilliseconds',
+              name: 'dropMissing',
+              type: 'boolean',
+              description:
+                  'Remove missing files from the manifests after reporting them. Default false.',
+              required: false,
+              example: false,
+            ),
+            LocalHttpApiField(
+              name: 'lowPriority',
+              type: 'boolean',
+              description:
+                  'Read one file at a time with idle I/O priority, as the scheduled scrub does. Default false.',
+              required: false,
+              example: false,
+            ),
+          ],
+        ),
+        handler: _handleStartIntegrityScrub,
+      ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/integrity-scrubs',
+        summary: 'Read integrity scrub progress and the last report',
+        description:
+            'Returns whether a scrub is running, its progress, and the report of the last finished scrub including up to 500 problems.',
+        tags: const ['monitoring', 'version-tree'],
+        handler: _handleGetIntegrityScrub,
+      ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/disk-usage',
+        summary: 'Read disk usage of all monitored backups',
+        description:
+            'Returns bytes and snapshot counts per monitor task, growth over the last 7 and 30 days, daily history of the total, the largest snapshots, and estimated savings from deduplication (by manifest checksums) and compression (by sampling). Results are cached and refreshed per task after snapshots and retention pruning.',
+        tags: const ['monitoring'],
+        queryParameters: const [
+          LocalHttpApiField(
+            name: 'refresh',
+            type: 'boolean',
+            description:
+                'Rescan every task before answering instead of returning the cached result. Default false.',
+            required: false,
+            example: false,
+          ),
+        ],
+        handler: _handleGetDiskUsage,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/cold-packs',
+        summary: 'Pack old monitor snapshots into cold storage',
+        description:
+            'Appends snapshots older than the given age to monthly .vtcold pack files under each _bak/.vertree.cold directory, then deletes the loose files. Runs one backup directory at a time in the background with a read throttle. Returns 409 while another run is in progress; poll GET /cold-packs or listen for cold-pack.finished, whose report includes inode and byte savings.',
+        tags: const ['monitoring'],
+        successStatusCode: HttpStatus.accepted,
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'Optional scope and age threshold.',
+          fields: [
+            LocalHttpApiField(
+              name: 'paths',
+              type: 'array',
+              description:
+                  'Monitored file paths whose _bak directories are packed. Defaults to every monitor task.',
+              required: false,
+              example: [r'D:\project\storyboard.txt'],
+            ),
+            LocalHttpApiField(
+              name: 'olderThanDays',
               type: 'integer',
               description:
-                  'How long to wait after the write before reading backup results.',
+                  'Pack snapshots older than this many days. Defaults to monitorColdPackDays, or 30 when packing is not scheduled.',
               required: false,
-              example: 1800,
+              example: 30,
             ),
           ],
         ),
-        handler: _handleVerifyMonitorTaskWrite,
+        handler: _handleStartColdPack,
       ),
-    ];
-  }
-
-  LocalHttpApiDocumentation get _documentation {
-    final serverUrl =
-        baseUrl ?? 'http://127.0.0.1:${_port ?? defaultPort}/api/v1';
-    return LocalHttpApiDocumentation(
-      title: 'Vertree Local HTTP API',
-      appVersion: apiService.currentVersion,
-      serverUrl: serverUrl,
-      routes: _routes,
-    );
-  }
-
-  Future<void> _handleApiIndex(
-    HttpRequest request,
-    Map<String, String> pathParameters,
-    DateTime startedAt,
-  ) async {
-    await _writeSuccess(
-      request,
-      data: _documentation.buildIndex(),
-      startedAt: startedAt,
-    );
-  }
-
-  Future<void> _handleOpenApiDocument(
-    HttpRequest request,
-    Map<String, String> pathParameters,
-    DateTime startedAt,
-  ) async {
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/cold-packs',
+        summary: 'Read cold packing progress and the last report',
+        description:
+            'Returns whether packing is running or scheduled, its progress, and the last report with packed counts, loose and stored bytes, and inode and byte savings per backup directory.',
+        tags: const ['monitoring'],
+        handler: _handleGetColdPack,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/cold-packs/restores',
+        summary: 'Restore one packed snapshot',
+        description:
+            'Reads one snapshot from its cold pack file by offset, verifies its XXH64 checksum and writes it with its original modification time. Without targetPath the snapshot is extracted to the system temp directory and reused on later calls. Existing target files are never overwritten.',
+        tags: const ['monitoring'],
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'Snapshot to restore.',
+          fields: [
+            LocalHttpApiField(
+              name: 'path',
+              type: 'string',
+              description: 'Monitored file path that owns the snapshot.',
+              example: r'D:\project\storyboard.txt',
+            ),
+            LocalHttpApiField(
+              name: 'name',
+              type: 'string',
+              description:
+                  'relativePath of a backup item whose storage is "pack".',
+              example: '2024/03/01/storyboard.txt_2024-03-01T09-00-00.bak.txt',
+            ),
+            LocalHttpApiField(
+              name: 'targetPath',
+              type: 'string',
+              description: 'Absolute path to write the snapshot to.',
+              required: false,
+              example: r'D:\restore\storyboard.txt',
+            ),
+          ],
+        ),
+        handler: _handleRestoreColdSnapshot,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/version-packs',
+        summary: 'Export a version family into one pack file',
+        description:
+            'Packs every version of the file family, optionally with its _bak monitor snapshots, into a single .vtpack file with a footer index, per-entry XXH64 checksums and optional zlib compression. Existing pack files are never overwritten.',
+        tags: const ['version-tree'],
+        successStatusCode: HttpStatus.created,
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'Family to export and pack options.',
+          fields: [
+            LocalHttpApiField(
+              name: 'path',
+              type: 'string',
+              description: 'Absolute path of any version in the family.',
+              required: true,
+              example: r'D:\project\storyboard.0.1.txt',
+            ),
+            LocalHttpApiField(
+              name: 'packPath',
+              type: 'string',
+              description:
+                  'Target .vtpack path. Defaults to <name>.vtpack next to the versions.',
+              required: false,
+              example: r'D:\exports\storyboard.vtpack',
+            ),
+            LocalHttpApiField(
+              name: 'includeBackups',
+              type: 'boolean',
+              description:
+                  'Also pack the <version>_bak monitor snapshot directories. Default false.',
+              required: false,
+              example: true,
+            ),
+            LocalHttpApiField(
+              name: 'compress',
+              type: 'boolean',
+              description:
+                  'Compress entries with zlib when it saves at least 1/8. Default true.',
+              required: false,
+              example: true,
+            ),
+          ],
+        ),
+        handler: _handleExportVersionPack,
+      ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/version-packs',
+        summary: 'Read the index of a version pack',
+        description:
+            'Reads only the footer index of a .vtpack file and lists its versions and snapshots with offsets, sizes and checksums.',
+        tags: const ['version-tree'],
+        queryParameters: const [
+          LocalHttpApiField(
+            name: 'path',
+            type: 'string',
+            description: 'Absolute path of the .vtpack file.',
+            required: true,
+            example: r'D:\exports\storyboard.vtpack',
+          ),
+        ],
+        handler: _handleGetVersionPack,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/version-packs/imports',
+        summary: 'Restore the files in a version pack',
+        description:
+            'Extracts every entry under its original name, verifying checksums. Identical existing files are skipped; different existing files are reported as conflicts and left untouched.',
+        tags: const ['version-tree'],
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'Pack to import.',
+          fields: [
+            LocalHttpApiField(
+              name: 'path',
+              type: 'string',
+              description: 'Absolute path of the .vtpack file.',
+              required: true,
+              example: r'D:\exports\storyboard.vtpack',
+            ),
+            LocalHttpApiField(
+              name: 'targetDirectory',
+              type: 'string',
+              description:
+                  'Directory to restore into. Defaults to the directory of the pack.',
+              required: false,
+              example: r'D:\project',
+            ),
+          ],
+        ),
+        handler: _handleImportVersionPack,
+      ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/events',
+        summary: 'Subscribe to monitor and backup activity',
+        description:
+            'Opens a long-lived text/event-stream. Each event carries a monotonic id; reconnect with the Last-Event-ID header (or lastEventId query) to replay buffered events that were missed.',
+        tags: const ['monitoring', 'automation'],
+        responseContentType: 'text/event-stream',
+        queryParameters: const [
+          LocalHttpApiField(
+            name: 'types',
+            type: 'string',
+            description:
+                'Optional comma-separated event type filter, e.g. snapshot.finished,retention.pruned.',
+            required: false,
+            example: 'snapshot.started,snapshot.finished,snapshot.skipped',
+          ),
+          LocalHttpApiField(
+            name: 'lastEventId',
+            type: 'integer',
+            description:
+                'Resume after this event id when the Last-Event-ID header cannot be set.',
+            required: false,
+            example: 42,
+          ),
+        ],
+        handler: _handleActivityEventStream,
+      ),
+      LocalHttpApiRoute(
+        method: 'GET',
+        pathTemplate: '/monitor-tasks/{id}/backups',
+        summary: 'List monitor backups for one task',
+        description:
+            'Lists timestamped snapshots from the monitor backup directory for a specific monitor task, newest first. Sharded backup directories are answered from their snapshot index.',
+        tags: const ['monitoring'],
+        pathParameters: const [
+          LocalHttpApiField(
+            name: 'id',
+            type: 'string',
+            description: 'base64url-encoded normalized file path.',
+            required: true,
+          ),
+        ],
+        queryParameters: const [
+          LocalHttpApiField(
+            name: 'from',
+            type: 'string',
+            description:
+                'ISO 8601 time; only snapshots taken at or after it are listed.',
+            required: false,
+            example: '2026-01-01T00:00:00',
+          ),
+          LocalHttpApiField(
+            name: 'to',
+            type: 'string',
+            description:
+                'ISO 8601 time; only snapshots taken before it are listed.',
+            required: false,
+            example: '2026-02-01T00:00:00',
+          ),
+        ],
+        handler: _handleListMonitorTaskBackups,
+      ),
+      LocalHttpApiRoute(
+        method: 'POST',
+        pathTemplate: '/monitor-tasks/{id}/verification-writes',
+        summary: 'Write to a monitored file and verify backup creation',
+        description:
+            'Appends text to the monitored file, waits briefly, and reports whether a new monitor backup was created.',
+        tags: const ['monitoring', 'testing'],
+        pathParameters: const [
+          LocalHttpApiField(
+            name: 'id',
+            type: 'string',
+            description: 'base64url-encoded normalized file path.',
+            required: true,
+          ),
+        ],
+        requestBody: const LocalHttpApiRequestBody(
+          description: 'Verification write payload.',
+          fields: [
+            LocalHttpApiField(
+              name: 'appendText',
+              type: 'string',
+              description:
+                  'Text appended to the monitored file during verification.',
+              required: true,
+              example: '\napi-verification-write',
+            ),
+            LocalHttpApiField(
+              name: 'waitMilliseconds',
+              type: 'integer',
+              description:
+                  'How long to wait after the write before reading backup results.',
+              required: false,
+              example: 1800,
+            ),
+          ],
+        ),
+        handler: _handleVerifyMonitorTaskWrite,
+      ),
+    ];
+  }
+
+  LocalHttpApiDocumentation get _documentation {
+    final serverUrl =
+        baseUrl ?? 'http://127.0.0.1:${_port ?? defaultPort}/api/v1';
+    return LocalHttpApiDocumentation(
+      title: 'Vertree Local HTTP API',
+      appVersion: apiService.currentVersion,
+      serverUrl: serverUrl,
+      routes: _routes,
+    );
+  }
+
+  Future<void> _handleApiIndex(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    await _writeSuccess(
+      request,
+      data: _documentation.buildIndex(),
+      startedAt: startedAt,
+    );
+  }
+
+  Future<void> _handleOpenApiDocument(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
     await _writeJson(
       request,
       statusCode: HttpStatus.ok,
@@ -786,6 +1444,23 @@ class LocalHttpApiServer {
     );
   }
 
+  Future<void> _handleMetrics(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    request.response.statusCode = HttpStatus.ok;
+    request.response.headers.contentType = ContentType(
+      'text',
+      'plain',
+      parameters: {'version': '0.0.4'},
+      charset: 'utf-8',
+    );
+    request.response.headers.set(HttpHeaders.cacheControlHeader, 'no-store');
+    request.response.write(appMetrics.registry.renderPrometheusText());
+    await request.response.close();
+  }
+
   Future<void> _handleQuitApp(
     HttpRequest request,
     Map<String, String> pathParameters,
@@ -1042,7 +1717,47 @@ class LocalHttpApiServer {
       return;
     }
 
-    final result = apiService.listBackups(filePath);
+    final range = _parseTimeRange(request.uri.queryParameters);
+    if (range.isErr) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', range.msg, startedAt),
+      );
+      return;
+    }
+
+    final (from, to) = range.unwrap();
+    final result = apiService.listBackups(filePath, from: from, to: to);
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleListVersionCopies(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    await _writeSuccess(
+      request,
+      data: apiService.listVersionCopies(),
+      startedAt: startedAt,
+    );
+  }
+
+  Future<void> _handleCancelVersionCopy(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final result = apiService.cancelVersionCopy(pathParameters['id']!);
+    if (result.isErr) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.notFound,
+        body: _errorBody(request, 'NOT_FOUND', result.msg, startedAt),
+      );
+      return;
+    }
     await _writeResult(request, result, startedAt);
   }
 
@@ -1155,27 +1870,699 @@ class LocalHttpApiServer {
       return;
     }
 
-    final result = await apiService.getVersionTree(filePath);
-    await _writeResult(request, result, startedAt);
-  }
-
-  Future<void> _handleListMonitorTaskBackups(
-    HttpRequest request,
-    Map<String, String> pathParameters,
-    DateTime startedAt,
-  ) async {
-    final result = apiService.listMonitorTaskBackups(pathParameters['id']!);
-    await _writeResult(request, result, startedAt);
-  }
-
-  Future<void> _handleVerifyMonitorTaskWrite(
-    HttpRequest request,
-    Map<String, String> pathParameters,
-    DateTime startedAt,
-  ) async {
-    final body = await _readJsonBody(request);
-    final appendText = _requiredStringField(body, 'appendText');
-    if (appendText == null) {
+    final query = _parseVersionTreeQuery(request.uri.queryParameters);
+    if (query.isErr) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', query.msg, startedAt),
+      );
+      return;
+    }
+
+    // 目录自上次构建后未变化时直接用缓存的 ETag 比较，不触碰文件系统
+    final ifNoneMatch = request.headers.value(HttpHeaders.ifNoneMatchHeader);
+    final cachedETag = apiService.cachedVersionTreeETag(filePath);
+    if (cachedETag != null && _eTagMatches(ifNoneMatch, cachedETag)) {
+      await _writeNotModified(request, cachedETag);
+      return;
+    }
+
+    final result = await apiService.getVersionTree(
+      filePath,
+      query: query.unwrap(),
+    );
+    if (result.isErr) {
+      await _writeResult(request, result, startedAt);
+      return;
+    }
+
+    final data = result.unwrap();
+    final eTag = data['etag'] as String;
+    if (_eTagMatches(ifNoneMatch, eTag)) {
+      await _writeNotModified(request, eTag);
+      return;
+    }
+    await _writeSuccess(
+      request,
+      data: data,
+      startedAt: startedAt,
+      headers: {
+        HttpHeaders.etagHeader: eTag,
+        HttpHeaders.cacheControlHeader: 'no-cache',
+      },
+    );
+  }
+
+  Result<VersionTreeQuery, String> _parseVersionTreeQuery(
+    Map<String, String> parameters,
+  ) {
+    final format = parameters['format']?.trim() ?? 'nested';
+    if (format != 'nested' && format != 'flat') {
+      return Result.eMsg('Query parameter "format" must be nested or flat.');
+    }
+    final depth = _optionalIntParameter(parameters, 'depth');
+    if (depth.isErr) {
+      return Result.eMsg(depth.msg);
+    }
+    final maxBranches = _optionalIntParameter(parameters, 'maxBranches');
+    if (maxBranches.isErr) {
+      return Result.eMsg(maxBranches.msg);
+    }
+    final limit = _optionalIntParameter(
+      parameters,
+      'limit',
+      min: 1,
+      max: VersionTreeQuery.maxPageSize,
+    );
+    if (limit.isErr) {
+      return Result.eMsg(limit.msg);
+    }
+    final cursor = parameters['cursor']?.trim();
+
+    return Result.ok(
+      VersionTreeQuery(
+        maxDepth: depth.unwrap(),
+        maxBranches: maxBranches.unwrap(),
+        flat: format == 'flat',
+        cursor: cursor == null || cursor.isEmpty ? null : cursor,
+        limit: limit.unwrap() ?? VersionTreeQuery.defaultPageSize,
+        includeChanges: _optionalBoolField(parameters, 'changes') ?? false,
+      ),
+    );
+  }
+
+  /// 可选的 from、to 查询参数（ISO 8601）
+  Result<(DateTime?, DateTime?), String> _parseTimeRange(
+    Map<String, String> parameters,
+  ) {
+    DateTime? parse(String key) {
+      final raw = parameters[key]?.trim();
+      return raw == null || raw.isEmpty ? null : DateTime.tryParse(raw);
+    }
+
+    for (final key in const ['from', 'to']) {
+      final raw = parameters[key]?.trim();
+      if (raw != null && raw.isNotEmpty && parse(key) == null) {
+        return Result.eMsg(
+          'Query parameter "$key" must be an ISO 8601 date or time.',
+        );
+      }
+    }
+    return Result.ok((parse('from'), parse('to')));
+  }
+
+  Result<int?, String> _optionalIntParameter(
+    Map<String, String> parameters,
+    String key, {
+    int min = 0,
+    int? max,
+  }) {
+    final raw = parameters[key]?.trim();
+    if (raw == null || raw.isEmpty) {
+      return Result.ok(null);
+    }
+    final value = int.tryParse(raw);
+    if (value == null || value < min || (max != null && value > max)) {
+      final range = max == null ? '>= $min' : 'between $min and $max';
+      return Result.eMsg('Query parameter "$key" must be an integer $range.');
+    }
+    return Result.ok(value);
+  }
+
+  /// If-None-Match 使用弱比较，忽略 W/ 前缀，支持逗号分隔列表与 *
+  bool _eTagMatches(String? ifNoneMatch, String eTag) {
+    if (ifNoneMatch == null || ifNoneMatch.trim().isEmpty) {
+      return false;
+    }
+    String opaque(String tag) {
+      final trimmed = tag.trim();
+      return trimmed.startsWith('W/') ? trimmed.substring(2) : trimmed;
+    }
+
+    final target = opaque(eTag);
+    return ifNoneMatch
+        .split(',')
+        .map(opaque)
+        .any((candidate) => candidate == '*' || candidate == target);
+  }
+
+  Future<void> _writeNotModified(HttpRequest request, String eTag) async {
+    request.response.statusCode = HttpStatus.notModified;
+    request.response.headers.set(HttpHeaders.etagHeader, eTag);
+    request.response.headers.set(HttpHeaders.cacheControlHeader, 'no-cache');
+    await request.response.close();
+  }
+
+  Future<void> _handleVersionSearch(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    Future<void> badRequest(String message) {
+      return _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', message, startedAt),
+      );
+    }
+
+    final filePath = _requiredQueryParameter(request, 'path');
+    final text = request.uri.queryParameters['q'];
+    if (filePath == null || text == null || text.isEmpty) {
+      await badRequest('Query parameters "path" and "q" are required.');
+      return;
+    }
+    final parameters = request.uri.queryParameters;
+    final limit = _optionalIntParameter(
+      parameters,
+      'limit',
+      min: 1,
+      max: 5000,
+    );
+    if (limit.isErr) {
+      await badRequest(limit.msg);
+      return;
+    }
+
+    final result = await apiService.searchVersions(
+      filePath,
+      VersionSearchQuery(
+        text: text,
+        regex: _optionalBoolField(parameters, 'regex') ?? false,
+        caseSensitive:
+            _optionalBoolField(parameters, 'caseSensitive') ?? false,
+        includeBackups:
+            _optionalBoolField(parameters, 'includeBackups') ?? false,
+        maxResults: limit.unwrap() ?? 200,
+      ),
+    );
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleStartIntegrityScrub(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final rawPaths = body['paths'];
+    if (rawPaths != null &&
+        (rawPaths is! List || rawPaths.any((path) => path is! String))) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Field "paths" must be an array of strings.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+    if (apiService.integrityScrubService.isRunning) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.conflict,
+        body: _errorBody(
+          request,
+          'CONFLICT',
+          'An integrity scrub is already running.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final result = apiService.startIntegrityScrub(
+      paths: (rawPaths as List?)?.cast<String>(),
+      dropMissing: _optionalBoolField(body, 'dropMissing') ?? false,
+      lowPriority: _optionalBoolField(body, 'lowPriority') ?? false,
+    );
+    await _writeResult(
+      request,
+      result,
+      startedAt,
+      successStatusCode: HttpStatus.accepted,
+    );
+  }
+
+  Future<void> _handleGetIntegrityScrub(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    await _writeSuccess(
+      request,
+      data: apiService.integrityScrubStatus(),
+      startedAt: startedAt,
+    );
+  }
+
+  Future<void> _handleStartColdPack(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final rawPaths = body['paths'];
+    final olderThanDays = _optionalIntField(body, 'olderThanDays');
+    final String? error;
+    if (rawPaths != null &&
+        (rawPaths is! List || rawPaths.any((path) => path is! String))) {
+      error = 'Field "paths" must be an array of strings.';
+    } else if (olderThanDays != null && olderThanDays <= 0) {
+      error = 'Field "olderThanDays" must be a positive integer.';
+    } else {
+      error = null;
+    }
+    if (error != null) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', error, startedAt),
+      );
+      return;
+    }
+    if (apiService.coldPackService.isRunning) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.conflict,
+        body: _errorBody(
+          request,
+          'CONFLICT',
+          'Cold packing is already running.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final result = apiService.startColdPack(
+      paths: (rawPaths as List?)?.cast<String>(),
+      olderThanDays: olderThanDays,
+    );
+    await _writeResult(
+      request,
+      result,
+      startedAt,
+      successStatusCode: HttpStatus.accepted,
+    );
+  }
+
+  Future<void> _handleGetColdPack(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    await _writeSuccess(
+      request,
+      data: apiService.coldPackStatus(),
+      startedAt: startedAt,
+    );
+  }
+
+  Future<void> _handleRestoreColdSnapshot(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final filePath = _requiredStringField(body, 'path');
+    final name = _requiredStringField(body, 'name');
+    if (filePath == null || name == null) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Fields "path" and "name" are required.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final result = await apiService.restoreColdSnapshot(
+      filePath: filePath,
+      name: name,
+      targetPath: _optionalStringField(body, 'targetPath'),
+    );
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleExportVersionPack(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final filePath = _requiredStringField(body, 'path');
+    if (filePath == null) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Field "path" is required.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final result = await apiService.exportVersionPack(
+      filePath,
+      packPath: _optionalStringField(body, 'packPath'),
+      includeBackups: _optionalBoolField(body, 'includeBackups') ?? false,
+      compress: _optionalBoolField(body, 'compress') ?? true,
+    );
+    await _writeResult(
+      request,
+      result,
+      startedAt,
+      successStatusCode: HttpStatus.created,
+    );
+  }
+
+  Future<void> _handleGetDiskUsage(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final result = await apiService.getDiskUsage(
+      refresh:
+          _optionalBoolField(request.uri.queryParameters, 'refresh') ?? false,
+    );
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleGetVersionPack(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final packPath = _requiredQueryParameter(request, 'path');
+    if (packPath == null) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Query parameter "path" is required.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final result = await apiService.getVersionPack(packPath);
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleImportVersionPack(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final packPath = _requiredStringField(body, 'path');
+    if (packPath == null) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Field "path" is required.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final result = await apiService.importVersionPack(
+      packPath,
+      targetDirectory: _optionalStringField(body, 'targetDirectory'),
+    );
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleDiff(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    Future<void> badRequest(String message) {
+      return _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', message, startedAt),
+      );
+    }
+
+    final oldPath = _requiredQueryParameter(request, 'old');
+    final newPath = _requiredQueryParameter(request, 'new');
+    if (oldPath == null || newPath == null) {
+      await badRequest('Query parameters "old" and "new" are required.');
+      return;
+    }
+
+    final parameters = request.uri.queryParameters;
+    final format = parameters['format']?.trim() ?? 'hunks';
+    if (format != 'hunks' && format != 'unified') {
+      await badRequest('Query parameter "format" must be hunks or unified.');
+      return;
+    }
+    final context = _optionalIntParameter(parameters, 'context', max: 1000);
+    if (context.isErr) {
+      await badRequest(context.msg);
+      return;
+    }
+    final maxLines = _optionalIntParameter(
+      parameters,
+      'maxLines',
+      min: 1,
+      max: 200000,
+    );
+    if (maxLines.isErr) {
+      await badRequest(maxLines.msg);
+      return;
+    }
+    final contextLines =
+        context.unwrap() ?? LineDiffService.defaultContextLines;
+
+    if (format == 'hunks') {
+      final result = await apiService.compareFiles(
+        oldPath,
+        newPath,
+        contextLines: contextLines,
+        maxLines: maxLines.unwrap() ?? LineDiffService.defaultMaxLines,
+      );
+      await _writeResult(request, result, startedAt);
+      return;
+    }
+
+    final unified = apiService.unifiedDiff(
+      oldPath,
+      newPath,
+      contextLines: contextLines,
+    );
+    if (unified.isErr) {
+      await badRequest(unified.msg);
+      return;
+    }
+    final (resolvedOld, resolvedNew, body) = unified.unwrap();
+    final chunks = StreamIterator<List<int>>(body);
+
+    // 二进制、过大等打开失败在第一块之前报告，此时还能返回 JSON 错误
+    bool hasOutput;
+    try {
+      hasOutput = await chunks.moveNext();
+    } on LineDiffException catch (error) {
+      await badRequest(error.message);
+      return;
+    }
+
+    final response = request.response;
+    response.statusCode = HttpStatus.ok;
+    response.headers.contentType = ContentType(
+      'text',
+      'plain',
+      charset: 'utf-8',
+    );
+    response.headers.set(HttpHeaders.cacheControlHeader, 'no-store');
+    try {
+      if (hasOutput) {
+        response.write('--- $resolvedOld\n+++ $resolvedNew\n');
+        do {
+          response.add(chunks.current);
+          // 等数据写入套接字后再取下一块，慢客户端不会让输出堆积在内存里
+          await response.flush();
+        } while (await chunks.moveNext());
+      }
+    } catch (_) {
+      // 响应头已经发出，客户端断开或中途出错时只能截断输出
+    } finally {
+      await chunks.cancel();
+      await response.close();
+    }
+  }
+
+  Future<void> _handleActivityEventStream(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final hub = apiService.activityEventHub;
+    final types = _parseEventTypes(request.uri.queryParameters['types']);
+    if (types != null &&
+        types.any((type) => !ActivityEventType.values.contains(type))) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Supported event types: ${ActivityEventType.values.join(', ')}.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final rawLastEventId =
+        request.headers.value('last-event-id') ??
+        request.uri.queryParameters['lastEventId'];
+    final lastEventId = int.tryParse(rawLastEventId?.trim() ?? '');
+
+    final response = request.response;
+    response.statusCode = HttpStatus.ok;
+    response.bufferOutput = false;
+    response.headers.contentType = ContentType(
+      'text',
+      'event-stream',
+      charset: 'utf-8',
+    );
+    response.headers.set(HttpHeaders.cacheControlHeader, 'no-store');
+    response.headers.set('X-Accel-Buffering', 'no');
+
+    final closed = Completer<void>();
+    void finish() {
+      if (!closed.isCompleted) {
+        closed.complete();
+      }
+    }
+
+    void writeFrame(String frame) {
+      if (closed.isCompleted) {
+        return;
+      }
+      try {
+        response.write(frame);
+      } catch (_) {
+        finish();
+      }
+    }
+
+    // 先订阅再取回放，二者之间没有 await，不会漏掉事件；
+    // lastSentId 用来去掉回放与实时流之间可能的重复。
+    var lastSentId = 0;
+    void send(ActivityEvent event) {
+      if (event.id <= lastSentId) {
+        return;
+      }
+      lastSentId = event.id;
+      if (types != null && !types.contains(event.type)) {
+        return;
+      }
+      writeFrame(event.toServerSentEvent());
+    }
+
+    final subscription = hub.stream.listen(send);
+    final replay = lastEventId == null
+        ? null
+        : hub.replaySince(lastEventId, types: types);
+    final isRestartedSequence =
+        lastEventId != null && lastEventId > hub.lastEventId;
+    lastSentId = isRestartedSequence ? 0 : (lastEventId ?? hub.lastEventId);
+
+    writeFrame('retry: 3000\n\n');
+    if (replay != null && !replay.isComplete) {
+      final gap = {
+        'requestedLastEventId': lastEventId,
+        'oldestBufferedEventId': hub.oldestBufferedEventId,
+        'lastEventId': hub.lastEventId,
+      };
+      writeFrame('event: replay-gap\ndata: ${jsonEncode(gap)}\n\n');
+    }
+    for (final event in replay?.events ?? const <ActivityEvent>[]) {
+      send(event);
+    }
+
+    final heartbeat = Timer.periodic(eventStreamHeartbeatInterval, (_) {
+      writeFrame(': keep-alive\n\n');
+    });
+    unawaited(response.done.then((_) => finish(), onError: (_) => finish()));
+
+    await closed.future;
+    heartbeat.cancel();
+    await subscription.cancel();
+    try {
+      await response.close();
+    } catch (_) {
+      // 客户端已断开
+    }
+  }
+
+  Set<String>? _parseEventTypes(String? raw) {
+    if (raw == null) {
+      return null;
+    }
+    final types = raw
+        .split(',')
+        .map((type) => type.trim())
+        .where((type) => type.isNotEmpty)
+        .toSet();
+    return types.isEmpty ? null : types;
+  }
+
+  Future<void> _handleListMonitorTaskBackups(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final range = _parseTimeRange(request.uri.queryParameters);
+    if (range.isErr) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', range.msg, startedAt),
+      );
+      return;
+    }
+
+    final (from, to) = range.unwrap();
+    final result = apiService.listMonitorTaskBackups(
+      pathParameters['id']!,
+      from: from,
+      to: to,
+    );
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<void> _handleVerifyMonitorTaskWrite(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final appendText = _requiredStringField(body, 'appendText');
+    if (appendText == null) {
       await _writeJson(
         request,
         statusCode: HttpStatus.badRequest,
@@ -1200,6 +2587,182 @@ class LocalHttpApiServer {
     await _writeResult(request, result, startedAt);
   }
 
+  Future<void> _handleBatch(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final operations = body['operations'];
+    if (operations is! List || operations.isEmpty) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'Field "operations" must be a non-empty array.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+    if (operations.length > maxBatchOperations) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(
+          request,
+          'BAD_REQUEST',
+          'At most $maxBatchOperations operations are allowed per batch.',
+          startedAt,
+        ),
+      );
+      return;
+    }
+
+    final concurrency = (_optionalIntField(body, 'concurrency') ?? 1).clamp(
+      1,
+      maxBatchConcurrency,
+    );
+    final stopOnError = _optionalBoolField(body, 'stopOnError') ?? false;
+    final results = List<Map<String, dynamic>?>.filled(operations.length, null);
+    var nextIndex = 0;
+    var failed = false;
+
+    Future<void> worker() async {
+      while (nextIndex < operations.length) {
+        final index = nextIndex;
+        nextIndex += 1;
+        results[index] = failed && stopOnError
+            ? _batchSkipped(operations[index], index)
+            : await _runBatchOperation(operations[index], index);
+        if (results[index]!['success'] != true) {
+          failed = true;
+        }
+      }
+    }
+
+    await Future.wait([
+      for (var slot = 0; slot < concurrency; slot++) worker(),
+    ]);
+
+    final items = results.cast<Map<String, dynamic>>();
+    await _writeSuccess(
+      request,
+      data: {
+        'count': items.length,
+        'succeededCount': items.where((item) => item['success'] == true).length,
+        'failedCount': items.where((item) => item['success'] != true).length,
+        'concurrency': concurrency,
+        'items': items,
+      },
+      startedAt: startedAt,
+    );
+  }
+
+  Future<void> _handleFileBatch(
+    HttpRequest request,
+    Map<String, String> pathParameters,
+    DateTime startedAt,
+  ) async {
+    final body = await _readJsonBody(request);
+    final action = FileBatchAction.fromToken(
+      _requiredStringField(body, 'action') ?? '',
+    );
+    final paths = body['paths'];
+    final String? error;
+    if (action == null) {
+      error = 'Field "action" must be one of backup, express-backup, monit.';
+    } else if (paths is! List ||
+        paths.isEmpty ||
+        paths.any((path) => path is! String || path.isEmpty)) {
+      error = 'Field "paths" must be a non-empty array of file paths.';
+    } else if (paths.length > maxFileBatchPaths) {
+      error = 'At most $maxFileBatchPaths paths are allowed per batch.';
+    } else {
+      error = null;
+    }
+    if (error != null) {
+      await _writeJson(
+        request,
+        statusCode: HttpStatus.badRequest,
+        body: _errorBody(request, 'BAD_REQUEST', error, startedAt),
+      );
+      return;
+    }
+
+    final concurrency = _optionalIntField(body, 'concurrency');
+    final result = await apiService.runFileBatch(
+      action!,
+      (paths as List).cast<String>(),
+      label: body['label']?.toString(),
+      concurrency: concurrency?.clamp(1, maxBatchConcurrency),
+    );
+    await _writeResult(request, result, startedAt);
+  }
+
+  Future<Map<String, dynamic>> _runBatchOperation(
+    dynamic operation,
+    int index,
+  ) async {
+    final stopwatch = Stopwatch()..start();
+    if (operation is! Map || operation['op'] is! String) {
+      return {
+        'index': index,
+        'id': operation is Map ? operation['id']?.toString() : null,
+        'op': null,
+        'success': false,
+        'code': 'BAD_REQUEST',
+        'message': 'Each operation must be an object with a string "op".',
+        'data': null,
+        'durationMs': 0,
+      };
+    }
+
+    final op = operation['op'] as String;
+    final rawParams = operation['params'];
+    final params = rawParams is Map
+        ? rawParams.map((key, value) => MapEntry(key.toString(), value))
+        : <String, dynamic>{};
+    Map<String, dynamic> build(String code, String message, Object? data) {
+      return {
+        'index': index,
+        'id': operation['id']?.toString(),
+        'op': op,
+        'success': code == 'OK',
+        'code': code,
+        'message': message,
+        'data': data,
+        'durationMs': stopwatch.elapsedMilliseconds,
+      };
+    }
+
+    try {
+      final result = await apiService.runBatchOperation(op, params);
+      if (result.isErr) {
+        return build('BAD_REQUEST', result.msg, null);
+      }
+      return build('OK', 'ok', result.unwrap());
+    } catch (e) {
+      logger.error('Local HTTP API batch operation $op failed: $e');
+      return build('INTERNAL_ERROR', e.toString(), null);
+    }
+  }
+
+  Map<String, dynamic> _batchSkipped(dynamic operation, int index) {
+    return {
+      'index': index,
+      'id': operation is Map ? operation['id']?.toString() : null,
+      'op': operation is Map ? operation['op']?.toString() : null,
+      'success': false,
+      'code': 'SKIPPED',
+      'message': 'Skipped because an earlier operation failed.',
+      'data': null,
+      'durationMs': 0,
+    };
+  }
+
   String? _requiredStringField(Map<String, dynamic> body, String fieldName) {
     final value = body[fieldName]?.toString();
     if (value == null || value.isEmpty) {
@@ -1274,8 +2837,51 @@ class LocalHttpApiServer {
     return value;
   }
 
+  /// 按 [maxRequestBodyBytes] 读取请求体，超过时抛出 [_RequestBodyTooLarge]，
+  /// 剩下的部分不再读取
+  Future<String> _readBodyLimited(HttpRequest request) async {
+    final bytes = BytesBuilder(copy: false);
+    await for (final chunk in request) {
+      bytes.add(chunk);
+      if (bytes.length > maxRequestBodyBytes) {
+        throw const _RequestBodyTooLarge();
+      }
+    }
+    return utf8.decode(bytes.takeBytes());
+  }
+
+  /// 不需要的请求体不解码：长度已知时在后台读完丢弃，连接可以复用；分块
+  /// 传输的不读，回复后关闭连接
+  void _discardBody(HttpRequest request) {
+    final length = request.contentLength;
+    if (length == 0) {
+      return;
+    }
+    if (length > 0 && length <= maxRequestBodyBytes) {
+      _requestBodies[request] = request.drain<void>().then((_) => '')
+        ..ignore();
+      return;
+    }
+    request.response.persistentConnection = false;
+  }
+
+  /// 剩下的请求体不再读取，回复后关闭连接
+  Future<void> _writeBodyTooLarge(HttpRequest request, DateTime startedAt) {
+    request.response.persistentConnection = false;
+    return _writeJson(
+      request,
+      statusCode: HttpStatus.requestEntityTooLarge,
+      body: _errorBody(
+        request,
+        'PAYLOAD_TOO_LARGE',
+        'Request body must not exceed $maxRequestBodyBytes bytes.',
+        startedAt,
+      ),
+    );
+  }
+
   Future<Map<String, dynamic>> _readJsonBody(HttpRequest request) async {
-    final raw = await utf8.decoder.bind(request).join();
+    final raw = await (_requestBodies[request] ??= _readBodyLimited(request));
     if (raw.trim().isEmpty) {
       return {};
     }
@@ -1318,10 +2924,12 @@ class LocalHttpApiServer {
     required Map<String, dynamic> data,
     required DateTime startedAt,
     int statusCode = HttpStatus.ok,
+    Map<String, String> headers = const {},
   }) async {
     await _writeJson(
       request,
       statusCode: statusCode,
+      headers: headers,
       body: {
         'success': true,
         'code': 'OK',
@@ -1365,11 +2973,17 @@ class LocalHttpApiServer {
     HttpRequest request, {
     required int statusCode,
     required Map<String, dynamic> body,
+    Map<String, String> headers = const {},
   }) async {
     request.response.statusCode = statusCode;
     request.response.headers.contentType = ContentType.json;
     request.response.headers.set(HttpHeaders.cacheControlHeader, 'no-store');
-    request.response.write(const JsonEncoder.withIndent('  ').convert(body));
+    headers.forEach(request.response.headers.set);
+    final sink = _jsonEncoder.startChunkedConversion(
+      _UnclosableByteSink(request.response),
+    );
+    sink.add(body);
+    sink.close();
     await request.response.close();
   }
 
@@ -1393,3 +3007,21 @@ class LocalHttpApiServer {
     return remote.isLoopback;
   }
 }
+
+/// 让 JSON 分块编码器写入响应而不替我们关闭它，关闭时机仍由调用方控制
+/// 请求体超过 [LocalHttpApiServer.maxRequestBodyBytes]
+class _RequestBodyTooLarge implements Exception {
+  const _RequestBodyTooLarge();
+}
+
+class _UnclosableByteSink implements Sink<List<int>> {
+  _UnclosableByteSink(this._target);
+
+  final IOSink _target;
+
+  @override
+  void add(List<int> data) => _target.add(data);
+
+  @override
+  void close() {}
+}
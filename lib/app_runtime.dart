@@ -13,19 +13,34 @@ import 'package:vertree/component/I18nLang.dart';
 import 'package:vertree/core/MonitManager.dart';
 import 'package:vertree/api/LocalHttpApiServer.dart';
 import 'package:vertree/component/AppLogger.dart';
+import 'package:vertree/component/AppMetrics.dart';
 import 'package:vertree/component/Configer.dart';
 import 'package:vertree/component/LaunchCounter.dart';
 import 'package:vertree/component/Notifier.dart';
+import 'package:vertree/core/FilePoller.dart';
+import 'package:vertree/core/SnapshotCopyQueue.dart';
+import 'package:vertree/core/VersionCopy.dart';
 import 'package:vertree/core/FileVersionTree.dart';
 import 'package:vertree/core/Result.dart';
+import 'package:vertree/component/app_cli.dart';
 import 'package:vertree/component/app_command_handler.dart';
 import 'package:vertree/component/app_window_controller.dart';
 import 'package:vertree/component/TrayManager.dart';
 import 'package:vertree/platform/bootstrap/platform_bootstrap.dart';
+import 'package:vertree/platform/linux_shell_ipc_server.dart';
 import 'package:vertree/platform/platform_integration.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
 import 'package:vertree/service/LanFileShareServer.dart';
 import 'package:vertree/service/LocalHttpApiService.dart';
 import 'package:vertree/service/AppAnnouncementService.dart';
+import 'package:vertree/service/ChangeSketchService.dart';
+import 'package:vertree/service/ColdPackService.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+import 'package:vertree/service/FileBatchService.dart';
+import 'package:vertree/service/IntegrityScrubService.dart';
+import 'package:vertree/service/ShellIndexService.dart';
+import 'package:vertree/service/ThumbnailService.dart';
+import 'package:vertree/service/VersionSearchService.dart';
 import 'package:vertree/view/module/FileTree.dart';
 import 'package:vertree/view/module/LanShareDialog.dart';
 import 'package:vertree/view/page/BrandPage.dart';
@@ -37,6 +52,95 @@ import 'package:window_manager/window_manager.dart';
 import 'component/AppVersionInfo.dart';
 
 final logger = AppLogger(LogLevel.debug);
+final activityEventHub = ActivityEventHub();
+final thumbnailService = ThumbnailService();
+final changeSketchService = ChangeSketchService();
+
+/// 网络盘与 FUSE 上的监控文件共用的轮询器
+final filePoller = FilePoller();
+
+/// 所有监控任务的快照经它合批复制
+final snapshotCopyQueue = SnapshotCopyQueue();
+final versionSearchService = VersionSearchService(
+  activityEvents: activityEventHub.stream,
+);
+
+/// 默认校验全部监控任务的版本家族与备份目录
+final integrityScrubService = IntegrityScrubService(
+  targetsResolver: () => [
+    for (final task in monitService.monitFileTasks)
+      ...ScrubTarget.forFile(task.filePath, backupDirPath: task.backupDirPath),
+  ],
+  onEvent: activityEventHub.emit,
+);
+
+/// 统计全部监控任务的备份占用，快照与清理事件触发对应任务的增量统计
+final diskUsageService = DiskUsageService(
+  targetsResolver: () => [
+    for (final task in monitService.monitFileTasks)
+      DiskUsageTarget(
+        filePath: task.filePath,
+        backupDirPath: task.backupDirPath,
+      ),
+  ],
+  activityEvents: activityEventHub.stream,
+);
+
+/// 把全部监控任务中较旧的快照打包进冷存储
+final coldPackService = ColdPackService(
+  targetsResolver: () => [
+    for (final task in monitService.monitFileTasks)
+      DiskUsageTarget(
+        filePath: task.filePath,
+        backupDirPath: task.backupDirPath,
+      ),
+  ],
+  onEvent: activityEventHub.emit,
+);
+
+/// GNOME Files 扩展按目录查询的版本与监控状态
+final shellIndexService = ShellIndexService(
+  targetsResolver: () => [
+    for (final task in monitService.monitFileTasks)
+      DiskUsageTarget(
+        filePath: task.filePath,
+        backupDirPath: task.backupDirPath,
+      ),
+  ],
+  activityEvents: activityEventHub.stream,
+);
+
+/// 多选文件的批量备份与监控，命令行、Files 扩展与本地 API 共用
+final fileBatchService = FileBatchService(
+  backup: (filePath, label) async {
+    final result = await FileNode(filePath).safeBackup(label);
+    return result.isErr
+        ? Result.eMsg(result.msg)
+        : Result.ok(result.unwrap().mate.fullPath);
+  },
+  monit: (filePath) async {
+    final result = await monitService.addFileMonitTask(
+      filePath,
+      persist: false,
+    );
+    return result.isErr
+        ? Result.eMsg(result.msg)
+        : Result.ok(result.unwrap().backupDirPath);
+  },
+  onFinished: (report) async {
+    if (report.action == FileBatchAction.monit && report.succeededCount > 0) {
+      await monitService.saveTasks();
+    }
+  },
+);
+
+/// GNOME Files 扩展的菜单操作与状态查询走这条 Unix socket，只在 Linux 上启动
+final shellIpcServer = LinuxShellIpcServer(
+  indexService: shellIndexService,
+  onAction: _handleSecondInstance,
+  onLogInfo: logger.info,
+  onLogError: logger.error,
+);
 const String configuredLanSharePageBaseUrl = String.fromEnvironment(
   'VERTREE_SHARE_PAGE_BASE_URL',
   defaultValue: LanFileShareServer.defaultSharePageBaseUrl,
@@ -352,6 +456,7 @@ Future<void> _disposeBackgroundServicesForQuit() async {
   await Future.wait<void>([
     _safeShutdownLanFileShareServer(),
     _safeStopLocalHttpApiServer(),
+    if (Platform.isLinux) _safeStopShellIpcServer(),
   ], eagerError: false);
 }
 
@@ -373,6 +478,14 @@ Future<void> _safeStopLocalHttpApiServer() async {
   }
 }
 
+Future<void> _safeStopShellIpcServer() async {
+  try {
+    await shellIpcServer.stop().timeout(const Duration(milliseconds: 700));
+  } catch (_) {
+    // ignore
+  }
+}
+
 Future<void> _forceExitAfterQuitTimeout() async {
   await Future<void>.delayed(const Duration(seconds: 2));
   if (_isQuittingApplication) {
@@ -426,6 +539,7 @@ Future<void> runVertreeApp(
     onMonit: monit,
     onShare: share,
     onViewTree: viewtree,
+    onBatch: batchAction,
     onNotify: showWindowsNotification,
     onLogInfo: logger.info,
     onLogError: logger.error,
@@ -438,16 +552,53 @@ Future<void> runVertreeApp(
   );
 
   monitService = MonitManager();
+  appMetrics.monitorTasks
+    ..bind(() => monitService.monitFileTasks.length, const ['total'])
+    ..bind(() => monitService.runningTaskCount, const ['running']);
+  VersionCopy.updates.listen(
+    (task) => activityEventHub.emit(
+      task.state == VersionCopyState.copying
+          ? ActivityEventType.versionCopyProgress
+          : ActivityEventType.versionCopyFinished,
+      task.toJson(),
+    ),
+  );
+  integrityScrubService.schedule(
+    Duration(hours: configer.get<int>('integrityScrubIntervalHours', 24)),
+  );
+  coldPackService.schedule(
+    Duration(days: configer.get<int>('monitorColdPackDays', 0)),
+  );
+  // 监控页先显示上次保存的统计，启动稍后再在后台完整扫描一次
+  unawaited(
+    Future.delayed(const Duration(seconds: 20), () async {
+      try {
+        await diskUsageService.refresh();
+      } catch (e) {
+        logger.error('统计备份占用失败: $e');
+      }
+    }),
+  );
   lanFileShareServer = LanFileShareServer(
     sharePageBaseUrl: configuredLanSharePageBaseUrl,
     onLogInfo: logger.info,
     onLogError: logger.error,
+    onShareDownloaded: (download) =>
+        activityEventHub.emit(ActivityEventType.shareDownloaded, download),
   );
   localHttpApiServer = LocalHttpApiServer(
     apiService: LocalHttpApiService(
       configer: configer,
       monitManager: monitService,
       lanFileShareServer: lanFileShareServer,
+      activityEventHub: activityEventHub,
+      changeSketchService: changeSketchService,
+      versionSearchService: versionSearchService,
+      integrityScrubService: integrityScrubService,
+      diskUsageService: diskUsageService,
+      coldPackService: coldPackService,
+      fileBatchService: fileBatchService,
+      filePoller: filePoller,
       currentVersion: appVersionInfo.currentVersion,
       startedAt: DateTime.now(),
       currentPortResolver: () => localHttpApiServer.port,
@@ -503,6 +654,13 @@ Future<void> runVertreeApp(
     } catch (e) {
       logger.error('Local HTTP API startup failed: $e');
     }
+    if (Platform.isLinux) {
+      try {
+        await shellIpcServer.start();
+      } catch (e) {
+        logger.error('Files 扩展通道启动失败: $e');
+      }
+    }
 
     windowManager.waitUntilReadyToShow(
       const WindowOptions(
@@ -541,6 +699,16 @@ Future<void> runVertreeApp(
               logger.info("Vertree没有需要监控的文件");
               return;
             }
+            // 为应用未运行期间改动过的文件补快照，再按配置迁移备份目录布局，
+            // 检查与迁移都在后台 isolate 中进行
+            unawaited(
+              monitService
+                  .catchUp()
+                  .then((_) => monitService.migrateBackupLayouts())
+                  .catchError(
+                    (Object e) => logger.error('启动检查监控文件失败: $e'),
+                  ),
+            );
             await showWindowsNotificationWithTask(
               appLocale.getText(LocaleKey.app_monitStartedTitle),
               appLocale.getText(LocaleKey.app_monitStartedContent),
@@ -1139,6 +1307,44 @@ void monit(String path) {
   });
 }
 
+/// 对多选的文件执行一次批量动作，完成后只发一条汇总通知。
+///
+/// 多选时不再逐个询问备份标签，备份按快速备份处理。
+void batchAction(AppCliAction action, List<String> paths) {
+  logger.info('batch ${action.name}: ${paths.length} files');
+  final fileAction = action == AppCliAction.monit
+      ? FileBatchAction.monit
+      : FileBatchAction.backup;
+  unawaited(() async {
+    final report = await fileBatchService.run(fileAction, paths);
+    logger.info(
+      'batch ${action.name} finished: ${report.succeededCount} ok, '
+      '${report.failedCount} failed in ${report.elapsed.inMilliseconds}ms',
+    );
+    final title = appLocale.getText(
+      fileAction == FileBatchAction.monit
+          ? LocaleKey.app_batchMonitTitle
+          : LocaleKey.app_batchBackupTitle,
+    );
+    final lines = [
+      appLocale.getText(LocaleKey.app_batchSummaryContent).tr([
+        '${report.succeededCount}',
+        '${report.failedCount}',
+      ]),
+    ];
+    final failure = report.firstFailure;
+    if (failure != null) {
+      lines.add(
+        appLocale.getText(LocaleKey.app_batchFirstFailure).tr([
+          p.basename(failure.path),
+          failure.error ?? '',
+        ]),
+      );
+    }
+    await showWindowsNotification(title, lines.join('\n'));
+  }());
+}
+
 void share(String path) {
   unawaited(openLanShareDialogForPath(path));
 }
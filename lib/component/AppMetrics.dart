@@ -0,0 +1,160 @@
+import 'package:vertree/component/MetricsRegistry.dart';
+
+/// 进程级的指标实例，core 与 api 层直接引用，不依赖 app_runtime。
+final AppMetrics appMetrics = AppMetrics(MetricsRegistry());
+
+/// Vertree 关注的全部指标定义。
+class AppMetrics {
+  AppMetrics(this.registry)
+    : snapshotCopySeconds = registry.histogram(
+        'vertree_snapshot_copy_seconds',
+        'Time spent copying one snapshot (monitor backup or version backup).',
+        buckets: MetricHistogram.latencySecondsBuckets,
+        labelNames: const ['kind'],
+      ),
+      snapshotBytes = registry.histogram(
+        'vertree_snapshot_bytes',
+        'Size of each written snapshot in bytes.',
+        buckets: MetricHistogram.byteSizeBuckets,
+        labelNames: const ['kind'],
+      ),
+      snapshotsTotal = registry.counter(
+        'vertree_snapshots_total',
+        'Snapshots attempted, by kind and result.',
+        labelNames: const ['kind', 'result'],
+      ),
+      snapshotBytesTotal = registry.counter(
+        'vertree_snapshot_bytes_total',
+        'Total bytes written into snapshots.',
+        labelNames: const ['kind'],
+      ),
+      monitorEventsTotal = registry.counter(
+        'vertree_monitor_file_events_total',
+        'File system events observed for monitored files.',
+      ),
+      monitorSnapshotsSkippedTotal = registry.counter(
+        'vertree_monitor_snapshots_skipped_total',
+        'Monitor snapshots skipped, by reason.',
+        labelNames: const ['reason'],
+      ),
+      monitorEventToSnapshotSeconds = registry.histogram(
+        'vertree_monitor_event_to_snapshot_seconds',
+        'Delay between the first unsaved file event and the snapshot that captured it.',
+        buckets: const [
+          0.01,
+          0.05,
+          0.1,
+          0.5,
+          1,
+          5,
+          30,
+          60,
+          300,
+          900,
+          3600,
+        ],
+      ),
+      retentionPrunedTotal = registry.counter(
+        'vertree_retention_pruned_files_total',
+        'Old monitor snapshots deleted by retention.',
+      ),
+      treeBuildSeconds = registry.histogram(
+        'vertree_tree_build_seconds',
+        'Time spent in buildTree, by version family size.',
+        buckets: MetricHistogram.latencySecondsBuckets,
+        labelNames: const ['nodes'],
+      ),
+      treeBuildLastNodeCount = registry.gauge(
+        'vertree_tree_build_last_node_count',
+        'Node count of the most recently built version tree.',
+      ),
+      httpRequestSeconds = registry.histogram(
+        'vertree_http_request_seconds',
+        'Local HTTP API request latency, by method and route template.',
+        buckets: MetricHistogram.latencySecondsBuckets,
+        labelNames: const ['method', 'route'],
+      ),
+      httpRequestsTotal = registry.counter(
+        'vertree_http_requests_total',
+        'Local HTTP API requests, by method, route template and status code.',
+        labelNames: const ['method', 'route', 'status'],
+      ),
+      monitorTasks = registry.gauge(
+        'vertree_monitor_tasks',
+        'Configured monitor tasks, by state.',
+        labelNames: const ['state'],
+      ),
+      polledFiles = registry.gauge(
+        'vertree_polled_files',
+        'Monitored files watched by polling instead of change notifications.',
+      ),
+      pollStatsTotal = registry.counter(
+        'vertree_poll_stats_total',
+        'File stats issued by the polling watcher.',
+      ),
+      pollRoundSeconds = registry.histogram(
+        'vertree_poll_round_seconds',
+        'Wall time of one polling round (one batched stat of all due files).',
+        buckets: MetricHistogram.latencySecondsBuckets,
+      ),
+      pollDetectionDelaySeconds = registry.histogram(
+        'vertree_poll_detection_delay_seconds',
+        'Delay between a polled file\'s modification time and its detection.',
+        buckets: const [0.25, 0.5, 1, 2, 5, 10, 30, 60, 120],
+      ),
+      snapshotCopyBatchFiles = registry.histogram(
+        'vertree_snapshot_copy_batch_files',
+        'Monitor snapshots copied together in one batch.',
+        buckets: const [1, 2, 4, 8, 16, 32, 64, 128, 256],
+      );
+
+  final MetricsRegistry registry;
+  final MetricHistogram snapshotCopySeconds;
+  final MetricHistogram snapshotBytes;
+  final MetricCounter snapshotsTotal;
+  final MetricCounter snapshotBytesTotal;
+  final MetricCounter monitorEventsTotal;
+  final MetricCounter monitorSnapshotsSkippedTotal;
+  final MetricHistogram monitorEventToSnapshotSeconds;
+  final MetricCounter retentionPrunedTotal;
+  final MetricHistogram treeBuildSeconds;
+  final MetricGauge treeBuildLastNodeCount;
+  final MetricHistogram httpRequestSeconds;
+  final MetricCounter httpRequestsTotal;
+  final MetricGauge monitorTasks;
+  final MetricGauge polledFiles;
+  final MetricCounter pollStatsTotal;
+  final MetricHistogram pollRoundSeconds;
+  final MetricHistogram pollDetectionDelaySeconds;
+  final MetricHistogram snapshotCopyBatchFiles;
+
+  void recordSnapshot({
+    required String kind,
+    required Duration elapsed,
+    required int? bytes,
+  }) {
+    final labels = [kind];
+    snapshotCopySeconds.observeDuration(elapsed, labels);
+    if (bytes == null) {
+      snapshotsTotal.inc([kind, 'error']);
+      return;
+    }
+    snapshotsTotal.inc([kind, 'ok']);
+    snapshotBytes.observe(bytes, labels);
+    snapshotBytesTotal.inc(labels, bytes);
+  }
+
+  void recordTreeBuild(Duration elapsed, int nodeCount) {
+    treeBuildSeconds.observeDuration(elapsed, [nodeCountBucket(nodeCount)]);
+    treeBuildLastNodeCount.set(nodeCount);
+  }
+
+  /// 把节点数量归入少量固定档位，避免标签基数随文件数增长
+  static String nodeCountBucket(int nodeCount) {
+    if (nodeCount <= 10) return '1-10';
+    if (nodeCount <= 100) return '11-100';
+    if (nodeCount <= 1000) return '101-1000';
+    if (nodeCount <= 10000) return '1001-10000';
+    return '10001+';
+  }
+}
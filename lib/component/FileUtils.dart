@@ -14,6 +14,20 @@ class FileUtils {
   }
 
 
+  /// 把字节数格式化为 B / KB / MB / GB
+  static String formatBytes(num bytes) {
+    if (bytes < 1024) {
+      return '${bytes.round()} B';
+    }
+    if (bytes < 1024 * 1024) {
+      return '${(bytes / 1024).toStringAsFixed(1)} KB';
+    }
+    if (bytes < 1024 * 1024 * 1024) {
+      return '${(bytes / (1024 * 1024)).toStringAsFixed(1)} MB';
+    }
+    return '${(bytes / (1024 * 1024 * 1024)).toStringAsFixed(1)} GB';
+  }
+
   /// 处理路径，确保路径格式适合当前操作系统
   static String _normalizePath(String path) {
     return p.normalize(path); // 处理不规范的路径，适配当前系统
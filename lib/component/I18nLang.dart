@@ -76,6 +76,10 @@ enum LocaleKey {
   app_monitFailedTitle,
   app_monitSuccessTitle,
   app_monitSuccessContent,
+  app_batchBackupTitle,
+  app_batchMonitTitle,
+  app_batchSummaryContent,
+  app_batchFirstFailure,
   app_adminPermissionTooFrequent,
 
   // Brand Keys
@@ -122,6 +126,16 @@ enum LocaleKey {
   monit_cleanInvalidTaskDialogBackupDirNotSet,
   monit_cleanInvalidTaskDialogNoInvalidTasks,
   monit_cleanInvalidTaskDialogCleaned,
+  monit_diskUsageTitle,
+  monit_diskUsageTotal,
+  monit_diskUsageSnapshots,
+  monit_diskUsageGrowth,
+  monit_diskUsageSavings,
+  monit_diskUsageSavingsDetail,
+  monit_diskUsageRefresh,
+  monit_diskUsageScanning,
+  monit_diskUsageUpdatedAt,
+  monit_diskUsageNotScanned,
 
   // Setting Page Keys
   setting_title,
@@ -212,6 +226,12 @@ enum LocaleKey {
   vertree_totalNodes,
   vertree_totalBranches,
   vertree_canvasHint,
+  vertree_searchHint,
+  vertree_searchRegex,
+  vertree_searchClear,
+  vertree_searchResult,
+  vertree_searchNoMatch,
+  vertree_searchFailed,
 
   // Monitor Card Keys
   monitcard_monitorStatus,
@@ -230,12 +250,17 @@ enum LocaleKey {
   monitcard_statusStopped,
   monitcard_statusEnabled,
   monitcard_statusDisabled,
+  monitcard_diskUsage,
+  monitcard_diskUsageLargest,
   // File Tree Keys
   filetree_inputLabelTitle,
   filetree_inputLabelHint,
   filetree_inputCancel,
   filetree_inputConfirm,
   filetree_backupBlockedHasChild,
+  filetree_copyProgressTitle,
+  filetree_copyProgressBytes,
+  filetree_copyResumed,
 
   // File Leaf Keys
   fileleaf_noLabel,
@@ -262,6 +287,12 @@ enum LocaleKey {
   fileleaf_shareCopyLink,
   fileleaf_shareOpenLanding,
   fileleaf_shareOpenFailed,
+  fileleaf_menuCompare,
+  fileleaf_compareTitle,
+  fileleaf_compareSummary,
+  fileleaf_compareIdentical,
+  fileleaf_compareTruncated,
+  fileleaf_compareFailed,
   fileleaf_monitTitle,
   fileleaf_monitContent,
   fileleaf_notifyFailed,
@@ -449,6 +480,10 @@ class AppLocale {
     LocaleKey.app_monitFailedTitle: "Vertree monitoring failed",
     LocaleKey.app_monitSuccessTitle: "Vertree started monitoring file",
     LocaleKey.app_monitSuccessContent: "Click to open backup folder",
+    LocaleKey.app_batchBackupTitle: "Vertree batch backup finished",
+    LocaleKey.app_batchMonitTitle: "Vertree batch monitoring finished",
+    LocaleKey.app_batchSummaryContent: "%a succeeded, %a failed",
+    LocaleKey.app_batchFirstFailure: "First failure: %a (%a)",
     LocaleKey.app_adminPermissionTooFrequent:
         "Administrator elevation is being requested too frequently. Please try again later.",
 
@@ -505,6 +540,18 @@ class AppLocale {
         "No invalid monitor tasks found",
     LocaleKey.monit_cleanInvalidTaskDialogCleaned:
         "Invalid monitor tasks cleaned successfully",
+    LocaleKey.monit_diskUsageTitle: "Backup Storage",
+    LocaleKey.monit_diskUsageTotal: "Total: %a",
+    LocaleKey.monit_diskUsageSnapshots: "Snapshots: %a",
+    LocaleKey.monit_diskUsageGrowth: "Growth: %a/day",
+    LocaleKey.monit_diskUsageSavings: "Possible savings: %a",
+    LocaleKey.monit_diskUsageSavingsDetail:
+        "Duplicate snapshots: %a · Compression: %a",
+    LocaleKey.monit_diskUsageRefresh: "Rescan backup storage",
+    LocaleKey.monit_diskUsageScanning: "Scanning…",
+    LocaleKey.monit_diskUsageUpdatedAt: "Updated %a",
+    LocaleKey.monit_diskUsageNotScanned:
+        "Backup storage has not been scanned yet",
 
     LocaleKey.setting_title: "Settings",
     LocaleKey.setting_titleBar: "Vertree Settings",
@@ -621,6 +668,12 @@ class AppLocale {
     LocaleKey.vertree_totalBranches: "Branch nodes",
     LocaleKey.vertree_canvasHint:
         "Drag to pan, scroll to zoom, right click a node for actions",
+    LocaleKey.vertree_searchHint: "Search text in every version",
+    LocaleKey.vertree_searchRegex: "Regular expression",
+    LocaleKey.vertree_searchClear: "Clear search",
+    LocaleKey.vertree_searchResult: "%a of %a versions match",
+    LocaleKey.vertree_searchNoMatch: "No version contains this text",
+    LocaleKey.vertree_searchFailed: "Search failed: %a",
 
     LocaleKey.monitcard_monitorStatus: "Monitoring of %a has been %a",
     LocaleKey.monitcard_backupFolder: "Backup Folder: %a",
@@ -637,6 +690,9 @@ class AppLocale {
     LocaleKey.monitcard_cleanDialogConfirm: "Confirm",
     LocaleKey.monitcard_statusEnabled: "enabled",
     LocaleKey.monitcard_statusDisabled: "disabled",
+    LocaleKey.monitcard_diskUsage:
+        "Backups: %a in %a snapshots, growing %a/day",
+    LocaleKey.monitcard_diskUsageLargest: "Largest snapshot: %a (%a)",
 
     LocaleKey.filetree_inputLabelTitle: "Enter a label",
     LocaleKey.filetree_inputLabelHint: "Enter a label (optional)",
@@ -644,6 +700,9 @@ class AppLocale {
     LocaleKey.filetree_inputConfirm: "Confirm",
     LocaleKey.filetree_backupBlockedHasChild:
         "This version already has a direct child, so backup is not allowed",
+    LocaleKey.filetree_copyProgressTitle: "Copying version",
+    LocaleKey.filetree_copyProgressBytes: "%a of %a",
+    LocaleKey.filetree_copyResumed: "resumed at %a",
 
     LocaleKey.fileleaf_noLabel: "No label",
     LocaleKey.fileleaf_lastModified: "Last modified",
@@ -673,6 +732,13 @@ class AppLocale {
     LocaleKey.fileleaf_shareCopyLink: "Copy link",
     LocaleKey.fileleaf_shareOpenLanding: "Open share page",
     LocaleKey.fileleaf_shareOpenFailed: "Unable to open the share page",
+    LocaleKey.fileleaf_menuCompare: "Compare with previous version",
+    LocaleKey.fileleaf_compareTitle: "Compare %a → %a",
+    LocaleKey.fileleaf_compareSummary: "-%a  +%a lines in %a hunks",
+    LocaleKey.fileleaf_compareIdentical: "The two versions have identical content",
+    LocaleKey.fileleaf_compareTruncated:
+        "The diff is too long; only the first part is shown",
+    LocaleKey.fileleaf_compareFailed: "Unable to compare versions: %a",
     LocaleKey.fileleaf_monitTitle: "Confirm file monitoring",
     LocaleKey.fileleaf_monitContent: "Start monitoring file \"%a.%a\"?",
     LocaleKey.fileleaf_notifyFailed: "Vertree monitoring failed,",
@@ -755,6 +821,10 @@ class AppLocale {
     LocaleKey.app_monitFailedTitle: "Vertree监控失败",
     LocaleKey.app_monitSuccessTitle: "Vertree已开始监控文件",
     LocaleKey.app_monitSuccessContent: "点击我打开备份目录",
+    LocaleKey.app_batchBackupTitle: "Vertree 批量备份完成",
+    LocaleKey.app_batchMonitTitle: "Vertree 批量监控完成",
+    LocaleKey.app_batchSummaryContent: "成功 %a 个，失败 %a 个",
+    LocaleKey.app_batchFirstFailure: "首个失败：%a（%a）",
     LocaleKey.app_adminPermissionTooFrequent: "获得管理员权限频率过高，请稍后再试。",
 
     LocaleKey.brand_title: 'Vertree维树',
@@ -801,6 +871,16 @@ class AppLocale {
     LocaleKey.monit_cleanInvalidTaskDialogBackupDirNotSet: "未设置备份路径",
     LocaleKey.monit_cleanInvalidTaskDialogNoInvalidTasks: "未发现无效监控任务",
     LocaleKey.monit_cleanInvalidTaskDialogCleaned: "无效监控任务已成功清理",
+    LocaleKey.monit_diskUsageTitle: "备份占用",
+    LocaleKey.monit_diskUsageTotal: "总占用：%a",
+    LocaleKey.monit_diskUsageSnapshots: "快照：%a 个",
+    LocaleKey.monit_diskUsageGrowth: "增长：%a/天",
+    LocaleKey.monit_diskUsageSavings: "可节省：%a",
+    LocaleKey.monit_diskUsageSavingsDetail: "重复快照：%a · 压缩：%a",
+    LocaleKey.monit_diskUsageRefresh: "重新统计备份占用",
+    LocaleKey.monit_diskUsageScanning: "统计中…",
+    LocaleKey.monit_diskUsageUpdatedAt: "更新于 %a",
+    LocaleKey.monit_diskUsageNotScanned: "尚未统计备份占用",
 
     LocaleKey.setting_title: "设置",
     LocaleKey.setting_language: '语言',
@@ -897,6 +977,12 @@ class AppLocale {
     LocaleKey.vertree_totalNodes: "节点总数",
     LocaleKey.vertree_totalBranches: "分支节点",
     LocaleKey.vertree_canvasHint: "拖动画布可平移，滚轮可缩放，右键节点可查看更多操作",
+    LocaleKey.vertree_searchHint: "在所有版本中搜索文本",
+    LocaleKey.vertree_searchRegex: "正则表达式",
+    LocaleKey.vertree_searchClear: "清除搜索",
+    LocaleKey.vertree_searchResult: "%a / %a 个版本匹配",
+    LocaleKey.vertree_searchNoMatch: "没有版本包含该文本",
+    LocaleKey.vertree_searchFailed: "搜索失败：%a",
 
     LocaleKey.monitcard_monitorStatus: "%a的监控已经%a",
     LocaleKey.monitcard_backupFolder: "备份文件夹：%a",
@@ -914,12 +1000,17 @@ class AppLocale {
     LocaleKey.monitcard_statusStopped: "已暂停",
     LocaleKey.monitcard_statusEnabled: "开启",
     LocaleKey.monitcard_statusDisabled: "关闭",
+    LocaleKey.monitcard_diskUsage: "备份：%a，共 %a 个快照，每天增长 %a",
+    LocaleKey.monitcard_diskUsageLargest: "最大快照：%a（%a）",
 
     LocaleKey.filetree_inputLabelTitle: "请输入备注",
     LocaleKey.filetree_inputLabelHint: "请输入备注（可选）",
     LocaleKey.filetree_inputCancel: "取消",
     LocaleKey.filetree_inputConfirm: "确认",
     LocaleKey.filetree_backupBlockedHasChild: "当前版本已有长子，不允许备份",
+    LocaleKey.filetree_copyProgressTitle: "正在复制版本",
+    LocaleKey.filetree_copyProgressBytes: "%a / %a",
+    LocaleKey.filetree_copyResumed: "从 %a 处续传",
 
     LocaleKey.fileleaf_noLabel: "无备注",
     LocaleKey.fileleaf_lastModified: "最后修改",
@@ -946,6 +1037,12 @@ class AppLocale {
     LocaleKey.fileleaf_shareCopyLink: "复制链接",
     LocaleKey.fileleaf_shareOpenLanding: "打开分享页",
     LocaleKey.fileleaf_shareOpenFailed: "无法打开分享页",
+    LocaleKey.fileleaf_menuCompare: "与上一版本对比",
+    LocaleKey.fileleaf_compareTitle: "对比 %a → %a",
+    LocaleKey.fileleaf_compareSummary: "删除 %a 行，新增 %a 行，共 %a 处差异",
+    LocaleKey.fileleaf_compareIdentical: "两个版本内容相同",
+    LocaleKey.fileleaf_compareTruncated: "差异过长，仅显示前面一部分",
+    LocaleKey.fileleaf_compareFailed: "无法对比版本：%a",
     LocaleKey.fileleaf_monitTitle: "确认文件监控",
     LocaleKey.fileleaf_monitContent: "确定要开始监控文件 \"%a.%a\" 吗？",
     LocaleKey.fileleaf_notifyFailed: "Vertree监控失败，",
@@ -1028,6 +1125,10 @@ class AppLocale {
     LocaleKey.app_monitFailedTitle: "Vertree の監視に失敗しました",
     LocaleKey.app_monitSuccessTitle: "Vertree はファイルの監視を開始しました",
     LocaleKey.app_monitSuccessContent: "クリックしてバックアップフォルダーを開く",
+    LocaleKey.app_batchBackupTitle: "Vertree 一括バックアップが完了しました",
+    LocaleKey.app_batchMonitTitle: "Vertree 一括監視が完了しました",
+    LocaleKey.app_batchSummaryContent: "成功 %a 件、失敗 %a 件",
+    LocaleKey.app_batchFirstFailure: "最初の失敗: %a（%a）",
     LocaleKey.app_adminPermissionTooFrequent:
         "管理者権限の要求回数が多すぎます。しばらくしてから再試行してください。",
 
@@ -1078,6 +1179,16 @@ class AppLocale {
     LocaleKey.monit_cleanInvalidTaskDialogBackupDirNotSet: "バックアップパスが設定されていません",
     LocaleKey.monit_cleanInvalidTaskDialogNoInvalidTasks: "無効な監視タスクは見つかりませんでした",
     LocaleKey.monit_cleanInvalidTaskDialogCleaned: "無効な監視タスクが正常にクリーンアップされました",
+    LocaleKey.monit_diskUsageTitle: "バックアップ容量",
+    LocaleKey.monit_diskUsageTotal: "合計：%a",
+    LocaleKey.monit_diskUsageSnapshots: "スナップショット：%a 件",
+    LocaleKey.monit_diskUsageGrowth: "増加：%a/日",
+    LocaleKey.monit_diskUsageSavings: "節約可能：%a",
+    LocaleKey.monit_diskUsageSavingsDetail: "重複スナップショット：%a · 圧縮：%a",
+    LocaleKey.monit_diskUsageRefresh: "バックアップ容量を再集計",
+    LocaleKey.monit_diskUsageScanning: "集計中…",
+    LocaleKey.monit_diskUsageUpdatedAt: "更新：%a",
+    LocaleKey.monit_diskUsageNotScanned: "バックアップ容量はまだ集計されていません",
 
     LocaleKey.setting_title: "設定",
     LocaleKey.setting_language: '言語',
@@ -1174,6 +1285,12 @@ class AppLocale {
     LocaleKey.vertree_totalNodes: "総ノード数",
     LocaleKey.vertree_totalBranches: "分岐ノード数",
     LocaleKey.vertree_canvasHint: "ドラッグで移動、ホイールで拡大縮小、ノードを右クリックで操作",
+    LocaleKey.vertree_searchHint: "すべてのバージョンからテキストを検索",
+    LocaleKey.vertree_searchRegex: "正規表現",
+    LocaleKey.vertree_searchClear: "検索をクリア",
+    LocaleKey.vertree_searchResult: "%a / %a 個のバージョンが一致",
+    LocaleKey.vertree_searchNoMatch: "このテキストを含むバージョンはありません",
+    LocaleKey.vertree_searchFailed: "検索に失敗しました: %a",
 
     LocaleKey.monitcard_monitorStatus: "%aの監視は%aされました",
     // Needs context for %a (e.g., 開始/停止 - started/stopped)
@@ -1192,6 +1309,8 @@ class AppLocale {
     LocaleKey.monitcard_cleanDialogConfirm: "確認",
     LocaleKey.monitcard_statusEnabled: "有効",
     LocaleKey.monitcard_statusDisabled: "無効",
+    LocaleKey.monitcard_diskUsage: "バックアップ：%a（%a 件、1 日あたり %a 増加）",
+    LocaleKey.monitcard_diskUsageLargest: "最大のスナップショット：%a（%a）",
 
     LocaleKey.filetree_inputLabelTitle: "ラベルを入力してください",
     LocaleKey.filetree_inputLabelHint: "ラベルを入力してください（任意）",
@@ -1199,6 +1318,9 @@ class AppLocale {
     LocaleKey.filetree_inputConfirm: "確認",
     LocaleKey.filetree_backupBlockedHasChild:
         "このバージョンにはすでに直系の子があるため、バックアップできません",
+    LocaleKey.filetree_copyProgressTitle: "バージョンをコピー中",
+    LocaleKey.filetree_copyProgressBytes: "%a / %a",
+    LocaleKey.filetree_copyResumed: "%a から再開",
 
     LocaleKey.fileleaf_noLabel: "備考なし",
     LocaleKey.fileleaf_lastModified: "最終更新",
@@ -1226,6 +1348,12 @@ class AppLocale {
     LocaleKey.fileleaf_shareCopyLink: "リンクをコピー",
     LocaleKey.fileleaf_shareOpenLanding: "共有ページを開く",
     LocaleKey.fileleaf_shareOpenFailed: "共有ページを開けませんでした",
+    LocaleKey.fileleaf_menuCompare: "前のバージョンと比較",
+    LocaleKey.fileleaf_compareTitle: "比較 %a → %a",
+    LocaleKey.fileleaf_compareSummary: "削除 %a 行、追加 %a 行、差分 %a 箇所",
+    LocaleKey.fileleaf_compareIdentical: "2 つのバージョンの内容は同じです",
+    LocaleKey.fileleaf_compareTruncated: "差分が長すぎるため、先頭部分のみ表示しています",
+    LocaleKey.fileleaf_compareFailed: "バージョンを比較できません: %a",
     LocaleKey.fileleaf_monitTitle: "ファイル監視の確認",
     LocaleKey.fileleaf_monitContent: "ファイル「%a.%a」の監視を開始しますか？",
     LocaleKey.fileleaf_notifyFailed: "Vertreeの監視に失敗しました、",
@@ -0,0 +1,379 @@
+/// 轻量的进程内指标注册表，输出 Prometheus text exposition format (0.0.4)。
+///
+/// 热路径上的更新只做一次 Map 查找和若干整数/浮点加法；
+/// 需要更低开销时可以先通过 `series(...)` 取到某组标签的句柄并缓存。
+class MetricsRegistry {
+  final Map<String, Metric> _metrics = <String, Metric>{};
+
+  Iterable<Metric> get metrics => _metrics.values;
+
+  MetricCounter counter(
+    String name,
+    String help, {
+    List<String> labelNames = const [],
+  }) {
+    return _register(MetricCounter._(name, help, labelNames));
+  }
+
+  MetricGauge gauge(
+    String name,
+    String help, {
+    List<String> labelNames = const [],
+  }) {
+    return _register(MetricGauge._(name, help, labelNames));
+  }
+
+  MetricHistogram histogram(
+    String name,
+    String help, {
+    required List<double> buckets,
+    List<String> labelNames = const [],
+  }) {
+    return _register(MetricHistogram._(name, help, labelNames, buckets));
+  }
+
+  T _register<T extends Metric>(T metric) {
+    final existing = _metrics[metric.name];
+    if (existing != null) {
+      if (existing is T) {
+        return existing;
+      }
+      throw ArgumentError('Metric ${metric.name} already registered');
+    }
+    _metrics[metric.name] = metric;
+    return metric;
+  }
+
+  String renderPrometheusText() {
+    final buffer = StringBuffer();
+    for (final metric in _metrics.values) {
+      metric._writeTo(buffer);
+    }
+    return buffer.toString();
+  }
+
+  Map<String, dynamic> toJson() {
+    return {for (final metric in _metrics.values) metric.name: metric.toJson()};
+  }
+}
+
+abstract class Metric {
+  Metric(this.name, this.help, this.labelNames);
+
+  final String name;
+  final String help;
+  final List<String> labelNames;
+
+  String get type;
+
+  void _writeSamples(StringBuffer buffer);
+
+  Map<String, dynamic> toJson();
+
+  void _writeTo(StringBuffer buffer) {
+    buffer
+      ..write('# HELP ')
+      ..write(name)
+      ..write(' ')
+      ..writeln(help.replaceAll('\\', r'\\').replaceAll('\n', r'\n'))
+      ..write('# TYPE ')
+      ..write(name)
+      ..write(' ')
+      ..writeln(type);
+    _writeSamples(buffer);
+  }
+
+  String _seriesKey(List<String> labelValues) {
+    if (labelValues.length != labelNames.length) {
+      throw ArgumentError(
+        'Metric $name expects labels $labelNames, got $labelValues',
+      );
+    }
+    return labelValues.join('\u0000');
+  }
+
+  String _formatLabels(List<String> labelValues, [String? extra]) {
+    if (labelValues.isEmpty && extra == null) {
+      return '';
+    }
+    final parts = <String>[
+      for (var index = 0; index < labelNames.length; index++)
+        '${labelNames[index]}="${_escapeLabelValue(labelValues[index])}"',
+      if (extra != null) extra,
+    ];
+    return '{${parts.join(',')}}';
+  }
+
+  static String _escapeLabelValue(String value) {
+    return value
+        .replaceAll('\\', r'\\')
+        .replaceAll('"', r'\"')
+        .replaceAll('\n', r'\n');
+  }
+
+  static String _formatValue(num value) {
+    if (value is double) {
+      if (value.isNaN) {
+        return 'NaN';
+      }
+      if (value.isInfinite) {
+        return value > 0 ? '+Inf' : '-Inf';
+      }
+      if (value == value.truncateToDouble() && value.abs() < 1e15) {
+        return value.toInt().toString();
+      }
+    }
+    return value.toString();
+  }
+}
+
+class MetricCounter extends Metric {
+  MetricCounter._(super.name, super.help, super.labelNames);
+
+  final Map<String, CounterSeries> _series = <String, CounterSeries>{};
+
+  @override
+  String get type => 'counter';
+
+  CounterSeries series([List<String> labelValues = const []]) {
+    final key = _seriesKey(labelValues);
+    return _series[key] ??= CounterSeries._(List.unmodifiable(labelValues));
+  }
+
+  void inc([List<String> labelValues = const [], num amount = 1]) {
+    series(labelValues).inc(amount);
+  }
+
+  @override
+  void _writeSamples(StringBuffer buffer) {
+    for (final series in _series.values) {
+      buffer.writeln(
+        '$name${_formatLabels(series.labelValues)} ${Metric._formatValue(series.value)}',
+      );
+    }
+  }
+
+  @override
+  Map<String, dynamic> toJson() => {
+    'type': type,
+    'series': [
+      for (final series in _series.values)
+        {'labels': series.labelValues, 'value': series.value},
+    ],
+  };
+}
+
+class CounterSeries {
+  CounterSeries._(this.labelValues);
+
+  final List<String> labelValues;
+  num value = 0;
+
+  void inc([num amount = 1]) {
+    if (amount < 0) {
+      throw ArgumentError('Counters can only increase');
+    }
+    value += amount;
+  }
+}
+
+class MetricGauge extends Metric {
+  MetricGauge._(super.name, super.help, super.labelNames);
+
+  final Map<String, GaugeSeries> _series = <String, GaugeSeries>{};
+
+  @override
+  String get type => 'gauge';
+
+  GaugeSeries series([List<String> labelValues = const []]) {
+    final key = _seriesKey(labelValues);
+    return _series[key] ??= GaugeSeries._(List.unmodifiable(labelValues));
+  }
+
+  void set(num value, [List<String> labelValues = const []]) {
+    series(labelValues).value = value;
+  }
+
+  /// 注册一个在抓取时才求值的读数，适合任务数量这类已由别处维护的状态
+  void bind(num Function() read, [List<String> labelValues = const []]) {
+    series(labelValues)._read = read;
+  }
+
+  @override
+  void _writeSamples(StringBuffer buffer) {
+    for (final series in _series.values) {
+      buffer.writeln(
+        '$name${_formatLabels(series.labelValues)} ${Metric._formatValue(series.current)}',
+      );
+    }
+  }
+
+  @override
+  Map<String, dynamic> toJson() => {
+    'type': type,
+    'series': [
+      for (final series in _series.values)
+        {'labels': series.labelValues, 'value': series.current},
+    ],
+  };
+}
+
+class GaugeSeries {
+  GaugeSeries._(this.labelValues);
+
+  final List<String> labelValues;
+  num value = 0;
+  num Function()? _read;
+
+  num get current {
+    final read = _read;
+    if (read == null) {
+      return value;
+    }
+    try {
+      return read();
+    } catch (_) {
+      return double.nan;
+    }
+  }
+}
+
+class MetricHistogram extends Metric {
+  MetricHistogram._(
+    super.name,
+    super.help,
+    super.labelNames,
+    List<double> buckets,
+  ) : buckets = List.unmodifiable(List<double>.from(buckets)..sort());
+
+  /// 常用的耗时分桶（秒）
+  static const List<double> latencySecondsBuckets = [
+    0.001,
+    0.0025,
+    0.005,
+    0.01,
+    0.025,
+    0.05,
+    0.1,
+    0.25,
+    0.5,
+    1,
+    2.5,
+    5,
+    10,
+    30,
+    60,
+  ];
+
+  /// 常用的字节数分桶：1 KiB 到 4 GiB，每档 ×4
+  static const List<double> byteSizeBuckets = [
+    1024,
+    4096,
+    16384,
+    65536,
+    262144,
+    1048576,
+    4194304,
+    16777216,
+    67108864,
+    268435456,
+    1073741824,
+    4294967296,
+  ];
+
+  final List<double> buckets;
+  final Map<String, HistogramSeries> _series = <String, HistogramSeries>{};
+
+  @override
+  String get type => 'histogram';
+
+  HistogramSeries series([List<String> labelValues = const []]) {
+    final key = _seriesKey(labelValues);
+    return _series[key] ??= HistogramSeries._(
+      List.unmodifiable(labelValues),
+      buckets,
+    );
+  }
+
+  void observe(num value, [List<String> labelValues = const []]) {
+    series(labelValues).observe(value);
+  }
+
+  void observeDuration(
+    Duration duration, [
+    List<String> labelValues = const [],
+  ]) {
+    series(labelValues).observe(duration.inMicroseconds / 1000000);
+  }
+
+  @override
+  void _writeSamples(StringBuffer buffer) {
+    for (final series in _series.values) {
+      var cumulative = 0;
+      for (var index = 0; index < buckets.length; index++) {
+        cumulative += series._bucketCounts[index];
+        final le = 'le="${Metric._formatValue(buckets[index])}"';
+        buffer.writeln(
+          '${name}_bucket${_formatLabels(series.labelValues, le)} $cumulative',
+        );
+      }
+      buffer
+        ..writeln(
+          '${name}_bucket${_formatLabels(series.labelValues, 'le="+Inf"')} ${series.count}',
+        )
+        ..writeln(
+          '${name}_sum${_formatLabels(series.labelValues)} ${Metric._formatValue(series.sum)}',
+        )
+        ..writeln(
+          '${name}_count${_formatLabels(series.labelValues)} ${series.count}',
+        );
+    }
+  }
+
+  @override
+  Map<String, dynamic> toJson() => {
+    'type': type,
+    'buckets': buckets,
+    'series': [
+      for (final series in _series.values)
+        {
+          'labels': series.labelValues,
+          'count': series.count,
+          'sum': series.sum,
+          'bucketCounts': List<int>.from(series._bucketCounts),
+        },
+    ],
+  };
+}
+
+class HistogramSeries {
+  HistogramSeries._(this.labelValues, this._bounds)
+    : _bucketCounts = List<int>.filled(_bounds.length, 0);
+
+  final List<String> labelValues;
+  final List<double> _bounds;
+
+  /// 非累积计数，最后一档之外的观测只计入 count（即 +Inf 桶）
+  final List<int> _bucketCounts;
+  int count = 0;
+  double sum = 0;
+
+  void observe(num value) {
+    count += 1;
+    sum += value.toDouble();
+
+    var low = 0;
+    var high = _bounds.length;
+    while (low < high) {
+      final mid = (low + high) >> 1;
+      if (value <= _bounds[mid]) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    if (low < _bounds.length) {
+      _bucketCounts[low] += 1;
+    }
+  }
+}
@@ -1,10 +1,14 @@
 import 'package:vertree/component/AppLaunchArgs.dart';
 
 class AppCliRequest {
-  const AppCliRequest({required this.action, required this.path});
+  const AppCliRequest({required this.action, required this.paths});
 
   final AppCliAction action;
-  final String path;
+
+  /// 文件管理器多选时一次传入的全部路径，至少一个
+  final List<String> paths;
+
+  String get path => paths.first;
 }
 
 enum AppCliAction {
@@ -14,6 +18,10 @@ enum AppCliAction {
   share,
   viewtree;
 
+  /// 多个路径一次提交时合并为一个批量任务的动作；其余动作只处理第一个路径
+  bool get supportsBatch =>
+      this == backup || this == expressBackup || this == monit;
+
   static AppCliAction? fromToken(String raw) {
     final token = raw.trim().toLowerCase();
     switch (token) {
@@ -55,24 +63,20 @@ AppCliRequest? parseAppCliArgs(List<String> rawArgs) {
   if (args.length == 1 &&
       !_looksLikeOption(args.first) &&
       AppCliAction.fromToken(args.first) == null) {
-    return AppCliRequest(action: AppCliAction.viewtree, path: args.first);
+    return AppCliRequest(action: AppCliAction.viewtree, paths: [args.first]);
   }
 
-  if (args.length == 2) {
-    final action = AppCliAction.fromToken(args.first);
-    if (action != null) {
-      return AppCliRequest(action: action, path: args.last);
-    }
+  // `<动作> <路径>...` 或 `--menu|--service <动作> <路径>...`
+  final actionIndex = _isInvocationSource(args.first) ? 1 : 0;
+  if (args.length < actionIndex + 2) {
+    return null;
   }
-
-  if (args.length == 3 && _isInvocationSource(args.first)) {
-    final action = AppCliAction.fromToken(args[1]);
-    if (action != null) {
-      return AppCliRequest(action: action, path: args.last);
-    }
+  final action = AppCliAction.fromToken(args[actionIndex]);
+  final paths = args.sublist(actionIndex + 1);
+  if (action == null) {
+    return null;
   }
-
-  return null;
+  return AppCliRequest(action: action, paths: paths);
 }
 
 bool _looksLikeOption(String value) => value.startsWith('-');
@@ -1,21 +1,26 @@
+import 'dart:async';
 import 'dart:io';
 
 import 'package:vertree/component/AppLaunchArgs.dart';
 import 'package:vertree/component/app_cli.dart';
 
 typedef FileActionCallback = void Function(String path);
+typedef FileBatchActionCallback =
+    void Function(AppCliAction action, List<String> paths);
 typedef UserNotificationCallback = void Function(String title, String body);
 
 class AppCommandHandler {
-  const AppCommandHandler({
+  AppCommandHandler({
     required this.onBackup,
     required this.onExpressBackup,
     required this.onMonit,
     required this.onShare,
     required this.onViewTree,
+    required this.onBatch,
     required this.onNotify,
     required this.onLogInfo,
     required this.onLogError,
+    this.batchWindow = const Duration(milliseconds: 300),
   });
 
   final FileActionCallback onBackup;
@@ -23,10 +28,22 @@ class AppCommandHandler {
   final FileActionCallback onMonit;
   final FileActionCallback onShare;
   final FileActionCallback onViewTree;
+
+  /// 同一动作收集到多个路径时调用一次，代替逐个调用单文件回调
+  final FileBatchActionCallback onBatch;
   final UserNotificationCallback onNotify;
   final void Function(String message) onLogInfo;
   final void Function(String message) onLogError;
 
+  /// 可批量的动作在这段时间内陆续到达的路径合并为一批。
+  ///
+  /// Windows 经典菜单和 macOS 服务对多选的每个文件各启动一次，请求经单实例
+  /// 转发到这里时只差几毫秒；合并后只执行一个批量任务、发一条通知。
+  final Duration batchWindow;
+
+  final Map<AppCliAction, List<String>> _pending = {};
+  final Map<AppCliAction, Timer> _timers = {};
+
   bool isActionable(List<String> args) => parseAppCliArgs(args) != null;
 
   void process(List<String> args) {
@@ -41,37 +58,95 @@ class AppCommandHandler {
         return;
       }
 
-      final path = request.path;
-      final entity = FileSystemEntity.typeSync(path);
-      if (entity == FileSystemEntityType.notFound) {
-        onLogError("传入的 path 不存在: $path");
-        onNotify("发生错误", "传入的 path 不存在: $path");
+      if (request.action.supportsBatch) {
+        _enqueue(request);
         return;
       }
-      if (entity == FileSystemEntityType.directory) {
-        onLogError("传入的 path 是一个文件夹，不对文件夹进行处理: $path");
+      if (request.paths.length > 1) {
+        onLogInfo("${request.action.name} 只处理第一个文件: ${request.path}");
+      }
+
+      final path = request.path;
+      if (!_checkPath(path)) {
         return;
       }
 
       switch (request.action) {
+        case AppCliAction.share:
+          onShare(path);
+          break;
+        case AppCliAction.viewtree:
+          onViewTree(path);
+          break;
+        case AppCliAction.backup:
+        case AppCliAction.expressBackup:
+        case AppCliAction.monit:
+          break;
+      }
+    } catch (e) {
+      onLogError('Vertree处理参数失败: $e');
+    }
+  }
+
+  /// 立即执行所有等待合并的请求
+  void flush() {
+    for (final action in _pending.keys.toList()) {
+      _dispatch(action);
+    }
+  }
+
+  void _enqueue(AppCliRequest request) {
+    // 单个路径沿用原来的检查与提示；多选中不存在的文件由批量结果汇总
+    if (request.paths.length == 1 && !_checkPath(request.path)) {
+      return;
+    }
+    final action = request.action;
+    (_pending[action] ??= []).addAll(request.paths);
+    _timers[action]?.cancel();
+    _timers[action] = Timer(batchWindow, () => _dispatch(action));
+  }
+
+  void _dispatch(AppCliAction action) {
+    _timers.remove(action)?.cancel();
+    final paths = _pending.remove(action);
+    if (paths == null || paths.isEmpty) {
+      return;
+    }
+    try {
+      if (paths.length > 1) {
+        onBatch(action, paths);
+        return;
+      }
+      switch (action) {
         case AppCliAction.backup:
-          onBackup(path);
+          onBackup(paths.single);
           break;
         case AppCliAction.expressBackup:
-          onExpressBackup(path);
+          onExpressBackup(paths.single);
           break;
         case AppCliAction.monit:
-          onMonit(path);
+          onMonit(paths.single);
           break;
         case AppCliAction.share:
-          onShare(path);
-          break;
         case AppCliAction.viewtree:
-          onViewTree(path);
           break;
       }
     } catch (e) {
       onLogError('Vertree处理参数失败: $e');
     }
   }
+
+  bool _checkPath(String path) {
+    final entity = FileSystemEntity.typeSync(path);
+    if (entity == FileSystemEntityType.notFound) {
+      onLogError("传入的 path 不存在: $path");
+      onNotify("发生错误", "传入的 path 不存在: $path");
+      return false;
+    }
+    if (entity == FileSystemEntityType.directory) {
+      onLogError("传入的 path 是一个文件夹，不对文件夹进行处理: $path");
+      return false;
+    }
+    return true;
+  }
 }
@@ -0,0 +1,198 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+
+/// 清单中一个文件的校验记录
+class ChecksumEntry {
+  const ChecksumEntry({
+    required this.name,
+    required this.hash,
+    required this.size,
+    required this.modifiedMicros,
+  });
+
+  /// 记录复制结果：[checksum] 来自复制时计算的值，修改时间取自刚写完的文件。
+  /// [name] 默认为文件名，分片备份目录中是相对目录的路径
+  factory ChecksumEntry.ofFile(
+    String filePath,
+    FileChecksum checksum, {
+    String? name,
+  }) {
+    return ChecksumEntry(
+      name: name ?? p.basename(filePath),
+      hash: checksum.hex,
+      size: checksum.size,
+      modifiedMicros: File(
+        filePath,
+      ).lastModifiedSync().microsecondsSinceEpoch,
+    );
+  }
+
+  /// 文件名，不含目录；分片备份目录中是以 `/` 分隔的相对路径
+  final String name;
+
+  /// 16 位十六进制 XXH64
+  final String hash;
+  final int size;
+  final int modifiedMicros;
+
+  Map<String, dynamic> toJson() => {
+    'name': name,
+    'hash': hash,
+    'size': size,
+    'modifiedAt': DateTime.fromMicrosecondsSinceEpoch(
+      modifiedMicros,
+    ).toIso8601String(),
+  };
+}
+
+/// 版本家族或备份目录的校验清单，是和文件放在同一目录下的隐藏文本文件：
+///
+/// ```
+/// # vertree-sums v1 xxh64
+/// <hash> <size> <mtimeMicros> <name>
+/// - <name>
+/// ```
+///
+/// 复制完成时追加一行，不重写整个文件；同名的后一行覆盖前一行，`-` 开头的
+/// 行表示文件已被清理。[compactSync] 去掉被覆盖的行。
+///
+/// 修改时间用来区分两种情况：时间没变而内容变了是静默损坏，时间变了是
+/// 用户自己改过（比如仍在编辑的最新版本），只需要更新记录。
+class ChecksumManifest {
+  ChecksumManifest._(this.path, this.entries, this.lineCount);
+
+  static const String header = '# vertree-sums v1 xxh64';
+  static const String backupManifestName = '.vertree.sums';
+  static const String _suffix = '.vertree.sums';
+
+  /// 清单文件的完整路径
+  final String path;
+  final Map<String, ChecksumEntry> entries;
+
+  /// 文件中的记录行数（含被覆盖的行）
+  final int lineCount;
+
+  String get directory => p.dirname(path);
+
+  /// 被覆盖或已删除的行较多，值得重写
+  bool get needsCompaction => lineCount > entries.length * 2 + 16;
+
+  /// 版本家族的清单：`.<名称>.<扩展名>.vertree.sums`，与版本文件同目录
+  static String familyManifestPath(String versionFilePath) {
+    final name = FileMeta.nameOf(versionFilePath);
+    return p.join(
+      p.dirname(versionFilePath),
+      '.$name${p.extension(versionFilePath)}$_suffix',
+    );
+  }
+
+  /// 监控备份目录的清单
+  static String backupManifestPath(String backupDirPath) {
+    return p.join(backupDirPath, backupManifestName);
+  }
+
+  static bool isManifestPath(String filePath) {
+    final name = p.basename(filePath);
+    return name.startsWith('.') &&
+        (name.endsWith(_suffix) || name.endsWith('$_suffix.tmp'));
+  }
+
+  /// 不存在或无法读取时返回空清单
+  static ChecksumManifest loadSync(String manifestPath) {
+    final entries = <String, ChecksumEntry>{};
+    var lineCount = 0;
+    final file = File(manifestPath);
+    if (!file.existsSync()) {
+      return ChecksumManifest._(manifestPath, entries, 0);
+    }
+    final List<String> lines;
+    try {
+      lines = file.readAsLinesSync();
+    } on FileSystemException {
+      return ChecksumManifest._(manifestPath, entries, 0);
+    }
+    for (final line in lines) {
+      if (line.isEmpty || line.startsWith('#')) {
+        continue;
+      }
+      lineCount += 1;
+      if (line.startsWith('- ')) {
+        entries.remove(line.substring(2));
+        continue;
+      }
+      final entry = _parse(line);
+      if (entry != null) {
+        entries[entry.name] = entry;
+      }
+    }
+    return ChecksumManifest._(manifestPath, entries, lineCount);
+  }
+
+  /// 追加记录；清单不存在时先写入表头
+  static void appendSync(String manifestPath, Iterable<ChecksumEntry> added) {
+    final buffer = StringBuffer();
+    for (final entry in added) {
+      buffer.writeln(
+        '${entry.hash} ${entry.size} ${entry.modifiedMicros} ${entry.name}',
+      );
+    }
+    _appendLines(manifestPath, buffer);
+  }
+
+  /// 追加删除记录
+  static void appendRemovalsSync(String manifestPath, Iterable<String> names) {
+    final buffer = StringBuffer();
+    for (final name in names) {
+      buffer.writeln('- $name');
+    }
+    _appendLines(manifestPath, buffer);
+  }
+
+  /// 只保留当前记录，写入临时文件后替换，中途失败不会丢掉原清单
+  void compactSync() {
+    final buffer = StringBuffer()..writeln(header);
+    final names = entries.keys.toList()..sort();
+    for (final name in names) {
+      final entry = entries[name]!;
+      buffer.writeln(
+        '${entry.hash} ${entry.size} ${entry.modifiedMicros} ${entry.name}',
+      );
+    }
+    final temp = File('$path.tmp');
+    temp.writeAsStringSync(buffer.toString(), flush: true);
+    temp.renameSync(path);
+  }
+
+  static void _appendLines(String manifestPath, StringBuffer lines) {
+    if (lines.isEmpty) {
+      return;
+    }
+    final file = File(manifestPath);
+    final prefix = file.existsSync() ? '' : '$header\n';
+    file.writeAsStringSync('$prefix$lines', mode: FileMode.append);
+  }
+
+  static ChecksumEntry? _parse(String line) {
+    final first = line.indexOf(' ');
+    final second = first < 0 ? -1 : line.indexOf(' ', first + 1);
+    final third = second < 0 ? -1 : line.indexOf(' ', second + 1);
+    if (third < 0 || third == line.length - 1) {
+      return null;
+    }
+    final hash = line.substring(0, first);
+    final size = int.tryParse(line.substring(first + 1, second));
+    final modified = int.tryParse(line.substring(second + 1, third));
+    if (hash.length != 16 || size == null || modified == null) {
+      return null;
+    }
+    return ChecksumEntry(
+      name: line.substring(third + 1),
+      hash: hash,
+      size: size,
+      modifiedMicros: modified,
+    );
+  }
+}
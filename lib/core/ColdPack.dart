@@ -0,0 +1,545 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/core/VersionPack.dart';
+
+/// 冷存储打包文件中的一个快照
+class ColdPackEntry {
+  const ColdPackEntry({
+    required this.pack,
+    required this.createdMicros,
+    required this.data,
+  });
+
+  /// 所在打包文件的文件名，如 `2024-03.vtcold`
+  final String pack;
+
+  /// 快照时间，与 [SnapshotRecord.createdMicros] 一致
+  final int createdMicros;
+
+  /// 数据的偏移、压缩方式与校验和，编码与 `.vtpack` 条目相同；名称是快照
+  /// 原来相对备份目录的路径
+  final VersionPackEntry data;
+
+  String get name => data.name;
+  int get size => data.size;
+
+  DateTime get createdAt => DateTime.fromMicrosecondsSinceEpoch(createdMicros);
+
+  SnapshotRecord toRecord() => SnapshotRecord(
+    name: name,
+    createdMicros: createdMicros,
+    size: size,
+    hash: data.hash,
+  );
+
+  Map<String, dynamic> toJson() => {
+    'name': name,
+    'pack': pack,
+    'createdAt': createdAt.toIso8601String(),
+    'offset': data.offset,
+    'size': size,
+    'storedSize': data.storedSize,
+    'compression': data.compressed ? 'zlib' : 'none',
+    'hash': data.hash,
+  };
+}
+
+/// 一个备份目录的一次打包结果
+class ColdPackResult {
+  const ColdPackResult({
+    required this.backupDirPath,
+    required this.removedNames,
+    required this.packedCount,
+    required this.skippedCount,
+    required this.looseBytes,
+    required this.storedBytes,
+    required this.createdFileCount,
+  });
+
+  final String backupDirPath;
+
+  /// 已删除散文件的快照，调用方据此在主 isolate 更新快照索引与校验清单
+  final List<String> removedNames;
+
+  /// 这次写进打包文件的快照数；上次已打包、只差删除散文件的不计入
+  final int packedCount;
+
+  /// 读不到或内容与校验记录不符、保留为散文件的快照数
+  final int skippedCount;
+
+  /// 删除的散文件的字节数
+  final int looseBytes;
+
+  /// 写入打包文件与冷存储索引的字节数（含对齐填充）
+  final int storedBytes;
+
+  /// 新建的打包文件、冷存储目录和索引文件个数
+  final int createdFileCount;
+
+  int get inodesSaved => removedNames.length - createdFileCount;
+
+  int get bytesSaved => looseBytes - storedBytes;
+
+  Map<String, dynamic> toJson() => {
+    'backupDirPath': backupDirPath,
+    'packedCount': packedCount,
+    'removedFileCount': removedNames.length,
+    'skippedCount': skippedCount,
+    'looseBytes': looseBytes,
+    'storedBytes': storedBytes,
+    'bytesSaved': bytesSaved,
+    'inodesSaved': inodesSaved,
+  };
+}
+
+/// 监控备份的冷存储：较旧的快照按月追加进备份目录下 `.vertree.cold/` 中的
+/// `<yyyy-mm>.vtcold` 打包文件，删除原来的散文件，省下 inode 和小文件的
+/// 块尾浪费。
+///
+/// 打包文件（小端序）：16 字节文件头（魔数 `VTCOLD01`、u32 格式版本、
+/// u32 保留），之后是各条目的数据，编码与 `.vtpack` 条目相同（按需 zlib
+/// 压缩，对齐后开始）。打包文件只追加，没有文件尾；条目位置记在同目录的
+/// 文本索引 `cold.index` 中：
+///
+/// ```
+/// # vertree-cold v1
+/// <pack> <offset> <storedSize> <size> <zlib|none> <hash> <createdMicros> <modifiedMicros> <name>
+/// - <name>
+/// ```
+///
+/// 写入顺序是数据落盘、索引追加、删除散文件，任何一步中断都不会丢快照：
+/// 打包文件中没有记入索引的尾部在下次追加前截掉，已记入索引但散文件还在
+/// 的快照下次只删散文件。每个快照都能按偏移单独读出并核对校验和。
+///
+/// 已打包的快照照样计入保留策略（monitorMaxSize）：清理时追加 `-` 行，
+/// 条目全被清掉的打包文件随即删除，其余的空洞留到整月清空。打包按开始时的
+/// 快照列表工作，同一备份目录的打包与清理经 [runLocked] 依次执行。
+class ColdPack {
+  ColdPack._(this.backupDirPath, this.entries, this.lineCount);
+
+  static const String directoryName = '.vertree.cold';
+  static const String indexFileName = 'cold.index';
+  static const String packSuffix = '.vtcold';
+  static const String header = '# vertree-cold v1';
+  static const int formatVersion = 1;
+  static const List<int> fileMagic = [
+    0x56, 0x54, 0x43, 0x4f, 0x4c, 0x44, 0x30, 0x31, // VTCOLD01
+  ];
+  static const int headerSize = 16;
+
+  final String backupDirPath;
+  final Map<String, ColdPackEntry> entries;
+
+  /// 索引中的记录行数（含被覆盖和已删除的行）
+  final int lineCount;
+
+  static final Map<String, Future<void>> _tails = {};
+
+  /// 按快照时间从旧到新
+  List<ColdPackEntry> get sorted {
+    return entries.values.toList()..sort((a, b) {
+      final byTime = a.createdMicros.compareTo(b.createdMicros);
+      return byTime != 0 ? byTime : a.name.compareTo(b.name);
+    });
+  }
+
+  static String directoryPath(String backupDirPath) {
+    return p.join(backupDirPath, directoryName);
+  }
+
+  static String indexPath(String backupDirPath) {
+    return p.join(directoryPath(backupDirPath), indexFileName);
+  }
+
+  /// 冷存储目录中的文件，它们不是快照
+  static bool isColdPath(String filePath) {
+    return p.split(filePath).contains(directoryName);
+  }
+
+  /// 打包文件按快照的本地年月命名
+  static String packNameFor(DateTime createdAt) {
+    return '${createdAt.year.toString().padLeft(4, '0')}-'
+        '${createdAt.month.toString().padLeft(2, '0')}$packSuffix';
+  }
+
+  /// 在 [backupDirPath] 上依次执行打包与保留策略清理，前一个结束（成功或
+  /// 失败）后才开始下一个。只在主 isolate 中使用。
+  static Future<T> runLocked<T>(
+    String backupDirPath,
+    FutureOr<T> Function() action,
+  ) {
+    final key = p.normalize(backupDirPath);
+    final next = (_tails[key] ?? Future<void>.value()).then((_) => action());
+    final tail = next.then<void>((_) {}, onError: (_) {});
+    _tails[key] = tail;
+    tail.then((_) {
+      if (identical(_tails[key], tail)) {
+        _tails.remove(key);
+      }
+    });
+    return next;
+  }
+
+  /// 不存在或无法读取时返回空的冷存储
+  static ColdPack loadSync(String backupDirPath) {
+    final entries = <String, ColdPackEntry>{};
+    var lineCount = 0;
+    final List<String> lines;
+    try {
+      lines = File(indexPath(backupDirPath)).readAsLinesSync();
+    } on FileSystemException {
+      return ColdPack._(backupDirPath, entries, 0);
+    }
+    for (final line in lines) {
+      if (line.isEmpty || line.startsWith('#')) {
+        continue;
+      }
+      lineCount += 1;
+      if (line.startsWith('- ')) {
+        entries.remove(line.substring(2));
+        continue;
+      }
+      final entry = _parse(line);
+      if (entry != null) {
+        entries[entry.name] = entry;
+      }
+    }
+    return ColdPack._(backupDirPath, entries, lineCount);
+  }
+
+  /// 保留策略清理掉已打包的快照 [names]：追加 `-` 行，删除不再有条目的
+  /// 打包文件，失效的行较多时重写索引
+  static void recordRemovalsSync(String backupDirPath, Iterable<String> names) {
+    final removed = names.toList();
+    final index = File(indexPath(backupDirPath));
+    if (removed.isEmpty || !index.existsSync()) {
+      return;
+    }
+    final lines = StringBuffer();
+    for (final name in removed) {
+      lines.writeln('- $name');
+    }
+    index.writeAsStringSync(
+      lines.toString(),
+      mode: FileMode.append,
+      flush: true,
+    );
+
+    final cold = loadSync(backupDirPath);
+    final livePacks = {for (final entry in cold.entries.values) entry.pack};
+    for (final entity in Directory(
+      directoryPath(backupDirPath),
+    ).listSync(followLinks: false)) {
+      final name = p.basename(entity.path);
+      if (entity is File &&
+          name.endsWith(packSuffix) &&
+          !livePacks.contains(name)) {
+        try {
+          entity.deleteSync();
+        } on FileSystemException {
+          // 留到下次清理再删，数据已不在索引中
+        }
+      }
+    }
+    if (cold.lineCount > cold.entries.length * 2 + 16) {
+      final buffer = StringBuffer()..writeln(header);
+      for (final entry in cold.sorted) {
+        buffer.writeln(_format(entry));
+      }
+      final temp = File('${index.path}.tmp');
+      temp.writeAsStringSync(buffer.toString(), flush: true);
+      temp.renameSync(index.path);
+    }
+  }
+
+  String packPath(ColdPackEntry entry) {
+    return p.join(directoryPath(backupDirPath), entry.pack);
+  }
+
+  /// 打包文件与索引实际占用的字节数
+  int storedBytesSync() {
+    final directory = Directory(directoryPath(backupDirPath));
+    if (!directory.existsSync()) {
+      return 0;
+    }
+    var total = 0;
+    for (final entity in directory.listSync(followLinks: false)) {
+      if (entity is File) {
+        total += entity.statSync().size;
+      }
+    }
+    return total;
+  }
+
+  /// 把快照写到 [targetPath]，核对校验和后再替换，并恢复原来的修改时间
+  void extractSync(ColdPackEntry entry, String targetPath) {
+    VersionPack.extractEntrySync(packPath(entry), entry.data, targetPath);
+  }
+
+  /// 把快照时间早于 [olderThan] 的散文件追加进按月的打包文件，然后删除它们。
+  ///
+  /// 在后台 isolate 中执行；只读写冷存储目录和散文件，快照索引与校验清单
+  /// 由调用方按 [ColdPackResult.removedNames] 在主 isolate 更新，避免与
+  /// 监控写入的索引行交错。调用方要在 [runLocked] 中执行，免得把保留策略
+  /// 刚清理掉的快照写进打包文件。[maxBytesPerSecond] 大于 0 时按读取的字节数
+  /// 限速，让出磁盘给前台操作。
+  static ColdPackResult packSync(
+    String backupDirPath, {
+    required DateTime olderThan,
+    int maxBytesPerSecond = 0,
+    bool compress = true,
+  }) {
+    final olderThanMicros = olderThan.microsecondsSinceEpoch;
+    final candidates = [
+      for (final snapshot in SnapshotIndex.snapshotsSync(backupDirPath))
+        if (snapshot.createdMicros < olderThanMicros) snapshot,
+    ];
+    if (candidates.isEmpty) {
+      return ColdPackResult(
+        backupDirPath: backupDirPath,
+        removedNames: const [],
+        packedCount: 0,
+        skippedCount: 0,
+        looseBytes: 0,
+        storedBytes: 0,
+        createdFileCount: 0,
+      );
+    }
+
+    final cold = loadSync(backupDirPath);
+    final manifest = ChecksumManifest.loadSync(
+      ChecksumManifest.backupManifestPath(backupDirPath),
+    );
+    final directory = Directory(directoryPath(backupDirPath));
+    var createdFileCount = 0;
+    if (!directory.existsSync()) {
+      directory.createSync(recursive: true);
+      createdFileCount += 1;
+    }
+    var storedBytes = 0;
+    final index = File(indexPath(backupDirPath));
+    if (!index.existsSync()) {
+      index.writeAsStringSync('$header\n', flush: true);
+      createdFileCount += 1;
+      storedBytes += header.length + 1;
+    }
+
+    final groups = <String, List<SnapshotRecord>>{};
+    for (final snapshot in candidates) {
+      groups.putIfAbsent(packNameFor(snapshot.createdAt), () => []).add(
+        snapshot,
+      );
+    }
+
+    final removable = <SnapshotRecord>[];
+    var packedCount = 0;
+    var skippedCount = 0;
+    var bytesRead = 0;
+    final stopwatch = Stopwatch()..start();
+
+    for (final MapEntry(key: packName, value: snapshots) in groups.entries) {
+      final packFile = File(p.join(directory.path, packName));
+      if (!packFile.existsSync()) {
+        createdFileCount += 1;
+      }
+      final handle = packFile.openSync(mode: FileMode.append);
+      final added = <ColdPackEntry>[];
+      try {
+        final lengthBefore = handle.lengthSync();
+        var position = _prepareForAppend(handle, cold, packName);
+        final appendFrom = min(lengthBefore, position);
+        for (final snapshot in snapshots) {
+          final recorded = manifest.entries[snapshot.name];
+          final expectedHash =
+              snapshot.hash ??
+              (recorded?.size == snapshot.size ? recorded?.hash : null);
+          // 上次已写进打包文件、散文件没删掉的快照，这次只删散文件
+          final existing = cold.entries[snapshot.name];
+          if (existing != null &&
+              existing.size == snapshot.size &&
+              (expectedHash == null || expectedHash == existing.data.hash)) {
+            removable.add(snapshot);
+            continue;
+          }
+
+          final VersionPackEntry data;
+          try {
+            data = VersionPack.writeEntrySync(
+              handle,
+              position,
+              snapshot.name,
+              VersionPackEntryKind.backup,
+              snapshot.pathIn(backupDirPath),
+              compress: compress,
+            );
+          } on FileSystemException {
+            // 打包期间被保留策略清理或无法读取，留给下次
+            _rollBack(handle, position);
+            skippedCount += 1;
+            continue;
+          }
+          if (data.size != snapshot.size ||
+              (expectedHash != null && data.hash != expectedHash)) {
+            // 与记录不符的快照保持原样，交给完整性校验报告
+            _rollBack(handle, position);
+            skippedCount += 1;
+            continue;
+          }
+          position = data.offset + data.storedSize;
+          added.add(
+            ColdPackEntry(
+              pack: packName,
+              createdMicros: snapshot.createdMicros,
+              data: data,
+            ),
+          );
+          removable.add(snapshot);
+
+          bytesRead += data.size;
+          if (maxBytesPerSecond > 0) {
+            final due = Duration(
+              microseconds: bytesRead * 1000000 ~/ maxBytesPerSecond,
+            );
+            if (due > stopwatch.elapsed) {
+              sleep(due - stopwatch.elapsed);
+            }
+          }
+        }
+        handle.flushSync();
+        storedBytes += position - appendFrom;
+      } finally {
+        handle.closeSync();
+      }
+
+      if (added.isNotEmpty) {
+        final lines = StringBuffer();
+        for (final entry in added) {
+          lines.writeln(_format(entry));
+        }
+        final text = lines.toString();
+        index.writeAsStringSync(text, mode: FileMode.append, flush: true);
+        storedBytes += utf8.encode(text).length;
+        packedCount += added.length;
+      }
+    }
+
+    final removedNames = <String>[];
+    var looseBytes = 0;
+    for (final snapshot in removable) {
+      try {
+        File(snapshot.pathIn(backupDirPath)).deleteSync();
+        looseBytes += snapshot.size;
+      } on PathNotFoundException {
+        // 已被保留策略删除，索引与清单里照样记一次删除
+      } on FileSystemException {
+        // 删不掉的散文件下次再删，数据已经在打包文件中
+        continue;
+      }
+      removedNames.add(snapshot.name);
+    }
+
+    return ColdPackResult(
+      backupDirPath: backupDirPath,
+      removedNames: removedNames,
+      packedCount: packedCount,
+      skippedCount: skippedCount,
+      looseBytes: looseBytes,
+      storedBytes: storedBytes,
+      createdFileCount: createdFileCount,
+    );
+  }
+
+  /// 新文件写入文件头；已有文件截掉上次中断时写了一半、没有记入索引的尾部。
+  /// 返回追加的起始位置
+  static int _prepareForAppend(
+    RandomAccessFile handle,
+    ColdPack cold,
+    String packName,
+  ) {
+    final length = handle.lengthSync();
+    if (length < headerSize) {
+      handle.truncateSync(0);
+      handle.setPositionSync(0);
+      handle.writeFromSync(fileMagic);
+      final versionBytes = ByteData(8)
+        ..setUint32(0, formatVersion, Endian.little);
+      handle.writeFromSync(versionBytes.buffer.asUint8List());
+      return headerSize;
+    }
+    var end = headerSize;
+    for (final entry in cold.entries.values) {
+      if (entry.pack == packName) {
+        final entryEnd = entry.data.offset + entry.data.storedSize;
+        end = entryEnd > end ? entryEnd : end;
+      }
+    }
+    if (length > end) {
+      handle.truncateSync(end);
+    }
+    handle.setPositionSync(end);
+    return end;
+  }
+
+  static void _rollBack(RandomAccessFile handle, int position) {
+    handle.truncateSync(position);
+    handle.setPositionSync(position);
+  }
+
+  static String _format(ColdPackEntry entry) {
+    final data = entry.data;
+    return '${entry.pack} ${data.offset} ${data.storedSize} ${data.size} '
+        '${data.compressed ? 'zlib' : 'none'} ${data.hash} '
+        '${entry.createdMicros} ${data.modifiedMicros} ${data.name}';
+  }
+
+  static ColdPackEntry? _parse(String line) {
+    final fields = <String>[];
+    var start = 0;
+    while (fields.length < 8) {
+      final space = line.indexOf(' ', start);
+      if (space < 0) {
+        return null;
+      }
+      fields.add(line.substring(start, space));
+      start = space + 1;
+    }
+    final name = line.substring(start);
+    final offset = int.tryParse(fields[1]);
+    final storedSize = int.tryParse(fields[2]);
+    final size = int.tryParse(fields[3]);
+    final createdMicros = int.tryParse(fields[6]);
+    final modifiedMicros = int.tryParse(fields[7]);
+    if (name.isEmpty ||
+        !fields[0].endsWith(packSuffix) ||
+        fields[0].contains('/') ||
+        offset == null ||
+        storedSize == null ||
+        size == null ||
+        createdMicros == null ||
+        modifiedMicros == null ||
+        fields[5].length != 16) {
+      return null;
+    }
+    return ColdPackEntry(
+      pack: fields[0],
+      createdMicros: createdMicros,
+      data: VersionPackEntry(
+        name: name,
+        kind: VersionPackEntryKind.backup,
+        offset: offset,
+        size: size,
+        storedSize: storedSize,
+        compressed: fields[4] == 'zlib',
+        hash: fields[5],
+        modifiedMicros: modifiedMicros,
+      ),
+    );
+  }
+}
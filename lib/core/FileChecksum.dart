@@ -0,0 +1,180 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:vertree/core/Xxh64.dart';
+import 'package:vertree/native/ChecksumBindings.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+/// 整个文件的 XXH64 与字节数，写入校验清单（见 ChecksumManifest）。
+///
+/// 优先调用原生库的 vt_copy_file / vt_checksum_file；库不可用时用
+/// [Xxh64] 按块读取，结果相同。同步方法会阻塞当前 isolate，界面所在的
+/// isolate 应使用返回 Future 的版本，它们在后台 isolate 中执行。
+class FileChecksum {
+  const FileChecksum({required this.hash, required this.size});
+
+  final int hash;
+  final int size;
+
+  String get hex => Xxh64.hexOf(hash);
+
+  static const int _bufferBytes = 1 << 20;
+
+  /// 复制 [sourcePath] 到 [targetPath]（覆盖），边写边算校验和，不需要再读一遍
+  /// 目标文件。失败时删除写了一半的目标文件并抛出 [FileSystemException]。
+  static Future<FileChecksum> copy(String sourcePath, String targetPath) {
+    return Isolate.run(() => copySync(sourcePath, targetPath));
+  }
+
+  /// 批量复制，每一对（源, 目标）的效果与 [copy] 相同，结果按顺序对应；复制失败的
+  /// 一项为 null，写了一半的目标文件已删除。
+  ///
+  /// 原生库在 Linux 上让多个文件的读写同时排在 io_uring 上，其他平台用线程池；
+  /// 库不可用时在后台 isolate 中逐个复制。
+  static Future<List<FileChecksum?>> copyAll(List<(String, String)> pairs) {
+    return Isolate.run(() => copyAllSync(pairs));
+  }
+
+  /// [lowPriority] 降低读取线程的 I/O 优先级，并在读完后把文件移出页缓存，
+  /// 供定时校验使用
+  static Future<FileChecksum> ofFile(String path, {bool lowPriority = false}) {
+    return Isolate.run(() => ofFileSync(path, lowPriority: lowPriority));
+  }
+
+  static FileChecksum copySync(String sourcePath, String targetPath) {
+    final bindings = ChecksumBindings.tryLoad();
+    if (bindings != null) {
+      return using((arena) {
+        final checksum = arena<VtChecksum>();
+        final status = bindings.copyFile(
+          sourcePath.toNativeUtf8(allocator: arena),
+          targetPath.toNativeUtf8(allocator: arena),
+          checksum,
+        );
+        if (status != vtOk) {
+          throw FileSystemException('复制文件失败 ($status)', sourcePath);
+        }
+        return FileChecksum(hash: checksum.ref.hash, size: checksum.ref.size);
+      });
+    }
+
+    final source = File(sourcePath).openSync();
+    RandomAccessFile? target;
+    try {
+      target = File(targetPath).openSync(mode: FileMode.write);
+      final buffer = Uint8List(_bufferBytes);
+      final hash = Xxh64();
+      while (true) {
+        final read = source.readIntoSync(buffer);
+        if (read == 0) {
+          break;
+        }
+        hash.addBytes(Uint8List.sublistView(buffer, 0, read));
+        target.writeFromSync(buffer, 0, read);
+      }
+      final finished = target;
+      target = null;
+      finished.closeSync();
+      return FileChecksum(hash: hash.value, size: hash.length);
+    } catch (_) {
+      try {
+        target?.closeSync();
+        File(targetPath).deleteSync();
+      } catch (_) {
+        // ignore
+      }
+      rethrow;
+    } finally {
+      source.closeSync();
+    }
+  }
+
+  static List<FileChecksum?> copyAllSync(List<(String, String)> pairs) {
+    if (pairs.isEmpty) {
+      return const [];
+    }
+    final bindings = ChecksumBindings.tryLoad();
+    if (bindings != null) {
+      return using((arena) {
+        final jobs = arena<VtCopyJob>(pairs.length);
+        for (var i = 0; i < pairs.length; i++) {
+          final (sourcePath, targetPath) = pairs[i];
+          jobs[i]
+            ..sourcePath = sourcePath.toNativeUtf8(allocator: arena)
+            ..targetPath = targetPath.toNativeUtf8(allocator: arena);
+        }
+        final options = arena<VtCopyOptions>();
+        bindings.copyDefaultOptions(options);
+        final results = arena<VtCopyResult>(pairs.length);
+        final status = bindings.copyBatch(
+          jobs,
+          pairs.length,
+          options,
+          results,
+        );
+        if (status != vtOk) {
+          throw FileSystemException('批量复制失败 ($status)');
+        }
+        return [
+          for (var i = 0; i < pairs.length; i++)
+            results[i].status == vtOk
+                ? FileChecksum(
+                    hash: results[i].checksum.hash,
+                    size: results[i].checksum.size,
+                  )
+                : null,
+        ];
+      });
+    }
+
+    return [
+      for (final (sourcePath, targetPath) in pairs)
+        _tryCopySync(sourcePath, targetPath),
+    ];
+  }
+
+  static FileChecksum? _tryCopySync(String sourcePath, String targetPath) {
+    try {
+      return copySync(sourcePath, targetPath);
+    } on FileSystemException {
+      return null;
+    }
+  }
+
+  static FileChecksum ofFileSync(String path, {bool lowPriority = false}) {
+    final bindings = ChecksumBindings.tryLoad();
+    if (bindings != null) {
+      return using((arena) {
+        final checksum = arena<VtChecksum>();
+        final status = bindings.checksumFile(
+          path.toNativeUtf8(allocator: arena),
+          lowPriority ? vtChecksumLowPriority | vtChecksumDropCache : 0,
+          checksum,
+        );
+        if (status != vtOk) {
+          throw FileSystemException('读取文件失败 ($status)', path);
+        }
+        return FileChecksum(hash: checksum.ref.hash, size: checksum.ref.size);
+      });
+    }
+
+    final file = File(path).openSync();
+    try {
+      final buffer = Uint8List(_bufferBytes);
+      final hash = Xxh64();
+      while (true) {
+        final read = file.readIntoSync(buffer);
+        if (read == 0) {
+          break;
+        }
+        hash.addBytes(Uint8List.sublistView(buffer, 0, read));
+      }
+      return FileChecksum(hash: hash.value, size: hash.length);
+    } finally {
+      file.closeSync();
+    }
+  }
+}
@@ -0,0 +1,376 @@
+import 'dart:async';
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
+
+import 'package:ffi/ffi.dart';
+import 'package:path/path.dart' as p;
+import 'package:vertree/component/AppMetrics.dart';
+import 'package:vertree/native/StatBindings.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+/// 文件所在文件系统的类别，决定监控能否依赖系统的文件变化通知
+enum FilesystemKind { local, network, fuse }
+
+/// 一次 stat 的结果；文件不存在时 [exists] 为 false，其余字段为 0
+class PolledFileStat {
+  const PolledFileStat({
+    required this.exists,
+    this.size = 0,
+    this.modifiedNs = 0,
+    this.changedNs = 0,
+    this.fileId = 0,
+  });
+
+  static const PolledFileStat missing = PolledFileStat(exists: false);
+
+  final bool exists;
+  final int size;
+  final int modifiedNs;
+  final int changedNs;
+  final int fileId;
+
+  /// 整个文件被替换（保存时先写临时文件再改名）也算变化
+  bool sameAs(PolledFileStat other) {
+    return exists == other.exists &&
+        size == other.size &&
+        modifiedNs == other.modifiedNs &&
+        changedNs == other.changedNs &&
+        fileId == other.fileId;
+  }
+}
+
+/// 与 [paths] 一一对应；null 表示没能读到状态（权限、网络错误），按未变化处理
+typedef StatBatchFunction =
+    Future<List<PolledFileStat?>> Function(List<String> paths);
+
+/// 为网络盘（SMB/NFS）和 FUSE（sshfs 等）上的监控文件轮询变化。
+///
+/// 这些文件系统上其他机器或 FUSE 服务端写入的内容不会产生 inotify 等通知，
+/// [Monitor] 在这类路径上改用 [watch]。所有被轮询的文件共用一个定时器：
+/// 每一轮把到期的文件合成一次批量 stat（原生库在 Linux 上经 io_uring 并发提交，
+/// 在后台 isolate 中执行），再按各文件的变化历史安排下次检查——刚变化过的文件
+/// 按 [minInterval] 检查，之后每次没有变化就乘以 [backoff]，最长 [maxInterval]。
+/// 每轮最多检查 [statsPerSecond] × [tick] 个文件，几千个文件时总开销也有上限，
+/// 超出的文件顺延到下一轮。
+class FilePoller {
+  FilePoller({
+    this.minInterval = const Duration(seconds: 1),
+    this.maxInterval = const Duration(seconds: 30),
+    this.backoff = 1.5,
+    this.tick = const Duration(milliseconds: 250),
+    this.statsPerSecond = 2000,
+    StatBatchFunction? statBatch,
+  }) : _statBatch = statBatch ?? statFiles;
+
+  final Duration minInterval;
+  final Duration maxInterval;
+  final double backoff;
+  final Duration tick;
+  final int statsPerSecond;
+  final StatBatchFunction _statBatch;
+
+  final Map<String, _PolledFile> _files = {};
+  Timer? _timer;
+  bool _polling = false;
+  int _roundCount = 0;
+  int _statCount = 0;
+  int _detectedChangeCount = 0;
+  Duration? _lastRoundDuration;
+  Duration? _lastDetectionDelay;
+
+  int get fileCount => _files.length;
+
+  /// 每轮最多检查的文件数
+  int get roundBudget =>
+      max(1, (statsPerSecond * tick.inMicroseconds / 1000000).floor());
+
+  /// 轮询 [path]，文件创建、修改、删除时发出对应的事件。
+  /// 开始后的第一轮只记录初始状态；同一路径可以被多次监听
+  Stream<FileSystemEvent> watch(String path) {
+    late final StreamController<FileSystemEvent> controller;
+    controller = StreamController<FileSystemEvent>(
+      onListen: () {
+        final file = _files.putIfAbsent(path, () => _PolledFile(path));
+        file.listeners.add(controller);
+        file.interval = minInterval;
+        file.nextDue = DateTime.now();
+        appMetrics.polledFiles.set(_files.length);
+        _timer ??= Timer.periodic(tick, (_) => _poll());
+      },
+      onCancel: () {
+        final file = _files[path];
+        file?.listeners.remove(controller);
+        if (file != null && file.listeners.isEmpty) {
+          _files.remove(path);
+        }
+        appMetrics.polledFiles.set(_files.length);
+        if (_files.isEmpty) {
+          _timer?.cancel();
+          _timer = null;
+        }
+      },
+    );
+    return controller.stream;
+  }
+
+  /// [path] 当前的检查间隔，没有在轮询时为 null
+  Duration? intervalOf(String path) => _files[path]?.interval;
+
+  /// 立即执行一轮，[all] 为 true 时不管是否到期（仍受每轮上限约束）
+  Future<void> pollNow({bool all = false}) => _poll(all: all);
+
+  Map<String, dynamic> status() {
+    return {
+      'files': _files.length,
+      'rounds': _roundCount,
+      'stats': _statCount,
+      'detectedChanges': _detectedChangeCount,
+      'roundBudget': roundBudget,
+      'lastRoundMs': _lastRoundDuration == null
+          ? null
+          : _lastRoundDuration!.inMicroseconds / 1000,
+      'lastDetectionDelayMs': _lastDetectionDelay?.inMilliseconds,
+    };
+  }
+
+  void dispose() {
+    _timer?.cancel();
+    _timer = null;
+    final listeners = [
+      for (final file in _files.values) ...file.listeners,
+    ];
+    _files.clear();
+    appMetrics.polledFiles.set(0);
+    for (final listener in listeners) {
+      listener.close();
+    }
+  }
+
+  Future<void> _poll({bool all = false}) async {
+    // 上一轮的 stat 还没返回（网络盘卡住）时跳过，不堆积请求
+    if (_polling || _files.isEmpty) {
+      return;
+    }
+    final now = DateTime.now();
+    final due =
+        _files.values
+            .where((file) => all || !file.nextDue.isAfter(now))
+            .toList()
+          ..sort((a, b) => a.nextDue.compareTo(b.nextDue));
+    if (due.isEmpty) {
+      return;
+    }
+    final batch = due.take(roundBudget).toList();
+
+    _polling = true;
+    final stopwatch = Stopwatch()..start();
+    List<PolledFileStat?> stats;
+    try {
+      stats = await _statBatch([for (final file in batch) file.path]);
+    } catch (_) {
+      // 整批失败时当作全部未变化，按退避间隔稍后再试
+      stats = List.filled(batch.length, null);
+    } finally {
+      _polling = false;
+    }
+    stopwatch.stop();
+
+    _roundCount += 1;
+    _statCount += batch.length;
+    _lastRoundDuration = stopwatch.elapsed;
+    appMetrics.pollStatsTotal.inc(batch.length);
+    appMetrics.pollRoundSeconds.observeDuration(stopwatch.elapsed);
+
+    final detectedAt = DateTime.now();
+    for (var index = 0; index < batch.length; index++) {
+      final file = batch[index];
+      // 等待 stat 期间取消监听的文件不再处理
+      if (!identical(_files[file.path], file)) {
+        continue;
+      }
+      _record(file, stats[index], detectedAt);
+    }
+  }
+
+  void _record(_PolledFile file, PolledFileStat? stat, DateTime detectedAt) {
+    final previous = file.stat;
+    if (stat != null) {
+      file.stat = stat;
+    }
+    if (previous == null || stat == null || previous.sameAs(stat)) {
+      final next = file.interval * backoff;
+      file.interval = next > maxInterval ? maxInterval : next;
+      file.nextDue = detectedAt.add(file.interval);
+      return;
+    }
+
+    file.interval = minInterval;
+    file.nextDue = detectedAt.add(minInterval);
+    _detectedChangeCount += 1;
+
+    final FileSystemEvent event;
+    if (!stat.exists) {
+      event = FileSystemDeleteEvent(file.path, false);
+    } else {
+      event = previous.exists
+          ? FileSystemModifyEvent(file.path, false, true)
+          : FileSystemCreateEvent(file.path, false);
+      // 服务器时钟偏差会让差值失真，只记录合理范围内的延迟
+      final delay = detectedAt.difference(
+        DateTime.fromMicrosecondsSinceEpoch(stat.modifiedNs ~/ 1000),
+      );
+      if (!delay.isNegative && delay < const Duration(hours: 1)) {
+        _lastDetectionDelay = delay;
+        appMetrics.pollDetectionDelaySeconds.observeDuration(delay);
+      }
+    }
+    for (final listener in [...file.listeners]) {
+      listener.add(event);
+    }
+  }
+
+  /// 批量 stat：原生库可用时在后台 isolate 中一次调用完成，否则逐个异步 stat
+  static Future<List<PolledFileStat?>> statFiles(List<String> paths) {
+    if (StatBindings.tryLoad() != null) {
+      return Isolate.run(() => statFilesSync(paths));
+    }
+    return Future.wait(paths.map(_statWithDart));
+  }
+
+  static List<PolledFileStat?> statFilesSync(List<String> paths) {
+    final bindings = StatBindings.tryLoad();
+    if (bindings == null) {
+      return [for (final path in paths) _fromFileStat(FileStat.statSync(path))];
+    }
+    return using((arena) {
+      final nativePaths = arena<Pointer<Utf8>>(max(1, paths.length));
+      for (var index = 0; index < paths.length; index++) {
+        nativePaths[index] = paths[index].toNativeUtf8(allocator: arena);
+      }
+      final stats = arena<VtFileStat>(max(1, paths.length));
+      final status = bindings.statBatch(nativePaths, paths.length, 0, stats);
+      if (status != vtOk) {
+        throw ArgumentError('vt_stat_batch failed ($status)');
+      }
+      return [
+        for (var index = 0; index < paths.length; index++)
+          _fromNative(stats[index]),
+      ];
+    });
+  }
+
+  /// 判断 [path] 所在的文件系统；无法判断时当作本地磁盘
+  static FilesystemKind filesystemKindOf(String path) {
+    final bindings = StatBindings.tryLoad();
+    if (bindings != null) {
+      final kind = using(
+        (arena) => bindings.filesystemKind(path.toNativeUtf8(allocator: arena)),
+      );
+      return switch (kind) {
+        vtFsNetwork => FilesystemKind.network,
+        vtFsFuse => FilesystemKind.fuse,
+        _ => FilesystemKind.local,
+      };
+    }
+    if (Platform.isLinux) {
+      try {
+        return kindFromMountTable(
+          p.absolute(path),
+          File('/proc/self/mounts').readAsStringSync(),
+        );
+      } on FileSystemException {
+        return FilesystemKind.local;
+      }
+    }
+    return FilesystemKind.local;
+  }
+
+  static const Set<String> _networkFilesystemTypes = {
+    'nfs',
+    'nfs4',
+    'cifs',
+    'smb3',
+    'smbfs',
+    'afs',
+    'coda',
+    '9p',
+    'ceph',
+    'gfs2',
+    'vboxsf',
+  };
+
+  /// 按 /proc/self/mounts 的格式找出 [path] 所在的挂载点（最长前缀）
+  static FilesystemKind kindFromMountTable(String path, String mounts) {
+    var bestLength = -1;
+    var bestType = '';
+    for (final line in mounts.split('\n')) {
+      final fields = line.split(' ');
+      if (fields.length < 3) {
+        continue;
+      }
+      // 挂载点中的空格等字符以八进制转义，如 \040
+      final mountPoint = fields[1].replaceAllMapped(
+        RegExp(r'\\([0-7]{3})'),
+        (match) => String.fromCharCode(int.parse(match[1]!, radix: 8)),
+      );
+      final matches =
+          mountPoint == '/' ||
+          path == mountPoint ||
+          path.startsWith('$mountPoint/');
+      if (matches && mountPoint.length > bestLength) {
+        bestLength = mountPoint.length;
+        bestType = fields[2];
+      }
+    }
+    if (bestType == 'fuse' || bestType.startsWith('fuse.')) {
+      return FilesystemKind.fuse;
+    }
+    return _networkFilesystemTypes.contains(bestType)
+        ? FilesystemKind.network
+        : FilesystemKind.local;
+  }
+
+  static Future<PolledFileStat> _statWithDart(String path) async {
+    return _fromFileStat(await FileStat.stat(path));
+  }
+
+  static PolledFileStat _fromFileStat(FileStat stat) {
+    if (stat.type == FileSystemEntityType.notFound) {
+      return PolledFileStat.missing;
+    }
+    return PolledFileStat(
+      exists: true,
+      size: stat.size,
+      modifiedNs: stat.modified.microsecondsSinceEpoch * 1000,
+      changedNs: stat.changed.microsecondsSinceEpoch * 1000,
+    );
+  }
+
+  static PolledFileStat? _fromNative(VtFileStat stat) {
+    if (stat.status == vtErrorNotFound) {
+      return PolledFileStat.missing;
+    }
+    if (stat.status != vtOk) {
+      return null;
+    }
+    return PolledFileStat(
+      exists: true,
+      size: stat.size,
+      modifiedNs: stat.modifiedNs,
+      changedNs: stat.changedNs,
+      fileId: stat.fileId,
+    );
+  }
+}
+
+class _PolledFile {
+  _PolledFile(this.path);
+
+  final String path;
+  final Set<StreamController<FileSystemEvent>> listeners = {};
+  PolledFileStat? stat;
+  Duration interval = Duration.zero;
+  DateTime nextDue = DateTime.now();
+}
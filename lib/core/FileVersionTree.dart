@@ -1,7 +1,13 @@
+import 'dart:async';
 import 'dart:io';
 import 'dart:math';
 import 'package:path/path.dart' as path;
+import 'package:vertree/component/AppMetrics.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileChecksum.dart';
 import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/VersionCopy.dart';
+import 'package:vertree/core/VersionKey.dart';
 
 void _logCoreError(String message) {
   stderr.writeln(message);
@@ -22,6 +28,9 @@ class _ParsedFileNameParts {
 class FileVersion implements Comparable<FileVersion> {
   final List<Segment> segments;
 
+  /// 紧凑键，按码元比较与 [compareTo] 顺序一致，见 [VersionKey]
+  late final String key = VersionKey.encode(segments);
+
   FileVersion._(this.segments);
 
   factory FileVersion(String versionString) {
@@ -85,18 +94,7 @@ class FileVersion implements Comparable<FileVersion> {
   }
 
   @override
-  int compareTo(FileVersion other) {
-    final minLen = segments.length < other.segments.length
-        ? segments.length
-        : other.segments.length;
-    for (int i = 0; i < minLen; i++) {
-      final diffBranch = segments[i].branch - other.segments[i].branch;
-      if (diffBranch != 0) return diffBranch;
-      final diffVer = segments[i].version - other.segments[i].version;
-      if (diffVer != 0) return diffVer;
-    }
-    return segments.length - other.segments.length;
-  }
+  int compareTo(FileVersion other) => key.compareTo(other.key);
 
   /// 判断是否与 [other] 在同一个分支
   bool isSameBranch(FileVersion other) {
@@ -211,7 +209,36 @@ class FileMeta {
     }
 
     final parsed = _parseFileNameParts(fileNameWithoutExt);
-    return parsed.name.isNotEmpty && !parsed.name.startsWith('.');
+    return parsed.name.isNotEmpty &&
+        !parsed.name.startsWith('.') &&
+        !VersionCopy.isPartPath(fullPath);
+  }
+
+  /// 去掉备注后的文件名，例如 "example#label.0.1.txt" 得到 "example.0.1.txt"
+  static String unlabeledNameOf(String fullPath) {
+    final fileName = path.basename(fullPath);
+    final extension = path.extension(fullPath);
+    final withoutExt = path.basenameWithoutExtension(fullPath);
+    final versionMatch = _versionSuffixPattern.firstMatch(withoutExt);
+    final basePart = versionMatch?.group(1) ?? withoutExt;
+    final hashIndex = basePart.indexOf('#');
+    if (hashIndex == -1) {
+      return fileName;
+    }
+    final versionSuffix = versionMatch == null
+        ? ''
+        : '.${versionMatch.group(2)}';
+    return '${basePart.substring(0, hashIndex)}$versionSuffix$extension';
+  }
+
+  /// 只从文件名解析版本号，不访问文件系统
+  static FileVersion versionOf(String fullPath) {
+    return _parseFileNameParts(path.basenameWithoutExtension(fullPath)).version;
+  }
+
+  /// 只从文件名解析主名称，不访问文件系统
+  static String nameOf(String fullPath) {
+    return _parseFileNameParts(path.basenameWithoutExtension(fullPath)).name;
   }
 
   static _ParsedFileNameParts _parseFileNameParts(String fileNameWithoutExt) {
@@ -322,7 +349,7 @@ class FileNode {
   late FileMeta mate;
   late File originalFile;
   FileNode? child;
-  late FileNode parent;
+  FileNode? _parent;
   final List<FileNode> branches = [];
   int branchIndex = -1;
   FileNode? firstBranch;
@@ -331,6 +358,13 @@ class FileNode {
 
   get version => mate.version;
 
+  /// 上一个版本节点；根节点没有父节点，访问前用 [parentOrNull] 判断
+  FileNode get parent => _parent!;
+
+  set parent(FileNode value) => _parent = value;
+
+  FileNode? get parentOrNull => _parent;
+
   // 分别存储偶数版本（topBranches）和奇数版本（bottomBranches）的分支
   final List<FileNode> topBranches = [];
   final List<FileNode> bottomBranches = [];
@@ -452,6 +486,34 @@ class FileNode {
     }
   }
 
+  /// 摘下直接的子版本或分支，与 [addChild]、[addBranch] 相对
+  bool removeNode(FileNode node) {
+    if (identical(child, node)) {
+      child = null;
+    } else if (branches.remove(node)) {
+      topBranches.remove(node);
+      bottomBranches.remove(node);
+      branchIndex = -1;
+      for (final branch in branches) {
+        branchIndex = max(
+          branchIndex,
+          branch.mate.version.segments.last.branch,
+        );
+      }
+    } else {
+      return false;
+    }
+    node._parent = null;
+    totalChildren -= 1;
+    return true;
+  }
+
+  static final StreamController<String> _createdVersions =
+      StreamController<String>.broadcast();
+
+  /// backup / branch 成功复制出的新版本文件路径，供搜索索引等服务增量更新
+  static Stream<String> get createdVersions => _createdVersions.stream;
+
   Future<Result<FileNode, String>> safeBackup([String? label]) async {
     final unsupportedMessage = _validateVersionableSource();
     if (unsupportedMessage != null) {
@@ -485,7 +547,7 @@ class FileNode {
           '${mate.name}${label != null ? "#$label" : ""}.${newVersion.toString()}.${mate.extension}';
       final dirPath = path.dirname(mate.fullPath);
       final newFilePath = path.join(dirPath, newFileName);
-      await originalFile.copy(newFilePath);
+      await _copyWithMetrics(newFilePath);
       final newNode = FileNode(newFilePath);
       addChild(newNode);
       return Result.ok(newNode);
@@ -506,7 +568,7 @@ class FileNode {
           '${mate.name}${label != null ? "#$label" : ""}.${branchedVersion.toString()}.${mate.extension}';
       final dirPath = path.dirname(mate.fullPath);
       final newFilePath = path.join(dirPath, newFileName);
-      await originalFile.copy(newFilePath);
+      await _copyWithMetrics(newFilePath);
       final newNode = FileNode(newFilePath);
       addBranch(newNode);
       return Result.ok(newNode);
@@ -515,6 +577,59 @@ class FileNode {
     }
   }
 
+  Future<File> _copyWithMetrics(String newFilePath) async {
+    final stopwatch = Stopwatch()..start();
+    try {
+      final sourceBefore = originalFile.statSync();
+      final checksum = await VersionCopy.copy(originalFile.path, newFilePath);
+      appMetrics.recordSnapshot(
+        kind: 'version',
+        elapsed: stopwatch.elapsed,
+        bytes: checksum.size,
+      );
+      _recordChecksums(newFilePath, checksum, sourceBefore);
+      _createdVersions.add(newFilePath);
+      return File(newFilePath);
+    } catch (_) {
+      appMetrics.recordSnapshot(
+        kind: 'version',
+        elapsed: stopwatch.elapsed,
+        bytes: null,
+      );
+      rethrow;
+    }
+  }
+
+  /// 复制时算出的校验和同时记下新版本与源文件；源文件在复制期间被改过时
+  /// 只记新版本。清单写入失败不影响备份本身。
+  void _recordChecksums(
+    String newFilePath,
+    FileChecksum checksum,
+    FileStat sourceBefore,
+  ) {
+    try {
+      final entries = [ChecksumEntry.ofFile(newFilePath, checksum)];
+      final sourceAfter = originalFile.statSync();
+      if (sourceAfter.modified == sourceBefore.modified &&
+          sourceAfter.size == checksum.size) {
+        entries.add(
+          ChecksumEntry(
+            name: path.basename(originalFile.path),
+            hash: checksum.hex,
+            size: checksum.size,
+            modifiedMicros: sourceAfter.modified.microsecondsSinceEpoch,
+          ),
+        );
+      }
+      ChecksumManifest.appendSync(
+        ChecksumManifest.familyManifestPath(newFilePath),
+        entries,
+      );
+    } catch (e) {
+      _logCoreError("写入校验清单失败: $e");
+    }
+  }
+
   bool _hasVersionConflict(FileVersion version) {
     final dir = Directory(path.dirname(mate.fullPath));
     if (!dir.existsSync()) {
@@ -522,7 +637,7 @@ class FileNode {
     }
 
     for (final entity in dir.listSync()) {
-      if (entity is! File) {
+      if (entity is! File || VersionCopy.isPartPath(entity.path)) {
         continue;
       }
 
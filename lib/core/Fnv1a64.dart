@@ -0,0 +1,45 @@
+import 'dart:convert';
+
+/// 64 位 FNV-1a 哈希，用于生成稳定的缓存键与 ETag。
+///
+/// Dart 原生 int 为 64 位，乘法按 2^64 回绕，正好符合算法要求；
+/// 结果只用于缓存判定，不具备抗碰撞的安全性。
+class Fnv1a64 {
+  static const int _offsetBasis = -3750763034362895579; // 0xcbf29ce484222325
+  static const int _prime = 0x100000001b3;
+
+  int _hash = _offsetBasis;
+
+  int get value => _hash;
+
+  void addBytes(List<int> bytes) {
+    var hash = _hash;
+    for (final byte in bytes) {
+      hash ^= byte & 0xff;
+      hash *= _prime;
+    }
+    _hash = hash;
+  }
+
+  /// 追加一个字段；字段之间用 UTF-8 中不会出现的 0xff 分隔
+  void addField(String value) {
+    addBytes(utf8.encode(value));
+    _hash ^= 0xff;
+    _hash *= _prime;
+  }
+
+  /// 16 位小写十六进制
+  String toHex() {
+    final high = (_hash >>> 32).toRadixString(16).padLeft(8, '0');
+    final low = (_hash & 0xffffffff).toRadixString(16).padLeft(8, '0');
+    return '$high$low';
+  }
+
+  static String hashFields(Iterable<String> fields) {
+    final hash = Fnv1a64();
+    for (final field in fields) {
+      hash.addField(field);
+    }
+    return hash.toHex();
+  }
+}
@@ -2,14 +2,20 @@ import 'dart:async';
 import 'dart:io';
 import 'package:vertree/component/Configer.dart';
 import 'package:vertree/core/Monitor.dart';
+import 'package:vertree/core/MonitorCatchUp.dart';
 import 'package:vertree/core/Result.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
 import 'package:path/path.dart' as p;
 
 class MonitManager {
   /// 由 MonitService 持有的任务列表
   List<FileMonitTask> monitFileTasks = [];
 
+  /// 快照刷新指纹后延迟合并保存，快照频繁时不反复重写配置文件
+  static const Duration fingerprintSaveDelay = Duration(seconds: 2);
+  Timer? _saveTimer;
+
   /// 返回正在运行的监控任务数量
   int get runningTaskCount {
     return monitFileTasks.where((task) => task.isRunning).length;
@@ -30,9 +36,80 @@ class MonitManager {
 
   /// 将当前任务列表保存到 configer
   Future<void> _saveMonitFiles() async {
+    _saveTimer?.cancel();
+    _saveTimer = null;
     configer.set("monitFiles", monitFileTasks.map((t) => t.toJson()).toList());
   }
 
+  void _scheduleSave() {
+    _saveTimer ??= Timer(fingerprintSaveDelay, _saveMonitFiles);
+  }
+
+  /// 检查运行中的任务在应用未运行期间是否被改动，为改动过的文件补快照。
+  ///
+  /// stat 与读取内容都在后台 isolate 中进行，应在界面显示之后调用。
+  Future<void> catchUp({MonitorCatchUp? scanner}) async {
+    final tasks = [
+      for (final task in monitFileTasks)
+        if (task.isRunning && task.monitor != null) task,
+    ];
+    if (tasks.isEmpty) {
+      return;
+    }
+    final stopwatch = Stopwatch()..start();
+    final results = await (scanner ?? MonitorCatchUp()).scan([
+      for (final task in tasks)
+        CatchUpTarget(
+          filePath: task.filePath,
+          backupDirPath: task.backupDirPath,
+          fingerprint: task.fingerprint,
+        ),
+    ]);
+
+    var changed = 0;
+    var hashed = 0;
+    var refreshed = false;
+    for (var i = 0; i < tasks.length; i++) {
+      final task = tasks[i];
+      final result = results[i];
+      if (result.hashed) hashed += 1;
+      if (result.fingerprint != null) {
+        task.fingerprint = result.fingerprint;
+        refreshed = true;
+      }
+      // 检查期间被暂停或移除的任务不再补快照
+      final monitor = task.monitor;
+      if (result.state == CatchUpState.changed && monitor != null) {
+        changed += 1;
+        unawaited(monitor.catchUp());
+      }
+    }
+    if (refreshed) {
+      _scheduleSave();
+    }
+    logger.info(
+      "Catch-up checked ${tasks.length} tasks in "
+      "${stopwatch.elapsedMilliseconds}ms: $changed changed, $hashed hashed",
+    );
+    activityEventHub.emit(ActivityEventType.monitorCatchUpFinished, {
+      'taskCount': tasks.length,
+      'changedCount': changed,
+      'hashedCount': hashed,
+      'durationMs': stopwatch.elapsedMilliseconds,
+    });
+  }
+
+  /// 配置为分片布局时，在后台逐个把运行中任务的平铺备份目录迁移过去，
+  /// 未运行的任务在下次启动监控后的首个快照前迁移
+  Future<void> migrateBackupLayouts() async {
+    for (final task in [...monitFileTasks]) {
+      final monitor = task.monitor;
+      if (task.isRunning && monitor != null) {
+        await monitor.prepareBackupLayout();
+      }
+    }
+  }
+
   /// 返回当前正在运行的监控数量
   int get runningMonitorCount {
     return monitFileTasks.where((t) => t.monitor != null).length;
@@ -48,7 +125,13 @@ class MonitManager {
   }
 
   /// 添加文件监视任务
-  Future<Result<FileMonitTask, String>> addFileMonitTask(String path) async {
+  ///
+  /// 批量添加时传 [persist] 为 false，全部添加后调用一次 [saveTasks]，避免
+  /// 每个任务都重写一遍配置文件
+  Future<Result<FileMonitTask, String>> addFileMonitTask(
+    String path, {
+    bool persist = true,
+  }) async {
     // 检查任务是否已存在
     if (monitFileTasks.any((task) => task.filePath == path)) {
       logger.info("Task already exists for: $path");
@@ -62,11 +145,16 @@ class MonitManager {
 
     // 加入列表并保存配置
     monitFileTasks.add(newTask);
-    await _saveMonitFiles();
+    if (persist) {
+      await _saveMonitFiles();
+    }
 
     return Result.ok(newTask);
   }
 
+  /// 保存当前任务列表
+  Future<void> saveTasks() => _saveMonitFiles();
+
   /// 移除文件监视任务
   Future<void> removeFileMonitTask(String path) async {
     final index = monitFileTasks.indexWhere((t) => t.filePath == path);
@@ -123,18 +211,33 @@ class MonitManager {
       );
     }
 
-    task.monitor ??= Monitor.fromTask(task);
+    task.monitor ??= Monitor.fromTask(task)
+      ..onFingerprint = (fingerprint) {
+        task.fingerprint = fingerprint;
+        _scheduleSave();
+      };
     task.monitor?.start();
     task.isRunning = true;
+    activityEventHub.emit(ActivityEventType.monitorStarted, {
+      'filePath': task.filePath,
+      'backupDirPath': task.backupDirPath,
+    });
 
     return Result.ok(task);
   }
 
   /// 停止监视
   Result<FileMonitTask, String> _pauseMonitor(FileMonitTask task) {
+    final wasAttached = task.monitor != null;
     task.monitor?.stop();
     task.monitor = null;
     task.isRunning = false;
+    if (wasAttached) {
+      activityEventHub.emit(ActivityEventType.monitorStopped, {
+        'filePath': task.filePath,
+        'backupDirPath': task.backupDirPath,
+      });
+    }
 
     return Result.ok(task);
   }
@@ -145,6 +248,9 @@ class FileMonitTask {
   String? backupDirPath;
   bool isRunning; // 是否正在运行
   bool fileExists; // 文件是否存在的标记
+
+  /// 最近一次快照时源文件的指纹，用于启动时检查应用未运行期间的改动
+  FileFingerprint? fingerprint;
   late File file;
   Monitor? monitor;
 
@@ -170,6 +276,7 @@ class FileMonitTask {
     "backupDirPath": backupDirPath,
     "isRunning": isRunning,
     "fileExists": fileExists,
+    if (fingerprint != null) "fingerprint": fingerprint!.toJson(),
   };
 
   // 从 Map（JSON 反序列化）创建对象
@@ -179,6 +286,7 @@ class FileMonitTask {
       isRunning: json["isRunning"] ?? false,
     );
     task.fileExists = File(task.filePath).existsSync();
+    task.fingerprint = FileFingerprint.fromJson(json["fingerprint"]);
 
     if (!task.fileExists) {
       task.isRunning = false;
@@ -1,8 +1,16 @@
 import 'dart:async';
 import 'dart:io';
+import 'dart:isolate';
 import 'package:path/path.dart' as p;
+import 'package:vertree/component/AppMetrics.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/ColdPack.dart';
+import 'package:vertree/core/FilePoller.dart';
 import 'package:vertree/core/MonitManager.dart';
+import 'package:vertree/core/MonitorCatchUp.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
 
 class Monitor {
   late String filePath;
@@ -13,12 +21,19 @@ class Monitor {
   DateTime? _startedAt;
   DateTime? _lastObservedEventAt;
   DateTime? _lastBackupTime;
+  DateTime? _firstUnsavedEventAt;
   String? _lastObservedEventPath;
   String? _lastBackupPath;
   String? _lastError;
   int _observedEventCount = 0;
   int _createdBackupCount = 0;
+  String _watchMode = 'events';
   StreamSubscription<FileSystemEvent>? _subscription;
+  Future<bool>? _sharding;
+
+  /// 每次快照成功后收到源文件当时的指纹，由 [MonitManager] 保存到任务配置，
+  /// 下次启动时据此找出应用未运行期间的改动
+  void Function(FileFingerprint fingerprint)? onFingerprint;
 
   DateTime? get startedAt => _startedAt;
   DateTime? get lastObservedEventAt => _lastObservedEventAt;
@@ -30,6 +45,9 @@ class Monitor {
   int get createdBackupCount => _createdBackupCount;
   bool get isHandlingFileChange => _isHandlingFileChange;
 
+  /// `events` 使用系统的文件变化通知，`polling` 由 [filePoller] 轮询
+  String get watchMode => _watchMode;
+
   Monitor(this.filePath) {
     file = File(filePath);
     if (!file.existsSync()) {
@@ -71,76 +89,345 @@ class Monitor {
 
   void start() {
     _startedAt = DateTime.now();
-    _subscription = file.parent.watch(events: FileSystemEvent.all).listen((event) {
+    _watchMode = _resolveWatchMode();
+    final events = _watchMode == 'polling'
+        ? filePoller.watch(file.absolute.path)
+        : file.parent.watch(events: FileSystemEvent.all);
+    _subscription = events.listen((event) {
       print("事件触发: ${event.type} -> ${event.path}");
       if (event.path == file.absolute.path) {
         _observedEventCount += 1;
         _lastObservedEventAt = DateTime.now();
         _lastObservedEventPath = event.path;
+        _firstUnsavedEventAt ??= _lastObservedEventAt;
+        appMetrics.monitorEventsTotal.inc();
+        activityEventHub.emit(ActivityEventType.fileEventObserved, {
+          'filePath': filePath,
+          'eventPath': event.path,
+          'eventType': _describeEventType(event.type),
+          'observedEventCount': _observedEventCount,
+        });
         _handleFileChange(file, backupDir);
       }
     });
 
-    logger.info("Started monitoring: $filePath");
+    logger.info("Started monitoring: $filePath ($_watchMode)");
+  }
+
+  /// 配置项 monitorWatchMode 为 auto（默认）时，网络盘和 FUSE 上的文件改用轮询：
+  /// 其他机器写入的内容不会产生文件变化通知
+  String _resolveWatchMode() {
+    final configured = configer.get<String>("monitorWatchMode", "auto");
+    if (configured == 'events' || configured == 'polling') {
+      return configured;
+    }
+    final kind = FilePoller.filesystemKindOf(filePath);
+    return kind == FilesystemKind.local ? 'events' : 'polling';
   }
   bool _isHandlingFileChange = false; // 添加一个布尔标志
 
-  void _handleFileChange(File file, Directory backupDir) {
+  /// 处理期间（复制大文件可能很久）又收到变化，处理完要再检查一次文件，
+  /// 否则最后一次改动可能永远没有快照
+  bool _changedWhileBusy = false;
+
+  /// 最近一次快照复制前的源文件状态
+  PolledFileStat? _lastSnapshotStat;
+
+  /// 启动检查发现文件在应用未运行期间被改动，补一个快照
+  Future<void> catchUp() {
+    logger.info("catch-up snapshot $filePath");
+    return _handleFileChange(file, backupDir);
+  }
+
+  Future<void> _handleFileChange(File file, Directory backupDir) async {
     if (_isHandlingFileChange) {
-      logger.info("handleFileChange 调用被拒绝，因为之前的调用仍在运行");
+      logger.info("handleFileChange 推迟：之前的调用仍在运行，结束后重新检查");
+      _changedWhileBusy = true;
       return;
     }
     _isHandlingFileChange = true;
 
     try {
-      final now = DateTime.now();
-      logger.info("handleFileChange ${file.path}");
-      if (_lastBackupTime == null ||
-          now.difference(_lastBackupTime!).inMinutes >=
-              configer.get("monitorRate", 5)) {
-        logger.info("backupFile ${file.path}");
-
-        _backupFile(file, backupDir);
-        _lastBackupTime = now;
-        _cleanupOldBackups(backupDir);
-      } else {
-        logger.info("_lastBackupTime ${_lastBackupTime?.toIso8601String()}");
-      }
+      do {
+        _changedWhileBusy = false;
+        await _handleFileChangeOnce(file, backupDir);
+      } while (_changedWhileBusy && _changedSinceLastSnapshot(file));
     } finally {
       _isHandlingFileChange = false; // 确保在任何情况下都重置标志
+      _changedWhileBusy = false;
     }
   }
 
-  void _cleanupOldBackups(Directory backupDir) {
+  Future<void> _handleFileChangeOnce(File file, Directory backupDir) async {
+    final now = DateTime.now();
+    logger.info("handleFileChange ${file.path}");
+    final monitorRate = configer.get("monitorRate", 5);
+    if (_lastBackupTime == null ||
+        now.difference(_lastBackupTime!).inMinutes >= monitorRate) {
+      logger.info("backupFile ${file.path}");
+
+      await _backupFile(file, backupDir);
+      _lastBackupTime = now;
+      // 冷存储打包进行中时清理要排队，不必因此拖住下一个快照
+      unawaited(_cleanupOldBackups(backupDir));
+    } else {
+      logger.info("_lastBackupTime ${_lastBackupTime?.toIso8601String()}");
+      appMetrics.monitorSnapshotsSkippedTotal.inc(const ['rateLimited']);
+      activityEventHub.emit(ActivityEventType.snapshotSkipped, {
+        'filePath': filePath,
+        'reason': 'rateLimited',
+        'lastBackupAt': _lastBackupTime?.toIso8601String(),
+        'nextEligibleAt': _lastBackupTime
+            ?.add(Duration(minutes: monitorRate))
+            .toIso8601String(),
+      });
+    }
+  }
+
+  /// 只触发了元数据事件、内容没变时不重复快照；读不到状态时按变化处理
+  bool _changedSinceLastSnapshot(File file) {
+    final last = _lastSnapshotStat;
+    final current = _statForFingerprint(file.path);
+    return last == null || current == null || !current.sameAs(last);
+  }
+
+  Future<void> _cleanupOldBackups(Directory backupDir) async {
     final maxBackups = configer.get("monitorMaxSize", 50);
-    final files = backupDir.listSync().whereType<File>().toList();
-    if (files.length > maxBackups) {
-      files.sort((a, b) => a.lastModifiedSync().compareTo(b.lastModifiedSync()));
-      final filesToDelete = files.take(files.length - maxBackups);
-      for (final fileToDelete in filesToDelete) {
-        try {
-          fileToDelete.deleteSync();
-          logger.info("Deleted old backup: ${fileToDelete.path}");
-        } catch (e) {
-          logger.error("Error deleting old backup: $e");
-        }
+    final List<String> deletedPaths;
+    try {
+      deletedPaths = await ColdPack.runLocked(
+        backupDir.path,
+        () => pruneOldBackups(backupDir.path, maxBackups),
+      );
+    } catch (e) {
+      logger.error("Error pruning old backups: $e");
+      return;
+    }
+    if (deletedPaths.isNotEmpty) {
+      appMetrics.retentionPrunedTotal.inc(const [], deletedPaths.length);
+      activityEventHub.emit(ActivityEventType.retentionPruned, {
+        'filePath': filePath,
+        'backupDirPath': backupDir.path,
+        'maxBackups': maxBackups,
+        'deletedCount': deletedPaths.length,
+        'deletedPaths': deletedPaths,
+      });
+    }
+  }
+
+  /// 只保留 [backupDirPath] 中最新的 [maxBackups] 个快照，删除其余的并从
+  /// 快照索引和校验清单中移除，返回已删除的路径。已移入冷存储的快照一并
+  /// 计数，清理时从冷存储索引中去掉（见 [ColdPack.recordRemovalsSync]），
+  /// 返回的是它们原来的路径。分片布局的快照顺序来自索引，不列目录。与冷存储
+  /// 打包同时运行时要经 [ColdPack.runLocked]。
+  static List<String> pruneOldBackups(String backupDirPath, int maxBackups) {
+    final loose = SnapshotIndex.snapshotsSync(backupDirPath);
+    final cold = ColdPack.loadSync(backupDirPath);
+    final looseNames = {for (final snapshot in loose) snapshot.name};
+    final snapshots = [
+      ...loose,
+      // 打包后散文件没删掉的快照只算一次
+      for (final entry in cold.entries.values)
+        if (!looseNames.contains(entry.name)) entry.toRecord(),
+    ];
+    if (snapshots.length <= maxBackups) {
+      return const [];
+    }
+    snapshots.sort((a, b) {
+      final byTime = a.createdMicros.compareTo(b.createdMicros);
+      return byTime != 0 ? byTime : a.name.compareTo(b.name);
+    });
+    final removedNames = <String>[];
+    final packedNames = <String>[];
+    final deletedPaths = <String>[];
+    for (final snapshot in snapshots.take(snapshots.length - maxBackups)) {
+      final snapshotPath = snapshot.pathIn(backupDirPath);
+      final packed = cold.entries.containsKey(snapshot.name);
+      if (!looseNames.contains(snapshot.name)) {
+        packedNames.add(snapshot.name);
+        deletedPaths.add(snapshotPath);
+        logger.info("Deleted old packed backup: $snapshotPath");
+        continue;
+      }
+      try {
+        File(snapshotPath).deleteSync();
+        removedNames.add(snapshot.name);
+        deletedPaths.add(snapshotPath);
+        logger.info("Deleted old backup: $snapshotPath");
+      } on PathNotFoundException {
+        // 已被手动删除，只需清掉记录
+        removedNames.add(snapshot.name);
+      } catch (e) {
+        logger.error("Error deleting old backup: $e");
+        continue;
+      }
+      if (packed) {
+        packedNames.add(snapshot.name);
       }
     }
+    try {
+      SnapshotIndex.recordRemovalsSync(backupDirPath, removedNames);
+    } catch (e) {
+      logger.error("Error updating snapshot index: $e");
+    }
+    try {
+      ColdPack.recordRemovalsSync(backupDirPath, packedNames);
+    } catch (e) {
+      logger.error("Error updating cold pack index: $e");
+    }
+    return deletedPaths;
+  }
+
+  /// 配置项 monitorBackupLayout 为 sharded 时，把平铺的备份目录原地迁移为
+  /// 分片布局，每个目录只迁移一次；已是分片布局的目录保持不变。中断过的
+  /// 迁移不论配置如何都先做完。返回目录是否为分片布局。
+  Future<bool> prepareBackupLayout() {
+    if (SnapshotIndex.isShardedSync(backupDirPath)) {
+      return Future.value(true);
+    }
+    final layout = BackupLayout.parse(
+      configer.get<String>("monitorBackupLayout", "flat"),
+    );
+    if (layout != BackupLayout.sharded &&
+        !SnapshotIndex.isMigrationIncompleteSync(backupDirPath)) {
+      return Future.value(false);
+    }
+    return _sharding ??= _migrateToShards();
+  }
+
+  Future<bool> _migrateToShards() async {
+    final dirPath = backupDirPath;
+    try {
+      final migration = await Isolate.run(
+        () => SnapshotIndex.migrateSync(dirPath),
+      );
+      logger.info(
+        "Migrated $dirPath to sharded layout: "
+        "${migration.movedCount}/${migration.snapshotCount} snapshots moved",
+      );
+      return true;
+    } catch (e) {
+      logger.error("Error migrating backup layout of $dirPath: $e");
+      _sharding = null;
+      return false;
+    }
   }
 
-  void _backupFile(File file, Directory backupDir) {
+  /// 复制经 [snapshotCopyQueue] 与其他任务同时变化的快照合批进行，不阻塞界面
+  Future<void> _backupFile(File file, Directory backupDir) async {
+    final stopwatch = Stopwatch()..start();
     try {
-      final timestamp = DateTime.now().toIso8601String().replaceAll(':', '-');
-      final backupPath = p.join(backupDir.path, '${p.basename(file.path)}_$timestamp.bak${p.extension(file.path)}');
+      final sharded = await prepareBackupLayout();
+      final createdAt = DateTime.now();
+      final timestamp = createdAt.toIso8601String().replaceAll(':', '-');
+      final snapshotName =
+          '${p.basename(file.path)}_$timestamp.bak${p.extension(file.path)}';
+      final name = sharded
+          ? SnapshotIndex.shardNameFor(snapshotName, createdAt)
+          : snapshotName;
+      final backupPath = p.joinAll([backupDir.path, ...name.split('/')]);
+      if (sharded) {
+        Directory(p.dirname(backupPath)).createSync(recursive: true);
+      }
       logger.info("Backup to: $backupPath");
-      file.copySync(backupPath);
+      activityEventHub.emit(ActivityEventType.snapshotStarted, {
+        'filePath': filePath,
+        'backupPath': backupPath,
+      });
+      // 复制前记下源文件状态：复制期间又被改动时，指纹对不上内容，下次启动
+      // 会再补一个快照，而不是漏掉
+      final sourceStat = _statForFingerprint(file.path);
+      _lastSnapshotStat = sourceStat;
+      final checksum = await snapshotCopyQueue.copy(file.path, backupPath);
+      final backupSize = checksum.size;
+      if (sourceStat != null && sourceStat.exists) {
+        onFingerprint?.call(
+          FileFingerprint.fromStat(sourceStat, hash: checksum.hex),
+        );
+      }
+      try {
+        ChecksumManifest.appendSync(
+          ChecksumManifest.backupManifestPath(backupDir.path),
+          [ChecksumEntry.ofFile(backupPath, checksum, name: name)],
+        );
+      } catch (e) {
+        logger.error("Error updating checksum manifest: $e");
+      }
+      if (sharded) {
+        try {
+          SnapshotIndex.appendSync(backupDir.path, [
+            SnapshotRecord(
+              name: name,
+              createdMicros: createdAt.microsecondsSinceEpoch,
+              size: backupSize,
+              hash: checksum.hex,
+            ),
+          ]);
+        } catch (e) {
+          logger.error("Error updating snapshot index: $e");
+        }
+      }
+      appMetrics.recordSnapshot(
+        kind: 'monitor',
+        elapsed: stopwatch.elapsed,
+        bytes: backupSize,
+      );
+      final firstUnsavedEventAt = _firstUnsavedEventAt;
+      if (firstUnsavedEventAt != null) {
+        appMetrics.monitorEventToSnapshotSeconds.observeDuration(
+          DateTime.now().difference(firstUnsavedEventAt),
+        );
+        _firstUnsavedEventAt = null;
+      }
       _lastBackupPath = backupPath;
       _createdBackupCount += 1;
       _lastError = null;
       logger.info("Backup created: $backupPath");
+      activityEventHub.emit(ActivityEventType.snapshotFinished, {
+        'filePath': filePath,
+        'backupPath': backupPath,
+        'success': true,
+        'size': backupSize,
+        'durationMs': stopwatch.elapsedMilliseconds,
+        'createdBackupCount': _createdBackupCount,
+      });
     } catch (e) {
       _lastError = e.toString();
       logger.error("Error creating backup: $e");
+      appMetrics.recordSnapshot(
+        kind: 'monitor',
+        elapsed: stopwatch.elapsed,
+        bytes: null,
+      );
+      activityEventHub.emit(ActivityEventType.snapshotFinished, {
+        'filePath': filePath,
+        'success': false,
+        'error': _lastError,
+        'durationMs': stopwatch.elapsedMilliseconds,
+      });
+    }
+  }
+
+  static PolledFileStat? _statForFingerprint(String path) {
+    try {
+      return FilePoller.statFilesSync([path]).single;
+    } catch (_) {
+      return null;
+    }
+  }
+
+  static String _describeEventType(int type) {
+    switch (type) {
+      case FileSystemEvent.create:
+        return 'create';
+      case FileSystemEvent.modify:
+        return 'modify';
+      case FileSystemEvent.delete:
+        return 'delete';
+      case FileSystemEvent.move:
+        return 'move';
+      default:
+        return 'unknown';
     }
   }
 
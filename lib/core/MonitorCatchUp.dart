@@ -0,0 +1,279 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
+
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FilePoller.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+
+/// 监控文件上一次快照时的状态，随任务保存在配置里
+class FileFingerprint {
+  const FileFingerprint({
+    required this.size,
+    required this.modifiedNs,
+    required this.fileId,
+    this.hash,
+  });
+
+  factory FileFingerprint.fromStat(PolledFileStat stat, {String? hash}) {
+    return FileFingerprint(
+      size: stat.size,
+      modifiedNs: stat.modifiedNs,
+      fileId: stat.fileId,
+      hash: hash,
+    );
+  }
+
+  final int size;
+  final int modifiedNs;
+
+  /// inode；原生库不可用时为 0
+  final int fileId;
+
+  /// 快照内容的 16 位十六进制 XXH64，没有计算过时为 null
+  final String? hash;
+
+  Map<String, dynamic> toJson() => {
+    'size': size,
+    'modifiedNs': modifiedNs,
+    'fileId': fileId,
+    if (hash != null) 'hash': hash,
+  };
+
+  static FileFingerprint? fromJson(Object? json) {
+    if (json is! Map) {
+      return null;
+    }
+    final size = json['size'];
+    final modifiedNs = json['modifiedNs'];
+    final fileId = json['fileId'];
+    final hash = json['hash'];
+    if (size is! int || modifiedNs is! int || fileId is! int) {
+      return null;
+    }
+    return FileFingerprint(
+      size: size,
+      modifiedNs: modifiedNs,
+      fileId: fileId,
+      hash: hash is String ? hash : null,
+    );
+  }
+}
+
+/// 一个需要检查的监控任务
+class CatchUpTarget {
+  const CatchUpTarget({
+    required this.filePath,
+    this.backupDirPath,
+    this.fingerprint,
+  });
+
+  final String filePath;
+  final String? backupDirPath;
+  final FileFingerprint? fingerprint;
+}
+
+enum CatchUpState {
+  /// 与上次快照相同
+  unchanged,
+
+  /// 应用未运行期间改动过，需要补一个快照
+  changed,
+
+  /// 文件已不存在
+  missing,
+
+  /// 没能读到状态（权限、网络盘断开），这次不处理
+  unreadable,
+}
+
+class CatchUpResult {
+  const CatchUpResult({
+    required this.target,
+    required this.state,
+    this.fingerprint,
+    this.hashed = false,
+  });
+
+  final CatchUpTarget target;
+  final CatchUpState state;
+
+  /// 未变化时刷新后的指纹（修改时间或 inode 变了但内容相同，或旧任务第一次
+  /// 记录），应当保存；其余情况为 null
+  final FileFingerprint? fingerprint;
+
+  /// 是否读了文件内容
+  final bool hashed;
+}
+
+typedef FileHashFunction = Future<String> Function(String filePath);
+
+/// 启动时找出应用未运行（或关机）期间被改动的监控文件。
+///
+/// - 全部任务按 [statBatchSize] 分批做批量 stat（后台 isolate），最多
+///   [statConcurrency] 批同时进行；
+/// - 大小、修改时间、inode 都与指纹相同即视为未变化，大小不同即视为已变化；
+/// - 大小相同而修改时间或 inode 不同（复制、同步工具改写、保存时替换文件）时
+///   才读内容计算 XXH64 与指纹比较，最多 [hashConcurrency] 个同时读取，并降低
+///   I/O 优先级；
+/// - 还没有指纹的旧任务与备份目录中最新快照的时间比较，文件更新则视为已
+///   变化。
+class MonitorCatchUp {
+  MonitorCatchUp({
+    StatBatchFunction? statBatch,
+    FileHashFunction? hashFile,
+    this.statBatchSize = 512,
+    this.statConcurrency = 4,
+    this.hashConcurrency = 2,
+  }) : _statBatch = statBatch ?? FilePoller.statFiles,
+       _hashFile = hashFile ?? _hashWithChecksum;
+
+  final StatBatchFunction _statBatch;
+  final FileHashFunction _hashFile;
+  final int statBatchSize;
+  final int statConcurrency;
+  final int hashConcurrency;
+
+  Future<List<CatchUpResult>> scan(List<CatchUpTarget> targets) async {
+    final stats = await _statAll([
+      for (final target in targets) target.filePath,
+    ]);
+    final results = List<CatchUpResult?>.filled(targets.length, null);
+    final ambiguous = <int>[];
+    final legacy = <int>[];
+
+    for (var i = 0; i < targets.length; i++) {
+      final target = targets[i];
+      final stat = stats[i];
+      if (stat == null) {
+        results[i] = CatchUpResult(
+          target: target,
+          state: CatchUpState.unreadable,
+        );
+        continue;
+      }
+      if (!stat.exists) {
+        results[i] = CatchUpResult(target: target, state: CatchUpState.missing);
+        continue;
+      }
+      final saved = target.fingerprint;
+      if (saved == null) {
+        legacy.add(i);
+      } else if (saved.size != stat.size) {
+        results[i] = CatchUpResult(target: target, state: CatchUpState.changed);
+      } else if (saved.modifiedNs == stat.modifiedNs &&
+          saved.fileId == stat.fileId) {
+        results[i] = CatchUpResult(
+          target: target,
+          state: CatchUpState.unchanged,
+        );
+      } else if (saved.hash == null) {
+        results[i] = CatchUpResult(target: target, state: CatchUpState.changed);
+      } else {
+        ambiguous.add(i);
+      }
+    }
+
+    if (legacy.isNotEmpty) {
+      final backupDirs = [for (final i in legacy) targets[i].backupDirPath];
+      final newest = await Isolate.run(
+        () => newestSnapshotsSync(backupDirs),
+      );
+      for (var k = 0; k < legacy.length; k++) {
+        final i = legacy[k];
+        final stat = stats[i]!;
+        final snapshotMicros = newest[k];
+        // 没有快照的任务无从比较，只记下当前状态作为以后的基准；Dart 读到的
+        // 快照时间只到微秒，按微秒比较
+        final changed =
+            snapshotMicros != null && stat.modifiedNs ~/ 1000 > snapshotMicros;
+        results[i] = CatchUpResult(
+          target: targets[i],
+          state: changed ? CatchUpState.changed : CatchUpState.unchanged,
+          fingerprint: changed ? null : FileFingerprint.fromStat(stat),
+        );
+      }
+    }
+
+    var next = 0;
+    Future<void> hasher() async {
+      while (next < ambiguous.length) {
+        final i = ambiguous[next++];
+        final target = targets[i];
+        final stat = stats[i]!;
+        try {
+          final hash = await _hashFile(target.filePath);
+          final same = hash == target.fingerprint!.hash;
+          results[i] = CatchUpResult(
+            target: target,
+            state: same ? CatchUpState.unchanged : CatchUpState.changed,
+            fingerprint: same
+                ? FileFingerprint.fromStat(stat, hash: hash)
+                : null,
+            hashed: true,
+          );
+        } catch (_) {
+          results[i] = CatchUpResult(
+            target: target,
+            state: CatchUpState.unreadable,
+          );
+        }
+      }
+    }
+
+    await Future.wait([
+      for (var i = 0; i < min(max(1, hashConcurrency), ambiguous.length); i++)
+        hasher(),
+    ]);
+    return results.cast<CatchUpResult>();
+  }
+
+  Future<List<PolledFileStat?>> _statAll(List<String> paths) async {
+    final stats = List<PolledFileStat?>.filled(paths.length, null);
+    final batchSize = max(1, statBatchSize);
+    final batchCount = (paths.length + batchSize - 1) ~/ batchSize;
+    var next = 0;
+    Future<void> worker() async {
+      while (next < batchCount) {
+        final start = next++ * batchSize;
+        final end = min(start + batchSize, paths.length);
+        try {
+          final batch = await _statBatch(paths.sublist(start, end));
+          stats.setRange(start, end, batch);
+        } catch (_) {
+          // 整批失败的任务留作 null，按读不到状态处理
+        }
+      }
+    }
+
+    await Future.wait([
+      for (var i = 0; i < min(max(1, statConcurrency), batchCount); i++)
+        worker(),
+    ]);
+    return stats;
+  }
+
+  /// 每个备份目录中最新快照的时间（微秒），目录不存在或没有快照时为 null
+  static List<int?> newestSnapshotsSync(List<String?> backupDirPaths) {
+    return [
+      for (final dirPath in backupDirPaths) _newestSnapshotMicros(dirPath),
+    ];
+  }
+
+  static int? _newestSnapshotMicros(String? dirPath) {
+    if (dirPath == null) {
+      return null;
+    }
+    try {
+      return SnapshotIndex.latestSync(dirPath)?.createdMicros;
+    } on FileSystemException {
+      return null;
+    }
+  }
+
+  static Future<String> _hashWithChecksum(String filePath) async {
+    final checksum = await FileChecksum.ofFile(filePath, lowPriority: true);
+    return checksum.hex;
+  }
+}
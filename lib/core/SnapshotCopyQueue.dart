@@ -0,0 +1,88 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:vertree/component/AppMetrics.dart';
+import 'package:vertree/core/FileChecksum.dart';
+
+/// 与 [pairs] 一一对应；null 表示这一项复制失败
+typedef CopyBatchFunction =
+    Future<List<FileChecksum?>> Function(List<(String, String)> pairs);
+
+/// 把同时到来的监控快照合成批量复制，交给 [FileChecksum.copyAll]。
+///
+/// git checkout、同步客户端整目录落盘时，几百个监控文件几乎同时变化，逐个复制
+/// 会让磁盘在每个小文件的打开、校验、关闭之间空等，还阻塞界面所在的 isolate。
+/// 队列空闲时，请求在当前事件处理完后立即成批开始，不为凑批等待；复制进行中
+/// 到来的请求先排队，当前一批完成后一起作为下一批提交。突发越大批越大，每批
+/// 最多 [maxBatch] 个。
+class SnapshotCopyQueue {
+  SnapshotCopyQueue({this.maxBatch = 256, CopyBatchFunction? copyBatch})
+    : _copyBatch = copyBatch ?? FileChecksum.copyAll;
+
+  final int maxBatch;
+  final CopyBatchFunction _copyBatch;
+
+  final List<_PendingCopy> _pending = [];
+  bool _draining = false;
+
+  /// 排队等待、还没开始复制的请求数
+  int get pendingCount => _pending.length;
+
+  /// 与 [FileChecksum.copy] 相同：复制并返回校验和，失败时抛出
+  /// [FileSystemException]，不留下写了一半的目标文件
+  Future<FileChecksum> copy(String sourcePath, String targetPath) {
+    final request = _PendingCopy(sourcePath, targetPath);
+    _pending.add(request);
+    if (!_draining) {
+      _draining = true;
+      scheduleMicrotask(_drain);
+    }
+    return request.completer.future;
+  }
+
+  Future<void> _drain() async {
+    try {
+      while (_pending.isNotEmpty) {
+        final batch = _pending.take(maxBatch).toList();
+        _pending.removeRange(0, batch.length);
+        await _run(batch);
+      }
+    } finally {
+      _draining = false;
+    }
+  }
+
+  Future<void> _run(List<_PendingCopy> batch) async {
+    appMetrics.snapshotCopyBatchFiles.observe(batch.length);
+    final List<FileChecksum?> results;
+    try {
+      results = await _copyBatch([
+        for (final request in batch) (request.sourcePath, request.targetPath),
+      ]);
+    } catch (e, stackTrace) {
+      for (final request in batch) {
+        request.completer.completeError(e, stackTrace);
+      }
+      return;
+    }
+    for (var i = 0; i < batch.length; i++) {
+      final request = batch[i];
+      final checksum = i < results.length ? results[i] : null;
+      if (checksum == null) {
+        request.completer.completeError(
+          FileSystemException('复制文件失败', request.sourcePath),
+        );
+      } else {
+        request.completer.complete(checksum);
+      }
+    }
+  }
+}
+
+class _PendingCopy {
+  _PendingCopy(this.sourcePath, this.targetPath);
+
+  final String sourcePath;
+  final String targetPath;
+  final Completer<FileChecksum> completer = Completer();
+}
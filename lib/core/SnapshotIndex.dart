@@ -0,0 +1,500 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/ColdPack.dart';
+
+/// 监控备份目录的布局
+enum BackupLayout {
+  /// 全部快照平铺在 `_bak` 目录下
+  flat,
+
+  /// 快照按日期放在 `yyyy/mm/dd` 子目录中，由 [SnapshotIndex] 记录
+  sharded;
+
+  static BackupLayout parse(String? raw) {
+    return raw?.trim().toLowerCase() == 'sharded' ? sharded : flat;
+  }
+}
+
+/// 备份目录中的一个快照
+class SnapshotRecord {
+  const SnapshotRecord({
+    required this.name,
+    required this.createdMicros,
+    required this.size,
+    this.hash,
+  });
+
+  /// 相对备份目录的路径，分隔符固定为 `/`；平铺布局下就是文件名
+  final String name;
+
+  /// 快照时间；平铺布局取文件修改时间
+  final int createdMicros;
+  final int size;
+
+  /// 16 位十六进制 XXH64，不知道时为 null
+  final String? hash;
+
+  DateTime get createdAt => DateTime.fromMicrosecondsSinceEpoch(createdMicros);
+
+  String pathIn(String backupDirPath) {
+    return p.joinAll([backupDirPath, ...name.split('/')]);
+  }
+
+  Map<String, dynamic> toJson() => {
+    'name': name,
+    'createdAt': createdAt.toIso8601String(),
+    'size': size,
+    'hash': hash,
+  };
+}
+
+/// 一次从平铺到分片布局的迁移
+class SnapshotMigration {
+  const SnapshotMigration({
+    required this.snapshotCount,
+    required this.movedCount,
+  });
+
+  final int snapshotCount;
+  final int movedCount;
+}
+
+/// 分片备份目录的快照索引，是备份目录下的隐藏文本文件：
+///
+/// ```
+/// # vertree-index v1
+/// <createdMicros> <size> <hash|-> <name>
+/// - <name>
+/// ```
+///
+/// 与校验清单一样只追加不重写：每个快照追加一行，清理时追加 `-` 行，同名
+/// 的后一行覆盖前一行，[compactSync] 去掉过时的行。最新快照、时间范围和
+/// 保留策略都从索引得到，不必列出成千上万个文件。
+///
+/// 目录中存在索引、且没有未完成的迁移即视为分片布局；没有索引的目录按平铺
+/// 布局读取，[snapshotsSync] 对两种布局给出相同的结果。迁移开始前先写入标记
+/// 文件，索引写完后才删除；标记还在，或没有索引却已有日期子目录，说明迁移
+/// 中断过（见 [isMigrationIncompleteSync]），这时两种布局的快照都要列出。
+class SnapshotIndex {
+  SnapshotIndex._(this.backupDirPath, this.records, this.lineCount);
+
+  static const String header = '# vertree-index v1';
+  static const String fileName = '.vertree.index';
+  static const String migrationMarkerName = '.vertree.migrating';
+
+  static final RegExp _yearShardPattern = RegExp(r'^\d{4}$');
+
+  final String backupDirPath;
+  final Map<String, SnapshotRecord> records;
+
+  /// 文件中的记录行数（含被覆盖的行）
+  final int lineCount;
+
+  /// 被覆盖或已删除的行较多，值得重写
+  bool get needsCompaction => lineCount > records.length * 2 + 16;
+
+  /// 按快照时间从旧到新
+  List<SnapshotRecord> get sorted => _sortByTime(records.values.toList());
+
+  static String indexPath(String backupDirPath) {
+    return p.join(backupDirPath, fileName);
+  }
+
+  static String migrationMarkerPath(String backupDirPath) {
+    return p.join(backupDirPath, migrationMarkerName);
+  }
+
+  static bool isIndexPath(String filePath) {
+    final name = p.basename(filePath);
+    return name == fileName ||
+        name == '$fileName.tmp' ||
+        name == migrationMarkerName;
+  }
+
+  /// 备份目录中的校验清单、快照索引、迁移标记与冷存储文件，它们不是快照
+  static bool isMetadataPath(String filePath) {
+    return ChecksumManifest.isManifestPath(filePath) ||
+        isIndexPath(filePath) ||
+        ColdPack.isColdPath(filePath);
+  }
+
+  static bool isShardedSync(String backupDirPath) {
+    return File(indexPath(backupDirPath)).existsSync() &&
+        !File(migrationMarkerPath(backupDirPath)).existsSync();
+  }
+
+  /// 上次迁移没做完：标记文件还在，或没有索引却已有日期子目录（标记出现
+  /// 之前的版本中断的迁移）。再次执行 [migrateSync] 即可继续。
+  static bool isMigrationIncompleteSync(String backupDirPath) {
+    if (File(migrationMarkerPath(backupDirPath)).existsSync()) {
+      return true;
+    }
+    if (File(indexPath(backupDirPath)).existsSync()) {
+      return false;
+    }
+    try {
+      return Directory(
+        backupDirPath,
+      ).listSync(followLinks: false).any(_isYearShard);
+    } on FileSystemException {
+      return false;
+    }
+  }
+
+  static bool _isYearShard(FileSystemEntity entity) {
+    return entity is Directory &&
+        _yearShardPattern.hasMatch(p.basename(entity.path));
+  }
+
+  /// 分片目录中快照的相对路径：`yyyy/mm/dd/<文件名>`，按本地日期
+  static String shardNameFor(String snapshotFileName, DateTime createdAt) {
+    String two(int value) => value.toString().padLeft(2, '0');
+    return '${createdAt.year.toString().padLeft(4, '0')}/'
+        '${two(createdAt.month)}/${two(createdAt.day)}/$snapshotFileName';
+  }
+
+  /// 不存在或无法读取时返回空索引
+  static SnapshotIndex loadSync(String backupDirPath) {
+    final records = <String, SnapshotRecord>{};
+    var lineCount = 0;
+    final List<String> lines;
+    try {
+      lines = File(indexPath(backupDirPath)).readAsLinesSync();
+    } on FileSystemException {
+      return SnapshotIndex._(backupDirPath, records, 0);
+    }
+    for (final line in lines) {
+      if (line.isEmpty || line.startsWith('#')) {
+        continue;
+      }
+      lineCount += 1;
+      if (line.startsWith('- ')) {
+        records.remove(line.substring(2));
+        continue;
+      }
+      final record = _parse(line);
+      if (record != null) {
+        records[record.name] = record;
+      }
+    }
+    return SnapshotIndex._(backupDirPath, records, lineCount);
+  }
+
+  /// 追加记录；索引不存在时先写入表头，目录随之成为分片布局
+  static void appendSync(
+    String backupDirPath,
+    Iterable<SnapshotRecord> added,
+  ) {
+    final buffer = StringBuffer();
+    for (final record in added) {
+      buffer.writeln(_format(record));
+    }
+    _appendLines(backupDirPath, buffer);
+  }
+
+  /// 记录已删除的快照：分片布局追加索引的 `-` 行并删掉空的日期目录，两种
+  /// 布局都从校验清单中移除
+  static void recordRemovalsSync(
+    String backupDirPath,
+    Iterable<String> names,
+  ) {
+    final removed = names.toList();
+    if (removed.isEmpty) {
+      return;
+    }
+    ChecksumManifest.appendRemovalsSync(
+      ChecksumManifest.backupManifestPath(backupDirPath),
+      removed,
+    );
+    // 迁移未完成时只有已写出的索引需要跟着改，不能因此新建索引
+    if (!File(indexPath(backupDirPath)).existsSync()) {
+      return;
+    }
+    final buffer = StringBuffer();
+    for (final name in removed) {
+      buffer.writeln('- $name');
+    }
+    _appendLines(backupDirPath, buffer);
+    for (final name in removed) {
+      _removeEmptyShards(backupDirPath, name);
+    }
+    final index = loadSync(backupDirPath);
+    if (index.needsCompaction) {
+      index.compactSync();
+    }
+  }
+
+  /// 只保留当前记录，写入临时文件后替换，中途失败不会丢掉原索引
+  void compactSync() {
+    _writeAll(backupDirPath, records.values);
+  }
+
+  /// 目录中的全部快照，按快照时间从旧到新。分片布局只读索引；平铺布局列出
+  /// 目录，以修改时间为快照时间；迁移未完成时列出两种布局下的全部文件。
+  /// 目录不存在时为空。
+  static List<SnapshotRecord> snapshotsSync(String backupDirPath) {
+    if (File(migrationMarkerPath(backupDirPath)).existsSync()) {
+      return _scanMixedSync(backupDirPath);
+    }
+    if (isShardedSync(backupDirPath)) {
+      return loadSync(backupDirPath).sorted;
+    }
+    final directory = Directory(backupDirPath);
+    if (!directory.existsSync()) {
+      return [];
+    }
+    final records = <SnapshotRecord>[];
+    for (final entity in directory.listSync(followLinks: false)) {
+      if (_isYearShard(entity)) {
+        return _scanMixedSync(backupDirPath);
+      }
+      if (entity is! File || isMetadataPath(entity.path)) {
+        continue;
+      }
+      final stat = entity.statSync();
+      if (stat.type == FileSystemEntityType.notFound) {
+        continue;
+      }
+      records.add(
+        SnapshotRecord(
+          name: p.basename(entity.path),
+          createdMicros: stat.modified.microsecondsSinceEpoch,
+          size: stat.size,
+        ),
+      );
+    }
+    return _sortByTime(records);
+  }
+
+  /// 迁移中断后的目录：平铺的和已移入日期子目录的快照都在，快照时间的取法
+  /// 与 [migrateSync] 相同
+  static List<SnapshotRecord> _scanMixedSync(String backupDirPath) {
+    final known = loadSync(backupDirPath).records;
+    final records = <SnapshotRecord>[];
+    for (final entity in Directory(
+      backupDirPath,
+    ).listSync(recursive: true, followLinks: false)) {
+      if (entity is! File || isMetadataPath(entity.path)) {
+        continue;
+      }
+      final stat = entity.statSync();
+      if (stat.type == FileSystemEntityType.notFound) {
+        continue;
+      }
+      final name = _relativeName(backupDirPath, entity.path);
+      records.add(
+        SnapshotRecord(
+          name: name,
+          createdMicros:
+              known[name]?.createdMicros ??
+              (createdAtFromName(p.basename(name)) ?? stat.modified)
+                  .microsecondsSinceEpoch,
+          size: stat.size,
+          hash: known[name]?.hash,
+        ),
+      );
+    }
+    return _sortByTime(records);
+  }
+
+  static String _relativeName(String backupDirPath, String filePath) {
+    return p.relative(filePath, from: backupDirPath).replaceAll(r'\', '/');
+  }
+
+  static SnapshotRecord? latestSync(String backupDirPath) {
+    final snapshots = snapshotsSync(backupDirPath);
+    return snapshots.isEmpty ? null : snapshots.last;
+  }
+
+  /// 快照时间在 [from]（含）与 [to]（不含）之间的快照，从旧到新
+  static List<SnapshotRecord> rangeSync(
+    String backupDirPath, {
+    DateTime? from,
+    DateTime? to,
+  }) {
+    final fromMicros = from?.microsecondsSinceEpoch;
+    final toMicros = to?.microsecondsSinceEpoch;
+    return [
+      for (final record in snapshotsSync(backupDirPath))
+        if ((fromMicros == null || record.createdMicros >= fromMicros) &&
+            (toMicros == null || record.createdMicros < toMicros))
+          record,
+    ];
+  }
+
+  /// 把平铺的快照原地移入日期子目录并重建索引。
+  ///
+  /// 快照时间取自文件名中的时间戳，解析不出时用修改时间；已有的校验记录
+  /// 随文件改到新名字下。可以重复执行：中途中断后再次调用会移动剩下的
+  /// 文件，并按磁盘上的实际文件重新写出索引。开始前写入迁移标记，清单也
+  /// 更新完才删除，中断期间目录按迁移未完成处理。
+  static SnapshotMigration migrateSync(String backupDirPath) {
+    final directory = Directory(backupDirPath);
+    if (!directory.existsSync()) {
+      directory.createSync(recursive: true);
+    }
+    final marker = File(migrationMarkerPath(backupDirPath));
+    marker.writeAsStringSync(
+      '${DateTime.now().toIso8601String()}\n',
+      flush: true,
+    );
+    final known = loadSync(backupDirPath).records;
+    final manifestPath = ChecksumManifest.backupManifestPath(backupDirPath);
+    final manifest = ChecksumManifest.loadSync(manifestPath);
+    final records = <SnapshotRecord>[];
+    final renamedEntries = <ChecksumEntry>[];
+    final renamedFrom = <String>[];
+    var movedCount = 0;
+
+    for (final entity in directory.listSync(
+      recursive: true,
+      followLinks: false,
+    )) {
+      if (entity is! File || isMetadataPath(entity.path)) {
+        continue;
+      }
+      var name = _relativeName(backupDirPath, entity.path);
+      final stat = entity.statSync();
+      final createdMicros =
+          known[name]?.createdMicros ??
+          (createdAtFromName(p.basename(name)) ?? stat.modified)
+              .microsecondsSinceEpoch;
+      final entry = manifest.entries[name];
+      final hash = known[name]?.hash ?? entry?.hash;
+
+      if (!name.contains('/')) {
+        final target = shardNameFor(
+          name,
+          DateTime.fromMicrosecondsSinceEpoch(createdMicros),
+        );
+        final targetPath = p.joinAll([backupDirPath, ...target.split('/')]);
+        if (!File(targetPath).existsSync()) {
+          Directory(p.dirname(targetPath)).createSync(recursive: true);
+          entity.renameSync(targetPath);
+          movedCount += 1;
+          if (entry != null) {
+            renamedFrom.add(name);
+            renamedEntries.add(
+              ChecksumEntry(
+                name: target,
+                hash: entry.hash,
+                size: entry.size,
+                modifiedMicros: entry.modifiedMicros,
+              ),
+            );
+          }
+          name = target;
+        }
+      }
+
+      records.add(
+        SnapshotRecord(
+          name: name,
+          createdMicros: createdMicros,
+          size: stat.size,
+          hash: hash,
+        ),
+      );
+    }
+
+    // 索引先写完整，再更新清单：清单里暂时留着旧名字只会在校验时报告一次
+    // 丢失，反过来则会让移动过的快照失去校验记录
+    _writeAll(backupDirPath, records);
+    if (renamedEntries.isNotEmpty) {
+      ChecksumManifest.appendSync(manifestPath, renamedEntries);
+      ChecksumManifest.appendRemovalsSync(manifestPath, renamedFrom);
+    }
+    marker.deleteSync();
+    return SnapshotMigration(
+      snapshotCount: records.length,
+      movedCount: movedCount,
+    );
+  }
+
+  static final RegExp _timestampPattern = RegExp(
+    r'_(\d{4}-\d{2}-\d{2})T(\d{2})-(\d{2})-(\d{2})(\.\d+)?\.bak',
+  );
+
+  /// 解析监控快照文件名 `<文件名>_<ISO 时间，冒号换成 ->.bak<扩展名>` 中的
+  /// 本地时间
+  static DateTime? createdAtFromName(String snapshotFileName) {
+    final match = _timestampPattern.allMatches(snapshotFileName).lastOrNull;
+    if (match == null) {
+      return null;
+    }
+    return DateTime.tryParse(
+      '${match[1]}T${match[2]}:${match[3]}:${match[4]}${match[5] ?? ''}',
+    );
+  }
+
+  static void _removeEmptyShards(String backupDirPath, String name) {
+    final root = p.normalize(backupDirPath);
+    var directory = p.dirname(p.joinAll([root, ...name.split('/')]));
+    while (p.isWithin(root, directory)) {
+      try {
+        Directory(directory).deleteSync();
+      } on FileSystemException {
+        return;
+      }
+      directory = p.dirname(directory);
+    }
+  }
+
+  static void _writeAll(
+    String backupDirPath,
+    Iterable<SnapshotRecord> records,
+  ) {
+    final buffer = StringBuffer()..writeln(header);
+    for (final record in _sortByTime(records.toList())) {
+      buffer.writeln(_format(record));
+    }
+    final path = indexPath(backupDirPath);
+    final temp = File('$path.tmp');
+    temp.writeAsStringSync(buffer.toString(), flush: true);
+    temp.renameSync(path);
+  }
+
+  static void _appendLines(String backupDirPath, StringBuffer lines) {
+    if (lines.isEmpty) {
+      return;
+    }
+    final file = File(indexPath(backupDirPath));
+    final prefix = file.existsSync() ? '' : '$header\n';
+    file.writeAsStringSync('$prefix$lines', mode: FileMode.append);
+  }
+
+  static List<SnapshotRecord> _sortByTime(List<SnapshotRecord> records) {
+    return records..sort((a, b) {
+      final byTime = a.createdMicros.compareTo(b.createdMicros);
+      return byTime != 0 ? byTime : a.name.compareTo(b.name);
+    });
+  }
+
+  static String _format(SnapshotRecord record) {
+    return '${record.createdMicros} ${record.size} ${record.hash ?? '-'} '
+        '${record.name}';
+  }
+
+  static SnapshotRecord? _parse(String line) {
+    final first = line.indexOf(' ');
+    final second = first < 0 ? -1 : line.indexOf(' ', first + 1);
+    final third = second < 0 ? -1 : line.indexOf(' ', second + 1);
+    if (third < 0 || third == line.length - 1) {
+      return null;
+    }
+    final created = int.tryParse(line.substring(0, first));
+    final size = int.tryParse(line.substring(first + 1, second));
+    final hash = line.substring(second + 1, third);
+    if (created == null || size == null) {
+      return null;
+    }
+    return SnapshotRecord(
+      name: line.substring(third + 1),
+      createdMicros: created,
+      size: size,
+      hash: hash.length == 16 ? hash : null,
+    );
+  }
+}
@@ -1,11 +1,15 @@
 import 'dart:io';
 import 'package:path/path.dart' as path;
 
+import 'package:vertree/component/AppMetrics.dart';
 import 'package:vertree/core/FileVersionTree.dart';
 import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/VersionKey.dart';
+import 'package:vertree/core/VersionPack.dart';
 
 Future<Result<FileNode, String>> buildTree(String selectedFileNodePath) async {
   FileNode? rootNode;
+  final stopwatch = Stopwatch()..start();
 
   try {
     if (!File(selectedFileNodePath).existsSync()) {
@@ -15,58 +19,120 @@ Future<Result<FileNode, String>> buildTree(String selectedFileNodePath) async {
       return Result.eMsg("当前文件命名不支持版本树");
     }
 
-    FileNode selectedFileNode = FileNode(selectedFileNodePath);
-    String dirname = path.dirname(selectedFileNodePath);
+    final selectedMeta = FileMeta(selectedFileNodePath);
+    final fileNodes = await loadFamilyNodes(
+      path.dirname(selectedFileNodePath),
+      selectedMeta.name,
+      selectedMeta.extension,
+    );
+    rootNode = assembleTree(fileNodes);
+    if (rootNode == null) {
+      return Result.eMsg("未找到根节点");
+    }
+    appMetrics.recordTreeBuild(stopwatch.elapsed, fileNodes.length);
+  } catch (e) {
+    return Result.err(e.toString());
+  }
+
+  return Result.ok(rootNode);
+}
 
-    final files = await Directory(dirname).list().toList();
+/// 列出 [directoryPath] 中名称为 [name]、扩展名为 [extension] 的全部版本文件
+Future<List<FileNode>> loadFamilyNodes(
+  String directoryPath,
+  String name,
+  String extension,
+) async {
+  final files = await Directory(directoryPath).list().toList();
 
-    // 过滤掉所有 name 与 extension 不一致，或不满足版本树命名规则的文件
-    final filteredFiles = files.where((file) {
-      try {
-        if (file is! File) return false;
-        if (!FileMeta.isSupportedTreeFilePath(file.path)) {
-          return false;
-        }
-        final fileMeta = FileMeta(file.path);
-        return fileMeta.name == selectedFileNode.mate.name &&
-            fileMeta.extension == selectedFileNode.mate.extension;
-      } catch (e) {
-        stderr.writeln("$e");
+  // 过滤掉所有 name 与 extension 不一致，或不满足版本树命名规则的文件
+  final filteredFiles = files.where((file) {
+    try {
+      if (file is! File) return false;
+      if (!FileMeta.isSupportedTreeFilePath(file.path)) {
         return false;
       }
-    }).toList();
-
-    List<FileNode> fileNodes = [];
-
-    // 找到 version 最低的文件作为 rootNode
-
-    for (var file in filteredFiles) {
       final fileMeta = FileMeta(file.path);
-      final fileNode = FileNode(file.path);
-      fileNodes.add(fileNode);
-
-      if (rootNode == null ||
-          fileMeta.version.compareTo(rootNode.mate.version) < 0) {
-        rootNode = fileNode;
-      }
+      return fileMeta.name == name && fileMeta.extension == extension;
+    } catch (e) {
+      stderr.writeln("$e");
+      return false;
     }
+  }).toList();
+
+  return [for (final file in filteredFiles) FileNode(file.path)];
+}
 
+/// 直接从打包文件建树，不解压。节点路径是 `<打包文件>/<文件名>` 形式的虚拟路径，
+/// 大小与修改时间取自打包索引。
+Future<Result<FileNode, String>> buildTreeFromPack(String packPath) async {
+  final stopwatch = Stopwatch()..start();
+  try {
+    final pack = await VersionPack.open(packPath);
+    final fileNodes = <FileNode>[];
+    for (final entry in pack.versions) {
+      final meta = FileMeta(pack.entryPath(entry))
+        ..fileSize = entry.size
+        ..creationTime = entry.modifiedAt
+        ..lastModifiedTime = entry.modifiedAt;
+      fileNodes.add(FileNode.fromMeta(meta));
+    }
+    final rootNode = assembleTree(fileNodes);
     if (rootNode == null) {
-      return Result.eMsg("未找到根节点");
+      return Result.eMsg("打包文件中没有版本");
     }
+    appMetrics.recordTreeBuild(stopwatch.elapsed, fileNodes.length);
+    return Result.ok(rootNode);
+  } on FormatException catch (e) {
+    return Result.eMsg(e.message);
+  } catch (e) {
+    return Result.err(e.toString());
+  }
+}
 
-    // 自定义排序方法：
-    fileNodes.sort((a, b) => a.mate.version.compareTo(b.mate.version));
-
-    List<FileNode> sortedFileNodes = fileNodes;
+/// 以版本最低的节点为根，按版本顺序挂上其余节点。
+///
+/// 节点按 [FileVersion.key] 基数排序，父节点的键由 [VersionKey.parentOf]
+/// 直接算出后在哈希表中查找，不再从根递归搜索挂载位置。家族中有节点缺少
+/// 父版本时（中间版本被删除等），整体退回 [FileNode.push] 的逐个搜索，
+/// 保持以往对这类残缺家族的挂载结果；完整的家族两种方式得到同一棵树。
+FileNode? assembleTree(List<FileNode> fileNodes) {
+  if (fileNodes.isEmpty) {
+    return null;
+  }
+  VersionKey.sort(fileNodes, (node) => node.mate.version.key);
+  final rootNode = fileNodes.first;
 
-    for (var node in sortedFileNodes) {
-      // print(node.mate.version.toString());
-      rootNode.push(node);
+  final nodesByKey = <String, FileNode>{};
+  for (final node in fileNodes) {
+    nodesByKey.putIfAbsent(node.mate.version.key, () => node);
+  }
+  final parentKeys = <String?>[
+    for (final node in fileNodes) VersionKey.parentOf(node.mate.version.key),
+  ];
+  final rootKey = rootNode.mate.version.key;
+  for (var index = 0; index < fileNodes.length; index++) {
+    final parentKey = parentKeys[index];
+    if (fileNodes[index].mate.version.key != rootKey &&
+        (parentKey == null || !nodesByKey.containsKey(parentKey))) {
+      for (final node in fileNodes) {
+        rootNode.push(node);
+      }
+      return rootNode;
     }
-  } catch (e) {
-    return Result.err(e.toString());
   }
 
-  return Result.ok(rootNode);
+  for (var index = 0; index < fileNodes.length; index++) {
+    final node = fileNodes[index];
+    if (node.mate.version.key == rootKey) {
+      continue;
+    }
+    final parent = nodesByKey[parentKeys[index]]!;
+    if (node.mate.version.revisionNumber > 0) {
+      parent.addChild(node);
+    } else {
+      parent.addBranch(node);
+    }
+  }
+  return rootNode;
 }
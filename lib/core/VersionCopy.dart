@@ -0,0 +1,488 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Xxh64.dart';
+
+/// 用户或 API 取消了版本备份
+class VersionCopyCancelled implements Exception {
+  const VersionCopyCancelled(this.targetPath);
+
+  final String targetPath;
+
+  @override
+  String toString() => '备份已取消: $targetPath';
+}
+
+enum VersionCopyState { copying, finished, failed, cancelled }
+
+/// 一次版本复制的进度，见 [VersionCopy.copy]
+class VersionCopyTask {
+  VersionCopyTask._(this.id, this.sourcePath, this.targetPath);
+
+  final String id;
+  final String sourcePath;
+  final String targetPath;
+  final DateTime startedAt = DateTime.now();
+
+  VersionCopyState _state = VersionCopyState.copying;
+  int _totalBytes = 0;
+  int _copiedBytes = 0;
+  int _resumedFromBytes = 0;
+  String? _error;
+  bool _cancelRequested = false;
+  SendPort? _control;
+
+  VersionCopyState get state => _state;
+  int get totalBytes => _totalBytes;
+  int get copiedBytes => _copiedBytes;
+
+  /// 从上次中断处继续时已有的字节数，否则为 0
+  int get resumedFromBytes => _resumedFromBytes;
+  String? get error => _error;
+  bool get isCancelRequested => _cancelRequested;
+
+  /// 停止复制并删除临时文件；复制已经结束时无效
+  void cancel() {
+    if (_cancelRequested || _state != VersionCopyState.copying) {
+      return;
+    }
+    _cancelRequested = true;
+    _control?.send(true);
+  }
+
+  Map<String, dynamic> toJson() => {
+    'id': id,
+    'sourcePath': sourcePath,
+    'targetPath': targetPath,
+    'state': _state.name,
+    'totalBytes': _totalBytes,
+    'copiedBytes': _copiedBytes,
+    'resumedFromBytes': _resumedFromBytes,
+    'startedAt': startedAt.toIso8601String(),
+    'cancelRequested': _cancelRequested,
+    'error': _error,
+  };
+}
+
+/// 把源文件复制成新的版本文件，半成品不会被当作版本。
+///
+/// 内容先写入同目录的隐藏临时文件 `.<去掉备注的版本文件名>.vtpart`（[FileMeta]
+/// 不把它当作版本），写完后改名为版本文件。大文件在后台 isolate 中分块复制、边写
+/// 边算 XXH64，通过 [updates] 定期报告进度，可随时取消。每写入
+/// [checkpointBytes] 就把临时文件刷到磁盘，并在旁边的 `.vtpart.json` 记下已落盘
+/// 的字节数与这段内容的校验和。进程崩溃或网络盘断开后再备份到同一路径时，只要
+/// 源文件的大小和修改时间没变、临时文件开头的校验和与记录一致，就从记录的位置继续，
+/// 否则从头复制；临时文件名不含备注，换了备注重试同一版本也能续传。取消会删除
+/// 临时文件；每次复制开始时清掉同目录中再也续传不了的临时文件。
+///
+/// 不到一个检查点大小的文件直接经 [FileChecksum.copy] 写入临时文件，取消在复制
+/// 结束后生效。
+class VersionCopy {
+  static const String partSuffix = '.vtpart';
+  static const String journalSuffix = '$partSuffix.json';
+  static const int defaultChunkBytes = 4 << 20;
+  static const int defaultCheckpointBytes = 64 << 20;
+  static const Duration progressInterval = Duration(milliseconds: 250);
+
+  static final Map<String, VersionCopyTask> _active = {};
+  static final StreamController<VersionCopyTask> _updates =
+      StreamController<VersionCopyTask>.broadcast();
+  static int _lastId = 0;
+
+  /// 正在进行的复制，按开始时间排列
+  static List<VersionCopyTask> get active => List.unmodifiable(_active.values);
+
+  /// 开始、每次进度更新和结束时各推送一次
+  static Stream<VersionCopyTask> get updates => _updates.stream;
+
+  static VersionCopyTask? find(String id) => _active[id];
+
+  /// 找不到正在进行的复制时返回 false
+  static bool cancel(String id) {
+    final task = _active[id];
+    if (task == null) {
+      return false;
+    }
+    task.cancel();
+    return true;
+  }
+
+  /// 按文件族和版本号命名，不含备注
+  static String partPathOf(String targetPath) {
+    return path.join(
+      path.dirname(targetPath),
+      '.${FileMeta.unlabeledNameOf(targetPath)}$partSuffix',
+    );
+  }
+
+  static String journalPathOf(String targetPath) {
+    return '${partPathOf(targetPath)}.json';
+  }
+
+  static bool isPartPath(String filePath) {
+    final name = path.basename(filePath);
+    return name.startsWith('.') &&
+        (name.endsWith(partSuffix) ||
+            name.endsWith(journalSuffix) ||
+            name.endsWith('$journalSuffix.tmp'));
+  }
+
+  /// 复制 [sourcePath] 到还不存在的 [targetPath]。取消时抛出
+  /// [VersionCopyCancelled]，读写失败时抛出 [FileSystemException]；两种情况下
+  /// [targetPath] 都不会出现。
+  static Future<FileChecksum> copy(
+    String sourcePath,
+    String targetPath, {
+    int chunkBytes = defaultChunkBytes,
+    int checkpointBytes = defaultCheckpointBytes,
+  }) async {
+    if (File(targetPath).existsSync()) {
+      throw FileSystemException('目标版本文件已存在', targetPath);
+    }
+    final partPath = partPathOf(targetPath);
+    if (_active.values.any(
+      (task) => partPathOf(task.targetPath) == partPath,
+    )) {
+      throw FileSystemException('同一版本正在备份', targetPath);
+    }
+    final task = VersionCopyTask._('${++_lastId}', sourcePath, targetPath);
+    _active[task.id] = task;
+    _updates.add(task);
+    try {
+      _sweepStaleParts(path.dirname(targetPath));
+      final size = File(sourcePath).lengthSync();
+      task._totalBytes = size;
+      final FileChecksum checksum;
+      if (size < checkpointBytes &&
+          !File(journalPathOf(targetPath)).existsSync()) {
+        checksum = await FileChecksum.copy(sourcePath, partPath);
+        if (task._cancelRequested) {
+          _deleteQuietly(partPath);
+          throw VersionCopyCancelled(targetPath);
+        }
+        task._copiedBytes = checksum.size;
+      } else {
+        checksum = await _copyInBackground(task, chunkBytes, checkpointBytes);
+      }
+      _commit(partPath, targetPath);
+      task._state = VersionCopyState.finished;
+      return checksum;
+    } on VersionCopyCancelled {
+      task._state = VersionCopyState.cancelled;
+      rethrow;
+    } catch (e) {
+      task
+        .._state = VersionCopyState.failed
+        .._error = e.toString();
+      rethrow;
+    } finally {
+      _active.remove(task.id);
+      _updates.add(task);
+    }
+  }
+
+  /// 改名前再确认一次目标不存在：POSIX 的 rename 会直接覆盖已有文件
+  static void _commit(String partPath, String targetPath) {
+    if (File(targetPath).existsSync()) {
+      _deleteQuietly(partPath);
+      throw FileSystemException('目标版本文件已存在', targetPath);
+    }
+    File(partPath).renameSync(targetPath);
+    _deleteQuietly(journalPathOf(targetPath));
+  }
+
+  /// 删除 [dirPath] 中不会再被续传的临时文件和记录：按旧规则带备注命名的、
+  /// 对应版本已经存在的，以及临时文件已不在的记录。正在复制的不动。
+  static void _sweepStaleParts(String dirPath) {
+    final List<FileSystemEntity> entities;
+    try {
+      entities = Directory(dirPath).listSync(followLinks: false);
+    } on FileSystemException {
+      return;
+    }
+    final inUse = {
+      for (final task in _active.values) partPathOf(task.targetPath),
+    };
+    final names = {for (final entity in entities) path.basename(entity.path)};
+    final versions = {
+      for (final entity in entities)
+        if (entity is File && FileMeta.isSupportedTreeFilePath(entity.path))
+          FileMeta.unlabeledNameOf(entity.path),
+    };
+    for (final entity in entities) {
+      if (entity is! File || !isPartPath(entity.path)) {
+        continue;
+      }
+      final name = path.basename(entity.path);
+      final partName = name.substring(
+        0,
+        name.indexOf(partSuffix) + partSuffix.length,
+      );
+      if (inUse.contains(path.join(dirPath, partName))) {
+        continue;
+      }
+      final versionName = partName.substring(
+        1,
+        partName.length - partSuffix.length,
+      );
+      if (versionName.contains('#') ||
+          versions.contains(versionName) ||
+          (name != partName && !names.contains(partName))) {
+        _deleteQuietly(entity.path);
+      }
+    }
+  }
+
+  static Future<FileChecksum> _copyInBackground(
+    VersionCopyTask task,
+    int chunkBytes,
+    int checkpointBytes,
+  ) async {
+    final messages = ReceivePort();
+    try {
+      await Isolate.spawn(
+        _copyInIsolate,
+        _CopyJob(
+          replyTo: messages.sendPort,
+          sourcePath: task.sourcePath,
+          targetPath: task.targetPath,
+          chunkBytes: chunkBytes,
+          checkpointBytes: checkpointBytes,
+        ),
+        onExit: messages.sendPort,
+      );
+      await for (final message in messages) {
+        switch (message) {
+          case SendPort control:
+            task._control = control;
+            if (task._cancelRequested) {
+              control.send(true);
+            }
+          case [_started, int total, int resumedFrom]:
+            task
+              .._totalBytes = total
+              .._resumedFromBytes = resumedFrom
+              .._copiedBytes = resumedFrom;
+            _updates.add(task);
+          case [_progress, int copied]:
+            task._copiedBytes = copied;
+            _updates.add(task);
+          case [_done, int hash, int size]:
+            task._copiedBytes = size;
+            return FileChecksum(hash: hash, size: size);
+          case [_cancelled]:
+            throw VersionCopyCancelled(task.targetPath);
+          case [_failed, String error]:
+            throw FileSystemException(error, task.sourcePath);
+          case null:
+            throw FileSystemException('复制进程意外退出', task.sourcePath);
+        }
+      }
+      throw FileSystemException('复制进程意外退出', task.sourcePath);
+    } finally {
+      task._control = null;
+      messages.close();
+    }
+  }
+
+  static void _deleteQuietly(String filePath) {
+    try {
+      File(filePath).deleteSync();
+    } catch (_) {
+      // ignore
+    }
+  }
+}
+
+// 后台 isolate 发回的消息：第一条是接收取消请求的 SendPort，之后是以下列
+const int _started = 0;
+const int _progress = 1;
+const int _done = 2;
+const int _cancelled = 3;
+const int _failed = 4;
+
+class _CopyJob {
+  const _CopyJob({
+    required this.replyTo,
+    required this.sourcePath,
+    required this.targetPath,
+    required this.chunkBytes,
+    required this.checkpointBytes,
+  });
+
+  final SendPort replyTo;
+  final String sourcePath;
+  final String targetPath;
+  final int chunkBytes;
+  final int checkpointBytes;
+}
+
+Future<void> _copyInIsolate(_CopyJob job) async {
+  // 读写都是异步的，每块之间能收到取消请求
+  final control = ReceivePort();
+  var cancelRequested = false;
+  control.listen((_) => cancelRequested = true);
+  job.replyTo.send(control.sendPort);
+  try {
+    job.replyTo.send(await _copyResumable(job, () => cancelRequested));
+  } catch (e) {
+    job.replyTo.send([_failed, e.toString()]);
+  } finally {
+    control.close();
+  }
+}
+
+Future<List<Object>> _copyResumable(
+  _CopyJob job,
+  bool Function() cancelRequested,
+) async {
+  final partPath = VersionCopy.partPathOf(job.targetPath);
+  final journalPath = VersionCopy.journalPathOf(job.targetPath);
+  final sourceStat = await File(job.sourcePath).stat();
+  final source = await File(job.sourcePath).open();
+  RandomAccessFile? part;
+  var keepPart = false;
+  try {
+    final buffer = Uint8List(job.chunkBytes);
+    final (resumeFrom, hash) = await _verifiedPrefix(
+      partPath,
+      journalPath,
+      job.sourcePath,
+      sourceStat,
+      buffer,
+    );
+    part = await File(
+      partPath,
+    ).open(mode: resumeFrom > 0 ? FileMode.append : FileMode.write);
+    await part.truncate(resumeFrom);
+    await part.setPosition(resumeFrom);
+    await source.setPosition(resumeFrom);
+    job.replyTo.send([_started, sourceStat.size, resumeFrom]);
+    keepPart = resumeFrom > 0;
+
+    var offset = resumeFrom;
+    var checkpointed = resumeFrom;
+    final sinceProgress = Stopwatch()..start();
+    while (true) {
+      if (cancelRequested()) {
+        keepPart = false;
+        return [_cancelled];
+      }
+      final read = await source.readInto(buffer);
+      if (read == 0) {
+        break;
+      }
+      hash.addBytes(Uint8List.sublistView(buffer, 0, read));
+      await part.writeFrom(buffer, 0, read);
+      offset += read;
+      if (offset - checkpointed >= job.checkpointBytes) {
+        await part.flush();
+        _writeJournal(journalPath, job.sourcePath, sourceStat, offset, hash);
+        checkpointed = offset;
+        keepPart = true;
+      }
+      if (sinceProgress.elapsed >= VersionCopy.progressInterval) {
+        job.replyTo.send([_progress, offset]);
+        sinceProgress.reset();
+      }
+    }
+    await part.flush();
+    final finished = part;
+    part = null;
+    await finished.close();
+    keepPart = true;
+    return [_done, hash.value, hash.length];
+  } finally {
+    await source.close();
+    await part?.close();
+    // 有检查点的半成品留给下次续传；取消或从未落盘过的直接删除
+    if (!keepPart) {
+      VersionCopy._deleteQuietly(partPath);
+      VersionCopy._deleteQuietly(journalPath);
+    }
+  }
+}
+
+/// 校验上次留下的临时文件，返回可以接着写的位置和已包含这之前内容的校验和；
+/// 不能续传时位置为 0
+Future<(int, Xxh64)> _verifiedPrefix(
+  String partPath,
+  String journalPath,
+  String sourcePath,
+  FileStat sourceStat,
+  Uint8List buffer,
+) async {
+  final Map<String, dynamic> journal;
+  try {
+    journal =
+        jsonDecode(await File(journalPath).readAsString())
+            as Map<String, dynamic>;
+  } catch (_) {
+    return (0, Xxh64());
+  }
+  final offset = journal['verifiedBytes'];
+  if (journal['sourcePath'] != sourcePath ||
+      journal['sourceSize'] != sourceStat.size ||
+      journal['sourceModifiedMicros'] !=
+          sourceStat.modified.microsecondsSinceEpoch ||
+      offset is! int ||
+      offset <= 0 ||
+      offset > sourceStat.size) {
+    return (0, Xxh64());
+  }
+  final hash = Xxh64();
+  try {
+    final part = await File(partPath).open();
+    try {
+      var remaining = offset;
+      while (remaining > 0) {
+        final read = await part.readInto(
+          buffer,
+          0,
+          remaining < buffer.length ? remaining : buffer.length,
+        );
+        if (read == 0) {
+          return (0, Xxh64());
+        }
+        hash.addBytes(Uint8List.sublistView(buffer, 0, read));
+        remaining -= read;
+      }
+    } finally {
+      await part.close();
+    }
+  } on FileSystemException {
+    return (0, Xxh64());
+  }
+  if (Xxh64.hexOf(hash.value) != journal['verifiedHash']) {
+    return (0, Xxh64());
+  }
+  return (offset, hash);
+}
+
+void _writeJournal(
+  String journalPath,
+  String sourcePath,
+  FileStat sourceStat,
+  int verifiedBytes,
+  Xxh64 hash,
+) {
+  // 先写临时文件再改名，断电时不会留下半截的记录
+  final temp = File('$journalPath.tmp');
+  temp.writeAsStringSync(
+    jsonEncode({
+      'sourcePath': sourcePath,
+      'sourceSize': sourceStat.size,
+      'sourceModifiedMicros': sourceStat.modified.microsecondsSinceEpoch,
+      'verifiedBytes': verifiedBytes,
+      'verifiedHash': Xxh64.hexOf(hash.value),
+    }),
+    flush: true,
+  );
+  temp.renameSync(journalPath);
+}
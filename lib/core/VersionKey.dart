@@ -0,0 +1,180 @@
+import 'package:vertree/core/FileVersionTree.dart';
+
+/// 版本号的紧凑键：每段的分支号、版本号依次写成保序变长整数，
+/// 每个字节占一个 0–255 的码元，拼成字符串。
+///
+/// 单个整数的编码：小于 240 时就是一个字节；否则先写 `240 + 长度 - 1`，
+/// 再写去掉前导零的大端字节。这种编码自带边界、按字节比较与数值大小一致，
+/// 所以整个键按码元比较（[String.compareTo]）的结果与
+/// [FileVersion.compareTo] 的逐段比较相同：短的前缀排在它的延伸之前。
+/// 常见的 `0.12-1.3` 只占 4 个码元，可以直接作为哈希表的键。
+class VersionKey {
+  VersionKey._();
+
+  static const int _inlineLimit = 240;
+
+  /// 小于该长度的区间改用插入排序
+  static const int _insertionSortThreshold = 24;
+
+  /// 桶 0 放在当前位置已经结束的键，桶 1–256 对应码元 0–255
+  static const int _bucketCount = 257;
+
+  static String encode(List<Segment> segments) {
+    final buffer = StringBuffer();
+    for (final segment in segments) {
+      _writeNumber(buffer, segment.branch);
+      _writeNumber(buffer, segment.version);
+    }
+    return buffer.toString();
+  }
+
+  static List<Segment> decode(String key) {
+    final numbers = _decodeNumbers(key);
+    return [
+      for (var index = 0; index + 1 < numbers.length; index += 2)
+        Segment(numbers[index], numbers[index + 1]),
+    ];
+  }
+
+  /// 树上父节点的键：末段版本号大于 0 时是同一分支的上一个版本，
+  /// 等于 0 时是去掉末段后的分叉点。只有一段且版本号为 0 时没有父节点。
+  ///
+  /// 与 [FileVersion.isChild]、[FileVersion.isDirectBranch] 描述的关系一致，
+  /// 只是直接算出来，不需要在已有的树里搜索。
+  static String? parentOf(String key) {
+    var offset = 0;
+    var lastSegmentStart = 0;
+    var segmentCount = 0;
+    var branch = 0;
+    var version = 0;
+    while (offset < key.length) {
+      lastSegmentStart = offset;
+      (branch, offset) = _readNumber(key, offset);
+      (version, offset) = _readNumber(key, offset);
+      segmentCount++;
+    }
+    if (segmentCount == 0) {
+      return null;
+    }
+    if (version > 0) {
+      final buffer = StringBuffer(key.substring(0, lastSegmentStart));
+      _writeNumber(buffer, branch);
+      _writeNumber(buffer, version - 1);
+      return buffer.toString();
+    }
+    if (segmentCount == 1) {
+      return null;
+    }
+    return key.substring(0, lastSegmentStart);
+  }
+
+  /// 按 [keyOf] 给出的键对 [items] 原地做 MSD 基数排序，键相同的元素保持原有顺序
+  static void sort<T>(List<T> items, String Function(T item) keyOf) {
+    if (items.length < 2) {
+      return;
+    }
+    final keys = [for (final item in items) keyOf(item)];
+    final order = List<int>.generate(items.length, (index) => index);
+    final scratch = List<int>.filled(items.length, 0);
+    _radixSort(keys, order, scratch, 0, items.length, 0);
+    final sorted = [for (final index in order) items[index]];
+    items.setAll(0, sorted);
+  }
+
+  static void _radixSort(
+    List<String> keys,
+    List<int> order,
+    List<int> scratch,
+    int from,
+    int to,
+    int depth,
+  ) {
+    if (to - from < _insertionSortThreshold) {
+      _insertionSort(keys, order, from, to);
+      return;
+    }
+    final starts = List<int>.filled(_bucketCount + 1, 0);
+    for (var index = from; index < to; index++) {
+      starts[_bucketOf(keys[order[index]], depth) + 1]++;
+    }
+    for (var bucket = 0; bucket < _bucketCount; bucket++) {
+      starts[bucket + 1] += starts[bucket];
+    }
+    final cursors = List<int>.of(starts);
+    for (var index = from; index < to; index++) {
+      final item = order[index];
+      scratch[from + cursors[_bucketOf(keys[item], depth)]++] = item;
+    }
+    order.setRange(from, to, scratch, from);
+    // 桶 0 里的键到这里已经全部相同
+    for (var bucket = 1; bucket < _bucketCount; bucket++) {
+      final start = from + starts[bucket];
+      final end = from + starts[bucket + 1];
+      if (end - start > 1) {
+        _radixSort(keys, order, scratch, start, end, depth + 1);
+      }
+    }
+  }
+
+  static void _insertionSort(
+    List<String> keys,
+    List<int> order,
+    int from,
+    int to,
+  ) {
+    for (var index = from + 1; index < to; index++) {
+      final item = order[index];
+      final key = keys[item];
+      var position = index;
+      while (position > from && keys[order[position - 1]].compareTo(key) > 0) {
+        order[position] = order[position - 1];
+        position--;
+      }
+      order[position] = item;
+    }
+  }
+
+  static int _bucketOf(String key, int depth) {
+    return depth < key.length ? key.codeUnitAt(depth) + 1 : 0;
+  }
+
+  static void _writeNumber(StringBuffer buffer, int value) {
+    assert(value >= 0, '版本号不能为负数: $value');
+    if (value < _inlineLimit) {
+      buffer.writeCharCode(value);
+      return;
+    }
+    var length = 1;
+    while (length < 8 && value >> (length * 8) != 0) {
+      length++;
+    }
+    buffer.writeCharCode(_inlineLimit + length - 1);
+    for (var shift = (length - 1) * 8; shift >= 0; shift -= 8) {
+      buffer.writeCharCode((value >> shift) & 0xFF);
+    }
+  }
+
+  static (int, int) _readNumber(String key, int offset) {
+    final head = key.codeUnitAt(offset);
+    if (head < _inlineLimit) {
+      return (head, offset + 1);
+    }
+    final length = head - _inlineLimit + 1;
+    var value = 0;
+    for (var index = 1; index <= length; index++) {
+      value = (value << 8) | key.codeUnitAt(offset + index);
+    }
+    return (value, offset + 1 + length);
+  }
+
+  static List<int> _decodeNumbers(String key) {
+    final numbers = <int>[];
+    var offset = 0;
+    while (offset < key.length) {
+      final (value, next) = _readNumber(key, offset);
+      numbers.add(value);
+      offset = next;
+    }
+    return numbers;
+  }
+}
@@ -0,0 +1,795 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/core/Xxh64.dart';
+
+enum VersionPackEntryKind {
+  /// 版本文件，名称即原文件名
+  version,
+
+  /// 监控备份，名称为 `<备份目录名>/<文件名>`
+  backup,
+}
+
+/// 打包文件索引中的一项
+class VersionPackEntry {
+  const VersionPackEntry({
+    required this.name,
+    required this.kind,
+    required this.offset,
+    required this.size,
+    required this.storedSize,
+    required this.compressed,
+    required this.hash,
+    required this.modifiedMicros,
+  });
+
+  factory VersionPackEntry.fromJson(Map<String, dynamic> json) {
+    return VersionPackEntry(
+      name: json['name'] as String,
+      kind: VersionPackEntryKind.values.byName(json['kind'] as String),
+      offset: json['offset'] as int,
+      size: json['size'] as int,
+      storedSize: json['storedSize'] as int,
+      compressed: json['compression'] == 'zlib',
+      hash: json['hash'] as String,
+      modifiedMicros: json['modifiedMicros'] as int,
+    );
+  }
+
+  /// 以 `/` 分隔的相对路径
+  final String name;
+  final VersionPackEntryKind kind;
+
+  /// 数据在打包文件中的起始偏移
+  final int offset;
+
+  /// 原始字节数
+  final int size;
+
+  /// 打包文件中占用的字节数，未压缩时等于 [size]
+  final int storedSize;
+  final bool compressed;
+
+  /// 原始内容的 16 位十六进制 XXH64，与校验清单一致
+  final String hash;
+  final int modifiedMicros;
+
+  DateTime get modifiedAt =>
+      DateTime.fromMicrosecondsSinceEpoch(modifiedMicros);
+
+  Map<String, dynamic> toJson() => {
+    'name': name,
+    'kind': kind.name,
+    'offset': offset,
+    'size': size,
+    'storedSize': storedSize,
+    'compression': compressed ? 'zlib' : 'none',
+    'hash': hash,
+    'modifiedMicros': modifiedMicros,
+  };
+}
+
+/// 导入结果
+class VersionPackImportReport {
+  const VersionPackImportReport({
+    required this.targetDirectory,
+    required this.restored,
+    required this.skipped,
+    required this.conflicts,
+    required this.bytesWritten,
+  });
+
+  final String targetDirectory;
+
+  /// 写入的条目名称
+  final List<String> restored;
+
+  /// 目标位置已有内容相同的文件，未重复写入
+  final List<String> skipped;
+
+  /// 目标位置已有内容不同的文件，保留原文件不覆盖
+  final List<String> conflicts;
+  final int bytesWritten;
+
+  Map<String, dynamic> toJson() => {
+    'targetDirectory': targetDirectory,
+    'restoredCount': restored.length,
+    'skippedCount': skipped.length,
+    'conflictCount': conflicts.length,
+    'bytesWritten': bytesWritten,
+    'restored': restored,
+    'skipped': skipped,
+    'conflicts': conflicts,
+  };
+}
+
+/// 把一个版本家族（可选带上监控备份）打包成单个 `.vtpack` 文件。
+///
+/// 文件格式（小端序）：
+/// - 文件头 16 字节：魔数 `VTPACK01`、u32 格式版本、u32 保留
+/// - 各条目的数据依次排列。未压缩且不小于 64 KB 的条目从 4096 字节边界开始，
+///   其余按 8 字节对齐
+/// - 索引：UTF-8 JSON，记录家族名称、扩展名和每个条目的 [VersionPackEntry]
+/// - 文件尾 32 字节：u64 索引偏移、u64 索引长度、u64 索引 XXH64、魔数 `VTPACKIX`
+///
+/// 打开时只读文件尾和索引，条目按偏移随机读取；偏移固定且对齐，
+/// 也可以把整个文件 mmap 后直接切片，未压缩条目就是原文件的字节。
+/// 每个条目带原始内容的校验和，压缩只在能省下至少八分之一时保留。
+class VersionPack {
+  VersionPack._({
+    required this.path,
+    required this.name,
+    required this.fileExtension,
+    required this.createdAt,
+    required this.entries,
+  });
+
+  static const String fileSuffix = '.vtpack';
+  static const int formatVersion = 1;
+  static const List<int> fileMagic = [
+    0x56, 0x54, 0x50, 0x41, 0x43, 0x4b, 0x30, 0x31, // VTPACK01
+  ];
+  static const List<int> trailerMagic = [
+    0x56, 0x54, 0x50, 0x41, 0x43, 0x4b, 0x49, 0x58, // VTPACKIX
+  ];
+  static const int headerSize = 16;
+  static const int trailerSize = 32;
+  static const int pageAlignment = 4096;
+  static const int pageAlignedMinBytes = 64 * 1024;
+  static const int alignment = 8;
+
+  /// 超过这个大小的文件不尝试压缩，直接分块写入
+  static const int maxCompressBytes = 32 * 1024 * 1024;
+  static const int _chunkBytes = 1 << 20;
+  static const int _maxIndexBytes = 64 * 1024 * 1024;
+
+  /// 本身已经压缩过的格式，压缩只会白费时间
+  static const Set<String> incompressibleExtensions = {
+    '.7z', '.gz', '.jpeg', '.jpg', '.mp3', '.mp4', '.png', '.rar', '.webp',
+    '.xz', '.zip', '.docx', '.xlsx', '.pptx',
+  };
+
+  final String path;
+
+  /// 版本家族的主名称
+  final String name;
+
+  /// 扩展名，不含点号
+  final String fileExtension;
+  final DateTime createdAt;
+  final List<VersionPackEntry> entries;
+
+  late final Map<String, VersionPackEntry> _byName = {
+    for (final entry in entries) entry.name: entry,
+  };
+
+  Iterable<VersionPackEntry> get versions =>
+      entries.where((entry) => entry.kind == VersionPackEntryKind.version);
+
+  Iterable<VersionPackEntry> get backups =>
+      entries.where((entry) => entry.kind == VersionPackEntryKind.backup);
+
+  VersionPackEntry? entry(String name) => _byName[name];
+
+  /// 条目在界面和 API 中使用的虚拟路径：`<打包文件>/<条目名称>`
+  String entryPath(VersionPackEntry entry) {
+    return p.joinAll([path, ...entry.name.split('/')]);
+  }
+
+  Map<String, dynamic> toJson() => {
+    'path': path,
+    'name': name,
+    'extension': fileExtension,
+    'createdAt': createdAt.toIso8601String(),
+    'versionCount': versions.length,
+    'backupCount': backups.length,
+    'entries': [for (final entry in entries) entry.toJson()],
+  };
+
+  static bool isPackPath(String filePath) {
+    return p.extension(filePath).toLowerCase() == fileSuffix;
+  }
+
+  /// 只根据路径判断是否指向打包文件中的条目，不访问文件系统
+  static bool isEntryPath(String filePath) {
+    final parent = p.dirname(filePath);
+    return isPackPath(parent) || isPackPath(p.dirname(parent));
+  }
+
+  /// 把虚拟路径拆成打包文件路径和条目名称；不是条目路径时返回 null
+  static (String, String)? splitEntryPath(String filePath) {
+    final normalized = p.normalize(filePath);
+    var packPath = p.dirname(normalized);
+    for (var depth = 0; depth < 2; depth++) {
+      if (isPackPath(packPath)) {
+        final relative = p.relative(normalized, from: packPath);
+        return (packPath, p.split(relative).join('/'));
+      }
+      packPath = p.dirname(packPath);
+    }
+    return null;
+  }
+
+  static Future<VersionPack> open(String packPath) {
+    return Isolate.run(() => openSync(packPath));
+  }
+
+  /// 读取文件尾与索引；格式不对时抛出 [FormatException]
+  static VersionPack openSync(String packPath) {
+    final handle = File(packPath).openSync();
+    try {
+      final length = handle.lengthSync();
+      if (length < headerSize + trailerSize) {
+        throw FormatException('不是版本打包文件', packPath);
+      }
+      final header = handle.readSync(headerSize);
+      if (!_startsWith(header, fileMagic)) {
+        throw FormatException('不是版本打包文件', packPath);
+      }
+
+      handle.setPositionSync(length - trailerSize);
+      final trailer = ByteData.sublistView(handle.readSync(trailerSize));
+      if (!_startsWith(
+        Uint8List.sublistView(trailer, trailerSize - trailerMagic.length),
+        trailerMagic,
+      )) {
+        throw FormatException('打包文件不完整，缺少索引', packPath);
+      }
+      final indexOffset = trailer.getUint64(0, Endian.little);
+      final indexLength = trailer.getUint64(8, Endian.little);
+      final indexHash = trailer.getUint64(16, Endian.little);
+      if (indexOffset < headerSize ||
+          indexLength < 0 ||
+          indexLength > _maxIndexBytes ||
+          indexOffset + indexLength > length - trailerSize) {
+        throw FormatException('打包文件索引位置无效', packPath);
+      }
+
+      handle.setPositionSync(indexOffset);
+      final indexBytes = handle.readSync(indexLength);
+      if (indexBytes.length != indexLength ||
+          Xxh64.hashBytes(indexBytes) != indexHash) {
+        throw FormatException('打包文件索引已损坏', packPath);
+      }
+      final json = jsonDecode(utf8.decode(indexBytes)) as Map<String, dynamic>;
+      if (json['format'] != formatVersion) {
+        throw FormatException('不支持的打包格式版本: ${json['format']}', packPath);
+      }
+
+      final List<VersionPackEntry> entries;
+      try {
+        entries = [
+          for (final item in json['entries'] as List<dynamic>)
+            VersionPackEntry.fromJson(item as Map<String, dynamic>),
+        ];
+      } on TypeError {
+        throw FormatException('打包文件索引格式错误', packPath);
+      } on ArgumentError {
+        throw FormatException('打包文件索引格式错误', packPath);
+      }
+      for (final entry in entries) {
+        if (!_isValidEntry(entry) ||
+            entry.offset < headerSize ||
+            entry.offset + entry.storedSize > indexOffset) {
+          throw FormatException('打包文件条目无效: ${entry.name}', packPath);
+        }
+      }
+      return VersionPack._(
+        path: packPath,
+        name: json['name'] as String,
+        fileExtension: json['extension'] as String,
+        createdAt: DateTime.parse(json['createdAt'] as String),
+        entries: entries,
+      );
+    } finally {
+      handle.closeSync();
+    }
+  }
+
+  /// 读取整个条目并核对校验和，不一致时抛出 [FormatException]
+  Future<Uint8List> read(VersionPackEntry entry) async {
+    final handle = await File(path).open();
+    try {
+      await handle.setPosition(entry.offset);
+      final stored = await handle.read(entry.storedSize);
+      return _verified(entry, stored);
+    } finally {
+      await handle.close();
+    }
+  }
+
+  /// 按偏移流式读取条目内容，供局域网分享直接从打包文件发送。
+  /// 流式读取不核对校验和，需要核对时使用 [read] 或 [extractEntry]
+  Stream<List<int>> openRead(VersionPackEntry entry) {
+    final stored = File(
+      path,
+    ).openRead(entry.offset, entry.offset + entry.storedSize);
+    return entry.compressed ? stored.transform(zlib.decoder) : stored;
+  }
+
+  /// 把条目写到 [targetPath]，核对校验和后再替换，并恢复原来的修改时间
+  Future<void> extractEntry(VersionPackEntry entry, String targetPath) {
+    final packPath = path;
+    return Isolate.run(() => extractEntrySync(packPath, entry, targetPath));
+  }
+
+  /// 解到系统临时目录供外部程序打开，按校验和分目录，已解出的直接复用
+  Future<String> extractToTemp(VersionPackEntry entry) async {
+    final targetPath = p.join(
+      Directory.systemTemp.path,
+      'vertree_pack',
+      entry.hash,
+      entry.name.split('/').last,
+    );
+    final existing = File(targetPath);
+    if (await existing.exists() && await existing.length() == entry.size) {
+      return targetPath;
+    }
+    await existing.parent.create(recursive: true);
+    await extractEntry(entry, targetPath);
+    return targetPath;
+  }
+
+  /// 导出 [versionFilePath] 所在的整个版本家族；[includeBackups] 时一并打包
+  /// 各版本的 `<文件名>_bak` 监控备份目录。先写临时文件，完成后再改名。
+  static Future<VersionPack> exportFamily(
+    String versionFilePath,
+    String packPath, {
+    bool includeBackups = false,
+    bool compress = true,
+  }) {
+    return Isolate.run(
+      () => exportFamilySync(
+        versionFilePath,
+        packPath,
+        includeBackups: includeBackups,
+        compress: compress,
+      ),
+    );
+  }
+
+  static VersionPack exportFamilySync(
+    String versionFilePath,
+    String packPath, {
+    bool includeBackups = false,
+    bool compress = true,
+  }) {
+    if (!FileMeta.isSupportedTreeFilePath(versionFilePath)) {
+      throw FileSystemException('当前文件命名不支持版本树', versionFilePath);
+    }
+    final sources = _collectSources(versionFilePath, includeBackups);
+    if (sources.isEmpty) {
+      throw FileSystemException('没有可以打包的版本文件', versionFilePath);
+    }
+
+    final tempPath = '$packPath.tmp';
+    final handle = File(tempPath).openSync(mode: FileMode.write);
+    final entries = <VersionPackEntry>[];
+    try {
+      handle.writeFromSync(fileMagic);
+      final header = ByteData(8)..setUint32(0, formatVersion, Endian.little);
+      handle.writeFromSync(header.buffer.asUint8List());
+      var position = headerSize;
+
+      for (final (entryName, kind, sourcePath) in sources) {
+        final entry = writeEntrySync(
+          handle,
+          position,
+          entryName,
+          kind,
+          sourcePath,
+          compress: compress,
+        );
+        entries.add(entry);
+        position = entry.offset + entry.storedSize;
+      }
+
+      position = _pad(handle, position, alignment);
+      final createdAt = DateTime.now();
+      final indexBytes = utf8.encode(
+        jsonEncode({
+          'format': formatVersion,
+          'name': FileMeta.nameOf(versionFilePath),
+          'extension': p.extension(versionFilePath).replaceFirst('.', ''),
+          'createdAt': createdAt.toIso8601String(),
+          'entries': [for (final entry in entries) entry.toJson()],
+        }),
+      );
+      handle.writeFromSync(indexBytes);
+
+      final trailer = ByteData(trailerSize)
+        ..setUint64(0, position, Endian.little)
+        ..setUint64(8, indexBytes.length, Endian.little)
+        ..setUint64(16, Xxh64.hashBytes(indexBytes), Endian.little);
+      final trailerBytes = trailer.buffer.asUint8List();
+      trailerBytes.setRange(24, trailerSize, trailerMagic);
+      handle.writeFromSync(trailerBytes);
+      handle.flushSync();
+      handle.closeSync();
+      File(tempPath).renameSync(packPath);
+
+      return VersionPack._(
+        path: packPath,
+        name: FileMeta.nameOf(versionFilePath),
+        fileExtension: p.extension(versionFilePath).replaceFirst('.', ''),
+        createdAt: createdAt,
+        entries: entries,
+      );
+    } catch (_) {
+      try {
+        handle.closeSync();
+      } on FileSystemException {
+        // 已经关闭
+      }
+      final temp = File(tempPath);
+      if (temp.existsSync()) {
+        temp.deleteSync();
+      }
+      rethrow;
+    }
+  }
+
+  /// 导入到 [targetDirectory]（默认打包文件所在目录），还原原来的文件名；
+  /// 不覆盖已有文件。写入的文件同时记入对应的校验清单。
+  static Future<VersionPackImportReport> importPack(
+    String packPath, {
+    String? targetDirectory,
+  }) {
+    return Isolate.run(
+      () => importPackSync(packPath, targetDirectory: targetDirectory),
+    );
+  }
+
+  static VersionPackImportReport importPackSync(
+    String packPath, {
+    String? targetDirectory,
+  }) {
+    final pack = openSync(packPath);
+    final target = p.normalize(targetDirectory ?? p.dirname(packPath));
+    Directory(target).createSync(recursive: true);
+
+    final restored = <String>[];
+    final skipped = <String>[];
+    final conflicts = <String>[];
+    final manifests = <String, List<ChecksumEntry>>{};
+    final shardedDirs = <String>{};
+    var bytesWritten = 0;
+
+    for (final entry in pack.entries) {
+      var targetPath = p.joinAll([target, ...entry.name.split('/')]);
+      var manifestName = p.basename(targetPath);
+      final entryDir = p.dirname(targetPath);
+      if (entry.kind == VersionPackEntryKind.backup &&
+          (SnapshotIndex.isShardedSync(entryDir) ||
+              SnapshotIndex.isMigrationIncompleteSync(entryDir))) {
+        // 导入到已是分片布局（或迁移到一半）的备份目录时直接放进对应的日期
+        // 子目录，最后的迁移顺带把中断的迁移做完
+        shardedDirs.add(entryDir);
+        final createdAt = SnapshotIndex.createdAtFromName(manifestName);
+        if (createdAt != null) {
+          manifestName = SnapshotIndex.shardNameFor(manifestName, createdAt);
+          targetPath = p.joinAll([entryDir, ...manifestName.split('/')]);
+        }
+      }
+      final existing = File(targetPath);
+      if (existing.existsSync()) {
+        if (existing.lengthSync() == entry.size &&
+            _hashFileSync(targetPath) == entry.hash) {
+          skipped.add(entry.name);
+        } else {
+          conflicts.add(entry.name);
+        }
+        continue;
+      }
+
+      Directory(p.dirname(targetPath)).createSync(recursive: true);
+      extractEntrySync(packPath, entry, targetPath);
+      restored.add(entry.name);
+      bytesWritten += entry.size;
+
+      final manifestPath = entry.kind == VersionPackEntryKind.version
+          ? ChecksumManifest.familyManifestPath(targetPath)
+          : ChecksumManifest.backupManifestPath(entryDir);
+      manifests.putIfAbsent(manifestPath, () => []).add(
+        ChecksumEntry(
+          name: manifestName,
+          hash: entry.hash,
+          size: entry.size,
+          modifiedMicros: File(
+            targetPath,
+          ).lastModifiedSync().microsecondsSinceEpoch,
+        ),
+      );
+    }
+
+    for (final MapEntry(key: manifestPath, value: added) in manifests.entries) {
+      try {
+        ChecksumManifest.appendSync(manifestPath, added);
+      } on FileSystemException {
+        // 清单只用于定时校验，写不进去不影响导入结果
+      }
+    }
+    for (final backupDirPath in shardedDirs) {
+      try {
+        // 把新快照记入索引，文件名里没有时间戳的也移入日期子目录
+        SnapshotIndex.migrateSync(backupDirPath);
+      } on FileSystemException {
+        // 与清单一样，索引写不进去不影响导入结果
+      }
+    }
+
+    return VersionPackImportReport(
+      targetDirectory: target,
+      restored: restored,
+      skipped: skipped,
+      conflicts: conflicts,
+      bytesWritten: bytesWritten,
+    );
+  }
+
+  static List<(String, VersionPackEntryKind, String)> _collectSources(
+    String versionFilePath,
+    bool includeBackups,
+  ) {
+    final directory = p.dirname(versionFilePath);
+    final name = FileMeta.nameOf(versionFilePath);
+    final extension = p.extension(versionFilePath);
+
+    final versionPaths =
+        Directory(directory)
+            .listSync()
+            .whereType<File>()
+            .map((file) => file.path)
+            .where(
+              (path) =>
+                  FileMeta.isSupportedTreeFilePath(path) &&
+                  p.extension(path) == extension &&
+                  FileMeta.nameOf(path) == name,
+            )
+            .toList()
+          ..sort(
+            (a, b) => FileMeta.versionOf(a).compareTo(FileMeta.versionOf(b)),
+          );
+
+    final sources = [
+      for (final path in versionPaths)
+        (p.basename(path), VersionPackEntryKind.version, path),
+    ];
+    if (!includeBackups) {
+      return sources;
+    }
+
+    for (final path in versionPaths) {
+      final backupDir = Directory(
+        p.join(directory, '${p.basenameWithoutExtension(path)}_bak'),
+      );
+      if (!backupDir.existsSync()) {
+        continue;
+      }
+      final backupDirName = p.basename(backupDir.path);
+      // 分片布局的快照也按文件名平铺打包，导入后是平铺布局
+      final snapshots = SnapshotIndex.snapshotsSync(backupDir.path)
+        ..sort((a, b) => p.basename(a.name).compareTo(p.basename(b.name)));
+      for (final snapshot in snapshots) {
+        sources.add((
+          '$backupDirName/${p.basename(snapshot.name)}',
+          VersionPackEntryKind.backup,
+          snapshot.pathIn(backupDir.path),
+        ));
+      }
+    }
+    return sources;
+  }
+
+  /// 从 [position] 起（先按需对齐）写入一个条目并返回它的索引项；冷存储
+  /// 打包文件 `ColdPack` 复用同样的条目编码
+  static VersionPackEntry writeEntrySync(
+    RandomAccessFile handle,
+    int position,
+    String entryName,
+    VersionPackEntryKind kind,
+    String sourcePath, {
+    required bool compress,
+  }) {
+    final source = File(sourcePath);
+    final stat = source.statSync();
+    final modifiedMicros = stat.modified.microsecondsSinceEpoch;
+
+    if (compress &&
+        stat.size <= maxCompressBytes &&
+        !incompressibleExtensions.contains(
+          p.extension(sourcePath).toLowerCase(),
+        )) {
+      final bytes = source.readAsBytesSync();
+      final compressed = zlib.encode(bytes);
+      if (compressed.length <= bytes.length - bytes.length ~/ 8) {
+        final offset = _pad(handle, position, alignment);
+        handle.writeFromSync(compressed);
+        return VersionPackEntry(
+          name: entryName,
+          kind: kind,
+          offset: offset,
+          size: bytes.length,
+          storedSize: compressed.length,
+          compressed: true,
+          hash: Xxh64.hexOf(Xxh64.hashBytes(bytes)),
+          modifiedMicros: modifiedMicros,
+        );
+      }
+    }
+
+    final offset = _pad(
+      handle,
+      position,
+      stat.size >= pageAlignedMinBytes ? pageAlignment : alignment,
+    );
+    final input = source.openSync();
+    try {
+      final buffer = Uint8List(_chunkBytes);
+      final hash = Xxh64();
+      while (true) {
+        final read = input.readIntoSync(buffer);
+        if (read == 0) {
+          break;
+        }
+        final chunk = Uint8List.sublistView(buffer, 0, read);
+        hash.addBytes(chunk);
+        handle.writeFromSync(chunk);
+      }
+      return VersionPackEntry(
+        name: entryName,
+        kind: kind,
+        offset: offset,
+        size: hash.length,
+        storedSize: hash.length,
+        compressed: false,
+        hash: hash.toHex(),
+        modifiedMicros: modifiedMicros,
+      );
+    } finally {
+      input.closeSync();
+    }
+  }
+
+  /// 把 [packPath] 中的条目写到 [targetPath]：先写临时文件，核对校验和并
+  /// 恢复修改时间后再改名
+  static void extractEntrySync(
+    String packPath,
+    VersionPackEntry entry,
+    String targetPath,
+  ) {
+    final tempPath = '$targetPath.vtpack-part';
+    final input = File(packPath).openSync();
+    final output = File(tempPath).openSync(mode: FileMode.write);
+    try {
+      input.setPositionSync(entry.offset);
+      if (entry.compressed) {
+        final stored = input.readSync(entry.storedSize);
+        output.writeFromSync(_verified(entry, stored));
+      } else {
+        final buffer = Uint8List(_chunkBytes);
+        final hash = Xxh64();
+        var remaining = entry.storedSize;
+        while (remaining > 0) {
+          final read = input.readIntoSync(
+            buffer,
+            0,
+            remaining < buffer.length ? remaining : buffer.length,
+          );
+          if (read == 0) {
+            break;
+          }
+          final chunk = Uint8List.sublistView(buffer, 0, read);
+          hash.addBytes(chunk);
+          output.writeFromSync(chunk);
+          remaining -= read;
+        }
+        if (remaining != 0 || hash.toHex() != entry.hash) {
+          throw FormatException('打包条目校验失败: ${entry.name}', packPath);
+        }
+      }
+      output.flushSync();
+      output.closeSync();
+      final temp = File(tempPath);
+      temp.setLastModifiedSync(entry.modifiedAt);
+      temp.renameSync(targetPath);
+    } catch (_) {
+      try {
+        output.closeSync();
+      } on FileSystemException {
+        // 已经关闭
+      }
+      final temp = File(tempPath);
+      if (temp.existsSync()) {
+        temp.deleteSync();
+      }
+      rethrow;
+    } finally {
+      input.closeSync();
+    }
+  }
+
+  static Uint8List _verified(VersionPackEntry entry, Uint8List stored) {
+    if (stored.length != entry.storedSize) {
+      throw FormatException('打包条目不完整: ${entry.name}');
+    }
+    final bytes = entry.compressed
+        ? Uint8List.fromList(zlib.decode(stored))
+        : stored;
+    if (bytes.length != entry.size ||
+        Xxh64.hexOf(Xxh64.hashBytes(bytes)) != entry.hash) {
+      throw FormatException('打包条目校验失败: ${entry.name}');
+    }
+    return bytes;
+  }
+
+  static String _hashFileSync(String filePath) {
+    final input = File(filePath).openSync();
+    try {
+      final buffer = Uint8List(_chunkBytes);
+      final hash = Xxh64();
+      while (true) {
+        final read = input.readIntoSync(buffer);
+        if (read == 0) {
+          return hash.toHex();
+        }
+        hash.addBytes(Uint8List.sublistView(buffer, 0, read));
+      }
+    } finally {
+      input.closeSync();
+    }
+  }
+
+  /// 条目名称来自文件内容，导入前确认不会写到目标目录之外
+  static bool _isValidEntry(VersionPackEntry entry) {
+    if (entry.name.contains('\\') ||
+        entry.hash.length != 16 ||
+        entry.size < 0 ||
+        entry.storedSize < 0) {
+      return false;
+    }
+    final segments = entry.name.split('/');
+    if (segments.any(
+      (segment) =>
+          segment.isEmpty ||
+          segment == '.' ||
+          segment == '..' ||
+          segment.contains(':'),
+    )) {
+      return false;
+    }
+    return switch (entry.kind) {
+      VersionPackEntryKind.version =>
+        segments.length == 1 && FileMeta.isSupportedTreeFilePath(entry.name),
+      VersionPackEntryKind.backup =>
+        segments.length == 2 && segments.first.endsWith('_bak'),
+    };
+  }
+
+  static int _pad(RandomAccessFile handle, int position, int boundary) {
+    final aligned = (position + boundary - 1) ~/ boundary * boundary;
+    if (aligned > position) {
+      handle.writeFromSync(Uint8List(aligned - position));
+    }
+    return aligned;
+  }
+
+  static bool _startsWith(List<int> bytes, List<int> prefix) {
+    if (bytes.length < prefix.length) {
+      return false;
+    }
+    for (var i = 0; i < prefix.length; i++) {
+      if (bytes[i] != prefix[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
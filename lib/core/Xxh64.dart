@@ -0,0 +1,130 @@
+import 'dart:typed_data';
+
+/// 流式 XXH64（种子为 0），与 native/src/xxh64.cpp 的结果一致。
+///
+/// 原生库不可用时用它计算校验清单中的哈希。Dart 原生 int 为 64 位，
+/// 加法与乘法按 2^64 回绕，正好符合算法要求；它只用来发现损坏，
+/// 不能防篡改。
+class Xxh64 {
+  static const int _prime1 = -7046029288634856825; // 0x9e3779b185ebca87
+  static const int _prime2 = -4417276706812531889; // 0xc2b2ae3d27d4eb4f
+  static const int _prime3 = 1609587929392839161; // 0x165667b19e3779f9
+  static const int _prime4 = -8796714831421723037; // 0x85ebca77c2b2ae63
+  static const int _prime5 = 2870177450012600261; // 0x27d4eb2f165667c5
+
+  int _v1 = _prime1 + _prime2;
+  int _v2 = _prime2;
+  int _v3 = 0;
+  int _v4 = -_prime1;
+  final Uint8List _buffer = Uint8List(32);
+  late final ByteData _bufferData = ByteData.sublistView(_buffer);
+  int _buffered = 0;
+  int _totalLength = 0;
+
+  int get length => _totalLength;
+
+  void addBytes(List<int> input) {
+    final bytes = input is Uint8List ? input : Uint8List.fromList(input);
+    _totalLength += bytes.length;
+
+    var offset = 0;
+    if (_buffered > 0) {
+      final fill = 32 - _buffered < bytes.length
+          ? 32 - _buffered
+          : bytes.length;
+      _buffer.setRange(_buffered, _buffered + fill, bytes);
+      _buffered += fill;
+      offset = fill;
+      if (_buffered < 32) {
+        return;
+      }
+      _consume(_bufferData, 0, 32);
+      _buffered = 0;
+    }
+
+    final stripesEnd = offset + ((bytes.length - offset) & ~31);
+    if (stripesEnd > offset) {
+      _consume(ByteData.sublistView(bytes), offset, stripesEnd);
+    }
+    _buffered = bytes.length - stripesEnd;
+    _buffer.setRange(0, _buffered, bytes, stripesEnd);
+  }
+
+  /// 当前已加入内容的摘要，不影响继续追加
+  int get value {
+    var hash = _totalLength >= 32
+        ? _rotateLeft(_v1, 1) +
+              _rotateLeft(_v2, 7) +
+              _rotateLeft(_v3, 12) +
+              _rotateLeft(_v4, 18)
+        : _prime5;
+    if (_totalLength >= 32) {
+      hash = _merge(hash, _v1);
+      hash = _merge(hash, _v2);
+      hash = _merge(hash, _v3);
+      hash = _merge(hash, _v4);
+    }
+    hash += _totalLength;
+
+    var offset = 0;
+    while (_buffered - offset >= 8) {
+      hash ^= _round(0, _bufferData.getUint64(offset, Endian.little));
+      hash = _rotateLeft(hash, 27) * _prime1 + _prime4;
+      offset += 8;
+    }
+    if (_buffered - offset >= 4) {
+      hash ^= _bufferData.getUint32(offset, Endian.little) * _prime1;
+      hash = _rotateLeft(hash, 23) * _prime2 + _prime3;
+      offset += 4;
+    }
+    while (offset < _buffered) {
+      hash ^= _buffer[offset] * _prime5;
+      hash = _rotateLeft(hash, 11) * _prime1;
+      offset += 1;
+    }
+
+    hash ^= hash >>> 33;
+    hash *= _prime2;
+    hash ^= hash >>> 29;
+    hash *= _prime3;
+    hash ^= hash >>> 32;
+    return hash;
+  }
+
+  /// 16 位小写十六进制
+  String toHex() => hexOf(value);
+
+  static int hashBytes(List<int> bytes) => (Xxh64()..addBytes(bytes)).value;
+
+  static String hexOf(int hash) {
+    final high = (hash >>> 32).toRadixString(16).padLeft(8, '0');
+    final low = (hash & 0xffffffff).toRadixString(16).padLeft(8, '0');
+    return '$high$low';
+  }
+
+  void _consume(ByteData data, int offset, int end) {
+    var v1 = _v1;
+    var v2 = _v2;
+    var v3 = _v3;
+    var v4 = _v4;
+    for (; offset < end; offset += 32) {
+      v1 = _round(v1, data.getUint64(offset, Endian.little));
+      v2 = _round(v2, data.getUint64(offset + 8, Endian.little));
+      v3 = _round(v3, data.getUint64(offset + 16, Endian.little));
+      v4 = _round(v4, data.getUint64(offset + 24, Endian.little));
+    }
+    _v1 = v1;
+    _v2 = v2;
+    _v3 = v3;
+    _v4 = v4;
+  }
+
+  static int _rotateLeft(int value, int bits) =>
+      (value << bits) | (value >>> (64 - bits));
+
+  static int _round(int lane, int input) =>
+      _rotateLeft(lane + input * _prime2, 31) * _prime1;
+
+  static int _merge(int hash, int lane) =>
+      (hash ^ _round(0, lane)) * _prime1 + _prime4;
+}
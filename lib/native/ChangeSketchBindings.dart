@@ -0,0 +1,86 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+// 与 native/include/vertree_native.h 中的 VtSketch* 一一对应
+
+const int vtSketchCapacity = 256;
+
+final class VtSketchOptions extends Struct {
+  @Int32()
+  external int sketchSize;
+
+  @Int32()
+  external int averageChunkBytes;
+
+  @Int64()
+  external int fullScanBytes;
+
+  @Int64()
+  external int stripeBytes;
+
+  @Int32()
+  external int stripeInterval;
+}
+
+final class VtSketch extends Struct {
+  @Int64()
+  external int fileSize;
+
+  @Int64()
+  external int scannedBytes;
+
+  @Int64()
+  external int chunkCount;
+
+  @Int32()
+  external int hashCount;
+
+  @Int32()
+  external int reserved;
+
+  @Array(vtSketchCapacity)
+  external Array<Uint64> hashes;
+}
+
+class ChangeSketchBindings {
+  ChangeSketchBindings(DynamicLibrary library)
+    : defaultOptions = library
+          .lookupFunction<
+            Void Function(Pointer<VtSketchOptions>),
+            void Function(Pointer<VtSketchOptions>)
+          >('vt_sketch_default_options'),
+      sketchFile = library
+          .lookupFunction<
+            Int32 Function(
+              Pointer<Utf8>,
+              Pointer<VtSketchOptions>,
+              Pointer<VtSketch>,
+            ),
+            int Function(
+              Pointer<Utf8>,
+              Pointer<VtSketchOptions>,
+              Pointer<VtSketch>,
+            )
+          >('vt_sketch_file');
+
+  final void Function(Pointer<VtSketchOptions>) defaultOptions;
+  final int Function(Pointer<Utf8>, Pointer<VtSketchOptions>, Pointer<VtSketch>)
+  sketchFile;
+
+  static ChangeSketchBindings? _instance;
+
+  /// 库不可用时返回 null
+  static ChangeSketchBindings? tryLoad() {
+    final existing = _instance;
+    if (existing != null) {
+      return existing;
+    }
+    final library = VertreeNative.library;
+    if (library == null) {
+      return null;
+    }
+    return _instance = ChangeSketchBindings(library);
+  }
+}
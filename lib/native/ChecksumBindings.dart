@@ -0,0 +1,111 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+// 与 native/include/vertree_native.h 中的 VtChecksum、vt_checksum_file 的
+// 标志位以及 vt_copy_batch 的结构体一一对应
+
+const int vtChecksumLowPriority = 1;
+const int vtChecksumDropCache = 2;
+
+const int vtCopyNoRing = 1;
+
+final class VtChecksum extends Struct {
+  @Uint64()
+  external int hash;
+
+  @Int64()
+  external int size;
+}
+
+final class VtCopyOptions extends Struct {
+  @Int32()
+  external int queueDepth;
+
+  @Int32()
+  external int bufferBytes;
+
+  @Int32()
+  external int threads;
+
+  @Int32()
+  external int flags;
+}
+
+final class VtCopyJob extends Struct {
+  external Pointer<Utf8> sourcePath;
+
+  external Pointer<Utf8> targetPath;
+}
+
+final class VtCopyResult extends Struct {
+  @Int32()
+  external int status;
+
+  @Int32()
+  external int reserved;
+
+  external VtChecksum checksum;
+}
+
+class ChecksumBindings {
+  ChecksumBindings(DynamicLibrary library)
+    : checksumFile = library
+          .lookupFunction<
+            Int32 Function(Pointer<Utf8>, Int32, Pointer<VtChecksum>),
+            int Function(Pointer<Utf8>, int, Pointer<VtChecksum>)
+          >('vt_checksum_file'),
+      copyFile = library
+          .lookupFunction<
+            Int32 Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<VtChecksum>),
+            int Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<VtChecksum>)
+          >('vt_copy_file'),
+      copyDefaultOptions = library
+          .lookupFunction<
+            Void Function(Pointer<VtCopyOptions>),
+            void Function(Pointer<VtCopyOptions>)
+          >('vt_copy_default_options'),
+      copyBatch = library
+          .lookupFunction<
+            Int32 Function(
+              Pointer<VtCopyJob>,
+              Int32,
+              Pointer<VtCopyOptions>,
+              Pointer<VtCopyResult>,
+            ),
+            int Function(
+              Pointer<VtCopyJob>,
+              int,
+              Pointer<VtCopyOptions>,
+              Pointer<VtCopyResult>,
+            )
+          >('vt_copy_batch');
+
+  final int Function(Pointer<Utf8>, int, Pointer<VtChecksum>) checksumFile;
+  final int Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<VtChecksum>)
+  copyFile;
+  final void Function(Pointer<VtCopyOptions>) copyDefaultOptions;
+  final int Function(
+    Pointer<VtCopyJob>,
+    int,
+    Pointer<VtCopyOptions>,
+    Pointer<VtCopyResult>,
+  )
+  copyBatch;
+
+  static ChecksumBindings? _instance;
+
+  /// 库不可用时返回 null
+  static ChecksumBindings? tryLoad() {
+    final existing = _instance;
+    if (existing != null) {
+      return existing;
+    }
+    final library = VertreeNative.library;
+    if (library == null) {
+      return null;
+    }
+    return _instance = ChecksumBindings(library);
+  }
+}
@@ -0,0 +1,166 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+// 与 native/include/vertree_native.h 一一对应
+
+const int vtDiffLineContext = 0;
+const int vtDiffLineRemoved = 1;
+const int vtDiffLineAdded = 2;
+
+final class VtDiff extends Opaque {}
+
+final class VtDiffOptions extends Struct {
+  @Int32()
+  external int contextLines;
+
+  @Int64()
+  external int maxIndexBytes;
+
+  @Int32()
+  external int maxEditCost;
+}
+
+final class VtDiffStats extends Struct {
+  @Int64()
+  external int oldLines;
+
+  @Int64()
+  external int newLines;
+
+  @Int64()
+  external int removedLines;
+
+  @Int64()
+  external int addedLines;
+
+  @Int64()
+  external int hunkCount;
+}
+
+final class VtDiffHunk extends Struct {
+  @Int64()
+  external int oldStart;
+
+  @Int64()
+  external int oldCount;
+
+  @Int64()
+  external int newStart;
+
+  @Int64()
+  external int newCount;
+}
+
+final class VtDiffLine extends Struct {
+  @Int32()
+  external int kind;
+
+  @Int32()
+  external int missingNewline;
+
+  @Int64()
+  external int oldLine;
+
+  @Int64()
+  external int newLine;
+
+  external Pointer<Uint8> text;
+
+  @Int64()
+  external int length;
+}
+
+class LineDiffBindings {
+  LineDiffBindings(DynamicLibrary library)
+    : defaultOptions = library
+          .lookupFunction<
+            Void Function(Pointer<VtDiffOptions>),
+            void Function(Pointer<VtDiffOptions>)
+          >('vt_diff_default_options'),
+      open = library
+          .lookupFunction<
+            Int32 Function(
+              Pointer<Utf8>,
+              Pointer<Utf8>,
+              Pointer<VtDiffOptions>,
+              Pointer<Pointer<VtDiff>>,
+            ),
+            int Function(
+              Pointer<Utf8>,
+              Pointer<Utf8>,
+              Pointer<VtDiffOptions>,
+              Pointer<Pointer<VtDiff>>,
+            )
+          >('vt_diff_open'),
+      stats = library
+          .lookupFunction<
+            Void Function(Pointer<VtDiff>, Pointer<VtDiffStats>),
+            void Function(Pointer<VtDiff>, Pointer<VtDiffStats>)
+          >('vt_diff_stats'),
+      nextHunk = library
+          .lookupFunction<
+            Int32 Function(Pointer<VtDiff>, Pointer<VtDiffHunk>),
+            int Function(Pointer<VtDiff>, Pointer<VtDiffHunk>)
+          >('vt_diff_next_hunk'),
+      nextLine = library
+          .lookupFunction<
+            Int32 Function(Pointer<VtDiff>, Pointer<VtDiffLine>),
+            int Function(Pointer<VtDiff>, Pointer<VtDiffLine>)
+          >('vt_diff_next_line'),
+      readUnified = library
+          .lookupFunction<
+            Int64 Function(Pointer<VtDiff>, Pointer<Uint8>, Int64),
+            int Function(Pointer<VtDiff>, Pointer<Uint8>, int)
+          >('vt_diff_read_unified'),
+      close = library
+          .lookupFunction<
+            Void Function(Pointer<VtDiff>),
+            void Function(Pointer<VtDiff>)
+          >('vt_diff_close');
+
+  final void Function(Pointer<VtDiffOptions>) defaultOptions;
+  final int Function(
+    Pointer<Utf8>,
+    Pointer<Utf8>,
+    Pointer<VtDiffOptions>,
+    Pointer<Pointer<VtDiff>>,
+  )
+  open;
+  final void Function(Pointer<VtDiff>, Pointer<VtDiffStats>) stats;
+  final int Function(Pointer<VtDiff>, Pointer<VtDiffHunk>) nextHunk;
+  final int Function(Pointer<VtDiff>, Pointer<VtDiffLine>) nextLine;
+  final int Function(Pointer<VtDiff>, Pointer<Uint8>, int) readUnified;
+  final void Function(Pointer<VtDiff>) close;
+
+  static LineDiffBindings? _instance;
+
+  /// 库不可用时返回 null
+  static LineDiffBindings? tryLoad() {
+    final existing = _instance;
+    if (existing != null) {
+      return existing;
+    }
+    final library = VertreeNative.library;
+    if (library == null) {
+      return null;
+    }
+    return _instance = LineDiffBindings(library);
+  }
+
+  static String describeStatus(int status) {
+    switch (status) {
+      case vtErrorInvalidArgument:
+        return 'Invalid diff arguments.';
+      case vtErrorIo:
+        return 'Unable to read one of the files.';
+      case vtErrorBinary:
+        return 'Binary files cannot be compared line by line.';
+      case vtErrorTooLarge:
+        return 'The files are too large to compare.';
+      default:
+        return 'Diff failed with status $status.';
+    }
+  }
+}
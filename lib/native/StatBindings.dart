@@ -0,0 +1,72 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+// 与 native/include/vertree_native.h 中的 VtFileStat、vt_stat_batch 的标志位
+// 以及 vt_filesystem_kind 的返回值一一对应
+
+const int vtFsLocal = 0;
+const int vtFsNetwork = 1;
+const int vtFsFuse = 2;
+
+const int vtStatForceSync = 1;
+const int vtStatSequential = 2;
+
+final class VtFileStat extends Struct {
+  @Int32()
+  external int status;
+
+  @Int32()
+  external int reserved;
+
+  @Int64()
+  external int size;
+
+  @Int64()
+  external int modifiedNs;
+
+  @Int64()
+  external int changedNs;
+
+  @Uint64()
+  external int fileId;
+}
+
+class StatBindings {
+  StatBindings(DynamicLibrary library)
+    : filesystemKind = library
+          .lookupFunction<
+            Int32 Function(Pointer<Utf8>),
+            int Function(Pointer<Utf8>)
+          >('vt_filesystem_kind'),
+      statBatch = library
+          .lookupFunction<
+            Int32 Function(
+              Pointer<Pointer<Utf8>>,
+              Int32,
+              Int32,
+              Pointer<VtFileStat>,
+            ),
+            int Function(Pointer<Pointer<Utf8>>, int, int, Pointer<VtFileStat>)
+          >('vt_stat_batch');
+
+  final int Function(Pointer<Utf8>) filesystemKind;
+  final int Function(Pointer<Pointer<Utf8>>, int, int, Pointer<VtFileStat>)
+  statBatch;
+
+  static StatBindings? _instance;
+
+  /// 库不可用时返回 null
+  static StatBindings? tryLoad() {
+    final existing = _instance;
+    if (existing != null) {
+      return existing;
+    }
+    final library = VertreeNative.library;
+    if (library == null) {
+      return null;
+    }
+    return _instance = StatBindings(library);
+  }
+}
@@ -0,0 +1,70 @@
+import 'dart:ffi';
+import 'dart:io';
+
+import 'package:path/path.dart' as p;
+
+// 所有原生入口共用的状态码，与 native/include/vertree_native.h 一致
+const int vtOk = 0;
+const int vtErrorInvalidArgument = -1;
+const int vtErrorIo = -2;
+const int vtErrorBinary = -3;
+const int vtErrorTooLarge = -4;
+const int vtErrorNotFound = -5;
+
+/// 加载随应用打包的 vertree_native 动态库（源码见仓库根目录 native/）。
+///
+/// Linux 安装在 bundle 的 lib/ 下，Windows 与可执行文件放在一起；macOS 暂未打包。
+/// 环境变量 [libraryPathEnvironment] 可以直接指定库文件，开发与测试时用
+/// `cmake -S native` 的构建产物即可。
+class VertreeNative {
+  VertreeNative._();
+
+  static const String libraryPathEnvironment = 'VERTREE_NATIVE_LIBRARY';
+
+  static DynamicLibrary? _library;
+  static bool _attempted = false;
+
+  /// 当前平台没有该库或加载失败时为 null，调用方需要降级处理。
+  /// 每个 isolate 各自加载一次。
+  static DynamicLibrary? get library {
+    if (!_attempted) {
+      _attempted = true;
+      _library = _open();
+    }
+    return _library;
+  }
+
+  static List<String> candidatePaths() {
+    final candidates = <String>[];
+    final override = Platform.environment[libraryPathEnvironment];
+    if (override != null && override.isNotEmpty) {
+      candidates.add(override);
+    }
+
+    final executableDir = p.dirname(Platform.resolvedExecutable);
+    if (Platform.isLinux) {
+      candidates.add(p.join(executableDir, 'lib', 'libvertree_native.so'));
+      candidates.add('libvertree_native.so');
+    } else if (Platform.isWindows) {
+      candidates.add(p.join(executableDir, 'vertree_native.dll'));
+      candidates.add('vertree_native.dll');
+    } else if (Platform.isMacOS) {
+      candidates.add(
+        p.join(executableDir, '..', 'Frameworks', 'libvertree_native.dylib'),
+      );
+      candidates.add('libvertree_native.dylib');
+    }
+    return candidates;
+  }
+
+  static DynamicLibrary? _open() {
+    for (final candidate in candidatePaths()) {
+      try {
+        return DynamicLibrary.open(candidate);
+      } on ArgumentError {
+        continue;
+      }
+    }
+    return null;
+  }
+}
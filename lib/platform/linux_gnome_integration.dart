@@ -70,6 +70,15 @@ class LinuxGnomeIntegration {
         gnomeSessionId != null;
   }
 
+  /// 发行版安装编译版 Files 扩展（linux/nautilus）的位置
+  static const List<String> _nativeExtensionDirs = [
+    '/usr/lib64/nautilus',
+    '/usr/lib/nautilus',
+    '/usr/lib/x86_64-linux-gnu/nautilus',
+    '/usr/lib/aarch64-linux-gnu/nautilus',
+  ];
+  static const String _nativeExtensionFileName = 'libvertree-nautilus.so';
+
   static Directory get _extensionDir => Directory(
     '${Platform.environment['HOME']}/.local/share/nautilus-python/extensions',
   );
@@ -242,11 +251,21 @@ sys.exit(1)
     }
   }
 
+  /// 已安装编译版扩展时，Files 里的菜单、版本标记与状态列都由它提供，
+  /// 菜单项仍读取这里写出的脚本首行的启用列表
+  static bool isNativeExtensionInstalled() {
+    // 只有 GNOME 43 起的 extensions-4 会加载它，其他目录里的文件不算
+    return _nativeExtensionDirs.any(
+      (dir) =>
+          File('$dir/extensions-4/$_nativeExtensionFileName').existsSync(),
+    );
+  }
+
   static Future<bool> isSupported() async {
     if (!Platform.isLinux || !isGnomeSession) {
       return false;
     }
-    return isNautilusPythonAvailable();
+    return isNativeExtensionInstalled() || await isNautilusPythonAvailable();
   }
 
   static Future<GnomeSupportInfo> getFilesMenuSupportInfo() async {
@@ -257,6 +276,15 @@ sys.exit(1)
       );
     }
 
+    if (isNativeExtensionInstalled()) {
+      return const GnomeSupportInfo(
+        status: GnomeSupportStatus.available,
+        message: 'GNOME Files 扩展已安装，右键菜单与版本标记已就绪。',
+        restartCommand: 'nautilus -q',
+        restartCommandLabel: '复制重启 Files 命令',
+      );
+    }
+
     if (await isNautilusPythonAvailable()) {
       return const GnomeSupportInfo(
         status: GnomeSupportStatus.available,
@@ -433,6 +461,7 @@ VERTREE_EXECUTABLE = $executable
 ACTIONS = [
 $actionEntries
 ]
+BATCH_ACTIONS = ("backup", "express-backup", "monit")
 
 
 def _resolve_local_file_path(file_info):
@@ -450,9 +479,9 @@ def _resolve_local_file_path(file_info):
 
 
 class VertreeExtension(GObject.GObject, Nautilus.MenuProvider):
-    def _launch(self, action, path):
+    def _launch(self, action, paths):
         try:
-            command = [VERTREE_EXECUTABLE, path] if not action else [VERTREE_EXECUTABLE, action, path]
+            command = [VERTREE_EXECUTABLE, *paths] if not action else [VERTREE_EXECUTABLE, action, *paths]
             subprocess.Popen(
                 command,
                 start_new_session=True,
@@ -461,17 +490,24 @@ class VertreeExtension(GObject.GObject, Nautilus.MenuProvider):
             pass
 
     def get_file_items(self, *args):
-        files = args[-1] if args else None
-        if not files or len(files) != 1:
+        # 编译版扩展已加载时由它提供菜单
+        if GLib.getenv("VERTREE_NAUTILUS_NATIVE"):
             return
 
-        file_info = files[0]
-        if file_info.is_directory():
+        files = args[-1] if args else None
+        if not files:
             return
 
-        path = _resolve_local_file_path(file_info)
-        if not path:
-            return
+        paths = []
+        for file_info in files:
+            if file_info.is_directory():
+                return
+            path = _resolve_local_file_path(file_info)
+            if not path:
+                return
+            paths.append(path)
+        # 多选时全部路径放在一条命令里，由应用合并为一次批量操作
+        multiple = len(paths) > 1
 
         root = Nautilus.MenuItem(
             name="Vertree::Root",
@@ -482,6 +518,8 @@ class VertreeExtension(GObject.GObject, Nautilus.MenuProvider):
         root.set_submenu(submenu)
 
         for action_key, label, cli_action in ACTIONS:
+            if multiple and cli_action not in BATCH_ACTIONS:
+                continue
             item = Nautilus.MenuItem(
                 name=f"Vertree::{action_key}",
                 label=label,
@@ -489,8 +527,8 @@ class VertreeExtension(GObject.GObject, Nautilus.MenuProvider):
             )
             item.connect(
                 "activate",
-                lambda _item, action=cli_action, file_path=path: self._launch(
-                    action, file_path
+                lambda _item, action=cli_action, file_paths=paths: self._launch(
+                    action, file_paths
                 ),
             )
             submenu.append_item(item)
@@ -0,0 +1,245 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/service/ShellIndexService.dart';
+
+/// GNOME Files 原生扩展（linux/nautilus）与应用之间的 Unix socket 通道。
+///
+/// 扩展在 Files 进程里保持一条长连接：菜单操作作为消息发来，不再为每次点击
+/// 启动一个 vertree 进程；列目录时按目录查询版本数、监控状态和最近备份时间。
+///
+/// 协议按行传输 UTF-8 文本，字段以制表符分隔，字段中的 `\`、制表符和换行
+/// 写作 `\\`、`\t`、`\n`、`\r`：
+///
+/// - 扩展 → 应用：`action <命令行动作> <路径>...`（多选时一条消息带全部
+///   路径）、`query <目录>`
+/// - 应用 → 扩展：`dir <目录> <条数>`，随后每行
+///   `<文件名> <版本数> <是否监控 0/1> <最近备份的 Unix 秒，没有为 0>`；
+///   以及目录状态变化时主动推送的 `changed <目录>`
+class LinuxShellIpcServer {
+  LinuxShellIpcServer({
+    required this.indexService,
+    required this.onAction,
+    this.onLogInfo,
+    this.onLogError,
+    String? socketPath,
+  }) : socketPath = socketPath ?? defaultSocketPath;
+
+  final ShellIndexService indexService;
+
+  /// 收到菜单操作时以命令行参数的形式调用，例如 `['backup', path1, path2]`
+  final void Function(List<String> args) onAction;
+  final void Function(String message)? onLogInfo;
+  final void Function(String message)? onLogError;
+  final String socketPath;
+
+  ServerSocket? _server;
+  StreamSubscription<String>? _changedSubscription;
+  final Set<_ShellClient> _clients = {};
+
+  /// 与扩展中 g_get_user_runtime_dir() 的取值一致
+  static String get defaultSocketPath {
+    final env = Platform.environment;
+    String? base = env['XDG_RUNTIME_DIR'];
+    if (base == null || base.isEmpty) {
+      base = env['XDG_CACHE_HOME'];
+    }
+    if (base == null || base.isEmpty) {
+      base = p.join(env['HOME'] ?? Directory.systemTemp.path, '.cache');
+    }
+    return p.join(base, 'vertree', 'shell.sock');
+  }
+
+  bool get isRunning => _server != null;
+
+  int get clientCount => _clients.length;
+
+  /// 监听 [socketPath]；另一个实例已在监听时返回 false
+  Future<bool> start() async {
+    if (_server != null) {
+      return true;
+    }
+    final address = InternetAddress(
+      socketPath,
+      type: InternetAddressType.unix,
+    );
+    if (await FileSystemEntity.type(socketPath) !=
+        FileSystemEntityType.notFound) {
+      try {
+        final probe = await Socket.connect(address, 0);
+        probe.destroy();
+        onLogInfo?.call('Files 扩展通道已被其他实例占用: $socketPath');
+        return false;
+      } catch (_) {
+        // 上次异常退出留下的 socket 文件
+        await File(socketPath).delete();
+      }
+    }
+    await Directory(p.dirname(socketPath)).create(recursive: true);
+    final server = await ServerSocket.bind(address, 0);
+    _server = server;
+    server.listen(
+      _accept,
+      onError: (Object e) => onLogError?.call('Files 扩展通道出错: $e'),
+    );
+    _changedSubscription = indexService.changedDirectories.listen((dirPath) {
+      final line = 'changed\t${encodeField(dirPath)}\n';
+      for (final client in _clients) {
+        client.write(line);
+      }
+    });
+    onLogInfo?.call('Files 扩展通道已启动: $socketPath');
+    return true;
+  }
+
+  Future<void> stop() async {
+    await _changedSubscription?.cancel();
+    _changedSubscription = null;
+    for (final client in _clients.toList()) {
+      client.socket.destroy();
+    }
+    _clients.clear();
+    final server = _server;
+    _server = null;
+    if (server != null) {
+      await server.close();
+      try {
+        await File(socketPath).delete();
+      } catch (_) {}
+    }
+  }
+
+  void _accept(Socket socket) {
+    final client = _ShellClient(socket);
+    _clients.add(client);
+    // 写入失败在 done 上报告，连接随后由读端的 onDone 清理
+    socket.done.catchError((_) {});
+    socket
+        .cast<List<int>>()
+        .transform(const Utf8Decoder(allowMalformed: true))
+        .transform(const LineSplitter())
+        .listen(
+          (line) => _handle(client, line),
+          onError: (_) => _drop(client),
+          onDone: () => _drop(client),
+          cancelOnError: true,
+        );
+  }
+
+  void _drop(_ShellClient client) {
+    client.closed = true;
+    _clients.remove(client);
+    client.socket.destroy();
+  }
+
+  void _handle(_ShellClient client, String line) {
+    final fields = [for (final field in line.split('\t')) decodeField(field)];
+    switch (fields) {
+      case ['action', final action, ...final paths] when paths.isNotEmpty:
+        onAction([action, ...paths]);
+      case ['query', final dirPath]:
+        // 按收到的顺序逐个回答，扩展可以在一次连接上连续发出多个查询
+        client.tail = client.tail.then((_) => _answer(client, dirPath));
+      default:
+        onLogError?.call('无法识别的 Files 扩展消息: $line');
+    }
+  }
+
+  Future<void> _answer(_ShellClient client, String dirPath) async {
+    final Map<String, ShellFileStatus> entries;
+    try {
+      entries = await indexService.directory(dirPath);
+    } catch (e) {
+      onLogError?.call('查询目录状态失败: $dirPath, $e');
+      client.write('dir\t${encodeField(dirPath)}\t0\n');
+      return;
+    }
+    client.write(encodeDirectory(dirPath, entries));
+  }
+
+  /// 一次目录查询的完整回答
+  static String encodeDirectory(
+    String dirPath,
+    Map<String, ShellFileStatus> entries,
+  ) {
+    final buffer = StringBuffer()
+      ..write('dir\t')
+      ..write(encodeField(dirPath))
+      ..write('\t')
+      ..write(entries.length)
+      ..write('\n');
+    entries.forEach((name, status) {
+      final lastBackup = status.lastBackupAt == null
+          ? 0
+          : status.lastBackupAt!.millisecondsSinceEpoch ~/ 1000;
+      buffer
+        ..write(encodeField(name))
+        ..write('\t')
+        ..write(status.versionCount)
+        ..write('\t')
+        ..write(status.monitored ? 1 : 0)
+        ..write('\t')
+        ..write(lastBackup)
+        ..write('\n');
+    });
+    return buffer.toString();
+  }
+
+  static String encodeField(String value) {
+    if (!value.contains(RegExp('[\\\\\t\n\r]'))) {
+      return value;
+    }
+    return value
+        .replaceAll('\\', '\\\\')
+        .replaceAll('\t', '\\t')
+        .replaceAll('\n', '\\n')
+        .replaceAll('\r', '\\r');
+  }
+
+  static String decodeField(String value) {
+    if (!value.contains('\\')) {
+      return value;
+    }
+    final buffer = StringBuffer();
+    for (var i = 0; i < value.length; i++) {
+      final char = value[i];
+      if (char != '\\' || i + 1 == value.length) {
+        buffer.write(char);
+        continue;
+      }
+      i += 1;
+      switch (value[i]) {
+        case 't':
+          buffer.write('\t');
+        case 'n':
+          buffer.write('\n');
+        case 'r':
+          buffer.write('\r');
+        default:
+          buffer.write(value[i]);
+      }
+    }
+    return buffer.toString();
+  }
+}
+
+class _ShellClient {
+  _ShellClient(this.socket);
+
+  final Socket socket;
+  Future<void> tail = Future<void>.value();
+  bool closed = false;
+
+  void write(String text) {
+    if (closed) {
+      return;
+    }
+    try {
+      socket.add(utf8.encode(text));
+    } catch (_) {
+      closed = true;
+    }
+  }
+}
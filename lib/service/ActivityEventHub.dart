@@ -0,0 +1,168 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:convert';
+
+/// 监控、备份与分享活动事件的类型常量
+class ActivityEventType {
+  static const String fileEventObserved = 'monitor.file-event';
+  static const String monitorStarted = 'monitor.started';
+  static const String monitorStopped = 'monitor.stopped';
+  static const String monitorCatchUpFinished = 'monitor.catch-up-finished';
+  static const String snapshotStarted = 'snapshot.started';
+  static const String snapshotFinished = 'snapshot.finished';
+  static const String snapshotSkipped = 'snapshot.skipped';
+  static const String retentionPruned = 'retention.pruned';
+  static const String retentionPacked = 'retention.packed';
+  static const String shareDownloaded = 'share.downloaded';
+  static const String scrubStarted = 'scrub.started';
+  static const String scrubFinished = 'scrub.finished';
+  static const String coldPackStarted = 'cold-pack.started';
+  static const String coldPackFinished = 'cold-pack.finished';
+  static const String versionCopyProgress = 'version.copy-progress';
+  static const String versionCopyFinished = 'version.copy-finished';
+
+  static const List<String> values = [
+    fileEventObserved,
+    monitorStarted,
+    monitorStopped,
+    monitorCatchUpFinished,
+    snapshotStarted,
+    snapshotFinished,
+    snapshotSkipped,
+    retentionPruned,
+    retentionPacked,
+    shareDownloaded,
+    scrubStarted,
+    scrubFinished,
+    coldPackStarted,
+    coldPackFinished,
+    versionCopyProgress,
+    versionCopyFinished,
+  ];
+}
+
+class ActivityEvent {
+  const ActivityEvent({
+    required this.id,
+    required this.type,
+    required this.occurredAt,
+    required this.data,
+  });
+
+  /// 单调递增的序号，同时作为 SSE 的 `id:` 字段
+  final int id;
+  final String type;
+  final DateTime occurredAt;
+  final Map<String, dynamic> data;
+
+  Map<String, dynamic> toJson() => {
+    'id': id,
+    'type': type,
+    'occurredAt': occurredAt.toIso8601String(),
+    'data': data,
+  };
+
+  /// 按 text/event-stream 格式编码为一帧
+  String toServerSentEvent() {
+    return 'id: $id\nevent: $type\ndata: ${jsonEncode(toJson())}\n\n';
+  }
+}
+
+/// 进程内的活动事件中心。
+///
+/// [emit] 只做入队和环形缓冲写入，真正的分发由异步 broadcast stream 完成，
+/// 因此 Monitor / MonitManager / LanFileShareServer 调用时不会被慢订阅者阻塞。
+class ActivityEventHub {
+  ActivityEventHub({
+    this.replayCapacity = defaultReplayCapacity,
+    DateTime Function()? now,
+  }) : _now = now ?? DateTime.now;
+
+  static const int defaultReplayCapacity = 512;
+
+  final int replayCapacity;
+  final DateTime Function() _now;
+  final Queue<ActivityEvent> _replayBuffer = Queue<ActivityEvent>();
+  final StreamController<ActivityEvent> _controller =
+      StreamController<ActivityEvent>.broadcast();
+
+  int _lastEventId = 0;
+
+  int get lastEventId => _lastEventId;
+  int get bufferedEventCount => _replayBuffer.length;
+  int? get oldestBufferedEventId =>
+      _replayBuffer.isEmpty ? null : _replayBuffer.first.id;
+  Stream<ActivityEvent> get stream => _controller.stream;
+
+  ActivityEvent emit(String type, [Map<String, dynamic> data = const {}]) {
+    _lastEventId += 1;
+    final event = ActivityEvent(
+      id: _lastEventId,
+      type: type,
+      occurredAt: _now(),
+      data: data,
+    );
+
+    _replayBuffer.addLast(event);
+    while (_replayBuffer.length > replayCapacity) {
+      _replayBuffer.removeFirst();
+    }
+
+    if (_controller.hasListener) {
+      _controller.add(event);
+    }
+    return event;
+  }
+
+  /// 返回序号大于 [lastEventId] 的缓冲事件。
+  ///
+  /// 当客户端断开太久、所需事件已被挤出缓冲区时，[isComplete] 为 false，
+  /// 调用方应当重新全量拉取状态。
+  ActivityEventReplay replaySince(int lastEventId, {Set<String>? types}) {
+    if (lastEventId > _lastEventId) {
+      // 序号比当前还大，说明应用重启过，序号已重新开始
+      return ActivityEventReplay(
+        events: _filterBuffered(0, types),
+        isComplete: false,
+      );
+    }
+
+    final oldest = oldestBufferedEventId;
+    final isComplete =
+        lastEventId >= _lastEventId ||
+        oldest == null ||
+        oldest <= lastEventId + 1;
+    return ActivityEventReplay(
+      events: _filterBuffered(lastEventId, types),
+      isComplete: isComplete,
+    );
+  }
+
+  List<ActivityEvent> _filterBuffered(int lastEventId, Set<String>? types) {
+    return _replayBuffer
+        .where((event) => event.id > lastEventId)
+        .where((event) => types == null || types.contains(event.type))
+        .toList(growable: false);
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'lastEventId': _lastEventId,
+      'bufferedEventCount': _replayBuffer.length,
+      'oldestBufferedEventId': oldestBufferedEventId,
+      'replayCapacity': replayCapacity,
+      'hasSubscribers': _controller.hasListener,
+    };
+  }
+
+  Future<void> dispose() async {
+    await _controller.close();
+  }
+}
+
+class ActivityEventReplay {
+  const ActivityEventReplay({required this.events, required this.isComplete});
+
+  final List<ActivityEvent> events;
+  final bool isComplete;
+}
@@ -0,0 +1,322 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:ffi';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:path/path.dart' as p;
+import 'package:path_provider/path_provider.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Fnv1a64.dart';
+import 'package:vertree/native/ChangeSketchBindings.dart';
+import 'package:vertree/native/VertreeNative.dart';
+import 'package:vertree/service/ThumbnailPack.dart';
+
+typedef ChangeSketchComputer = Future<ChangeSketch?> Function(String filePath);
+
+/// 一个版本的相似度草图：内容分块哈希中最小的若干个（见 native/src/change_sketch.h）
+class ChangeSketch {
+  ChangeSketch({
+    required this.fileSize,
+    required this.scannedBytes,
+    required this.chunkCount,
+    required this.hashes,
+  });
+
+  static const int formatVersion = 1;
+  static const int _headerBytes = 32;
+
+  final int fileSize;
+  final int scannedBytes;
+  final int chunkCount;
+
+  /// 升序、互不相同的 63 位哈希
+  final Int64List hashes;
+
+  /// 估算从 [from] 到 [to] 变化的块占比，0 表示内容相同，1 表示没有共同的块。
+  ///
+  /// 两份草图并集中最小的 k 个哈希里，两边都有的占比估计了块集合的
+  /// Jaccard 相似度 J；替换掉比例为 f 的块时 J = (1 - f) / (1 + f)，
+  /// 由此反解出 f。
+  static double estimateChange(ChangeSketch from, ChangeSketch to) {
+    final a = from.hashes;
+    final b = to.hashes;
+    if (a.isEmpty || b.isEmpty) {
+      return a.length == b.length ? 0 : 1;
+    }
+
+    final k = a.length < b.length ? a.length : b.length;
+    var i = 0;
+    var j = 0;
+    var shared = 0;
+    for (var taken = 0; taken < k; taken++) {
+      if (j == b.length || (i < a.length && a[i] < b[j])) {
+        i++;
+      } else if (i == a.length || b[j] < a[i]) {
+        j++;
+      } else {
+        shared++;
+        i++;
+        j++;
+      }
+    }
+    final similarity = shared / k;
+    return (1 - similarity) / (1 + similarity);
+  }
+
+  /// 小端序：`u32 格式版本 | u32 哈希数 | i64 文件大小 | i64 扫描字节数 |
+  /// i64 块数`，随后是哈希
+  Uint8List toBytes() {
+    final data = ByteData(_headerBytes + hashes.length * 8)
+      ..setUint32(0, formatVersion, Endian.little)
+      ..setUint32(4, hashes.length, Endian.little)
+      ..setInt64(8, fileSize, Endian.little)
+      ..setInt64(16, scannedBytes, Endian.little)
+      ..setInt64(24, chunkCount, Endian.little);
+    for (var index = 0; index < hashes.length; index++) {
+      data.setInt64(_headerBytes + index * 8, hashes[index], Endian.little);
+    }
+    return data.buffer.asUint8List();
+  }
+
+  /// 格式不符时返回 null
+  static ChangeSketch? fromBytes(Uint8List bytes) {
+    if (bytes.length < _headerBytes) {
+      return null;
+    }
+    final data = ByteData.sublistView(bytes);
+    final count = data.getUint32(4, Endian.little);
+    if (data.getUint32(0, Endian.little) != formatVersion ||
+        bytes.length != _headerBytes + count * 8) {
+      return null;
+    }
+    return ChangeSketch(
+      fileSize: data.getInt64(8, Endian.little),
+      scannedBytes: data.getInt64(16, Endian.little),
+      chunkCount: data.getInt64(24, Endian.little),
+      hashes: Int64List.fromList([
+        for (var index = 0; index < count; index++)
+          data.getInt64(_headerBytes + index * 8, Endian.little),
+      ]),
+    );
+  }
+}
+
+/// 版本间变化幅度的估算服务。
+///
+/// 对二进制文件（PSD、DWG、XLSX 等）逐行 diff 没有意义，这里用内容分块的
+/// 相似度草图估算父子版本之间变化的比例：
+/// - 草图由原生库在后台 isolate 中流式计算，大文件只按条带抽样读取
+/// - 键由路径、大小与修改时间组成，文件变化后自然失效；结果在内存中按条目数保留，
+///   磁盘上复用 [ThumbnailPack] 的打包格式持久化，每个版本只计算一次
+/// - 同一键的请求共享一个任务，同时运行的任务数受 [maxConcurrentJobs] 限制
+class ChangeSketchService {
+  ChangeSketchService({
+    ChangeSketchComputer? computeSketch,
+    Future<ThumbnailPack?> Function()? openPack,
+    this.maxConcurrentJobs = 2,
+    this.memoryCapacity = 4096,
+  }) : _computeSketch = computeSketch,
+       _openPack = openPack ?? _openDefaultPack;
+
+  final ChangeSketchComputer? _computeSketch;
+  final Future<ThumbnailPack?> Function() _openPack;
+  final int maxConcurrentJobs;
+  final int memoryCapacity;
+
+  final LinkedHashMap<String, ChangeSketch> _memory =
+      LinkedHashMap<String, ChangeSketch>();
+  final Map<String, Future<ChangeSketch?>> _pending = {};
+  final ListQueue<Completer<void>> _waiting = ListQueue<Completer<void>>();
+  Future<ThumbnailPack?>? _pack;
+  int _running = 0;
+  int _computedCount = 0;
+  int _diskHitCount = 0;
+  int _failedCount = 0;
+
+  static Future<ThumbnailPack?> _openDefaultPack() async {
+    final directory = await getApplicationSupportDirectory();
+    final pack = ThumbnailPack(
+      p.join(directory.path, 'sketches', 'sketches.pack'),
+      maxBytes: 16 * 1024 * 1024,
+    );
+    await pack.open();
+    return pack;
+  }
+
+  bool get isAvailable =>
+      _computeSketch != null || ChangeSketchBindings.tryLoad() != null;
+
+  static String cacheKey(String filePath, int fileSize, DateTime modifiedAt) {
+    return Fnv1a64.hashFields([
+      'sketch-v${ChangeSketch.formatVersion}',
+      filePath,
+      fileSize.toString(),
+      modifiedAt.microsecondsSinceEpoch.toString(),
+    ]);
+  }
+
+  /// 同步读取内存中的草图
+  ChangeSketch? peek(FileMeta meta) {
+    final key = cacheKey(meta.fullPath, meta.fileSize, meta.lastModifiedTime);
+    final sketch = _memory.remove(key);
+    if (sketch != null) {
+      _memory[key] = sketch;
+    }
+    return sketch;
+  }
+
+  /// 文件无法读取或原生库不可用时返回 null
+  Future<ChangeSketch?> sketchOf(FileMeta meta) {
+    final cached = peek(meta);
+    if (cached != null) {
+      return Future.value(cached);
+    }
+    if (!isAvailable) {
+      return Future.value(null);
+    }
+    final key = cacheKey(meta.fullPath, meta.fileSize, meta.lastModifiedTime);
+    return _pending.putIfAbsent(
+      key,
+      () => _load(key, meta.fullPath).whenComplete(() => _pending.remove(key)),
+    );
+  }
+
+  /// 估算 [from] 到 [to] 变化的比例（0 ~ 1），任一草图不可用时返回 null
+  Future<double?> estimateChange(FileMeta from, FileMeta to) async {
+    final sketches = await Future.wait([sketchOf(from), sketchOf(to)]);
+    final fromSketch = sketches[0];
+    final toSketch = sketches[1];
+    if (fromSketch == null || toSketch == null) {
+      return null;
+    }
+    return ChangeSketch.estimateChange(fromSketch, toSketch);
+  }
+
+  /// 整棵树每个版本相对父版本的变化比例，以版本文件路径为键；
+  /// 无法估算的版本不在结果中
+  Future<Map<String, double>> estimateTree(FileNode root) async {
+    final nodes = <FileNode>[];
+    final stack = <FileNode>[root];
+    while (stack.isNotEmpty) {
+      final node = stack.removeLast();
+      if (node.parentOrNull != null) {
+        nodes.add(node);
+      }
+      if (node.child != null) {
+        stack.add(node.child!);
+      }
+      stack.addAll(node.branches);
+    }
+
+    final estimates = await Future.wait([
+      for (final node in nodes) estimateChange(node.parent.mate, node.mate),
+    ]);
+    return {
+      for (var index = 0; index < nodes.length; index++)
+        if (estimates[index] != null)
+          nodes[index].mate.fullPath: estimates[index]!,
+    };
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'available': isAvailable,
+      'memoryEntries': _memory.length,
+      'pending': _pending.length,
+      'running': _running,
+      'computed': _computedCount,
+      'diskHits': _diskHitCount,
+      'failed': _failedCount,
+    };
+  }
+
+  Future<ChangeSketch?> _load(String key, String filePath) async {
+    final pack = await (_pack ??= _openPack().catchError((_) => null));
+    final stored = await pack?.read(key);
+    final decoded = stored == null ? null : ChangeSketch.fromBytes(stored);
+    if (decoded != null) {
+      _diskHitCount += 1;
+      _remember(key, decoded);
+      return decoded;
+    }
+
+    await _acquireSlot();
+    ChangeSketch? sketch;
+    try {
+      sketch = await (_computeSketch ?? _computeNative)(filePath);
+    } catch (_) {
+      sketch = null;
+    } finally {
+      _releaseSlot();
+    }
+
+    if (sketch == null) {
+      _failedCount += 1;
+      return null;
+    }
+    _computedCount += 1;
+    _remember(key, sketch);
+    await pack?.write(key, sketch.toBytes());
+    return sketch;
+  }
+
+  Future<void> _acquireSlot() {
+    if (_running < maxConcurrentJobs) {
+      _running += 1;
+      return Future.value();
+    }
+    final waiter = Completer<void>();
+    _waiting.addLast(waiter);
+    return waiter.future;
+  }
+
+  void _releaseSlot() {
+    if (_waiting.isNotEmpty) {
+      // 槽位直接转交给下一个等待者，_running 不变
+      _waiting.removeFirst().complete();
+      return;
+    }
+    _running -= 1;
+  }
+
+  void _remember(String key, ChangeSketch sketch) {
+    _memory.remove(key);
+    _memory[key] = sketch;
+    while (_memory.length > memoryCapacity) {
+      _memory.remove(_memory.keys.first);
+    }
+  }
+
+  static Future<ChangeSketch?> _computeNative(String filePath) {
+    return Isolate.run(() => _sketchSync(filePath));
+  }
+}
+
+ChangeSketch? _sketchSync(String filePath) {
+  final bindings = ChangeSketchBindings.tryLoad();
+  if (bindings == null) {
+    return null;
+  }
+  return using((arena) {
+    final sketch = arena<VtSketch>();
+    final status = bindings.sketchFile(
+      filePath.toNativeUtf8(allocator: arena),
+      nullptr,
+      sketch,
+    );
+    if (status != vtOk) {
+      return null;
+    }
+    final ref = sketch.ref;
+    return ChangeSketch(
+      fileSize: ref.fileSize,
+      scannedBytes: ref.scannedBytes,
+      chunkCount: ref.chunkCount,
+      hashes: Int64List.fromList([
+        for (var index = 0; index < ref.hashCount; index++) ref.hashes[index],
+      ]),
+    );
+  });
+}
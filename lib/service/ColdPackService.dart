@@ -0,0 +1,285 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:isolate';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/ColdPack.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+
+class ColdPackReport {
+  ColdPackReport({
+    required this.trigger,
+    required this.olderThan,
+    required this.startedAt,
+  });
+
+  /// manual 或 scheduled
+  final String trigger;
+
+  /// 早于这个时间的快照被打包
+  final DateTime olderThan;
+  final DateTime startedAt;
+  DateTime? finishedAt;
+  Duration elapsed = Duration.zero;
+
+  int targetCount = 0;
+  final List<ColdPackResult> results = [];
+
+  /// 打包失败的备份目录及原因
+  final Map<String, String> errors = {};
+
+  int get packedCount =>
+      results.fold(0, (sum, result) => sum + result.packedCount);
+
+  int get removedFileCount =>
+      results.fold(0, (sum, result) => sum + result.removedNames.length);
+
+  int get skippedCount =>
+      results.fold(0, (sum, result) => sum + result.skippedCount);
+
+  int get looseBytes =>
+      results.fold(0, (sum, result) => sum + result.looseBytes);
+
+  int get storedBytes =>
+      results.fold(0, (sum, result) => sum + result.storedBytes);
+
+  int get bytesSaved => looseBytes - storedBytes;
+
+  int get inodesSaved =>
+      results.fold(0, (sum, result) => sum + result.inodesSaved);
+
+  Map<String, dynamic> toJson() => {
+    'trigger': trigger,
+    'olderThan': olderThan.toIso8601String(),
+    'startedAt': startedAt.toIso8601String(),
+    'finishedAt': finishedAt?.toIso8601String(),
+    'elapsedMs': elapsed.inMilliseconds,
+    'targetCount': targetCount,
+    'packedCount': packedCount,
+    'removedFileCount': removedFileCount,
+    'skippedCount': skippedCount,
+    'looseBytes': looseBytes,
+    'storedBytes': storedBytes,
+    'bytesSaved': bytesSaved,
+    'inodesSaved': inodesSaved,
+    'directories': [
+      for (final result in results)
+        if (result.removedNames.isNotEmpty || result.skippedCount > 0)
+          result.toJson(),
+    ],
+    'errors': [
+      for (final MapEntry(key: directory, value: message) in errors.entries)
+        {'backupDirPath': directory, 'error': message},
+    ],
+  };
+}
+
+/// 把监控任务中较旧的快照移入冷存储打包文件（见 [ColdPack]），并从中恢复。
+///
+/// - 备份目录逐个在后台 isolate 中打包，同时只有一路，并按
+///   [maxBytesPerSecond] 限速；纯 Dart 读写无法降低 I/O 优先级，靠限速和
+///   单路避免与前台保存、快照抢磁盘
+/// - 打包后在主 isolate 把删除的散文件记入快照索引与校验清单，与监控写索引
+///   走同一个线程
+/// - 已打包的快照照样计入保留策略（monitorMaxSize）；同一备份目录的打包
+///   与监控的清理经 [ColdPack.runLocked] 依次执行，打包用的快照列表在拿到
+///   锁之后才取
+class ColdPackService {
+  ColdPackService({
+    required this.targetsResolver,
+    this.onEvent,
+    this.maxBytesPerSecond = 32 << 20,
+    this.compress = true,
+  });
+
+  /// 未指定范围时要打包的监控任务
+  final Iterable<DiskUsageTarget> Function() targetsResolver;
+  final void Function(String type, Map<String, dynamic> data)? onEvent;
+  final int maxBytesPerSecond;
+  final bool compress;
+
+  ColdPackReport? _current;
+  ColdPackReport? _lastReport;
+  int _targetsDone = 0;
+  Timer? _timer;
+  Duration? _scheduledMinAge;
+
+  bool get isRunning => _current != null;
+  ColdPackReport? get lastReport => _lastReport;
+
+  /// 每隔 [interval] 把早于 [minAge] 的快照打包；[minAge] 为 null 或非正数
+  /// 时关闭
+  void schedule(
+    Duration? minAge, {
+    Duration interval = const Duration(days: 1),
+  }) {
+    _timer?.cancel();
+    _timer = null;
+    _scheduledMinAge = null;
+    if (minAge == null || minAge <= Duration.zero) {
+      return;
+    }
+    _scheduledMinAge = minAge;
+    _timer = Timer.periodic(interval, (_) {
+      if (!isRunning) {
+        pack(minAge: minAge, trigger: 'scheduled');
+      }
+    });
+  }
+
+  void dispose() {
+    _timer?.cancel();
+    _timer = null;
+  }
+
+  /// 已有打包在运行时立即返回错误。[targets] 为 null 时打包
+  /// [targetsResolver] 给出的全部任务
+  Future<Result<ColdPackReport, String>> pack({
+    required Duration minAge,
+    List<DiskUsageTarget>? targets,
+    String trigger = 'manual',
+  }) async {
+    if (isRunning) {
+      return Result.eMsg('Cold packing is already running.');
+    }
+    if (minAge <= Duration.zero) {
+      return Result.eMsg('The minimum snapshot age must be positive.');
+    }
+    final startedAt = DateTime.now();
+    final report = ColdPackReport(
+      trigger: trigger,
+      olderThan: startedAt.subtract(minAge),
+      startedAt: startedAt,
+    );
+    _current = report;
+    _targetsDone = 0;
+    final stopwatch = Stopwatch()..start();
+    try {
+      final unique = <String, DiskUsageTarget>{
+        for (final target in targets ?? targetsResolver())
+          if (target.backupDirPath != null)
+            p.normalize(target.backupDirPath!): target,
+      };
+      report.targetCount = unique.length;
+      onEvent?.call(ActivityEventType.coldPackStarted, {
+        'trigger': trigger,
+        'olderThan': report.olderThan.toIso8601String(),
+        'targetCount': unique.length,
+      });
+
+      final olderThan = report.olderThan;
+      final rate = maxBytesPerSecond;
+      final compress = this.compress;
+      for (final MapEntry(key: backupDirPath, value: target)
+          in unique.entries) {
+        try {
+          if (!await Directory(backupDirPath).exists()) {
+            continue;
+          }
+          final result = await ColdPack.runLocked(backupDirPath, () async {
+            final packed = await Isolate.run(
+              () => ColdPack.packSync(
+                backupDirPath,
+                olderThan: olderThan,
+                maxBytesPerSecond: rate,
+                compress: compress,
+              ),
+            );
+            SnapshotIndex.recordRemovalsSync(
+              backupDirPath,
+              packed.removedNames,
+            );
+            return packed;
+          });
+          report.results.add(result);
+          if (result.removedNames.isNotEmpty) {
+            onEvent?.call(ActivityEventType.retentionPacked, {
+              'filePath': target.filePath,
+              ...result.toJson(),
+            });
+          }
+        } on FileSystemException catch (e) {
+          report.errors[backupDirPath] = '${e.message}: ${e.path}';
+        } finally {
+          _targetsDone += 1;
+        }
+      }
+    } catch (e) {
+      return Result.eMsg('Cold packing failed: $e');
+    } finally {
+      stopwatch.stop();
+      report.elapsed = stopwatch.elapsed;
+      report.finishedAt = DateTime.now();
+      _current = null;
+      _lastReport = report;
+    }
+    onEvent?.call(ActivityEventType.coldPackFinished, {
+      ...report.toJson()..remove('directories'),
+    });
+    return Result.ok(report);
+  }
+
+  /// 把冷存储中的快照 [name]（相对备份目录的路径）解出到 [targetPath]，默认
+  /// 解到系统临时目录，按校验和分目录，已解出的直接复用。不覆盖已有文件。
+  Future<Result<String, String>> restore(
+    String backupDirPath,
+    String name, {
+    String? targetPath,
+  }) async {
+    final cold = await Isolate.run(() => ColdPack.loadSync(backupDirPath));
+    final entry = cold.entries[name];
+    if (entry == null) {
+      return Result.eMsg('Snapshot is not in cold storage: $name');
+    }
+    final target =
+        targetPath ??
+        p.join(
+          Directory.systemTemp.path,
+          'vertree_cold',
+          entry.data.hash,
+          name.split('/').last,
+        );
+    final existing = File(target);
+    if (await existing.exists()) {
+      if (targetPath != null) {
+        return Result.eMsg('Target file already exists: $target');
+      }
+      if (await existing.length() == entry.size) {
+        return Result.ok(target);
+      }
+    }
+    try {
+      await Isolate.run(() {
+        Directory(p.dirname(target)).createSync(recursive: true);
+        cold.extractSync(entry, target);
+      });
+    } on FileSystemException catch (e) {
+      return Result.eMsg('Restoring snapshot failed: ${e.message}');
+    } on FormatException catch (e) {
+      return Result.eMsg('Restoring snapshot failed: ${e.message}');
+    }
+    return Result.ok(target);
+  }
+
+  Map<String, dynamic> status() {
+    final current = _current;
+    return {
+      'running': current != null,
+      'scheduled': _timer != null,
+      'minAgeDays': _scheduledMinAge?.inDays,
+      'maxBytesPerSecond': maxBytesPerSecond,
+      if (current != null)
+        'progress': {
+          'trigger': current.trigger,
+          'startedAt': current.startedAt.toIso8601String(),
+          'targetsDone': _targetsDone,
+          'targetsTotal': current.targetCount,
+          'packedCount': current.packedCount,
+        },
+      'lastReport': _lastReport?.toJson(),
+    };
+  }
+}
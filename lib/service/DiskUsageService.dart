@@ -0,0 +1,721 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as p;
+import 'package:path_provider/path_provider.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/ColdPack.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+
+/// 要统计的一个监控任务：被监控的文件与它的备份目录
+class DiskUsageTarget {
+  const DiskUsageTarget({required this.filePath, this.backupDirPath});
+
+  final String filePath;
+  final String? backupDirPath;
+}
+
+/// 一个快照或版本文件
+class DiskUsageFile {
+  const DiskUsageFile({
+    required this.path,
+    required this.size,
+    required this.modifiedAt,
+  });
+
+  factory DiskUsageFile.fromJson(Map<String, dynamic> json) {
+    return DiskUsageFile(
+      path: json['path'] as String,
+      size: json['size'] as int,
+      modifiedAt: DateTime.parse(json['modifiedAt'] as String),
+    );
+  }
+
+  final String path;
+  final int size;
+  final DateTime modifiedAt;
+
+  Map<String, dynamic> toJson() => {
+    'path': path,
+    'size': size,
+    'modifiedAt': modifiedAt.toIso8601String(),
+  };
+}
+
+/// 一个监控任务的磁盘占用
+class TaskDiskUsage {
+  TaskDiskUsage({
+    required this.filePath,
+    required this.backupDirPath,
+    required this.scannedAt,
+    this.backupBytes = 0,
+    this.snapshotCount = 0,
+    this.packedBytes = 0,
+    this.packedSnapshotCount = 0,
+    this.versionBytes = 0,
+    this.versionCount = 0,
+    this.oldestSnapshotAt,
+    this.newestSnapshotAt,
+    this.bytesAddedLast7Days = 0,
+    this.bytesAddedLast30Days = 0,
+    this.duplicateBytes = 0,
+    this.unhashedBytes = 0,
+    this.compressionSavingsBytes = 0,
+    this.sampledCompressionRatio,
+    this.largestSnapshots = const [],
+    this.error,
+  });
+
+  factory TaskDiskUsage.fromJson(Map<String, dynamic> json) {
+    DateTime? date(String key) {
+      final value = json[key];
+      return value is String ? DateTime.parse(value) : null;
+    }
+
+    return TaskDiskUsage(
+      filePath: json['filePath'] as String,
+      backupDirPath: json['backupDirPath'] as String?,
+      scannedAt: DateTime.parse(json['scannedAt'] as String),
+      backupBytes: json['backupBytes'] as int,
+      snapshotCount: json['snapshotCount'] as int,
+      packedBytes: json['packedBytes'] as int? ?? 0,
+      packedSnapshotCount: json['packedSnapshotCount'] as int? ?? 0,
+      versionBytes: json['versionBytes'] as int,
+      versionCount: json['versionCount'] as int,
+      oldestSnapshotAt: date('oldestSnapshotAt'),
+      newestSnapshotAt: date('newestSnapshotAt'),
+      bytesAddedLast7Days: json['bytesAddedLast7Days'] as int,
+      bytesAddedLast30Days: json['bytesAddedLast30Days'] as int,
+      duplicateBytes: json['duplicateBytes'] as int,
+      unhashedBytes: json['unhashedBytes'] as int,
+      compressionSavingsBytes: json['compressionSavingsBytes'] as int,
+      sampledCompressionRatio: (json['sampledCompressionRatio'] as num?)
+          ?.toDouble(),
+      largestSnapshots: [
+        for (final item in json['largestSnapshots'] as List<dynamic>)
+          DiskUsageFile.fromJson(item as Map<String, dynamic>),
+      ],
+      error: json['error'] as String?,
+    );
+  }
+
+  final String filePath;
+  final String? backupDirPath;
+  final DateTime scannedAt;
+
+  /// `_bak` 目录中快照的总字节数与个数（不含校验清单）
+  final int backupBytes;
+  final int snapshotCount;
+
+  /// 冷存储打包文件（含索引）的字节数与其中的快照个数，不计入上面两项
+  final int packedBytes;
+  final int packedSnapshotCount;
+
+  /// 版本家族（backup / branch 产生的版本文件）的总字节数与个数
+  final int versionBytes;
+  final int versionCount;
+  final DateTime? oldestSnapshotAt;
+  final DateTime? newestSnapshotAt;
+
+  /// 按快照修改时间统计的新增字节，用来估算增长速度
+  final int bytesAddedLast7Days;
+  final int bytesAddedLast30Days;
+
+  /// 内容与另一个快照或版本完全相同的字节数，即去重可以省下的空间。
+  /// 只统计校验清单中记录过哈希的文件，其余计入 [unhashedBytes]
+  final int duplicateBytes;
+  final int unhashedBytes;
+
+  /// 去重后再按抽样压缩率估算的可省字节数
+  final int compressionSavingsBytes;
+
+  /// 抽样文件压缩后与压缩前的字节比，没有可抽样的文件时为 null
+  final double? sampledCompressionRatio;
+  final List<DiskUsageFile> largestSnapshots;
+
+  /// 目录无法读取时的错误信息
+  final String? error;
+
+  int get totalBytes => backupBytes + packedBytes + versionBytes;
+
+  double get growthBytesPerDay => bytesAddedLast7Days / 7;
+
+  Map<String, dynamic> toJson() => {
+    'filePath': filePath,
+    'backupDirPath': backupDirPath,
+    'scannedAt': scannedAt.toIso8601String(),
+    'totalBytes': totalBytes,
+    'backupBytes': backupBytes,
+    'snapshotCount': snapshotCount,
+    'packedBytes': packedBytes,
+    'packedSnapshotCount': packedSnapshotCount,
+    'versionBytes': versionBytes,
+    'versionCount': versionCount,
+    'oldestSnapshotAt': oldestSnapshotAt?.toIso8601String(),
+    'newestSnapshotAt': newestSnapshotAt?.toIso8601String(),
+    'bytesAddedLast7Days': bytesAddedLast7Days,
+    'bytesAddedLast30Days': bytesAddedLast30Days,
+    'growthBytesPerDay': growthBytesPerDay.round(),
+    'duplicateBytes': duplicateBytes,
+    'unhashedBytes': unhashedBytes,
+    'compressionSavingsBytes': compressionSavingsBytes,
+    'sampledCompressionRatio': sampledCompressionRatio,
+    'largestSnapshots': [for (final file in largestSnapshots) file.toJson()],
+    'error': error,
+  };
+}
+
+/// 全部监控任务的占用汇总
+class DiskUsageReport {
+  DiskUsageReport({
+    required this.tasks,
+    required this.history,
+    required this.updatedAt,
+  });
+
+  factory DiskUsageReport.fromJson(Map<String, dynamic> json) {
+    return DiskUsageReport(
+      tasks: [
+        for (final item in json['tasks'] as List<dynamic>)
+          TaskDiskUsage.fromJson(item as Map<String, dynamic>),
+      ],
+      history: [
+        for (final item in json['history'] as List<dynamic>)
+          (
+            DateTime.parse((item as Map<String, dynamic>)['date'] as String),
+            item['totalBytes'] as int,
+          ),
+      ],
+      updatedAt: DateTime.parse(json['updatedAt'] as String),
+    );
+  }
+
+  /// 按文件路径排序
+  final List<TaskDiskUsage> tasks;
+
+  /// 每天一个点的总占用，最多保留 [DiskUsageService.historyDays] 天
+  final List<(DateTime, int)> history;
+  final DateTime updatedAt;
+
+  TaskDiskUsage? taskFor(String filePath) {
+    final normalized = p.normalize(filePath);
+    return tasks.where((task) => task.filePath == normalized).firstOrNull;
+  }
+
+  int get totalBytes => tasks.fold(0, (sum, task) => sum + task.totalBytes);
+
+  int get backupBytes => tasks.fold(0, (sum, task) => sum + task.backupBytes);
+
+  int get snapshotCount =>
+      tasks.fold(0, (sum, task) => sum + task.snapshotCount);
+
+  int get duplicateBytes =>
+      tasks.fold(0, (sum, task) => sum + task.duplicateBytes);
+
+  int get compressionSavingsBytes =>
+      tasks.fold(0, (sum, task) => sum + task.compressionSavingsBytes);
+
+  double get growthBytesPerDay =>
+      tasks.fold(0.0, (sum, task) => sum + task.growthBytesPerDay);
+
+  /// 全部任务中最大的快照
+  List<DiskUsageFile> largestSnapshots([int limit = 20]) {
+    final files = [for (final task in tasks) ...task.largestSnapshots]
+      ..sort((a, b) => b.size.compareTo(a.size));
+    return files.take(limit).toList();
+  }
+
+  Map<String, dynamic> toJson() => {
+    'updatedAt': updatedAt.toIso8601String(),
+    'taskCount': tasks.length,
+    'totalBytes': totalBytes,
+    'backupBytes': backupBytes,
+    'snapshotCount': snapshotCount,
+    'growthBytesPerDay': growthBytesPerDay.round(),
+    'duplicateBytes': duplicateBytes,
+    'compressionSavingsBytes': compressionSavingsBytes,
+    'largestSnapshots': [for (final file in largestSnapshots()) file.toJson()],
+    'tasks': [for (final task in tasks) task.toJson()],
+    'history': [
+      for (final (date, totalBytes) in history)
+        {'date': date.toIso8601String(), 'totalBytes': totalBytes},
+    ],
+  };
+}
+
+/// 统计全部监控任务的 `_bak` 目录与版本家族占用的磁盘空间。
+///
+/// - 每个任务在后台 isolate 中扫描，最多 [concurrency] 个同时进行
+/// - 结果保存在应用数据目录的 `disk_usage.json`，监控页打开时直接显示
+///   上次的结果；快照完成、保留策略清理和新建版本的事件只让对应任务在
+///   [refreshDelay] 后重新扫描
+/// - 去重收益按校验清单中的哈希统计，不重新读取文件；压缩收益对每个任务中
+///   最大的几个文件抽样压缩开头部分，按字节加权推算
+class DiskUsageService {
+  DiskUsageService({
+    required this.targetsResolver,
+    Stream<ActivityEvent>? activityEvents,
+    Stream<String>? createdVersions,
+    Future<String?> Function()? cachePathResolver,
+    int? concurrency,
+    this.refreshDelay = const Duration(seconds: 3),
+    this.largestPerTask = 10,
+    this.compressionSampleFiles = 4,
+    this.compressionSampleBytes = 256 * 1024,
+  }) : _cachePathResolver = cachePathResolver ?? _defaultCachePath,
+       concurrency = concurrency ?? min(4, Platform.numberOfProcessors) {
+    if (activityEvents != null) {
+      _subscriptions.add(activityEvents.listen(_onActivityEvent));
+    }
+    _subscriptions.add(
+      (createdVersions ?? FileNode.createdVersions).listen(_onVersionCreated),
+    );
+  }
+
+  static const int historyDays = 90;
+
+  final Iterable<DiskUsageTarget> Function() targetsResolver;
+  final Future<String?> Function() _cachePathResolver;
+  final int concurrency;
+  final Duration refreshDelay;
+  final int largestPerTask;
+  final int compressionSampleFiles;
+  final int compressionSampleBytes;
+
+  final Map<String, TaskDiskUsage> _tasks = {};
+  final List<(DateTime, int)> _history = [];
+  final Set<String> _dirty = {};
+  final List<StreamSubscription<Object>> _subscriptions = [];
+  final StreamController<DiskUsageReport> _updates =
+      StreamController<DiskUsageReport>.broadcast();
+  Future<void>? _loaded;
+  Future<void> _tail = Future<void>.value();
+  Timer? _refreshTimer;
+  DateTime? _updatedAt;
+  int _pendingRefreshes = 0;
+  int _scanCount = 0;
+
+  /// 每次有任务的统计更新后发出最新的汇总
+  Stream<DiskUsageReport> get updates => _updates.stream;
+
+  /// 有排队或进行中的扫描
+  bool get isScanning => _pendingRefreshes > 0;
+
+  /// 立即返回已有的结果（首次调用时读取磁盘缓存），不触发扫描；
+  /// 从未扫描过时返回 null
+  Future<DiskUsageReport?> cachedReport() async {
+    await (_loaded ??= _loadCache());
+    return _updatedAt == null ? null : _snapshot();
+  }
+
+  /// 重新扫描 [filePaths] 对应的任务，为 null 时扫描全部任务；
+  /// 已不在监控列表中的任务从结果中移除
+  Future<DiskUsageReport> refresh({Iterable<String>? filePaths}) {
+    _pendingRefreshes += 1;
+    return _serialized(() async {
+      final DiskUsageReport report;
+      try {
+        await (_loaded ??= _loadCache());
+        final targets = {
+          for (final target in targetsResolver())
+            p.normalize(target.filePath): target,
+        };
+        _tasks.removeWhere((filePath, _) => !targets.containsKey(filePath));
+        final wanted = filePaths == null
+            ? targets.values.toList()
+            : [
+                for (final filePath in filePaths)
+                  ?targets[p.normalize(filePath)],
+              ];
+        _dirty.removeAll(wanted.map((target) => p.normalize(target.filePath)));
+
+        final results = await _scanAll(wanted);
+        for (final usage in results) {
+          _tasks[usage.filePath] = usage;
+        }
+        _scanCount += 1;
+        _updatedAt = DateTime.now();
+        _recordHistory();
+        report = _snapshot();
+        await _saveCache(report);
+      } finally {
+        // 先减计数再通知，监听者收到结果时 isScanning 已经反映当前状态
+        _pendingRefreshes -= 1;
+      }
+      _updates.add(report);
+      return report;
+    });
+  }
+
+  /// 缓存中有结果就直接返回，否则先完整扫描一次
+  Future<DiskUsageReport> report() async {
+    return await cachedReport() ?? await refresh();
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'scanning': isScanning,
+      'concurrency': concurrency,
+      'taskCount': _tasks.length,
+      'pendingTaskCount': _dirty.length,
+      'scanCount': _scanCount,
+      'updatedAt': _updatedAt?.toIso8601String(),
+    };
+  }
+
+  Future<void> dispose() async {
+    _refreshTimer?.cancel();
+    for (final subscription in _subscriptions) {
+      await subscription.cancel();
+    }
+    await _updates.close();
+  }
+
+  void _onActivityEvent(ActivityEvent event) {
+    if (event.type != ActivityEventType.snapshotFinished &&
+        event.type != ActivityEventType.retentionPruned &&
+        event.type != ActivityEventType.retentionPacked) {
+      return;
+    }
+    final filePath = event.data['filePath'];
+    if (filePath is String) {
+      _markDirty(p.normalize(filePath));
+    }
+  }
+
+  /// backup / branch 新建的版本属于某个任务的版本家族时，重新统计该任务
+  void _onVersionCreated(String versionPath) {
+    final directory = p.dirname(versionPath);
+    final name = FileMeta.nameOf(versionPath);
+    final extension = p.extension(versionPath);
+    for (final filePath in _tasks.keys) {
+      if (p.dirname(filePath) == directory &&
+          p.extension(filePath) == extension &&
+          FileMeta.nameOf(filePath) == name) {
+        _markDirty(filePath);
+      }
+    }
+  }
+
+  void _markDirty(String filePath) {
+    _dirty.add(filePath);
+    _refreshTimer ??= Timer(refreshDelay, () {
+      _refreshTimer = null;
+      final filePaths = _dirty.toList();
+      // 失败时保留旧结果，等下一个事件或手动刷新再扫描
+      unawaited(refresh(filePaths: filePaths).catchError((_) => _snapshot()));
+    });
+  }
+
+  Future<List<TaskDiskUsage>> _scanAll(List<DiskUsageTarget> targets) async {
+    final results = <TaskDiskUsage>[];
+    var next = 0;
+    final options = (
+      largestPerTask,
+      compressionSampleFiles,
+      compressionSampleBytes,
+    );
+    Future<void> worker() async {
+      while (next < targets.length) {
+        final target = targets[next++];
+        final filePath = p.normalize(target.filePath);
+        final backupDirPath = target.backupDirPath;
+        results.add(
+          await Isolate.run(
+            () => scanTaskSync(
+              filePath,
+              backupDirPath,
+              largestPerTask: options.$1,
+              compressionSampleFiles: options.$2,
+              compressionSampleBytes: options.$3,
+            ),
+          ),
+        );
+      }
+    }
+
+    await Future.wait([
+      for (var i = 0; i < min(concurrency, targets.length); i++) worker(),
+    ]);
+    return results;
+  }
+
+  /// 统计一个任务；在后台 isolate 中执行，目录读取失败时记入 error
+  static TaskDiskUsage scanTaskSync(
+    String filePath,
+    String? backupDirPath, {
+    int largestPerTask = 10,
+    int compressionSampleFiles = 4,
+    int compressionSampleBytes = 256 * 1024,
+    DateTime? now,
+  }) {
+    final scannedAt = now ?? DateTime.now();
+    try {
+      final versions = _familyFiles(filePath);
+      final snapshots = backupDirPath == null
+          ? <(String, FileStat)>[]
+          : _backupFiles(backupDirPath);
+
+      final hashes = <String, ChecksumEntry>{
+        ..._manifestEntries(
+          ChecksumManifest.familyManifestPath(filePath),
+          p.dirname(filePath),
+        ),
+        if (backupDirPath != null)
+          ..._manifestEntries(
+            ChecksumManifest.backupManifestPath(backupDirPath),
+            backupDirPath,
+          ),
+      };
+
+      // 按哈希分组，同一内容只算一份
+      final seen = <String>{};
+      final unique = <(String, int)>[];
+      var duplicateBytes = 0;
+      var unhashedBytes = 0;
+      for (final (path, stat) in [...versions, ...snapshots]) {
+        final entry = hashes[path];
+        if (entry == null ||
+            entry.size != stat.size ||
+            entry.modifiedMicros != stat.modified.microsecondsSinceEpoch) {
+          unhashedBytes += stat.size;
+          unique.add((path, stat.size));
+        } else if (!seen.add('${entry.hash}:${entry.size}')) {
+          duplicateBytes += stat.size;
+        } else {
+          unique.add((path, stat.size));
+        }
+      }
+
+      final (ratio, compressionSavings) = _estimateCompression(
+        unique,
+        sampleFiles: compressionSampleFiles,
+        sampleBytes: compressionSampleBytes,
+      );
+
+      final weekAgo = scannedAt.subtract(const Duration(days: 7));
+      final monthAgo = scannedAt.subtract(const Duration(days: 30));
+      var backupBytes = 0;
+      var added7 = 0;
+      var added30 = 0;
+      DateTime? oldest;
+      DateTime? newest;
+      for (final (_, stat) in snapshots) {
+        backupBytes += stat.size;
+        if (stat.modified.isAfter(weekAgo)) {
+          added7 += stat.size;
+        }
+        if (stat.modified.isAfter(monthAgo)) {
+          added30 += stat.size;
+        }
+        if (oldest == null || stat.modified.isBefore(oldest)) {
+          oldest = stat.modified;
+        }
+        if (newest == null || stat.modified.isAfter(newest)) {
+          newest = stat.modified;
+        }
+      }
+
+      final cold = backupDirPath == null
+          ? null
+          : ColdPack.loadSync(backupDirPath);
+
+      final largest = [...snapshots]
+        ..sort((a, b) => b.$2.size.compareTo(a.$2.size));
+      return TaskDiskUsage(
+        filePath: filePath,
+        backupDirPath: backupDirPath,
+        scannedAt: scannedAt,
+        backupBytes: backupBytes,
+        snapshotCount: snapshots.length,
+        packedBytes: cold?.storedBytesSync() ?? 0,
+        packedSnapshotCount: cold?.entries.length ?? 0,
+        versionBytes: versions.fold(0, (sum, file) => sum + file.$2.size),
+        versionCount: versions.length,
+        oldestSnapshotAt: oldest,
+        newestSnapshotAt: newest,
+        bytesAddedLast7Days: added7,
+        bytesAddedLast30Days: added30,
+        duplicateBytes: duplicateBytes,
+        unhashedBytes: unhashedBytes,
+        compressionSavingsBytes: compressionSavings,
+        sampledCompressionRatio: ratio,
+        largestSnapshots: [
+          for (final (path, stat) in largest.take(largestPerTask))
+            DiskUsageFile(
+              path: path,
+              size: stat.size,
+              modifiedAt: stat.modified,
+            ),
+        ],
+      );
+    } on FileSystemException catch (e) {
+      return TaskDiskUsage(
+        filePath: filePath,
+        backupDirPath: backupDirPath,
+        scannedAt: scannedAt,
+        error: '${e.message}: ${e.path}',
+      );
+    }
+  }
+
+  static List<(String, FileStat)> _familyFiles(String filePath) {
+    final directory = Directory(p.dirname(filePath));
+    if (!directory.existsSync() ||
+        !FileMeta.isSupportedTreeFilePath(filePath)) {
+      return [];
+    }
+    final name = FileMeta.nameOf(filePath);
+    final extension = p.extension(filePath);
+    return [
+      for (final entity in directory.listSync(followLinks: false))
+        if (entity is File &&
+            FileMeta.isSupportedTreeFilePath(entity.path) &&
+            p.extension(entity.path) == extension &&
+            FileMeta.nameOf(entity.path) == name)
+          (entity.path, entity.statSync()),
+    ];
+  }
+
+  static List<(String, FileStat)> _backupFiles(String backupDirPath) {
+    final directory = Directory(backupDirPath);
+    if (!directory.existsSync()) {
+      return [];
+    }
+    // 分片布局的快照在日期子目录中
+    return [
+      for (final entity in directory.listSync(
+        recursive: true,
+        followLinks: false,
+      ))
+        if (entity is File && !SnapshotIndex.isMetadataPath(entity.path))
+          (entity.path, entity.statSync()),
+    ];
+  }
+
+  static Map<String, ChecksumEntry> _manifestEntries(
+    String manifestPath,
+    String directory,
+  ) {
+    final manifest = ChecksumManifest.loadSync(manifestPath);
+    return {
+      for (final entry in manifest.entries.values)
+        p.joinAll([directory, ...entry.name.split('/')]): entry,
+    };
+  }
+
+  /// 对最大的几个文件抽样压缩开头部分，按抽样的字节加权压缩率推算全部
+  /// [files] 能省下的字节
+  static (double?, int) _estimateCompression(
+    List<(String, int)> files, {
+    required int sampleFiles,
+    required int sampleBytes,
+  }) {
+    final samples = [...files]..sort((a, b) => b.$2.compareTo(a.$2));
+    var rawBytes = 0;
+    var compressedBytes = 0;
+    for (final (path, size) in samples.take(sampleFiles)) {
+      if (size == 0) {
+        continue;
+      }
+      try {
+        final handle = File(path).openSync();
+        final Uint8List bytes;
+        try {
+          bytes = handle.readSync(sampleBytes);
+        } finally {
+          handle.closeSync();
+        }
+        rawBytes += bytes.length;
+        compressedBytes += min(bytes.length, zlib.encode(bytes).length);
+      } on FileSystemException {
+        // 抽样期间被清理的文件跳过
+      }
+    }
+    if (rawBytes == 0) {
+      return (null, 0);
+    }
+    final ratio = compressedBytes / rawBytes;
+    final total = files.fold(0, (sum, file) => sum + file.$2);
+    return (ratio, (total * (1 - ratio)).round());
+  }
+
+  DiskUsageReport _snapshot() {
+    final tasks = _tasks.values.toList()
+      ..sort((a, b) => a.filePath.compareTo(b.filePath));
+    return DiskUsageReport(
+      tasks: tasks,
+      history: List.unmodifiable(_history),
+      updatedAt: _updatedAt ?? DateTime.now(),
+    );
+  }
+
+  /// 每天保留一个点，当天多次扫描时覆盖
+  void _recordHistory() {
+    final now = DateTime.now();
+    final today = DateTime(now.year, now.month, now.day);
+    final total = _tasks.values.fold(0, (sum, task) => sum + task.totalBytes);
+    if (_history.isNotEmpty && _history.last.$1 == today) {
+      _history.removeLast();
+    }
+    _history.add((today, total));
+    if (_history.length > historyDays) {
+      _history.removeRange(0, _history.length - historyDays);
+    }
+  }
+
+  Future<void> _loadCache() async {
+    try {
+      final cachePath = await _cachePathResolver();
+      if (cachePath == null || !await File(cachePath).exists()) {
+        return;
+      }
+      final report = DiskUsageReport.fromJson(
+        jsonDecode(await File(cachePath).readAsString())
+            as Map<String, dynamic>,
+      );
+      for (final task in report.tasks) {
+        _tasks[task.filePath] = task;
+      }
+      _history
+        ..clear()
+        ..addAll(report.history);
+      _updatedAt = report.updatedAt;
+    } catch (_) {
+      // 缓存损坏或格式变化时当作没有缓存，下次扫描后重写
+    }
+  }
+
+  Future<void> _saveCache(DiskUsageReport report) async {
+    try {
+      final cachePath = await _cachePathResolver();
+      if (cachePath == null) {
+        return;
+      }
+      final file = File(cachePath);
+      await file.parent.create(recursive: true);
+      final temp = File('$cachePath.tmp');
+      await temp.writeAsString(jsonEncode(report.toJson()), flush: true);
+      await temp.rename(cachePath);
+    } on FileSystemException {
+      // 缓存只用于加快显示，写不进去不影响结果
+    }
+  }
+
+  static Future<String?> _defaultCachePath() async {
+    final directory = await getApplicationSupportDirectory();
+    return p.join(directory.path, 'disk_usage.json');
+  }
+
+  Future<T> _serialized<T>(Future<T> Function() action) {
+    final result = _tail.then((_) => action());
+    _tail = result.then<void>((_) {}, onError: (_) {});
+    return result;
+  }
+}
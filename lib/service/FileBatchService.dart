@@ -0,0 +1,215 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:math';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Result.dart';
+
+/// 可以对多选文件一次执行的动作
+enum FileBatchAction {
+  backup('backup'),
+  monit('monit');
+
+  const FileBatchAction(this.token);
+
+  final String token;
+
+  static FileBatchAction? fromToken(String raw) {
+    switch (raw.trim().toLowerCase()) {
+      case 'backup':
+      case 'express-backup':
+      case 'express_backup':
+      case 'expressbackup':
+        return FileBatchAction.backup;
+      case 'monit':
+      case 'monitor':
+        return FileBatchAction.monit;
+    }
+    return null;
+  }
+}
+
+/// 对一个文件执行动作；成功时返回生成的版本文件或备份目录
+typedef FileBatchOperation =
+    Future<Result<String?, String>> Function(String filePath);
+
+/// 以 [label] 备份一个文件，返回生成的版本文件
+typedef FileBackupOperation =
+    Future<Result<String?, String>> Function(String filePath, String? label);
+
+/// 批量动作中一个文件的结果
+class FileBatchItem {
+  const FileBatchItem({
+    required this.path,
+    required this.success,
+    this.output,
+    this.error,
+  });
+
+  final String path;
+  final bool success;
+
+  /// 备份生成的版本文件，或监控任务的备份目录
+  final String? output;
+  final String? error;
+
+  Map<String, dynamic> toJson() => {
+    'path': path,
+    'success': success,
+    if (output != null) 'output': output,
+    if (error != null) 'error': error,
+  };
+}
+
+/// 一次批量动作的汇总，按请求中的路径顺序列出每个文件
+class FileBatchReport {
+  const FileBatchReport({
+    required this.action,
+    required this.items,
+    required this.concurrency,
+    required this.elapsed,
+  });
+
+  final FileBatchAction action;
+  final List<FileBatchItem> items;
+  final int concurrency;
+  final Duration elapsed;
+
+  int get succeededCount => items.where((item) => item.success).length;
+  int get failedCount => items.length - succeededCount;
+
+  FileBatchItem? get firstFailure {
+    for (final item in items) {
+      if (!item.success) return item;
+    }
+    return null;
+  }
+
+  Map<String, dynamic> toJson() => {
+    'action': action.token,
+    'count': items.length,
+    'succeededCount': succeededCount,
+    'failedCount': failedCount,
+    'concurrency': concurrency,
+    'elapsedMs': elapsed.inMilliseconds,
+    'items': [for (final item in items) item.toJson()],
+  };
+}
+
+/// 文件管理器多选、命令行和本地 API 共用的批量动作执行器。
+///
+/// - 路径先去重，不存在的路径和文件夹直接记为失败，不交给动作；
+/// - 同一版本家族的文件（如 `a.0.1.txt` 与 `a.0.2.txt`）在同一队列里依次
+///   执行，避免两次备份同时分配下一个版本号；不同家族最多 [concurrency]
+///   个同时进行；
+/// - 全部完成后 [onFinished] 收到一份汇总，调用方据此只发一条通知。
+class FileBatchService {
+  FileBatchService({
+    required this.backup,
+    required this.monit,
+    this.onFinished,
+    int? concurrency,
+  }) : concurrency = max(
+         1,
+         concurrency ?? min(4, Platform.numberOfProcessors),
+       );
+
+  final FileBackupOperation backup;
+  final FileBatchOperation monit;
+
+  /// 每批结束后调用一次，例如把这一批新增的监控任务合并写入配置
+  final Future<void> Function(FileBatchReport report)? onFinished;
+
+  final int concurrency;
+
+  Future<FileBatchReport> run(
+    FileBatchAction action,
+    Iterable<String> paths, {
+    String? label,
+    int? concurrency,
+  }) async {
+    final stopwatch = Stopwatch()..start();
+    final FileBatchOperation operation = switch (action) {
+      FileBatchAction.backup => (filePath) => backup(filePath, label),
+      FileBatchAction.monit => monit,
+    };
+    final workers = max(1, concurrency ?? this.concurrency);
+
+    final normalized = <String>[];
+    final seen = <String>{};
+    for (final raw in paths) {
+      final filePath = p.normalize(raw);
+      if (seen.add(filePath)) {
+        normalized.add(filePath);
+      }
+    }
+
+    final results = List<FileBatchItem?>.filled(normalized.length, null);
+    final lanes = <String, List<int>>{};
+    for (var i = 0; i < normalized.length; i++) {
+      final filePath = normalized[i];
+      final type = FileSystemEntity.typeSync(filePath);
+      if (type == FileSystemEntityType.notFound) {
+        results[i] = FileBatchItem(
+          path: filePath,
+          success: false,
+          error: 'File does not exist: $filePath',
+        );
+      } else if (type == FileSystemEntityType.directory) {
+        results[i] = FileBatchItem(
+          path: filePath,
+          success: false,
+          error: 'Directories are not supported: $filePath',
+        );
+      } else {
+        (lanes[laneOf(filePath)] ??= []).add(i);
+      }
+    }
+
+    final queue = lanes.values.toList();
+    var next = 0;
+    Future<void> worker() async {
+      while (next < queue.length) {
+        for (final index in queue[next++]) {
+          results[index] = await _runOne(operation, normalized[index]);
+        }
+      }
+    }
+
+    await Future.wait([
+      for (var i = 0; i < min(workers, queue.length); i++) worker(),
+    ]);
+
+    final report = FileBatchReport(
+      action: action,
+      items: results.cast<FileBatchItem>(),
+      concurrency: workers,
+      elapsed: stopwatch.elapsed,
+    );
+    await onFinished?.call(report);
+    return report;
+  }
+
+  /// 同一目录下同一版本家族的文件共用一个队列
+  static String laneOf(String filePath) {
+    return p.join(
+      p.dirname(filePath),
+      '${FileMeta.nameOf(filePath)}${p.extension(filePath)}',
+    );
+  }
+
+  static Future<FileBatchItem> _runOne(
+    FileBatchOperation operation,
+    String filePath,
+  ) async {
+    try {
+      final result = await operation(filePath);
+      return result.isErr
+          ? FileBatchItem(path: filePath, success: false, error: result.msg)
+          : FileBatchItem(path: filePath, success: true, output: result.value);
+    } catch (e) {
+      return FileBatchItem(path: filePath, success: false, error: '$e');
+    }
+  }
+}
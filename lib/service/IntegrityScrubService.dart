@@ -0,0 +1,579 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+
+/// 一份校验清单及其覆盖的文件：版本家族只包括同目录下同名同扩展名的版本，
+/// 备份目录包括目录（含分片布局的日期子目录）中除清单和索引外的全部文件
+class ScrubTarget {
+  const ScrubTarget._({
+    required this.manifestPath,
+    required this.directory,
+    this.familyName,
+    this.familyExtension,
+  });
+
+  factory ScrubTarget.family(String versionFilePath) {
+    final normalized = p.normalize(versionFilePath);
+    return ScrubTarget._(
+      manifestPath: ChecksumManifest.familyManifestPath(normalized),
+      directory: p.dirname(normalized),
+      familyName: FileMeta.nameOf(normalized),
+      familyExtension: p.extension(normalized),
+    );
+  }
+
+  factory ScrubTarget.backupDirectory(String backupDirPath) {
+    final normalized = p.normalize(backupDirPath);
+    return ScrubTarget._(
+      manifestPath: ChecksumManifest.backupManifestPath(normalized),
+      directory: normalized,
+    );
+  }
+
+  /// 文件所在的版本家族与它的监控备份目录（默认 `<名称>_bak`）
+  static List<ScrubTarget> forFile(String filePath, {String? backupDirPath}) {
+    final normalized = p.normalize(filePath);
+    return [
+      ScrubTarget.family(normalized),
+      ScrubTarget.backupDirectory(
+        backupDirPath ??
+            p.join(
+              p.dirname(normalized),
+              '${p.basenameWithoutExtension(normalized)}_bak',
+            ),
+      ),
+    ];
+  }
+
+  final String manifestPath;
+  final String directory;
+  final String? familyName;
+  final String? familyExtension;
+
+  bool get isBackupDirectory => familyName == null;
+
+  bool includes(String filePath) {
+    if (SnapshotIndex.isMetadataPath(filePath)) {
+      return false;
+    }
+    if (familyName == null) {
+      return true;
+    }
+    return FileMeta.isSupportedTreeFilePath(filePath) &&
+        FileMeta.nameOf(filePath) == familyName &&
+        p.extension(filePath) == familyExtension;
+  }
+}
+
+class ScrubStatus {
+  /// 修改时间未变而内容或大小变了：静默损坏或截断
+  static const String corrupted = 'corrupted';
+
+  /// 清单里有、磁盘上没有
+  static const String missing = 'missing';
+
+  /// 读取失败
+  static const String unreadable = 'unreadable';
+}
+
+class ScrubProblem {
+  const ScrubProblem({
+    required this.path,
+    required this.status,
+    this.expectedHash,
+    this.actualHash,
+    this.expectedSize,
+    this.actualSize,
+    this.detail,
+  });
+
+  final String path;
+  final String status;
+  final String? expectedHash;
+  final String? actualHash;
+  final int? expectedSize;
+  final int? actualSize;
+  final String? detail;
+
+  Map<String, dynamic> toJson() => {
+    'path': path,
+    'status': status,
+    'expectedHash': expectedHash,
+    'actualHash': actualHash,
+    'expectedSize': expectedSize,
+    'actualSize': actualSize,
+    'detail': detail,
+  };
+}
+
+class IntegrityScrubReport {
+  IntegrityScrubReport({
+    required this.trigger,
+    required this.lowPriority,
+    required this.startedAt,
+  });
+
+  /// manual 或 scheduled
+  final String trigger;
+  final bool lowPriority;
+  final DateTime startedAt;
+  DateTime? finishedAt;
+  Duration elapsed = Duration.zero;
+
+  int targetCount = 0;
+  int fileCount = 0;
+  int bytesRead = 0;
+
+  /// 与清单一致
+  int verifiedCount = 0;
+
+  /// 修改时间变过，按新内容更新了记录
+  int updatedCount = 0;
+
+  /// 清单里原本没有，已补记
+  int recordedCount = 0;
+  int corruptedCount = 0;
+  int missingCount = 0;
+  int unreadableCount = 0;
+
+  /// 按 dropMissing 从清单中移除的记录数
+  int droppedCount = 0;
+  final List<ScrubProblem> problems = [];
+  bool problemsTruncated = false;
+
+  int get problemCount => corruptedCount + missingCount + unreadableCount;
+
+  double get throughputMBps {
+    final seconds = elapsed.inMicroseconds / 1000000;
+    return seconds <= 0 ? 0 : bytesRead / 1048576 / seconds;
+  }
+
+  Map<String, dynamic> toJson() => {
+    'trigger': trigger,
+    'lowPriority': lowPriority,
+    'startedAt': startedAt.toIso8601String(),
+    'finishedAt': finishedAt?.toIso8601String(),
+    'elapsedMs': elapsed.inMilliseconds,
+    'targetCount': targetCount,
+    'fileCount': fileCount,
+    'bytesRead': bytesRead,
+    'throughputMBps': double.parse(throughputMBps.toStringAsFixed(1)),
+    'verifiedCount': verifiedCount,
+    'updatedCount': updatedCount,
+    'recordedCount': recordedCount,
+    'corruptedCount': corruptedCount,
+    'missingCount': missingCount,
+    'unreadableCount': unreadableCount,
+    'droppedCount': droppedCount,
+    'problemCount': problemCount,
+    'problems': problems.map((problem) => problem.toJson()).toList(),
+    'problemsTruncated': problemsTruncated,
+  };
+}
+
+/// 按校验清单重新读取版本与监控快照，找出损坏、截断和丢失的文件。
+///
+/// - 文件按字节数分批交给后台 isolate，最多 [concurrency] 批同时读取；
+///   读取本身顺序进行，几路并行足以让 SSD 跑满，又不会把机械盘读成随机访问
+/// - 定时执行时只用一路，并降低 I/O 优先级、读完移出页缓存
+/// - 修改时间变过的文件视为用户的正常修改，只更新记录；清单里没有的文件
+///   （启用清单之前的版本）补记为基线
+class IntegrityScrubService {
+  IntegrityScrubService({
+    required this.targetsResolver,
+    this.onEvent,
+    int? concurrency,
+    this.batchBytes = 64 << 20,
+    this.batchFiles = 256,
+    this.maxProblems = 500,
+  }) : concurrency = concurrency ?? min(4, Platform.numberOfProcessors);
+
+  /// 未指定范围时要校验的目标，通常是全部监控任务
+  final Iterable<ScrubTarget> Function() targetsResolver;
+  final void Function(String type, Map<String, dynamic> data)? onEvent;
+  final int concurrency;
+  final int batchBytes;
+  final int batchFiles;
+  final int maxProblems;
+
+  IntegrityScrubReport? _current;
+  IntegrityScrubReport? _lastReport;
+  int _filesDone = 0;
+  int _filesTotal = 0;
+  Timer? _timer;
+
+  bool get isRunning => _current != null;
+  IntegrityScrubReport? get lastReport => _lastReport;
+
+  /// 按 [interval] 定时执行低优先级校验；null 或非正数时关闭
+  void schedule(Duration? interval) {
+    _timer?.cancel();
+    _timer = null;
+    if (interval == null || interval <= Duration.zero) {
+      return;
+    }
+    _timer = Timer.periodic(interval, (_) {
+      if (!isRunning) {
+        scrub(lowPriority: true, trigger: 'scheduled');
+      }
+    });
+  }
+
+  void dispose() {
+    _timer?.cancel();
+    _timer = null;
+  }
+
+  /// 已有校验在运行时立即返回错误。[targets] 为 null 时校验 [targetsResolver]
+  /// 给出的目标；[dropMissing] 为 true 时把丢失的文件从清单中移除。
+  Future<Result<IntegrityScrubReport, String>> scrub({
+    List<ScrubTarget>? targets,
+    bool lowPriority = false,
+    bool dropMissing = false,
+    String trigger = 'manual',
+  }) async {
+    if (isRunning) {
+      return Result.eMsg('An integrity scrub is already running.');
+    }
+    final report = IntegrityScrubReport(
+      trigger: trigger,
+      lowPriority: lowPriority,
+      startedAt: DateTime.now(),
+    );
+    _current = report;
+    _filesDone = 0;
+    _filesTotal = 0;
+    final stopwatch = Stopwatch()..start();
+    try {
+      final unique = <String, ScrubTarget>{
+        for (final target in targets ?? targetsResolver())
+          target.manifestPath: target,
+      };
+      report.targetCount = unique.length;
+      onEvent?.call(ActivityEventType.scrubStarted, {
+        'trigger': trigger,
+        'lowPriority': lowPriority,
+        'targetCount': unique.length,
+      });
+
+      final plans = <_TargetPlan>[];
+      for (final target in unique.values) {
+        plans.add(await _plan(target, report));
+      }
+      final jobs = [for (final plan in plans) ...plan.jobs];
+      _filesTotal = jobs.length;
+      await _checksumAll(jobs, lowPriority: lowPriority, report: report);
+      for (final plan in plans) {
+        _apply(plan, report, dropMissing: dropMissing);
+      }
+    } catch (e) {
+      return Result.eMsg('Integrity scrub failed: $e');
+    } finally {
+      stopwatch.stop();
+      report.elapsed = stopwatch.elapsed;
+      report.finishedAt = DateTime.now();
+      _current = null;
+      _lastReport = report;
+    }
+    onEvent?.call(ActivityEventType.scrubFinished, {
+      ...report.toJson()..remove('problems'),
+    });
+    return Result.ok(report);
+  }
+
+  Map<String, dynamic> status() {
+    final current = _current;
+    return {
+      'running': current != null,
+      'concurrency': concurrency,
+      'scheduled': _timer != null,
+      if (current != null)
+        'progress': {
+          'trigger': current.trigger,
+          'startedAt': current.startedAt.toIso8601String(),
+          'filesDone': _filesDone,
+          'filesTotal': _filesTotal,
+          'bytesRead': current.bytesRead,
+        },
+      'lastReport': _lastReport?.toJson(),
+    };
+  }
+
+  Future<_TargetPlan> _plan(
+    ScrubTarget target,
+    IntegrityScrubReport report,
+  ) async {
+    final manifest = ChecksumManifest.loadSync(target.manifestPath);
+    final plan = _TargetPlan(target, manifest);
+    final directory = Directory(target.directory);
+    if (!await directory.exists()) {
+      plan.missing.addAll(manifest.entries.values);
+      return plan;
+    }
+
+    final present = <String>{};
+    final List<FileSystemEntity> entities;
+    try {
+      entities = await directory
+          .list(recursive: target.isBackupDirectory, followLinks: false)
+          .toList();
+    } on FileSystemException catch (e) {
+      report.unreadableCount += 1;
+      _addProblem(
+        report,
+        ScrubProblem(
+          path: target.directory,
+          status: ScrubStatus.unreadable,
+          detail: e.message,
+        ),
+      );
+      return plan;
+    }
+    for (final entity in entities) {
+      if (entity is! File || !target.includes(entity.path)) {
+        continue;
+      }
+      final stat = await entity.stat();
+      if (stat.type == FileSystemEntityType.notFound) {
+        continue;
+      }
+      // 清单中分片备份目录的快照以相对路径记录
+      final name = target.isBackupDirectory
+          ? p
+                .relative(entity.path, from: target.directory)
+                .replaceAll(r'\', '/')
+          : p.basename(entity.path);
+      present.add(name);
+      final entry = manifest.entries[name];
+      final modifiedMicros = stat.modified.microsecondsSinceEpoch;
+      report.fileCount += 1;
+      if (entry != null &&
+          entry.modifiedMicros == modifiedMicros &&
+          entry.size != stat.size) {
+        // 截断或被填充，不必读内容
+        _addProblem(
+          report,
+          ScrubProblem(
+            path: entity.path,
+            status: ScrubStatus.corrupted,
+            expectedHash: entry.hash,
+            expectedSize: entry.size,
+            actualSize: stat.size,
+          ),
+        );
+        report.corruptedCount += 1;
+        continue;
+      }
+      plan.jobs.add(
+        _ScrubJob(
+          path: entity.path,
+          size: stat.size,
+          modifiedMicros: modifiedMicros,
+          expected: entry,
+        ),
+      );
+    }
+    for (final entry in manifest.entries.values) {
+      if (!present.contains(entry.name)) {
+        plan.missing.add(entry);
+      }
+    }
+    return plan;
+  }
+
+  Future<void> _checksumAll(
+    List<_ScrubJob> jobs, {
+    required bool lowPriority,
+    required IntegrityScrubReport report,
+  }) async {
+    final batches = <List<_ScrubJob>>[];
+    var batch = <_ScrubJob>[];
+    var bytes = 0;
+    for (final job in jobs) {
+      if (batch.isNotEmpty &&
+          (bytes + job.size > batchBytes || batch.length >= batchFiles)) {
+        batches.add(batch);
+        batch = [];
+        bytes = 0;
+      }
+      batch.add(job);
+      bytes += job.size;
+    }
+    if (batch.isNotEmpty) {
+      batches.add(batch);
+    }
+
+    var next = 0;
+    Future<void> worker() async {
+      while (next < batches.length) {
+        final current = batches[next++];
+        final paths = [for (final job in current) job.path];
+        final results = await Isolate.run(
+          () => _checksumBatch(paths, lowPriority),
+        );
+        for (var index = 0; index < current.length; index++) {
+          final result = results[index];
+          if (result is FileChecksum) {
+            current[index].checksum = result;
+            report.bytesRead += result.size;
+          } else {
+            current[index].error = result.toString();
+          }
+        }
+        _filesDone += current.length;
+      }
+    }
+
+    final workers = lowPriority ? 1 : max(1, concurrency);
+    await Future.wait([for (var i = 0; i < workers; i++) worker()]);
+  }
+
+  void _apply(
+    _TargetPlan plan,
+    IntegrityScrubReport report, {
+    required bool dropMissing,
+  }) {
+    final updates = <ChecksumEntry>[];
+    for (final job in plan.jobs) {
+      final checksum = job.checksum;
+      final expected = job.expected;
+      if (checksum == null) {
+        report.unreadableCount += 1;
+        _addProblem(
+          report,
+          ScrubProblem(
+            path: job.path,
+            status: ScrubStatus.unreadable,
+            expectedHash: expected?.hash,
+            detail: job.error,
+          ),
+        );
+        continue;
+      }
+      final entry = ChecksumEntry(
+        name: p.basename(job.path),
+        hash: checksum.hex,
+        size: checksum.size,
+        modifiedMicros: job.modifiedMicros,
+      );
+      if (expected == null) {
+        report.recordedCount += 1;
+        updates.add(entry);
+      } else if (expected.modifiedMicros != job.modifiedMicros) {
+        report.updatedCount += 1;
+        updates.add(entry);
+      } else if (expected.hash == entry.hash && expected.size == entry.size) {
+        report.verifiedCount += 1;
+      } else {
+        report.corruptedCount += 1;
+        _addProblem(
+          report,
+          ScrubProblem(
+            path: job.path,
+            status: ScrubStatus.corrupted,
+            expectedHash: expected.hash,
+            actualHash: entry.hash,
+            expectedSize: expected.size,
+            actualSize: entry.size,
+          ),
+        );
+      }
+    }
+
+    for (final entry in plan.missing) {
+      report.missingCount += 1;
+      _addProblem(
+        report,
+        ScrubProblem(
+          path: p.joinAll([plan.target.directory, ...entry.name.split('/')]),
+          status: ScrubStatus.missing,
+          expectedHash: entry.hash,
+          expectedSize: entry.size,
+        ),
+      );
+    }
+
+    final removals = dropMissing
+        ? [for (final entry in plan.missing) entry.name]
+        : const <String>[];
+    if (updates.isEmpty && removals.isEmpty) {
+      return;
+    }
+    if (!Directory(plan.target.directory).existsSync()) {
+      return;
+    }
+    try {
+      ChecksumManifest.appendSync(plan.target.manifestPath, updates);
+      ChecksumManifest.appendRemovalsSync(plan.target.manifestPath, removals);
+      report.droppedCount += removals.length;
+      final reloaded = ChecksumManifest.loadSync(plan.target.manifestPath);
+      if (reloaded.needsCompaction) {
+        reloaded.compactSync();
+      }
+    } on FileSystemException catch (e) {
+      _addProblem(
+        report,
+        ScrubProblem(
+          path: plan.target.manifestPath,
+          status: ScrubStatus.unreadable,
+          detail: e.message,
+        ),
+      );
+    }
+  }
+
+  void _addProblem(IntegrityScrubReport report, ScrubProblem problem) {
+    if (report.problems.length < maxProblems) {
+      report.problems.add(problem);
+    } else {
+      report.problemsTruncated = true;
+    }
+  }
+}
+
+class _ScrubJob {
+  _ScrubJob({
+    required this.path,
+    required this.size,
+    required this.modifiedMicros,
+    required this.expected,
+  });
+
+  final String path;
+  final int size;
+  final int modifiedMicros;
+  final ChecksumEntry? expected;
+  FileChecksum? checksum;
+  String? error;
+}
+
+class _TargetPlan {
+  _TargetPlan(this.target, this.manifest);
+
+  final ScrubTarget target;
+  final ChecksumManifest manifest;
+  final List<_ScrubJob> jobs = [];
+  final List<ChecksumEntry> missing = [];
+}
+
+/// 在后台 isolate 中依次读取一批文件；每个位置是 [FileChecksum] 或错误信息
+List<Object> _checksumBatch(List<String> paths, bool lowPriority) {
+  final results = <Object>[];
+  for (final path in paths) {
+    try {
+      results.add(FileChecksum.ofFileSync(path, lowPriority: lowPriority));
+    } on FileSystemException catch (e) {
+      results.add(e.message);
+    }
+  }
+  return results;
+}
@@ -7,6 +7,7 @@ import 'dart:math';
 
 import 'package:path/path.dart' as p;
 import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/VersionPack.dart';
 import 'package:vertree/service/LanSharePayloadCodec.dart';
 
 class LanFileShareServer {
@@ -16,10 +17,12 @@ class LanFileShareServer {
     Future<String?> Function()? wifiNameResolver,
     void Function(String message)? onLogInfo,
     void Function(String message)? onLogError,
+    void Function(Map<String, dynamic> download)? onShareDownloaded,
   }) : _addressResolver = addressResolver ?? _discoverLanIpv4Addresses,
        _wifiNameResolver = wifiNameResolver ?? _discoverWifiName,
        _onLogInfo = onLogInfo,
-       _onLogError = onLogError {
+       _onLogError = onLogError,
+       _onShareDownloaded = onShareDownloaded {
     _cleanupTimer = Timer.periodic(
       const Duration(minutes: 1),
       (_) => _purgeExpiredShares(),
@@ -37,6 +40,7 @@ class LanFileShareServer {
   final Future<String?> Function() _wifiNameResolver;
   final void Function(String message)? _onLogInfo;
   final void Function(String message)? _onLogError;
+  final void Function(Map<String, dynamic> download)? _onShareDownloaded;
 
   late final Timer _cleanupTimer;
   final Map<String, _LanFileShareEntry> _sharesByToken =
@@ -127,8 +131,22 @@ class LanFileShareServer {
 
     final normalizedPath = p.normalize(filePath);
     final file = File(normalizedPath);
+    VersionPack? pack;
+    VersionPackEntry? packEntry;
     if (!file.existsSync()) {
-      return Result.eMsg('File does not exist: $normalizedPath');
+      // 打包文件中的版本直接按偏移发送，不需要先解压
+      final parts = VersionPack.splitEntryPath(normalizedPath);
+      if (parts != null && File(parts.$1).existsSync()) {
+        try {
+          pack = await VersionPack.open(parts.$1);
+          packEntry = pack.entry(parts.$2);
+        } on FormatException catch (e) {
+          return Result.eMsg('Invalid version pack: ${e.message}');
+        }
+      }
+      if (packEntry == null) {
+        return Result.eMsg('File does not exist: $normalizedPath');
+      }
     }
 
     await start();
@@ -140,16 +158,17 @@ class LanFileShareServer {
       );
     }
 
-    final stat = file.statSync();
     final now = DateTime.now();
     final entry = _LanFileShareEntry(
       shareKey: _generateShareKey(),
       token: _generateToken(),
       filePath: normalizedPath,
       fileName: p.basename(normalizedPath),
-      fileSize: stat.size,
+      fileSize: packEntry?.size ?? file.statSync().size,
       createdAt: now,
       expiresAt: now.add(Duration(minutes: expiresInMinutes)),
+      pack: pack,
+      packEntry: packEntry,
     );
     _sharesByToken[entry.token] = entry;
     _sharesByKey[entry.shareKey] = entry;
@@ -415,8 +434,7 @@ class LanFileShareServer {
       return;
     }
 
-    final file = File(entry.filePath);
-    if (!file.existsSync()) {
+    if (!entry.sourceExists) {
       _removeShare(entry);
       await _writeText(
         request,
@@ -436,16 +454,18 @@ class LanFileShareServer {
       return;
     }
 
-    final stat = file.statSync();
     request.response.statusCode = HttpStatus.ok;
     _setCommonHeaders(request.response);
     request.response.headers.contentType = contentType;
-    request.response.headers.set(HttpHeaders.contentLengthHeader, stat.size);
+    request.response.headers.set(
+      HttpHeaders.contentLengthHeader,
+      entry.currentSize,
+    );
     request.response.headers.set(
       'content-disposition',
       'inline; filename="${entry.fileName.replaceAll('"', '')}"',
     );
-    await file.openRead().pipe(request.response);
+    await entry.openRead().pipe(request.response);
   }
 
   Future<void> _handleDownload(HttpRequest request, String token) async {
@@ -459,8 +479,7 @@ class LanFileShareServer {
       return;
     }
 
-    final file = File(entry.filePath);
-    if (!file.existsSync()) {
+    if (!entry.sourceExists) {
       _removeShare(entry);
       await _writeText(
         request,
@@ -470,19 +489,52 @@ class LanFileShareServer {
       return;
     }
 
-    final stat = file.statSync();
+    final size = entry.currentSize;
     request.response.statusCode = HttpStatus.ok;
     _setCommonHeaders(request.response);
     request.response.headers.contentType = ContentType.binary;
-    request.response.headers.set(HttpHeaders.contentLengthHeader, stat.size);
+    request.response.headers.set(HttpHeaders.contentLengthHeader, size);
     request.response.headers.set(
       'content-disposition',
       _contentDisposition(entry.fileName),
     );
-    await file.openRead().pipe(request.response);
+    final stopwatch = Stopwatch()..start();
+    await entry.openRead().pipe(request.response);
 
     entry.downloadCount += 1;
     entry.lastDownloadedAt = DateTime.now();
+    _notifyShareDownloaded(
+      entry,
+      remoteAddress: request.connectionInfo?.remoteAddress.address,
+      bytes: size,
+      durationMs: stopwatch.elapsedMilliseconds,
+    );
+  }
+
+  void _notifyShareDownloaded(
+    _LanFileShareEntry entry, {
+    required String? remoteAddress,
+    required int bytes,
+    required int durationMs,
+  }) {
+    final callback = _onShareDownloaded;
+    if (callback == null) {
+      return;
+    }
+    try {
+      callback({
+        'shareKey': entry.shareKey,
+        'fileName': entry.fileName,
+        'filePath': entry.filePath,
+        'bytes': bytes,
+        'durationMs': durationMs,
+        'downloadCount': entry.downloadCount,
+        'remoteAddress': remoteAddress,
+        'downloadedAt': entry.lastDownloadedAt?.toIso8601String(),
+      });
+    } catch (error) {
+      _logError('LAN file share download callback failed: $error');
+    }
   }
 
   _LanFileShareEntry? _findActiveShare(String token) {
@@ -833,8 +885,7 @@ $previewSection
     _LanFileShareEntry entry, {
     required String previewUrl,
   }) {
-    final file = File(entry.filePath);
-    if (!file.existsSync()) {
+    if (!entry.sourceExists) {
       return '';
     }
 
@@ -868,7 +919,7 @@ $previewSection
     }
 
     if (_isTextPreviewFile(entry.fileName)) {
-      final textPreview = htmlEscape.convert(_readTextPreview(file));
+      final textPreview = htmlEscape.convert(_readTextPreview(entry));
       return '''
       <section class="section">
         <span class="previewTag">文本预览</span>
@@ -905,18 +956,15 @@ $previewSection
     return '$year-$month-$day $hour:$minute';
   }
 
-  static String _readTextPreview(File file) {
+  static String _readTextPreview(_LanFileShareEntry entry) {
     const maxBytes = 24 * 1024;
     const maxChars = 5000;
-    RandomAccessFile? handle;
     try {
-      handle = file.openSync(mode: FileMode.read);
-      final bytes = handle.readSync(maxBytes);
+      final (bytes, wasTrimmedByBytes) = entry.readPrefixSync(maxBytes);
       var text = utf8.decode(bytes, allowMalformed: true).replaceAll(
         '\r\n',
         '\n',
       );
-      final wasTrimmedByBytes = handle.positionSync() < handle.lengthSync();
       if (text.length > maxChars) {
         text = text.substring(0, maxChars);
       }
@@ -926,8 +974,6 @@ $previewSection
       return text.trimRight();
     } catch (_) {
       return '当前文件无法生成文本预览，请直接下载查看。';
-    } finally {
-      handle?.closeSync();
     }
   }
 
@@ -1204,6 +1250,8 @@ class _LanFileShareEntry {
     required this.fileSize,
     required this.createdAt,
     required this.expiresAt,
+    this.pack,
+    this.packEntry,
   });
 
   final String shareKey;
@@ -1216,5 +1264,42 @@ class _LanFileShareEntry {
   int downloadCount = 0;
   DateTime? lastDownloadedAt;
 
+  /// 分享打包文件中的版本时，[filePath] 是虚拟路径，内容从打包文件读取
+  final VersionPack? pack;
+  final VersionPackEntry? packEntry;
+
   bool get isExpired => DateTime.now().isAfter(expiresAt);
+
+  bool get sourceExists => File(pack?.path ?? filePath).existsSync();
+
+  int get currentSize => packEntry?.size ?? File(filePath).statSync().size;
+
+  Stream<List<int>> openRead() {
+    final entry = packEntry;
+    return entry == null ? File(filePath).openRead() : pack!.openRead(entry);
+  }
+
+  /// 读取开头最多 [maxBytes] 字节，并返回后面是否还有内容
+  (List<int>, bool) readPrefixSync(int maxBytes) {
+    final entry = packEntry;
+    final handle = File(pack?.path ?? filePath).openSync();
+    try {
+      if (entry == null) {
+        final bytes = handle.readSync(maxBytes);
+        return (bytes, handle.positionSync() < handle.lengthSync());
+      }
+      handle.setPositionSync(entry.offset);
+      var bytes = entry.compressed
+          ? zlib.decode(handle.readSync(entry.storedSize))
+          : handle.readSync(
+              entry.storedSize < maxBytes ? entry.storedSize : maxBytes,
+            );
+      if (bytes.length > maxBytes) {
+        bytes = bytes.sublist(0, maxBytes);
+      }
+      return (bytes, entry.size > maxBytes);
+    } finally {
+      handle.closeSync();
+    }
+  }
 }
@@ -0,0 +1,393 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/native/LineDiffBindings.dart';
+import 'package:vertree/native/VertreeNative.dart';
+
+enum LineDiffLineKind { context, removed, added }
+
+class LineDiffLine {
+  const LineDiffLine({
+    required this.kind,
+    required this.text,
+    this.oldLine,
+    this.newLine,
+    this.missingNewline = false,
+  });
+
+  final LineDiffLineKind kind;
+  final String text;
+
+  /// 从 1 开始的行号，该侧不存在这一行时为 null
+  final int? oldLine;
+  final int? newLine;
+  final bool missingNewline;
+
+  Map<String, dynamic> toJson() {
+    return {
+      'kind': kind.name,
+      'oldLine': oldLine,
+      'newLine': newLine,
+      'text': text,
+      if (missingNewline) 'missingNewline': true,
+    };
+  }
+}
+
+class LineDiffHunk {
+  const LineDiffHunk({
+    required this.oldStart,
+    required this.oldCount,
+    required this.newStart,
+    required this.newCount,
+    required this.lines,
+  });
+
+  /// 与 unified diff 的 `@@ -oldStart,oldCount +newStart,newCount @@` 一致
+  final int oldStart;
+  final int oldCount;
+  final int newStart;
+  final int newCount;
+  final List<LineDiffLine> lines;
+
+  String get header => '@@ -${_range(oldStart, oldCount)} '
+      '+${_range(newStart, newCount)} @@';
+
+  static String _range(int start, int count) {
+    return count == 1 ? '$start' : '$start,$count';
+  }
+
+  Map<String, dynamic> toJson() {
+    return {
+      'oldStart': oldStart,
+      'oldCount': oldCount,
+      'newStart': newStart,
+      'newCount': newCount,
+      'lines': lines,
+    };
+  }
+}
+
+class LineDiffResult {
+  const LineDiffResult({
+    required this.oldPath,
+    required this.newPath,
+    required this.oldLineCount,
+    required this.newLineCount,
+    required this.removedLines,
+    required this.addedLines,
+    required this.hunkCount,
+    required this.hunks,
+    required this.truncated,
+  });
+
+  final String oldPath;
+  final String newPath;
+  final int oldLineCount;
+  final int newLineCount;
+  final int removedLines;
+  final int addedLines;
+
+  /// 全部差异块数量。[truncated] 时 [hunks] 只含前面一部分，且最后一块可能不完整
+  final int hunkCount;
+  final List<LineDiffHunk> hunks;
+  final bool truncated;
+
+  bool get isIdentical => hunkCount == 0;
+
+  Map<String, dynamic> toJson() {
+    return {
+      'oldPath': oldPath,
+      'newPath': newPath,
+      'oldLineCount': oldLineCount,
+      'newLineCount': newLineCount,
+      'removedLines': removedLines,
+      'addedLines': addedLines,
+      'hunkCount': hunkCount,
+      'returnedHunkCount': hunks.length,
+      'truncated': truncated,
+      'hunks': hunks,
+    };
+  }
+}
+
+/// 基于原生 diff 引擎（native/src/line_diff.cpp）比较两个版本的文本内容。
+///
+/// 原生调用都在后台 isolate 中执行，不阻塞界面。[compare] 返回结构化的差异块，
+/// 行数超过 [maxLines] 时截断；[unified] 按块产出 unified diff，只在订阅方
+/// 需要下一块时才读取，内存占用与文件大小无关。
+class LineDiffService {
+  const LineDiffService();
+
+  static const int defaultContextLines = 3;
+  static const int defaultMaxLines = 20000;
+  static const int unifiedChunkBytes = 64 * 1024;
+  static const String unavailableMessage =
+      'The native diff engine is not available on this platform.';
+
+  bool get isAvailable => LineDiffBindings.tryLoad() != null;
+
+  Future<Result<LineDiffResult, String>> compare(
+    String oldPath,
+    String newPath, {
+    int contextLines = defaultContextLines,
+    int maxLines = defaultMaxLines,
+  }) {
+    return Isolate.run(
+      () => _compareSync(oldPath, newPath, contextLines, maxLines),
+    );
+  }
+
+  /// unified diff 正文（不含 ---/+++ 文件头）。打开失败时以 [LineDiffException]
+  /// 作为流的第一个事件报告。
+  Stream<List<int>> unified(
+    String oldPath,
+    String newPath, {
+    int contextLines = defaultContextLines,
+  }) {
+    late final StreamController<List<int>> controller;
+    ReceivePort? replies;
+    SendPort? commands;
+    var requested = false;
+
+    void requestNext() {
+      final target = commands;
+      if (target == null || requested || controller.isPaused) {
+        return;
+      }
+      requested = true;
+      target.send(true);
+    }
+
+    void finish([Object? error]) {
+      commands?.send(false);
+      commands = null;
+      replies?.close();
+      if (controller.isClosed) {
+        return;
+      }
+      if (error != null) {
+        controller.addError(error);
+      }
+      controller.close();
+    }
+
+    void onMessage(dynamic message) {
+      if (message is SendPort) {
+        commands = message;
+        requestNext();
+      } else if (message is TransferableTypedData) {
+        requested = false;
+        controller.add(message.materialize().asUint8List());
+        requestNext();
+      } else if (message is String) {
+        finish(LineDiffException(message));
+      } else if (message is List) {
+        // 来自 onError：后台 isolate 抛出了未捕获的异常
+        finish(LineDiffException('${message.first}'));
+      } else {
+        // 读取完毕，或来自 onExit
+        finish();
+      }
+    }
+
+    controller = StreamController<List<int>>(
+      onListen: () {
+        final port = replies = ReceivePort()..listen(onMessage);
+        unawaited(
+          Isolate.spawn(
+            _unifiedWorker,
+            _UnifiedJob(port.sendPort, oldPath, newPath, contextLines),
+            onError: port.sendPort,
+            onExit: port.sendPort,
+          ).then<void>(
+            (_) {},
+            onError: (Object error) => finish(LineDiffException('$error')),
+          ),
+        );
+      },
+      onResume: requestNext,
+      onCancel: () => finish(),
+    );
+    return controller.stream;
+  }
+}
+
+class LineDiffException implements Exception {
+  const LineDiffException(this.message);
+
+  final String message;
+
+  @override
+  String toString() => message;
+}
+
+Result<LineDiffResult, String> _compareSync(
+  String oldPath,
+  String newPath,
+  int contextLines,
+  int maxLines,
+) {
+  final bindings = LineDiffBindings.tryLoad();
+  if (bindings == null) {
+    return Result.eMsg(LineDiffService.unavailableMessage);
+  }
+
+  return using((arena) {
+    final options = arena<VtDiffOptions>();
+    bindings.defaultOptions(options);
+    options.ref.contextLines = contextLines;
+    final handle = arena<Pointer<VtDiff>>();
+    final status = bindings.open(
+      oldPath.toNativeUtf8(allocator: arena),
+      newPath.toNativeUtf8(allocator: arena),
+      options,
+      handle,
+    );
+    if (status != vtOk) {
+      return Result.eMsg(LineDiffBindings.describeStatus(status));
+    }
+
+    final diff = handle.value;
+    try {
+      final stats = arena<VtDiffStats>();
+      bindings.stats(diff, stats);
+      final hunk = arena<VtDiffHunk>();
+      final line = arena<VtDiffLine>();
+      final hunks = <LineDiffHunk>[];
+      var lineBudget = maxLines;
+      var truncated = false;
+
+      while (!truncated && bindings.nextHunk(diff, hunk) == 1) {
+        final lines = <LineDiffLine>[];
+        while (bindings.nextLine(diff, line) == 1) {
+          if (lineBudget == 0) {
+            truncated = true;
+            break;
+          }
+          lines.add(_toLine(line.ref));
+          lineBudget -= 1;
+        }
+        if (lines.isEmpty) {
+          break;
+        }
+        final ref = hunk.ref;
+        hunks.add(
+          LineDiffHunk(
+            // 空区间沿用 unified diff 的写法，指向它前面的一行
+            oldStart: ref.oldCount == 0 ? ref.oldStart : ref.oldStart + 1,
+            oldCount: ref.oldCount,
+            newStart: ref.newCount == 0 ? ref.newStart : ref.newStart + 1,
+            newCount: ref.newCount,
+            lines: lines,
+          ),
+        );
+      }
+
+      final summary = stats.ref;
+      return Result.ok(
+        LineDiffResult(
+          oldPath: oldPath,
+          newPath: newPath,
+          oldLineCount: summary.oldLines,
+          newLineCount: summary.newLines,
+          removedLines: summary.removedLines,
+          addedLines: summary.addedLines,
+          hunkCount: summary.hunkCount,
+          hunks: hunks,
+          truncated: truncated,
+        ),
+      );
+    } finally {
+      bindings.close(diff);
+    }
+  });
+}
+
+LineDiffLine _toLine(VtDiffLine line) {
+  final kind = switch (line.kind) {
+    vtDiffLineRemoved => LineDiffLineKind.removed,
+    vtDiffLineAdded => LineDiffLineKind.added,
+    _ => LineDiffLineKind.context,
+  };
+  return LineDiffLine(
+    kind: kind,
+    text: utf8.decode(line.text.asTypedList(line.length), allowMalformed: true),
+    oldLine: line.oldLine < 0 ? null : line.oldLine + 1,
+    newLine: line.newLine < 0 ? null : line.newLine + 1,
+    missingNewline: line.missingNewline != 0,
+  );
+}
+
+class _UnifiedJob {
+  const _UnifiedJob(this.replies, this.oldPath, this.newPath, this.context);
+
+  final SendPort replies;
+  final String oldPath;
+  final String newPath;
+  final int context;
+}
+
+/// 后台 isolate：先回传命令端口，之后每收到一次 true 读取并回传一块，
+/// 读完发送 null；收到 false 表示订阅方已取消
+void _unifiedWorker(_UnifiedJob job) {
+  final bindings = LineDiffBindings.tryLoad();
+  if (bindings == null) {
+    job.replies.send(LineDiffService.unavailableMessage);
+    return;
+  }
+
+  final handle = calloc<Pointer<VtDiff>>();
+  final options = calloc<VtDiffOptions>();
+  final oldPath = job.oldPath.toNativeUtf8();
+  final newPath = job.newPath.toNativeUtf8();
+  bindings.defaultOptions(options);
+  options.ref.contextLines = job.context;
+  final status = bindings.open(oldPath, newPath, options, handle);
+  final diff = handle.value;
+  calloc
+    ..free(handle)
+    ..free(options)
+    ..free(oldPath)
+    ..free(newPath);
+  if (status != vtOk) {
+    job.replies.send(LineDiffBindings.describeStatus(status));
+    return;
+  }
+
+  final buffer = calloc<Uint8>(LineDiffService.unifiedChunkBytes);
+  final commands = ReceivePort();
+  void release() {
+    commands.close();
+    bindings.close(diff);
+    calloc.free(buffer);
+  }
+
+  commands.listen((message) {
+    if (message != true) {
+      release();
+      return;
+    }
+    final read = bindings.readUnified(
+      diff,
+      buffer,
+      LineDiffService.unifiedChunkBytes,
+    );
+    if (read <= 0) {
+      job.replies.send(null);
+      release();
+      return;
+    }
+    job.replies.send(
+      TransferableTypedData.fromList([
+        Uint8List.fromList(buffer.asTypedList(read)),
+      ]),
+    );
+  });
+  job.replies.send(commands.sendPort);
+}
@@ -0,0 +1,380 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/core/VersionKey.dart';
+import 'package:vertree/service/VersionTreeCache.dart';
+
+/// 一批目录变化应用到版本树上的结果
+class LiveVersionTreeUpdate {
+  LiveVersionTreeUpdate({
+    required this.root,
+    this.rootReplaced = false,
+    this.inserted = const [],
+    this.removed = const [],
+    this.renamed = const [],
+    this.updated = const [],
+  });
+
+  /// 应用后的根节点；家族里的文件全部消失时为空
+  final FileNode? root;
+
+  /// 无法就地修改、重新组装了整棵树。此时节点都是新对象
+  final bool rootReplaced;
+  final List<FileNode> inserted;
+  final List<FileNode> removed;
+
+  /// 版本号不变、只改了文件名（备注）的节点，[FileNode.mate] 已换成新路径
+  final List<FileNode> renamed;
+
+  /// 内容或修改时间变了的节点
+  final List<FileNode> updated;
+
+  bool get isEmpty =>
+      !rootReplaced &&
+      inserted.isEmpty &&
+      removed.isEmpty &&
+      renamed.isEmpty &&
+      updated.isEmpty;
+}
+
+/// 监听版本家族所在目录，把新增、删除、改名就地应用到已建好的树上。
+///
+/// 新版本由 [VersionKey.parentOf] 算出父节点后直接挂上，删除只摘下叶子节点，
+/// 改名只替换节点的元数据，节点对象保持不变，界面只需重新布局。
+/// 删除中间版本、出现比根更早的版本、父版本缺失等会改变其他节点挂载位置的
+/// 情况，重新列目录并用 [assembleTree] 组装。树的结构总与重新 [buildTree]
+/// 相同，只是同一版本号有多个文件时保留原先显示的那个。
+///
+/// 界面上的备份、分支、改备注会先修改树，随后到达的目录事件按路径识别为
+/// 已有节点，不会重复插入。
+class LiveVersionTree {
+  LiveVersionTree(
+    FileNode root, {
+    DirectoryWatchFactory? watchDirectory,
+    this.debounce = const Duration(milliseconds: 120),
+  }) : _root = root,
+       directoryPath = p.dirname(root.mate.fullPath),
+       name = root.mate.name,
+       extension = root.mate.extension,
+       _watchDirectory = watchDirectory ?? _defaultWatchDirectory;
+
+  final String directoryPath;
+  final String name;
+  final String extension;
+
+  /// 合并连续事件的等待时间，复制大文件时的多次写入只触发一次更新
+  final Duration debounce;
+  final DirectoryWatchFactory _watchDirectory;
+
+  FileNode? _root;
+  final Map<String, FileNode> _nodesByPath = {};
+  final Map<String, FileNode> _nodesByKey = {};
+
+  /// 在目录中但没挂到树上的家族文件（同版本号的重复文件、缺父版本的孤立版本），
+  /// 路径到版本键
+  final Map<String, String> _untracked = {};
+
+  /// 每个节点都挂在 [VersionKey.parentOf] 算出的父节点上。否则树里有按旧规则
+  /// 退回递归搜索挂上的节点
+  bool _linkedByKey = true;
+
+  final Set<String> _pendingPaths = {};
+  Timer? _flushTimer;
+  Future<void> _applying = Future.value();
+  StreamSubscription<FileSystemEvent>? _subscription;
+  final StreamController<LiveVersionTreeUpdate> _updates =
+      StreamController<LiveVersionTreeUpdate>.broadcast();
+  bool _disposed = false;
+
+  static Stream<FileSystemEvent> _defaultWatchDirectory(String directoryPath) {
+    return Directory(directoryPath).watch();
+  }
+
+  FileNode? get root => _root;
+
+  Stream<LiveVersionTreeUpdate> get updates => _updates.stream;
+
+  bool get isWatching => _subscription != null;
+
+  FileNode? nodeForPath(String filePath) {
+    _reindex();
+    return _nodesByPath[filePath];
+  }
+
+  /// 树上代表 [version] 的节点，文件改名后可以用它重新找到原来的版本
+  FileNode? nodeForVersion(FileVersion version) {
+    _reindex();
+    return _nodesByKey[version.key];
+  }
+
+  /// 开始监听；先记下目录里已有但不在树上的家族文件
+  Future<void> start() async {
+    if (_subscription != null || _disposed) {
+      return;
+    }
+    try {
+      _subscription = _watchDirectory(directoryPath).listen(
+        _onEvent,
+        onError: (_) => _stopWatching(),
+        onDone: _stopWatching,
+        cancelOnError: true,
+      );
+    } catch (e) {
+      // 平台或文件系统不支持监听时只显示打开时的树
+      stderr.writeln("监听版本目录失败: $e");
+      return;
+    }
+    await _collectUntracked();
+  }
+
+  Future<void> dispose() async {
+    _disposed = true;
+    _flushTimer?.cancel();
+    await _subscription?.cancel();
+    _subscription = null;
+    await _applying;
+    await _updates.close();
+  }
+
+  /// 按磁盘上的现状同步 [paths] 对应的节点，返回并广播这一批的结果
+  Future<LiveVersionTreeUpdate> applyPaths(Iterable<String> paths) {
+    final batch = paths.toSet();
+    final completer = Completer<LiveVersionTreeUpdate>();
+    _applying = _applying.then((_) async {
+      try {
+        final update = await _apply(batch);
+        if (!update.isEmpty && !_updates.isClosed) {
+          _updates.add(update);
+        }
+        completer.complete(update);
+      } catch (e, stackTrace) {
+        completer.completeError(e, stackTrace);
+      }
+    });
+    return completer.future;
+  }
+
+  void _onEvent(FileSystemEvent event) {
+    if (event.isDirectory) {
+      return;
+    }
+    _pendingPaths.add(event.path);
+    if (event is FileSystemMoveEvent && event.destination != null) {
+      _pendingPaths.add(event.destination!);
+    }
+    _flushTimer?.cancel();
+    _flushTimer = Timer(debounce, () {
+      final paths = _pendingPaths.toList();
+      _pendingPaths.clear();
+      unawaited(applyPaths(paths).catchError(_logApplyError));
+    });
+  }
+
+  LiveVersionTreeUpdate _logApplyError(Object error) {
+    stderr.writeln("更新版本树失败: $error");
+    return LiveVersionTreeUpdate(root: _root);
+  }
+
+  void _stopWatching() {
+    _subscription = null;
+  }
+
+  bool _isFamilyPath(String filePath) {
+    return p.dirname(filePath) == directoryPath &&
+        FileMeta.isSupportedTreeFilePath(filePath) &&
+        FileMeta.nameOf(filePath) == name &&
+        p.extension(filePath).replaceFirst('.', '') == extension;
+  }
+
+  Future<LiveVersionTreeUpdate> _apply(Set<String> paths) async {
+    _reindex();
+    final removed = <FileNode>[];
+    final added = <String>[];
+    final updated = <FileNode>[];
+    for (final filePath in paths) {
+      if (!_isFamilyPath(filePath)) {
+        continue;
+      }
+      final exists = File(filePath).existsSync();
+      final node = _nodesByPath[filePath];
+      if (node == null) {
+        if (!exists) {
+          _untracked.remove(filePath);
+        } else if (!_untracked.containsKey(filePath)) {
+          added.add(filePath);
+        }
+      } else if (exists) {
+        _refreshMeta(node, filePath);
+        updated.add(node);
+      } else {
+        removed.add(node);
+      }
+    }
+    if (removed.isEmpty && added.isEmpty && updated.isEmpty) {
+      return LiveVersionTreeUpdate(root: _root);
+    }
+
+    // 同一版本号一删一增，是文件改名
+    final renamed = <FileNode>[];
+    for (final node in [...removed]) {
+      final key = node.mate.version.key;
+      final index = added.indexWhere(
+        (filePath) => FileMeta.versionOf(filePath).key == key,
+      );
+      if (index >= 0) {
+        _refreshMeta(node, added.removeAt(index));
+        removed.remove(node);
+        renamed.add(node);
+      }
+    }
+
+    // 家族不完整时（有孤立版本或按旧规则挂上的节点），结构变化可能让其他
+    // 节点换位置，直接重新组装
+    final isComplete =
+        _linkedByKey && _untracked.values.every(_nodesByKey.containsKey);
+    final root = _root;
+    final needsReassembly =
+        root == null ||
+        (!isComplete && (removed.isNotEmpty || added.isNotEmpty)) ||
+        !_removeLeaves(root, removed) ||
+        !_insertAll(root, added);
+    if (needsReassembly) {
+      return _reassemble();
+    }
+    final inserted = [
+      for (final filePath in added)
+        if (_nodesByPath[filePath] case final node?) node,
+    ];
+    _reindex();
+    return LiveVersionTreeUpdate(
+      root: _root,
+      inserted: inserted,
+      removed: removed,
+      renamed: renamed,
+      updated: updated,
+    );
+  }
+
+  /// 从新到旧摘下叶子节点；遇到根节点、还有后续版本的节点，或有同版本号的
+  /// 其他文件可以顶替时返回 false
+  bool _removeLeaves(FileNode root, List<FileNode> nodes) {
+    VersionKey.sort(nodes, (node) => node.mate.version.key);
+    for (final node in nodes.reversed) {
+      final parent = node.parentOrNull;
+      if (identical(node, root) ||
+          parent == null ||
+          node.child != null ||
+          node.branches.isNotEmpty ||
+          _untracked.containsValue(node.mate.version.key)) {
+        return false;
+      }
+      parent.removeNode(node);
+      _nodesByPath.remove(node.mate.fullPath);
+      if (identical(_nodesByKey[node.mate.version.key], node)) {
+        _nodesByKey.remove(node.mate.version.key);
+      }
+    }
+    return true;
+  }
+
+  /// 从旧到新挂上新文件；父版本不在树上或比根更早时返回 false
+  bool _insertAll(FileNode root, List<String> paths) {
+    final keys = {for (final filePath in paths) filePath: _keyOf(filePath)};
+    VersionKey.sort(paths, (filePath) => keys[filePath]!);
+    final rootKey = root.mate.version.key;
+    for (final filePath in paths) {
+      final key = keys[filePath]!;
+      if (key.compareTo(rootKey) < 0) {
+        return false;
+      }
+      if (_nodesByKey.containsKey(key)) {
+        // 同版本号的另一个文件，和建树时一样不挂上
+        _untracked[filePath] = key;
+        continue;
+      }
+      final parentKey = VersionKey.parentOf(key);
+      final parent = parentKey == null ? null : _nodesByKey[parentKey];
+      if (parent == null) {
+        return false;
+      }
+      final node = FileNode(filePath);
+      if (node.mate.version.revisionNumber > 0) {
+        parent.addChild(node);
+      } else {
+        parent.addBranch(node);
+      }
+      _nodesByPath[filePath] = node;
+      _nodesByKey[key] = node;
+    }
+    return true;
+  }
+
+  Future<LiveVersionTreeUpdate> _reassemble() async {
+    final nodes = Directory(directoryPath).existsSync()
+        ? await loadFamilyNodes(directoryPath, name, extension)
+        : <FileNode>[];
+    _root = assembleTree(nodes);
+    _reindex();
+    _untracked
+      ..clear()
+      ..addAll({
+        for (final node in nodes)
+          if (!_nodesByPath.containsKey(node.mate.fullPath))
+            node.mate.fullPath: node.mate.version.key,
+      });
+    return LiveVersionTreeUpdate(root: _root, rootReplaced: true);
+  }
+
+  Future<void> _collectUntracked() async {
+    final List<FileNode> nodes;
+    try {
+      nodes = await loadFamilyNodes(directoryPath, name, extension);
+    } catch (e) {
+      stderr.writeln("列出版本目录失败: $e");
+      return;
+    }
+    _reindex();
+    for (final node in nodes) {
+      if (!_nodesByPath.containsKey(node.mate.fullPath)) {
+        _untracked[node.mate.fullPath] = node.mate.version.key;
+      }
+    }
+  }
+
+  /// 重新遍历树建立索引，顺带收进界面操作直接挂上或改名的节点
+  void _reindex() {
+    _nodesByPath.clear();
+    _nodesByKey.clear();
+    _linkedByKey = true;
+    final root = _root;
+    if (root == null) {
+      return;
+    }
+    final stack = [root];
+    while (stack.isNotEmpty) {
+      final node = stack.removeLast();
+      final key = node.mate.version.key;
+      _nodesByPath[node.mate.fullPath] = node;
+      _nodesByKey.putIfAbsent(key, () => node);
+      final parent = node.parentOrNull;
+      if (parent != null &&
+          VersionKey.parentOf(key) != parent.mate.version.key) {
+        _linkedByKey = false;
+      }
+      if (node.child != null) {
+        stack.add(node.child!);
+      }
+      stack.addAll(node.branches);
+    }
+  }
+
+  void _refreshMeta(FileNode node, String filePath) {
+    node.mate = FileMeta(filePath);
+    node.originalFile = node.mate.originalFile;
+  }
+
+  static String _keyOf(String filePath) => FileMeta.versionOf(filePath).key;
+}
@@ -1,13 +1,27 @@
+import 'dart:async';
 import 'dart:convert';
 import 'dart:io';
 
 import 'package:path/path.dart' as p;
 import 'package:vertree/component/Configer.dart';
+import 'package:vertree/core/ColdPack.dart';
+import 'package:vertree/core/FilePoller.dart';
 import 'package:vertree/core/FileVersionTree.dart';
 import 'package:vertree/core/MonitManager.dart';
 import 'package:vertree/core/Result.dart';
-import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/core/VersionCopy.dart';
+import 'package:vertree/core/VersionPack.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/ChangeSketchService.dart';
+import 'package:vertree/service/ColdPackService.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+import 'package:vertree/service/FileBatchService.dart';
+import 'package:vertree/service/IntegrityScrubService.dart';
 import 'package:vertree/service/LanFileShareServer.dart';
+import 'package:vertree/service/LineDiffService.dart';
+import 'package:vertree/service/VersionSearchService.dart';
+import 'package:vertree/service/VersionTreeCache.dart';
 
 typedef CurrentPortResolver = int? Function();
 typedef UiStateResolver = Map<String, dynamic> Function();
@@ -50,6 +64,14 @@ class LocalHttpApiService {
     required this.configer,
     required this.monitManager,
     required this.lanFileShareServer,
+    required this.activityEventHub,
+    required this.changeSketchService,
+    required this.versionSearchService,
+    required this.integrityScrubService,
+    required this.diskUsageService,
+    required this.coldPackService,
+    required this.fileBatchService,
+    required this.filePoller,
     required this.currentVersion,
     required this.startedAt,
     required this.currentPortResolver,
@@ -64,6 +86,14 @@ class LocalHttpApiService {
   final Configer configer;
   final MonitManager monitManager;
   final LanFileShareServer lanFileShareServer;
+  final ActivityEventHub activityEventHub;
+  final ChangeSketchService changeSketchService;
+  final VersionSearchService versionSearchService;
+  final IntegrityScrubService integrityScrubService;
+  final DiskUsageService diskUsageService;
+  final ColdPackService coldPackService;
+  final FileBatchService fileBatchService;
+  final FilePoller filePoller;
   final String currentVersion;
   final DateTime startedAt;
   final CurrentPortResolver currentPortResolver;
@@ -73,6 +103,8 @@ class LocalHttpApiService {
   final UiWindowStateHandler setWindowStateHandler;
   final FileTreeViewportHandler setFileTreeViewportHandler;
   final AppQuitHandler quitAppHandler;
+  final VersionTreeCache versionTreeCache = VersionTreeCache();
+  final LineDiffService lineDiffService = const LineDiffService();
 
   Map<String, dynamic> health() {
     return {
@@ -90,11 +122,30 @@ class LocalHttpApiService {
       'monitoring': {
         'taskCount': monitManager.monitFileTasks.length,
         'runningTaskCount': monitManager.runningTaskCount,
+        'polling': filePoller.status(),
       },
       'lanFileSharing': lanFileShareServer.status(),
+      'activityEvents': activityEventHub.status(),
+      'versionTreeCache': versionTreeCache.status(),
+      'lineDiffAvailable': lineDiffService.isAvailable,
+      'changeSketches': changeSketchService.status(),
+      'versionSearch': versionSearchService.status(),
+      'integrityScrub': integrityScrubService.status(),
+      'diskUsage': diskUsageService.status(),
+      'coldPack': coldPackService.status(),
       'config': {
         'monitorRateMinutes': configer.get<int>('monitorRate', 5),
         'monitorMaxSize': configer.get<int>('monitorMaxSize', 50),
+        'monitorWatchMode': configer.get<String>('monitorWatchMode', 'auto'),
+        'monitorBackupLayout': configer.get<String>(
+          'monitorBackupLayout',
+          'flat',
+        ),
+        'integrityScrubIntervalHours': configer.get<int>(
+          'integrityScrubIntervalHours',
+          24,
+        ),
+        'monitorColdPackDays': configer.get<int>('monitorColdPackDays', 0),
       },
       'ui': currentUiStateResolver(),
     };
@@ -265,29 +316,87 @@ class LocalHttpApiService {
     });
   }
 
-  Result<Map<String, dynamic>, String> listBackups(String filePath) {
+  /// 对一组文件执行同一个动作，结果与文件管理器多选相同
+  Future<Result<Map<String, dynamic>, String>> runFileBatch(
+    FileBatchAction action,
+    List<String> paths, {
+    String? label,
+    int? concurrency,
+  }) async {
+    final report = await fileBatchService.run(
+      action,
+      paths.map(_normalizePath),
+      label: label,
+      concurrency: concurrency,
+    );
+    return Result.ok(report.toJson());
+  }
+
+  /// 正在进行的版本备份与分支复制及其进度
+  Map<String, dynamic> listVersionCopies() {
+    return {
+      'copies': [for (final task in VersionCopy.active) task.toJson()],
+    };
+  }
+
+  /// 取消后复制在下一块之前停止，临时文件被删除，createBackup 返回失败
+  Result<Map<String, dynamic>, String> cancelVersionCopy(String id) {
+    final task = VersionCopy.find(id);
+    if (task == null) {
+      return Result.eMsg('Version copy not found or already finished: $id');
+    }
+    task.cancel();
+    return Result.ok(task.toJson());
+  }
+
+  /// 列出监控快照，最新的在前。[from]（含）与 [to]（不含）按快照时间筛选；
+  /// 分片布局的备份目录直接读快照索引。已移入冷存储的快照一并列出，
+  /// `storage` 为 `pack`，需要先经 [restoreColdSnapshot] 解出。
+  Result<Map<String, dynamic>, String> listBackups(
+    String filePath, {
+    String? backupDirPath,
+    DateTime? from,
+    DateTime? to,
+  }) {
     final normalizedPath = _normalizePath(filePath);
     final file = File(normalizedPath);
     if (!file.existsSync()) {
       return Result.eMsg('File does not exist: $normalizedPath');
     }
 
-    final backupDirPath = _deriveBackupDirectory(normalizedPath);
-    final backupDir = Directory(backupDirPath);
-    final backups = backupDir.existsSync()
-        ? backupDir.listSync().whereType<File>().map(_fileMetadata).toList()
-        : <Map<String, dynamic>>[];
-
-    backups.sort(
-      (a, b) => ((b['lastModifiedAt'] as String?) ?? '').compareTo(
-        ((a['lastModifiedAt'] as String?) ?? ''),
-      ),
-    );
+    final directoryPath =
+        backupDirPath ?? _deriveBackupDirectory(normalizedPath);
+    final backupDir = Directory(directoryPath);
+    final loose = SnapshotIndex.rangeSync(directoryPath, from: from, to: to);
+    final looseNames = {for (final snapshot in loose) snapshot.name};
+    final fromMicros = from?.microsecondsSinceEpoch;
+    final toMicros = to?.microsecondsSinceEpoch;
+    final cold = ColdPack.loadSync(directoryPath);
+    final items = [
+      for (final snapshot in loose)
+        (snapshot.createdMicros, _snapshotMetadata(directoryPath, snapshot)),
+      for (final entry in cold.entries.values)
+        if (!looseNames.contains(entry.name) &&
+            (fromMicros == null || entry.createdMicros >= fromMicros) &&
+            (toMicros == null || entry.createdMicros < toMicros))
+          (
+            entry.createdMicros,
+            _snapshotMetadata(
+              directoryPath,
+              entry.toRecord(),
+              packPath: cold.packPath(entry),
+            ),
+          ),
+    ]..sort((a, b) => b.$1.compareTo(a.$1));
+    final backups = [for (final (_, item) in items) item];
 
     return Result.ok({
       'sourcePath': normalizedPath,
-      'backupDirPath': backupDirPath,
+      'backupDirPath': directoryPath,
       'backupDirExists': backupDir.existsSync(),
+      'layout': SnapshotIndex.isShardedSync(directoryPath)
+          ? BackupLayout.sharded.name
+          : BackupLayout.flat.name,
       'count': backups.length,
       'items': backups,
     });
@@ -308,12 +417,21 @@ class LocalHttpApiService {
     });
   }
 
-  Result<Map<String, dynamic>, String> listMonitorTaskBackups(String taskId) {
+  Result<Map<String, dynamic>, String> listMonitorTaskBackups(
+    String taskId, {
+    DateTime? from,
+    DateTime? to,
+  }) {
     final task = _findTaskById(taskId);
     if (task == null) {
       return Result.eMsg('Monitor task not found: $taskId');
     }
-    return listBackups(task.filePath);
+    return listBackups(
+      task.filePath,
+      backupDirPath: task.backupDirPath,
+      from: from,
+      to: to,
+    );
   }
 
   Future<Map<String, dynamic>> listLanFileShares() async {
@@ -395,24 +513,448 @@ class LocalHttpApiService {
     });
   }
 
+  /// 构建（或复用缓存的）版本树，并按 [query] 裁剪或分页。
+  ///
+  /// 返回数据中的 etag 与 [cachedVersionTreeETag] 一致，可用于条件请求。
+  /// [VersionTreeQuery.includeChanges] 为 true 时先为整棵树估算变化比例，
+  /// 首次请求需要为尚未计算过的版本生成草图。
   Future<Result<Map<String, dynamic>, String>> getVersionTree(
+    String filePath, {
+    VersionTreeQuery query = const VersionTreeQuery(),
+  }) async {
+    final normalizedPath = _normalizePath(filePath);
+    final result = await versionTreeCache.load(normalizedPath);
+    if (result.isErr) {
+      return Result.eMsg(result.msg);
+    }
+    final snapshot = result.unwrap();
+    if (query.includeChanges && snapshot.changeEstimates == null) {
+      snapshot.changeEstimates = await changeSketchService.estimateTree(
+        snapshot.root,
+      );
+    }
+    return snapshot.render(query);
+  }
+
+  /// 目录自上次构建后没有变化时返回缓存的 ETag，不访问文件系统
+  String? cachedVersionTreeETag(String filePath) {
+    return versionTreeCache.peekETag(_normalizePath(filePath));
+  }
+
+  Future<Result<Map<String, dynamic>, String>> compareFiles(
+    String oldPath,
+    String newPath, {
+    int contextLines = LineDiffService.defaultContextLines,
+    int maxLines = LineDiffService.defaultMaxLines,
+  }) async {
+    final paths = _resolveDiffPaths(oldPath, newPath);
+    if (paths.isErr) {
+      return Result.eMsg(paths.msg);
+    }
+    final (normalizedOld, normalizedNew) = paths.unwrap();
+    final result = await lineDiffService.compare(
+      normalizedOld,
+      normalizedNew,
+      contextLines: contextLines,
+      maxLines: maxLines,
+    );
+    if (result.isErr) {
+      return Result.eMsg(result.msg);
+    }
+    return Result.ok(result.unwrap().toJson());
+  }
+
+  /// unified diff 正文的字节流，由调用方负责写出文件头
+  Result<(String, String, Stream<List<int>>), String> unifiedDiff(
+    String oldPath,
+    String newPath, {
+    int contextLines = LineDiffService.defaultContextLines,
+  }) {
+    final paths = _resolveDiffPaths(oldPath, newPath);
+    if (paths.isErr) {
+      return Result.eMsg(paths.msg);
+    }
+    if (!lineDiffService.isAvailable) {
+      return Result.eMsg(LineDiffService.unavailableMessage);
+    }
+    final (normalizedOld, normalizedNew) = paths.unwrap();
+    return Result.ok((
+      normalizedOld,
+      normalizedNew,
+      lineDiffService.unified(
+        normalizedOld,
+        normalizedNew,
+        contextLines: contextLines,
+      ),
+    ));
+  }
+
+  Result<(String, String), String> _resolveDiffPaths(
+    String oldPath,
+    String newPath,
+  ) {
+    final normalizedOld = _normalizePath(oldPath);
+    final normalizedNew = _normalizePath(newPath);
+    for (final filePath in [normalizedOld, normalizedNew]) {
+      if (!File(filePath).existsSync()) {
+        return Result.eMsg('File does not exist: $filePath');
+      }
+    }
+    return Result.ok((normalizedOld, normalizedNew));
+  }
+
+  Future<Result<Map<String, dynamic>, String>> searchVersions(
     String filePath,
+    VersionSearchQuery query,
   ) async {
-    final normalizedPath = _normalizePath(filePath);
-    final result = await buildTree(normalizedPath);
+    final result = await versionSearchService.search(
+      _normalizePath(filePath),
+      query,
+    );
     if (result.isErr) {
       return Result.eMsg(result.msg);
     }
+    return Result.ok(result.unwrap().toJson());
+  }
+
+  /// 在后台开始一次完整性校验，立即返回当前状态；结果通过
+  /// [integrityScrubStatus] 或 scrub.finished 事件获取。
+  /// [paths] 为空时校验全部监控任务，否则校验这些文件的版本家族与备份目录。
+  Result<Map<String, dynamic>, String> startIntegrityScrub({
+    List<String>? paths,
+    bool dropMissing = false,
+    bool lowPriority = false,
+  }) {
+    if (integrityScrubService.isRunning) {
+      return Result.eMsg('An integrity scrub is already running.');
+    }
+    List<ScrubTarget>? targets;
+    if (paths != null && paths.isNotEmpty) {
+      targets = [];
+      for (final filePath in paths) {
+        final normalizedPath = _normalizePath(filePath);
+        if (!File(normalizedPath).existsSync()) {
+          return Result.eMsg('File does not exist: $normalizedPath');
+        }
+        final task = monitManager.monitFileTasks
+            .where((task) => _normalizePath(task.filePath) == normalizedPath)
+            .firstOrNull;
+        targets.addAll(
+          ScrubTarget.forFile(
+            normalizedPath,
+            backupDirPath: task?.backupDirPath,
+          ),
+        );
+      }
+    }
+    unawaited(
+      integrityScrubService.scrub(
+        targets: targets,
+        dropMissing: dropMissing,
+        lowPriority: lowPriority,
+      ),
+    );
+    return Result.ok(integrityScrubService.status());
+  }
+
+  Map<String, dynamic> integrityScrubStatus() {
+    return integrityScrubService.status();
+  }
+
+  /// 在后台把早于 [olderThanDays] 天的监控快照打包进冷存储，立即返回当前
+  /// 状态；结果通过 [coldPackStatus] 或 cold-pack.finished 事件获取。
+  /// [olderThanDays] 默认取配置 monitorColdPackDays，未配置时为 30；[paths]
+  /// 为空时处理全部监控任务。
+  Result<Map<String, dynamic>, String> startColdPack({
+    List<String>? paths,
+    int? olderThanDays,
+  }) {
+    if (coldPackService.isRunning) {
+      return Result.eMsg('Cold packing is already running.');
+    }
+    final configuredDays = configer.get<int>('monitorColdPackDays', 0);
+    final days = olderThanDays ?? (configuredDays > 0 ? configuredDays : 30);
+    if (days <= 0) {
+      return Result.eMsg('Field "olderThanDays" must be positive.');
+    }
+    List<DiskUsageTarget>? targets;
+    if (paths != null && paths.isNotEmpty) {
+      targets = [];
+      for (final filePath in paths) {
+        final normalizedPath = _normalizePath(filePath);
+        final task = monitManager.monitFileTasks
+            .where((task) => _normalizePath(task.filePath) == normalizedPath)
+            .firstOrNull;
+        if (task == null) {
+          return Result.eMsg('Monitor task not found: $normalizedPath');
+        }
+        targets.add(
+          DiskUsageTarget(
+            filePath: task.filePath,
+            backupDirPath:
+                task.backupDirPath ?? _deriveBackupDirectory(task.filePath),
+          ),
+        );
+      }
+    }
+    unawaited(
+      coldPackService.pack(minAge: Duration(days: days), targets: targets),
+    );
+    return Result.ok(coldPackService.status());
+  }
 
-    final root = result.unwrap();
-    final summary = _summarizeTree(root);
+  Map<String, dynamic> coldPackStatus() {
+    return coldPackService.status();
+  }
+
+  /// 把 [filePath] 的监控任务中已打包的快照 [name]（列表中的 relativePath）
+  /// 解出；[targetPath] 为空时解到系统临时目录
+  Future<Result<Map<String, dynamic>, String>> restoreColdSnapshot({
+    required String filePath,
+    required String name,
+    String? targetPath,
+  }) async {
+    final normalizedPath = _normalizePath(filePath);
+    final task = monitManager.monitFileTasks
+        .where((task) => _normalizePath(task.filePath) == normalizedPath)
+        .firstOrNull;
+    final backupDirPath =
+        task?.backupDirPath ?? _deriveBackupDirectory(normalizedPath);
+    final result = await coldPackService.restore(
+      backupDirPath,
+      name,
+      targetPath: targetPath == null ? null : _normalizePath(targetPath),
+    );
+    if (result.isErr) {
+      return Result.eMsg(result.msg);
+    }
+    final restoredPath = result.unwrap();
     return Result.ok({
       'sourcePath': normalizedPath,
-      'summary': summary,
-      'root': _treeNodeToMap(root),
+      'backupDirPath': backupDirPath,
+      'name': name,
+      'path': restoredPath,
+      'size': File(restoredPath).lengthSync(),
     });
   }
 
+  /// 全部监控任务的磁盘占用。默认返回缓存的结果（从未统计过时先扫描一次），
+  /// [refresh] 为 true 时重新扫描全部任务
+  Future<Result<Map<String, dynamic>, String>> getDiskUsage({
+    bool refresh = false,
+  }) async {
+    try {
+      final report = refresh
+          ? await diskUsageService.refresh()
+          : await diskUsageService.report();
+      return Result.ok(report.toJson());
+    } on FileSystemException catch (e) {
+      return Result.eMsg('${e.message}: ${e.path}');
+    }
+  }
+
+  /// 把 [filePath] 所在的版本家族打包成一个文件；[packPath] 默认是版本文件
+  /// 同目录下的 `<名称>.vtpack`。不覆盖已有的打包文件。
+  Future<Result<Map<String, dynamic>, String>> exportVersionPack(
+    String filePath, {
+    String? packPath,
+    bool includeBackups = false,
+    bool compress = true,
+  }) async {
+    final normalizedPath = _normalizePath(filePath);
+    if (!File(normalizedPath).existsSync()) {
+      return Result.eMsg('File does not exist: $normalizedPath');
+    }
+    if (!FileMeta.isSupportedTreeFilePath(normalizedPath)) {
+      return Result.eMsg('File name is not a supported version file.');
+    }
+    final targetPath = packPath == null
+        ? p.join(
+            p.dirname(normalizedPath),
+            '${FileMeta.nameOf(normalizedPath)}${VersionPack.fileSuffix}',
+          )
+        : _normalizePath(packPath);
+    if (!VersionPack.isPackPath(targetPath)) {
+      return Result.eMsg(
+        'Pack path must end with ${VersionPack.fileSuffix}: $targetPath',
+      );
+    }
+    if (File(targetPath).existsSync()) {
+      return Result.eMsg('Pack file already exists: $targetPath');
+    }
+
+    final stopwatch = Stopwatch()..start();
+    try {
+      final pack = await VersionPack.exportFamily(
+        normalizedPath,
+        targetPath,
+        includeBackups: includeBackups,
+        compress: compress,
+      );
+      return Result.ok({
+        ...pack.toJson(),
+        'packBytes': File(targetPath).lengthSync(),
+        'elapsedMs': stopwatch.elapsedMilliseconds,
+      });
+    } on FileSystemException catch (e) {
+      return Result.eMsg('${e.message}: ${e.path ?? targetPath}');
+    }
+  }
+
+  /// 读取打包文件的索引，列出其中的版本与备份
+  Future<Result<Map<String, dynamic>, String>> getVersionPack(
+    String packPath,
+  ) async {
+    final normalizedPath = _normalizePath(packPath);
+    if (!File(normalizedPath).existsSync()) {
+      return Result.eMsg('File does not exist: $normalizedPath');
+    }
+    try {
+      final pack = await VersionPack.open(normalizedPath);
+      return Result.ok({
+        ...pack.toJson(),
+        'packBytes': File(normalizedPath).lengthSync(),
+      });
+    } on FormatException catch (e) {
+      return Result.eMsg(e.message);
+    } on FileSystemException catch (e) {
+      return Result.eMsg('${e.message}: $normalizedPath');
+    }
+  }
+
+  /// 把打包文件还原到 [targetDirectory]（默认打包文件所在目录），恢复原来的
+  /// 文件名；已有的同名文件不会被覆盖，内容不同的列为冲突
+  Future<Result<Map<String, dynamic>, String>> importVersionPack(
+    String packPath, {
+    String? targetDirectory,
+  }) async {
+    final normalizedPath = _normalizePath(packPath);
+    if (!File(normalizedPath).existsSync()) {
+      return Result.eMsg('File does not exist: $normalizedPath');
+    }
+    try {
+      final report = await VersionPack.importPack(
+        normalizedPath,
+        targetDirectory: targetDirectory == null
+            ? null
+            : _normalizePath(targetDirectory),
+      );
+      return Result.ok(report.toJson());
+    } on FormatException catch (e) {
+      return Result.eMsg(e.message);
+    } on FileSystemException catch (e) {
+      return Result.eMsg('${e.message}: ${e.path ?? normalizedPath}');
+    }
+  }
+
+  /// 批量接口支持的操作名，均映射到本类已有的方法
+  static const List<String> batchOperations = [
+    'health',
+    'listMonitorTasks',
+    'getMonitorTask',
+    'createMonitorTask',
+    'updateMonitorTask',
+    'deleteMonitorTask',
+    'createBackup',
+    'listBackups',
+    'listVersionCopies',
+    'listVersionFiles',
+    'getVersionTree',
+    'compareFiles',
+    'searchVersions',
+    'getIntegrityScrub',
+    'getVersionPack',
+    'getDiskUsage',
+    'getColdPack',
+    'listFileShares',
+  ];
+
+  Future<Result<Map<String, dynamic>, String>> runBatchOperation(
+    String operation,
+    Map<String, dynamic> params,
+  ) async {
+    String? stringParam(String key) {
+      final value = params[key]?.toString();
+      return value == null || value.isEmpty ? null : value;
+    }
+
+    Result<Map<String, dynamic>, String> missing(String key) {
+      return Result.eMsg('Parameter "$key" is required for $operation.');
+    }
+
+    final id = stringParam('id');
+    final path = stringParam('path');
+    switch (operation) {
+      case 'health':
+        return Result.ok(health());
+      case 'listMonitorTasks':
+        return Result.ok(listMonitorTasks());
+      case 'getMonitorTask':
+        if (id == null) return missing('id');
+        return getMonitorTask(id);
+      case 'createMonitorTask':
+        if (path == null) return missing('path');
+        return createMonitorTask(path);
+      case 'updateMonitorTask':
+        final isRunning = params['isRunning'];
+        if (id == null) return missing('id');
+        if (isRunning is! bool) return missing('isRunning');
+        return updateMonitorTask(id, isRunning: isRunning);
+      case 'deleteMonitorTask':
+        if (id == null) return missing('id');
+        return deleteMonitorTask(id);
+      case 'createBackup':
+        if (path == null) return missing('path');
+        return createBackup(path, label: stringParam('label'));
+      case 'listBackups':
+        if (path == null) return missing('path');
+        return listBackups(path);
+      case 'listVersionCopies':
+        return Result.ok(listVersionCopies());
+      case 'listVersionFiles':
+        if (path == null) return missing('path');
+        return listVersionFiles(path);
+      case 'getVersionTree':
+        if (path == null) return missing('path');
+        return getVersionTree(path);
+      case 'compareFiles':
+        final oldPath = stringParam('old');
+        final newPath = stringParam('new');
+        if (oldPath == null) return missing('old');
+        if (newPath == null) return missing('new');
+        return compareFiles(oldPath, newPath);
+      case 'searchVersions':
+        final text = stringParam('q');
+        if (path == null) return missing('path');
+        if (text == null) return missing('q');
+        return searchVersions(
+          path,
+          VersionSearchQuery(
+            text: text,
+            regex: params['regex'] == true,
+            caseSensitive: params['caseSensitive'] == true,
+            includeBackups: params['includeBackups'] == true,
+          ),
+        );
+      case 'getIntegrityScrub':
+        return Result.ok(integrityScrubStatus());
+      case 'getVersionPack':
+        if (path == null) return missing('path');
+        return getVersionPack(path);
+      case 'getDiskUsage':
+        return getDiskUsage(refresh: params['refresh'] == true);
+      case 'getColdPack':
+        return Result.ok(coldPackStatus());
+      case 'listFileShares':
+        return Result.ok(await listLanFileShares());
+      default:
+        return Result.eMsg(
+          'Unsupported batch operation: $operation. '
+          'Supported: ${batchOperations.join(', ')}.',
+        );
+    }
+  }
+
   String encodeTaskId(String filePath) {
     return base64Url.encode(utf8.encode(_normalizePath(filePath)));
   }
@@ -445,13 +987,7 @@ class LocalHttpApiService {
     final backupDirPath =
         task.backupDirPath ?? _deriveBackupDirectory(task.filePath);
     final backupDir = Directory(backupDirPath);
-    final recentBackups = backupDir.existsSync()
-        ? backupDir.listSync().whereType<File>().toList()
-        : <File>[];
-
-    recentBackups.sort(
-      (a, b) => b.lastModifiedSync().compareTo(a.lastModifiedSync()),
-    );
+    final snapshots = SnapshotIndex.snapshotsSync(backupDirPath);
 
     final monitor = task.monitor;
 
@@ -466,12 +1002,17 @@ class LocalHttpApiService {
           : null,
       'backupDirPath': backupDirPath,
       'backupDirExists': backupDir.existsSync(),
-      'backupFileCount': recentBackups.length,
-      'recentBackups': recentBackups.take(5).map(_fileMetadata).toList(),
+      'backupFileCount': snapshots.length,
+      'packedBackupCount': ColdPack.loadSync(backupDirPath).entries.length,
+      'recentBackups': [
+        for (final snapshot in snapshots.reversed.take(5))
+          _snapshotMetadata(backupDirPath, snapshot),
+      ],
       'isRunning': task.isRunning,
       'monitorAttached': task.monitor != null,
       'monitorRuntime': {
         'startedAt': monitor?.startedAt?.toIso8601String(),
+        'watchMode': monitor?.watchMode,
         'lastObservedEventAt': monitor?.lastObservedEventAt?.toIso8601String(),
         'lastObservedEventPath': monitor?.lastObservedEventPath,
         'lastBackupAt': monitor?.lastBackupTime?.toIso8601String(),
@@ -530,50 +1071,6 @@ class LocalHttpApiService {
     return files;
   }
 
-  Map<String, dynamic> _treeNodeToMap(FileNode node) {
-    return {
-      'path': node.mate.fullPath,
-      'fullName': node.mate.fullName,
-      'name': node.mate.name,
-      'label': node.mate.label,
-      'extension': node.mate.extension,
-      'version': node.mate.version.toString(),
-      'child': node.child == null ? null : _treeNodeToMap(node.child!),
-      'branches': node.branches.map(_treeNodeToMap).toList(),
-    };
-  }
-
-  Map<String, dynamic> _summarizeTree(FileNode root) {
-    var totalNodes = 0;
-    var branchNodes = 0;
-    FileNode? latest;
-
-    void walk(FileNode node) {
-      totalNodes += 1;
-      latest =
-          latest == null ||
-              latest!.mate.version.compareTo(node.mate.version) < 0
-          ? node
-          : latest;
-      branchNodes += node.branches.length;
-      if (node.child != null) {
-        walk(node.child!);
-      }
-      for (final branch in node.branches) {
-        walk(branch);
-      }
-    }
-
-    walk(root);
-
-    return {
-      'rootVersion': root.mate.version.toString(),
-      'latestVersion': latest?.mate.version.toString(),
-      'totalNodes': totalNodes,
-      'branchNodes': branchNodes,
-    };
-  }
-
   Map<String, dynamic> _fileMetadata(File file) {
     final stat = file.statSync();
     return {
@@ -585,6 +1082,25 @@ class LocalHttpApiService {
     };
   }
 
+  /// [packPath] 不为 null 时快照在冷存储中，`path` 是它原来的位置
+  Map<String, dynamic> _snapshotMetadata(
+    String backupDirPath,
+    SnapshotRecord snapshot, {
+    String? packPath,
+  }) {
+    return {
+      'path': snapshot.pathIn(backupDirPath),
+      'name': p.basename(snapshot.name),
+      'relativePath': snapshot.name,
+      'size': snapshot.size,
+      'createdAt': snapshot.createdAt.toIso8601String(),
+      'lastModifiedAt': snapshot.createdAt.toIso8601String(),
+      'hash': snapshot.hash,
+      'storage': packPath == null ? 'file' : 'pack',
+      if (packPath != null) 'packPath': packPath,
+    };
+  }
+
   String _deriveBackupDirectory(String filePath) {
     final normalizedPath = _normalizePath(filePath);
     final directory = p.dirname(normalizedPath);
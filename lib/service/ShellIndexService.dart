@@ -0,0 +1,249 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:io';
+import 'dart:isolate';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+
+/// 文件管理器中一个文件显示的 Vertree 状态
+class ShellFileStatus {
+  const ShellFileStatus({
+    required this.versionCount,
+    this.monitored = false,
+    this.lastBackupAt,
+  });
+
+  /// 所在版本家族的版本数，未备份过的文件为 1
+  final int versionCount;
+  final bool monitored;
+
+  /// 同家族其他版本与监控快照中最新的修改时间
+  final DateTime? lastBackupAt;
+
+  @override
+  bool operator ==(Object other) =>
+      other is ShellFileStatus &&
+      other.versionCount == versionCount &&
+      other.monitored == monitored &&
+      other.lastBackupAt == lastBackupAt;
+
+  @override
+  int get hashCode => Object.hash(versionCount, monitored, lastBackupAt);
+
+  @override
+  String toString() =>
+      'ShellFileStatus(versionCount: $versionCount, monitored: $monitored, '
+      'lastBackupAt: $lastBackupAt)';
+}
+
+/// 按目录回答文件管理器扩展的状态查询。
+///
+/// 文件管理器列出目录时逐个文件询问状态，扩展把它们合成一次目录查询，这里
+/// 列一次目录、按文件名分组出版本家族，只返回有版本或被监控的文件。结果按
+/// 目录缓存，目录的修改时间变化（新增、删除版本文件）后重新扫描；监控快照
+/// 写在 `_bak` 子目录里，不改变目录本身，改由活动事件使缓存失效，并通过
+/// [changedDirectories] 通知扩展刷新。
+class ShellIndexService {
+  ShellIndexService({
+    required this.targetsResolver,
+    Stream<ActivityEvent>? activityEvents,
+    Stream<String>? createdVersions,
+    this.maxDirectories = 64,
+  }) {
+    if (activityEvents != null) {
+      _subscriptions.add(activityEvents.listen(_onActivityEvent));
+    }
+    _subscriptions.add(
+      (createdVersions ?? FileNode.createdVersions).listen(
+        (versionPath) => invalidate(p.dirname(versionPath)),
+      ),
+    );
+  }
+
+  static const Set<String> _invalidatingEvents = {
+    ActivityEventType.monitorStarted,
+    ActivityEventType.monitorStopped,
+    ActivityEventType.snapshotFinished,
+    ActivityEventType.retentionPruned,
+  };
+
+  /// 当前的监控任务
+  final Iterable<DiskUsageTarget> Function() targetsResolver;
+
+  /// 最多缓存的目录数，超出时淘汰最久没有查询的
+  final int maxDirectories;
+
+  final LinkedHashMap<String, _CachedDirectory> _cache = LinkedHashMap();
+  final Map<String, Future<Map<String, ShellFileStatus>>> _scanning = {};
+  final StreamController<String> _changed =
+      StreamController<String>.broadcast();
+  final List<StreamSubscription<Object>> _subscriptions = [];
+  int _generation = 0;
+
+  /// 状态可能已经变化的目录
+  Stream<String> get changedDirectories => _changed.stream;
+
+  /// 返回 [directoryPath] 中有版本或被监控的文件，以文件名为键
+  Future<Map<String, ShellFileStatus>> directory(String directoryPath) {
+    final dirPath = p.normalize(directoryPath);
+    final FileStat stat;
+    try {
+      stat = FileStat.statSync(dirPath);
+    } catch (_) {
+      return Future.value(const {});
+    }
+    if (stat.type != FileSystemEntityType.directory) {
+      return Future.value(const {});
+    }
+
+    final cached = _cache.remove(dirPath);
+    if (cached != null && cached.modified == stat.modified) {
+      _cache[dirPath] = cached;
+      return Future.value(cached.entries);
+    }
+    return _scanning[dirPath] ??= _scan(dirPath, stat.modified);
+  }
+
+  /// 丢弃 [directoryPath] 的缓存并通知扩展
+  void invalidate(String directoryPath) {
+    final dirPath = p.normalize(directoryPath);
+    _generation += 1;
+    _cache.remove(dirPath);
+    _changed.add(dirPath);
+  }
+
+  Future<void> dispose() async {
+    for (final subscription in _subscriptions) {
+      await subscription.cancel();
+    }
+    await _changed.close();
+  }
+
+  Future<Map<String, ShellFileStatus>> _scan(
+    String dirPath,
+    DateTime modified,
+  ) async {
+    final generation = _generation;
+    try {
+      final monitored = [
+        for (final target in targetsResolver())
+          if (p.dirname(p.normalize(target.filePath)) == dirPath)
+            (p.normalize(target.filePath), target.backupDirPath),
+      ];
+      final entries = await Isolate.run(
+        () => scanDirectorySync(dirPath, monitored),
+      );
+      // 扫描期间有事件使缓存失效时，这次结果可能已经过时，不缓存
+      if (generation == _generation) {
+        _cache[dirPath] = _CachedDirectory(modified, entries);
+        while (_cache.length > maxDirectories) {
+          _cache.remove(_cache.keys.first);
+        }
+      }
+      return entries;
+    } catch (_) {
+      return const {};
+    } finally {
+      _scanning.remove(dirPath);
+    }
+  }
+
+  void _onActivityEvent(ActivityEvent event) {
+    if (!_invalidatingEvents.contains(event.type)) {
+      return;
+    }
+    final filePath = event.data['filePath'];
+    if (filePath is String) {
+      invalidate(p.dirname(filePath));
+    }
+  }
+
+  /// 在当前 isolate 中扫描一个目录，[monitored] 是该目录中被监控的文件及其
+  /// 备份目录
+  static Map<String, ShellFileStatus> scanDirectorySync(
+    String dirPath,
+    List<(String, String?)> monitored,
+  ) {
+    final families = <String, List<String>>{};
+    for (final entity in Directory(dirPath).listSync(followLinks: false)) {
+      if (entity is! File || !FileMeta.isSupportedTreeFilePath(entity.path)) {
+        continue;
+      }
+      final key =
+          '${FileMeta.nameOf(entity.path)}${p.extension(entity.path)}';
+      (families[key] ??= []).add(entity.path);
+    }
+
+    final entries = <String, ShellFileStatus>{};
+    for (final members in families.values) {
+      if (members.length < 2) {
+        continue;
+      }
+      // 一个家族可能有上千个版本：一遍找出最新和次新的修改时间，每个版本的
+      // “其他版本中最新的”就是两者之一
+      final modified = [for (final member in members) _modifiedOf(member)];
+      var newestIndex = -1;
+      DateTime? newest;
+      DateTime? secondNewest;
+      for (var i = 0; i < modified.length; i++) {
+        final time = modified[i];
+        if (time == null) {
+          continue;
+        }
+        if (newest == null || time.isAfter(newest)) {
+          secondNewest = newest;
+          newest = time;
+          newestIndex = i;
+        } else if (secondNewest == null || time.isAfter(secondNewest)) {
+          secondNewest = time;
+        }
+      }
+      for (var i = 0; i < members.length; i++) {
+        entries[p.basename(members[i])] = ShellFileStatus(
+          versionCount: members.length,
+          lastBackupAt: i == newestIndex ? secondNewest : newest,
+        );
+      }
+    }
+
+    for (final (filePath, backupDirPath) in monitored) {
+      final name = p.basename(filePath);
+      final versioned = entries[name];
+      entries[name] = ShellFileStatus(
+        versionCount: versioned?.versionCount ?? 1,
+        monitored: true,
+        lastBackupAt: _later(
+          versioned?.lastBackupAt,
+          backupDirPath == null ? null : _newestIn(backupDirPath),
+        ),
+      );
+    }
+    return entries;
+  }
+
+  static DateTime? _modifiedOf(String filePath) {
+    final stat = FileStat.statSync(filePath);
+    return stat.type == FileSystemEntityType.notFound ? null : stat.modified;
+  }
+
+  static DateTime? _newestIn(String dirPath) {
+    return SnapshotIndex.latestSync(dirPath)?.createdAt;
+  }
+
+  static DateTime? _later(DateTime? a, DateTime? b) {
+    if (a == null) return b;
+    if (b == null) return a;
+    return b.isAfter(a) ? b : a;
+  }
+}
+
+class _CachedDirectory {
+  _CachedDirectory(this.modified, this.entries);
+
+  final DateTime modified;
+  final Map<String, ShellFileStatus> entries;
+}
@@ -0,0 +1,297 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:vertree/core/Fnv1a64.dart';
+
+/// 缩略图的磁盘打包存储。格式与内容无关，变化草图（ChangeSketchService）也复用它。
+///
+/// 文件格式（小端序）：
+/// - 文件头 8 字节魔数 `VTTHUMB1`
+/// - 之后是连续的记录，每条记录：
+///   `u32 记录魔数 | u32 键长度 | u32 数据长度 | u32 数据校验(FNV-1a 低 32 位)`，
+///   随后是 UTF-8 键与数据，整条记录补齐到 8 字节边界
+///
+/// 记录只追加、偏移固定且按 8 字节对齐，读取方既可以按偏移随机读取，
+/// 也可以把整个文件 mmap 后直接切片。索引不单独落盘，打开时顺序扫描记录头重建，
+/// 同一个键后写入的记录覆盖先前的记录；尾部写了一半的记录会被截掉。
+/// 超过 [maxBytes] 时按最近使用顺序保留一半预算的条目重写整个文件。
+class ThumbnailPack {
+  ThumbnailPack(this.path, {this.maxBytes = defaultMaxBytes});
+
+  static const int defaultMaxBytes = 128 * 1024 * 1024;
+  static const List<int> fileMagic = [
+    0x56, 0x54, 0x54, 0x48, 0x55, 0x4d, 0x42, 0x31, // VTTHUMB1
+  ];
+  static const int recordMagic = 0x52485456; // "VTHR"
+  static const int recordHeaderSize = 16;
+  static const int alignment = 8;
+
+  final String path;
+  final int maxBytes;
+
+  /// 插入顺序即最近使用顺序
+  final LinkedHashMap<String, _PackEntry> _index =
+      LinkedHashMap<String, _PackEntry>();
+  RandomAccessFile? _file;
+  int _length = 0;
+  int _liveBytes = 0;
+  Future<void> _tail = Future<void>.value();
+
+  int get entryCount => _index.length;
+
+  /// 打包文件当前大小（含被覆盖的旧记录）
+  int get fileBytes => _length;
+
+  /// 仍被索引引用的记录所占字节数
+  int get liveBytes => _liveBytes;
+
+  bool contains(String key) => _index.containsKey(key);
+
+  Future<void> open() {
+    return _serialized(() async {
+      final file = File(path);
+      await file.parent.create(recursive: true);
+      final handle = await file.open(mode: FileMode.append);
+      _file = handle;
+      _length = await handle.length();
+      if (_length < fileMagic.length || !await _hasFileMagic(handle)) {
+        await _reset(handle);
+        return;
+      }
+      await _scan(handle);
+    });
+  }
+
+  Future<Uint8List?> read(String key) {
+    return _serialized(() async {
+      final entry = _index.remove(key);
+      final handle = _file;
+      if (entry == null || handle == null) {
+        return null;
+      }
+
+      await handle.setPosition(entry.dataOffset);
+      final data = await handle.read(entry.dataLength);
+      if (data.length != entry.dataLength ||
+          _checksum(data) != entry.checksum) {
+        _liveBytes -= entry.recordLength;
+        return null;
+      }
+      _index[key] = entry;
+      return data;
+    });
+  }
+
+  Future<void> write(String key, Uint8List data) {
+    return _serialized(() async {
+      final handle = _file;
+      if (handle == null) {
+        return;
+      }
+
+      final keyBytes = utf8.encode(key);
+      final recordLength = _align(
+        recordHeaderSize + keyBytes.length + data.length,
+      );
+      final record = Uint8List(recordLength);
+      final header = ByteData.sublistView(record, 0, recordHeaderSize);
+      header.setUint32(0, recordMagic, Endian.little);
+      header.setUint32(4, keyBytes.length, Endian.little);
+      header.setUint32(8, data.length, Endian.little);
+      header.setUint32(12, _checksum(data), Endian.little);
+      record.setRange(
+        recordHeaderSize,
+        recordHeaderSize + keyBytes.length,
+        keyBytes,
+      );
+      record.setRange(
+        recordHeaderSize + keyBytes.length,
+        recordHeaderSize + keyBytes.length + data.length,
+        data,
+      );
+
+      final offset = _length;
+      await handle.setPosition(offset);
+      await handle.writeFrom(record);
+      _length += recordLength;
+
+      final previous = _index.remove(key);
+      if (previous != null) {
+        _liveBytes -= previous.recordLength;
+      }
+      _index[key] = _PackEntry(
+        recordOffset: offset,
+        recordLength: recordLength,
+        dataOffset: offset + recordHeaderSize + keyBytes.length,
+        dataLength: data.length,
+        checksum: _checksum(data),
+      );
+      _liveBytes += recordLength;
+
+      if (_length > maxBytes) {
+        await _compact(maxBytes ~/ 2);
+      }
+    });
+  }
+
+  Future<void> close() {
+    return _serialized(() async {
+      await _file?.close();
+      _file = null;
+      _index.clear();
+      _length = 0;
+      _liveBytes = 0;
+    });
+  }
+
+  Future<bool> _hasFileMagic(RandomAccessFile handle) async {
+    await handle.setPosition(0);
+    final bytes = await handle.read(fileMagic.length);
+    if (bytes.length != fileMagic.length) {
+      return false;
+    }
+    for (var index = 0; index < fileMagic.length; index++) {
+      if (bytes[index] != fileMagic[index]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Future<void> _reset(RandomAccessFile handle) async {
+    await handle.truncate(0);
+    await handle.setPosition(0);
+    await handle.writeFrom(fileMagic);
+    _length = fileMagic.length;
+    _index.clear();
+    _liveBytes = 0;
+  }
+
+  Future<void> _scan(RandomAccessFile handle) async {
+    var offset = fileMagic.length;
+    while (offset + recordHeaderSize <= _length) {
+      await handle.setPosition(offset);
+      final headerBytes = await handle.read(recordHeaderSize);
+      final header = ByteData.sublistView(headerBytes);
+      if (headerBytes.length != recordHeaderSize ||
+          header.getUint32(0, Endian.little) != recordMagic) {
+        break;
+      }
+      final keyLength = header.getUint32(4, Endian.little);
+      final dataLength = header.getUint32(8, Endian.little);
+      final recordLength = _align(recordHeaderSize + keyLength + dataLength);
+      if (offset + recordLength > _length) {
+        break;
+      }
+
+      final key = utf8.decode(
+        await handle.read(keyLength),
+        allowMalformed: true,
+      );
+      final previous = _index.remove(key);
+      if (previous != null) {
+        _liveBytes -= previous.recordLength;
+      }
+      _index[key] = _PackEntry(
+        recordOffset: offset,
+        recordLength: recordLength,
+        dataOffset: offset + recordHeaderSize + keyLength,
+        dataLength: dataLength,
+        checksum: header.getUint32(12, Endian.little),
+      );
+      _liveBytes += recordLength;
+      offset += recordLength;
+    }
+
+    if (offset < _length) {
+      // 上次写入被中断留下的残缺尾部
+      await handle.truncate(offset);
+      _length = offset;
+    }
+  }
+
+  /// 把最近使用的条目按 [budget] 重写到临时文件，再原子替换
+  Future<void> _compact(int budget) async {
+    final handle = _file;
+    if (handle == null) {
+      return;
+    }
+
+    final keep = <MapEntry<String, _PackEntry>>[];
+    var keptBytes = fileMagic.length;
+    for (final entry in _index.entries.toList().reversed) {
+      if (keptBytes + entry.value.recordLength > budget) {
+        break;
+      }
+      keep.add(entry);
+      keptBytes += entry.value.recordLength;
+    }
+
+    final tempFile = File('$path.compact');
+    final sink = await tempFile.open(mode: FileMode.write);
+    final newIndex = LinkedHashMap<String, _PackEntry>();
+    var offset = fileMagic.length;
+    try {
+      await sink.writeFrom(fileMagic);
+      for (final entry in keep.reversed) {
+        final old = entry.value;
+        await handle.setPosition(old.recordOffset);
+        final record = await handle.read(old.recordLength);
+        await sink.writeFrom(record);
+        newIndex[entry.key] = _PackEntry(
+          recordOffset: offset,
+          recordLength: old.recordLength,
+          dataOffset: offset + (old.dataOffset - old.recordOffset),
+          dataLength: old.dataLength,
+          checksum: old.checksum,
+        );
+        offset += old.recordLength;
+      }
+      await sink.flush();
+    } finally {
+      await sink.close();
+    }
+
+    await handle.close();
+    await tempFile.rename(path);
+    _file = await File(path).open(mode: FileMode.append);
+    _index
+      ..clear()
+      ..addAll(newIndex);
+    _length = offset;
+    _liveBytes = offset - fileMagic.length;
+  }
+
+  Future<T> _serialized<T>(Future<T> Function() action) {
+    final result = _tail.then((_) => action());
+    _tail = result.then<void>((_) {}, onError: (_) {});
+    return result;
+  }
+
+  static int _align(int length) {
+    return (length + alignment - 1) & ~(alignment - 1);
+  }
+
+  static int _checksum(List<int> data) {
+    return (Fnv1a64()..addBytes(data)).value & 0xffffffff;
+  }
+}
+
+class _PackEntry {
+  const _PackEntry({
+    required this.recordOffset,
+    required this.recordLength,
+    required this.dataOffset,
+    required this.dataLength,
+    required this.checksum,
+  });
+
+  final int recordOffset;
+  final int recordLength;
+  final int dataOffset;
+  final int dataLength;
+  final int checksum;
+}
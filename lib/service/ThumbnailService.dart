@@ -0,0 +1,305 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:typed_data';
+import 'dart:ui' as ui;
+
+import 'package:flutter/scheduler.dart';
+import 'package:path/path.dart' as p;
+import 'package:path_provider/path_provider.dart';
+import 'package:vertree/core/Fnv1a64.dart';
+import 'package:vertree/service/ThumbnailPack.dart';
+
+/// 某一类文件的预览生成器，返回编码后的图片数据（PNG 等）
+abstract class ThumbnailGenerator {
+  bool supports(String filePath);
+
+  Future<Uint8List?> generate(String filePath, int maxDimension);
+}
+
+/// 用引擎的图片解码器生成缩略图，解码时直接按目标尺寸缩放
+class ImageThumbnailGenerator implements ThumbnailGenerator {
+  const ImageThumbnailGenerator();
+
+  static const Set<String> extensions = {
+    '.png',
+    '.jpg',
+    '.jpeg',
+    '.gif',
+    '.webp',
+    '.bmp',
+  };
+
+  @override
+  bool supports(String filePath) {
+    return extensions.contains(p.extension(filePath).toLowerCase());
+  }
+
+  @override
+  Future<Uint8List?> generate(String filePath, int maxDimension) async {
+    final buffer = await ui.ImmutableBuffer.fromFilePath(filePath);
+    ui.ImageDescriptor? descriptor;
+    ui.Codec? codec;
+    ui.Image? image;
+    try {
+      descriptor = await ui.ImageDescriptor.encoded(buffer);
+      final longestSide = descriptor.width > descriptor.height
+          ? descriptor.width
+          : descriptor.height;
+      final ratio = longestSide > maxDimension
+          ? maxDimension / longestSide
+          : 1.0;
+      codec = await descriptor.instantiateCodec(
+        targetWidth: (descriptor.width * ratio).round().clamp(1, maxDimension),
+        targetHeight: (descriptor.height * ratio).round().clamp(
+          1,
+          maxDimension,
+        ),
+      );
+      image = (await codec.getNextFrame()).image;
+      final bytes = await image.toByteData(format: ui.ImageByteFormat.png);
+      return bytes?.buffer.asUint8List(
+        bytes.offsetInBytes,
+        bytes.lengthInBytes,
+      );
+    } finally {
+      image?.dispose();
+      codec?.dispose();
+      descriptor?.dispose();
+      buffer.dispose();
+    }
+  }
+}
+
+/// 一次缩略图请求；组件离开视口时调用 [cancel]
+class ThumbnailRequest {
+  ThumbnailRequest._(this.key, this._job, this._service);
+
+  final String key;
+  final _ThumbnailJob? _job;
+  final ThumbnailService? _service;
+  bool _cancelled = false;
+
+  bool get isCancelled => _cancelled;
+
+  Future<Uint8List?> get result =>
+      _job?.completer.future ?? Future<Uint8List?>.value(null);
+
+  void cancel() {
+    if (_cancelled) {
+      return;
+    }
+    _cancelled = true;
+    final job = _job;
+    if (job != null) {
+      _service?._release(job);
+    }
+  }
+}
+
+/// 版本文件的缩略图服务。
+///
+/// - 键由路径、大小与修改时间组成，文件变化后自然失效
+/// - 内存中按字节预算保留最近使用的结果，磁盘上由 [ThumbnailPack] 持久化
+/// - 生成任务在有限数量的槽位中执行，每个任务开始前都通过调度器排到空闲优先级，
+///   不与界面帧争抢；后请求的先处理，优先满足当前视口
+/// - 同一键的请求共享一个任务，所有请求都取消后尚未开始的任务直接丢弃
+class ThumbnailService {
+  ThumbnailService({
+    List<ThumbnailGenerator>? generators,
+    Future<ThumbnailPack?> Function()? openPack,
+    Future<void> Function()? yieldToIdle,
+    this.maxConcurrentJobs = 2,
+    this.memoryBudgetBytes = 24 * 1024 * 1024,
+    this.maxDimension = 256,
+  }) : generators = generators ?? const [ImageThumbnailGenerator()],
+       _openPack = openPack ?? _openDefaultPack,
+       _yieldToIdle = yieldToIdle ?? _defaultYieldToIdle;
+
+  final List<ThumbnailGenerator> generators;
+  final int maxConcurrentJobs;
+  final int memoryBudgetBytes;
+  final int maxDimension;
+  final Future<ThumbnailPack?> Function() _openPack;
+  final Future<void> Function() _yieldToIdle;
+
+  final LinkedHashMap<String, Uint8List> _memory =
+      LinkedHashMap<String, Uint8List>();
+  final Map<String, _ThumbnailJob> _jobs = {};
+  final ListQueue<_ThumbnailJob> _queue = ListQueue<_ThumbnailJob>();
+  Future<ThumbnailPack?>? _pack;
+  int _memoryBytes = 0;
+  int _running = 0;
+  int _generatedCount = 0;
+  int _diskHitCount = 0;
+  int _cancelledCount = 0;
+
+  static Future<ThumbnailPack?> _openDefaultPack() async {
+    final directory = await getApplicationSupportDirectory();
+    final pack = ThumbnailPack(
+      p.join(directory.path, 'thumbnails', 'thumbnails.pack'),
+    );
+    await pack.open();
+    return pack;
+  }
+
+  static Future<void> _defaultYieldToIdle() {
+    return SchedulerBinding.instance.scheduleTask<void>(() {}, Priority.idle);
+  }
+
+  bool supports(String filePath) {
+    return generators.any((generator) => generator.supports(filePath));
+  }
+
+  static String cacheKey(String filePath, int fileSize, DateTime modifiedAt) {
+    return Fnv1a64.hashFields([
+      filePath,
+      fileSize.toString(),
+      modifiedAt.microsecondsSinceEpoch.toString(),
+    ]);
+  }
+
+  /// 同步读取内存中的结果，用于首帧直接显示已有缩略图
+  Uint8List? peek(String filePath, int fileSize, DateTime modifiedAt) {
+    final key = cacheKey(filePath, fileSize, modifiedAt);
+    final bytes = _memory.remove(key);
+    if (bytes != null) {
+      _memory[key] = bytes;
+    }
+    return bytes;
+  }
+
+  ThumbnailRequest request(
+    String filePath,
+    int fileSize,
+    DateTime modifiedAt,
+  ) {
+    final key = cacheKey(filePath, fileSize, modifiedAt);
+    final cached = peek(filePath, fileSize, modifiedAt);
+    if (cached != null || !supports(filePath)) {
+      final job = _ThumbnailJob(key, filePath)..completer.complete(cached);
+      return ThumbnailRequest._(key, job, null);
+    }
+
+    final existing = _jobs[key];
+    if (existing != null) {
+      existing.waiters += 1;
+      if (!existing.started) {
+        // 再次被请求说明它又回到视口，排到下一个处理
+        _queue.remove(existing);
+        _queue.addLast(existing);
+      }
+      return ThumbnailRequest._(key, existing, this);
+    }
+
+    final job = _ThumbnailJob(key, filePath)..waiters = 1;
+    _jobs[key] = job;
+    _queue.addLast(job);
+    _pump();
+    return ThumbnailRequest._(key, job, this);
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'memoryEntries': _memory.length,
+      'memoryBytes': _memoryBytes,
+      'queued': _queue.length,
+      'running': _running,
+      'generated': _generatedCount,
+      'diskHits': _diskHitCount,
+      'cancelled': _cancelledCount,
+    };
+  }
+
+  void _release(_ThumbnailJob job) {
+    job.waiters -= 1;
+    if (job.waiters > 0 || job.started) {
+      return;
+    }
+    _queue.remove(job);
+    _jobs.remove(job.key);
+    _cancelledCount += 1;
+    if (!job.completer.isCompleted) {
+      job.completer.complete(null);
+    }
+  }
+
+  void _pump() {
+    while (_running < maxConcurrentJobs && _queue.isNotEmpty) {
+      final job = _queue.removeLast();
+      job.started = true;
+      _running += 1;
+      unawaited(
+        _run(job).whenComplete(() {
+          _running -= 1;
+          _jobs.remove(job.key);
+          _pump();
+        }),
+      );
+    }
+  }
+
+  Future<void> _run(_ThumbnailJob job) async {
+    Uint8List? bytes;
+    try {
+      await _yieldToIdle();
+      if (job.waiters > 0) {
+        bytes = await _produce(job);
+      } else {
+        // 等待空闲期间所有请求都已取消
+        _cancelledCount += 1;
+      }
+    } catch (_) {
+      // 文件已被删除、格式损坏等情况下不显示缩略图即可
+      bytes = null;
+    }
+
+    if (bytes != null) {
+      _remember(job.key, bytes);
+    }
+    if (!job.completer.isCompleted) {
+      job.completer.complete(bytes);
+    }
+  }
+
+  Future<Uint8List?> _produce(_ThumbnailJob job) async {
+    final pack = await (_pack ??= _openPack().catchError((_) => null));
+    final cached = await pack?.read(job.key);
+    if (cached != null) {
+      _diskHitCount += 1;
+      return cached;
+    }
+
+    final generator = generators.firstWhere(
+      (candidate) => candidate.supports(job.filePath),
+    );
+    final bytes = await generator.generate(job.filePath, maxDimension);
+    if (bytes != null) {
+      _generatedCount += 1;
+      await pack?.write(job.key, bytes);
+    }
+    return bytes;
+  }
+
+  void _remember(String key, Uint8List bytes) {
+    final previous = _memory.remove(key);
+    if (previous != null) {
+      _memoryBytes -= previous.length;
+    }
+    _memory[key] = bytes;
+    _memoryBytes += bytes.length;
+    while (_memoryBytes > memoryBudgetBytes && _memory.length > 1) {
+      final oldestKey = _memory.keys.first;
+      _memoryBytes -= _memory.remove(oldestKey)!.length;
+    }
+  }
+}
+
+class _ThumbnailJob {
+  _ThumbnailJob(this.key, this.filePath);
+
+  final String key;
+  final String filePath;
+  final Completer<Uint8List?> completer = Completer<Uint8List?>();
+  int waiters = 0;
+  bool started = false;
+}
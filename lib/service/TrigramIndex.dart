@@ -0,0 +1,409 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+/// 按字节三元组建立的倒排索引，用于在一组文本中快速筛出可能包含某些
+/// 字面量的文档。
+///
+/// - 三元组取自 UTF-8 字节，ASCII 字母折叠为小写，打包成 24 位整数
+/// - 文档号按加入顺序递增分配，倒排表存成区间 `[start, end)`：同一文件
+///   家族的版本内容相近、又按版本顺序加入，一个三元组通常只占少数几个区间
+/// - 删除只做标记，[compact] 时再按存活文档重新编号
+///
+/// 索引只给出候选，调用方需要读取原文确认是否真正匹配。
+class TrigramIndex {
+  final List<String?> _paths = [];
+  final Map<String, int> _ids = {};
+  final Map<int, _RunList> _postings = {};
+
+  /// 2^24 位的去重位图，提取单个文档的三元组时复用
+  final Uint8List _seen = Uint8List(1 << 21);
+  int _removedCount = 0;
+
+  int get documentCount => _ids.length;
+  int get removedCount => _removedCount;
+  int get trigramCount => _postings.length;
+  Iterable<String> get paths => _ids.keys;
+
+  int get runCount {
+    var total = 0;
+    for (final postings in _postings.values) {
+      total += postings.runCount;
+    }
+    return total;
+  }
+
+  /// 倒排表实际分配的字节数，不含 Map 本身的开销
+  int get postingBytes {
+    var total = 0;
+    for (final postings in _postings.values) {
+      total += postings.capacityBytes;
+    }
+    return total;
+  }
+
+  bool contains(String path) => _ids.containsKey(path);
+
+  /// 加入（或替换）一个文档
+  void add(String path, List<int> bytes) {
+    remove(path);
+    final id = _paths.length;
+    _paths.add(path);
+    _ids[path] = id;
+    for (final trigram in _distinctTrigrams(bytes)) {
+      (_postings[trigram] ??= _RunList()).add(id);
+    }
+  }
+
+  void remove(String path) {
+    final id = _ids.remove(path);
+    if (id != null) {
+      _paths[id] = null;
+      _removedCount += 1;
+    }
+  }
+
+  /// 包含 [literals] 中全部字面量的所有三元组的文档，按加入顺序返回。
+  ///
+  /// 短于 3 个字节的字面量不参与筛选；没有可用的三元组时返回全部文档。
+  List<String> candidates(Iterable<String> literals) {
+    _RunList? matched;
+    for (final literal in literals) {
+      for (final trigram in _distinctTrigrams(utf8.encode(literal))) {
+        final postings = _postings[trigram];
+        if (postings == null) {
+          return [];
+        }
+        matched = matched == null ? postings : matched.intersect(postings);
+        if (matched.runCount == 0) {
+          return [];
+        }
+      }
+    }
+    if (matched == null) {
+      return [
+        for (final path in _paths)
+          if (path != null) path,
+      ];
+    }
+
+    final result = <String>[];
+    for (var run = 0; run < matched.runCount; run++) {
+      for (var id = matched.startAt(run); id < matched.endAt(run); id++) {
+        final path = _paths[id];
+        if (path != null) {
+          result.add(path);
+        }
+      }
+    }
+    return result;
+  }
+
+  /// 丢弃已删除文档的编号。存活文档按原顺序重新编号，一个区间内的存活文档
+  /// 编号仍然连续，所以只需逐区间换算，不必展开倒排表。
+  void compact() {
+    if (_removedCount == 0) {
+      return;
+    }
+    // liveBefore[id] = 编号小于 id 的存活文档数
+    final liveBefore = Uint32List(_paths.length + 1);
+    for (var id = 0; id < _paths.length; id++) {
+      liveBefore[id + 1] = liveBefore[id] + (_paths[id] == null ? 0 : 1);
+    }
+
+    final emptied = <int>[];
+    _postings.forEach((trigram, postings) {
+      final remapped = _RunList();
+      for (var run = 0; run < postings.runCount; run++) {
+        remapped.addRun(
+          liveBefore[postings.startAt(run)],
+          liveBefore[postings.endAt(run)],
+        );
+      }
+      if (remapped.runCount == 0) {
+        emptied.add(trigram);
+      } else {
+        _postings[trigram] = remapped;
+      }
+    });
+    emptied.forEach(_postings.remove);
+
+    final live = [
+      for (final path in _paths)
+        if (path != null) path,
+    ];
+    _paths
+      ..clear()
+      ..addAll(live);
+    _ids.clear();
+    for (var id = 0; id < live.length; id++) {
+      _ids[live[id]] = id;
+    }
+    _removedCount = 0;
+  }
+
+  List<int> _distinctTrigrams(List<int> bytes) {
+    final trigrams = <int>[];
+    if (bytes.length < 3) {
+      return trigrams;
+    }
+    final seen = _seen;
+    var key = (_fold[bytes[0]] << 8) | _fold[bytes[1]];
+    for (var index = 2; index < bytes.length; index++) {
+      key = ((key << 8) | _fold[bytes[index]]) & 0xffffff;
+      final mask = 1 << (key & 7);
+      final slot = key >> 3;
+      if (seen[slot] & mask == 0) {
+        seen[slot] |= mask;
+        trigrams.add(key);
+      }
+    }
+    for (final trigram in trigrams) {
+      seen[trigram >> 3] = 0;
+    }
+    return trigrams;
+  }
+
+  static final Uint8List _fold = Uint8List.fromList([
+    for (var byte = 0; byte < 256; byte++)
+      byte >= 0x41 && byte <= 0x5a ? byte | 0x20 : byte,
+  ]);
+}
+
+/// 升序、互不相交的文档号区间
+class _RunList {
+  Uint32List _bounds = Uint32List(2);
+  int _length = 0;
+
+  int get runCount => _length >> 1;
+  int get capacityBytes => _bounds.lengthInBytes;
+  int startAt(int run) => _bounds[run * 2];
+  int endAt(int run) => _bounds[run * 2 + 1];
+
+  /// [id] 必须不小于已有的最大编号
+  void add(int id) => addRun(id, id + 1);
+
+  void addRun(int start, int end) {
+    if (start >= end) {
+      return;
+    }
+    if (_length > 0 && _bounds[_length - 1] >= start) {
+      if (end > _bounds[_length - 1]) {
+        _bounds[_length - 1] = end;
+      }
+      return;
+    }
+    if (_length == _bounds.length) {
+      _bounds = Uint32List(_bounds.length * 2)..setRange(0, _length, _bounds);
+    }
+    _bounds[_length++] = start;
+    _bounds[_length++] = end;
+  }
+
+  _RunList intersect(_RunList other) {
+    final result = _RunList();
+    var i = 0;
+    var j = 0;
+    while (i < runCount && j < other.runCount) {
+      final start = startAt(i) > other.startAt(j)
+          ? startAt(i)
+          : other.startAt(j);
+      final end = endAt(i) < other.endAt(j) ? endAt(i) : other.endAt(j);
+      result.addRun(start, end);
+      if (endAt(i) < other.endAt(j)) {
+        i++;
+      } else {
+        j++;
+      }
+    }
+    return result;
+  }
+}
+
+/// 从正则表达式中提取任何匹配都必然包含的字面量片段。
+///
+/// 只分析顶层的顺序拼接：顶层出现 `|` 时放弃筛选返回空列表；分组、字符类、
+/// `.`、`\d` 这类转义以及可省略的原子（后跟 `*`、`?`、`{0,…}`）都会截断
+/// 当前片段。[caseSensitive] 为 false 时非 ASCII 字符也会截断片段，因为
+/// 索引只折叠了 ASCII 的大小写。
+List<String> requiredRegexLiterals(
+  String pattern, {
+  bool caseSensitive = true,
+}) {
+  final literals = <String>[];
+  final current = StringBuffer();
+  void flush() {
+    if (current.isNotEmpty) {
+      literals.add(current.toString());
+      current.clear();
+    }
+  }
+
+  var index = 0;
+  while (index < pattern.length) {
+    final char = pattern[index];
+    String? literal;
+    var next = index + 1;
+    switch (char) {
+      case '|':
+        return [];
+      case '(':
+        next = _skipGroup(pattern, index);
+      case '[':
+        next = _skipClass(pattern, index);
+      case '.':
+      case '^':
+      case '\$':
+        break;
+      case '\\':
+        next = _skipEscape(pattern, index);
+        if (next == index + 2 &&
+            !RegExp(r'[0-9A-Za-z]').hasMatch(pattern[index + 1])) {
+          literal = pattern[index + 1];
+        }
+      default:
+        literal = char;
+        final unit = pattern.codeUnitAt(index);
+        if (unit >= 0xd800 && unit < 0xdc00 && index + 1 < pattern.length) {
+          literal = pattern.substring(index, index + 2);
+          next = index + 2;
+        }
+    }
+
+    // 原子后面的量词决定它是否必然出现
+    var required = true;
+    var repeated = false;
+    final atomEnd = next;
+    if (next < pattern.length) {
+      final quantifier = pattern[next];
+      if (quantifier == '*' || quantifier == '?') {
+        required = false;
+        next += 1;
+      } else if (quantifier == '+') {
+        repeated = true;
+        next += 1;
+      } else if (quantifier == '{') {
+        final match = RegExp(r'\{(\d+)(,\d*)?\}').matchAsPrefix(pattern, next);
+        if (match != null) {
+          required = int.parse(match.group(1)!) > 0;
+          repeated = true;
+          next = match.end;
+        }
+      }
+      // 惰性量词
+      if (next > atomEnd && next < pattern.length && pattern[next] == '?') {
+        next += 1;
+      }
+    }
+
+    if (literal == null ||
+        !required ||
+        (!caseSensitive && literal.codeUnitAt(0) > 0x7f)) {
+      flush();
+    } else {
+      current.write(literal);
+      if (repeated) {
+        flush();
+      }
+    }
+    index = next;
+  }
+  flush();
+  return literals;
+}
+
+/// 不区分大小写时按非 ASCII 字符切开字面量，理由同 [requiredRegexLiterals]
+List<String> foldableLiterals(String text, {bool caseSensitive = true}) {
+  if (caseSensitive) {
+    return [text];
+  }
+  return text
+      .split(RegExp(r'[^\x00-\x7f]+'))
+      .where((part) => part.isNotEmpty)
+      .toList();
+}
+
+/// `\xHH`、`\u{…}`、`\k<…>`、反向引用等转义都占用后面的字符，
+/// 不能把它们当成字面量
+int _skipEscape(String pattern, int start) {
+  final index = start + 1;
+  if (index >= pattern.length) {
+    return pattern.length;
+  }
+  int until(String terminator) {
+    final end = pattern.indexOf(terminator, index);
+    return end < 0 ? pattern.length : end + 1;
+  }
+
+  int fixed(int count) {
+    final end = index + 1 + count;
+    return end > pattern.length ? pattern.length : end;
+  }
+
+  switch (pattern[index]) {
+    case 'x':
+      return fixed(2);
+    case 'u':
+      return index + 1 < pattern.length && pattern[index + 1] == '{'
+          ? until('}')
+          : fixed(4);
+    case 'c':
+      return fixed(1);
+    case 'k':
+      return until('>');
+    case 'p':
+    case 'P':
+      return until('}');
+  }
+  var end = index + 1;
+  if (RegExp(r'[1-9]').hasMatch(pattern[index])) {
+    while (end < pattern.length && RegExp(r'\d').hasMatch(pattern[end])) {
+      end += 1;
+    }
+  }
+  return end;
+}
+
+int _skipGroup(String pattern, int start) {
+  var depth = 0;
+  var index = start;
+  while (index < pattern.length) {
+    final char = pattern[index];
+    if (char == '\\') {
+      index += 2;
+      continue;
+    }
+    if (char == '[') {
+      index = _skipClass(pattern, index);
+      continue;
+    }
+    if (char == '(') {
+      depth += 1;
+    } else if (char == ')') {
+      depth -= 1;
+      if (depth == 0) {
+        return index + 1;
+      }
+    }
+    index += 1;
+  }
+  return pattern.length;
+}
+
+int _skipClass(String pattern, int start) {
+  var index = start + 1;
+  if (index < pattern.length && pattern[index] == '^') {
+    index += 1;
+  }
+  while (index < pattern.length) {
+    final char = pattern[index];
+    if (char == '\\') {
+      index += 2;
+      continue;
+    }
+    if (char == ']') {
+      return index + 1;
+    }
+    index += 1;
+  }
+  return pattern.length;
+}
@@ -0,0 +1,654 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/TrigramIndex.dart';
+
+class VersionSearchQuery {
+  const VersionSearchQuery({
+    required this.text,
+    this.regex = false,
+    this.caseSensitive = false,
+    this.includeBackups = false,
+    this.maxResults = 200,
+    this.maxSnippets = 3,
+  });
+
+  /// 子串，或 [regex] 为 true 时的正则表达式
+  final String text;
+  final bool regex;
+  final bool caseSensitive;
+
+  /// 同时搜索各版本 `_bak` 目录中的监控快照
+  final bool includeBackups;
+  final int maxResults;
+
+  /// 每个文件最多返回的匹配行数
+  final int maxSnippets;
+}
+
+class VersionSearchSnippet {
+  const VersionSearchSnippet({required this.line, required this.text});
+
+  /// 从 1 开始的行号
+  final int line;
+  final String text;
+
+  Map<String, dynamic> toJson() => {'line': line, 'text': text};
+}
+
+class VersionSearchMatch {
+  const VersionSearchMatch({
+    required this.path,
+    required this.isBackup,
+    required this.matchCount,
+    required this.snippets,
+  });
+
+  final String path;
+  final bool isBackup;
+  final int matchCount;
+  final List<VersionSearchSnippet> snippets;
+
+  Map<String, dynamic> toJson() => {
+    'path': path,
+    'fullName': p.basename(path),
+    'kind': isBackup ? 'backup' : 'version',
+    'version': isBackup ? null : FileMeta.versionOf(path).toString(),
+    'matchCount': matchCount,
+    'snippets': snippets.map((snippet) => snippet.toJson()).toList(),
+  };
+}
+
+class VersionSearchResult {
+  const VersionSearchResult({
+    required this.sourcePath,
+    required this.query,
+    required this.documentCount,
+    required this.candidateCount,
+    required this.matches,
+    required this.truncated,
+    required this.index,
+    required this.indexElapsed,
+    required this.filterElapsed,
+    required this.verifyElapsed,
+  });
+
+  final String sourcePath;
+  final VersionSearchQuery query;
+
+  /// 参与搜索的文本文件数
+  final int documentCount;
+
+  /// 三元组筛选后需要读取原文确认的文件数
+  final int candidateCount;
+  final List<VersionSearchMatch> matches;
+  final bool truncated;
+  final Map<String, dynamic> index;
+  final Duration indexElapsed;
+  final Duration filterElapsed;
+  final Duration verifyElapsed;
+
+  Set<String> get matchedPaths => {for (final match in matches) match.path};
+
+  Map<String, dynamic> toJson() => {
+    'sourcePath': sourcePath,
+    'query': query.text,
+    'regex': query.regex,
+    'caseSensitive': query.caseSensitive,
+    'includeBackups': query.includeBackups,
+    'documentCount': documentCount,
+    'candidateCount': candidateCount,
+    'matchCount': matches.length,
+    'truncated': truncated,
+    'matches': matches.map((match) => match.toJson()).toList(),
+    'index': index,
+    'elapsedMicros': {
+      'index': indexElapsed.inMicroseconds,
+      'filter': filterElapsed.inMicroseconds,
+      'verify': verifyElapsed.inMicroseconds,
+    },
+  };
+}
+
+/// 在一个文件家族的所有版本（可选包括监控快照）中做全文搜索。
+///
+/// - 每个家族一份 [TrigramIndex]，常驻内存，按最近使用保留 [maxFamilies] 个
+/// - backup / branch 新建的版本与监控生成的快照通过事件增量加入索引；
+///   此外搜索时若距上次全量核对超过 [rescanInterval]，再按大小和修改时间
+///   核对目录，捕获应用之外的改动
+/// - 查询先用三元组筛出候选，再在后台 isolate 中读取原文逐个确认
+/// - 含 NUL 字节或超过 [maxFileBytes] 的文件视为不可搜索
+class VersionSearchService {
+  VersionSearchService({
+    Stream<String>? createdVersions,
+    Stream<ActivityEvent>? activityEvents,
+    this.maxFamilies = 8,
+    this.maxFileBytes = 16 * 1024 * 1024,
+    this.rescanInterval = const Duration(seconds: 10),
+    this.inlineUpdateLimit = 8,
+  }) {
+    _subscriptions.add(
+      (createdVersions ?? FileNode.createdVersions).listen(_onVersionCreated),
+    );
+    if (activityEvents != null) {
+      _subscriptions.add(activityEvents.listen(_onActivityEvent));
+    }
+  }
+
+  final int maxFamilies;
+  final int maxFileBytes;
+  final Duration rescanInterval;
+
+  /// 待更新的文件不超过这个数时直接在当前 isolate 中读取建索引
+  final int inlineUpdateLimit;
+
+  final LinkedHashMap<String, _SearchFamily> _families =
+      LinkedHashMap<String, _SearchFamily>();
+  final List<StreamSubscription<Object>> _subscriptions = [];
+  int _searchCount = 0;
+
+  Future<Result<VersionSearchResult, String>> search(
+    String filePath,
+    VersionSearchQuery query,
+  ) async {
+    if (query.text.isEmpty) {
+      return Result.eMsg('Search text must not be empty');
+    }
+    final normalizedPath = p.normalize(filePath);
+    if (!File(normalizedPath).existsSync()) {
+      return Result.eMsg('File does not exist: $normalizedPath');
+    }
+    if (!FileMeta.isSupportedTreeFilePath(normalizedPath)) {
+      return Result.eMsg('File name does not follow the version tree format');
+    }
+    try {
+      _buildPattern(query);
+    } on FormatException catch (e) {
+      return Result.eMsg('Invalid regular expression: ${e.message}');
+    }
+
+    final stopwatch = Stopwatch()..start();
+    final family = _familyFor(normalizedPath);
+    if (query.includeBackups && !family.includeBackups) {
+      family.includeBackups = true;
+      family.scannedAt = null;
+    }
+    try {
+      await family.run(() => _refresh(family));
+    } on FileSystemException catch (e) {
+      return Result.eMsg('Unable to index versions: ${e.message}');
+    }
+    final indexElapsed = stopwatch.elapsed;
+
+    stopwatch.reset();
+    final literals = query.regex
+        ? requiredRegexLiterals(
+            query.text,
+            caseSensitive: query.caseSensitive,
+          )
+        : foldableLiterals(query.text, caseSensitive: query.caseSensitive);
+    final candidates = family.index
+        .candidates(literals)
+        .where((path) => query.includeBackups || !family.isBackup(path))
+        .toList();
+    candidates.sort(family.compareDocuments);
+    final filterElapsed = stopwatch.elapsed;
+
+    stopwatch.reset();
+    final verified = await _verify(candidates, query, maxFileBytes);
+    final verifyElapsed = stopwatch.elapsed;
+    _searchCount += 1;
+
+    final documentCount = query.includeBackups
+        ? family.index.documentCount
+        : family.index.paths.where((path) => !family.isBackup(path)).length;
+    return Result.ok(
+      VersionSearchResult(
+        sourcePath: normalizedPath,
+        query: query,
+        documentCount: documentCount,
+        candidateCount: candidates.length,
+        matches: [
+          for (final (path, count, snippets) in verified.matches)
+            VersionSearchMatch(
+              path: path,
+              isBackup: family.isBackup(path),
+              matchCount: count,
+              snippets: snippets,
+            ),
+        ],
+        truncated: verified.truncated,
+        index: family.status(),
+        indexElapsed: indexElapsed,
+        filterElapsed: filterElapsed,
+        verifyElapsed: verifyElapsed,
+      ),
+    );
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'familyCount': _families.length,
+      'documentCount': _families.values.fold<int>(
+        0,
+        (total, family) => total + family.index.documentCount,
+      ),
+      'searchCount': _searchCount,
+    };
+  }
+
+  void dispose() {
+    for (final subscription in _subscriptions) {
+      subscription.cancel();
+    }
+    _subscriptions.clear();
+    _families.clear();
+  }
+
+  /// 家族由目录、名称与扩展名确定，与 buildTree 的筛选规则一致
+  _SearchFamily _familyFor(String filePath) {
+    final meta = FileMeta(filePath);
+    final key = _familyKey(p.dirname(filePath), meta.name, meta.extension);
+    final family =
+        _families.remove(key) ??
+        _SearchFamily(
+          directory: p.dirname(filePath),
+          name: meta.name,
+          extension: meta.extension,
+        );
+    _families[key] = family;
+    while (_families.length > maxFamilies) {
+      _families.remove(_families.keys.first);
+    }
+    return family;
+  }
+
+  _SearchFamily? _existingFamilyOf(String filePath) {
+    if (!FileMeta.isSupportedTreeFilePath(filePath)) {
+      return null;
+    }
+    final meta = FileMeta(filePath);
+    return _families[_familyKey(
+      p.dirname(p.normalize(filePath)),
+      meta.name,
+      meta.extension,
+    )];
+  }
+
+  static String _familyKey(String directory, String name, String extension) {
+    return '$directory\u0000$name\u0000$extension';
+  }
+
+  void _onVersionCreated(String filePath) {
+    final family = _existingFamilyOf(filePath);
+    if (family == null) {
+      return;
+    }
+    _schedule(family, [p.normalize(filePath)]);
+  }
+
+  void _onActivityEvent(ActivityEvent event) {
+    final filePath = event.data['filePath'];
+    if (filePath is! String) {
+      return;
+    }
+    final family = _existingFamilyOf(filePath);
+    if (family == null || !family.includeBackups) {
+      return;
+    }
+    if (event.type == ActivityEventType.snapshotFinished &&
+        event.data['success'] == true &&
+        event.data['backupPath'] is String) {
+      final backupPath = p.normalize(event.data['backupPath'] as String);
+      family.backupDirectories.add(p.dirname(backupPath));
+      _schedule(family, [backupPath]);
+    } else if (event.type == ActivityEventType.retentionPruned &&
+        event.data['deletedPaths'] is List) {
+      _schedule(family, [
+        for (final path in event.data['deletedPaths'] as List)
+          if (path is String) p.normalize(path),
+      ]);
+    }
+  }
+
+  void _schedule(_SearchFamily family, List<String> paths) {
+    // 失败的增量更新留给下一次全量核对补上
+    unawaited(family.run(() => _update(family, paths)).catchError((_) {}));
+  }
+
+  /// 全量核对：列出家族文件，只重新读取大小或修改时间变化过的
+  Future<void> _refresh(_SearchFamily family) async {
+    final scannedAt = family.scannedAt;
+    if (scannedAt != null &&
+        DateTime.now().difference(scannedAt) < rescanInterval) {
+      return;
+    }
+    final versions = <String>[];
+    await for (final entity in Directory(family.directory).list()) {
+      if (entity is File && family.isVersion(entity.path)) {
+        versions.add(p.normalize(entity.path));
+      }
+    }
+    final paths = [...versions];
+    if (family.includeBackups) {
+      for (final version in versions) {
+        final backupName = '${p.basenameWithoutExtension(version)}_bak';
+        family.backupDirectories.add(p.join(family.directory, backupName));
+      }
+      for (final directory in family.backupDirectories) {
+        final backupDir = Directory(directory);
+        if (!await backupDir.exists()) {
+          continue;
+        }
+        await for (final entity in backupDir.list(recursive: true)) {
+          if (entity is File && !SnapshotIndex.isMetadataPath(entity.path)) {
+            paths.add(p.normalize(entity.path));
+          }
+        }
+      }
+    }
+
+    final present = paths.toSet();
+    final gone = family.stamps.keys
+        .where((path) => !present.contains(path))
+        .toList();
+    await _update(family, [...paths, ...gone]);
+    family.scannedAt = DateTime.now();
+  }
+
+  /// 按当前的大小和修改时间更新 [paths] 对应的索引条目
+  Future<void> _update(_SearchFamily family, List<String> paths) async {
+    final changed = <String>[];
+    final removed = <String>[];
+    for (final path in paths) {
+      FileStat stat;
+      try {
+        stat = await File(path).stat();
+      } catch (_) {
+        removed.add(path);
+        continue;
+      }
+      if (stat.type != FileSystemEntityType.file) {
+        removed.add(path);
+        continue;
+      }
+      final stamp = _FileStamp(stat.size, stat.modified);
+      if (family.stamps[path] != stamp) {
+        family.stamps[path] = stamp;
+        changed.add(path);
+      }
+    }
+    for (final path in removed) {
+      family.stamps.remove(path);
+      family.index.remove(path);
+    }
+    if (changed.isEmpty) {
+      _maybeCompact(family);
+      return;
+    }
+
+    if (changed.length <= inlineUpdateLimit) {
+      _indexFiles(family.index, changed, maxFileBytes);
+    } else {
+      family.index = await _indexFilesInBackground(
+        family.index,
+        changed,
+        maxFileBytes,
+      );
+    }
+    _maybeCompact(family);
+  }
+
+  void _maybeCompact(_SearchFamily family) {
+    if (family.index.removedCount > family.index.documentCount) {
+      family.index.compact();
+    }
+  }
+
+  static Future<TrigramIndex> _indexFilesInBackground(
+    TrigramIndex index,
+    List<String> paths,
+    int maxFileBytes,
+  ) {
+    return Isolate.run(() {
+      _indexFiles(index, paths, maxFileBytes);
+      return index;
+    });
+  }
+
+  static Future<_VerifyOutcome> _verify(
+    List<String> candidates,
+    VersionSearchQuery query,
+    int maxFileBytes,
+  ) {
+    if (candidates.isEmpty) {
+      return Future.value(const _VerifyOutcome([], false));
+    }
+    final text = query.text;
+    final regex = query.regex;
+    final caseSensitive = query.caseSensitive;
+    final maxResults = query.maxResults;
+    final maxSnippets = query.maxSnippets;
+    return Isolate.run(
+      () => _verifyCandidates(
+        candidates,
+        _buildPattern(
+          VersionSearchQuery(
+            text: text,
+            regex: regex,
+            caseSensitive: caseSensitive,
+          ),
+        ),
+        maxResults: maxResults,
+        maxSnippets: maxSnippets,
+        maxFileBytes: maxFileBytes,
+      ),
+    );
+  }
+}
+
+class _FileStamp {
+  const _FileStamp(this.size, this.modifiedAt);
+
+  final int size;
+  final DateTime modifiedAt;
+
+  @override
+  bool operator ==(Object other) =>
+      other is _FileStamp &&
+      other.size == size &&
+      other.modifiedAt == modifiedAt;
+
+  @override
+  int get hashCode => Object.hash(size, modifiedAt);
+}
+
+class _SearchFamily {
+  _SearchFamily({
+    required this.directory,
+    required this.name,
+    required this.extension,
+  });
+
+  final String directory;
+  final String name;
+  final String extension;
+  TrigramIndex index = TrigramIndex();
+  final Map<String, _FileStamp> stamps = {};
+  final Set<String> backupDirectories = {};
+  bool includeBackups = false;
+  DateTime? scannedAt;
+  final Map<String, FileVersion> _versions = {};
+  Future<void> _tail = Future.value();
+
+  FileVersion _versionOf(String path) {
+    return _versions.putIfAbsent(path, () => FileMeta.versionOf(path));
+  }
+
+  /// 同一家族的索引更新与查询依次执行
+  Future<void> run(Future<void> Function() action) {
+    final next = _tail.then((_) => action());
+    _tail = next.catchError((_) {});
+    return next;
+  }
+
+  bool isVersion(String path) {
+    if (p.dirname(p.normalize(path)) != directory ||
+        !FileMeta.isSupportedTreeFilePath(path)) {
+      return false;
+    }
+    final meta = FileMeta(path);
+    return meta.name == name && meta.extension == extension;
+  }
+
+  bool isBackup(String path) => p.dirname(path) != directory;
+
+  /// 版本按版本号排序，快照按文件名（含时间戳）排在版本之后
+  int compareDocuments(String a, String b) {
+    final aBackup = isBackup(a);
+    final bBackup = isBackup(b);
+    if (aBackup != bBackup) {
+      return aBackup ? 1 : -1;
+    }
+    if (aBackup) {
+      return p.basename(a).compareTo(p.basename(b));
+    }
+    return _versionOf(a).compareTo(_versionOf(b));
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'documentCount': index.documentCount,
+      'trigramCount': index.trigramCount,
+      'postingRunCount': index.runCount,
+      'postingBytes': index.postingBytes,
+      'includeBackups': includeBackups,
+      'scannedAt': scannedAt?.toIso8601String(),
+    };
+  }
+}
+
+class _VerifyOutcome {
+  const _VerifyOutcome(this.matches, this.truncated);
+
+  final List<(String, int, List<VersionSearchSnippet>)> matches;
+  final bool truncated;
+}
+
+RegExp _buildPattern(VersionSearchQuery query) {
+  return RegExp(
+    query.regex ? query.text : RegExp.escape(query.text),
+    caseSensitive: query.caseSensitive,
+    multiLine: true,
+  );
+}
+
+/// 读取文本内容；二进制或过大的文件返回 null
+String? _readSearchableText(String path, int maxFileBytes) {
+  try {
+    final file = File(path);
+    if (file.lengthSync() > maxFileBytes) {
+      return null;
+    }
+    final bytes = file.readAsBytesSync();
+    final probe = bytes.length < 8192 ? bytes.length : 8192;
+    for (var index = 0; index < probe; index++) {
+      if (bytes[index] == 0) {
+        return null;
+      }
+    }
+    return utf8.decode(bytes, allowMalformed: true);
+  } catch (_) {
+    return null;
+  }
+}
+
+void _indexFiles(TrigramIndex index, List<String> paths, int maxFileBytes) {
+  for (final path in paths) {
+    final text = _readSearchableText(path, maxFileBytes);
+    if (text == null) {
+      index.remove(path);
+    } else {
+      index.add(path, utf8.encode(text));
+    }
+  }
+}
+
+/// 空匹配（如 `^`、`a*` 匹配到空串）不计入结果
+_VerifyOutcome _verifyCandidates(
+  List<String> candidates,
+  RegExp pattern, {
+  required int maxResults,
+  required int maxSnippets,
+  required int maxFileBytes,
+}) {
+  const maxSnippetLength = 240;
+  final matches = <(String, int, List<VersionSearchSnippet>)>[];
+  for (final path in candidates) {
+    final text = _readSearchableText(path, maxFileBytes);
+    if (text == null) {
+      continue;
+    }
+    var count = 0;
+    var line = 1;
+    var lineStart = 0;
+    var scanned = 0;
+    var lastSnippetLine = 0;
+    final snippets = <VersionSearchSnippet>[];
+    for (final match in pattern.allMatches(text)) {
+      if (match.end == match.start) {
+        continue;
+      }
+      count += 1;
+      if (snippets.length >= maxSnippets) {
+        continue;
+      }
+      for (; scanned < match.start; scanned++) {
+        if (text.codeUnitAt(scanned) == 0x0a) {
+          line += 1;
+          lineStart = scanned + 1;
+        }
+      }
+      if (line == lastSnippetLine) {
+        continue;
+      }
+      lastSnippetLine = line;
+      var lineEnd = text.indexOf('\n', match.start);
+      if (lineEnd < 0) {
+        lineEnd = text.length;
+      }
+      var snippetStart = lineStart;
+      if (lineEnd - snippetStart > maxSnippetLength) {
+        snippetStart = match.start - maxSnippetLength ~/ 4;
+        if (snippetStart < lineStart) {
+          snippetStart = lineStart;
+        }
+      }
+      final snippetEnd = lineEnd - snippetStart > maxSnippetLength
+          ? snippetStart + maxSnippetLength
+          : lineEnd;
+      snippets.add(
+        VersionSearchSnippet(
+          line: line,
+          text: text.substring(snippetStart, snippetEnd).trimRight(),
+        ),
+      );
+    }
+    if (count == 0) {
+      continue;
+    }
+    if (matches.length == maxResults) {
+      return _VerifyOutcome(matches, true);
+    }
+    matches.add((path, count, snippets));
+  }
+  return _VerifyOutcome(matches, false);
+}
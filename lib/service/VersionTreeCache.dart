@@ -0,0 +1,499 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:path/path.dart' as p;
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Fnv1a64.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+
+typedef VersionTreeBuilder =
+    Future<Result<FileNode, String>> Function(String filePath);
+typedef DirectoryWatchFactory =
+    Stream<FileSystemEvent> Function(String directoryPath);
+
+/// 版本树接口的裁剪与分页参数
+class VersionTreeQuery {
+  const VersionTreeQuery({
+    this.maxDepth,
+    this.maxBranches,
+    this.flat = false,
+    this.cursor,
+    this.limit = defaultPageSize,
+    this.includeChanges = false,
+  });
+
+  static const int defaultPageSize = 500;
+  static const int maxPageSize = 5000;
+
+  /// 分支嵌套层数上限，0 表示只返回主线；为空时不限制
+  final int? maxDepth;
+
+  /// 每个节点最多返回的分支数；为空时不限制
+  final int? maxBranches;
+
+  /// 为 true 时按节点平铺并分页返回，否则返回嵌套结构
+  final bool flat;
+
+  /// 平铺模式下上一页返回的 nextCursor
+  final String? cursor;
+
+  /// 平铺模式下每页的节点数
+  final int limit;
+
+  /// 为 true 时每个节点附带相对父版本的变化比例 changeFromParent，
+  /// 需要先填充 [VersionTreeSnapshot.changeEstimates]
+  final bool includeChanges;
+
+  String get _limitsKey =>
+      '${maxDepth ?? '-'}:${maxBranches ?? '-'}:$includeChanges';
+}
+
+/// 一次构建得到的版本树及其 ETag。
+///
+/// ETag 由同族文件的文件名、大小与修改时间计算，同一目录状态总是得到同一个值。
+class VersionTreeSnapshot {
+  VersionTreeSnapshot(this.sourcePath, this.root)
+    : etag = _computeETag(sourcePath, root);
+
+  final String sourcePath;
+  final FileNode root;
+  final String etag;
+
+  late final Map<String, dynamic> summary = _summarize(root);
+
+  /// 各版本相对父版本的变化比例（0 ~ 1），以版本文件路径为键。
+  /// 内容由 ETag 覆盖的文件大小与修改时间决定，随快照一起缓存
+  Map<String, double>? changeEstimates;
+  final Map<String, List<_FlatTreeEntry>> _flattenedByLimits = {};
+
+  /// 按查询参数渲染响应数据。
+  ///
+  /// 节点以带 toJson 的轻量对象返回，JSON 编码器按需逐个展开，
+  /// 不会先在内存里拼出整棵树的 Map。
+  Result<Map<String, dynamic>, String> render(VersionTreeQuery query) {
+    final limits = {
+      'maxDepth': query.maxDepth,
+      'maxBranches': query.maxBranches,
+    };
+    if (!query.flat) {
+      if (query.cursor != null) {
+        return Result.eMsg('Query parameter "cursor" requires format=flat.');
+      }
+      return Result.ok({
+        'sourcePath': sourcePath,
+        'etag': etag,
+        'summary': summary,
+        'format': 'nested',
+        'limits': limits,
+        'root': _NestedTreeNodeJson(root, 0, query, _changesFor(query)),
+      });
+    }
+
+    final offsetResult = _decodeCursor(query.cursor);
+    if (offsetResult.isErr) {
+      return Result.eMsg(offsetResult.msg);
+    }
+    final offset = offsetResult.unwrap();
+    final entries = _flattenedByLimits.putIfAbsent(
+      query._limitsKey,
+      () => _flatten(query),
+    );
+    final start = offset.clamp(0, entries.length);
+    final end = (start + query.limit).clamp(0, entries.length);
+    final nextCursor = end < entries.length ? _encodeCursor(end) : null;
+
+    return Result.ok({
+      'sourcePath': sourcePath,
+      'etag': etag,
+      'summary': summary,
+      'format': 'flat',
+      'limits': limits,
+      'page': {
+        'offset': start,
+        'limit': query.limit,
+        'returned': end - start,
+        'totalMatched': entries.length,
+        'nextCursor': nextCursor,
+      },
+      'nodes': entries.sublist(start, end),
+    });
+  }
+
+  Map<String, double>? _changesFor(VersionTreeQuery query) {
+    return query.includeChanges ? changeEstimates ?? const {} : null;
+  }
+
+  /// 前序展开：节点本身，其次各分支子树，最后主线上的下一个版本。
+  /// 用显式栈代替递归，避免长主线时调用栈过深。
+  List<_FlatTreeEntry> _flatten(VersionTreeQuery query) {
+    final changes = _changesFor(query);
+    final entries = <_FlatTreeEntry>[];
+    final stack = <_FlatTreeEntry>[
+      _FlatTreeEntry(root, null, 'root', 0, query, changes),
+    ];
+    while (stack.isNotEmpty) {
+      final entry = stack.removeLast();
+      entries.add(entry);
+
+      final node = entry.node;
+      if (node.child != null) {
+        stack.add(
+          _FlatTreeEntry(
+            node.child!,
+            node,
+            'child',
+            entry.depth,
+            query,
+            changes,
+          ),
+        );
+      }
+      final branches = _visibleBranches(node, entry.depth, query);
+      for (var index = branches.length - 1; index >= 0; index--) {
+        stack.add(
+          _FlatTreeEntry(
+            branches[index],
+            node,
+            'branch',
+            entry.depth + 1,
+            query,
+            changes,
+          ),
+        );
+      }
+    }
+    return entries;
+  }
+
+  String _encodeCursor(int offset) {
+    return base64Url.encode(utf8.encode('$offset|$etag'));
+  }
+
+  Result<int, String> _decodeCursor(String? cursor) {
+    if (cursor == null || cursor.isEmpty) {
+      return Result.ok(0);
+    }
+
+    String decoded;
+    try {
+      decoded = utf8.decode(base64Url.decode(base64Url.normalize(cursor)));
+    } on FormatException {
+      return Result.eMsg('Query parameter "cursor" is not a valid cursor.');
+    }
+    final separator = decoded.indexOf('|');
+    final offset = separator <= 0
+        ? null
+        : int.tryParse(decoded.substring(0, separator));
+    if (offset == null || offset < 0) {
+      return Result.eMsg('Query parameter "cursor" is not a valid cursor.');
+    }
+    if (decoded.substring(separator + 1) != etag) {
+      return Result.eMsg(
+        'The version tree changed after this cursor was issued; restart from the first page.',
+      );
+    }
+    return Result.ok(offset);
+  }
+
+  static String _computeETag(String sourcePath, FileNode root) {
+    final nodes = <FileNode>[];
+    final stack = <FileNode>[root];
+    while (stack.isNotEmpty) {
+      final node = stack.removeLast();
+      nodes.add(node);
+      if (node.child != null) {
+        stack.add(node.child!);
+      }
+      stack.addAll(node.branches);
+    }
+    nodes.sort((a, b) => a.mate.fullName.compareTo(b.mate.fullName));
+
+    final hash = Fnv1a64()..addField(sourcePath);
+    for (final node in nodes) {
+      hash
+        ..addField(node.mate.fullName)
+        ..addField(node.mate.fileSize.toString())
+        ..addField(
+          node.mate.lastModifiedTime.microsecondsSinceEpoch.toString(),
+        );
+    }
+
+    return '"vt-${nodes.length}-${hash.toHex()}"';
+  }
+
+  static Map<String, dynamic> _summarize(FileNode root) {
+    var totalNodes = 0;
+    var branchNodes = 0;
+    FileNode? latest;
+
+    final stack = <FileNode>[root];
+    while (stack.isNotEmpty) {
+      final node = stack.removeLast();
+      totalNodes += 1;
+      if (latest == null ||
+          latest.mate.version.compareTo(node.mate.version) < 0) {
+        latest = node;
+      }
+      branchNodes += node.branches.length;
+      if (node.child != null) {
+        stack.add(node.child!);
+      }
+      stack.addAll(node.branches);
+    }
+
+    return {
+      'rootVersion': root.mate.version.toString(),
+      'latestVersion': latest?.mate.version.toString(),
+      'totalNodes': totalNodes,
+      'branchNodes': branchNodes,
+    };
+  }
+}
+
+List<FileNode> _visibleBranches(
+  FileNode node,
+  int depth,
+  VersionTreeQuery query,
+) {
+  final maxDepth = query.maxDepth;
+  if (maxDepth != null && depth >= maxDepth) {
+    return const [];
+  }
+  final maxBranches = query.maxBranches;
+  if (maxBranches != null && node.branches.length > maxBranches) {
+    return node.branches.sublist(0, maxBranches);
+  }
+  return node.branches;
+}
+
+Map<String, dynamic> _nodeFields(
+  FileNode node,
+  Map<String, double>? changes,
+) {
+  return {
+    'path': node.mate.fullPath,
+    'fullName': node.mate.fullName,
+    'name': node.mate.name,
+    'label': node.mate.label,
+    'extension': node.mate.extension,
+    'version': node.mate.version.toString(),
+    if (changes != null)
+      'changeFromParent': _roundChange(changes[node.mate.fullPath]),
+  };
+}
+
+double? _roundChange(double? change) {
+  return change == null ? null : (change * 10000).round() / 10000;
+}
+
+class _NestedTreeNodeJson {
+  const _NestedTreeNodeJson(this.node, this.depth, this.query, this.changes);
+
+  final FileNode node;
+  final int depth;
+  final VersionTreeQuery query;
+  final Map<String, double>? changes;
+
+  Map<String, dynamic> toJson() {
+    final branches = _visibleBranches(node, depth, query);
+    final truncated = node.branches.length - branches.length;
+    return {
+      ..._nodeFields(node, changes),
+      'child': node.child == null
+          ? null
+          : _NestedTreeNodeJson(node.child!, depth, query, changes),
+      'branches': [
+        for (final branch in branches)
+          _NestedTreeNodeJson(branch, depth + 1, query, changes),
+      ],
+      if (truncated > 0) 'truncatedBranchCount': truncated,
+    };
+  }
+}
+
+class _FlatTreeEntry {
+  const _FlatTreeEntry(
+    this.node,
+    this.parent,
+    this.relation,
+    this.depth,
+    this.query,
+    this.changes,
+  );
+
+  final FileNode node;
+  final FileNode? parent;
+
+  /// root / child / branch
+  final String relation;
+
+  /// 所在的分支嵌套层数，主线为 0
+  final int depth;
+  final VersionTreeQuery query;
+  final Map<String, double>? changes;
+
+  Map<String, dynamic> toJson() {
+    final visibleBranchCount = _visibleBranches(node, depth, query).length;
+    return {
+      ..._nodeFields(node, changes),
+      'parentVersion': parent?.mate.version.toString(),
+      'relation': relation,
+      'depth': depth,
+      'hasChild': node.child != null,
+      'branchCount': visibleBranchCount,
+      'truncatedBranchCount': node.branches.length - visibleBranchCount,
+    };
+  }
+}
+
+/// 按文件缓存版本树，并用目录监听在文件变化时失效。
+///
+/// 只有在对应目录的监听仍然有效时才会缓存，因此 [peekETag] 命中即说明
+/// 自构建以来目录没有变化，HTTP 层可以直接回 304 而无需访问文件系统。
+/// 监听事件是异步送达的，刚写入文件后的极短时间内仍可能返回旧的 ETag。
+class VersionTreeCache {
+  VersionTreeCache({
+    this.capacity = defaultCapacity,
+    VersionTreeBuilder? builder,
+    DirectoryWatchFactory? watchDirectory,
+  }) : _builder = builder ?? buildTree,
+       _watchDirectory = watchDirectory ?? _defaultWatchDirectory;
+
+  static const int defaultCapacity = 32;
+
+  final int capacity;
+  final VersionTreeBuilder _builder;
+  final DirectoryWatchFactory _watchDirectory;
+
+  /// 插入顺序即最近使用顺序，命中时移到末尾
+  final LinkedHashMap<String, VersionTreeSnapshot> _entries =
+      LinkedHashMap<String, VersionTreeSnapshot>();
+  final Map<String, _DirectoryWatch> _watches = {};
+
+  int _hits = 0;
+  int _misses = 0;
+
+  static Stream<FileSystemEvent> _defaultWatchDirectory(String directoryPath) {
+    return Directory(directoryPath).watch();
+  }
+
+  /// 返回仍然有效的缓存 ETag，不访问文件系统
+  String? peekETag(String filePath) => _entries[filePath]?.etag;
+
+  Future<Result<VersionTreeSnapshot, String>> load(String filePath) async {
+    final cached = _entries.remove(filePath);
+    if (cached != null) {
+      _entries[filePath] = cached;
+      _hits += 1;
+      return Result.ok(cached);
+    }
+    _misses += 1;
+
+    // 先建立监听再构建，构建期间发生的变化会让这次结果不进入缓存
+    final watch = _ensureWatch(p.dirname(filePath));
+    final generation = watch?.generation;
+
+    final result = await _builder(filePath);
+    if (result.isErr) {
+      _releaseIdleWatches();
+      return Result.eMsg(result.msg);
+    }
+
+    final snapshot = VersionTreeSnapshot(filePath, result.unwrap());
+    if (watch != null && watch.isActive && watch.generation == generation) {
+      _entries[filePath] = snapshot;
+      while (_entries.length > capacity) {
+        _entries.remove(_entries.keys.first);
+      }
+    }
+    _releaseIdleWatches();
+    return Result.ok(snapshot);
+  }
+
+  void invalidate(String filePath) {
+    _entries.remove(filePath);
+    _releaseIdleWatches();
+  }
+
+  Map<String, dynamic> status() {
+    return {
+      'cachedTrees': _entries.length,
+      'capacity': capacity,
+      'watchedDirectories': _watches.length,
+      'hits': _hits,
+      'misses': _misses,
+    };
+  }
+
+  Future<void> clear() async {
+    _entries.clear();
+    final watches = _watches.values.toList();
+    _watches.clear();
+    for (final watch in watches) {
+      await watch.cancel();
+    }
+  }
+
+  _DirectoryWatch? _ensureWatch(String directoryPath) {
+    final existing = _watches[directoryPath];
+    if (existing != null) {
+      return existing;
+    }
+
+    final watch = _DirectoryWatch();
+    try {
+      watch.subscription = _watchDirectory(directoryPath).listen(
+        (_) => _invalidateDirectory(directoryPath),
+        onError: (_) => _dropWatch(directoryPath),
+        onDone: () => _dropWatch(directoryPath),
+        cancelOnError: true,
+      );
+    } catch (_) {
+      // 平台或文件系统不支持监听时退化为每次重新构建
+      return null;
+    }
+    _watches[directoryPath] = watch;
+    return watch;
+  }
+
+  void _invalidateDirectory(String directoryPath) {
+    _watches[directoryPath]?.generation += 1;
+    _entries.removeWhere((path, _) => p.dirname(path) == directoryPath);
+  }
+
+  void _dropWatch(String directoryPath) {
+    final watch = _watches.remove(directoryPath);
+    if (watch == null) {
+      return;
+    }
+    watch.isActive = false;
+    _entries.removeWhere((path, _) => p.dirname(path) == directoryPath);
+    unawaited(watch.cancel());
+  }
+
+  /// 目录下已没有缓存条目时取消监听，避免长期占用 inotify 等系统资源
+  void _releaseIdleWatches() {
+    final usedDirectories = _entries.keys.map(p.dirname).toSet();
+    final idle = _watches.keys
+        .where((directoryPath) => !usedDirectories.contains(directoryPath))
+        .toList();
+    for (final directoryPath in idle) {
+      final watch = _watches.remove(directoryPath)!;
+      watch.isActive = false;
+      unawaited(watch.cancel());
+    }
+  }
+}
+
+class _DirectoryWatch {
+  StreamSubscription<FileSystemEvent>? subscription;
+  int generation = 0;
+  bool isActive = true;
+
+  Future<void> cancel() async {
+    await subscription?.cancel();
+  }
+}
@@ -0,0 +1,147 @@
+import 'dart:async';
+
+import 'package:flutter/material.dart';
+import 'package:path/path.dart' as p;
+import 'package:vertree/component/FileUtils.dart';
+import 'package:vertree/component/I18nLang.dart';
+import 'package:vertree/core/VersionCopy.dart';
+import 'package:vertree/main.dart';
+
+/// 在 [until] 完成前列出正在进行的版本复制，每项可单独取消。
+///
+/// 由版本树在备份或建分支超过片刻仍未完成时弹出，[until] 完成后自行关闭。
+class VersionCopyProgressDialog extends StatefulWidget {
+  const VersionCopyProgressDialog({super.key, required this.until});
+
+  final Future<Object?> until;
+
+  /// [future] 在 [delay] 内未完成且确有复制在进行时才显示对话框，
+  /// 小文件的备份不会闪一下
+  static Future<T> showWhileRunning<T>(
+    BuildContext context,
+    Future<T> future, {
+    Duration delay = const Duration(milliseconds: 400),
+  }) async {
+    var completed = false;
+    final timer = Timer(delay, () {
+      if (completed || !context.mounted || VersionCopy.active.isEmpty) {
+        return;
+      }
+      showDialog<void>(
+        context: context,
+        barrierDismissible: false,
+        builder: (_) => VersionCopyProgressDialog(until: future),
+      );
+    });
+    try {
+      return await future;
+    } finally {
+      completed = true;
+      timer.cancel();
+    }
+  }
+
+  @override
+  State<VersionCopyProgressDialog> createState() =>
+      _VersionCopyProgressDialogState();
+}
+
+class _VersionCopyProgressDialogState extends State<VersionCopyProgressDialog> {
+  StreamSubscription<VersionCopyTask>? _subscription;
+  bool _closed = false;
+
+  @override
+  void initState() {
+    super.initState();
+    _subscription = VersionCopy.updates.listen((_) {
+      if (mounted) {
+        setState(() {});
+      }
+    });
+    widget.until.then<void>((_) => _close(), onError: (_) => _close());
+  }
+
+  @override
+  void dispose() {
+    _subscription?.cancel();
+    super.dispose();
+  }
+
+  void _close() {
+    if (_closed || !mounted) {
+      return;
+    }
+    _closed = true;
+    Navigator.of(context).pop();
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final tasks = VersionCopy.active;
+    return AlertDialog(
+      title: Text(appLocale.getText(LocaleKey.filetree_copyProgressTitle)),
+      content: SizedBox(
+        width: 420,
+        child: Column(
+          mainAxisSize: MainAxisSize.min,
+          children: [
+            if (tasks.isEmpty) const LinearProgressIndicator(),
+            for (final task in tasks) _buildTask(context, task),
+          ],
+        ),
+      ),
+    );
+  }
+
+  Widget _buildTask(BuildContext context, VersionCopyTask task) {
+    final theme = Theme.of(context);
+    final fraction = task.totalBytes == 0
+        ? null
+        : task.copiedBytes / task.totalBytes;
+    var detail = appLocale.getText(LocaleKey.filetree_copyProgressBytes).tr([
+      FileUtils.formatBytes(task.copiedBytes),
+      FileUtils.formatBytes(task.totalBytes),
+    ]);
+    if (task.resumedFromBytes > 0) {
+      final resumed = appLocale
+          .getText(LocaleKey.filetree_copyResumed)
+          .tr([FileUtils.formatBytes(task.resumedFromBytes)]);
+      detail = '$detail · $resumed';
+    }
+    return Padding(
+      padding: const EdgeInsets.symmetric(vertical: 6),
+      child: Row(
+        children: [
+          Expanded(
+            child: Column(
+              crossAxisAlignment: CrossAxisAlignment.start,
+              children: [
+                Text(
+                  p.basename(task.targetPath),
+                  overflow: TextOverflow.ellipsis,
+                  style: theme.textTheme.bodyMedium,
+                ),
+                const SizedBox(height: 6),
+                LinearProgressIndicator(value: fraction),
+                const SizedBox(height: 4),
+                Text(
+                  detail,
+                  style: theme.textTheme.bodySmall?.copyWith(
+                    color: theme.colorScheme.onSurfaceVariant,
+                  ),
+                ),
+              ],
+            ),
+          ),
+          const SizedBox(width: 12),
+          TextButton(
+            onPressed: task.isCancelRequested
+                ? null
+                : () => setState(task.cancel),
+            child: Text(appLocale.getText(LocaleKey.filetree_inputCancel)),
+          ),
+        ],
+      ),
+    );
+  }
+}
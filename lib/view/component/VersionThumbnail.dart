@@ -0,0 +1,121 @@
+import 'dart:typed_data';
+
+import 'package:flutter/material.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/service/ThumbnailService.dart';
+
+/// 版本卡片上的缩略图。
+///
+/// 挂载时才向 [ThumbnailService] 请求，卸载（例如被画布虚拟化移出视口）时取消，
+/// 所以只有可见节点会占用生成队列。
+class VersionThumbnail extends StatefulWidget {
+  const VersionThumbnail({
+    super.key,
+    required this.fileMeta,
+    required this.service,
+    this.height = defaultHeight,
+  });
+
+  static const double defaultHeight = 96;
+
+  final FileMeta fileMeta;
+  final ThumbnailService service;
+  final double height;
+
+  @override
+  State<VersionThumbnail> createState() => _VersionThumbnailState();
+}
+
+class _VersionThumbnailState extends State<VersionThumbnail> {
+  ThumbnailRequest? _request;
+  Uint8List? _bytes;
+  bool _failed = false;
+
+  @override
+  void initState() {
+    super.initState();
+    _load();
+  }
+
+  @override
+  void didUpdateWidget(covariant VersionThumbnail oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    final oldMeta = oldWidget.fileMeta;
+    final meta = widget.fileMeta;
+    if (oldMeta.fullPath != meta.fullPath ||
+        oldMeta.fileSize != meta.fileSize ||
+        oldMeta.lastModifiedTime != meta.lastModifiedTime ||
+        oldWidget.service != widget.service) {
+      _request?.cancel();
+      _load();
+    }
+  }
+
+  void _load() {
+    final meta = widget.fileMeta;
+    _failed = false;
+    _bytes = widget.service.peek(
+      meta.fullPath,
+      meta.fileSize,
+      meta.lastModifiedTime,
+    );
+    if (_bytes != null) {
+      _request = null;
+      return;
+    }
+
+    final request = widget.service.request(
+      meta.fullPath,
+      meta.fileSize,
+      meta.lastModifiedTime,
+    );
+    _request = request;
+    request.result.then((bytes) {
+      if (!mounted || request.isCancelled || _request != request) {
+        return;
+      }
+      setState(() {
+        _bytes = bytes;
+        _failed = bytes == null;
+      });
+    });
+  }
+
+  @override
+  void dispose() {
+    _request?.cancel();
+    super.dispose();
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final scheme = Theme.of(context).colorScheme;
+    final bytes = _bytes;
+    return ClipRRect(
+      borderRadius: BorderRadius.circular(12),
+      child: SizedBox(
+        height: widget.height,
+        width: double.infinity,
+        child: bytes != null
+            ? Image.memory(
+                bytes,
+                fit: BoxFit.cover,
+                gaplessPlayback: true,
+                filterQuality: FilterQuality.medium,
+              )
+            : ColoredBox(
+                color: scheme.surfaceContainerHighest.withValues(alpha: 0.6),
+                child: Center(
+                  child: Icon(
+                    _failed
+                        ? Icons.broken_image_outlined
+                        : Icons.image_outlined,
+                    size: 22,
+                    color: scheme.onSurfaceVariant.withValues(alpha: 0.7),
+                  ),
+                ),
+              ),
+      ),
+    );
+  }
+}
@@ -3,6 +3,8 @@ import 'package:flutter/material.dart';
 import 'package:flutter/services.dart';
 import 'package:vertree/view/component/tree/CanvasComponent.dart';
 import 'package:vertree/view/component/tree/EdgePainter.dart';
+import 'package:vertree/view/component/tree/NodeOverviewPainter.dart';
+import 'package:vertree/view/component/tree/SpatialGridIndex.dart';
 import 'CanvasManager.dart';
 
 class TreeCanvas extends StatefulWidget {
@@ -14,6 +16,9 @@ class TreeCanvas extends StatefulWidget {
   final List<Edge>? edges;
   final int revision;
 
+  /// 缩放比例低于该值时不再构建节点卡片，只画色块；鼠标悬停的节点仍显示卡片
+  final double detailScale;
+
   final Future<void> Function() refresh;
 
   const TreeCanvas({
@@ -25,18 +30,46 @@ class TreeCanvas extends StatefulWidget {
     this.children,
     this.edges,
     this.revision = 0,
+    this.detailScale = defaultDetailScale,
     required this.refresh,
   });
 
+  static const double defaultDetailScale = 0.45;
+
   @override
   _TreeCanvasState createState() => _TreeCanvasState();
 }
 
 class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
   static const double _fitPadding = 40;
+
+  /// 视口四周额外实例化组件的范围（屏幕像素），平移时不会在边缘频繁挂载/卸载
+  static const double _viewportMargin = 320;
   final Map<String, CanvasComponentContainer> components = {};
+
+  /// 带有布局包围盒的组件登记在空间索引里，只有与视口相交的才会构建 widget
+  final SpatialGridIndex<String> _spatialIndex = SpatialGridIndex<String>();
+
+  /// 当前已实例化的组件及其覆盖的场景区域；视口仍在该区域内时直接复用
+  List<CanvasComponentContainer>? _materializedComponents;
+  Rect? _materializedRect;
+
+  /// 上面的列表是缩小模式下的结果（只含悬停节点和没有包围盒的组件）
+  bool _materializedOverview = false;
+  String? _materializedHoverId;
   int indexCounter = 0; // 控制 index 递增
   List<Edge> edges = []; // 存储所有的连线
+  final EdgePictureCache _edgePictureCache = EdgePictureCache();
+  int _edgesRevision = 0;
+  bool _hasLiveEdges = false;
+
+  /// 缩小模式下的节点色块，组件或包围盒变化后在下次绘制时重新收集
+  final NodeOverviewCache _overviewCache = NodeOverviewCache();
+  List<(Rect, NodeOverviewTone)>? _overviewNodes;
+  int _overviewRevision = 0;
+
+  /// 缩小模式下鼠标所在的节点，只有它会构建完整卡片
+  String? _hoveredId;
 
   bool isDragging = false;
 
@@ -64,6 +97,13 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
     super.initState();
   }
 
+  @override
+  void dispose() {
+    _edgePictureCache.dispose();
+    _overviewCache.dispose();
+    super.dispose();
+  }
+
   @override
   void didUpdateWidget(covariant TreeCanvas oldWidget) {
     super.didUpdateWidget(oldWidget);
@@ -109,6 +149,8 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
         },
         child: MouseRegion(
           cursor: _cursor,
+          onHover: _updateHover,
+          onExit: (_) => _setHoveredId(null),
           child: SizedBox(
             height: widget.height,
             width: widget.width,
@@ -126,23 +168,44 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
                       child: Stack(
                         clipBehavior: Clip.none,
                         children: [
-                          CustomPaint(
-                            size: sceneSize,
-                            painter: FileTreeCanvasPainter(
-                              edges,
-                              Offset.zero,
-                              color: scheme.outlineVariant.withValues(
-                                alpha: 0.92,
+                          // 独立图层：平移缩放只变换已合成的连线图层，不触发重绘
+                          RepaintBoundary(
+                            child: CustomPaint(
+                              size: sceneSize,
+                              painter: FileTreeCanvasPainter(
+                                edges,
+                                Offset.zero,
+                                color: scheme.outlineVariant.withValues(
+                                  alpha: 0.92,
+                                ),
+                                debugColor: scheme.primary,
+                                labelColor: scheme.onSurfaceVariant,
+                                labelBackground: scheme.surfaceContainerHigh,
+                                revision: _edgesRevision,
+                                cache: _edgePictureCache,
+                                repaint: _hasLiveEdges
+                                    ? widget.manager.repaintNotifier
+                                    : null,
                               ),
-                              debugColor: scheme.primary,
-                              repaint: widget.manager.repaintNotifier,
                             ),
                           ),
-                          ...(components.values.toList()
-                                ..sort((a, b) => a.index.compareTo(b.index)))
-                              .map((e) {
-                                return e.canvasComponent;
-                              }),
+                          if (_showsOverview)
+                            RepaintBoundary(
+                              child: CustomPaint(
+                                size: sceneSize,
+                                painter: NodeOverviewPainter(
+                                  _collectOverviewNodes(),
+                                  color: scheme.secondaryContainer,
+                                  focusedColor: scheme.primary,
+                                  highlightedColor: scheme.tertiary,
+                                  revision: _overviewRevision,
+                                  cache: _overviewCache,
+                                ),
+                              ),
+                            ),
+                          ..._visibleComponents().map((e) {
+                            return e.canvasComponent;
+                          }),
                         ],
                       ),
                     ),
@@ -178,11 +241,153 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
   void add(CanvasComponentContainer canvasComponentContainer) {
     canvasComponentContainer.index = indexCounter++;
     components[canvasComponentContainer.id] = canvasComponentContainer;
+    _indexComponent(canvasComponentContainer);
+  }
+
+  void _indexComponent(CanvasComponentContainer container) {
+    final bounds = container.bounds;
+    if (bounds == null) {
+      _spatialIndex.remove(container.id);
+    } else {
+      _spatialIndex.insert(container.id, bounds);
+    }
+    _invalidateVisibleComponents();
+    _invalidateOverview();
+  }
+
+  void _invalidateOverview() {
+    _overviewNodes = null;
+    _overviewRevision += 1;
+  }
+
+  bool get _showsOverview => _scale < widget.detailScale;
+
+  List<(Rect, NodeOverviewTone)> _collectOverviewNodes() {
+    return _overviewNodes ??= [
+      for (final component in components.values)
+        if (component.bounds case final bounds?)
+          (bounds, component.overviewTone),
+    ];
+  }
+
+  /// 缩小模式下找出鼠标下层级最高的节点
+  void _updateHover(PointerHoverEvent event) {
+    if (!_showsOverview) {
+      _setHoveredId(null);
+      return;
+    }
+    final scenePoint = (event.localPosition - canvasPosition) / _scale;
+    String? hoveredId;
+    var hoveredIndex = -1;
+    final probe = Rect.fromCenter(center: scenePoint, width: 1, height: 1);
+    for (final id in _spatialIndex.query(probe)) {
+      final component = components[id];
+      final bounds = component?.bounds;
+      if (component != null &&
+          bounds != null &&
+          bounds.contains(scenePoint) &&
+          component.index > hoveredIndex) {
+        hoveredId = id;
+        hoveredIndex = component.index;
+      }
+    }
+    _setHoveredId(hoveredId);
+  }
+
+  void _setHoveredId(String? id) {
+    if (_hoveredId == id) {
+      return;
+    }
+    setState(() {
+      _hoveredId = id;
+    });
+  }
+
+  void _invalidateVisibleComponents() {
+    _materializedComponents = null;
+    _materializedRect = null;
+  }
+
+  /// 当前视口在场景坐标系中的矩形
+  Rect _viewportSceneRect() {
+    return Rect.fromLTWH(
+      -canvasPosition.dx / _scale,
+      -canvasPosition.dy / _scale,
+      widget.width / _scale,
+      widget.height / _scale,
+    );
+  }
+
+  /// 返回需要构建 widget 的组件（按层级排序）。
+  ///
+  /// 视口离开上次实例化的区域时才重新查询空间索引，并把区域向外扩展
+  /// [_viewportMargin]，因此连续平移的大多数帧都直接复用上一次的列表，
+  /// 已挂载的组件保持不动，离开区域的组件被卸载、其 GlobalKey 在重新进入时复用。
+  List<CanvasComponentContainer> _visibleComponents() {
+    if (_showsOverview) {
+      return _overviewComponents();
+    }
+    final viewport = _viewportSceneRect();
+    final cached = _materializedComponents;
+    final materializedRect = _materializedRect;
+    if (cached != null &&
+        !_materializedOverview &&
+        materializedRect != null &&
+        materializedRect.left <= viewport.left &&
+        materializedRect.top <= viewport.top &&
+        materializedRect.right >= viewport.right &&
+        materializedRect.bottom >= viewport.bottom) {
+      return cached;
+    }
+
+    final queryRect = viewport.inflate(_viewportMargin / _scale);
+    final visibleIds = _spatialIndex.query(queryRect).toSet();
+    final visible =
+        components.values
+            .where(
+              (component) =>
+                  component.bounds == null || visibleIds.contains(component.id),
+            )
+            .toList()
+          ..sort((a, b) => a.index.compareTo(b.index));
+
+    _materializedComponents = visible;
+    _materializedRect = queryRect;
+    _materializedOverview = false;
+    return visible;
+  }
+
+  /// 缩小模式下只构建悬停的节点和没有包围盒的组件，其余节点由色块代替
+  List<CanvasComponentContainer> _overviewComponents() {
+    final cached = _materializedComponents;
+    if (cached != null &&
+        _materializedOverview &&
+        _materializedHoverId == _hoveredId) {
+      return cached;
+    }
+    final visible =
+        components.values
+            .where(
+              (component) =>
+                  component.bounds == null || component.id == _hoveredId,
+            )
+            .toList()
+          ..sort((a, b) => a.index.compareTo(b.index));
+
+    _materializedComponents = visible;
+    _materializedRect = null;
+    _materializedOverview = true;
+    _materializedHoverId = _hoveredId;
+    return visible;
   }
 
   void _syncCanvasContent() {
     components.clear();
+    _spatialIndex.clear();
+    _invalidateVisibleComponents();
+    _invalidateOverview();
     edges = [...widget.edges ?? []];
+    _onEdgesChanged();
     indexCounter = 0;
 
     if (widget.children != null) {
@@ -192,6 +397,36 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
     }
   }
 
+  void _onEdgesChanged() {
+    _edgesRevision += 1;
+    _hasLiveEdges = edges.any(
+      (edge) => edge.startCenter == null || edge.endCenter == null,
+    );
+  }
+
+  /// 组件包围盒变化后同步更新与之相连的连线端点
+  void _moveEdgeEndpoints(CanvasComponentContainer container) {
+    final center = container.bounds?.center;
+    edges = [
+      for (final edge in edges)
+        if (edge.startPoint == container.key || edge.endPoint == container.key)
+          Edge(
+            edge.startPoint,
+            edge.endPoint,
+            id: edge.id,
+            startCenter: edge.startPoint == container.key
+                ? center
+                : edge.startCenter,
+            endCenter: edge.endPoint == container.key ? center : edge.endCenter,
+            changeRatio: edge.changeRatio,
+            labelDistance: edge.labelDistance,
+          )
+        else
+          edge,
+    ];
+    _onEdgesChanged();
+  }
+
   double getScale() {
     return _scale;
   }
@@ -255,19 +490,34 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
         globalKey,
         indexCounter++,
       );
+      _invalidateVisibleComponents();
     });
     return canvasComponent.id;
   }
 
   void move(String id, Offset offset) {
     setState(() {
-      components[id]?.key.currentState?.position += offset;
+      final container = components[id];
+      container?.key.currentState?.position += offset;
+      final bounds = container?.bounds;
+      if (container != null && bounds != null) {
+        container.bounds = bounds.shift(offset);
+        _indexComponent(container);
+        _moveEdgeEndpoints(container);
+      }
     });
   }
 
   void jump(String id, Offset position) {
     setState(() {
-      components[id]?.key.currentState?.setPosition(position);
+      final container = components[id];
+      container?.key.currentState?.setPosition(position);
+      final bounds = container?.bounds;
+      if (container != null && bounds != null) {
+        container.bounds = position & bounds.size;
+        _indexComponent(container);
+        _moveEdgeEndpoints(container);
+      }
     });
   }
 
@@ -289,7 +539,7 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
     container.index = upper.index;
     upper.index = tempIndex;
 
-    setState(() {});
+    setState(_invalidateVisibleComponents);
   }
 
   /// 降低一层：与下方（index 更小）的那个组件交换 index
@@ -311,7 +561,7 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
     container.index = lower.index;
     lower.index = tempIndex;
 
-    setState(() {});
+    setState(_invalidateVisibleComponents);
   }
 
   void connectPoints(String startId, String endId) {
@@ -322,8 +572,15 @@ class _TreeCanvasState extends State<TreeCanvas> with TickerProviderStateMixin {
 
     setState(() {
       edges.add(
-        Edge(startComponent.key, endComponent.key, id: '$startId->$endId'),
+        Edge(
+          startComponent.key,
+          endComponent.key,
+          id: '$startId->$endId',
+          startCenter: startComponent.bounds?.center,
+          endCenter: endComponent.bounds?.center,
+        ),
       );
+      _onEdgesChanged();
     });
   }
 }
@@ -334,10 +591,23 @@ class CanvasComponentContainer {
   late final GlobalKey<CanvasComponentState> key;
   late int index; // 组件的层级 index
 
-  CanvasComponentContainer(this.canvasComponent, this.key, this.index)
-    : id = canvasComponent.id;
-
-  CanvasComponentContainer.component(this.canvasComponent)
-    : id = canvasComponent.id,
-      key = canvasComponent.canvasComponentKey;
+  /// 组件在场景坐标中的布局包围盒；为空时组件始终被构建
+  Rect? bounds;
+
+  /// 缩小模式下色块的样式
+  final NodeOverviewTone overviewTone;
+
+  CanvasComponentContainer(
+    this.canvasComponent,
+    this.key,
+    this.index, {
+    this.overviewTone = NodeOverviewTone.normal,
+  }) : id = canvasComponent.id;
+
+  CanvasComponentContainer.component(
+    this.canvasComponent, {
+    this.bounds,
+    this.overviewTone = NodeOverviewTone.normal,
+  }) : id = canvasComponent.id,
+       key = canvasComponent.canvasComponentKey;
 }
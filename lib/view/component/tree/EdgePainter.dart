@@ -1,4 +1,6 @@
 import 'dart:math';
+import 'dart:ui' show Picture, PictureRecorder, PointMode;
+
 import 'package:flutter/material.dart';
 import 'package:vertree/view/component/tree/CanvasComponent.dart';
 
@@ -7,7 +9,245 @@ class Edge {
   final GlobalKey<CanvasComponentState> endPoint;
   final String id;
 
-  Edge(this.startPoint, this.endPoint, {required this.id});
+  /// 布局得到的端点中心；为空时从已挂载组件读取实时位置
+  final Offset? startCenter;
+  final Offset? endCenter;
+
+  /// 子版本相对父版本的估算变化比例（0 ~ 1），为空时不标注
+  final double? changeRatio;
+
+  /// 标注中心到终点中心的水平距离，让标注落在子版本卡片左侧的空隙里
+  final double labelDistance;
+
+  Edge(
+    this.startPoint,
+    this.endPoint, {
+    required this.id,
+    this.startCenter,
+    this.endCenter,
+    this.changeRatio,
+    this.labelDistance = 0,
+  });
+
+  Edge withChangeRatio(double? ratio) {
+    return Edge(
+      startPoint,
+      endPoint,
+      id: id,
+      startCenter: startCenter,
+      endCenter: endCenter,
+      changeRatio: ratio,
+      labelDistance: labelDistance,
+    );
+  }
+}
+
+/// 把连线录制成可复用的 [Picture]。
+///
+/// 端点来自布局结果（[Edge.startCenter] / [Edge.endCenter]），不依赖组件是否挂载，
+/// 所以只有连线列表或样式变化时才需要重新录制；平移、缩放只是对缓存图片做变换。
+class EdgePictureCache {
+  Picture? _picture;
+  int? _revision;
+  Color? _color;
+  Color? _debugColor;
+  Color? _labelColor;
+  Color? _labelBackground;
+  bool? _showDebugPoints;
+  List<Edge> _liveEdges = const [];
+
+  /// 缺少布局中心点、需要每帧从组件状态读取端点的连线
+  List<Edge> get liveEdges => _liveEdges;
+
+  Picture pictureFor({
+    required int revision,
+    required List<Edge> edges,
+    required Color color,
+    required Color debugColor,
+    required Color labelColor,
+    required Color labelBackground,
+    required bool showDebugPoints,
+  }) {
+    final cached = _picture;
+    if (cached != null &&
+        _revision == revision &&
+        _color == color &&
+        _debugColor == debugColor &&
+        _labelColor == labelColor &&
+        _labelBackground == labelBackground &&
+        _showDebugPoints == showDebugPoints) {
+      return cached;
+    }
+
+    final staticEdges = <Edge>[];
+    final liveEdges = <Edge>[];
+    for (final edge in edges) {
+      if (edge.startCenter != null && edge.endCenter != null) {
+        staticEdges.add(edge);
+      } else {
+        liveEdges.add(edge);
+      }
+    }
+
+    final recorder = PictureRecorder();
+    final canvas = Canvas(recorder);
+    paintEdges(
+      canvas,
+      staticEdges.map((edge) => (edge.startCenter!, edge.endCenter!)),
+      color: color,
+      debugColor: debugColor,
+      showDebugPoints: showDebugPoints,
+    );
+    paintChangeLabels(
+      canvas,
+      staticEdges,
+      color: labelColor,
+      background: labelBackground,
+    );
+
+    cached?.dispose();
+    _picture = recorder.endRecording();
+    _revision = revision;
+    _color = color;
+    _debugColor = debugColor;
+    _labelColor = labelColor;
+    _labelBackground = labelBackground;
+    _showDebugPoints = showDebugPoints;
+    _liveEdges = liveEdges;
+    return _picture!;
+  }
+
+  void dispose() {
+    _picture?.dispose();
+    _picture = null;
+    _revision = null;
+  }
+}
+
+/// 同一样式的所有连线合并进一条 [Path]，只调用一次 drawPath
+void paintEdges(
+  Canvas canvas,
+  Iterable<(Offset, Offset)> segments, {
+  required Color color,
+  required Color debugColor,
+  bool showDebugPoints = false,
+  Offset baseOffset = Offset.zero,
+}) {
+  final path = Path();
+  final debugPoints = showDebugPoints ? <Offset>[] : null;
+  for (final (start, end) in segments) {
+    _appendEdgePath(path, start + baseOffset, end + baseOffset, debugPoints);
+  }
+
+  canvas.drawPath(
+    path,
+    Paint()
+      ..color = color
+      ..strokeWidth = 2.0
+      ..style = PaintingStyle.stroke,
+  );
+
+  if (debugPoints != null && debugPoints.isNotEmpty) {
+    // 调试用：绘制关键点
+    canvas.drawPoints(
+      PointMode.points,
+      debugPoints,
+      Paint()
+        ..color = debugColor
+        ..strokeWidth = 4.0
+        ..strokeCap = StrokeCap.round,
+    );
+  }
+}
+
+/// 在有估算结果的连线末端标出变化比例，端点取布局结果
+void paintChangeLabels(
+  Canvas canvas,
+  Iterable<Edge> edges, {
+  required Color color,
+  required Color background,
+  Offset baseOffset = Offset.zero,
+}) {
+  final fill = Paint()..color = background;
+  final style = TextStyle(
+    color: color,
+    fontSize: 10,
+    fontWeight: FontWeight.w600,
+  );
+  for (final edge in edges) {
+    final ratio = edge.changeRatio;
+    final end = edge.endCenter;
+    if (ratio == null || end == null) {
+      continue;
+    }
+    final painter = TextPainter(
+      text: TextSpan(text: formatChangeRatio(ratio), style: style),
+      textDirection: TextDirection.ltr,
+    )..layout();
+    final rect = Rect.fromCenter(
+      center: end + baseOffset - Offset(edge.labelDistance, 0),
+      width: painter.width + 8,
+      height: painter.height + 2,
+    );
+    canvas.drawRRect(
+      RRect.fromRectAndRadius(rect, const Radius.circular(6)),
+      fill,
+    );
+    painter.paint(canvas, rect.topLeft + const Offset(4, 1));
+    painter.dispose();
+  }
+}
+
+String formatChangeRatio(double ratio) {
+  if (ratio <= 0) {
+    return '0%';
+  }
+  if (ratio < 0.01) {
+    return '<1%';
+  }
+  return '${(ratio * 100).round()}%';
+}
+
+void _appendEdgePath(Path path, Offset s, Offset e, List<Offset>? debugPoints) {
+  // 计算水平和垂直的差值
+  double dx = e.dx - s.dx;
+  double dy = e.dy - s.dy;
+
+  // 计算圆角半径，取dx和dy的最小绝对值，如果大于20则为20
+  double dynamicR = min(dx.abs(), dy.abs());
+  double r = dynamicR > 20 ? 20 : dynamicR;
+
+  // 如果水平或垂直距离不足圆角半径，则直接绘制直线
+  if (dx.abs() < r || dy.abs() < r) {
+    path.moveTo(s.dx, s.dy);
+    path.lineTo(e.dx, e.dy);
+    return;
+  }
+
+  // 固定采用【先垂直后水平】的路线，拐角设为 (s.dx, e.dy)
+  // 计算垂直段终点 p1（预留圆角空间）
+  Offset p1 = dy > 0 ? Offset(s.dx, e.dy - r) : Offset(s.dx, e.dy + r);
+  // 计算水平段起点 p2（预留圆角空间）
+  Offset p2 = dx > 0 ? Offset(s.dx + r, e.dy) : Offset(s.dx - r, e.dy);
+
+  // 根据 dx 和 dy 确定圆角绘制方向：
+  // 如果 endPoint 在右侧（dx > 0）则统一采用 clockwise = true；
+  // 如果在左侧（dx < 0）：若 endPoint 在下方 (dy > 0) 则 clockwise = false，
+  // 若在上方 (dy < 0) 则 clockwise = true。
+  bool clockwise;
+  if (dx > 0) {
+    clockwise = dy > 0 ? false : true;
+  } else {
+    clockwise = dy < 0 ? false : true;
+  }
+
+  path.moveTo(s.dx, s.dy);
+  path.lineTo(p1.dx, p1.dy);
+  path.arcToPoint(p2, radius: Radius.circular(r), clockwise: clockwise);
+  path.lineTo(e.dx, e.dy);
+
+  debugPoints?.add(p1);
+  debugPoints?.add(p2);
 }
 
 class FileTreeCanvasPainter extends CustomPainter {
@@ -16,7 +256,12 @@ class FileTreeCanvasPainter extends CustomPainter {
   final bool showDebugPoints; // 调试点开关
   final Color color;
   final Color debugColor;
-  final Listenable repaint;
+  final Color labelColor;
+  final Color labelBackground;
+
+  /// 连线列表的版本号，变化时才重新录制缓存
+  final int revision;
+  final EdgePictureCache? cache;
 
   FileTreeCanvasPainter(
     this.edges,
@@ -24,78 +269,84 @@ class FileTreeCanvasPainter extends CustomPainter {
     this.showDebugPoints = false,
     required this.color,
     required this.debugColor,
-    required this.repaint,
+    required this.labelColor,
+    required this.labelBackground,
+    this.revision = 0,
+    this.cache,
+    Listenable? repaint,
   }) : super(repaint: repaint);
 
   @override
   void paint(Canvas canvas, Size size) {
-    // 调试用：绘制关键点的画笔
-    final debugPaint = Paint()
-      ..color = debugColor
-      ..strokeWidth = 4.0
-      ..style = PaintingStyle.fill;
-
-    for (var edge in edges) {
-      final paint = Paint()
-        ..color = color
-        ..strokeWidth = 2.0
-        ..style = PaintingStyle.stroke;
-
-      // 获取起点和终点的中心位置，并加上基础偏移
-      var start =
-          edge.startPoint.currentState?.getCenterPosition() ?? Offset.zero;
-      var end = edge.endPoint.currentState?.getCenterPosition() ?? Offset.zero;
-      Offset s = start + baseOffset;
-      Offset e = end + baseOffset;
-
-      // 计算水平和垂直的差值
-      double dx = e.dx - s.dx;
-      double dy = e.dy - s.dy;
-
-      // 计算圆角半径，取dx和dy的最小绝对值，如果大于20则为20
-      double dynamicR = min(dx.abs(), dy.abs());
-      double r = dynamicR > 20 ? 20 : dynamicR;
-
-      Path path = Path();
-
-      // 如果水平或垂直距离不足圆角半径，则直接绘制直线
-      if (dx.abs() < r || dy.abs() < r) {
-        path.moveTo(s.dx, s.dy);
-        path.lineTo(e.dx, e.dy);
-      } else {
-        // 固定采用【先垂直后水平】的路线，拐角设为 (s.dx, e.dy)
-        // 计算垂直段终点 p1（预留圆角空间）
-        Offset p1 = dy > 0 ? Offset(s.dx, e.dy - r) : Offset(s.dx, e.dy + r);
-        // 计算水平段起点 p2（预留圆角空间）
-        Offset p2 = dx > 0 ? Offset(s.dx + r, e.dy) : Offset(s.dx - r, e.dy);
-
-        // 根据 dx 和 dy 确定圆角绘制方向：
-        // 如果 endPoint 在右侧（dx > 0）则统一采用 clockwise = true；
-        // 如果在左侧（dx < 0）：若 endPoint 在下方 (dy > 0) 则 clockwise = false，
-        // 若在上方 (dy < 0) 则 clockwise = true。
-        bool clockwise;
-        if (dx > 0) {
-          clockwise = dy > 0 ? false : true;
-        } else {
-          clockwise = dy < 0 ? false : true;
-        }
-
-        path.moveTo(s.dx, s.dy);
-        path.lineTo(p1.dx, p1.dy);
-        path.arcToPoint(p2, radius: Radius.circular(r), clockwise: clockwise);
-        path.lineTo(e.dx, e.dy);
-
-        // 如果打开调试点，则绘制关键点
-        if (showDebugPoints) {
-          canvas.drawCircle(p1, 2, debugPaint);
-          canvas.drawCircle(p2, 2, debugPaint);
-        }
-      }
+    final cache = this.cache;
+    if (cache == null) {
+      paintEdges(
+        canvas,
+        edges.map(_resolveLiveEndpoints),
+        color: color,
+        debugColor: debugColor,
+        showDebugPoints: showDebugPoints,
+        baseOffset: baseOffset,
+      );
+      paintChangeLabels(
+        canvas,
+        edges,
+        color: labelColor,
+        background: labelBackground,
+        baseOffset: baseOffset,
+      );
+      return;
+    }
+
+    final picture = cache.pictureFor(
+      revision: revision,
+      edges: edges,
+      color: color,
+      debugColor: debugColor,
+      labelColor: labelColor,
+      labelBackground: labelBackground,
+      showDebugPoints: showDebugPoints,
+    );
+    canvas.save();
+    canvas.translate(baseOffset.dx, baseOffset.dy);
+    canvas.drawPicture(picture);
+    canvas.restore();
 
-      canvas.drawPath(path, paint);
+    if (cache.liveEdges.isNotEmpty) {
+      paintEdges(
+        canvas,
+        cache.liveEdges.map(_resolveLiveEndpoints),
+        color: color,
+        debugColor: debugColor,
+        showDebugPoints: showDebugPoints,
+        baseOffset: baseOffset,
+      );
     }
   }
 
+  /// 获取起点和终点的中心位置：优先布局结果，其次已挂载组件的实际位置
+  (Offset, Offset) _resolveLiveEndpoints(Edge edge) {
+    final start =
+        edge.startCenter ??
+        edge.startPoint.currentState?.getCenterPosition() ??
+        Offset.zero;
+    final end =
+        edge.endCenter ??
+        edge.endPoint.currentState?.getCenterPosition() ??
+        Offset.zero;
+    return (start, end);
+  }
+
   @override
-  bool shouldRepaint(CustomPainter oldDelegate) => true;
+  bool shouldRepaint(FileTreeCanvasPainter oldDelegate) {
+    return oldDelegate.revision != revision ||
+        !identical(oldDelegate.edges, edges) ||
+        oldDelegate.cache != cache ||
+        oldDelegate.baseOffset != baseOffset ||
+        oldDelegate.color != color ||
+        oldDelegate.debugColor != debugColor ||
+        oldDelegate.labelColor != labelColor ||
+        oldDelegate.labelBackground != labelBackground ||
+        oldDelegate.showDebugPoints != showDebugPoints;
+  }
 }
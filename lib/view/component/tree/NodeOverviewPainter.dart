@@ -0,0 +1,134 @@
+import 'dart:ui' show Picture, PictureRecorder;
+
+import 'package:flutter/material.dart';
+
+/// 缩小后节点色块的样式
+enum NodeOverviewTone { normal, focused, highlighted }
+
+/// 缩小到卡片文字无法辨认时，用布局包围盒画出的节点色块。
+///
+/// 同一样式的色块合并进一条 [Path]，每种样式只调用一次 drawPath；
+/// 结果录制成 [Picture]，只有节点或颜色变化时才重新录制，平移缩放只变换图片。
+class NodeOverviewCache {
+  Picture? _picture;
+  int? _revision;
+  Color? _color;
+  Color? _focusedColor;
+  Color? _highlightedColor;
+
+  Picture pictureFor({
+    required int revision,
+    required List<(Rect, NodeOverviewTone)> nodes,
+    required Color color,
+    required Color focusedColor,
+    required Color highlightedColor,
+  }) {
+    final cached = _picture;
+    if (cached != null &&
+        _revision == revision &&
+        _color == color &&
+        _focusedColor == focusedColor &&
+        _highlightedColor == highlightedColor) {
+      return cached;
+    }
+
+    final recorder = PictureRecorder();
+    paintNodeOverview(
+      Canvas(recorder),
+      nodes,
+      color: color,
+      focusedColor: focusedColor,
+      highlightedColor: highlightedColor,
+    );
+    cached?.dispose();
+    _picture = recorder.endRecording();
+    _revision = revision;
+    _color = color;
+    _focusedColor = focusedColor;
+    _highlightedColor = highlightedColor;
+    return _picture!;
+  }
+
+  void dispose() {
+    _picture?.dispose();
+    _picture = null;
+    _revision = null;
+  }
+}
+
+/// 按样式分组画出全部色块，圆角与卡片一致
+void paintNodeOverview(
+  Canvas canvas,
+  Iterable<(Rect, NodeOverviewTone)> nodes, {
+  required Color color,
+  required Color focusedColor,
+  required Color highlightedColor,
+}) {
+  final paths = {for (final tone in NodeOverviewTone.values) tone: Path()};
+  for (final (rect, tone) in nodes) {
+    final radius = Radius.circular(rect.shortestSide * 0.2);
+    paths[tone]!.addRRect(RRect.fromRectAndRadius(rect, radius));
+  }
+  final colors = {
+    NodeOverviewTone.normal: color,
+    NodeOverviewTone.focused: focusedColor,
+    NodeOverviewTone.highlighted: highlightedColor,
+  };
+  for (final MapEntry(key: tone, value: path) in paths.entries) {
+    canvas.drawPath(path, Paint()..color = colors[tone]!);
+  }
+}
+
+class NodeOverviewPainter extends CustomPainter {
+  NodeOverviewPainter(
+    this.nodes, {
+    required this.color,
+    required this.focusedColor,
+    required this.highlightedColor,
+    this.revision = 0,
+    this.cache,
+  });
+
+  final List<(Rect, NodeOverviewTone)> nodes;
+  final Color color;
+  final Color focusedColor;
+  final Color highlightedColor;
+
+  /// 色块列表的版本号，变化时才重新录制缓存
+  final int revision;
+  final NodeOverviewCache? cache;
+
+  @override
+  void paint(Canvas canvas, Size size) {
+    final cache = this.cache;
+    if (cache == null) {
+      paintNodeOverview(
+        canvas,
+        nodes,
+        color: color,
+        focusedColor: focusedColor,
+        highlightedColor: highlightedColor,
+      );
+      return;
+    }
+    canvas.drawPicture(
+      cache.pictureFor(
+        revision: revision,
+        nodes: nodes,
+        color: color,
+        focusedColor: focusedColor,
+        highlightedColor: highlightedColor,
+      ),
+    );
+  }
+
+  @override
+  bool shouldRepaint(NodeOverviewPainter oldDelegate) {
+    return oldDelegate.revision != revision ||
+        !identical(oldDelegate.nodes, nodes) ||
+        oldDelegate.cache != cache ||
+        oldDelegate.color != color ||
+        oldDelegate.focusedColor != focusedColor ||
+        oldDelegate.highlightedColor != highlightedColor;
+  }
+}
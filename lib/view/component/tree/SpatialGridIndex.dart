@@ -0,0 +1,90 @@
+import 'dart:ui';
+
+/// 均匀网格空间索引，用于快速找出与视口相交的画布组件。
+///
+/// 每个条目按包围盒登记到覆盖的所有格子里，查询时只遍历与查询区域相交的格子，
+/// 代价与可见条目数量成正比，而不是与全部条目数量成正比。
+class SpatialGridIndex<T> {
+  SpatialGridIndex({this.cellSize = 512}) : assert(cellSize > 0);
+
+  final double cellSize;
+  final Map<int, List<T>> _cells = {};
+  final Map<T, Rect> _bounds = {};
+  Rect? _extent;
+
+  int get length => _bounds.length;
+
+  /// 所有条目包围盒的并集
+  Rect? get extent => _extent;
+
+  Rect? boundsOf(T item) => _bounds[item];
+
+  void insert(T item, Rect bounds) {
+    remove(item);
+    _bounds[item] = bounds;
+    _extent = _extent == null ? bounds : _extent!.expandToInclude(bounds);
+    _forEachCell(bounds, (key) {
+      (_cells[key] ??= <T>[]).add(item);
+    });
+  }
+
+  void remove(T item) {
+    final bounds = _bounds.remove(item);
+    if (bounds == null) {
+      return;
+    }
+    // extent 只增不减，偶尔偏大只会让查询多遍历几个空格子
+    _forEachCell(bounds, (key) {
+      final cell = _cells[key];
+      if (cell == null) {
+        return;
+      }
+      cell.remove(item);
+      if (cell.isEmpty) {
+        _cells.remove(key);
+      }
+    });
+  }
+
+  void clear() {
+    _cells.clear();
+    _bounds.clear();
+    _extent = null;
+  }
+
+  /// 返回包围盒与 [area] 相交的条目，每个条目只出现一次
+  List<T> query(Rect area) {
+    final extent = _extent;
+    if (extent == null || !extent.overlaps(area)) {
+      return <T>[];
+    }
+
+    final clipped = area.intersect(extent);
+    final seen = <T>{};
+    final result = <T>[];
+    _forEachCell(clipped, (key) {
+      final cell = _cells[key];
+      if (cell == null) {
+        return;
+      }
+      for (final item in cell) {
+        if (seen.add(item) && _bounds[item]!.overlaps(area)) {
+          result.add(item);
+        }
+      }
+    });
+    return result;
+  }
+
+  void _forEachCell(Rect bounds, void Function(int key) visit) {
+    final minX = (bounds.left / cellSize).floor();
+    final maxX = (bounds.right / cellSize).floor();
+    final minY = (bounds.top / cellSize).floor();
+    final maxY = (bounds.bottom / cellSize).floor();
+    for (var x = minX; x <= maxX; x++) {
+      for (var y = minY; y <= maxY; y++) {
+        visit(((x & 0xffffffff) << 32) | (y & 0xffffffff));
+      }
+    }
+  }
+}
@@ -5,8 +5,11 @@ import 'package:vertree/component/I18nLang.dart';
 import 'package:vertree/component/Notifier.dart';
 import 'package:vertree/component/ThemedAssets.dart';
 import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/VersionPack.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/view/component/VersionThumbnail.dart';
 import 'package:vertree/view/component/tree/CanvasComponent.dart';
+import 'package:vertree/view/module/VersionCompareDialog.dart';
 
 class FileLeaf extends CanvasComponent {
   static const double minCardWidth = 240;
@@ -30,14 +33,22 @@ class FileLeaf extends CanvasComponent {
     required super.treeCanvasManager,
     required this.preferredWidth,
     this.isFocused = false,
+    this.isHighlighted = false,
     this.animateEntry = false,
+    this.readOnly = false,
   });
 
   final FileNode fileNode;
   final double preferredWidth;
   final bool isFocused;
+
+  /// 版本搜索命中时描出强调色边框
+  final bool isHighlighted;
   final bool animateEntry;
 
+  /// 从打包文件浏览时只能查看、打开和分享，不能备份、分支或改名
+  final bool readOnly;
+
   final void Function(
     FileNode parentNode,
     Offset parentPosition,
@@ -65,6 +76,12 @@ class FileLeaf extends CanvasComponent {
     return label;
   }
 
+  /// 支持预览的文件类型在卡片上预留缩略图区域，布局尺寸不随加载状态变化
+  static bool hasThumbnail(FileNode fileNode) {
+    return thumbnailService.supports(fileNode.mate.fullPath) &&
+        !VersionPack.isEntryPath(fileNode.mate.fullPath);
+  }
+
   static double estimateWidth(BuildContext context, FileNode fileNode) {
     final theme = Theme.of(context);
     final direction = Directionality.of(context);
@@ -173,7 +190,17 @@ class FileLeaf extends CanvasComponent {
         : 2;
     final tagHeight = (defaultTagHeight * tagRows) + (tagRows > 1 ? 8 : 0);
 
-    final totalHeight = 26 + titleHeight + 10 + tagHeight + 10 + labelHeight;
+    final thumbnailHeight = hasThumbnail(fileNode)
+        ? VersionThumbnail.defaultHeight + 10
+        : 0;
+    final totalHeight =
+        26 +
+        titleHeight +
+        thumbnailHeight +
+        10 +
+        tagHeight +
+        10 +
+        labelHeight;
     return Size(
       width + (edgeActionInset * 2),
       totalHeight + (edgeActionInset * 2),
@@ -241,7 +268,10 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
     final secondaryForeground = isFocused
         ? scheme.onPrimaryContainer.withValues(alpha: 0.8)
         : scheme.onSurfaceVariant;
-    final outlineColor = isFocused
+    final isHighlighted = widget.isHighlighted;
+    final outlineColor = isHighlighted
+        ? scheme.tertiary
+        : isFocused
         ? scheme.primary.withValues(alpha: 0.45)
         : scheme.outlineVariant.withValues(alpha: 0.85);
     final shadowColor = isFocused
@@ -261,7 +291,10 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
         decoration: BoxDecoration(
           color: surfaceColor,
           borderRadius: BorderRadius.circular(FileLeaf.cardRadius),
-          border: Border.all(color: outlineColor, width: isFocused ? 1.4 : 1),
+          border: Border.all(
+            color: outlineColor,
+            width: isHighlighted ? 2.4 : (isFocused ? 1.4 : 1),
+          ),
           boxShadow: [
             BoxShadow(
               color: shadowColor,
@@ -292,17 +325,26 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
                 IconButton.filledTonal(
                   visualDensity: VisualDensity.compact,
                   iconSize: 18,
-                  onPressed: () {
-                    widget.sprout(
-                      fileNode,
-                      position,
-                      widget.canvasComponentKey,
-                    );
-                  },
+                  onPressed: widget.readOnly
+                      ? null
+                      : () {
+                          widget.sprout(
+                            fileNode,
+                            position,
+                            widget.canvasComponentKey,
+                          );
+                        },
                   icon: const Icon(Icons.file_copy_outlined),
                 ),
               ],
             ),
+            if (FileLeaf.hasThumbnail(fileNode)) ...[
+              const SizedBox(height: 10),
+              VersionThumbnail(
+                fileMeta: fileNode.mate,
+                service: thumbnailService,
+              ),
+            ],
             const SizedBox(height: 10),
             Wrap(
               spacing: 8,
@@ -367,49 +409,31 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
                 ),
               ),
             ),
-            _buildHoverAction(
-              visible: _showTopAction,
-              alignment: Alignment.topCenter,
-              offset: const Offset(0, 0),
-              onPressed: () {
-                widget.branchNode(
-                  fileNode,
-                  position,
-                  widget.canvasComponentKey,
-                );
-              },
-              onHoverChanged: (value) {
-                setState(() {
-                  _showTopAction = value;
-                });
-              },
-              icon: Icons.call_split_rounded,
-            ),
-            _buildHoverAction(
-              visible: _showBottomAction,
-              alignment: Alignment.bottomCenter,
-              offset: const Offset(0, 0),
-              onPressed: () {
-                widget.branchNode(
-                  fileNode,
-                  position,
-                  widget.canvasComponentKey,
-                );
-              },
-              onHoverChanged: (value) {
-                setState(() {
-                  _showBottomAction = value;
-                });
-              },
-              icon: Icons.call_split_rounded,
-            ),
-            if (fileNode.child == null)
+            if (!widget.readOnly) ...[
+              _buildHoverAction(
+                visible: _showTopAction,
+                alignment: Alignment.topCenter,
+                offset: const Offset(0, 0),
+                onPressed: () {
+                  widget.branchNode(
+                    fileNode,
+                    position,
+                    widget.canvasComponentKey,
+                  );
+                },
+                onHoverChanged: (value) {
+                  setState(() {
+                    _showTopAction = value;
+                  });
+                },
+                icon: Icons.call_split_rounded,
+              ),
               _buildHoverAction(
-                visible: _showRightAction,
-                alignment: Alignment.centerRight,
+                visible: _showBottomAction,
+                alignment: Alignment.bottomCenter,
                 offset: const Offset(0, 0),
                 onPressed: () {
-                  widget.backupNode(
+                  widget.branchNode(
                     fileNode,
                     position,
                     widget.canvasComponentKey,
@@ -417,11 +441,31 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
                 },
                 onHoverChanged: (value) {
                   setState(() {
-                    _showRightAction = value;
+                    _showBottomAction = value;
                   });
                 },
-                icon: Icons.file_copy_outlined,
+                icon: Icons.call_split_rounded,
               ),
+              if (fileNode.child == null)
+                _buildHoverAction(
+                  visible: _showRightAction,
+                  alignment: Alignment.centerRight,
+                  offset: const Offset(0, 0),
+                  onPressed: () {
+                    widget.backupNode(
+                      fileNode,
+                      position,
+                      widget.canvasComponentKey,
+                    );
+                  },
+                  onHoverChanged: (value) {
+                    setState(() {
+                      _showRightAction = value;
+                    });
+                  },
+                  icon: Icons.file_copy_outlined,
+                ),
+            ],
           ],
         ),
       ),
@@ -545,7 +589,11 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
             TextButton(
               onPressed: () {
                 Navigator.of(context).pop();
-                FileUtils.openFile(fileNode.mate.fullPath);
+                if (widget.readOnly) {
+                  _openPackEntry();
+                } else {
+                  FileUtils.openFile(fileNode.mate.fullPath);
+                }
               },
               child: Text(appLocale.getText(LocaleKey.fileleaf_confirm)),
             ),
@@ -567,7 +615,7 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
       items: [
         PopupMenuItem(
           value: 'backup',
-          enabled: fileNode.child == null,
+          enabled: !widget.readOnly && fileNode.child == null,
           child: _buildMenuEntry(
             context,
             icon: Icon(
@@ -580,6 +628,7 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
         ),
         PopupMenuItem(
           value: 'branch',
+          enabled: !widget.readOnly,
           child: _buildMenuEntry(
             context,
             icon: Icon(
@@ -590,8 +639,22 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
             label: appLocale.getText(LocaleKey.fileleaf_menuBranch),
           ),
         ),
+        PopupMenuItem(
+          value: 'compare',
+          enabled: !widget.readOnly && fileNode.parentOrNull != null,
+          child: _buildMenuEntry(
+            context,
+            icon: Icon(
+              Icons.difference_outlined,
+              size: 18,
+              color: Theme.of(context).colorScheme.primary,
+            ),
+            label: appLocale.getText(LocaleKey.fileleaf_menuCompare),
+          ),
+        ),
         PopupMenuItem(
           value: 'monit',
+          enabled: !widget.readOnly,
           child: _buildMenuEntry(
             context,
             icon: Icon(
@@ -629,6 +692,14 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
       widget.backupNode(fileNode, position, widget.canvasComponentKey);
     } else if (result == 'branch') {
       widget.branchNode(fileNode, position, widget.canvasComponentKey);
+    } else if (result == 'compare') {
+      showDialog(
+        context: context,
+        builder: (context) => VersionCompareDialog(
+          oldMeta: fileNode.parent.mate,
+          newMeta: fileNode.mate,
+        ),
+      );
     } else if (result == 'monit') {
       showDialog(
         context: context,
@@ -678,7 +749,10 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
     } else if (result == 'property') {
       showDialog(
         context: context,
-        builder: (context) => FilePropertiesDialog(meta: fileNode.mate),
+        builder: (context) => FilePropertiesDialog(
+          meta: fileNode.mate,
+          editable: !widget.readOnly,
+        ),
       );
     } else if (result == 'share') {
       _openLanShareDialog();
@@ -689,6 +763,25 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
     await openLanShareDialogForPath(fileNode.mate.fullPath);
   }
 
+  /// 打包文件中的版本先解到临时目录再打开，打包文件本身不变
+  Future<void> _openPackEntry() async {
+    final parts = VersionPack.splitEntryPath(fileNode.mate.fullPath);
+    if (parts == null) {
+      return;
+    }
+    final (packPath, entryName) = parts;
+    try {
+      final pack = await VersionPack.open(packPath);
+      final entry = pack.entry(entryName);
+      if (entry == null) {
+        return;
+      }
+      FileUtils.openFile(await pack.extractToTemp(entry));
+    } catch (e) {
+      showToast(e.toString());
+    }
+  }
+
   @override
   void dispose() {
     _entryController.dispose();
@@ -699,7 +792,14 @@ class _FileNodeState extends CanvasComponentState<FileLeaf> {
 class FilePropertiesDialog extends StatefulWidget {
   final FileMeta meta;
 
-  const FilePropertiesDialog({Key? key, required this.meta}) : super(key: key);
+  /// 为 false 时不能修改备注
+  final bool editable;
+
+  const FilePropertiesDialog({
+    Key? key,
+    required this.meta,
+    this.editable = true,
+  }) : super(key: key);
 
   @override
   _FilePropertiesDialogState createState() => _FilePropertiesDialogState();
@@ -815,8 +915,10 @@ class _FilePropertiesDialogState extends State<FilePropertiesDialog> {
                               Expanded(child: Text(widget.meta.label ?? "")),
                               IconButton(
                                 icon: const Icon(Icons.edit_rounded, size: 18),
-                                onPressed: () =>
-                                    setState(() => isEditingLabel = true),
+                                onPressed: widget.editable
+                                    ? () =>
+                                          setState(() => isEditingLabel = true)
+                                    : null,
                               ),
                             ],
                           ),
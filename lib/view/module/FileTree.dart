@@ -1,3 +1,4 @@
+import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
 
 import 'package:vertree/component/I18nLang.dart';
@@ -5,10 +6,12 @@ import 'package:vertree/component/Notifier.dart';
 import 'package:vertree/core/FileVersionTree.dart';
 import 'package:vertree/core/Result.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/view/component/VersionCopyProgress.dart';
 import 'package:vertree/view/component/tree/Canvas.dart';
 import 'package:vertree/view/component/tree/CanvasComponent.dart';
 import 'package:vertree/view/component/tree/CanvasManager.dart';
 import 'package:vertree/view/component/tree/EdgePainter.dart';
+import 'package:vertree/view/component/tree/NodeOverviewPainter.dart';
 import 'package:vertree/view/module/FileLeaf.dart';
 
 class FileTreeViewportController {
@@ -55,6 +58,9 @@ class FileTree extends StatefulWidget {
     this.viewportController,
     this.initialScale,
     this.fitToViewportOnLoad = false,
+    this.highlightedPaths = const {},
+    this.readOnly = false,
+    this.treeRevision = 0,
   });
 
   final double height;
@@ -65,6 +71,15 @@ class FileTree extends StatefulWidget {
   final double? initialScale;
   final bool fitToViewportOnLoad;
 
+  /// 搜索命中的版本文件路径，对应节点高亮显示
+  final Set<String> highlightedPaths;
+
+  /// 从打包文件浏览，节点不能修改
+  final bool readOnly;
+
+  /// 树在原处被修改（目录变化增删了节点）后递增，触发重新布局
+  final int treeRevision;
+
   @override
   State<FileTree> createState() => _FileTreeState();
 }
@@ -80,6 +95,12 @@ class _FileTreeState extends State<FileTree> {
   final Map<FileNode, Size> _nodeSizes = {};
   final Map<FileNode, _SubtreeSpan> _subtreeSpans = {};
   final Map<String, GlobalKey<CanvasComponentState>> _nodeKeys = {};
+  final Map<String, Offset> _nodeCenters = {};
+
+  /// 以连线 id 为键的估算变化比例，在后台陆续填充
+  final Map<String, double> _changeRatios = {};
+  int _changeRequestGeneration = 0;
+  bool _edgeRefreshScheduled = false;
 
   List<CanvasComponentContainer> canvasComponentContainers = [];
   List<Edge> edges = [];
@@ -109,7 +130,9 @@ class _FileTreeState extends State<FileTree> {
     if (oldWidget.height != widget.height ||
         oldWidget.width != widget.width ||
         oldWidget.rootNode != widget.rootNode ||
-        oldWidget.focusNode != widget.focusNode) {
+        oldWidget.focusNode != widget.focusNode ||
+        oldWidget.treeRevision != widget.treeRevision ||
+        !setEquals(oldWidget.highlightedPaths, widget.highlightedPaths)) {
       rootNode = widget.rootNode;
       _refreshTree();
     }
@@ -168,6 +191,7 @@ class _FileTreeState extends State<FileTree> {
 
     _nodeSizes.clear();
     _subtreeSpans.clear();
+    _nodeCenters.clear();
     canvasComponentContainers.clear();
     edges.clear();
     _contentBounds = null;
@@ -179,6 +203,7 @@ class _FileTreeState extends State<FileTree> {
     _layoutTree(rootNode, initPosition, rootKey);
     _updateSceneSize();
     _canvasRevision += 1;
+    _requestChangeEstimates();
 
     setState(() {});
     treeCanvasManager.requestRepaint();
@@ -243,8 +268,14 @@ class _FileTreeState extends State<FileTree> {
     Future<Result<FileNode, String>> Function(String? label) action,
   ) async {
     final label = await _askForLabel();
+    if (!mounted) {
+      return;
+    }
 
-    final result = await action(label);
+    final result = await VersionCopyProgressDialog.showWhileRunning(
+      context,
+      action(label),
+    );
     if (result.isErr) {
       showToast(result.msg);
       return;
@@ -303,6 +334,10 @@ class _FileTreeState extends State<FileTree> {
     logger.info(
       "isFocused: $isFocused, widget.focusNode version: ${widget.focusNode?.version}, child version: ${child.version}",
     );
+    final isHighlighted = widget.highlightedPaths.contains(nodeId);
+    final nodeSize = _nodeSizes[child] ?? FileLeaf.estimateSize(context, child);
+    final nodeBounds = childPosition & nodeSize;
+    _nodeCenters[nodeId] = nodeBounds.center;
 
     canvasComponentContainers.add(
       CanvasComponentContainer.component(
@@ -315,32 +350,95 @@ class _FileTreeState extends State<FileTree> {
           componentId: nodeId,
           treeCanvasManager: treeCanvasManager,
           position: childPosition,
-          preferredWidth:
-              (_nodeSizes[child] ?? FileLeaf.estimateSize(context, child))
-                  .width,
+          preferredWidth: nodeSize.width,
           isFocused: isFocused,
+          isHighlighted: isHighlighted,
           animateEntry: isFreshNode,
+          readOnly: widget.readOnly,
         ),
+        bounds: nodeBounds,
+        overviewTone: isFocused
+            ? NodeOverviewTone.focused
+            : isHighlighted
+            ? NodeOverviewTone.highlighted
+            : NodeOverviewTone.normal,
       ),
     );
-    _includeNodeBounds(child, childPosition);
+    _includeNodeBounds(nodeBounds);
 
     if (parentKey != null && parentNodeId != null) {
       final edgeId = _edgeId(parentNodeId, nodeId);
-      edges.add(Edge(parentKey, childKey, id: edgeId));
+      edges.add(
+        Edge(
+          parentKey,
+          childKey,
+          id: edgeId,
+          startCenter: _nodeCenters[parentNodeId],
+          endCenter: nodeBounds.center,
+          changeRatio: _changeRatios[edgeId],
+          labelDistance: (nodeSize.width + _baseHorizontalGap) / 2,
+        ),
+      );
     }
 
     return childKey;
   }
 
-  void _includeNodeBounds(FileNode node, Offset position) {
-    final nodeSize = _nodeSizes[node] ?? FileLeaf.estimateSize(context, node);
-    final rect = Rect.fromLTWH(
-      position.dx,
-      position.dy,
-      nodeSize.width,
-      nodeSize.height,
-    );
+  /// 在后台估算每个版本相对父版本的变化比例，结果陆续返回后合并刷新连线
+  void _requestChangeEstimates() {
+    if (!changeSketchService.isAvailable || widget.readOnly) {
+      return;
+    }
+    final generation = ++_changeRequestGeneration;
+    final stack = <FileNode>[rootNode];
+    while (stack.isNotEmpty) {
+      final node = stack.removeLast();
+      if (node.child != null) {
+        stack.add(node.child!);
+      }
+      stack.addAll(node.branches);
+
+      final parent = node.parentOrNull;
+      if (parent == null) {
+        continue;
+      }
+      final edgeId = _edgeId(_nodeId(parent), _nodeId(node));
+      changeSketchService.estimateChange(parent.mate, node.mate).then((ratio) {
+        if (!mounted ||
+            generation != _changeRequestGeneration ||
+            ratio == null ||
+            _changeRatios[edgeId] == ratio) {
+          return;
+        }
+        _changeRatios[edgeId] = ratio;
+        _scheduleEdgeRefresh();
+      });
+    }
+  }
+
+  /// 同一帧内返回的估算合并成一次连线重录
+  void _scheduleEdgeRefresh() {
+    if (_edgeRefreshScheduled) {
+      return;
+    }
+    _edgeRefreshScheduled = true;
+    WidgetsBinding.instance.addPostFrameCallback((_) {
+      _edgeRefreshScheduled = false;
+      if (!mounted) {
+        return;
+      }
+      setState(() {
+        edges = [
+          for (final edge in edges)
+            edge.withChangeRatio(_changeRatios[edge.id]),
+        ];
+        _canvasRevision += 1;
+      });
+    });
+    WidgetsBinding.instance.scheduleFrame();
+  }
+
+  void _includeNodeBounds(Rect rect) {
     _contentBounds = _contentBounds == null
         ? rect
         : _contentBounds!.expandToInclude(rect);
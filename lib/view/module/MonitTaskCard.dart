@@ -1,19 +1,28 @@
 import 'dart:io';
 
 import 'package:flutter/material.dart';
+import 'package:path/path.dart' as p;
 import 'package:vertree/component/I18nLang.dart';
 import 'package:vertree/core/MonitManager.dart';
 import 'package:vertree/component/FileUtils.dart';
 import 'package:vertree/component/Notifier.dart';
 import 'package:vertree/component/ThemedAssets.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/service/DiskUsageService.dart';
 
 class MonitTaskCard extends StatefulWidget {
   final FileMonitTask task;
   final Function(FileMonitTask task) removeTask;
 
-  const MonitTaskCard({Key? key, required this.task, required this.removeTask})
-    : super(key: key);
+  /// 该任务最近一次的备份占用统计，尚未统计时为 null
+  final TaskDiskUsage? usage;
+
+  const MonitTaskCard({
+    Key? key,
+    required this.task,
+    required this.removeTask,
+    this.usage,
+  }) : super(key: key);
 
   @override
   State<MonitTaskCard> createState() => _MonitTaskCardState();
@@ -90,11 +99,14 @@ class _MonitTaskCardState extends State<MonitTaskCard> {
         if (confirmed != null && confirmed) {
           try {
             final directory = Directory(task.backupDirPath!);
-            final files = directory.listSync();
+            final entities = directory.listSync();
 
-            for (final file in files) {
-              if (file is File) {
-                file.deleteSync();
+            // 分片布局的快照在日期子目录中，索引和清单随快照一起清掉
+            for (final entity in entities) {
+              if (entity is File) {
+                entity.deleteSync();
+              } else if (entity is Directory) {
+                entity.deleteSync(recursive: true);
               }
             }
             showToast(
@@ -121,6 +133,7 @@ class _MonitTaskCardState extends State<MonitTaskCard> {
     final theme = Theme.of(context);
     final scheme = theme.colorScheme;
     final statusColor = task.isRunning ? Colors.green.shade700 : scheme.outline;
+    final usage = widget.usage;
 
     return MouseRegion(
       cursor: SystemMouseCursors.basic,
@@ -171,6 +184,31 @@ class _MonitTaskCardState extends State<MonitTaskCard> {
                     color: scheme.onSurfaceVariant,
                   ),
                 ),
+              if (usage != null && usage.error == null) ...[
+                const SizedBox(height: 4),
+                Tooltip(
+                  message: usage.largestSnapshots.isEmpty
+                      ? ''
+                      : appLocale
+                            .getText(LocaleKey.monitcard_diskUsageLargest)
+                            .tr([
+                              p.basename(usage.largestSnapshots.first.path),
+                              FileUtils.formatBytes(
+                                usage.largestSnapshots.first.size,
+                              ),
+                            ]),
+                  child: Text(
+                    appLocale.getText(LocaleKey.monitcard_diskUsage).tr([
+                      FileUtils.formatBytes(usage.backupBytes),
+                      '${usage.snapshotCount}',
+                      FileUtils.formatBytes(usage.growthBytesPerDay),
+                    ]),
+                    style: theme.textTheme.bodyMedium?.copyWith(
+                      color: scheme.onSurfaceVariant,
+                    ),
+                  ),
+                ),
+              ],
               const SizedBox(height: 14),
               Wrap(
                 spacing: 10,
@@ -0,0 +1,199 @@
+// ignore_for_file: file_names
+
+import 'package:flutter/material.dart';
+import 'package:vertree/component/I18nLang.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/main.dart';
+import 'package:vertree/service/LineDiffService.dart';
+
+/// 逐行对比两个版本（通常是某个版本和它的上一个版本），差异由原生引擎在后台计算
+class VersionCompareDialog extends StatefulWidget {
+  const VersionCompareDialog({
+    super.key,
+    required this.oldMeta,
+    required this.newMeta,
+  });
+
+  final FileMeta oldMeta;
+  final FileMeta newMeta;
+
+  @override
+  State<VersionCompareDialog> createState() => _VersionCompareDialogState();
+}
+
+class _VersionCompareDialogState extends State<VersionCompareDialog> {
+  static const LineDiffService _lineDiffService = LineDiffService();
+
+  late final Future<Result<LineDiffResult, String>> _result;
+
+  @override
+  void initState() {
+    super.initState();
+    _result = _lineDiffService.isAvailable
+        ? _lineDiffService.compare(
+            widget.oldMeta.fullPath,
+            widget.newMeta.fullPath,
+          )
+        : Future.value(Result.eMsg(LineDiffService.unavailableMessage));
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final size = MediaQuery.of(context).size;
+    return AlertDialog(
+      insetPadding: const EdgeInsets.symmetric(horizontal: 24, vertical: 18),
+      contentPadding: const EdgeInsets.fromLTRB(20, 8, 20, 8),
+      title: Text(
+        appLocale.getText(LocaleKey.fileleaf_compareTitle).tr([
+          widget.oldMeta.version.toString(),
+          widget.newMeta.version.toString(),
+        ]),
+      ),
+      content: SizedBox(
+        width: (size.width * 0.82).clamp(320.0, 1080.0).toDouble(),
+        height: size.height * 0.7,
+        child: FutureBuilder<Result<LineDiffResult, String>>(
+          future: _result,
+          builder: (context, snapshot) {
+            final result = snapshot.data;
+            if (result == null) {
+              return const Center(child: CircularProgressIndicator());
+            }
+            if (result.isErr) {
+              return Center(
+                child: Text(
+                  appLocale.getText(LocaleKey.fileleaf_compareFailed).tr([
+                    result.msg,
+                  ]),
+                ),
+              );
+            }
+            return _buildDiff(context, result.unwrap());
+          },
+        ),
+      ),
+      actions: [
+        TextButton(
+          onPressed: () => Navigator.of(context).pop(),
+          child: Text(appLocale.getText(LocaleKey.fileleaf_propertyClose)),
+        ),
+      ],
+    );
+  }
+
+  Widget _buildDiff(BuildContext context, LineDiffResult diff) {
+    final theme = Theme.of(context);
+    final scheme = theme.colorScheme;
+    if (diff.isIdentical) {
+      return Center(
+        child: Text(appLocale.getText(LocaleKey.fileleaf_compareIdentical)),
+      );
+    }
+
+    // 把差异块展开成一维的行列表，交给 ListView.builder 按需构建
+    final rows = <Object>[];
+    for (final hunk in diff.hunks) {
+      rows.add(hunk);
+      rows.addAll(hunk.lines);
+    }
+
+    return Column(
+      crossAxisAlignment: CrossAxisAlignment.start,
+      children: [
+        Text(
+          appLocale.getText(LocaleKey.fileleaf_compareSummary).tr([
+            '${diff.removedLines}',
+            '${diff.addedLines}',
+            '${diff.hunkCount}',
+          ]),
+          style: theme.textTheme.bodyMedium?.copyWith(
+            color: scheme.onSurfaceVariant,
+          ),
+        ),
+        if (diff.truncated) ...[
+          const SizedBox(height: 4),
+          Text(
+            appLocale.getText(LocaleKey.fileleaf_compareTruncated),
+            style: theme.textTheme.bodySmall?.copyWith(color: scheme.error),
+          ),
+        ],
+        const SizedBox(height: 12),
+        Expanded(
+          child: DecoratedBox(
+            decoration: BoxDecoration(
+              border: Border.all(color: scheme.outlineVariant),
+              borderRadius: BorderRadius.circular(12),
+            ),
+            child: ClipRRect(
+              borderRadius: BorderRadius.circular(12),
+              child: ListView.builder(
+                itemCount: rows.length,
+                itemBuilder: (context, index) {
+                  final row = rows[index];
+                  return row is LineDiffHunk
+                      ? _buildHunkHeader(context, row)
+                      : _buildLine(context, row as LineDiffLine);
+                },
+              ),
+            ),
+          ),
+        ),
+      ],
+    );
+  }
+
+  Widget _buildHunkHeader(BuildContext context, LineDiffHunk hunk) {
+    final scheme = Theme.of(context).colorScheme;
+    return Container(
+      color: scheme.secondaryContainer,
+      padding: const EdgeInsets.symmetric(horizontal: 12, vertical: 4),
+      child: Text(
+        hunk.header,
+        style: TextStyle(
+          fontFamily: 'monospace',
+          fontSize: 12,
+          color: scheme.onSecondaryContainer,
+        ),
+      ),
+    );
+  }
+
+  Widget _buildLine(BuildContext context, LineDiffLine line) {
+    final scheme = Theme.of(context).colorScheme;
+    final (marker, background) = switch (line.kind) {
+      LineDiffLineKind.removed => ('-', Colors.red.withValues(alpha: 0.14)),
+      LineDiffLineKind.added => ('+', Colors.green.withValues(alpha: 0.14)),
+      LineDiffLineKind.context => (' ', Colors.transparent),
+    };
+    final numberStyle = TextStyle(
+      fontFamily: 'monospace',
+      fontSize: 12,
+      color: scheme.onSurfaceVariant,
+    );
+    return Container(
+      color: background,
+      padding: const EdgeInsets.symmetric(horizontal: 12, vertical: 1),
+      child: Row(
+        crossAxisAlignment: CrossAxisAlignment.start,
+        children: [
+          SizedBox(
+            width: 48,
+            child: Text('${line.oldLine ?? ''}', style: numberStyle),
+          ),
+          SizedBox(
+            width: 48,
+            child: Text('${line.newLine ?? ''}', style: numberStyle),
+          ),
+          Expanded(
+            child: Text(
+              '$marker ${line.text}',
+              softWrap: true,
+              style: const TextStyle(fontFamily: 'monospace', fontSize: 12),
+            ),
+          ),
+        ],
+      ),
+    );
+  }
+}
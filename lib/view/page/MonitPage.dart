@@ -1,12 +1,15 @@
+import 'dart:async';
 import 'dart:io';
 import 'package:file_picker/file_picker.dart';
 import 'package:flutter/material.dart';
 
+import 'package:vertree/component/FileUtils.dart';
 import 'package:vertree/component/I18nLang.dart';
 import 'package:vertree/core/MonitManager.dart';
 import 'package:vertree/component/Notifier.dart';
 import 'package:vertree/component/ThemedAssets.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/service/DiskUsageService.dart';
 import 'package:vertree/view/component/AppBar.dart';
 import 'package:vertree/view/component/AppPageBackground.dart';
 import 'package:vertree/view/module/MonitTaskCard.dart';
@@ -36,6 +39,9 @@ class _MonitPageState extends State<MonitPage> {
   final TextEditingController _searchController = TextEditingController();
   String _searchQuery = '';
 
+  DiskUsageReport? _diskUsage;
+  StreamSubscription<DiskUsageReport>? _diskUsageSubscription;
+
   @override
   void initState() {
     // Load initial tasks
@@ -48,6 +54,31 @@ class _MonitPageState extends State<MonitPage> {
 
     // Listen to search input changes
     _searchController.addListener(_onSearchChanged);
+
+    // 先显示缓存的统计，后台扫描完成后再更新
+    _diskUsageSubscription = diskUsageService.updates.listen((report) {
+      if (mounted) {
+        setState(() => _diskUsage = report);
+      }
+    });
+    diskUsageService.cachedReport().then((report) {
+      if (mounted && report != null && _diskUsage == null) {
+        setState(() => _diskUsage = report);
+      }
+    });
+  }
+
+  Future<void> _refreshDiskUsage({Iterable<String>? filePaths}) async {
+    final refreshing = diskUsageService.refresh(filePaths: filePaths);
+    setState(() {});
+    try {
+      await refreshing;
+    } catch (e) {
+      logger.error('统计备份占用失败: $e');
+    }
+    if (mounted) {
+      setState(() {});
+    }
   }
 
   void sortTasks() {
@@ -66,6 +97,7 @@ class _MonitPageState extends State<MonitPage> {
   void dispose() {
     _searchController.removeListener(_onSearchChanged);
     _searchController.dispose();
+    _diskUsageSubscription?.cancel();
     super.dispose();
   }
 
@@ -114,6 +146,7 @@ class _MonitPageState extends State<MonitPage> {
             _filterTasks();
             sortTasks();
           });
+          unawaited(_refreshDiskUsage(filePaths: [task.filePath]));
           if (mounted) {
             showToast(
               appLocale.getText(LocaleKey.monit_addSuccess).tr([task.filePath]),
@@ -179,6 +212,7 @@ class _MonitPageState extends State<MonitPage> {
         // Re-apply the filter to update the displayed list
         _filterTasks();
       });
+      unawaited(_refreshDiskUsage(filePaths: const []));
       showToast(
         appLocale.getText(LocaleKey.monit_deleteSuccess).tr([task.filePath]),
       );
@@ -287,6 +321,7 @@ class _MonitPageState extends State<MonitPage> {
         _allMonitTasks.removeWhere((task) => invalidTasks.contains(task));
         _filterTasks();
       });
+      unawaited(_refreshDiskUsage(filePaths: const []));
 
       if (mounted) {
         showToast(
@@ -335,6 +370,15 @@ class _MonitPageState extends State<MonitPage> {
                 ),
               ),
             ),
+            if (_allMonitTasks.isNotEmpty)
+              Padding(
+                padding: const EdgeInsets.fromLTRB(16, 0, 16, 4),
+                child: _DiskUsageSummary(
+                  report: _diskUsage,
+                  scanning: diskUsageService.isScanning,
+                  onRefresh: () => _refreshDiskUsage(),
+                ),
+              ),
             Expanded(
               child: _filteredMonitTasks.isEmpty
                   ? Center(
@@ -367,6 +411,7 @@ class _MonitPageState extends State<MonitPage> {
                         return MonitTaskCard(
                           task: task,
                           removeTask: _removeTask,
+                          usage: _diskUsage?.taskFor(task.filePath),
                         );
                       },
                     ),
@@ -406,3 +451,129 @@ class _MonitPageState extends State<MonitPage> {
     );
   }
 }
+
+
+/// 监控页顶部的备份占用汇总
+class _DiskUsageSummary extends StatelessWidget {
+  const _DiskUsageSummary({
+    required this.report,
+    required this.scanning,
+    required this.onRefresh,
+  });
+
+  final DiskUsageReport? report;
+  final bool scanning;
+  final VoidCallback onRefresh;
+
+  @override
+  Widget build(BuildContext context) {
+    final theme = Theme.of(context);
+    final scheme = theme.colorScheme;
+    final report = this.report;
+    final labelStyle = theme.textTheme.bodyMedium?.copyWith(
+      color: scheme.onSurfaceVariant,
+    );
+    final savings = report == null
+        ? 0
+        : report.duplicateBytes + report.compressionSavingsBytes;
+
+    return Card.filled(
+      margin: EdgeInsets.zero,
+      child: Padding(
+        padding: const EdgeInsets.fromLTRB(16, 10, 8, 10),
+        child: Row(
+          children: [
+            Icon(Icons.storage_rounded, size: 20, color: scheme.primary),
+            const SizedBox(width: 12),
+            Expanded(
+              child: Column(
+                crossAxisAlignment: CrossAxisAlignment.start,
+                children: [
+                  Text(
+                    appLocale.getText(LocaleKey.monit_diskUsageTitle),
+                    style: theme.textTheme.titleSmall?.copyWith(
+                      fontWeight: FontWeight.w700,
+                    ),
+                  ),
+                  const SizedBox(height: 4),
+                  if (report == null)
+                    Text(
+                      scanning
+                          ? appLocale.getText(LocaleKey.monit_diskUsageScanning)
+                          : appLocale.getText(
+                              LocaleKey.monit_diskUsageNotScanned,
+                            ),
+                      style: labelStyle,
+                    )
+                  else
+                    Wrap(
+                      spacing: 16,
+                      runSpacing: 4,
+                      children: [
+                        Text(
+                          appLocale.getText(LocaleKey.monit_diskUsageTotal).tr([
+                            FileUtils.formatBytes(report.totalBytes),
+                          ]),
+                          style: labelStyle,
+                        ),
+                        Text(
+                          appLocale
+                              .getText(LocaleKey.monit_diskUsageSnapshots)
+                              .tr(['${report.snapshotCount}']),
+                          style: labelStyle,
+                        ),
+                        Text(
+                          appLocale.getText(LocaleKey.monit_diskUsageGrowth).tr(
+                            [FileUtils.formatBytes(report.growthBytesPerDay)],
+                          ),
+                          style: labelStyle,
+                        ),
+                        Tooltip(
+                          message: appLocale
+                              .getText(LocaleKey.monit_diskUsageSavingsDetail)
+                              .tr([
+                                FileUtils.formatBytes(report.duplicateBytes),
+                                FileUtils.formatBytes(
+                                  report.compressionSavingsBytes,
+                                ),
+                              ]),
+                          child: Text(
+                            appLocale
+                                .getText(LocaleKey.monit_diskUsageSavings)
+                                .tr([FileUtils.formatBytes(savings)]),
+                            style: labelStyle,
+                          ),
+                        ),
+                        Text(
+                          scanning
+                              ? appLocale.getText(
+                                  LocaleKey.monit_diskUsageScanning,
+                                )
+                              : appLocale
+                                    .getText(LocaleKey.monit_diskUsageUpdatedAt)
+                                    .tr([_formatTime(report.updatedAt)]),
+                          style: labelStyle,
+                        ),
+                      ],
+                    ),
+                ],
+              ),
+            ),
+            IconButton(
+              tooltip: appLocale.getText(LocaleKey.monit_diskUsageRefresh),
+              onPressed: scanning ? null : onRefresh,
+              icon: const Icon(Icons.refresh_rounded),
+            ),
+          ],
+        ),
+      ),
+    );
+  }
+
+  static String _formatTime(DateTime time) {
+    final local = time.toLocal();
+    String two(int value) => value.toString().padLeft(2, '0');
+    return '${local.year}-${two(local.month)}-${two(local.day)} '
+        '${two(local.hour)}:${two(local.minute)}';
+  }
+}
@@ -1,3 +1,5 @@
+import 'dart:async';
+
 import 'package:flutter/material.dart';
 import 'package:vertree/component/I18nLang.dart';
 import 'package:vertree/component/Notifier.dart';
@@ -5,7 +7,10 @@ import 'package:vertree/component/ThemedAssets.dart';
 import 'package:vertree/core/FileVersionTree.dart';
 import 'package:vertree/core/Result.dart';
 import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/core/VersionPack.dart';
 import 'package:vertree/main.dart';
+import 'package:vertree/service/LiveVersionTree.dart';
+import 'package:vertree/service/VersionSearchService.dart';
 import 'package:vertree/view/component/AppBar.dart';
 import 'package:vertree/view/component/AppPageBackground.dart';
 import 'package:vertree/view/component/Loading.dart';
@@ -32,10 +37,25 @@ class FileTreePage extends StatefulWidget {
 
 class _FileTreePageState extends State<FileTreePage> {
   late String path = widget.path;
+
+  /// 路径是 `.vtpack` 打包文件时直接从打包索引建树，只读浏览
+  late final bool _isPack = VersionPack.isPackPath(widget.path);
   late FileNode focusNode;
   FileNode? rootNode;
   bool isLoading = true;
 
+  /// 监听家族目录，其他程序新增、删除、改名的版本就地更新到树上
+  LiveVersionTree? _liveTree;
+  StreamSubscription<LiveVersionTreeUpdate>? _liveTreeSubscription;
+  int _treeRevision = 0;
+
+  final TextEditingController _searchController = TextEditingController();
+  bool _searchRegex = false;
+  bool _isSearching = false;
+  int _searchGeneration = 0;
+  Set<String> _highlightedPaths = const {};
+  String? _searchSummary;
+
   String _formatVersionSummary(FileVersion version) {
     return "${appLocale.getText(LocaleKey.fileleaf_branchLabel)} ${version.branchPath} · "
         "${appLocale.getText(LocaleKey.fileleaf_revisionLabel)} ${version.revisionNumber}";
@@ -219,6 +239,118 @@ class _FileTreePageState extends State<FileTreePage> {
     );
   }
 
+  Future<void> _runSearch() async {
+    final text = _searchController.text;
+    if (text.isEmpty) {
+      _clearSearch();
+      return;
+    }
+    final generation = ++_searchGeneration;
+    setState(() {
+      _isSearching = true;
+    });
+    final result = await versionSearchService.search(
+      path,
+      VersionSearchQuery(text: text, regex: _searchRegex),
+    );
+    if (!mounted || generation != _searchGeneration) {
+      return;
+    }
+    if (result.isErr) {
+      showToast(
+        appLocale.getText(LocaleKey.vertree_searchFailed).tr([result.msg]),
+      );
+      setState(() {
+        _isSearching = false;
+      });
+      return;
+    }
+    final search = result.unwrap();
+    setState(() {
+      _isSearching = false;
+      _highlightedPaths = search.matchedPaths;
+      _searchSummary = search.matches.isEmpty
+          ? appLocale.getText(LocaleKey.vertree_searchNoMatch)
+          : appLocale.getText(LocaleKey.vertree_searchResult).tr([
+              search.matches.length.toString(),
+              search.documentCount.toString(),
+            ]);
+    });
+  }
+
+  void _clearSearch() {
+    _searchGeneration += 1;
+    _searchController.clear();
+    setState(() {
+      _isSearching = false;
+      _highlightedPaths = const {};
+      _searchSummary = null;
+    });
+  }
+
+  Widget _buildSearchBar(BuildContext context) {
+    final theme = Theme.of(context);
+    final scheme = theme.colorScheme;
+
+    return Card(
+      color: scheme.surface,
+      child: Padding(
+        padding: const EdgeInsets.symmetric(horizontal: 14, vertical: 6),
+        child: Row(
+          children: [
+            Icon(Icons.search_rounded, color: scheme.primary),
+            const SizedBox(width: 10),
+            Expanded(
+              child: TextField(
+                controller: _searchController,
+                textInputAction: TextInputAction.search,
+                onSubmitted: (_) => _runSearch(),
+                decoration: InputDecoration(
+                  hintText: appLocale.getText(LocaleKey.vertree_searchHint),
+                  border: InputBorder.none,
+                  isDense: true,
+                ),
+              ),
+            ),
+            if (_isSearching)
+              const Padding(
+                padding: EdgeInsets.symmetric(horizontal: 8),
+                child: SizedBox(
+                  width: 16,
+                  height: 16,
+                  child: CircularProgressIndicator(strokeWidth: 2),
+                ),
+              )
+            else if (_searchSummary != null)
+              Padding(
+                padding: const EdgeInsets.symmetric(horizontal: 8),
+                child: Text(
+                  _searchSummary!,
+                  style: theme.textTheme.labelMedium?.copyWith(
+                    color: scheme.onSurfaceVariant,
+                  ),
+                ),
+              ),
+            FilterChip(
+              label: Text(appLocale.getText(LocaleKey.vertree_searchRegex)),
+              selected: _searchRegex,
+              onSelected: (selected) {
+                setState(() {
+                  _searchRegex = selected;
+                });
+              },
+            ),
+            IconButton(
+              tooltip: appLocale.getText(LocaleKey.vertree_searchClear),
+              icon: const Icon(Icons.close_rounded),
+              onPressed: _clearSearch,
+            ),
+          ],
+        ),
+      ),
+    );
+  }
+
   Widget _buildCanvasPanel(BuildContext context, FileNode root) {
     final theme = Theme.of(context);
     final scheme = theme.colorScheme;
@@ -249,6 +381,9 @@ class _FileTreePageState extends State<FileTreePage> {
                         viewportController: widget.viewportController,
                         initialScale: widget.initialScale,
                         fitToViewportOnLoad: widget.fitToViewportOnLoad,
+                        highlightedPaths: _highlightedPaths,
+                        readOnly: _isPack,
+                        treeRevision: _treeRevision,
                       );
                     },
                   ),
@@ -301,23 +436,68 @@ class _FileTreePageState extends State<FileTreePage> {
     super.initState();
     _syncWindowState();
 
-    Future.wait([
-      buildTree(path),
-      Future.delayed(Duration(milliseconds: 200)),
-    ]).then((results) {
-      Result<FileNode, String> buildTreeResult = results[0];
-      if (buildTreeResult.isErr) {
-        showToast(buildTreeResult.msg);
-        isLoading = false;
-        return;
-      }
+    _loadTree();
+  }
+
+  Future<void> _loadTree() async {
+    final Result<FileNode, String> buildTreeResult = _isPack
+        ? await buildTreeFromPack(path)
+        : await buildTree(path);
+    if (!mounted) {
+      return;
+    }
+    if (buildTreeResult.isErr) {
+      showToast(buildTreeResult.msg);
       setState(() {
-        rootNode = buildTreeResult.unwrap();
         isLoading = false;
       });
+      return;
+    }
+    final root = buildTreeResult.unwrap();
+    setState(() {
+      rootNode = root;
+      if (_isPack) {
+        focusNode = root;
+      }
+      isLoading = false;
+    });
+    if (!_isPack) {
+      final liveTree = LiveVersionTree(root);
+      _liveTree = liveTree;
+      _liveTreeSubscription = liveTree.updates.listen(_applyTreeUpdate);
+      unawaited(liveTree.start());
+    }
+  }
+
+  void _applyTreeUpdate(LiveVersionTreeUpdate update) {
+    if (!mounted) {
+      return;
+    }
+    final liveTree = _liveTree!;
+    final root = update.root;
+    setState(() {
+      rootNode = root;
+      _treeRevision += 1;
+      if (root == null) {
+        return;
+      }
+      // 打开的版本被改名时按版本号找回，被删除时改为聚焦最新版本
+      focusNode =
+          liveTree.nodeForPath(focusNode.mate.fullPath) ??
+          liveTree.nodeForVersion(focusNode.mate.version) ??
+          _findLatestNode(root);
+      path = focusNode.mate.fullPath;
     });
   }
 
+  @override
+  void dispose() {
+    _liveTreeSubscription?.cancel();
+    _liveTree?.dispose();
+    _searchController.dispose();
+    super.dispose();
+  }
+
   @override
   Widget build(BuildContext context) {
     return Scaffold(
@@ -355,7 +535,15 @@ class _FileTreePageState extends State<FileTreePage> {
               ? const SizedBox.shrink()
               : Padding(
                   padding: const EdgeInsets.all(16),
-                  child: _buildCanvasPanel(context, rootNode!),
+                  child: Column(
+                    children: [
+                      if (!_isPack) ...[
+                        _buildSearchBar(context),
+                        const SizedBox(height: 12),
+                      ],
+                      Expanded(child: _buildCanvasPanel(context, rootNode!)),
+                    ],
+                  ),
                 ),
         ),
       ),
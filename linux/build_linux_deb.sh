@@ -64,6 +64,19 @@ sed \
 install -m 0644 "$ROOT_DIR/linux/packaging/vertree_nautilus.py" \
   "$PKG_ROOT/usr/share/nautilus-python/extensions/vertree_extension.py"
 
+# The compiled Files extension is built when libnautilus-extension-4 is
+# installed on the build machine; Files loads it from its own extension
+# directory.
+NAUTILUS_EXTENSION="$RELEASE_BUNDLE_DIR/lib/nautilus/libvertree-nautilus.so"
+if [[ -f "$NAUTILUS_EXTENSION" ]]; then
+  NAUTILUS_EXTENSION_DIR="$(pkg-config --variable=extensiondir libnautilus-extension-4 2>/dev/null || true)"
+  if [[ -z "$NAUTILUS_EXTENSION_DIR" ]]; then
+    NAUTILUS_EXTENSION_DIR="/usr/lib/$(dpkg-architecture -qDEB_HOST_MULTIARCH)/nautilus/extensions-4"
+  fi
+  install -D -m 0644 "$NAUTILUS_EXTENSION" \
+    "$PKG_ROOT$NAUTILUS_EXTENSION_DIR/libvertree-nautilus.so"
+fi
+
 cat > "$DEBIAN_DIR/control" <<EOF
 Package: vertree
 Version: $DEB_VERSION
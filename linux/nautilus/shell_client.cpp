@@ -0,0 +1,264 @@
+#include "shell_client.h"
+
+#include <gio/gunixsocketaddress.h>
+
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vertree {
+
+namespace {
+
+// Answers are refreshed by "changed" pushes; the lifetime only bounds how
+// stale a directory can get through changes the app did not see, such as a
+// version file copied in by hand.
+constexpr gint64 kCacheLifetimeUs = 30 * G_USEC_PER_SEC;
+constexpr gint64 kReconnectDelayUs = 3 * G_USEC_PER_SEC;
+constexpr size_t kMaxDirectories = 32;
+
+// Must match LinuxShellIpcServer.defaultSocketPath.
+std::string SocketPath() {
+  gchar* path = g_build_filename(g_get_user_runtime_dir(), "vertree",
+                                 "shell.sock", nullptr);
+  std::string result(path);
+  g_free(path);
+  return result;
+}
+
+bool IsCancelled(const GError* error) {
+  return g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+}
+
+}  // namespace
+
+ShellClient* ShellClient::Get() {
+  static ShellClient* client = new ShellClient();
+  return client;
+}
+
+void ShellClient::SetListeners(DirectoryListener on_loaded,
+                               DirectoryListener on_changed) {
+  on_loaded_ = std::move(on_loaded);
+  on_changed_ = std::move(on_changed);
+}
+
+const DirectoryStatus* ShellClient::Find(const std::string& dir) {
+  auto it = directories_.find(dir);
+  if (it == directories_.end()) return nullptr;
+  if (g_get_monotonic_time() - it->second.loaded_at > kCacheLifetimeUs) {
+    directories_.erase(it);
+    return nullptr;
+  }
+  return &it->second;
+}
+
+bool ShellClient::Request(const std::string& dir) {
+  if (requested_.count(dir) != 0) return true;
+  if (state_ == State::kDisconnected) {
+    if (g_get_monotonic_time() < retry_after_) return false;
+    Connect();
+  }
+  requested_.insert(dir);
+  pending_output_ += QueryMessage(dir);
+  Flush();
+  return true;
+}
+
+bool ShellClient::SendAction(const std::string& action,
+                             const std::vector<std::string>& paths) {
+  if (state_ != State::kConnected) {
+    // Let the next action use the socket once the app is up.
+    if (state_ == State::kDisconnected &&
+        g_get_monotonic_time() >= retry_after_) {
+      Connect();
+    }
+    return false;
+  }
+  pending_output_ += ActionMessage(action, paths);
+  Flush();
+  return true;
+}
+
+void ShellClient::Shutdown() {
+  on_loaded_ = nullptr;
+  on_changed_ = nullptr;
+  Disconnect();
+}
+
+void ShellClient::Connect() {
+  state_ = State::kConnecting;
+  cancellable_ = g_cancellable_new();
+  GSocketClient* socket_client = g_socket_client_new();
+  GSocketAddress* address = g_unix_socket_address_new(SocketPath().c_str());
+  g_socket_client_connect_async(socket_client, G_SOCKET_CONNECTABLE(address),
+                                cancellable_, &ShellClient::OnConnected, this);
+  g_object_unref(address);
+  g_object_unref(socket_client);
+}
+
+void ShellClient::Disconnect() {
+  // Cancelled operations still call back; they check IsCancelled or compare
+  // their stream with the current one before touching any state.
+  if (cancellable_ != nullptr) g_cancellable_cancel(cancellable_);
+  g_clear_object(&cancellable_);
+  g_clear_object(&input_);
+  g_clear_object(&connection_);
+  state_ = State::kDisconnected;
+  retry_after_ = g_get_monotonic_time() + kReconnectDelayUs;
+  pending_output_.clear();
+  writing_ = false;
+  loading_dir_.clear();
+  loading_ = DirectoryStatus();
+  remaining_entries_ = 0;
+
+  std::unordered_set<std::string> failed = std::move(requested_);
+  requested_.clear();
+  for (const std::string& dir : failed) {
+    if (on_loaded_) on_loaded_(dir);
+  }
+}
+
+void ShellClient::ReadLine() {
+  g_data_input_stream_read_line_async(input_, G_PRIORITY_DEFAULT, cancellable_,
+                                      &ShellClient::OnLine, this);
+}
+
+void ShellClient::Flush() {
+  if (state_ != State::kConnected || writing_ || pending_output_.empty()) {
+    return;
+  }
+  // The buffer must live until the write completes, even if the connection
+  // is dropped in between, so each write owns its own copy.
+  auto* op = new WriteOp{this, std::move(pending_output_)};
+  pending_output_.clear();
+  writing_ = true;
+  GOutputStream* output =
+      g_io_stream_get_output_stream(G_IO_STREAM(connection_));
+  g_output_stream_write_all_async(output, op->data.data(), op->data.size(),
+                                  G_PRIORITY_DEFAULT, cancellable_,
+                                  &ShellClient::OnWritten, op);
+}
+
+void ShellClient::HandleLine(std::string_view line) {
+  if (remaining_entries_ > 0) {
+    std::string name;
+    FileStatus status;
+    if (ParseStatusLine(line, &name, &status)) {
+      loading_.files.emplace(std::move(name), status);
+    }
+    if (--remaining_entries_ == 0) FinishDirectory();
+    return;
+  }
+
+  std::vector<std::string> fields = SplitFields(line);
+  if (fields.size() == 3 && fields[0] == "dir") {
+    loading_dir_ = std::move(fields[1]);
+    loading_ = DirectoryStatus();
+    remaining_entries_ = std::strtol(fields[2].c_str(), nullptr, 10);
+    if (remaining_entries_ <= 0) {
+      remaining_entries_ = 0;
+      FinishDirectory();
+    }
+  } else if (fields.size() == 2 && fields[0] == "changed") {
+    directories_.erase(fields[1]);
+    if (on_changed_) on_changed_(fields[1]);
+  }
+}
+
+void ShellClient::FinishDirectory() {
+  const gint64 now = g_get_monotonic_time();
+  loading_.loaded_at = now;
+  directories_[loading_dir_] = std::move(loading_);
+  loading_ = DirectoryStatus();
+
+  while (directories_.size() > kMaxDirectories) {
+    auto oldest = directories_.begin();
+    for (auto it = directories_.begin(); it != directories_.end(); ++it) {
+      if (it->second.loaded_at < oldest->second.loaded_at) oldest = it;
+    }
+    directories_.erase(oldest);
+  }
+
+  std::string dir = std::move(loading_dir_);
+  loading_dir_.clear();
+  requested_.erase(dir);
+  if (on_loaded_) on_loaded_(dir);
+}
+
+void ShellClient::OnConnected(GObject* source,
+                              GAsyncResult* result,
+                              gpointer data) {
+  auto* self = static_cast<ShellClient*>(data);
+  GError* error = nullptr;
+  GSocketConnection* connection = g_socket_client_connect_finish(
+      G_SOCKET_CLIENT(source), result, &error);
+  if (connection == nullptr) {
+    const bool cancelled = IsCancelled(error);
+    g_error_free(error);
+    // The app is not running; pending requests get no status.
+    if (!cancelled) self->Disconnect();
+    return;
+  }
+  if (self->state_ != State::kConnecting) {
+    g_object_unref(connection);
+    return;
+  }
+  self->connection_ = connection;
+  self->input_ = g_data_input_stream_new(
+      g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+  g_data_input_stream_set_newline_type(self->input_,
+                                       G_DATA_STREAM_NEWLINE_TYPE_LF);
+  self->state_ = State::kConnected;
+  self->ReadLine();
+  self->Flush();
+}
+
+void ShellClient::OnLine(GObject* source, GAsyncResult* result, gpointer data) {
+  auto* self = static_cast<ShellClient*>(data);
+  GError* error = nullptr;
+  gsize length = 0;
+  char* line = g_data_input_stream_read_line_finish(
+      G_DATA_INPUT_STREAM(source), result, &length, &error);
+  if (G_DATA_INPUT_STREAM(source) != self->input_) {
+    // A read of a connection that was dropped meanwhile.
+    g_free(line);
+    if (error != nullptr) g_error_free(error);
+    return;
+  }
+  if (line == nullptr) {
+    // End of stream or a read error: the app quit.
+    if (error != nullptr) g_error_free(error);
+    self->Disconnect();
+    return;
+  }
+  self->HandleLine(std::string_view(line, length));
+  g_free(line);
+  if (self->input_ != nullptr) self->ReadLine();
+}
+
+void ShellClient::OnWritten(GObject* source,
+                            GAsyncResult* result,
+                            gpointer data) {
+  std::unique_ptr<WriteOp> op(static_cast<WriteOp*>(data));
+  ShellClient* self = op->client;
+  GError* error = nullptr;
+  const gboolean written = g_output_stream_write_all_finish(
+      G_OUTPUT_STREAM(source), result, nullptr, &error);
+  const bool current =
+      self->connection_ != nullptr &&
+      G_OUTPUT_STREAM(source) ==
+          g_io_stream_get_output_stream(G_IO_STREAM(self->connection_));
+  if (!written) {
+    const bool cancelled = IsCancelled(error);
+    g_error_free(error);
+    if (current && !cancelled) self->Disconnect();
+    return;
+  }
+  if (!current) return;
+  self->writing_ = false;
+  self->Flush();
+}
+
+}  // namespace vertree
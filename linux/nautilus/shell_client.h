@@ -0,0 +1,95 @@
+#ifndef VERTREE_NAUTILUS_SHELL_CLIENT_H_
+#define VERTREE_NAUTILUS_SHELL_CLIENT_H_
+
+#include <gio/gio.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "shell_protocol.h"
+
+namespace vertree {
+
+// The statuses of the versioned or monitored files of one directory, keyed
+// by file name. Files that are absent have nothing to show.
+struct DirectoryStatus {
+  std::unordered_map<std::string, FileStatus> files;
+  gint64 loaded_at = 0;
+};
+
+// Keeps one connection to the running app's socket and a small cache of
+// directory answers. Everything runs on the Files main loop: reads and
+// writes are asynchronous, so a slow or hung app never blocks a directory
+// listing; at worst the emblems arrive late.
+class ShellClient {
+ public:
+  using DirectoryListener = std::function<void(const std::string& dir)>;
+
+  static ShellClient* Get();
+
+  // on_loaded runs for every Request once its answer arrived or the
+  // connection failed; on_changed when the app reports that a directory's
+  // statuses changed (its cache entry is already dropped by then).
+  void SetListeners(DirectoryListener on_loaded, DirectoryListener on_changed);
+
+  // The cached answer for dir, or nullptr when there is none or it expired.
+  const DirectoryStatus* Find(const std::string& dir);
+
+  // Asks the app about dir. Returns false when the app cannot be reached
+  // right now; callers then show no status instead of waiting.
+  bool Request(const std::string& dir);
+
+  // Sends a menu action for the selected files. Returns false when not
+  // connected to the app.
+  bool SendAction(const std::string& action,
+                  const std::vector<std::string>& paths);
+
+  void Shutdown();
+
+ private:
+  enum class State { kDisconnected, kConnecting, kConnected };
+
+  struct WriteOp {
+    ShellClient* client;
+    std::string data;
+  };
+
+  ShellClient() = default;
+
+  void Connect();
+  void Disconnect();
+  void ReadLine();
+  void Flush();
+  void HandleLine(std::string_view line);
+  void FinishDirectory();
+
+  static void OnConnected(GObject* source, GAsyncResult* result, gpointer data);
+  static void OnLine(GObject* source, GAsyncResult* result, gpointer data);
+  static void OnWritten(GObject* source, GAsyncResult* result, gpointer data);
+
+  State state_ = State::kDisconnected;
+  gint64 retry_after_ = 0;
+  GCancellable* cancellable_ = nullptr;
+  GSocketConnection* connection_ = nullptr;
+  GDataInputStream* input_ = nullptr;
+  std::string pending_output_;
+  bool writing_ = false;
+
+  std::unordered_map<std::string, DirectoryStatus> directories_;
+  std::unordered_set<std::string> requested_;
+
+  // The "dir" answer being read.
+  std::string loading_dir_;
+  DirectoryStatus loading_;
+  long remaining_entries_ = 0;
+
+  DirectoryListener on_loaded_;
+  DirectoryListener on_changed_;
+};
+
+}  // namespace vertree
+
+#endif  // VERTREE_NAUTILUS_SHELL_CLIENT_H_
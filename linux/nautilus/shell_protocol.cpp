@@ -0,0 +1,112 @@
+#include "shell_protocol.h"
+
+#include <charconv>
+#include <system_error>
+#include <utility>
+
+namespace vertree {
+
+namespace {
+
+template <typename T>
+bool ParseNumber(const std::string& text, T* value) {
+  const char* end = text.data() + text.size();
+  auto [parsed_end, error] = std::from_chars(text.data(), end, *value);
+  return error == std::errc() && parsed_end == end;
+}
+
+}  // namespace
+
+std::string EscapeField(std::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (const char c : value) {
+    switch (c) {
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string UnescapeField(std::string_view value) {
+  std::string unescaped;
+  unescaped.reserve(value.size());
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] != '\\' || i + 1 == value.size()) {
+      unescaped += value[i];
+      continue;
+    }
+    switch (value[++i]) {
+      case 't':
+        unescaped += '\t';
+        break;
+      case 'n':
+        unescaped += '\n';
+        break;
+      case 'r':
+        unescaped += '\r';
+        break;
+      default:
+        unescaped += value[i];
+    }
+  }
+  return unescaped;
+}
+
+std::vector<std::string> SplitFields(std::string_view line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (true) {
+    const size_t tab = line.find('\t', start);
+    fields.push_back(UnescapeField(line.substr(start, tab - start)));
+    if (tab == std::string_view::npos) break;
+    start = tab + 1;
+  }
+  return fields;
+}
+
+std::string QueryMessage(std::string_view dir) {
+  return "query\t" + EscapeField(dir) + "\n";
+}
+
+std::string ActionMessage(std::string_view action,
+                          const std::vector<std::string>& paths) {
+  std::string message = "action\t" + EscapeField(action);
+  for (const std::string& path : paths) {
+    message += '\t';
+    message += EscapeField(path);
+  }
+  message += '\n';
+  return message;
+}
+
+bool ParseStatusLine(std::string_view line,
+                     std::string* name,
+                     FileStatus* status) {
+  std::vector<std::string> fields = SplitFields(line);
+  if (fields.size() != 4) return false;
+  int monitored = 0;
+  if (!ParseNumber(fields[1], &status->versions) ||
+      !ParseNumber(fields[2], &monitored) ||
+      !ParseNumber(fields[3], &status->last_backup)) {
+    return false;
+  }
+  status->monitored = monitored != 0;
+  *name = std::move(fields[0]);
+  return true;
+}
+
+}  // namespace vertree
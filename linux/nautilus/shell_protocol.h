@@ -0,0 +1,44 @@
+#ifndef VERTREE_NAUTILUS_SHELL_PROTOCOL_H_
+#define VERTREE_NAUTILUS_SHELL_PROTOCOL_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The line protocol spoken with lib/platform/linux_shell_ipc_server.dart:
+// one message per line, fields separated by tabs, and backslash, tab,
+// newline and carriage return escaped inside a field.
+namespace vertree {
+
+// What Files shows for one file.
+struct FileStatus {
+  int versions = 0;
+  bool monitored = false;
+  // Unix seconds; 0 when the file has not been backed up.
+  int64_t last_backup = 0;
+};
+
+std::string EscapeField(std::string_view value);
+std::string UnescapeField(std::string_view value);
+
+// Splits a line on tabs and unescapes every field.
+std::vector<std::string> SplitFields(std::string_view line);
+
+// "query <dir>\n"
+std::string QueryMessage(std::string_view dir);
+
+// "action <cli action> <path>...\n"; a multi-selection travels as one
+// message so the app can run it as one batch.
+std::string ActionMessage(std::string_view action,
+                          const std::vector<std::string>& paths);
+
+// Parses one entry of a "dir" answer:
+// "<name>\t<versions>\t<monitored 0/1>\t<last backup>".
+bool ParseStatusLine(std::string_view line,
+                     std::string* name,
+                     FileStatus* status);
+
+}  // namespace vertree
+
+#endif  // VERTREE_NAUTILUS_SHELL_PROTOCOL_H_
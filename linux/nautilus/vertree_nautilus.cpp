@@ -0,0 +1,413 @@
+// GNOME Files extension: shows which files Vertree versions or monitors and
+// adds the Vertree context menu. Statuses and menu actions go over the Unix
+// socket of the running app (lib/platform/linux_shell_ipc_server.dart).
+//
+// Files asks for extension info one file at a time while it lists a
+// directory. The first file of a directory turns into a single query for the
+// whole directory; the files after it are answered from the cached reply
+// without any I/O, so a folder with 10k entries costs one round trip.
+
+#include <gmodule.h>
+#include <nautilus-extension.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "shell_client.h"
+
+namespace {
+
+using MenuProviderIface = NautilusMenuProviderInterface;
+using InfoProviderIface = NautilusInfoProviderInterface;
+using ColumnProviderIface = NautilusColumnProviderInterface;
+
+using vertree::DirectoryStatus;
+using vertree::FileStatus;
+using vertree::ShellClient;
+
+constexpr char kVersionsAttribute[] = "vertree_versions";
+constexpr char kMonitoredAttribute[] = "vertree_monitored";
+constexpr char kLastBackupAttribute[] = "vertree_last_backup";
+constexpr char kPathsKey[] = "vertree-paths";
+
+// Directories whose files keep a reference here so a "changed" push can
+// invalidate them.
+constexpr size_t kMaxRememberedDirectories = 32;
+
+struct MenuAction {
+  const char* key;
+  const char* label;
+  const char* cli_action;
+  // Offered for a multi-selection; the app runs the files as one batch.
+  bool batch;
+};
+
+// Same keys and labels as LinuxGnomeIntegration.
+constexpr MenuAction kActions[] = {
+    {"backup", "备份该文件", "backup", true},
+    {"expressBackup", "快速备份该文件", "express-backup", true},
+    {"monitor", "监控该文件", "monit", true},
+    {"share", "局域网分享下载", "share", false},
+    {"viewTree", "查看版本树", "viewtree", false},
+};
+
+// An update_file_info call waiting for its directory's answer. Its address
+// is the NautilusOperationHandle handed to Files.
+struct PendingUpdate {
+  NautilusInfoProvider* provider;
+  NautilusFileInfo* file;
+  GClosure* update_complete;
+  std::string name;
+};
+
+std::unordered_map<std::string, std::vector<PendingUpdate*>> g_pending;
+std::unordered_map<std::string, std::unordered_set<NautilusFileInfo*>>
+    g_remembered;
+
+void FreeUpdate(PendingUpdate* update) {
+  g_closure_unref(update->update_complete);
+  g_object_unref(update->file);
+  delete update;
+}
+
+// The path of a local file, or "" for other schemes.
+std::string LocalPath(NautilusFileInfo* file) {
+  gchar* scheme = nautilus_file_info_get_uri_scheme(file);
+  const bool local = scheme != nullptr && g_strcmp0(scheme, "file") == 0;
+  g_free(scheme);
+  if (!local) return {};
+  GFile* location = nautilus_file_info_get_location(file);
+  if (location == nullptr) return {};
+  gchar* path = g_file_get_path(location);
+  g_object_unref(location);
+  if (path == nullptr) return {};
+  std::string result(path);
+  g_free(path);
+  return result;
+}
+
+bool SplitPath(const std::string& path, std::string* dir, std::string* name) {
+  if (path.empty()) return false;
+  gchar* dirname = g_path_get_dirname(path.c_str());
+  gchar* basename = g_path_get_basename(path.c_str());
+  *dir = dirname;
+  *name = basename;
+  g_free(dirname);
+  g_free(basename);
+  return true;
+}
+
+std::string FormatTime(int64_t seconds) {
+  if (seconds <= 0) return {};
+  GDateTime* time = g_date_time_new_from_unix_local(seconds);
+  if (time == nullptr) return {};
+  gchar* text = g_date_time_format(time, "%Y-%m-%d %H:%M");
+  g_date_time_unref(time);
+  std::string result = text != nullptr ? text : "";
+  g_free(text);
+  return result;
+}
+
+void ApplyStatus(NautilusFileInfo* file,
+                 const DirectoryStatus& directory,
+                 const std::string& name) {
+  auto found = directory.files.find(name);
+  const FileStatus* status =
+      found == directory.files.end() ? nullptr : &found->second;
+  const bool versioned = status != nullptr && status->versions > 1;
+  const bool monitored = status != nullptr && status->monitored;
+
+  const std::string versions =
+      versioned ? std::to_string(status->versions) : std::string();
+  const std::string last_backup =
+      status != nullptr ? FormatTime(status->last_backup) : std::string();
+  nautilus_file_info_add_string_attribute(file, kVersionsAttribute,
+                                          versions.c_str());
+  nautilus_file_info_add_string_attribute(file, kMonitoredAttribute,
+                                          monitored ? "监控中" : "");
+  nautilus_file_info_add_string_attribute(file, kLastBackupAttribute,
+                                          last_backup.c_str());
+  if (versioned) nautilus_file_info_add_emblem(file, "emblem-documents");
+  if (monitored) nautilus_file_info_add_emblem(file, "emblem-synchronizing");
+}
+
+void Remember(const std::string& dir, NautilusFileInfo* file) {
+  auto it = g_remembered.find(dir);
+  if (it == g_remembered.end()) {
+    if (g_remembered.size() >= kMaxRememberedDirectories) {
+      for (NautilusFileInfo* old : g_remembered.begin()->second) {
+        g_object_unref(old);
+      }
+      g_remembered.erase(g_remembered.begin());
+    }
+    it = g_remembered.emplace(dir, std::unordered_set<NautilusFileInfo*>())
+             .first;
+  }
+  if (it->second.insert(file).second) g_object_ref(file);
+}
+
+void OnDirectoryLoaded(const std::string& dir) {
+  auto it = g_pending.find(dir);
+  if (it == g_pending.end()) return;
+  std::vector<PendingUpdate*> updates = std::move(it->second);
+  g_pending.erase(it);
+
+  // nullptr when the app could not answer; the files then show nothing.
+  const DirectoryStatus* status = ShellClient::Get()->Find(dir);
+  for (PendingUpdate* update : updates) {
+    if (status != nullptr) {
+      ApplyStatus(update->file, *status, update->name);
+      Remember(dir, update->file);
+    }
+    nautilus_info_provider_update_complete_invoke(
+        update->update_complete, update->provider,
+        reinterpret_cast<NautilusOperationHandle*>(update),
+        NAUTILUS_OPERATION_COMPLETE);
+    FreeUpdate(update);
+  }
+}
+
+void OnDirectoryChanged(const std::string& dir) {
+  auto it = g_remembered.find(dir);
+  if (it == g_remembered.end()) return;
+  std::unordered_set<NautilusFileInfo*> files = std::move(it->second);
+  g_remembered.erase(it);
+  // Files asks for these files again, which queries the directory anew.
+  for (NautilusFileInfo* file : files) {
+    nautilus_file_info_invalidate_extension_info(file);
+    g_object_unref(file);
+  }
+}
+
+NautilusOperationResult UpdateFileInfo(NautilusInfoProvider* provider,
+                                       NautilusFileInfo* file,
+                                       GClosure* update_complete,
+                                       NautilusOperationHandle** handle) {
+  std::string dir;
+  std::string name;
+  if (!SplitPath(LocalPath(file), &dir, &name)) {
+    return NAUTILUS_OPERATION_COMPLETE;
+  }
+  ShellClient* client = ShellClient::Get();
+  if (const DirectoryStatus* status = client->Find(dir)) {
+    ApplyStatus(file, *status, name);
+    Remember(dir, file);
+    return NAUTILUS_OPERATION_COMPLETE;
+  }
+  if (!client->Request(dir)) return NAUTILUS_OPERATION_COMPLETE;
+
+  auto* update = new PendingUpdate{
+      provider, NAUTILUS_FILE_INFO(g_object_ref(file)),
+      g_closure_ref(update_complete), std::move(name)};
+  g_pending[dir].push_back(update);
+  *handle = reinterpret_cast<NautilusOperationHandle*>(update);
+  return NAUTILUS_OPERATION_IN_PROGRESS;
+}
+
+void CancelUpdate(NautilusInfoProvider* provider,
+                  NautilusOperationHandle* handle) {
+  auto* update = reinterpret_cast<PendingUpdate*>(handle);
+  for (auto it = g_pending.begin(); it != g_pending.end(); ++it) {
+    std::vector<PendingUpdate*>& updates = it->second;
+    auto found = std::find(updates.begin(), updates.end(), update);
+    if (found == updates.end()) continue;
+    updates.erase(found);
+    if (updates.empty()) g_pending.erase(it);
+    FreeUpdate(update);
+    return;
+  }
+}
+
+// The settings page keeps the enabled actions in the first line of the
+// nautilus-python script it writes; without that script every action is
+// offered, as with the packaged script.
+std::vector<const MenuAction*> EnabledActions() {
+  std::vector<const MenuAction*> actions;
+  gchar* path = g_build_filename(g_get_home_dir(), ".local", "share",
+                                 "nautilus-python", "extensions",
+                                 "vertree_user_extension.py", nullptr);
+  gchar* contents = nullptr;
+  const bool found = g_file_get_contents(path, &contents, nullptr, nullptr);
+  g_free(path);
+  if (!found) {
+    for (const MenuAction& action : kActions) actions.push_back(&action);
+    return actions;
+  }
+
+  constexpr std::string_view kPrefix = "# vertree-actions: ";
+  std::string_view text(contents);
+  text = text.substr(0, text.find('\n'));
+  if (text.substr(0, kPrefix.size()) == kPrefix) {
+    text.remove_prefix(kPrefix.size());
+    gchar** keys = g_strsplit(std::string(text).c_str(), ",", -1);
+    for (const MenuAction& action : kActions) {
+      for (gchar** key = keys; *key != nullptr; ++key) {
+        if (g_strcmp0(g_strstrip(*key), action.key) == 0) {
+          actions.push_back(&action);
+          break;
+        }
+      }
+    }
+    g_strfreev(keys);
+  }
+  g_free(contents);
+  return actions;
+}
+
+void FreePaths(gpointer data) {
+  delete static_cast<std::vector<std::string>*>(data);
+}
+
+void OnActivate(NautilusMenuItem* item, gpointer data) {
+  const auto* action = static_cast<const MenuAction*>(data);
+  const auto* paths = static_cast<const std::vector<std::string>*>(
+      g_object_get_data(G_OBJECT(item), kPathsKey));
+  if (paths == nullptr || paths->empty()) return;
+  if (ShellClient::Get()->SendAction(action->cli_action, *paths)) return;
+
+  // The app is not running; launching it with the action starts it. All
+  // selected files go on one command line.
+  std::vector<const gchar*> argv = {"vertree", action->cli_action};
+  for (const std::string& path : *paths) argv.push_back(path.c_str());
+  argv.push_back(nullptr);
+  GError* error = nullptr;
+  if (!g_spawn_async(nullptr, const_cast<gchar**>(argv.data()), nullptr,
+                     G_SPAWN_SEARCH_PATH, nullptr, nullptr, nullptr,
+                     &error)) {
+    g_warning("Failed to start vertree: %s", error->message);
+    g_error_free(error);
+  }
+}
+
+GList* FileItems(GList* files) {
+  std::vector<std::string> paths;
+  for (GList* node = files; node != nullptr; node = node->next) {
+    auto* file = NAUTILUS_FILE_INFO(node->data);
+    if (nautilus_file_info_is_directory(file)) return nullptr;
+    std::string path = LocalPath(file);
+    if (path.empty()) return nullptr;
+    paths.push_back(std::move(path));
+  }
+  if (paths.empty()) return nullptr;
+  const bool multiple = paths.size() > 1;
+
+  std::vector<const MenuAction*> actions = EnabledActions();
+  if (multiple) {
+    actions.erase(std::remove_if(actions.begin(), actions.end(),
+                                 [](const MenuAction* action) {
+                                   return !action->batch;
+                                 }),
+                  actions.end());
+  }
+  if (actions.empty()) return nullptr;
+
+  gchar* tip =
+      multiple ? g_strdup_printf("Vertree 批量操作（%u 个文件）",
+                                 static_cast<guint>(paths.size()))
+               : g_strdup("Vertree 文件操作");
+  NautilusMenuItem* root =
+      nautilus_menu_item_new("Vertree::Root", "Vertree", tip, nullptr);
+  g_free(tip);
+  NautilusMenu* submenu = nautilus_menu_new();
+  nautilus_menu_item_set_submenu(root, submenu);
+  for (const MenuAction* action : actions) {
+    const std::string name = std::string("Vertree::") + action->key;
+    NautilusMenuItem* item = nautilus_menu_item_new(
+        name.c_str(), action->label, action->label, nullptr);
+    g_object_set_data_full(G_OBJECT(item), kPathsKey,
+                           new std::vector<std::string>(paths), FreePaths);
+    g_signal_connect(item, "activate", G_CALLBACK(OnActivate),
+                     const_cast<MenuAction*>(action));
+    nautilus_menu_append_item(submenu, item);
+    g_object_unref(item);
+  }
+  g_object_unref(submenu);
+  return g_list_append(nullptr, root);
+}
+
+GList* GetFileItems(NautilusMenuProvider* provider, GList* files) {
+  return FileItems(files);
+}
+
+GList* GetColumns(NautilusColumnProvider* provider) {
+  GList* columns = nullptr;
+  columns = g_list_append(
+      columns, nautilus_column_new("Vertree::Versions", kVersionsAttribute,
+                                   "版本数", "Vertree 版本家族中的版本数"));
+  columns = g_list_append(
+      columns, nautilus_column_new("Vertree::Monitored", kMonitoredAttribute,
+                                   "Vertree 监控", "是否由 Vertree 监控"));
+  columns = g_list_append(
+      columns,
+      nautilus_column_new("Vertree::LastBackup", kLastBackupAttribute,
+                          "最近备份", "最近一次版本备份或监控快照的时间"));
+  return columns;
+}
+
+void MenuProviderInit(MenuProviderIface* iface) {
+  iface->get_file_items = GetFileItems;
+}
+
+void InfoProviderInit(InfoProviderIface* iface) {
+  iface->update_file_info = UpdateFileInfo;
+  iface->cancel_update = CancelUpdate;
+}
+
+void ColumnProviderInit(ColumnProviderIface* iface) {
+  iface->get_columns = GetColumns;
+}
+
+}  // namespace
+
+struct VertreeProvider {
+  GObject parent_instance;
+};
+
+struct VertreeProviderClass {
+  GObjectClass parent_class;
+};
+
+// clang-format off
+G_DEFINE_DYNAMIC_TYPE_EXTENDED(VertreeProvider, vertree_provider, G_TYPE_OBJECT,
+                               0,
+    G_IMPLEMENT_INTERFACE_DYNAMIC(NAUTILUS_TYPE_MENU_PROVIDER,
+                                  MenuProviderInit)
+    G_IMPLEMENT_INTERFACE_DYNAMIC(NAUTILUS_TYPE_INFO_PROVIDER,
+                                  InfoProviderInit)
+    G_IMPLEMENT_INTERFACE_DYNAMIC(NAUTILUS_TYPE_COLUMN_PROVIDER,
+                                  ColumnProviderInit))
+// clang-format on
+
+static void vertree_provider_init(VertreeProvider* self) {}
+
+static void vertree_provider_class_init(VertreeProviderClass* klass) {}
+
+static void vertree_provider_class_finalize(VertreeProviderClass* klass) {}
+
+static GType g_provider_types[1];
+
+extern "C" {
+
+G_MODULE_EXPORT void nautilus_module_initialize(GTypeModule* module) {
+  vertree_provider_register_type(module);
+  g_provider_types[0] = vertree_provider_get_type();
+  ShellClient::Get()->SetListeners(OnDirectoryLoaded, OnDirectoryChanged);
+  // The packaged nautilus-python script steps aside when this is set.
+  g_setenv("VERTREE_NAUTILUS_NATIVE", "1", TRUE);
+}
+
+G_MODULE_EXPORT void nautilus_module_shutdown(void) {
+  ShellClient::Get()->Shutdown();
+}
+
+G_MODULE_EXPORT void nautilus_module_list_types(const GType** types,
+                                                int* num_types) {
+  *types = g_provider_types;
+  *num_types = G_N_ELEMENTS(g_provider_types);
+}
+
+}  // extern "C"
@@ -51,13 +51,22 @@ install -Dpm0644 %{SOURCE2} %{buildroot}%{_datadir}/icons/hicolor/512x512/apps/v
 install -Dpm0644 %{SOURCE4} %{buildroot}%{_datadir}/metainfo/%{app_id}.metainfo.xml
 install -Dpm0644 %{SOURCE5} %{buildroot}%{_datadir}/nautilus-python/extensions/vertree_extension.py
 
+# The compiled Files extension is only in bundles built where
+# libnautilus-extension-4 was installed.
+: > nautilus-extension.files
+if [ -f bundle/lib/nautilus/libvertree-nautilus.so ]; then
+  install -Dpm0755 bundle/lib/nautilus/libvertree-nautilus.so \
+    %{buildroot}%{_libdir}/nautilus/extensions-4/libvertree-nautilus.so
+  echo "%{_libdir}/nautilus/extensions-4/libvertree-nautilus.so" > nautilus-extension.files
+fi
+
 desktop-file-install \
   --dir=%{buildroot}%{_datadir}/applications \
   %{buildroot}%{_datadir}/applications/%{app_id}.desktop
 
 appstreamcli validate --no-net %{buildroot}%{_datadir}/metainfo/%{app_id}.metainfo.xml
 
-%files
+%files -f nautilus-extension.files
 %license LICENSE
 %{_bindir}/vertree
 %{_libexecdir}/vertree
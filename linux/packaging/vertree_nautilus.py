@@ -23,6 +23,7 @@ ACTIONS = [
     ("share", "局域网分享下载", "share"),
     ("viewTree", "查看版本树", ""),
 ]
+BATCH_ACTIONS = ("backup", "express-backup", "monit")
 
 
 def _resolve_local_file_path(file_info):
@@ -40,9 +41,9 @@ def _resolve_local_file_path(file_info):
 
 
 class VertreeSystemExtension(GObject.GObject, Nautilus.MenuProvider):
-    def _launch(self, action, path):
+    def _launch(self, action, paths):
         try:
-            command = [VERTREE_EXECUTABLE, path] if not action else [VERTREE_EXECUTABLE, action, path]
+            command = [VERTREE_EXECUTABLE, *paths] if not action else [VERTREE_EXECUTABLE, action, *paths]
             subprocess.Popen(
                 command,
                 start_new_session=True,
@@ -51,20 +52,24 @@ class VertreeSystemExtension(GObject.GObject, Nautilus.MenuProvider):
             pass
 
     def get_file_items(self, *args):
-        if USER_OVERRIDE.exists():
+        # The compiled extension provides the menu when it is loaded.
+        if USER_OVERRIDE.exists() or GLib.getenv("VERTREE_NAUTILUS_NATIVE"):
             return
 
         files = args[-1] if args else None
-        if not files or len(files) != 1:
+        if not files:
             return
 
-        file_info = files[0]
-        if file_info.is_directory():
-            return
-
-        path = _resolve_local_file_path(file_info)
-        if not path:
-            return
+        paths = []
+        for file_info in files:
+            if file_info.is_directory():
+                return
+            path = _resolve_local_file_path(file_info)
+            if not path:
+                return
+            paths.append(path)
+        # A multi-selection goes to the app as one batch.
+        multiple = len(paths) > 1
 
         root = Nautilus.MenuItem(
             name="Vertree::Root",
@@ -75,6 +80,8 @@ class VertreeSystemExtension(GObject.GObject, Nautilus.MenuProvider):
         root.set_submenu(submenu)
 
         for action_key, label, cli_action in ACTIONS:
+            if multiple and cli_action not in BATCH_ACTIONS:
+                continue
             item = Nautilus.MenuItem(
                 name=f"Vertree::{action_key}",
                 label=label,
@@ -82,8 +89,8 @@ class VertreeSystemExtension(GObject.GObject, Nautilus.MenuProvider):
             )
             item.connect(
                 "activate",
-                lambda _item, action=cli_action, file_path=path: self._launch(
-                    action, file_path
+                lambda _item, action=cli_action, file_paths=paths: self._launch(
+                    action, file_paths
                 ),
             )
             submenu.append_item(item)
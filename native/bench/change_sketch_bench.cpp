@@ -0,0 +1,95 @@
+// Benchmarks change sketches against hashing the whole file.
+//
+//   change_sketch_bench [megabytes]
+//
+// Writes one random file and times, with a warm page cache, a byte-wise
+// FNV-1a pass over the whole file (what a full content hash costs at least),
+// a sketch that chunks every byte, and a sketch with the default striped
+// sampling.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "vertree_native.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Milliseconds(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+double TimeFullHash(const std::string& path, uint64_t* hash) {
+  const Clock::time_point started = Clock::now();
+  std::ifstream in(path, std::ios::binary);
+  std::string buffer(1 << 20, '\0');
+  uint64_t value = 0xcbf29ce484222325ULL;
+  while (in) {
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    const std::streamsize read = in.gcount();
+    for (std::streamsize i = 0; i < read; ++i) {
+      value ^= static_cast<unsigned char>(buffer[static_cast<size_t>(i)]);
+      value *= 0x100000001b3ULL;
+    }
+  }
+  *hash = value;
+  return Milliseconds(started);
+}
+
+void TimeSketch(const char* name,
+                const std::string& path,
+                const VtSketchOptions& options) {
+  VtSketch sketch;
+  const Clock::time_point started = Clock::now();
+  const int32_t status = vt_sketch_file(path.c_str(), &options, &sketch);
+  const double elapsed = Milliseconds(started);
+  if (status != VT_OK) {
+    std::printf("%-18s failed with status %d\n", name, status);
+    return;
+  }
+  std::printf("%-18s %8.1f ms  scanned %7.1f MB  %lld chunks\n", name,
+              elapsed, sketch.scanned_bytes / 1048576.0,
+              static_cast<long long>(sketch.chunk_count));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long megabytes = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 1024;
+  const char* dir = std::getenv("TMPDIR");
+  const std::string path =
+      std::string(dir != nullptr ? dir : "/tmp") + "/vertree_bench_sketch.bin";
+  {
+    std::mt19937_64 random(11);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string block(1 << 20, '\0');
+    for (long written = 0; written < megabytes; ++written) {
+      for (size_t i = 0; i < block.size(); i += 8) {
+        const uint64_t value = random();
+        block.replace(i, 8, reinterpret_cast<const char*>(&value), 8);
+      }
+      out.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+  }
+
+  uint64_t hash = 0;
+  TimeFullHash(path, &hash);  // Warms the page cache.
+  std::printf("%-18s %8.1f ms  (%ld MB, %016llx)\n", "full FNV-1a",
+              TimeFullHash(path, &hash), megabytes,
+              static_cast<unsigned long long>(hash));
+
+  VtSketchOptions options;
+  vt_sketch_default_options(&options);
+  VtSketchOptions complete = options;
+  complete.full_scan_bytes = INT64_MAX;
+  TimeSketch("sketch, every byte", path, complete);
+  TimeSketch("sketch, striped", path, options);
+
+  std::remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Benchmarks whole-file checksums against the raw read they are bound by.
+//
+//   checksum_bench [megabytes]
+//
+// Writes one random file and times, with a warm page cache, reading it into
+// a 1 MB buffer without looking at the bytes, checksumming it, and copying
+// it with the checksum computed on the way. The gap between the first two
+// is the hashing cost a scrub adds on top of the disk.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "vertree_native.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Milliseconds(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+void Report(const char* name, double elapsed, long megabytes) {
+  std::printf("%-18s %8.1f ms  %8.0f MB/s\n", name, elapsed,
+              megabytes / (elapsed / 1000.0));
+}
+
+double TimeRawRead(const std::string& path) {
+  const Clock::time_point started = Clock::now();
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  std::string buffer(1 << 20, '\0');
+  while (std::fread(buffer.data(), 1, buffer.size(), file) > 0) {
+  }
+  std::fclose(file);
+  return Milliseconds(started);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long megabytes = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 1024;
+  const char* dir = std::getenv("TMPDIR");
+  const std::string base = std::string(dir != nullptr ? dir : "/tmp");
+  const std::string path = base + "/vertree_bench_checksum.bin";
+  const std::string copy_path = base + "/vertree_bench_checksum_copy.bin";
+  {
+    std::mt19937_64 random(13);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::string block(1 << 20, '\0');
+    for (long written = 0; written < megabytes; ++written) {
+      for (size_t i = 0; i < block.size(); i += 8) {
+        const uint64_t value = random();
+        block.replace(i, 8, reinterpret_cast<const char*>(&value), 8);
+      }
+      out.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+  }
+
+  TimeRawRead(path);  // Warms the page cache.
+  Report("raw read", TimeRawRead(path), megabytes);
+
+  VtChecksum checksum;
+  Clock::time_point started = Clock::now();
+  if (vt_checksum_file(path.c_str(), 0, &checksum) != VT_OK) {
+    std::printf("checksum failed\n");
+    return 1;
+  }
+  Report("checksum", Milliseconds(started), megabytes);
+
+  VtChecksum copied;
+  started = Clock::now();
+  if (vt_copy_file(path.c_str(), copy_path.c_str(), &copied) != VT_OK) {
+    std::printf("copy failed\n");
+    return 1;
+  }
+  Report("copy + checksum", Milliseconds(started), megabytes);
+  std::printf("%016llx %s\n", static_cast<unsigned long long>(checksum.hash),
+              checksum.hash == copied.hash ? "matches" : "MISMATCH");
+
+  std::remove(path.c_str());
+  std::remove(copy_path.c_str());
+  return 0;
+}
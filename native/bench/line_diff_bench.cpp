@@ -0,0 +1,125 @@
+// Benchmarks the line diff on generated multi-megabyte files.
+//
+//   line_diff_bench [megabytes]
+//
+// Each case writes an old and a new file, then times vt_diff_open (split,
+// hash, edit script) and streaming the whole unified output separately.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vertree_native.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Case {
+  const char* name;
+  // Probability that a line is replaced, deleted or followed by an insert.
+  double edit_rate;
+  // Number of distinct line bodies; small values mean highly repetitive text.
+  int distinct_lines;
+};
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/vertree_bench_" + name;
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+double Milliseconds(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+void RunCase(const Case& bench_case, size_t target_bytes) {
+  std::mt19937_64 random(7);
+  std::uniform_real_distribution<double> roll(0.0, 1.0);
+  std::string old_text;
+  std::string new_text;
+  old_text.reserve(target_bytes);
+  new_text.reserve(target_bytes + target_bytes / 4);
+  while (old_text.size() < target_bytes) {
+    const uint64_t body = bench_case.distinct_lines > 0
+                              ? random() % bench_case.distinct_lines
+                              : random();
+    const std::string line =
+        "    value_" + std::to_string(body) + " = compute(input, " +
+        std::to_string(body % 97) + ");\n";
+    old_text += line;
+    const double chance = roll(random);
+    if (chance < bench_case.edit_rate / 3) {
+      new_text += "    replaced_" + std::to_string(random()) + "();\n";
+    } else if (chance < bench_case.edit_rate * 2 / 3) {
+      // Deleted in the new version.
+    } else if (chance < bench_case.edit_rate) {
+      new_text += line;
+      new_text += "    inserted_" + std::to_string(random()) + "();\n";
+    } else {
+      new_text += line;
+    }
+  }
+
+  const std::string old_path = TempPath("old.txt");
+  const std::string new_path = TempPath("new.txt");
+  WriteFile(old_path, old_text);
+  WriteFile(new_path, new_text);
+
+  const Clock::time_point open_started = Clock::now();
+  VtDiff* diff = nullptr;
+  const int32_t status =
+      vt_diff_open(old_path.c_str(), new_path.c_str(), nullptr, &diff);
+  const double open_ms = Milliseconds(open_started);
+  if (status != VT_OK) {
+    std::printf("%-22s failed with status %d\n", bench_case.name, status);
+    return;
+  }
+
+  VtDiffStats stats;
+  vt_diff_stats(diff, &stats);
+  const Clock::time_point stream_started = Clock::now();
+  std::vector<char> buffer(64 * 1024);
+  int64_t output_bytes = 0;
+  for (int64_t read; (read = vt_diff_read_unified(
+                          diff, buffer.data(),
+                          static_cast<int64_t>(buffer.size()))) > 0;) {
+    output_bytes += read;
+  }
+  const double stream_ms = Milliseconds(stream_started);
+  vt_diff_close(diff);
+
+  std::printf(
+      "%-22s %6.1f MB %8lld lines  diff %8.1f ms  stream %7.1f ms  "
+      "-%lld +%lld in %lld hunks, %.1f MB output\n",
+      bench_case.name, old_text.size() / 1048576.0,
+      static_cast<long long>(stats.old_lines), open_ms, stream_ms,
+      static_cast<long long>(stats.removed_lines),
+      static_cast<long long>(stats.added_lines),
+      static_cast<long long>(stats.hunk_count), output_bytes / 1048576.0);
+  std::remove(old_path.c_str());
+  std::remove(new_path.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const long megabytes = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 16;
+  const size_t target_bytes = static_cast<size_t>(megabytes) * 1024 * 1024;
+  const Case cases[] = {
+      {"small edit distance", 0.0005, 0},
+      {"large edit distance", 0.3, 0},
+      {"repetitive, small", 0.0005, 50},
+      {"repetitive, large", 0.3, 50},
+  };
+  for (const Case& bench_case : cases) RunCase(bench_case, target_bytes);
+  return 0;
+}
@@ -0,0 +1,266 @@
+// C interface of the Vertree native helpers, loaded from Dart through
+// dart:ffi. Everything exported here uses plain C types so the Dart bindings
+// in lib/native/ can mirror the structs one to one.
+#ifndef VERTREE_NATIVE_H_
+#define VERTREE_NATIVE_H_
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(VERTREE_NATIVE_IMPLEMENTATION)
+#define VT_EXPORT __declspec(dllexport)
+#else
+#define VT_EXPORT __declspec(dllimport)
+#endif
+#else
+#define VT_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Status codes shared by all native entry points.
+#define VT_OK 0
+#define VT_ERROR_INVALID_ARGUMENT -1
+#define VT_ERROR_IO -2
+#define VT_ERROR_BINARY -3
+#define VT_ERROR_TOO_LARGE -4
+#define VT_ERROR_NOT_FOUND -5
+
+// Kinds reported in VtDiffLine.kind.
+#define VT_DIFF_LINE_CONTEXT 0
+#define VT_DIFF_LINE_REMOVED 1
+#define VT_DIFF_LINE_ADDED 2
+
+typedef struct VtDiff VtDiff;
+
+typedef struct VtDiffOptions {
+  // Unchanged lines shown around each change; changes closer than twice this
+  // distance are merged into one hunk.
+  int32_t context_lines;
+  // Upper bound for the line index (offsets, hashes and work arrays). Files
+  // whose index would exceed it fail with VT_ERROR_TOO_LARGE.
+  int64_t max_index_bytes;
+  // Edit cost after which a region without a rare anchor line is reported as
+  // a whole replacement instead of searching for the minimal script.
+  int32_t max_edit_cost;
+} VtDiffOptions;
+
+typedef struct VtDiffStats {
+  int64_t old_lines;
+  int64_t new_lines;
+  int64_t removed_lines;
+  int64_t added_lines;
+  int64_t hunk_count;
+} VtDiffStats;
+
+// Line numbers are zero-based; counts may be zero for pure insertions or
+// deletions.
+typedef struct VtDiffHunk {
+  int64_t old_start;
+  int64_t old_count;
+  int64_t new_start;
+  int64_t new_count;
+} VtDiffHunk;
+
+typedef struct VtDiffLine {
+  int32_t kind;
+  // Non-zero when this is the last line of its file and it lacks a newline.
+  int32_t missing_newline;
+  // Zero-based line numbers, -1 on the side the line does not exist.
+  int64_t old_line;
+  int64_t new_line;
+  // Points into the mapped file, valid until vt_diff_close. The line
+  // terminator is not included.
+  const char* text;
+  int64_t length;
+} VtDiffLine;
+
+VT_EXPORT void vt_diff_default_options(VtDiffOptions* options);
+
+// Maps both files, splits and hashes lines and computes the edit script.
+// Paths are UTF-8. On success *out_diff owns the mappings until
+// vt_diff_close.
+VT_EXPORT int32_t vt_diff_open(const char* old_path,
+                               const char* new_path,
+                               const VtDiffOptions* options,
+                               VtDiff** out_diff);
+
+VT_EXPORT void vt_diff_stats(const VtDiff* diff, VtDiffStats* out_stats);
+
+// Advances to the next hunk. Returns 1 and fills *out_hunk, or 0 at the end.
+VT_EXPORT int32_t vt_diff_next_hunk(VtDiff* diff, VtDiffHunk* out_hunk);
+
+// Advances to the next line of the current hunk. Returns 1 and fills
+// *out_line, or 0 once the hunk is exhausted.
+VT_EXPORT int32_t vt_diff_next_line(VtDiff* diff, VtDiffLine* out_line);
+
+// Writes the next chunk of the unified diff body (hunk headers and lines,
+// without the ---/+++ file header) into buffer. Returns the number of bytes
+// written, 0 once everything was produced. Shares its cursor with
+// vt_diff_next_hunk, so use one or the other on a session.
+VT_EXPORT int64_t vt_diff_read_unified(VtDiff* diff,
+                                       char* buffer,
+                                       int64_t capacity);
+
+VT_EXPORT void vt_diff_close(VtDiff* diff);
+
+// Capacity of VtSketch.hashes.
+#define VT_SKETCH_CAPACITY 256
+
+typedef struct VtSketchOptions {
+  // Number of smallest distinct chunk hashes kept, 1..VT_SKETCH_CAPACITY.
+  int32_t sketch_size;
+  // Target average chunk size; rounded down to a power of two, minimum 256.
+  int32_t average_chunk_bytes;
+  // Bytes at the start of the file that are always chunked completely.
+  int64_t full_scan_bytes;
+  // Past full_scan_bytes only the first stripe_bytes of every
+  // stripe_bytes * stripe_interval block are chunked. Stripes sit at fixed
+  // offsets, so two versions are sampled at the same places.
+  int64_t stripe_bytes;
+  int32_t stripe_interval;
+} VtSketchOptions;
+
+// Bottom-k sketch over the content-defined chunks of one file. Two sketches
+// taken with the same options estimate how many chunks the files share.
+typedef struct VtSketch {
+  int64_t file_size;
+  int64_t scanned_bytes;
+  int64_t chunk_count;
+  int32_t hash_count;
+  int32_t reserved;
+  // Ascending and distinct. Values use 63 bits so they stay non-negative
+  // when read as signed integers.
+  uint64_t hashes[VT_SKETCH_CAPACITY];
+} VtSketch;
+
+VT_EXPORT void vt_sketch_default_options(VtSketchOptions* options);
+
+// Chunks the file at the UTF-8 path and fills *out_sketch.
+VT_EXPORT int32_t vt_sketch_file(const char* path,
+                                 const VtSketchOptions* options,
+                                 VtSketch* out_sketch);
+
+// Flags for vt_checksum_file.
+// Lowers the I/O priority of the calling thread while reading (idle class
+// on Linux, background mode on Windows) so a scheduled scrub yields to
+// interactive work.
+#define VT_CHECKSUM_LOW_PRIORITY 1
+// Drops the file from the page cache afterwards, so scrubbing a large
+// backup set does not evict what the rest of the system is using.
+#define VT_CHECKSUM_DROP_CACHE 2
+
+// XXH64 (seed 0) of a whole file, see lib/core/Xxh64.dart.
+typedef struct VtChecksum {
+  uint64_t hash;
+  int64_t size;
+} VtChecksum;
+
+// Reads the file at the UTF-8 path once and fills *out_checksum.
+VT_EXPORT int32_t vt_checksum_file(const char* path,
+                                   int32_t flags,
+                                   VtChecksum* out_checksum);
+
+// Copies source to target (replacing it) and hashes the bytes as they are
+// written, so the manifest entry costs no second read. The target keeps the
+// source's permission bits; a failed copy removes the partial target.
+VT_EXPORT int32_t vt_copy_file(const char* source_path,
+                               const char* target_path,
+                               VtChecksum* out_checksum);
+
+// Flags for VtCopyOptions.flags.
+// Copies on the worker threads even where io_uring is available. Mainly for
+// tests and benchmarks.
+#define VT_COPY_NO_RING 1
+// Asks io_uring for only part of a chunk per read, so reads come back short
+// in the middle of files the way FUSE and network mounts may return them.
+// For tests.
+#define VT_COPY_SHORT_READS 2
+
+typedef struct VtCopyOptions {
+  // Reads and writes in flight at once across all files, 1..256. Each one
+  // owns a buffer of buffer_bytes.
+  int32_t queue_depth;
+  // Chunk size per read and write, 4 KB..8 MB.
+  int32_t buffer_bytes;
+  // Worker threads when io_uring is not used; 0 picks the hardware thread
+  // count, at most 8.
+  int32_t threads;
+  int32_t flags;
+} VtCopyOptions;
+
+typedef struct VtCopyJob {
+  const char* source_path;
+  const char* target_path;
+} VtCopyJob;
+
+typedef struct VtCopyResult {
+  // VT_OK or VT_ERROR_IO; a failed copy leaves no partial target behind.
+  int32_t status;
+  int32_t reserved;
+  VtChecksum checksum;
+} VtCopyResult;
+
+VT_EXPORT void vt_copy_default_options(VtCopyOptions* options);
+
+// Copies every job like vt_copy_file, many files at a time. On Linux the
+// reads and writes of all files share one io_uring with registered buffers
+// and a bounded queue depth; elsewhere, or when the kernel refuses io_uring,
+// a small thread pool copies the files. Per-job failures are reported in
+// out_results, the return value only covers invalid arguments.
+VT_EXPORT int32_t vt_copy_batch(const VtCopyJob* jobs,
+                                int32_t count,
+                                const VtCopyOptions* options,
+                                VtCopyResult* out_results);
+
+// Filesystem classes reported by vt_filesystem_kind. Change notifications
+// (inotify, ReadDirectoryChangesW) only cover writes made through the local
+// kernel, so on the latter two a change made by another machine or by the
+// FUSE server itself never produces an event.
+#define VT_FS_LOCAL 0
+#define VT_FS_NETWORK 1
+#define VT_FS_FUSE 2
+
+// Classifies the filesystem holding the UTF-8 path. Returns VT_FS_LOCAL when
+// it cannot tell, so callers fall back to change notifications.
+VT_EXPORT int32_t vt_filesystem_kind(const char* path);
+
+// Flags for vt_stat_batch.
+// Asks network filesystems for fresh attributes instead of answering from
+// the client attribute cache (AT_STATX_FORCE_SYNC on Linux).
+#define VT_STAT_FORCE_SYNC 1
+// Stats the paths one after another on the calling thread, without
+// io_uring. Mainly for tests and benchmarks.
+#define VT_STAT_SEQUENTIAL 2
+
+typedef struct VtFileStat {
+  // VT_OK, VT_ERROR_NOT_FOUND, or VT_ERROR_IO for any other failure. The
+  // other fields are zero unless status is VT_OK.
+  int32_t status;
+  int32_t reserved;
+  int64_t size;
+  // Nanoseconds since the Unix epoch.
+  int64_t modified_ns;
+  // Inode change time on POSIX, equal to modified_ns on Windows.
+  int64_t changed_ns;
+  // Inode number, zero where the platform has none.
+  uint64_t file_id;
+} VtFileStat;
+
+// Stats count UTF-8 paths and fills out_stats[i] for paths[i]. On Linux the
+// requests go through one io_uring submission when the kernel allows it, so
+// the round trips of a network filesystem overlap instead of adding up;
+// otherwise they run sequentially. Per-path failures are reported in
+// VtFileStat.status, the return value only covers invalid arguments.
+VT_EXPORT int32_t vt_stat_batch(const char* const* paths,
+                                int32_t count,
+                                int32_t flags,
+                                VtFileStat* out_stats);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VERTREE_NATIVE_H_
@@ -0,0 +1,169 @@
+#include "change_sketch.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "hash.h"
+#include "mapped_file.h"
+
+namespace vertree {
+
+namespace {
+
+constexpr int32_t kMinAverageChunkBytes = 256;
+constexpr uint64_t kHashMask = 0x7fffffffffffffffULL;
+
+// Gear table from splitmix64, fixed so sketches are stable across builds.
+const std::array<uint64_t, 256>& GearTable() {
+  static const std::array<uint64_t, 256> table = [] {
+    std::array<uint64_t, 256> values{};
+    uint64_t state = 0x5657525452454531ULL;
+    for (uint64_t& value : values) {
+      state += 0x9e3779b97f4a7c15ULL;
+      value = Finalize(state);
+    }
+    return values;
+  }();
+  return table;
+}
+
+// The gear hash shifts left once per byte, so only its high bits depend on
+// the whole 64-byte window; boundary masks therefore test the top bits.
+constexpr uint64_t TopBits(int count) {
+  return count <= 0 ? 0 : ~uint64_t{0} << (64 - count);
+}
+
+class Chunker {
+ public:
+  explicit Chunker(int32_t average_bytes) {
+    int bits = 0;
+    while ((int64_t{2} << bits) <= average_bytes) ++bits;
+    average_ = size_t{1} << bits;
+    min_ = average_ / 4;
+    max_ = average_ * 8;
+    // Normalized chunking: harder to cut before the average, easier after,
+    // which narrows the size distribution around it.
+    strict_mask_ = TopBits(bits + 2);
+    loose_mask_ = TopBits(bits - 2);
+  }
+
+  // Length of the chunk starting at data; the whole input if no boundary is
+  // found before it ends or max_ is reached.
+  size_t Next(const unsigned char* data, size_t length) const {
+    if (length <= min_) return length;
+    const std::array<uint64_t, 256>& gear = GearTable();
+    const size_t normal = std::min(length, average_);
+    const size_t limit = std::min(length, max_);
+    uint64_t hash = 0;
+    size_t i = min_;
+    for (; i < normal; ++i) {
+      hash = (hash << 1) + gear[data[i]];
+      if ((hash & strict_mask_) == 0) return i + 1;
+    }
+    for (; i < limit; ++i) {
+      hash = (hash << 1) + gear[data[i]];
+      if ((hash & loose_mask_) == 0) return i + 1;
+    }
+    return limit;
+  }
+
+ private:
+  size_t average_ = 0;
+  size_t min_ = 0;
+  size_t max_ = 0;
+  uint64_t strict_mask_ = 0;
+  uint64_t loose_mask_ = 0;
+};
+
+// Keeps the smallest distinct values seen so far, in ascending order.
+class BottomK {
+ public:
+  explicit BottomK(size_t capacity) : capacity_(capacity) {
+    values_.reserve(capacity + 1);
+  }
+
+  void Add(uint64_t value) {
+    if (values_.size() == capacity_ && value >= values_.back()) return;
+    const auto position =
+        std::lower_bound(values_.begin(), values_.end(), value);
+    if (position != values_.end() && *position == value) return;
+    values_.insert(position, value);
+    if (values_.size() > capacity_) values_.pop_back();
+  }
+
+  const std::vector<uint64_t>& values() const { return values_; }
+
+ private:
+  size_t capacity_;
+  std::vector<uint64_t> values_;
+};
+
+// Chunks [begin, end). With partial_edges set, the first and the last chunk
+// are cut by the range rather than by content and are left out, so stripes
+// only contribute chunks that line up between versions.
+void ChunkRange(const unsigned char* begin,
+                const unsigned char* end,
+                bool partial_edges,
+                const Chunker& chunker,
+                BottomK* sketch,
+                int64_t* chunk_count) {
+  bool first = true;
+  while (begin < end) {
+    const size_t remaining = static_cast<size_t>(end - begin);
+    const size_t length = chunker.Next(begin, remaining);
+    const bool last = length == remaining;
+    if (!partial_edges || (!first && !last)) {
+      sketch->Add(HashBytes(reinterpret_cast<const char*>(begin), length) &
+                  kHashMask);
+      ++*chunk_count;
+    }
+    first = false;
+    begin += length;
+  }
+}
+
+}  // namespace
+
+int32_t ComputeChangeSketch(const std::string& path,
+                            const VtSketchOptions& options,
+                            VtSketch* sketch) {
+  if (options.sketch_size < 1 || options.sketch_size > VT_SKETCH_CAPACITY ||
+      options.average_chunk_bytes < kMinAverageChunkBytes ||
+      options.full_scan_bytes < 0 || options.stripe_bytes < 1 ||
+      options.stripe_interval < 1) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+
+  MappedFile file;
+  if (!file.Open(path)) return VT_ERROR_IO;
+
+  const Chunker chunker(options.average_chunk_bytes);
+  BottomK bottom_k(static_cast<size_t>(options.sketch_size));
+  const auto* data = reinterpret_cast<const unsigned char*>(file.data());
+  const int64_t size = static_cast<int64_t>(file.size());
+  int64_t chunk_count = 0;
+  int64_t scanned = std::min(size, options.full_scan_bytes);
+
+  if (scanned == size) file.AdviseSequential();
+  ChunkRange(data, data + scanned, false, chunker, &bottom_k, &chunk_count);
+
+  const int64_t block = options.stripe_bytes * options.stripe_interval;
+  for (int64_t start = options.full_scan_bytes; start < size; start += block) {
+    const int64_t length = std::min(options.stripe_bytes, size - start);
+    ChunkRange(data + start, data + start + length, true, chunker, &bottom_k,
+               &chunk_count);
+    scanned += length;
+  }
+
+  *sketch = VtSketch();
+  sketch->file_size = size;
+  sketch->scanned_bytes = scanned;
+  sketch->chunk_count = chunk_count;
+  const std::vector<uint64_t>& values = bottom_k.values();
+  sketch->hash_count = static_cast<int32_t>(values.size());
+  std::copy(values.begin(), values.end(), sketch->hashes);
+  return VT_OK;
+}
+
+}  // namespace vertree
@@ -0,0 +1,31 @@
+#ifndef VERTREE_NATIVE_CHANGE_SKETCH_H_
+#define VERTREE_NATIVE_CHANGE_SKETCH_H_
+
+#include <cstdint>
+#include <string>
+
+#include "vertree_native.h"
+
+namespace vertree {
+
+// Similarity sketch of a file for estimating how much changed between two
+// versions without comparing them byte by byte.
+//
+// The file is cut into content-defined chunks with a gear rolling hash
+// (FastCDC style: normalized chunking and skipping the minimum chunk size),
+// so an insertion only disturbs the chunks around it. Every chunk is hashed
+// and the sketch keeps the sketch_size smallest distinct hashes, which is a
+// uniform sample of the chunk set. Comparing two such bottom-k samples
+// estimates the Jaccard similarity of the chunk sets.
+//
+// Files larger than full_scan_bytes are sampled in fixed stripes past that
+// point, so the cost of a multi-gigabyte file is a fraction of reading it.
+// Inserting more than a stripe's worth of bytes shifts the later stripes
+// and inflates the estimate; the head is weighted more than the tail.
+int32_t ComputeChangeSketch(const std::string& path,
+                            const VtSketchOptions& options,
+                            VtSketch* sketch);
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_CHANGE_SKETCH_H_
@@ -0,0 +1,349 @@
+#include "checksum.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "mapped_file.h"
+#include "xxh64.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace vertree {
+
+namespace {
+
+constexpr size_t kMaxBufferBytes = size_t{1} << 20;
+constexpr size_t kMinBufferBytes = size_t{64} << 10;
+
+size_t BufferSizeFor(int64_t file_size) {
+  const size_t wanted = static_cast<size_t>(std::max<int64_t>(file_size, 0));
+  return std::clamp(wanted, kMinBufferBytes, kMaxBufferBytes);
+}
+
+#if defined(_WIN32)
+
+class LowPriorityScope {
+ public:
+  explicit LowPriorityScope(bool enabled)
+      : enabled_(enabled &&
+                 SetThreadPriority(GetCurrentThread(),
+                                   THREAD_MODE_BACKGROUND_BEGIN) != 0) {}
+  ~LowPriorityScope() {
+    if (enabled_) {
+      SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+    }
+  }
+
+  LowPriorityScope(const LowPriorityScope&) = delete;
+  LowPriorityScope& operator=(const LowPriorityScope&) = delete;
+
+ private:
+  const bool enabled_;
+};
+
+class Handle {
+ public:
+  explicit Handle(HANDLE handle) : handle_(handle) {}
+  ~Handle() {
+    if (valid()) CloseHandle(handle_);
+  }
+
+  Handle(const Handle&) = delete;
+  Handle& operator=(const Handle&) = delete;
+
+  bool valid() const { return handle_ != INVALID_HANDLE_VALUE; }
+  HANDLE get() const { return handle_; }
+
+  bool Close() {
+    const bool closed = CloseHandle(handle_) != 0;
+    handle_ = INVALID_HANDLE_VALUE;
+    return closed;
+  }
+
+ private:
+  HANDLE handle_;
+};
+
+HANDLE OpenForReading(const std::string& path) {
+  return CreateFileW(Utf8ToWide(path).c_str(), GENERIC_READ,
+                     FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                     nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                     nullptr);
+}
+
+int64_t FileSize(HANDLE file) {
+  LARGE_INTEGER size;
+  return GetFileSizeEx(file, &size) ? size.QuadPart : -1;
+}
+
+// Returns the bytes read, 0 at the end of the file and -1 on errors.
+int64_t ReadSome(HANDLE file, char* buffer, size_t capacity) {
+  DWORD read = 0;
+  if (!ReadFile(file, buffer, static_cast<DWORD>(capacity), &read, nullptr)) {
+    return -1;
+  }
+  return read;
+}
+
+bool WriteAll(HANDLE file, const char* data, size_t length) {
+  while (length > 0) {
+    DWORD written = 0;
+    if (!WriteFile(file, data, static_cast<DWORD>(length), &written,
+                   nullptr) ||
+        written == 0) {
+      return false;
+    }
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+#else
+
+// Lowers the I/O priority of the calling thread to the idle class and
+// restores it afterwards; Dart runs isolates on pooled threads, so leaving
+// it lowered would slow down unrelated work later.
+class LowPriorityScope {
+ public:
+  explicit LowPriorityScope(bool enabled) {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    if (!enabled) return;
+    previous_ = static_cast<int>(
+        syscall(SYS_ioprio_get, kIoprioWhoProcess, 0));
+    if (previous_ >= 0 &&
+        syscall(SYS_ioprio_set, kIoprioWhoProcess, 0,
+                kIoprioClassIdle << kIoprioClassShift) == 0) {
+      lowered_ = true;
+    }
+#else
+    (void)enabled;
+#endif
+  }
+  ~LowPriorityScope() {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    if (lowered_) syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, previous_);
+#endif
+  }
+
+  LowPriorityScope(const LowPriorityScope&) = delete;
+  LowPriorityScope& operator=(const LowPriorityScope&) = delete;
+
+ private:
+#if defined(__linux__) && defined(SYS_ioprio_set)
+  // From linux/ioprio.h, which not every libc ships.
+  static constexpr int kIoprioWhoProcess = 1;
+  static constexpr int kIoprioClassIdle = 3;
+  static constexpr int kIoprioClassShift = 13;
+  int previous_ = -1;
+  bool lowered_ = false;
+#endif
+};
+
+class Descriptor {
+ public:
+  explicit Descriptor(int fd) : fd_(fd) {}
+  ~Descriptor() {
+    if (valid()) close(fd_);
+  }
+
+  Descriptor(const Descriptor&) = delete;
+  Descriptor& operator=(const Descriptor&) = delete;
+
+  bool valid() const { return fd_ >= 0; }
+  int get() const { return fd_; }
+
+  bool Close() {
+    const bool closed = close(fd_) == 0;
+    fd_ = -1;
+    return closed;
+  }
+
+ private:
+  int fd_;
+};
+
+void AdviseSequential(int fd) {
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+  (void)fd;
+#endif
+}
+
+void DropCache(int fd) {
+#if defined(POSIX_FADV_DONTNEED)
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+  (void)fd;
+#endif
+}
+
+int64_t ReadSome(int fd, char* buffer, size_t capacity) {
+  while (true) {
+    const ssize_t read_bytes = read(fd, buffer, capacity);
+    if (read_bytes >= 0 || errno != EINTR) return read_bytes;
+  }
+}
+
+bool WriteAll(int fd, const char* data, size_t length) {
+  while (length > 0) {
+    const ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    length -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+#endif
+
+}  // namespace
+
+#if defined(_WIN32)
+
+int32_t ChecksumFile(const std::string& path,
+                     int32_t flags,
+                     VtChecksum* checksum) {
+  LowPriorityScope priority((flags & VT_CHECKSUM_LOW_PRIORITY) != 0);
+  Handle file(OpenForReading(path));
+  if (!file.valid()) return VT_ERROR_IO;
+
+  const size_t capacity = BufferSizeFor(FileSize(file.get()));
+  std::unique_ptr<char[]> buffer(new char[capacity]);
+  Xxh64 hash;
+  while (true) {
+    const int64_t read_bytes = ReadSome(file.get(), buffer.get(), capacity);
+    if (read_bytes < 0) return VT_ERROR_IO;
+    if (read_bytes == 0) break;
+    hash.Update(buffer.get(), static_cast<size_t>(read_bytes));
+  }
+  checksum->hash = hash.Digest();
+  checksum->size = static_cast<int64_t>(hash.total_length());
+  return VT_OK;
+}
+
+int32_t CopyFileWithChecksum(const std::string& source_path,
+                             const std::string& target_path,
+                             VtChecksum* checksum) {
+  Handle source(OpenForReading(source_path));
+  if (!source.valid()) return VT_ERROR_IO;
+  const std::wstring target_wide = Utf8ToWide(target_path);
+  Handle target(CreateFileW(target_wide.c_str(), GENERIC_WRITE, 0, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+  if (!target.valid()) return VT_ERROR_IO;
+
+  const size_t capacity = BufferSizeFor(FileSize(source.get()));
+  std::unique_ptr<char[]> buffer(new char[capacity]);
+  Xxh64 hash;
+  bool ok = true;
+  while (ok) {
+    const int64_t read_bytes = ReadSome(source.get(), buffer.get(), capacity);
+    if (read_bytes <= 0) {
+      ok = read_bytes == 0;
+      break;
+    }
+    hash.Update(buffer.get(), static_cast<size_t>(read_bytes));
+    ok = WriteAll(target.get(), buffer.get(), static_cast<size_t>(read_bytes));
+  }
+  ok = target.Close() && ok;
+  if (!ok) {
+    DeleteFileW(target_wide.c_str());
+    return VT_ERROR_IO;
+  }
+  checksum->hash = hash.Digest();
+  checksum->size = static_cast<int64_t>(hash.total_length());
+  return VT_OK;
+}
+
+#else
+
+int32_t ChecksumFile(const std::string& path,
+                     int32_t flags,
+                     VtChecksum* checksum) {
+  LowPriorityScope priority((flags & VT_CHECKSUM_LOW_PRIORITY) != 0);
+  Descriptor file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!file.valid()) return VT_ERROR_IO;
+  struct stat info;
+  if (fstat(file.get(), &info) != 0 || !S_ISREG(info.st_mode)) {
+    return VT_ERROR_IO;
+  }
+  AdviseSequential(file.get());
+
+  const size_t capacity = BufferSizeFor(info.st_size);
+  std::unique_ptr<char[]> buffer(new char[capacity]);
+  Xxh64 hash;
+  int32_t status = VT_OK;
+  while (true) {
+    const int64_t read_bytes = ReadSome(file.get(), buffer.get(), capacity);
+    if (read_bytes < 0) {
+      status = VT_ERROR_IO;
+      break;
+    }
+    if (read_bytes == 0) break;
+    hash.Update(buffer.get(), static_cast<size_t>(read_bytes));
+  }
+  if ((flags & VT_CHECKSUM_DROP_CACHE) != 0) DropCache(file.get());
+  if (status != VT_OK) return status;
+  checksum->hash = hash.Digest();
+  checksum->size = static_cast<int64_t>(hash.total_length());
+  return VT_OK;
+}
+
+int32_t CopyFileWithChecksum(const std::string& source_path,
+                             const std::string& target_path,
+                             VtChecksum* checksum) {
+  Descriptor source(open(source_path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!source.valid()) return VT_ERROR_IO;
+  struct stat info;
+  if (fstat(source.get(), &info) != 0 || !S_ISREG(info.st_mode)) {
+    return VT_ERROR_IO;
+  }
+  AdviseSequential(source.get());
+
+  const mode_t mode = info.st_mode & 07777;
+  Descriptor target(open(target_path.c_str(),
+                         O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode));
+  if (!target.valid()) return VT_ERROR_IO;
+
+  const size_t capacity = BufferSizeFor(info.st_size);
+  std::unique_ptr<char[]> buffer(new char[capacity]);
+  Xxh64 hash;
+  bool ok = true;
+  while (ok) {
+    const int64_t read_bytes = ReadSome(source.get(), buffer.get(), capacity);
+    if (read_bytes <= 0) {
+      ok = read_bytes == 0;
+      break;
+    }
+    hash.Update(buffer.get(), static_cast<size_t>(read_bytes));
+    ok = WriteAll(target.get(), buffer.get(), static_cast<size_t>(read_bytes));
+  }
+  // open() applies the umask; keep the source's bits exactly.
+  ok = ok && fchmod(target.get(), mode) == 0;
+  ok = target.Close() && ok;
+  if (!ok) {
+    unlink(target_path.c_str());
+    return VT_ERROR_IO;
+  }
+  checksum->hash = hash.Digest();
+  checksum->size = static_cast<int64_t>(hash.total_length());
+  return VT_OK;
+}
+
+#endif
+
+}  // namespace vertree
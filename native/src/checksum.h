@@ -0,0 +1,29 @@
+#ifndef VERTREE_NATIVE_CHECKSUM_H_
+#define VERTREE_NATIVE_CHECKSUM_H_
+
+#include <cstdint>
+#include <string>
+
+#include "vertree_native.h"
+
+namespace vertree {
+
+// Whole-file checksums for the integrity manifests written next to version
+// families and backup directories.
+//
+// Both functions stream through one buffer with plain read()/write() and a
+// sequential access hint instead of mapping the file: a scrub touches every
+// byte exactly once, and a read error on a damaged disk surfaces as
+// VT_ERROR_IO rather than a SIGBUS inside a mapping. XXH64 runs at several
+// GB/s per core, so the cost is the I/O itself.
+int32_t ChecksumFile(const std::string& path,
+                     int32_t flags,
+                     VtChecksum* checksum);
+
+int32_t CopyFileWithChecksum(const std::string& source_path,
+                             const std::string& target_path,
+                             VtChecksum* checksum);
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_CHECKSUM_H_
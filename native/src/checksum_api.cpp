@@ -0,0 +1,59 @@
+#include <algorithm>
+
+#include "checksum.h"
+#include "copy_engine.h"
+#include "vertree_native.h"
+
+extern "C" {
+
+int32_t vt_checksum_file(const char* path,
+                         int32_t flags,
+                         VtChecksum* out_checksum) {
+  if (path == nullptr || out_checksum == nullptr) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+  return vertree::ChecksumFile(path, flags, out_checksum);
+}
+
+int32_t vt_copy_file(const char* source_path,
+                     const char* target_path,
+                     VtChecksum* out_checksum) {
+  if (source_path == nullptr || target_path == nullptr ||
+      out_checksum == nullptr) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+  return vertree::CopyFileWithChecksum(source_path, target_path,
+                                       out_checksum);
+}
+
+void vt_copy_default_options(VtCopyOptions* options) {
+  if (options == nullptr) return;
+  options->queue_depth = 32;
+  options->buffer_bytes = 128 * 1024;
+  options->threads = 0;
+  options->flags = 0;
+}
+
+int32_t vt_copy_batch(const VtCopyJob* jobs,
+                      int32_t count,
+                      const VtCopyOptions* options,
+                      VtCopyResult* out_results) {
+  if (count < 0 || (count > 0 && (jobs == nullptr || out_results == nullptr))) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    if (jobs[i].source_path == nullptr || jobs[i].target_path == nullptr) {
+      return VT_ERROR_INVALID_ARGUMENT;
+    }
+  }
+  VtCopyOptions resolved;
+  vt_copy_default_options(&resolved);
+  if (options != nullptr) resolved = *options;
+  resolved.queue_depth = std::clamp(resolved.queue_depth, 1, 256);
+  resolved.buffer_bytes =
+      std::clamp(resolved.buffer_bytes, 4 * 1024, 8 * 1024 * 1024);
+  vertree::CopyBatch(jobs, static_cast<size_t>(count), resolved, out_results);
+  return VT_OK;
+}
+
+}  // extern "C"
@@ -0,0 +1,371 @@
+#include "copy_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "checksum.h"
+#include "io_ring.h"
+#include "xxh64.h"
+
+#if defined(VT_HAVE_IO_RING)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vertree {
+
+namespace {
+
+constexpr unsigned kMaxThreads = 8;
+
+void CopyOne(const VtCopyJob& job, VtCopyResult* result) {
+  *result = VtCopyResult{};
+  result->status = CopyFileWithChecksum(job.source_path, job.target_path,
+                                        &result->checksum);
+}
+
+void CopyOnThreads(const VtCopyJob* jobs,
+                   const std::vector<size_t>& pending,
+                   int32_t threads,
+                   VtCopyResult* results) {
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    for (size_t i = next.fetch_add(1); i < pending.size();
+         i = next.fetch_add(1)) {
+      CopyOne(jobs[pending[i]], &results[pending[i]]);
+    }
+  };
+  unsigned workers = threads > 0 ? static_cast<unsigned>(threads)
+                                 : std::thread::hardware_concurrency();
+  workers = std::clamp<unsigned>(workers, 1, kMaxThreads);
+  workers = static_cast<unsigned>(
+      std::min<size_t>(workers, std::max<size_t>(pending.size(), 1)));
+
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < workers; ++i) {
+    try {
+      pool.emplace_back(work);
+    } catch (const std::system_error&) {
+      break;  // Out of threads; the ones already running share the rest.
+    }
+  }
+  work();
+  for (std::thread& thread : pool) thread.join();
+}
+
+#if defined(VT_HAVE_IO_RING)
+
+// Set once io_uring turned out to be missing (ENOSYS), blocked by seccomp
+// (EPERM) or without the read/write opcodes, so later batches go straight
+// to the threads.
+std::atomic<bool> g_ring_unavailable{false};
+
+// One file being copied; owns the buffer of its slot while it is active.
+struct ActiveCopy {
+  size_t job = 0;
+  int source = -1;
+  int target = -1;
+  mode_t mode = 0;
+  // Source size when it was opened.
+  int64_t size = 0;
+  // Bytes read, hashed and written so far.
+  int64_t offset = 0;
+  // The chunk currently being written.
+  unsigned chunk = 0;
+  unsigned written = 0;
+  bool writing = false;
+  // The chunk was a short read that reached the size, so the source ended
+  // with it.
+  bool last_chunk = false;
+  Xxh64 hash;
+};
+
+// Opens the pair the way CopyFileWithChecksum does.
+bool OpenCopy(const VtCopyJob& job, ActiveCopy* copy) {
+  copy->source = open(job.source_path, O_RDONLY | O_CLOEXEC);
+  if (copy->source < 0) return false;
+  struct stat info;
+  if (fstat(copy->source, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close(copy->source);
+    return false;
+  }
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(copy->source, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  copy->mode = info.st_mode & 07777;
+  copy->size = static_cast<int64_t>(info.st_size);
+  copy->target = open(job.target_path,
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, copy->mode);
+  if (copy->target < 0) {
+    close(copy->source);
+    return false;
+  }
+  return true;
+}
+
+// Closes both files and fills the result; a failed copy removes the target.
+void FinishCopy(const VtCopyJob& job,
+                ActiveCopy* copy,
+                bool ok,
+                VtCopyResult* result) {
+  // open() applies the umask; keep the source's bits exactly.
+  ok = ok && fchmod(copy->target, copy->mode) == 0;
+  ok = close(copy->target) == 0 && ok;
+  close(copy->source);
+  *result = VtCopyResult{};
+  if (!ok) {
+    unlink(job.target_path);
+    result->status = VT_ERROR_IO;
+    return;
+  }
+  result->status = VT_OK;
+  result->checksum.hash = copy->hash.Digest();
+  result->checksum.size = static_cast<int64_t>(copy->hash.total_length());
+}
+
+class RingCopier {
+ public:
+  RingCopier(IoRing* ring,
+             unsigned slots,
+             size_t buffer_bytes,
+             bool short_reads)
+      : ring_(ring),
+        buffer_bytes_(buffer_bytes),
+        read_bytes_(short_reads ? buffer_bytes / 2 - 1 : buffer_bytes),
+        buffers_(new (std::nothrow) char[slots * buffer_bytes]),
+        slots_(slots) {
+    if (buffers_ == nullptr) return;
+    std::vector<iovec> iovecs(slots);
+    for (unsigned slot = 0; slot < slots; ++slot) {
+      iovecs[slot].iov_base = Buffer(slot);
+      iovecs[slot].iov_len = buffer_bytes_;
+      free_slots_.push_back(slots - 1 - slot);
+    }
+    fixed_ = ring_->RegisterBuffers(iovecs.data(), slots) == 0;
+  }
+
+  bool ready() const { return buffers_ != nullptr; }
+
+  // Copies every job, except those the kernel rejected an opcode for; they
+  // are appended to retry with their targets removed. Returns false when
+  // the ring itself failed; the buffers are then left to the kernel and
+  // every job not yet finished is in retry.
+  bool Run(const VtCopyJob* jobs,
+           size_t count,
+           VtCopyResult* results,
+           std::vector<size_t>* retry) {
+    jobs_ = jobs;
+    results_ = results;
+    retry_ = retry;
+    size_t next_job = 0;
+    while (next_job < count || in_flight_ > 0) {
+      while (!free_slots_.empty() && next_job < count) {
+        const size_t job = next_job++;
+        const unsigned slot = free_slots_.back();
+        ActiveCopy& copy = slots_[slot];
+        copy = ActiveCopy();
+        copy.job = job;
+        if (!OpenCopy(jobs[job], &copy)) {
+          results[job] = VtCopyResult{};
+          results[job].status = VT_ERROR_IO;
+          continue;
+        }
+        free_slots_.pop_back();
+        QueueRead(slot);
+      }
+      if (in_flight_ == 0) continue;
+
+      if (ring_->Submit(1) != 0) {
+        Abandon(next_job, count);
+        return false;
+      }
+      ring_->Reap([&](const io_uring_cqe& cqe) {
+        --in_flight_;
+        Complete(static_cast<unsigned>(cqe.user_data), cqe.res);
+      });
+    }
+    return true;
+  }
+
+ private:
+  char* Buffer(unsigned slot) {
+    return buffers_.get() + static_cast<size_t>(slot) * buffer_bytes_;
+  }
+
+  void Queue(unsigned slot, bool write) {
+    ActiveCopy& copy = slots_[slot];
+    io_uring_sqe* sqe = ring_->NextSqe();
+    // Every slot has at most one request in flight and the ring has an
+    // entry per slot, so this only fails if the kernel misbehaves.
+    if (sqe == nullptr) {
+      Fail(slot, false);
+      return;
+    }
+    if (write) {
+      sqe->opcode = fixed_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+      sqe->fd = copy.target;
+      sqe->addr = reinterpret_cast<uint64_t>(Buffer(slot) + copy.written);
+      sqe->len = copy.chunk - copy.written;
+      sqe->off = static_cast<uint64_t>(copy.offset + copy.written);
+    } else {
+      sqe->opcode = fixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+      sqe->fd = copy.source;
+      sqe->addr = reinterpret_cast<uint64_t>(Buffer(slot));
+      sqe->len = static_cast<uint32_t>(read_bytes_);
+      sqe->off = static_cast<uint64_t>(copy.offset);
+    }
+    sqe->buf_index = static_cast<uint16_t>(slot);
+    sqe->user_data = slot;
+    ++in_flight_;
+  }
+
+  void QueueRead(unsigned slot) { Queue(slot, false); }
+  void QueueWrite(unsigned slot) { Queue(slot, true); }
+
+  // Closes the slot's files and frees it for the next job.
+  void Finish(unsigned slot, bool ok) {
+    ActiveCopy& copy = slots_[slot];
+    FinishCopy(jobs_[copy.job], &copy, ok, &results_[copy.job]);
+    free_slots_.push_back(slot);
+  }
+
+  // Fails the slot's job; with retry it is copied again on the threads.
+  void Fail(unsigned slot, bool retry) {
+    if (retry) retry_->push_back(slots_[slot].job);
+    Finish(slot, false);
+  }
+
+  void Complete(unsigned slot, int res) {
+    ActiveCopy& copy = slots_[slot];
+    if (res == -EINVAL || res == -EOPNOTSUPP) {
+      g_ring_unavailable.store(true, std::memory_order_relaxed);
+      Fail(slot, true);
+      return;
+    }
+    if (res < 0 || (copy.writing && res == 0)) {
+      Fail(slot, false);
+      return;
+    }
+
+    if (!copy.writing) {
+      if (res == 0) {
+        Finish(slot, true);
+        return;
+      }
+      copy.hash.Update(Buffer(slot), static_cast<size_t>(res));
+      copy.chunk = static_cast<unsigned>(res);
+      copy.written = 0;
+      copy.writing = true;
+      // A short read that reaches the size seen at open means the file
+      // ended there; skipping the read that would return 0 saves a third of
+      // the requests for the small files that make up most bursts. FUSE and
+      // network mounts may also read short in the middle of a file, so
+      // anything before the size is followed by another read, and a file
+      // that grew is read on until a read returns 0.
+      copy.last_chunk = static_cast<size_t>(res) < read_bytes_ &&
+                        copy.offset + res >= copy.size;
+      QueueWrite(slot);
+      return;
+    }
+
+    copy.written += static_cast<unsigned>(res);
+    if (copy.written < copy.chunk) {
+      QueueWrite(slot);
+      return;
+    }
+    copy.offset += copy.chunk;
+    copy.writing = false;
+    if (copy.last_chunk) {
+      Finish(slot, true);
+      return;
+    }
+    QueueRead(slot);
+  }
+
+  void Abandon(size_t next_job, size_t count) {
+    // Requests may still be running in the kernel, so their buffers must
+    // outlive this object. This path needs a failing io_uring_enter, which
+    // does not happen in practice; leaking one batch of buffers beats a
+    // use-after-free.
+    buffers_.release();
+    std::vector<bool> active(slots_.size(), true);
+    for (const unsigned slot : free_slots_) active[slot] = false;
+    for (unsigned slot = 0; slot < slots_.size(); ++slot) {
+      if (!active[slot]) continue;
+      Fail(slot, true);
+    }
+    for (size_t job = next_job; job < count; ++job) retry_->push_back(job);
+  }
+
+  IoRing* ring_;
+  const size_t buffer_bytes_;
+  // Bytes asked for per read; below buffer_bytes_ only with
+  // VT_COPY_SHORT_READS.
+  const size_t read_bytes_;
+  std::unique_ptr<char[]> buffers_;
+  std::vector<ActiveCopy> slots_;
+  std::vector<unsigned> free_slots_;
+  bool fixed_ = false;
+  unsigned in_flight_ = 0;
+  const VtCopyJob* jobs_ = nullptr;
+  VtCopyResult* results_ = nullptr;
+  std::vector<size_t>* retry_ = nullptr;
+};
+
+// Returns false when nothing was copied and the whole batch should go to
+// the threads; otherwise retry lists the jobs that still need a copy.
+bool CopyOnRing(const VtCopyJob* jobs,
+                size_t count,
+                const VtCopyOptions& options,
+                VtCopyResult* results,
+                std::vector<size_t>* retry) {
+  if (g_ring_unavailable.load(std::memory_order_relaxed)) return false;
+  IoRing ring;
+  const unsigned depth = static_cast<unsigned>(
+      std::min<size_t>(count, static_cast<size_t>(options.queue_depth)));
+  const int error = ring.Open(depth);
+  if (error != 0) {
+    if (error == ENOSYS || error == EPERM) {
+      g_ring_unavailable.store(true, std::memory_order_relaxed);
+    }
+    return false;
+  }
+  RingCopier copier(&ring, depth, static_cast<size_t>(options.buffer_bytes),
+                    (options.flags & VT_COPY_SHORT_READS) != 0);
+  if (!copier.ready()) return false;
+  copier.Run(jobs, count, results, retry);
+  return true;
+}
+
+#endif  // VT_HAVE_IO_RING
+
+}  // namespace
+
+void CopyBatch(const VtCopyJob* jobs,
+               size_t count,
+               const VtCopyOptions& options,
+               VtCopyResult* results) {
+  std::vector<size_t> pending;
+#if defined(VT_HAVE_IO_RING)
+  if ((options.flags & VT_COPY_NO_RING) == 0 && count > 1 &&
+      CopyOnRing(jobs, count, options, results, &pending)) {
+    if (!pending.empty()) {
+      CopyOnThreads(jobs, pending, options.threads, results);
+    }
+    return;
+  }
+#endif
+  pending.resize(count);
+  for (size_t i = 0; i < count; ++i) pending[i] = i;
+  CopyOnThreads(jobs, pending, options.threads, results);
+}
+
+}  // namespace vertree
@@ -0,0 +1,28 @@
+#ifndef VERTREE_NATIVE_COPY_ENGINE_H_
+#define VERTREE_NATIVE_COPY_ENGINE_H_
+
+#include <cstddef>
+
+#include "vertree_native.h"
+
+namespace vertree {
+
+// Bulk copy for bursts of monitor snapshots, e.g. after a git checkout or a
+// sync client touching a whole project folder at once.
+//
+// Copying one file after another leaves the disk idle while each small file
+// is opened, hashed and closed. On Linux the engine keeps up to queue_depth
+// reads and writes of different files in flight on one io_uring, each chunk
+// going through its own registered buffer (plain buffers when registration
+// fails), and hashes every chunk between its read and its write. Files are
+// still opened synchronously. Without io_uring the jobs are spread over a
+// few threads running CopyFileWithChecksum. Either way every job ends with
+// the same result vt_copy_file would have produced.
+void CopyBatch(const VtCopyJob* jobs,
+               size_t count,
+               const VtCopyOptions& options,
+               VtCopyResult* results);
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_COPY_ENGINE_H_
@@ -0,0 +1,65 @@
+#include <new>
+
+#include "line_diff.h"
+#include "vertree_native.h"
+
+struct VtDiff {
+  vertree::LineDiff impl;
+};
+
+extern "C" {
+
+void vt_diff_default_options(VtDiffOptions* options) {
+  if (options == nullptr) return;
+  options->context_lines = 3;
+  options->max_index_bytes = int64_t{256} * 1024 * 1024;
+  options->max_edit_cost = 2048;
+}
+
+int32_t vt_diff_open(const char* old_path,
+                     const char* new_path,
+                     const VtDiffOptions* options,
+                     VtDiff** out_diff) {
+  if (old_path == nullptr || new_path == nullptr || out_diff == nullptr) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+  *out_diff = nullptr;
+
+  VtDiffOptions resolved;
+  vt_diff_default_options(&resolved);
+  if (options != nullptr) resolved = *options;
+
+  VtDiff* diff = new (std::nothrow) VtDiff();
+  if (diff == nullptr) return VT_ERROR_TOO_LARGE;
+  const int32_t status = diff->impl.Open(old_path, new_path, resolved);
+  if (status != VT_OK) {
+    delete diff;
+    return status;
+  }
+  *out_diff = diff;
+  return VT_OK;
+}
+
+void vt_diff_stats(const VtDiff* diff, VtDiffStats* out_stats) {
+  if (diff == nullptr || out_stats == nullptr) return;
+  diff->impl.Stats(out_stats);
+}
+
+int32_t vt_diff_next_hunk(VtDiff* diff, VtDiffHunk* out_hunk) {
+  if (diff == nullptr || out_hunk == nullptr) return 0;
+  return diff->impl.NextHunk(out_hunk) ? 1 : 0;
+}
+
+int32_t vt_diff_next_line(VtDiff* diff, VtDiffLine* out_line) {
+  if (diff == nullptr || out_line == nullptr) return 0;
+  return diff->impl.NextLine(out_line) ? 1 : 0;
+}
+
+int64_t vt_diff_read_unified(VtDiff* diff, char* buffer, int64_t capacity) {
+  if (diff == nullptr || buffer == nullptr || capacity <= 0) return 0;
+  return diff->impl.ReadUnified(buffer, capacity);
+}
+
+void vt_diff_close(VtDiff* diff) { delete diff; }
+
+}  // extern "C"
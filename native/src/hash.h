@@ -0,0 +1,43 @@
+#ifndef VERTREE_NATIVE_HASH_H_
+#define VERTREE_NATIVE_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace vertree {
+
+inline uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// MurmurHash3 finalizer: spreads every input bit over the whole word.
+inline uint64_t Finalize(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// Non-cryptographic hash that consumes eight bytes per round. Callers that
+// need exact equality must still compare the bytes.
+inline uint64_t HashBytes(const char* data, size_t length) {
+  uint64_t hash = 0x9e3779b97f4a7c15ULL ^ length;
+  while (length >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    hash ^= word * 0x87c37b91114253d5ULL;
+    hash = RotateLeft(hash, 31) * 0x4cf5ad432745937fULL;
+    data += 8;
+    length -= 8;
+  }
+  uint64_t tail = 0;
+  if (length > 0) std::memcpy(&tail, data, length);
+  return Finalize(hash ^ (tail * 0x87c37b91114253d5ULL));
+}
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_HASH_H_
@@ -0,0 +1,120 @@
+#include "io_ring.h"
+
+#if defined(VT_HAVE_IO_RING)
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace vertree {
+
+IoRing::~IoRing() {
+  if (sqes_ != nullptr) munmap(sqes_, sqes_bytes_);
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_bytes_);
+  }
+  if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_bytes_);
+  if (fd_ >= 0) close(fd_);
+}
+
+int IoRing::Open(unsigned entries) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  fd_ = static_cast<int>(syscall(SYS_io_uring_setup, entries, &params));
+  if (fd_ < 0) return errno;
+  entries_ = params.sq_entries;
+
+  sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_bytes_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+  }
+  void* sq_ring = mmap(nullptr, sq_ring_bytes_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) return errno;
+  sq_ring_ = sq_ring;
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void* cq_ring = mmap(nullptr, cq_ring_bytes_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) return errno;
+    cq_ring_ = cq_ring;
+  }
+  sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_bytes_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) return errno;
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* cq = static_cast<char*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return 0;
+}
+
+int IoRing::RegisterBuffers(const iovec* buffers, unsigned count) {
+  const long result = syscall(SYS_io_uring_register, fd_,
+                              IORING_REGISTER_BUFFERS, buffers, count);
+  return result == 0 ? 0 : errno;
+}
+
+io_uring_sqe* IoRing::NextSqe() {
+  // Only this thread produces submissions, so the tail can be read without
+  // synchronization; the head moves as the kernel consumes entries.
+  const unsigned tail = *sq_tail_ + prepared_;
+  const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (tail - head >= entries_) return nullptr;
+  const unsigned index = tail & sq_mask_;
+  io_uring_sqe* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  ++prepared_;
+  return sqe;
+}
+
+int IoRing::Submit(unsigned min_complete) {
+  const unsigned tail = *sq_tail_ + prepared_;
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  prepared_ = 0;
+  for (;;) {
+    // Entries the kernel has not consumed yet, including any left over from
+    // an earlier call that stopped early.
+    const unsigned pending =
+        tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    const long submitted =
+        syscall(SYS_io_uring_enter, fd_, pending, min_complete,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (submitted < 0) {
+      if (errno == EINTR) continue;
+      return -errno;
+    }
+    if (static_cast<unsigned>(submitted) >= pending) return 0;
+    if (submitted == 0) return -EAGAIN;
+  }
+}
+
+int IoRing::Wait(unsigned min_complete) {
+  for (;;) {
+    const long result = syscall(SYS_io_uring_enter, fd_, 0, min_complete,
+                                IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (result >= 0) return 0;
+    if (errno != EINTR) return -errno;
+  }
+}
+
+}  // namespace vertree
+
+#endif  // VT_HAVE_IO_RING
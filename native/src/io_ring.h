@@ -0,0 +1,108 @@
+#ifndef VERTREE_NATIVE_IO_RING_H_
+#define VERTREE_NATIVE_IO_RING_H_
+
+// Minimal io_uring driver shared by the batched stat and the bulk copy
+// engine. It talks to the kernel through the raw syscalls because liburing
+// is not available on every build machine; VT_HAVE_IO_RING is only defined
+// where the uapi header and syscall numbers are, and callers keep a
+// sequential or threaded path for everything else.
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// IORING_OP_STATX, IORING_OP_READ and IORING_OP_WRITE arrived in Linux 5.6
+// together with IORING_FEAT_RW_CUR_POS; older uapi headers lack them.
+#if defined(__linux__) && defined(SYS_io_uring_setup) && \
+    defined(SYS_io_uring_enter) && defined(SYS_io_uring_register) && \
+    defined(IORING_FEAT_RW_CUR_POS)
+#define VT_HAVE_IO_RING 1
+#endif
+
+#if defined(VT_HAVE_IO_RING)
+
+#include <sys/uio.h>
+
+#include <cstddef>
+
+namespace vertree {
+
+class IoRing {
+ public:
+  IoRing() = default;
+  ~IoRing();
+
+  IoRing(const IoRing&) = delete;
+  IoRing& operator=(const IoRing&) = delete;
+
+  // Sets up a ring with at least the given number of submission entries.
+  // Returns 0 or the errno of the failed step; ENOSYS and EPERM mean the
+  // kernel or a seccomp filter does not allow io_uring at all.
+  int Open(unsigned entries);
+
+  unsigned entries() const { return entries_; }
+
+  // Registers fixed buffers for IORING_OP_READ_FIXED/WRITE_FIXED. Returns 0
+  // or an errno (ENOMEM when RLIMIT_MEMLOCK is too low on older kernels).
+  int RegisterBuffers(const iovec* buffers, unsigned count);
+
+  // Returns a zeroed submission entry, or nullptr when all entries are
+  // queued but not yet submitted. Only one thread may prepare entries.
+  io_uring_sqe* NextSqe();
+
+  // Submits the prepared entries and waits until at least min_complete
+  // completions are available. Returns 0 or a negative errno.
+  int Submit(unsigned min_complete);
+
+  // Waits until at least min_complete completions are available without
+  // submitting anything. Returns 0 or a negative errno.
+  int Wait(unsigned min_complete);
+
+  // Submitted entries the kernel has not consumed yet. They never start, so
+  // nothing they point to is touched once the ring is torn down.
+  unsigned Unconsumed() const {
+    return *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  }
+
+  // Calls on_completion(const io_uring_cqe&) for every available completion
+  // and returns how many there were.
+  template <typename Callback>
+  unsigned Reap(Callback on_completion) {
+    unsigned head = *cq_head_;
+    const unsigned ready = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned seen = 0;
+    for (; head != ready; ++head, ++seen) {
+      on_completion(cqes_[head & cq_mask_]);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return seen;
+  }
+
+ private:
+  int fd_ = -1;
+  unsigned entries_ = 0;
+  unsigned prepared_ = 0;
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_bytes_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_bytes_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_bytes_ = 0;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+}  // namespace vertree
+
+#endif  // VT_HAVE_IO_RING
+
+#endif  // VERTREE_NATIVE_IO_RING_H_
@@ -0,0 +1,639 @@
+#include "line_diff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "hash.h"
+
+namespace vertree {
+
+namespace {
+
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+// Lines that occur more often than this in a region are never used as
+// histogram anchors; such regions go to the Myers split instead.
+constexpr uint32_t kMaxChainLength = 64;
+// Same probe window git uses to tell binary content from text.
+constexpr size_t kBinaryProbeBytes = 8000;
+constexpr int64_t kMaxLines = std::numeric_limits<int32_t>::max();
+constexpr uint32_t kNewSideTag = 0x80000000u;
+constexpr int64_t kInfinity = std::numeric_limits<int64_t>::max() / 4;
+
+int64_t NextPowerOfTwo(int64_t value) {
+  int64_t result = 16;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+std::string FormatRange(int64_t start, int64_t count) {
+  if (count == 1) return std::to_string(start + 1);
+  // An empty range names the line before it, like GNU diff.
+  if (count == 0) return std::to_string(start) + ",0";
+  return std::to_string(start + 1) + "," + std::to_string(count);
+}
+
+}  // namespace
+
+int32_t LineDiff::Open(const std::string& old_path,
+                       const std::string& new_path,
+                       const VtDiffOptions& options) {
+  options_ = options;
+  options_.context_lines = std::max(options_.context_lines, 0);
+  options_.max_edit_cost = std::max(options_.max_edit_cost, 1);
+
+  int32_t status = LoadSide(old_path, &old_);
+  if (status != VT_OK) return status;
+  status = LoadSide(new_path, &new_);
+  if (status != VT_OK) return status;
+
+  const int64_t shorter = std::min(old_.lines, new_.lines);
+  int64_t head = 0;
+  while (head < shorter && LineEquals(old_, head, new_, head)) ++head;
+  int64_t tail = 0;
+  while (tail < shorter - head &&
+         LineEquals(old_, old_.lines - 1 - tail, new_, new_.lines - 1 - tail)) {
+    ++tail;
+  }
+  const int64_t old_tail = old_.lines - tail;
+  const int64_t new_tail = new_.lines - tail;
+
+  const int64_t old_middle = old_tail - head;
+  const int64_t middle = old_middle + (new_tail - head);
+  const int64_t fixed_bytes = (old_.lines + new_.lines + 2) *
+                              static_cast<int64_t>(sizeof(uint64_t) + 1);
+  const int64_t index_bytes =
+      middle * static_cast<int64_t>(sizeof(uint32_t) * 3) +
+      NextPowerOfTwo(middle + middle / 2) *
+          static_cast<int64_t>(sizeof(Slot)) +
+      old_middle * static_cast<int64_t>(sizeof(uint32_t)) +
+      (middle + 3) * static_cast<int64_t>(sizeof(int64_t) * 2);
+  if (fixed_bytes + index_bytes > options_.max_index_bytes) {
+    return VT_ERROR_TOO_LARGE;
+  }
+
+  old_.changed.assign(static_cast<size_t>(old_.lines), 0);
+  new_.changed.assign(static_cast<size_t>(new_.lines), 0);
+  if (middle > 0) {
+    InternLines(head, old_tail, new_tail);
+    Compute(head, old_tail, new_tail);
+  }
+  CollectChanges();
+  return VT_OK;
+}
+
+void LineDiff::Stats(VtDiffStats* stats) const {
+  stats->old_lines = old_.lines;
+  stats->new_lines = new_.lines;
+  stats->removed_lines = 0;
+  stats->added_lines = 0;
+  for (const Change& change : changes_) {
+    stats->removed_lines += change.old_end - change.old_begin;
+    stats->added_lines += change.new_end - change.new_begin;
+  }
+  stats->hunk_count = hunk_count_;
+}
+
+int32_t LineDiff::LoadSide(const std::string& path, Side* side) {
+  if (!side->file.Open(path)) return VT_ERROR_IO;
+  const char* data = side->file.data();
+  const size_t size = side->file.size();
+  if (size > 0 &&
+      std::memchr(data, 0, std::min(size, kBinaryProbeBytes)) != nullptr) {
+    return VT_ERROR_BINARY;
+  }
+  side->file.AdviseSequential();
+
+  // memchr is vectorized by the C runtime, so both passes run close to
+  // memory bandwidth; the first one only counts so the offsets are sized
+  // exactly and the memory cap is checked before allocating.
+  const char* const end = data + size;
+  int64_t lines = 0;
+  for (const char* cursor = data; cursor < end;) {
+    const void* newline =
+        std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+    ++lines;
+    if (newline == nullptr) break;
+    cursor = static_cast<const char*>(newline) + 1;
+  }
+  if (lines > kMaxLines ||
+      (lines + 1) * static_cast<int64_t>(sizeof(uint64_t) + 1) >
+          options_.max_index_bytes) {
+    return VT_ERROR_TOO_LARGE;
+  }
+
+  side->lines = lines;
+  side->offsets.resize(static_cast<size_t>(lines + 1));
+  side->offsets[0] = 0;
+  size_t line = 1;
+  for (const char* cursor = data; cursor < end;) {
+    const void* newline =
+        std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+    if (newline == nullptr) {
+      side->offsets[line++] = size;
+      break;
+    }
+    cursor = static_cast<const char*>(newline) + 1;
+    side->offsets[line++] = static_cast<uint64_t>(cursor - data);
+  }
+  return VT_OK;
+}
+
+const char* LineDiff::LineData(const Side& side, int64_t line) const {
+  return side.file.data() + side.offsets[static_cast<size_t>(line)];
+}
+
+int64_t LineDiff::LineLength(const Side& side, int64_t line) const {
+  const size_t index = static_cast<size_t>(line);
+  return static_cast<int64_t>(side.offsets[index + 1] - side.offsets[index]);
+}
+
+bool LineDiff::LineEquals(const Side& a,
+                          int64_t i,
+                          const Side& b,
+                          int64_t j) const {
+  const int64_t length = LineLength(a, i);
+  return length == LineLength(b, j) &&
+         std::memcmp(LineData(a, i), LineData(b, j),
+                     static_cast<size_t>(length)) == 0;
+}
+
+void LineDiff::InternLines(int64_t head, int64_t old_tail, int64_t new_tail) {
+  const int64_t middle = (old_tail - head) + (new_tail - head);
+  table_.assign(static_cast<size_t>(NextPowerOfTwo(middle + middle / 2)),
+                Slot{0, kNone, 0});
+  head_ = head;
+  old_.ids.resize(static_cast<size_t>(old_tail - head));
+  for (int64_t line = head; line < old_tail; ++line) {
+    old_.ids[static_cast<size_t>(line - head)] = Intern(old_, line, 0);
+  }
+  new_.ids.resize(static_cast<size_t>(new_tail - head));
+  for (int64_t line = head; line < new_tail; ++line) {
+    new_.ids[static_cast<size_t>(line - head)] =
+        Intern(new_, line, kNewSideTag);
+  }
+  std::vector<Slot>().swap(table_);
+}
+
+uint32_t LineDiff::Intern(const Side& side, int64_t line, uint32_t tag) {
+  const uint64_t hash = HashBytes(LineData(side, line),
+                                 static_cast<size_t>(LineLength(side, line)));
+  const size_t mask = table_.size() - 1;
+  for (size_t index = static_cast<size_t>(hash) & mask;;
+       index = (index + 1) & mask) {
+    Slot& slot = table_[index];
+    if (slot.id == kNone) {
+      slot = Slot{hash, unique_, static_cast<uint32_t>(line) | tag};
+      return unique_++;
+    }
+    if (slot.hash != hash) continue;
+    const Side& owner = (slot.representative & kNewSideTag) ? new_ : old_;
+    if (LineEquals(owner, slot.representative & ~kNewSideTag, side, line)) {
+      return slot.id;
+    }
+  }
+}
+
+void LineDiff::Compute(int64_t head, int64_t old_tail, int64_t new_tail) {
+  occurrence_head_.assign(unique_, kNone);
+  occurrence_count_.assign(unique_, 0);
+  occurrence_next_.resize(static_cast<size_t>(old_tail - head));
+
+  const auto old_id = [this](int64_t line) {
+    return old_.ids[static_cast<size_t>(line - head_)];
+  };
+  const auto new_id = [this](int64_t line) {
+    return new_.ids[static_cast<size_t>(line - head_)];
+  };
+
+  // Explicit stack: capped Myers splits can chain deeply on large inputs.
+  std::vector<Region> stack;
+  stack.push_back(Region{head, old_tail, head, new_tail, true});
+  while (!stack.empty()) {
+    Region region = stack.back();
+    stack.pop_back();
+
+    while (region.old_begin < region.old_end &&
+           region.new_begin < region.new_end &&
+           old_id(region.old_begin) == new_id(region.new_begin)) {
+      ++region.old_begin;
+      ++region.new_begin;
+    }
+    while (region.old_begin < region.old_end &&
+           region.new_begin < region.new_end &&
+           old_id(region.old_end - 1) == new_id(region.new_end - 1)) {
+      --region.old_end;
+      --region.new_end;
+    }
+    if (region.old_begin == region.old_end ||
+        region.new_begin == region.new_end) {
+      MarkChanged(region);
+      continue;
+    }
+
+    if (region.histogram) {
+      Region anchor{};
+      if (FindAnchor(region, &anchor)) {
+        stack.push_back(Region{region.old_begin, anchor.old_begin,
+                               region.new_begin, anchor.new_begin, true});
+        stack.push_back(Region{anchor.old_end, region.old_end,
+                               anchor.new_end, region.new_end, true});
+        continue;
+      }
+    }
+
+    int64_t old_split = 0;
+    int64_t new_split = 0;
+    if (!Split(region, &old_split, &new_split)) {
+      MarkChanged(region);
+      continue;
+    }
+    stack.push_back(Region{region.old_begin, old_split, region.new_begin,
+                           new_split, false});
+    stack.push_back(
+        Region{old_split, region.old_end, new_split, region.new_end, false});
+  }
+
+  // The session may stay open while Dart streams the output; only the
+  // offsets and changed flags are needed from here on.
+  std::vector<uint32_t>().swap(old_.ids);
+  std::vector<uint32_t>().swap(new_.ids);
+  std::vector<uint32_t>().swap(occurrence_head_);
+  std::vector<uint32_t>().swap(occurrence_count_);
+  std::vector<uint32_t>().swap(occurrence_next_);
+  std::vector<int64_t>().swap(forward_);
+  std::vector<int64_t>().swap(backward_);
+}
+
+// Histogram step: among lines of the new side that occur at most
+// kMaxChainLength times in the old region, extend every occurrence into a
+// maximal common run and keep the run whose rarest line is rarest, then the
+// longest one.
+bool LineDiff::FindAnchor(const Region& region, Region* anchor) {
+  const uint32_t* a = old_.ids.data() + (region.old_begin - head_);
+  const uint32_t* b = new_.ids.data() + (region.new_begin - head_);
+  uint32_t* next = occurrence_next_.data() + (region.old_begin - head_);
+  const int64_t n = region.old_end - region.old_begin;
+  const int64_t m = region.new_end - region.new_begin;
+
+  for (int64_t i = n - 1; i >= 0; --i) {
+    const uint32_t id = a[i];
+    if (occurrence_count_[id] == 0) touched_.push_back(id);
+    if (occurrence_count_[id] <= kMaxChainLength) ++occurrence_count_[id];
+    next[i] = occurrence_head_[id];
+    occurrence_head_[id] = static_cast<uint32_t>(i);
+  }
+
+  bool found = false;
+  uint32_t best_rarity = kMaxChainLength;
+  int64_t best_length = 0;
+  for (int64_t j = 0; j < m;) {
+    const uint32_t count = occurrence_count_[b[j]];
+    int64_t next_j = j + 1;
+    if (count == 0 || count > best_rarity) {
+      j = next_j;
+      continue;
+    }
+    for (uint32_t i = occurrence_head_[b[j]]; i != kNone; i = next[i]) {
+      int64_t start_a = i;
+      int64_t start_b = j;
+      while (start_a > 0 && start_b > 0 && a[start_a - 1] == b[start_b - 1]) {
+        --start_a;
+        --start_b;
+      }
+      int64_t end_a = static_cast<int64_t>(i) + 1;
+      int64_t end_b = j + 1;
+      while (end_a < n && end_b < m && a[end_a] == b[end_b]) {
+        ++end_a;
+        ++end_b;
+      }
+
+      uint32_t rarity = count;
+      for (int64_t k = start_a; k < end_a && rarity > 1; ++k) {
+        rarity = std::min(rarity, occurrence_count_[a[k]]);
+      }
+      const int64_t length = end_a - start_a;
+      if (!found || rarity < best_rarity ||
+          (rarity == best_rarity && length > best_length)) {
+        found = true;
+        best_rarity = rarity;
+        best_length = length;
+        anchor->old_begin = region.old_begin + start_a;
+        anchor->old_end = region.old_begin + end_a;
+        anchor->new_begin = region.new_begin + start_b;
+        anchor->new_end = region.new_begin + end_b;
+      }
+      next_j = std::max(next_j, end_b);
+    }
+    j = next_j;
+  }
+
+  for (const uint32_t id : touched_) {
+    occurrence_head_[id] = kNone;
+    occurrence_count_[id] = 0;
+  }
+  touched_.clear();
+  return found;
+}
+
+// Bidirectional Myers search for a point on an optimal edit path, as in
+// xdiff. Both ends of the region are known to differ. Once the edit cost
+// reaches max_edit_cost the furthest reaching diagonal is used instead.
+bool LineDiff::Split(const Region& region,
+                     int64_t* old_split,
+                     int64_t* new_split) {
+  const uint32_t* a = old_.ids.data() + (region.old_begin - head_);
+  const uint32_t* b = new_.ids.data() + (region.new_begin - head_);
+  const int64_t n = region.old_end - region.old_begin;
+  const int64_t m = region.new_end - region.new_begin;
+
+  forward_.resize(static_cast<size_t>(n + m + 3));
+  backward_.resize(static_cast<size_t>(n + m + 3));
+  // Indexed by diagonal d = x - y, which ranges over [-m - 1, n + 1].
+  int64_t* kvdf = forward_.data() + m + 1;
+  int64_t* kvdb = backward_.data() + m + 1;
+
+  const int64_t dmin = -m;
+  const int64_t dmax = n;
+  const int64_t fmid = 0;
+  const int64_t bmid = n - m;
+  const bool odd = ((n - m) % 2) != 0;
+  int64_t fmin = fmid;
+  int64_t fmax = fmid;
+  int64_t bmin = bmid;
+  int64_t bmax = bmid;
+  kvdf[fmid] = 0;
+  kvdb[bmid] = n;
+
+  // Like xdiff, large regions get a cost limit near the square root of their
+  // size; max_edit_cost is the upper bound.
+  int64_t cost_limit = 256;
+  while (cost_limit * cost_limit < n + m) cost_limit <<= 1;
+  cost_limit = std::min<int64_t>(cost_limit, options_.max_edit_cost);
+
+  int64_t split_x = -1;
+  int64_t split_y = -1;
+  for (int64_t cost = 1; split_x < 0; ++cost) {
+    if (fmin > dmin) {
+      kvdf[--fmin - 1] = -1;
+    } else {
+      ++fmin;
+    }
+    if (fmax < dmax) {
+      kvdf[++fmax + 1] = -1;
+    } else {
+      --fmax;
+    }
+    for (int64_t d = fmax; d >= fmin && split_x < 0; d -= 2) {
+      int64_t x = kvdf[d - 1] >= kvdf[d + 1] ? kvdf[d - 1] + 1 : kvdf[d + 1];
+      int64_t y = x - d;
+      while (x < n && y < m && a[x] == b[y]) {
+        ++x;
+        ++y;
+      }
+      kvdf[d] = x;
+      if (odd && bmin <= d && d <= bmax && kvdb[d] <= x) {
+        split_x = x;
+        split_y = y;
+      }
+    }
+    if (split_x >= 0) break;
+
+    if (bmin > dmin) {
+      kvdb[--bmin - 1] = kInfinity;
+    } else {
+      ++bmin;
+    }
+    if (bmax < dmax) {
+      kvdb[++bmax + 1] = kInfinity;
+    } else {
+      --bmax;
+    }
+    for (int64_t d = bmax; d >= bmin && split_x < 0; d -= 2) {
+      int64_t x = kvdb[d - 1] < kvdb[d + 1] ? kvdb[d - 1] : kvdb[d + 1] - 1;
+      int64_t y = x - d;
+      while (x > 0 && y > 0 && a[x - 1] == b[y - 1]) {
+        --x;
+        --y;
+      }
+      kvdb[d] = x;
+      if (!odd && fmin <= d && d <= fmax && x <= kvdf[d]) {
+        split_x = x;
+        split_y = y;
+      }
+    }
+    if (split_x >= 0 || cost < cost_limit) continue;
+
+    int64_t forward_best = -1;
+    int64_t forward_x = 0;
+    for (int64_t d = fmax; d >= fmin; d -= 2) {
+      int64_t x = std::min(kvdf[d], n);
+      int64_t y = x - d;
+      if (y > m) {
+        x = m + d;
+        y = m;
+      }
+      if (x + y > forward_best) {
+        forward_best = x + y;
+        forward_x = x;
+      }
+    }
+    int64_t backward_best = kInfinity;
+    int64_t backward_x = 0;
+    for (int64_t d = bmax; d >= bmin; d -= 2) {
+      int64_t x = std::max<int64_t>(kvdb[d], 0);
+      int64_t y = x - d;
+      if (y < 0) {
+        x = d;
+        y = 0;
+      }
+      if (x + y < backward_best) {
+        backward_best = x + y;
+        backward_x = x;
+      }
+    }
+    if ((n + m) - backward_best < forward_best) {
+      split_x = forward_x;
+      split_y = forward_best - forward_x;
+    } else {
+      split_x = backward_x;
+      split_y = backward_best - backward_x;
+    }
+  }
+
+  if (split_x < 0 || split_x > n || split_y < 0 || split_y > m ||
+      (split_x == 0 && split_y == 0) || (split_x == n && split_y == m)) {
+    return false;
+  }
+  *old_split = region.old_begin + split_x;
+  *new_split = region.new_begin + split_y;
+  return true;
+}
+
+void LineDiff::MarkChanged(const Region& region) {
+  std::fill(old_.changed.begin() + region.old_begin,
+            old_.changed.begin() + region.old_end, 1);
+  std::fill(new_.changed.begin() + region.new_begin,
+            new_.changed.begin() + region.new_end, 1);
+}
+
+void LineDiff::CollectChanges() {
+  changes_.clear();
+  int64_t i = 0;
+  int64_t j = 0;
+  while (i < old_.lines || j < new_.lines) {
+    const bool old_changed = i < old_.lines && old_.changed[i];
+    const bool new_changed = j < new_.lines && new_.changed[j];
+    if (!old_changed && !new_changed) {
+      ++i;
+      ++j;
+      continue;
+    }
+    Change change{i, i, j, j};
+    while (change.old_end < old_.lines && old_.changed[change.old_end]) {
+      ++change.old_end;
+    }
+    while (change.new_end < new_.lines && new_.changed[change.new_end]) {
+      ++change.new_end;
+    }
+    changes_.push_back(change);
+    i = change.old_end;
+    j = change.new_end;
+  }
+
+  hunk_count_ = 0;
+  for (size_t first = 0; first < changes_.size(); first = HunkEnd(first)) {
+    ++hunk_count_;
+  }
+}
+
+size_t LineDiff::HunkEnd(size_t first) const {
+  const int64_t merge_gap = 2 * static_cast<int64_t>(options_.context_lines);
+  size_t last = first;
+  while (last + 1 < changes_.size() &&
+         changes_[last + 1].old_begin - changes_[last].old_end <= merge_gap) {
+    ++last;
+  }
+  return last + 1;
+}
+
+bool LineDiff::NextHunk(VtDiffHunk* hunk) {
+  in_hunk_ = false;
+  if (next_change_ >= changes_.size()) return false;
+
+  const size_t end = HunkEnd(next_change_);
+  const Change& first = changes_[next_change_];
+  const Change& last = changes_[end - 1];
+  const int64_t context = options_.context_lines;
+  const int64_t leading = std::min(context, first.old_begin);
+  const int64_t trailing = std::min(context, old_.lines - last.old_end);
+
+  hunk->old_start = first.old_begin - leading;
+  hunk->old_count = last.old_end + trailing - hunk->old_start;
+  hunk->new_start = first.new_begin - leading;
+  hunk->new_count = last.new_end + trailing - hunk->new_start;
+
+  hunk_change_ = next_change_;
+  hunk_change_end_ = end;
+  next_change_ = end;
+  cursor_old_ = hunk->old_start;
+  cursor_new_ = hunk->new_start;
+  hunk_old_end_ = hunk->old_start + hunk->old_count;
+  in_hunk_ = true;
+  return true;
+}
+
+bool LineDiff::NextLine(VtDiffLine* line) {
+  if (!in_hunk_) return false;
+  while (hunk_change_ < hunk_change_end_) {
+    const Change& change = changes_[hunk_change_];
+    if (cursor_old_ < change.old_begin) break;
+    if (cursor_old_ < change.old_end) {
+      FillLine(VT_DIFF_LINE_REMOVED, cursor_old_++, -1, line);
+      return true;
+    }
+    if (cursor_new_ < change.new_end) {
+      FillLine(VT_DIFF_LINE_ADDED, -1, cursor_new_++, line);
+      return true;
+    }
+    ++hunk_change_;
+  }
+  if (cursor_old_ < hunk_old_end_) {
+    FillLine(VT_DIFF_LINE_CONTEXT, cursor_old_++, cursor_new_++, line);
+    return true;
+  }
+  in_hunk_ = false;
+  return false;
+}
+
+void LineDiff::FillLine(int32_t kind,
+                        int64_t old_line,
+                        int64_t new_line,
+                        VtDiffLine* line) const {
+  const Side& side = old_line >= 0 ? old_ : new_;
+  const int64_t index = old_line >= 0 ? old_line : new_line;
+  const char* text = LineData(side, index);
+  int64_t length = LineLength(side, index);
+  const bool has_newline = length > 0 && text[length - 1] == '\n';
+  line->kind = kind;
+  line->missing_newline = has_newline ? 0 : 1;
+  line->old_line = old_line;
+  line->new_line = new_line;
+  line->text = text;
+  line->length = has_newline ? length - 1 : length;
+}
+
+int64_t LineDiff::ReadUnified(char* buffer, int64_t capacity) {
+  int64_t written = 0;
+  while (written < capacity) {
+    const int64_t room = capacity - written;
+    if (!pending_head_.empty()) {
+      const size_t count = static_cast<size_t>(
+          std::min<int64_t>(room, static_cast<int64_t>(pending_head_.size())));
+      std::memcpy(buffer + written, pending_head_.data(), count);
+      pending_head_.erase(0, count);
+      written += static_cast<int64_t>(count);
+      continue;
+    }
+    if (pending_text_length_ > 0) {
+      const int64_t count = std::min(room, pending_text_length_);
+      std::memcpy(buffer + written, pending_text_, static_cast<size_t>(count));
+      pending_text_ += count;
+      pending_text_length_ -= count;
+      written += count;
+      continue;
+    }
+    if (!pending_tail_.empty()) {
+      const size_t count = static_cast<size_t>(
+          std::min<int64_t>(room, static_cast<int64_t>(pending_tail_.size())));
+      std::memcpy(buffer + written, pending_tail_.data(), count);
+      pending_tail_.erase(0, count);
+      written += static_cast<int64_t>(count);
+      continue;
+    }
+
+    VtDiffLine line;
+    if (NextLine(&line)) {
+      const char prefix = line.kind == VT_DIFF_LINE_REMOVED ? '-'
+                          : line.kind == VT_DIFF_LINE_ADDED ? '+'
+                                                             : ' ';
+      pending_head_.assign(1, prefix);
+      pending_text_ = line.text;
+      pending_text_length_ = line.length;
+      pending_tail_ = line.missing_newline ? "\n\\ No newline at end of file\n"
+                                           : "\n";
+      continue;
+    }
+    VtDiffHunk hunk;
+    if (NextHunk(&hunk)) {
+      pending_head_ = "@@ -" + FormatRange(hunk.old_start, hunk.old_count) +
+                      " +" + FormatRange(hunk.new_start, hunk.new_count) +
+                      " @@\n";
+      continue;
+    }
+    break;
+  }
+  return written;
+}
+
+}  // namespace vertree
@@ -0,0 +1,128 @@
+#ifndef VERTREE_NATIVE_LINE_DIFF_H_
+#define VERTREE_NATIVE_LINE_DIFF_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "vertree_native.h"
+
+namespace vertree {
+
+// Line diff between two files.
+//
+// Both files are memory mapped and split on '\n'. The common head and tail
+// are stripped by plain byte comparison; the remaining lines are hashed and
+// interned into dense ids so every later comparison is an integer compare.
+// The edit script comes from histogram diff (anchor on the rarest common
+// line, recurse on both sides), falling back to Myers' O(ND) split when a
+// region has no rare anchor. The Myers search is capped by max_edit_cost and
+// then splits at the furthest reaching diagonal, which keeps pathological
+// inputs bounded at the price of a non-minimal script.
+//
+// The result is kept as one changed flag per line. Hunks and their lines
+// are produced lazily from it, so the output never has to be materialized.
+class LineDiff {
+ public:
+  LineDiff() = default;
+
+  LineDiff(const LineDiff&) = delete;
+  LineDiff& operator=(const LineDiff&) = delete;
+
+  int32_t Open(const std::string& old_path,
+               const std::string& new_path,
+               const VtDiffOptions& options);
+
+  void Stats(VtDiffStats* stats) const;
+  bool NextHunk(VtDiffHunk* hunk);
+  bool NextLine(VtDiffLine* line);
+  int64_t ReadUnified(char* buffer, int64_t capacity);
+
+ private:
+  struct Side {
+    MappedFile file;
+    // offsets[i] .. offsets[i + 1] is line i including its terminator.
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> changed;
+    std::vector<uint32_t> ids;
+    int64_t lines = 0;
+  };
+
+  struct Region {
+    int64_t old_begin;
+    int64_t old_end;
+    int64_t new_begin;
+    int64_t new_end;
+    bool histogram;
+  };
+
+  struct Change {
+    int64_t old_begin;
+    int64_t old_end;
+    int64_t new_begin;
+    int64_t new_end;
+  };
+
+  struct Slot {
+    uint64_t hash;
+    uint32_t id;
+    uint32_t representative;
+  };
+
+  int32_t LoadSide(const std::string& path, Side* side);
+  bool LineEquals(const Side& a, int64_t i, const Side& b, int64_t j) const;
+  const char* LineData(const Side& side, int64_t line) const;
+  int64_t LineLength(const Side& side, int64_t line) const;
+
+  void InternLines(int64_t head, int64_t old_tail, int64_t new_tail);
+  uint32_t Intern(const Side& side, int64_t line, uint32_t tag);
+
+  void Compute(int64_t head, int64_t old_tail, int64_t new_tail);
+  bool FindAnchor(const Region& region, Region* anchor);
+  bool Split(const Region& region, int64_t* old_split, int64_t* new_split);
+  void MarkChanged(const Region& region);
+  void CollectChanges();
+
+  size_t HunkEnd(size_t first) const;
+  void FillLine(int32_t kind, int64_t old_line, int64_t new_line,
+                VtDiffLine* line) const;
+
+  VtDiffOptions options_{};
+  Side old_;
+  Side new_;
+  // Offset of the interned range; ids[i] belongs to line head_ + i.
+  int64_t head_ = 0;
+
+  std::vector<Slot> table_;
+  uint32_t unique_ = 0;
+
+  std::vector<uint32_t> occurrence_head_;
+  std::vector<uint32_t> occurrence_count_;
+  std::vector<uint32_t> occurrence_next_;
+  std::vector<uint32_t> touched_;
+  std::vector<int64_t> forward_;
+  std::vector<int64_t> backward_;
+
+  std::vector<Change> changes_;
+  int64_t hunk_count_ = 0;
+
+  // Cursor over hunks and the lines of the current hunk.
+  size_t next_change_ = 0;
+  size_t hunk_change_ = 0;
+  size_t hunk_change_end_ = 0;
+  int64_t cursor_old_ = 0;
+  int64_t cursor_new_ = 0;
+  int64_t hunk_old_end_ = 0;
+  bool in_hunk_ = false;
+
+  // Pending unified output: head, then a slice of the mapping, then tail.
+  std::string pending_head_;
+  const char* pending_text_ = nullptr;
+  int64_t pending_text_length_ = 0;
+  std::string pending_tail_;
+};
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_LINE_DIFF_H_
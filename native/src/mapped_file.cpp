@@ -0,0 +1,115 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vertree {
+
+MappedFile::~MappedFile() { Close(); }
+
+#if defined(_WIN32)
+
+std::wstring Utf8ToWide(const std::string& value) {
+  if (value.empty()) return std::wstring();
+  const int length = MultiByteToWideChar(CP_UTF8, 0, value.data(),
+                                         static_cast<int>(value.size()),
+                                         nullptr, 0);
+  std::wstring result(static_cast<size_t>(length), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, value.data(),
+                      static_cast<int>(value.size()), result.data(), length);
+  return result;
+}
+
+bool MappedFile::Open(const std::string& utf8_path) {
+  Close();
+  HANDLE file = CreateFileW(Utf8ToWide(utf8_path).c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return false;
+  }
+  if (file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return true;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) return false;
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    return false;
+  }
+  mapping_ = mapping;
+  data_ = static_cast<const char*>(view);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) UnmapViewOfFile(data_);
+  if (mapping_ != nullptr) CloseHandle(mapping_);
+  data_ = nullptr;
+  mapping_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::AdviseSequential() const {}
+
+#else
+
+bool MappedFile::Open(const std::string& utf8_path) {
+  Close();
+  const int fd = open(utf8_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close(fd);
+    return false;
+  }
+  if (info.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) return false;
+
+  data_ = static_cast<const char*>(view);
+  size_ = static_cast<size_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void MappedFile::AdviseSequential() const {
+  if (data_ != nullptr) {
+    madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+  }
+}
+
+#endif
+
+}  // namespace vertree
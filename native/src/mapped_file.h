@@ -0,0 +1,44 @@
+#ifndef VERTREE_NATIVE_MAPPED_FILE_H_
+#define VERTREE_NATIVE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace vertree {
+
+// Read-only memory mapping of a whole file. The pages belong to the OS page
+// cache, so large versions can be scanned without copying them onto the heap.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps the file at the UTF-8 path. Empty files succeed with size() == 0.
+  bool Open(const std::string& utf8_path);
+  void Close();
+
+  // Hints that the mapping is about to be read front to back.
+  void AdviseSequential() const;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  void* mapping_ = nullptr;
+#endif
+};
+
+#if defined(_WIN32)
+// Windows APIs take UTF-16 paths; the C interface passes UTF-8.
+std::wstring Utf8ToWide(const std::string& value);
+#endif
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_MAPPED_FILE_H_
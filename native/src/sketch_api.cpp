@@ -0,0 +1,27 @@
+#include "change_sketch.h"
+#include "vertree_native.h"
+
+extern "C" {
+
+void vt_sketch_default_options(VtSketchOptions* options) {
+  if (options == nullptr) return;
+  options->sketch_size = 128;
+  options->average_chunk_bytes = 8 * 1024;
+  options->full_scan_bytes = int64_t{64} * 1024 * 1024;
+  options->stripe_bytes = int64_t{1} * 1024 * 1024;
+  options->stripe_interval = 8;
+}
+
+int32_t vt_sketch_file(const char* path,
+                       const VtSketchOptions* options,
+                       VtSketch* out_sketch) {
+  if (path == nullptr || out_sketch == nullptr) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+  VtSketchOptions resolved;
+  vt_sketch_default_options(&resolved);
+  if (options != nullptr) resolved = *options;
+  return vertree::ComputeChangeSketch(path, resolved, out_sketch);
+}
+
+}  // extern "C"
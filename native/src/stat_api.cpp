@@ -0,0 +1,25 @@
+#include "stat_batch.h"
+#include "vertree_native.h"
+
+extern "C" {
+
+int32_t vt_filesystem_kind(const char* path) {
+  if (path == nullptr) return VT_FS_LOCAL;
+  return vertree::FilesystemKind(path);
+}
+
+int32_t vt_stat_batch(const char* const* paths,
+                      int32_t count,
+                      int32_t flags,
+                      VtFileStat* out_stats) {
+  if (count < 0 || (count > 0 && (paths == nullptr || out_stats == nullptr))) {
+    return VT_ERROR_INVALID_ARGUMENT;
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    if (paths[i] == nullptr) return VT_ERROR_INVALID_ARGUMENT;
+  }
+  vertree::StatBatch(paths, static_cast<size_t>(count), flags, out_stats);
+  return VT_OK;
+}
+
+}  // extern "C"
@@ -0,0 +1,336 @@
+#include "stat_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+
+#include "mapped_file.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/statfs.h>
+#elif defined(__APPLE__)
+#include <sys/mount.h>
+#include <sys/param.h>
+#endif
+#endif
+
+#include "io_ring.h"
+
+#if defined(VT_HAVE_IO_RING) && defined(STATX_BASIC_STATS)
+#define VT_HAVE_STAT_RING 1
+#endif
+
+namespace vertree {
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1000000000;
+
+#if defined(_WIN32)
+
+// FILETIME counts 100 ns intervals since 1601-01-01.
+constexpr int64_t kFileTimeUnixEpoch = 116444736000000000;
+
+int64_t FileTimeToUnixNanos(const FILETIME& time) {
+  const int64_t ticks = (static_cast<int64_t>(time.dwHighDateTime) << 32) |
+                        time.dwLowDateTime;
+  return (ticks - kFileTimeUnixEpoch) * 100;
+}
+
+void StatOne(const char* path, int32_t flags, VtFileStat* stat) {
+  (void)flags;
+  *stat = VtFileStat{};
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if (!GetFileAttributesExW(Utf8ToWide(path).c_str(), GetFileExInfoStandard,
+                            &data)) {
+    const DWORD error = GetLastError();
+    stat->status = error == ERROR_FILE_NOT_FOUND ||
+                           error == ERROR_PATH_NOT_FOUND
+                       ? VT_ERROR_NOT_FOUND
+                       : VT_ERROR_IO;
+    return;
+  }
+  stat->status = VT_OK;
+  stat->size = (static_cast<int64_t>(data.nFileSizeHigh) << 32) |
+               data.nFileSizeLow;
+  stat->modified_ns = FileTimeToUnixNanos(data.ftLastWriteTime);
+  stat->changed_ns = stat->modified_ns;
+}
+
+#else
+
+int32_t StatusFromErrno(int error) {
+  return error == ENOENT || error == ENOTDIR ? VT_ERROR_NOT_FOUND
+                                             : VT_ERROR_IO;
+}
+
+void FailStat(int error, VtFileStat* stat) {
+  *stat = VtFileStat{};
+  stat->status = StatusFromErrno(error);
+}
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+
+constexpr unsigned kStatxMask =
+    STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_INO;
+
+int StatxFlags(int32_t flags) {
+  return (flags & VT_STAT_FORCE_SYNC) != 0 ? AT_STATX_FORCE_SYNC
+                                           : AT_STATX_SYNC_AS_STAT;
+}
+
+int64_t ToNanos(const struct statx_timestamp& time) {
+  return static_cast<int64_t>(time.tv_sec) * kNanosPerSecond + time.tv_nsec;
+}
+
+void FillFromStatx(const struct statx& info, VtFileStat* stat) {
+  *stat = VtFileStat{};
+  stat->status = VT_OK;
+  stat->size = static_cast<int64_t>(info.stx_size);
+  stat->modified_ns = ToNanos(info.stx_mtime);
+  stat->changed_ns = ToNanos(info.stx_ctime);
+  stat->file_id = info.stx_ino;
+}
+
+void StatOne(const char* path, int32_t flags, VtFileStat* stat) {
+  struct statx info;
+  if (statx(AT_FDCWD, path, StatxFlags(flags), kStatxMask, &info) != 0) {
+    FailStat(errno, stat);
+    return;
+  }
+  FillFromStatx(info, stat);
+}
+
+#else
+
+void StatOne(const char* path, int32_t flags, VtFileStat* stat) {
+  (void)flags;
+  struct stat info;
+  if (::stat(path, &info) != 0) {
+    FailStat(errno, stat);
+    return;
+  }
+  *stat = VtFileStat{};
+  stat->status = VT_OK;
+  stat->size = static_cast<int64_t>(info.st_size);
+#if defined(__APPLE__)
+  stat->modified_ns = static_cast<int64_t>(info.st_mtimespec.tv_sec) *
+                          kNanosPerSecond +
+                      info.st_mtimespec.tv_nsec;
+  stat->changed_ns = static_cast<int64_t>(info.st_ctimespec.tv_sec) *
+                         kNanosPerSecond +
+                     info.st_ctimespec.tv_nsec;
+#else
+  stat->modified_ns =
+      static_cast<int64_t>(info.st_mtim.tv_sec) * kNanosPerSecond +
+      info.st_mtim.tv_nsec;
+  stat->changed_ns =
+      static_cast<int64_t>(info.st_ctim.tv_sec) * kNanosPerSecond +
+      info.st_ctim.tv_nsec;
+#endif
+  stat->file_id = static_cast<uint64_t>(info.st_ino);
+}
+
+#endif  // __linux__ && STATX_BASIC_STATS
+
+#endif  // _WIN32
+
+#if defined(VT_HAVE_STAT_RING)
+
+// Below this many paths the ring setup costs more than it saves.
+constexpr size_t kMinRingBatch = 4;
+// Requests in flight at once; the kernel caps its workers per ring by the
+// same number, so this is also the concurrency towards the server.
+constexpr unsigned kMaxRingEntries = 64;
+
+// Set once io_uring turned out to be missing (ENOSYS), blocked by seccomp
+// (EPERM), rejecting the setup parameters or without IORING_OP_STATX
+// (EINVAL), so later batches skip the attempt. Other failures such as EAGAIN,
+// EBUSY or ENOMEM are transient and only send one batch down the sequential
+// path.
+std::atomic<bool> g_ring_unavailable{false};
+
+bool IsPermanentRingError(int error) {
+  return error == ENOSYS || error == EPERM || error == EINVAL;
+}
+
+// Waits for every request the kernel has picked up, so none of them writes
+// into the statx buffers after they are freed. Returns false when waiting
+// failed and requests may still be in flight.
+bool DrainStatRing(IoRing& ring, unsigned batch, unsigned completed) {
+  while (completed + ring.Unconsumed() < batch) {
+    if (ring.Wait(1) != 0) return false;
+    completed += ring.Reap([](const io_uring_cqe&) {});
+  }
+  return true;
+}
+
+// Stats the paths in windows of the ring size on a ring set up for this
+// batch. A poll round runs every few hundred milliseconds at most, so keeping
+// a ring around would only pin locked memory between rounds. Returns 0, or
+// the errno that stopped the batch; stats is incomplete then. EINVAL means
+// the kernel rejected the opcode.
+int RunStatRing(IoRing& ring,
+                const char* const* paths,
+                size_t count,
+                int statx_flags,
+                VtFileStat* stats) {
+  const unsigned slots = ring.entries();
+  std::unique_ptr<struct statx[]> buffers(new struct statx[slots]);
+  for (size_t next = 0; next < count;) {
+    unsigned batch = 0;
+    while (next + batch < count && batch < slots) {
+      io_uring_sqe* sqe = ring.NextSqe();
+      if (sqe == nullptr) break;
+      sqe->opcode = IORING_OP_STATX;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = reinterpret_cast<uint64_t>(paths[next + batch]);
+      sqe->len = kStatxMask;
+      sqe->off = reinterpret_cast<uint64_t>(&buffers[batch]);
+      sqe->statx_flags = static_cast<uint32_t>(statx_flags);
+      sqe->user_data = batch;
+      ++batch;
+    }
+
+    unsigned completed = 0;
+    bool unsupported = false;
+    while (completed < batch) {
+      const int result = ring.Submit(1);
+      if (result != 0) {
+        // Part of the window may already be running in the kernel.
+        if (!DrainStatRing(ring, batch, completed)) {
+          // Same as the copy engine: leave the buffers to the kernel rather
+          // than free memory it may still write to.
+          buffers.release();
+        }
+        return -result;
+      }
+      completed += ring.Reap([&](const io_uring_cqe& cqe) {
+        const size_t slot = static_cast<size_t>(cqe.user_data);
+        if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+          unsupported = true;
+        } else if (cqe.res < 0) {
+          FailStat(-cqe.res, &stats[next + slot]);
+        } else {
+          FillFromStatx(buffers[slot], &stats[next + slot]);
+        }
+      });
+    }
+    if (unsupported) return EINVAL;
+    next += batch;
+  }
+  return 0;
+}
+
+// Returns false when the batch has to be redone sequentially.
+bool StatBatchOnRing(const char* const* paths,
+                     size_t count,
+                     int32_t flags,
+                     VtFileStat* stats) {
+  if (count < kMinRingBatch ||
+      g_ring_unavailable.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  IoRing ring;
+  int error = ring.Open(
+      static_cast<unsigned>(std::min<size_t>(count, kMaxRingEntries)));
+  if (error == 0) {
+    error = RunStatRing(ring, paths, count, StatxFlags(flags), stats);
+  }
+  if (error != 0) {
+    if (IsPermanentRingError(error)) {
+      g_ring_unavailable.store(true, std::memory_order_relaxed);
+    }
+    return false;
+  }
+  return true;
+}
+
+#endif  // VT_HAVE_STAT_RING
+
+#if defined(__linux__)
+
+// f_type values from linux/magic.h and the filesystems' own headers.
+constexpr uint32_t kNetworkMagics[] = {
+    0x6969,      // NFS
+    0x517B,      // SMB
+    0xFF534D42,  // CIFS
+    0xFE534D42,  // SMB2 (smb3 mounts)
+    0x5346414F,  // AFS
+    0x6B414653,  // kAFS
+    0x73757245,  // Coda
+    0x01021997,  // 9p (WSL, virtio shared folders)
+    0x00C36400,  // Ceph
+    0x01161970,  // GFS2
+    0x786F4256,  // VirtualBox shared folders
+};
+constexpr uint32_t kFuseMagic = 0x65735546;
+
+#elif defined(__APPLE__)
+
+bool HasPrefix(const char* value, const char* prefix) {
+  return std::strncmp(value, prefix, std::strlen(prefix)) == 0;
+}
+
+#endif
+
+}  // namespace
+
+void StatBatch(const char* const* paths,
+               size_t count,
+               int32_t flags,
+               VtFileStat* stats) {
+#if defined(VT_HAVE_STAT_RING)
+  if ((flags & VT_STAT_SEQUENTIAL) == 0 &&
+      StatBatchOnRing(paths, count, flags, stats)) {
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; ++i) {
+    StatOne(paths[i], flags, &stats[i]);
+  }
+}
+
+int32_t FilesystemKind(const char* path) {
+#if defined(_WIN32)
+  const std::wstring wide = Utf8ToWide(path);
+  wchar_t volume[MAX_PATH];
+  if (!GetVolumePathNameW(wide.c_str(), volume, MAX_PATH)) {
+    return VT_FS_LOCAL;
+  }
+  return GetDriveTypeW(volume) == DRIVE_REMOTE ? VT_FS_NETWORK : VT_FS_LOCAL;
+#elif defined(__linux__)
+  struct statfs info;
+  if (statfs(path, &info) != 0) return VT_FS_LOCAL;
+  const uint32_t magic = static_cast<uint32_t>(info.f_type);
+  if (magic == kFuseMagic) return VT_FS_FUSE;
+  for (const uint32_t network : kNetworkMagics) {
+    if (magic == network) return VT_FS_NETWORK;
+  }
+  return VT_FS_LOCAL;
+#elif defined(__APPLE__)
+  struct statfs info;
+  if (statfs(path, &info) != 0) return VT_FS_LOCAL;
+  if (HasPrefix(info.f_fstypename, "osxfuse") ||
+      HasPrefix(info.f_fstypename, "macfuse") ||
+      HasPrefix(info.f_fstypename, "fuse")) {
+    return VT_FS_FUSE;
+  }
+  return (info.f_flags & MNT_LOCAL) != 0 ? VT_FS_LOCAL : VT_FS_NETWORK;
+#else
+  (void)path;
+  return VT_FS_LOCAL;
+#endif
+}
+
+}  // namespace vertree
@@ -0,0 +1,30 @@
+#ifndef VERTREE_NATIVE_STAT_BATCH_H_
+#define VERTREE_NATIVE_STAT_BATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vertree_native.h"
+
+namespace vertree {
+
+// Polling support for monitored files on filesystems that do not deliver
+// change notifications for remote writes.
+//
+// A poll round stats every due file once. On a network mount each stat is
+// a round trip to the server, so issuing them one by one makes a round take
+// count * RTT. On Linux the batch is submitted as IORING_OP_STATX requests
+// on a short-lived io_uring; the kernel runs them on its worker pool and the
+// round takes roughly one RTT per ring's worth of files. Kernels or sandboxes
+// without io_uring fall back to sequential statx.
+void StatBatch(const char* const* paths,
+               size_t count,
+               int32_t flags,
+               VtFileStat* stats);
+
+// One of VT_FS_LOCAL, VT_FS_NETWORK or VT_FS_FUSE.
+int32_t FilesystemKind(const char* path);
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_STAT_BATCH_H_
@@ -0,0 +1,126 @@
+#include "xxh64.h"
+
+#include <cstring>
+
+#include "hash.h"
+
+namespace vertree {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9e3779b185ebca87ULL;
+constexpr uint64_t kPrime2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr uint64_t kPrime3 = 0x165667b19e3779f9ULL;
+constexpr uint64_t kPrime4 = 0x85ebca77c2b2ae63ULL;
+constexpr uint64_t kPrime5 = 0x27d4eb2f165667c5ULL;
+
+// Little-endian loads; every platform the runners target is little-endian.
+inline uint64_t Load64(const unsigned char* data) {
+  uint64_t value;
+  std::memcpy(&value, data, 8);
+  return value;
+}
+
+inline uint32_t Load32(const unsigned char* data) {
+  uint32_t value;
+  std::memcpy(&value, data, 4);
+  return value;
+}
+
+inline uint64_t Round(uint64_t lane, uint64_t input) {
+  lane += input * kPrime2;
+  lane = RotateLeft(lane, 31);
+  return lane * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t hash, uint64_t lane) {
+  hash ^= Round(0, lane);
+  return hash * kPrime1 + kPrime4;
+}
+
+inline const unsigned char* Consume(uint64_t lanes[4],
+                                    const unsigned char* data,
+                                    const unsigned char* end) {
+  uint64_t v1 = lanes[0];
+  uint64_t v2 = lanes[1];
+  uint64_t v3 = lanes[2];
+  uint64_t v4 = lanes[3];
+  while (end - data >= 32) {
+    v1 = Round(v1, Load64(data));
+    v2 = Round(v2, Load64(data + 8));
+    v3 = Round(v3, Load64(data + 16));
+    v4 = Round(v4, Load64(data + 24));
+    data += 32;
+  }
+  lanes[0] = v1;
+  lanes[1] = v2;
+  lanes[2] = v3;
+  lanes[3] = v4;
+  return data;
+}
+
+}  // namespace
+
+Xxh64::Xxh64()
+    : lanes_{kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1}, buffer_{} {}
+
+void Xxh64::Update(const void* data, size_t length) {
+  const unsigned char* input = static_cast<const unsigned char*>(data);
+  const unsigned char* const end = input + length;
+  total_length_ += length;
+
+  if (buffered_ + length < 32) {
+    if (length > 0) std::memcpy(buffer_ + buffered_, input, length);
+    buffered_ += length;
+    return;
+  }
+  if (buffered_ > 0) {
+    const size_t fill = 32 - buffered_;
+    std::memcpy(buffer_ + buffered_, input, fill);
+    Consume(lanes_, buffer_, buffer_ + 32);
+    input += fill;
+    buffered_ = 0;
+  }
+  input = Consume(lanes_, input, end);
+  buffered_ = static_cast<size_t>(end - input);
+  if (buffered_ > 0) std::memcpy(buffer_, input, buffered_);
+}
+
+uint64_t Xxh64::Digest() const {
+  uint64_t hash;
+  if (total_length_ >= 32) {
+    hash = RotateLeft(lanes_[0], 1) + RotateLeft(lanes_[1], 7) +
+           RotateLeft(lanes_[2], 12) + RotateLeft(lanes_[3], 18);
+    for (const uint64_t lane : lanes_) hash = MergeRound(hash, lane);
+  } else {
+    hash = kPrime5;
+  }
+  hash += total_length_;
+
+  const unsigned char* data = buffer_;
+  const unsigned char* const end = buffer_ + buffered_;
+  while (end - data >= 8) {
+    hash ^= Round(0, Load64(data));
+    hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+    data += 8;
+  }
+  if (end - data >= 4) {
+    hash ^= Load32(data) * kPrime1;
+    hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+    data += 4;
+  }
+  while (data < end) {
+    hash ^= *data * kPrime5;
+    hash = RotateLeft(hash, 11) * kPrime1;
+    ++data;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+}  // namespace vertree
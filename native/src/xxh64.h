@@ -0,0 +1,29 @@
+#ifndef VERTREE_NATIVE_XXH64_H_
+#define VERTREE_NATIVE_XXH64_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vertree {
+
+// Streaming XXH64 (seed 0). The digest matches the reference implementation
+// and lib/core/Xxh64.dart, so manifests written by either side agree. It is
+// a checksum against corruption, not a defence against tampering.
+class Xxh64 {
+ public:
+  Xxh64();
+
+  void Update(const void* data, size_t length);
+  uint64_t Digest() const;
+  uint64_t total_length() const { return total_length_; }
+
+ private:
+  uint64_t lanes_[4];
+  unsigned char buffer_[32];
+  size_t buffered_ = 0;
+  uint64_t total_length_ = 0;
+};
+
+}  // namespace vertree
+
+#endif  // VERTREE_NATIVE_XXH64_H_
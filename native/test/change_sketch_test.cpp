@@ -0,0 +1,178 @@
+// Tests for the change sketch through its exported C interface.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "vertree_native.h"
+
+namespace {
+
+int g_failures = 0;
+
+#define EXPECT_TRUE(condition)                                        \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, \
+                   #condition);                                       \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) EXPECT_TRUE((expected) == (actual))
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/vertree_sketch_" + name;
+}
+
+std::string WriteFile(const std::string& name, const std::string& content) {
+  const std::string path = TempPath(name);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return path;
+}
+
+std::string RandomBytes(size_t length, uint64_t seed) {
+  std::mt19937_64 random(seed);
+  std::string bytes(length, '\0');
+  for (char& byte : bytes) byte = static_cast<char>(random());
+  return bytes;
+}
+
+VtSketch Sketch(const std::string& content,
+                const VtSketchOptions* options = nullptr) {
+  const std::string path = WriteFile("file.bin", content);
+  VtSketch sketch;
+  EXPECT_EQ(VT_OK, vt_sketch_file(path.c_str(), options, &sketch));
+  std::remove(path.c_str());
+  return sketch;
+}
+
+// Same estimator as ChangeSketch.estimateChange in lib/service: the share of
+// the union's smallest hashes present in both sketches estimates the Jaccard
+// similarity J, and replacing a fraction f of the chunks gives
+// J = (1 - f) / (1 + f).
+double EstimateChange(const VtSketch& a, const VtSketch& b) {
+  if (a.hash_count == 0 || b.hash_count == 0) {
+    return a.hash_count == b.hash_count ? 0.0 : 1.0;
+  }
+  const int32_t k = std::min(a.hash_count, b.hash_count);
+  int32_t i = 0;
+  int32_t j = 0;
+  int32_t shared = 0;
+  for (int32_t taken = 0; taken < k; ++taken) {
+    if (j == b.hash_count || (i < a.hash_count && a.hashes[i] < b.hashes[j])) {
+      ++i;
+    } else if (i == a.hash_count || b.hashes[j] < a.hashes[i]) {
+      ++j;
+    } else {
+      ++shared;
+      ++i;
+      ++j;
+    }
+  }
+  const double similarity = static_cast<double>(shared) / k;
+  return (1 - similarity) / (1 + similarity);
+}
+
+void TestSketchShape() {
+  const VtSketch empty = Sketch("");
+  EXPECT_EQ(0, empty.file_size);
+  EXPECT_EQ(0, empty.hash_count);
+  EXPECT_EQ(0, empty.chunk_count);
+
+  const VtSketch tiny = Sketch("hello");
+  EXPECT_EQ(1, tiny.chunk_count);
+  EXPECT_EQ(1, tiny.hash_count);
+  EXPECT_TRUE(tiny.hashes[0] < (uint64_t{1} << 63));
+
+  const std::string content = RandomBytes(4 << 20, 1);
+  const VtSketch sketch = Sketch(content);
+  EXPECT_EQ(static_cast<int64_t>(content.size()), sketch.file_size);
+  EXPECT_EQ(sketch.file_size, sketch.scanned_bytes);
+  EXPECT_EQ(128, sketch.hash_count);
+  // 8 KiB average chunks, with some slack for the size distribution.
+  EXPECT_TRUE(sketch.chunk_count > 300 && sketch.chunk_count < 800);
+  EXPECT_TRUE(std::is_sorted(sketch.hashes, sketch.hashes + 128));
+  EXPECT_TRUE(std::adjacent_find(sketch.hashes, sketch.hashes + 128) ==
+              sketch.hashes + 128);
+}
+
+void TestChangeEstimates() {
+  const std::string original = RandomBytes(8 << 20, 2);
+  const VtSketch base = Sketch(original);
+
+  EXPECT_EQ(0.0, EstimateChange(base, Sketch(original)));
+
+  // Content-defined boundaries resynchronize after an insertion.
+  const VtSketch shifted = Sketch(RandomBytes(100, 3) + original);
+  EXPECT_TRUE(EstimateChange(base, shifted) < 0.05);
+
+  std::string edited = original;
+  const std::string block = RandomBytes(edited.size() / 10, 4);
+  edited.replace(edited.size() / 2, block.size(), block);
+  const double estimate = EstimateChange(base, Sketch(edited));
+  EXPECT_TRUE(estimate > 0.04 && estimate < 0.2);
+
+  EXPECT_TRUE(EstimateChange(base, Sketch(RandomBytes(8 << 20, 5))) > 0.9);
+  EXPECT_EQ(1.0, EstimateChange(base, Sketch("")));
+}
+
+void TestStripedSampling() {
+  VtSketchOptions options;
+  vt_sketch_default_options(&options);
+  options.full_scan_bytes = 1 << 20;
+  options.stripe_bytes = 256 << 10;
+  options.stripe_interval = 4;
+
+  const std::string original = RandomBytes(9 << 20, 6);
+  const VtSketch base = Sketch(original, &options);
+  EXPECT_EQ(int64_t{3} << 20, base.scanned_bytes);
+
+  // Shifts well below the stripe size keep most striped chunks aligned.
+  const VtSketch shifted = Sketch(RandomBytes(1000, 7) + original, &options);
+  EXPECT_TRUE(EstimateChange(base, shifted) < 0.1);
+
+  std::string tail_edit = original;
+  tail_edit.replace(tail_edit.size() - (4 << 20), 4 << 20,
+                    RandomBytes(4 << 20, 8));
+  EXPECT_TRUE(EstimateChange(base, Sketch(tail_edit, &options)) > 0.2);
+}
+
+void TestErrors() {
+  VtSketch sketch;
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT, vt_sketch_file(nullptr, nullptr,
+                                                      &sketch));
+  EXPECT_EQ(VT_ERROR_IO,
+            vt_sketch_file(TempPath("missing").c_str(), nullptr, &sketch));
+
+  const std::string path = WriteFile("options.bin", "content");
+  VtSketchOptions options;
+  vt_sketch_default_options(&options);
+  options.sketch_size = VT_SKETCH_CAPACITY + 1;
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_sketch_file(path.c_str(), &options, &sketch));
+  vt_sketch_default_options(&options);
+  options.average_chunk_bytes = 16;
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_sketch_file(path.c_str(), &options, &sketch));
+  std::remove(path.c_str());
+}
+
+}  // namespace
+
+int main() {
+  TestSketchShape();
+  TestChangeEstimates();
+  TestStripedSampling();
+  TestErrors();
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("change_sketch_test passed\n");
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Tests for whole-file checksums and the hashing copy through the exported C
+// interface. Expected digests come from the XXH64 reference implementation.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <sys/stat.h>
+
+#include "vertree_native.h"
+
+namespace {
+
+int g_failures = 0;
+
+#define EXPECT_TRUE(condition)                                        \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, \
+                   #condition);                                       \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) EXPECT_TRUE((expected) == (actual))
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/vertree_checksum_" +
+         name;
+}
+
+std::string WriteFile(const std::string& name, const std::string& content) {
+  const std::string path = TempPath(name);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return path;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+// Same generator as the Dart tests in test/core/xxh64_test.dart.
+std::string Pattern(size_t length) {
+  std::string bytes(length, '\0');
+  for (uint64_t i = 0; i < length; ++i) {
+    bytes[i] = static_cast<char>(((i * i * 31 + i * 7) >> 3) & 0xff);
+  }
+  return bytes;
+}
+
+VtChecksum Checksum(const std::string& content, int32_t flags = 0) {
+  const std::string path = WriteFile("file.bin", content);
+  VtChecksum checksum{0, -1};
+  EXPECT_EQ(VT_OK, vt_checksum_file(path.c_str(), flags, &checksum));
+  std::remove(path.c_str());
+  return checksum;
+}
+
+void TestReferenceDigests() {
+  EXPECT_EQ(0xef46db3751d8e999ULL, Checksum("").hash);
+  EXPECT_EQ(0xd24ec4f1a98c6e5bULL, Checksum("a").hash);
+  EXPECT_EQ(0x44bc2cf5ad770999ULL, Checksum("abc").hash);
+  // Lengths around the 32-byte stripe, and one spanning several buffers.
+  EXPECT_EQ(0xb5429a83e33c39a3ULL, Checksum(Pattern(31)).hash);
+  EXPECT_EQ(0xe724bf51de2dd891ULL, Checksum(Pattern(32)).hash);
+  EXPECT_EQ(0x5cbcdb6956716fa7ULL, Checksum(Pattern(33)).hash);
+  EXPECT_EQ(0x61eebf0a5ab1f0b9ULL, Checksum(Pattern(100)).hash);
+  const VtChecksum large =
+      Checksum(Pattern(1048576 + 37),
+               VT_CHECKSUM_LOW_PRIORITY | VT_CHECKSUM_DROP_CACHE);
+  EXPECT_EQ(0x2f9200bcf036fcbdULL, large.hash);
+  EXPECT_EQ(1048576 + 37, large.size);
+}
+
+void TestCopy() {
+  const std::string content = Pattern(3 * 1048576 + 5);
+  const std::string source = WriteFile("source.bin", content);
+  chmod(source.c_str(), 0640);
+  const std::string target = TempPath("target.bin");
+  WriteFile("target.bin", "stale content that is longer than nothing");
+
+  VtChecksum copied{0, -1};
+  EXPECT_EQ(VT_OK, vt_copy_file(source.c_str(), target.c_str(), &copied));
+  EXPECT_TRUE(ReadFile(target) == content);
+  EXPECT_EQ(Checksum(content).hash, copied.hash);
+  EXPECT_EQ(static_cast<int64_t>(content.size()), copied.size);
+  struct stat info;
+  EXPECT_EQ(0, stat(target.c_str(), &info));
+  EXPECT_EQ(0640u, static_cast<unsigned>(info.st_mode & 0777));
+
+  std::remove(source.c_str());
+  std::remove(target.c_str());
+}
+
+void TestErrors() {
+  VtChecksum checksum;
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_checksum_file(nullptr, 0, &checksum));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_copy_file("a", nullptr, &checksum));
+  EXPECT_EQ(VT_ERROR_IO,
+            vt_checksum_file(TempPath("missing").c_str(), 0, &checksum));
+  EXPECT_EQ(VT_ERROR_IO, vt_checksum_file(TempPath("").c_str(), 0,
+                                          &checksum));
+
+  const std::string source = WriteFile("source.bin", "content");
+  const std::string target = TempPath("no_such_dir/target.bin");
+  EXPECT_EQ(VT_ERROR_IO,
+            vt_copy_file(source.c_str(), target.c_str(), &checksum));
+  EXPECT_EQ(VT_ERROR_IO, vt_copy_file(TempPath("missing").c_str(),
+                                      TempPath("copy").c_str(), &checksum));
+  std::ifstream absent(TempPath("copy"));
+  EXPECT_TRUE(!absent.good());
+  std::remove(source.c_str());
+}
+
+}  // namespace
+
+int main() {
+  TestReferenceDigests();
+  TestCopy();
+  TestErrors();
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("checksum_test passed\n");
+  return 0;
+}
@@ -0,0 +1,184 @@
+// Tests for the bulk copy engine through the exported C interface. Every
+// batch result must match what vt_copy_file produces for the same file; the
+// io_uring path, the thread pool and tiny buffers are all compared.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vertree_native.h"
+
+namespace {
+
+int g_failures = 0;
+
+#define EXPECT_TRUE(condition)                                        \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, \
+                   #condition);                                       \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) EXPECT_TRUE((expected) == (actual))
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/vertree_copy_" + name;
+}
+
+std::string WriteFile(const std::string& name, const std::string& content) {
+  const std::string path = TempPath(name);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return path;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+bool Exists(const std::string& path) {
+  struct stat info;
+  return stat(path.c_str(), &info) == 0;
+}
+
+std::string Pattern(size_t length, uint64_t seed) {
+  std::string bytes(length, '\0');
+  for (uint64_t i = 0; i < length; ++i) {
+    bytes[i] = static_cast<char>(((i * i * 31 + i * 7 + seed) >> 3) & 0xff);
+  }
+  return bytes;
+}
+
+// Sizes around the default 128 KB chunk and the 4 KB one used below.
+size_t SizeFor(size_t index) {
+  static const size_t kSizes[] = {0,          1,          4095,
+                                  4096,       4097,       131071,
+                                  131072,     131073,     3 * 131072 + 5,
+                                  1048576 + 37};
+  return kSizes[index % (sizeof(kSizes) / sizeof(kSizes[0]))] + index / 10;
+}
+
+void CheckBatch(int32_t queue_depth, int32_t buffer_bytes, int32_t flags) {
+  constexpr size_t kFiles = 120;
+  std::vector<std::string> contents;
+  std::vector<std::string> sources;
+  std::vector<std::string> targets;
+  for (size_t i = 0; i < kFiles; ++i) {
+    contents.push_back(Pattern(SizeFor(i), i));
+    sources.push_back(WriteFile("source_" + std::to_string(i),
+                                contents.back()));
+    chmod(sources.back().c_str(), i % 2 == 0 ? 0640 : 0755);
+    targets.push_back(TempPath("target_" + std::to_string(i)));
+  }
+  // A stale, longer target must be truncated.
+  WriteFile("target_1", std::string(4096, 'x'));
+
+  std::vector<VtCopyJob> jobs;
+  for (size_t i = 0; i < kFiles; ++i) {
+    jobs.push_back({sources[i].c_str(), targets[i].c_str()});
+  }
+  VtCopyOptions options;
+  vt_copy_default_options(&options);
+  options.queue_depth = queue_depth;
+  options.buffer_bytes = buffer_bytes;
+  options.flags = flags;
+  std::vector<VtCopyResult> results(kFiles);
+  EXPECT_EQ(VT_OK, vt_copy_batch(jobs.data(), static_cast<int32_t>(kFiles),
+                                 &options, results.data()));
+
+  for (size_t i = 0; i < kFiles; ++i) {
+    EXPECT_EQ(VT_OK, results[i].status);
+    EXPECT_TRUE(ReadFile(targets[i]) == contents[i]);
+    VtChecksum expected{0, -1};
+    EXPECT_EQ(VT_OK, vt_checksum_file(sources[i].c_str(), 0, &expected));
+    EXPECT_EQ(expected.hash, results[i].checksum.hash);
+    EXPECT_EQ(static_cast<int64_t>(contents[i].size()),
+              results[i].checksum.size);
+    struct stat info;
+    EXPECT_EQ(0, stat(targets[i].c_str(), &info));
+    EXPECT_EQ(i % 2 == 0 ? 0640u : 0755u,
+              static_cast<unsigned>(info.st_mode & 0777));
+    std::remove(sources[i].c_str());
+    std::remove(targets[i].c_str());
+  }
+}
+
+void TestFailuresStayPerJob() {
+  const std::string source = WriteFile("ok_source", Pattern(70000, 3));
+  const std::string target = TempPath("ok_target");
+  const std::string missing = TempPath("missing_source");
+  const std::string orphan = TempPath("missing_target");
+  const std::string unreachable = TempPath("no_such_dir/target");
+  std::vector<VtCopyJob> jobs = {
+      {missing.c_str(), orphan.c_str()},
+      {source.c_str(), unreachable.c_str()},
+      {source.c_str(), target.c_str()},
+      {nullptr, orphan.c_str()},
+  };
+  // Directories are not regular files and fail like vt_copy_file does.
+  const std::string directory = TempPath("dir");
+  mkdir(directory.c_str(), 0755);
+  jobs[3].source_path = directory.c_str();
+
+  for (const int32_t flags : {0, VT_COPY_NO_RING}) {
+    VtCopyOptions options;
+    vt_copy_default_options(&options);
+    options.flags = flags;
+    std::vector<VtCopyResult> results(jobs.size());
+    EXPECT_EQ(VT_OK, vt_copy_batch(jobs.data(),
+                                   static_cast<int32_t>(jobs.size()),
+                                   &options, results.data()));
+    EXPECT_EQ(VT_ERROR_IO, results[0].status);
+    EXPECT_EQ(VT_ERROR_IO, results[1].status);
+    EXPECT_EQ(VT_OK, results[2].status);
+    EXPECT_EQ(VT_ERROR_IO, results[3].status);
+    EXPECT_TRUE(!Exists(orphan));
+    EXPECT_TRUE(ReadFile(target) == ReadFile(source));
+    std::remove(target.c_str());
+  }
+  rmdir(directory.c_str());
+  std::remove(source.c_str());
+}
+
+void TestArguments() {
+  VtCopyResult result;
+  VtCopyJob job = {nullptr, "target"};
+  EXPECT_EQ(VT_OK, vt_copy_batch(nullptr, 0, nullptr, nullptr));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_copy_batch(nullptr, 1, nullptr, &result));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_copy_batch(&job, 1, nullptr, &result));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_copy_batch(&job, -1, nullptr, &result));
+}
+
+}  // namespace
+
+int main() {
+  CheckBatch(32, 128 * 1024, 0);
+  // Out-of-range options are clamped: one request in flight, 4 KB chunks.
+  CheckBatch(0, 1, 0);
+  CheckBatch(3, 4096, 0);
+  CheckBatch(32, 128 * 1024, VT_COPY_NO_RING);
+  // Short reads in the middle of a file must not end the copy early.
+  CheckBatch(32, 128 * 1024, VT_COPY_SHORT_READS);
+  CheckBatch(3, 4096, VT_COPY_SHORT_READS);
+  TestFailuresStayPerJob();
+  TestArguments();
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("copy_batch_test passed\n");
+  return 0;
+}
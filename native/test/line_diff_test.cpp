@@ -0,0 +1,204 @@
+// Tests for the line diff through its exported C interface.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vertree_native.h"
+
+namespace {
+
+int g_failures = 0;
+
+#define EXPECT_TRUE(condition)                                        \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, \
+                   #condition);                                       \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) EXPECT_TRUE((expected) == (actual))
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/vertree_diff_" + name;
+}
+
+std::string WriteFile(const std::string& name, const std::string& content) {
+  const std::string path = TempPath(name);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return path;
+}
+
+std::string Unified(const std::string& old_text,
+                    const std::string& new_text,
+                    int32_t context = 3) {
+  const std::string old_path = WriteFile("old.txt", old_text);
+  const std::string new_path = WriteFile("new.txt", new_text);
+  VtDiffOptions options;
+  vt_diff_default_options(&options);
+  options.context_lines = context;
+  VtDiff* diff = nullptr;
+  EXPECT_EQ(VT_OK, vt_diff_open(old_path.c_str(), new_path.c_str(), &options,
+                                &diff));
+  std::string result;
+  char buffer[7];  // Deliberately tiny to exercise partial writes.
+  for (int64_t read; (read = vt_diff_read_unified(diff, buffer, 7)) > 0;) {
+    result.append(buffer, static_cast<size_t>(read));
+  }
+  vt_diff_close(diff);
+  return result;
+}
+
+std::vector<std::string> SplitLines(const std::string& text) {
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start < text.size()) {
+    const size_t newline = text.find('\n', start);
+    if (newline == std::string::npos) {
+      lines.push_back(text.substr(start));
+      break;
+    }
+    lines.push_back(text.substr(start, newline - start + 1));
+    start = newline + 1;
+  }
+  return lines;
+}
+
+// Rebuilds the new file from the old one and the structured hunks.
+std::string Apply(const std::string& old_text, VtDiff* diff) {
+  const std::vector<std::string> old_lines = SplitLines(old_text);
+  std::string result;
+  int64_t copied = 0;
+  VtDiffHunk hunk;
+  while (vt_diff_next_hunk(diff, &hunk)) {
+    for (; copied < hunk.old_start; ++copied) result += old_lines[copied];
+    VtDiffLine line;
+    while (vt_diff_next_line(diff, &line)) {
+      if (line.kind == VT_DIFF_LINE_REMOVED) {
+        EXPECT_EQ(copied, line.old_line);
+        ++copied;
+        continue;
+      }
+      if (line.kind == VT_DIFF_LINE_CONTEXT) {
+        EXPECT_EQ(copied, line.old_line);
+        ++copied;
+      }
+      result.append(line.text, static_cast<size_t>(line.length));
+      if (!line.missing_newline) result += '\n';
+    }
+  }
+  for (; copied < static_cast<int64_t>(old_lines.size()); ++copied) {
+    result += old_lines[copied];
+  }
+  return result;
+}
+
+void TestUnifiedOutput() {
+  EXPECT_EQ(std::string(), Unified("a\nb\n", "a\nb\n"));
+  EXPECT_EQ(std::string("@@ -1,3 +1,3 @@\n a\n-b\n+B\n c\n"),
+            Unified("a\nb\nc\n", "a\nB\nc\n"));
+  EXPECT_EQ(std::string("@@ -0,0 +1 @@\n+x\n"), Unified("", "x\n"));
+  EXPECT_EQ(std::string("@@ -1 +1 @@\n-x\n\\ No newline at end of file\n"
+                        "+x\n"),
+            Unified("x", "x\n"));
+  // Changes further apart than twice the context become separate hunks.
+  EXPECT_EQ(std::string("@@ -1,2 +1,2 @@\n-1\n+one\n 2\n"
+                        "@@ -5,2 +5,2 @@\n 5\n-6\n+six\n"),
+            Unified("1\n2\n3\n4\n5\n6\n", "one\n2\n3\n4\n5\nsix\n", 1));
+}
+
+void TestRandomEditsRoundTrip() {
+  std::mt19937 random(42);
+  for (int round = 0; round < 200; ++round) {
+    // A small alphabet makes repeated lines common, which exercises the
+    // fallback from histogram anchors to the Myers split.
+    const int alphabet = round % 2 == 0 ? 4 : 200;
+    std::string old_text;
+    const int old_count = static_cast<int>(random() % 300);
+    for (int i = 0; i < old_count; ++i) {
+      old_text += "line " + std::to_string(random() % alphabet) + "\n";
+    }
+    std::string new_text;
+    for (const std::string& line : SplitLines(old_text)) {
+      const unsigned roll = random() % 10;
+      if (roll == 0) continue;
+      if (roll == 1) new_text += "inserted " + std::to_string(random()) + "\n";
+      new_text += line;
+    }
+    if (round % 3 == 0) new_text += "tail without newline";
+
+    const std::string old_path = WriteFile("old.txt", old_text);
+    const std::string new_path = WriteFile("new.txt", new_text);
+    VtDiffOptions options;
+    vt_diff_default_options(&options);
+    options.max_edit_cost = round % 4 == 0 ? 2 : 2048;
+    VtDiff* diff = nullptr;
+    EXPECT_EQ(VT_OK, vt_diff_open(old_path.c_str(), new_path.c_str(),
+                                  &options, &diff));
+    if (diff == nullptr) continue;
+    EXPECT_EQ(new_text, Apply(old_text, diff));
+    vt_diff_close(diff);
+  }
+}
+
+void TestStats() {
+  const std::string old_path = WriteFile("old.txt", "a\nb\nc\nd\n");
+  const std::string new_path = WriteFile("new.txt", "a\nc\nd\ne\nf\n");
+  VtDiff* diff = nullptr;
+  EXPECT_EQ(VT_OK,
+            vt_diff_open(old_path.c_str(), new_path.c_str(), nullptr, &diff));
+  VtDiffStats stats;
+  vt_diff_stats(diff, &stats);
+  EXPECT_EQ(4, stats.old_lines);
+  EXPECT_EQ(5, stats.new_lines);
+  EXPECT_EQ(1, stats.removed_lines);
+  EXPECT_EQ(2, stats.added_lines);
+  EXPECT_EQ(1, stats.hunk_count);
+  vt_diff_close(diff);
+}
+
+void TestErrors() {
+  const std::string text_path = WriteFile("text.txt", "a\n");
+  const std::string binary_path =
+      WriteFile("binary.bin", std::string("PK\0\0data", 8));
+  VtDiff* diff = nullptr;
+  EXPECT_EQ(VT_ERROR_BINARY, vt_diff_open(text_path.c_str(),
+                                          binary_path.c_str(), nullptr, &diff));
+  EXPECT_TRUE(diff == nullptr);
+  EXPECT_EQ(VT_ERROR_IO,
+            vt_diff_open(TempPath("missing").c_str(), text_path.c_str(),
+                         nullptr, &diff));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT,
+            vt_diff_open(nullptr, text_path.c_str(), nullptr, &diff));
+
+  std::string large;
+  for (int i = 0; i < 10000; ++i) large += std::to_string(i) + "\n";
+  const std::string large_path = WriteFile("large.txt", large);
+  VtDiffOptions options;
+  vt_diff_default_options(&options);
+  options.max_index_bytes = 64 * 1024;
+  EXPECT_EQ(VT_ERROR_TOO_LARGE, vt_diff_open(text_path.c_str(),
+                                             large_path.c_str(), &options,
+                                             &diff));
+}
+
+}  // namespace
+
+int main() {
+  TestUnifiedOutput();
+  TestRandomEditsRoundTrip();
+  TestStats();
+  TestErrors();
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("line_diff_test passed\n");
+  return 0;
+}
@@ -0,0 +1,142 @@
+// Tests for the batched stat used by the polling watcher. The io_uring path
+// is compared against the sequential one; where the kernel or sandbox has no
+// io_uring both calls take the sequential path and the test still holds.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "vertree_native.h"
+
+namespace {
+
+int g_failures = 0;
+
+#define EXPECT_TRUE(condition)                                        \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, \
+                   #condition);                                       \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) EXPECT_TRUE((expected) == (actual))
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/vertree_stat_" + name;
+}
+
+std::string WriteFile(const std::string& name, const std::string& content) {
+  const std::string path = TempPath(name);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return path;
+}
+
+std::vector<VtFileStat> StatAll(const std::vector<std::string>& paths,
+                                int32_t flags) {
+  std::vector<const char*> raw;
+  for (const std::string& path : paths) raw.push_back(path.c_str());
+  std::vector<VtFileStat> stats(paths.size());
+  EXPECT_EQ(VT_OK, vt_stat_batch(raw.data(), static_cast<int32_t>(raw.size()),
+                                 flags, stats.data()));
+  return stats;
+}
+
+bool SameStat(const VtFileStat& a, const VtFileStat& b) {
+  return a.status == b.status && a.size == b.size &&
+         a.modified_ns == b.modified_ns && a.changed_ns == b.changed_ns &&
+         a.file_id == b.file_id;
+}
+
+void TestBatchMatchesSequential() {
+  // More paths than one ring window, with missing files mixed in.
+  std::vector<std::string> paths;
+  for (int i = 0; i < 150; ++i) {
+    if (i % 7 == 3) {
+      paths.push_back(TempPath("missing_" + std::to_string(i)));
+    } else {
+      paths.push_back(WriteFile("file_" + std::to_string(i),
+                                std::string(static_cast<size_t>(i), 'x')));
+    }
+  }
+  paths.push_back(TempPath("file_1/not_a_directory"));
+
+  const std::vector<VtFileStat> batched = StatAll(paths, 0);
+  const std::vector<VtFileStat> sequential =
+      StatAll(paths, VT_STAT_SEQUENTIAL);
+  const std::vector<VtFileStat> forced =
+      StatAll(paths, VT_STAT_FORCE_SYNC);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    EXPECT_TRUE(SameStat(sequential[i], batched[i]));
+    EXPECT_TRUE(SameStat(sequential[i], forced[i]));
+  }
+  for (int i = 0; i < 150; ++i) {
+    const VtFileStat& stat = batched[static_cast<size_t>(i)];
+    if (i % 7 == 3) {
+      EXPECT_EQ(VT_ERROR_NOT_FOUND, stat.status);
+      EXPECT_EQ(0, stat.size);
+      continue;
+    }
+    struct stat info;
+    EXPECT_EQ(0, ::stat(paths[static_cast<size_t>(i)].c_str(), &info));
+    EXPECT_EQ(VT_OK, stat.status);
+    EXPECT_EQ(i, stat.size);
+    EXPECT_EQ(static_cast<int64_t>(info.st_mtime),
+              stat.modified_ns / 1000000000);
+    EXPECT_EQ(static_cast<uint64_t>(info.st_ino), stat.file_id);
+  }
+  EXPECT_EQ(VT_ERROR_NOT_FOUND, batched.back().status);
+
+  for (const std::string& path : paths) std::remove(path.c_str());
+}
+
+void TestDetectsChanges() {
+  const std::string path = WriteFile("changing", "one");
+  const std::vector<std::string> paths(8, path);
+  const VtFileStat before = StatAll(paths, 0).front();
+  WriteFile("changing", "three");
+  const std::vector<VtFileStat> after = StatAll(paths, 0);
+  for (const VtFileStat& stat : after) {
+    EXPECT_EQ(5, stat.size);
+    EXPECT_TRUE(stat.modified_ns >= before.modified_ns);
+    EXPECT_EQ(before.file_id, stat.file_id);
+  }
+  std::remove(path.c_str());
+}
+
+void TestArguments() {
+  VtFileStat stat;
+  const char* missing[] = {nullptr};
+  EXPECT_EQ(VT_OK, vt_stat_batch(nullptr, 0, 0, nullptr));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT, vt_stat_batch(nullptr, 1, 0, &stat));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT, vt_stat_batch(missing, 1, 0, &stat));
+  EXPECT_EQ(VT_ERROR_INVALID_ARGUMENT, vt_stat_batch(missing, -1, 0, &stat));
+
+  EXPECT_EQ(VT_FS_LOCAL, vt_filesystem_kind(nullptr));
+  EXPECT_EQ(VT_FS_LOCAL, vt_filesystem_kind(TempPath("missing").c_str()));
+  const std::string probe = WriteFile("probe", "");
+  const int32_t kind = vt_filesystem_kind(probe.c_str());
+  EXPECT_TRUE(kind == VT_FS_LOCAL || kind == VT_FS_NETWORK ||
+              kind == VT_FS_FUSE);
+  std::remove(probe.c_str());
+}
+
+}  // namespace
+
+int main() {
+  TestBatchMatchesSequential();
+  TestDetectsChanges();
+  TestArguments();
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d expectation(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("stat_batch_test passed\n");
+  return 0;
+}
@@ -0,0 +1,75 @@
+import 'package:test/test.dart';
+import 'package:vertree/api/LocalHttpApiContract.dart';
+import 'package:vertree/api/LocalHttpApiRouter.dart';
+
+void main() {
+  group('LocalHttpApiRouter', () {
+    LocalHttpApiRoute route(String method, String pathTemplate) {
+      return LocalHttpApiRoute(
+        method: method,
+        pathTemplate: pathTemplate,
+        summary: '$method $pathTemplate',
+        description: '$method $pathTemplate',
+        tags: const ['test'],
+        handler: (request, pathParameters, startedAt) async {},
+      );
+    }
+
+    final router = LocalHttpApiRouter([
+      route('GET', '/'),
+      route('GET', '/monitor-tasks'),
+      route('POST', '/monitor-tasks'),
+      route('GET', '/monitor-tasks/{id}'),
+      route('DELETE', '/monitor-tasks/{id}'),
+      route('GET', '/monitor-tasks/{id}/backups'),
+      route('GET', '/monitor-tasks/summary'),
+      route('GET', '/file-shares/{token}'),
+    ]);
+
+    test('matches the root and literal routes by method', () {
+      expect(router.match('GET', const [])?.route.pathTemplate, '/');
+      expect(
+        router.match('POST', const ['monitor-tasks'])?.route.method,
+        'POST',
+      );
+      expect(router.match('PUT', const ['monitor-tasks']), isNull);
+    });
+
+    test('extracts path parameters', () {
+      final match = router.match('GET', const ['monitor-tasks', 'abc', 'backups']);
+
+      expect(match?.route.pathTemplate, '/monitor-tasks/{id}/backups');
+      expect(match?.pathParameters, {'id': 'abc'});
+    });
+
+    test('prefers literal segments over parameters', () {
+      expect(
+        router.match('GET', const ['monitor-tasks', 'summary'])?.route.pathTemplate,
+        '/monitor-tasks/summary',
+      );
+      expect(
+        router.match('DELETE', const ['monitor-tasks', 'summary'])?.pathParameters,
+        {'id': 'summary'},
+      );
+    });
+
+    test('reports allowed methods for known paths only', () {
+      expect(
+        router.allowedMethods(const ['monitor-tasks', 'x']),
+        unorderedEquals(['GET', 'DELETE']),
+      );
+      expect(router.allowedMethods(const ['unknown']), isEmpty);
+      expect(router.match('GET', const ['monitor-tasks', 'x', 'y']), isNull);
+    });
+
+    test('rejects duplicate routes', () {
+      expect(
+        () => LocalHttpApiRouter([
+          route('GET', '/health'),
+          route('GET', '/health'),
+        ]),
+        throwsArgumentError,
+      );
+    });
+  });
+}
@@ -0,0 +1,183 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+
+/// 一项基准测试的结果
+class BenchmarkResult {
+  BenchmarkResult({
+    required this.name,
+    required this.unit,
+    required this.value,
+    this.lowerIsBetter = true,
+    this.samples = const [],
+    this.parameters = const {},
+  });
+
+  /// 由多次采样生成，取中位数作为比较值
+  factory BenchmarkResult.fromSamples(
+    String name,
+    String unit,
+    List<double> samples, {
+    bool lowerIsBetter = true,
+    Map<String, dynamic> parameters = const {},
+  }) {
+    return BenchmarkResult(
+      name: name,
+      unit: unit,
+      value: percentile(samples, 0.5),
+      lowerIsBetter: lowerIsBetter,
+      samples: samples,
+      parameters: parameters,
+    );
+  }
+
+  factory BenchmarkResult.fromJson(Map<String, dynamic> json) {
+    return BenchmarkResult(
+      name: json['name'] as String,
+      unit: json['unit'] as String,
+      value: (json['value'] as num).toDouble(),
+      lowerIsBetter: json['lowerIsBetter'] as bool? ?? true,
+      parameters: json['parameters'] as Map<String, dynamic>? ?? const {},
+    );
+  }
+
+  final String name;
+  final String unit;
+  final double value;
+  final bool lowerIsBetter;
+  final List<double> samples;
+  final Map<String, dynamic> parameters;
+
+  Map<String, dynamic> toJson() => {
+    'name': name,
+    'unit': unit,
+    'value': _round(value),
+    'lowerIsBetter': lowerIsBetter,
+    if (samples.isNotEmpty) ...{
+      'sampleCount': samples.length,
+      'min': _round(samples.reduce(min)),
+      'p95': _round(percentile(samples, 0.95)),
+      'max': _round(samples.reduce(max)),
+    },
+    'parameters': parameters,
+  };
+
+  static double _round(double value) =>
+      double.parse(value.toStringAsFixed(3));
+}
+
+/// 当前结果相对基线的变化
+class BenchmarkComparison {
+  BenchmarkComparison(this.current, this.baseline);
+
+  final BenchmarkResult current;
+  final BenchmarkResult baseline;
+
+  /// 变差的比例：0.2 表示比基线差 20%，负数表示变好
+  double get regression {
+    if (baseline.value == 0 || current.value == 0) {
+      return 0;
+    }
+    return current.lowerIsBetter
+        ? current.value / baseline.value - 1
+        : baseline.value / current.value - 1;
+  }
+
+  Map<String, dynamic> toJson() => {
+    'name': current.name,
+    'unit': current.unit,
+    'baseline': baseline.value,
+    'current': current.value,
+    'regression': double.parse(regression.toStringAsFixed(4)),
+  };
+}
+
+/// 收集一次运行的全部结果，写成 JSON 并与基线比较。
+///
+/// JSON 格式：`{suite, generatedAt, environment, results: [...]}`，
+/// 可以直接把某次的输出作为之后运行的基线。
+class BenchmarkReport {
+  BenchmarkReport(this.suite, {Map<String, dynamic> environment = const {}})
+    : environment = {
+        'os': Platform.operatingSystem,
+        'osVersion': Platform.operatingSystemVersion,
+        'processors': Platform.numberOfProcessors,
+        'dartVersion': Platform.version.split(' ').first,
+        ...environment,
+      };
+
+  factory BenchmarkReport.fromJson(Map<String, dynamic> json) {
+    final report = BenchmarkReport(
+      json['suite'] as String,
+      environment: json['environment'] as Map<String, dynamic>? ?? const {},
+    );
+    for (final item in json['results'] as List<dynamic>) {
+      report.add(BenchmarkResult.fromJson(item as Map<String, dynamic>));
+    }
+    return report;
+  }
+
+  static BenchmarkReport? loadSync(String filePath) {
+    final file = File(filePath);
+    if (!file.existsSync()) {
+      return null;
+    }
+    return BenchmarkReport.fromJson(
+      jsonDecode(file.readAsStringSync()) as Map<String, dynamic>,
+    );
+  }
+
+  final String suite;
+  final Map<String, dynamic> environment;
+  final Map<String, BenchmarkResult> _results = {};
+
+  Iterable<BenchmarkResult> get results => _results.values;
+
+  void add(BenchmarkResult result) {
+    _results[result.name] = result;
+    // ignore: avoid_print
+    print(
+      '${result.name.padRight(40)} '
+      '${result.value.toStringAsFixed(2).padLeft(12)} ${result.unit}',
+    );
+  }
+
+  /// 两边都有的指标的比较结果，按变差程度从大到小排列
+  List<BenchmarkComparison> compareTo(BenchmarkReport baseline) {
+    return [
+      for (final result in results)
+        if (baseline._results[result.name] case final previous?)
+          if (previous.unit == result.unit)
+            BenchmarkComparison(result, previous),
+    ]..sort((a, b) => b.regression.compareTo(a.regression));
+  }
+
+  Map<String, dynamic> toJson({BenchmarkReport? baseline}) => {
+    'suite': suite,
+    'generatedAt': DateTime.now().toIso8601String(),
+    'environment': environment,
+    'results': [for (final result in results) result.toJson()],
+    if (baseline != null)
+      'comparison': [
+        for (final comparison in compareTo(baseline)) comparison.toJson(),
+      ],
+  };
+
+  void writeSync(String filePath, {BenchmarkReport? baseline}) {
+    final file = File(filePath);
+    file.parent.createSync(recursive: true);
+    file.writeAsStringSync(
+      const JsonEncoder.withIndent('  ').convert(toJson(baseline: baseline)),
+    );
+  }
+}
+
+/// [fraction] 分位数（最近秩法）
+double percentile(List<double> samples, double fraction) {
+  if (samples.isEmpty) {
+    return 0;
+  }
+  final sorted = [...samples]..sort();
+  final rank = (fraction * sorted.length).ceil().clamp(1, sorted.length);
+  return sorted[rank - 1];
+}
@@ -0,0 +1,89 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+
+import 'benchmark_report.dart';
+import 'workload.dart';
+
+void main() {
+  group('BenchmarkReport', () {
+    test('compares latency and throughput against a baseline', () async {
+      final tempDir = await Directory.systemTemp.createTemp('vertree_bench_');
+      addTearDown(() => tempDir.delete(recursive: true));
+      final baselinePath = path.join(tempDir.path, 'baseline.json');
+
+      final baseline = BenchmarkReport('core')
+        ..add(BenchmarkResult(name: 'buildTree', unit: 'ms', value: 10))
+        ..add(
+          BenchmarkResult(
+            name: 'download',
+            unit: 'MB/s',
+            value: 400,
+            lowerIsBetter: false,
+          ),
+        )
+        ..add(BenchmarkResult(name: 'removed', unit: 'ms', value: 1));
+      baseline.writeSync(baselinePath);
+
+      final current = BenchmarkReport('core')
+        ..add(
+          BenchmarkResult.fromSamples('buildTree', 'ms', [11, 15, 12, 90, 13]),
+        )
+        ..add(
+          BenchmarkResult(
+            name: 'download',
+            unit: 'MB/s',
+            value: 200,
+            lowerIsBetter: false,
+          ),
+        );
+      final comparisons = current.compareTo(
+        BenchmarkReport.loadSync(baselinePath)!,
+      );
+
+      expect(comparisons.map((comparison) => comparison.current.name), [
+        'download',
+        'buildTree',
+      ]);
+      expect(comparisons.first.regression, closeTo(1.0, 1e-9));
+      expect(comparisons.last.current.value, 13);
+      expect(comparisons.last.regression, closeTo(0.3, 1e-9));
+    });
+
+    test('percentile uses the nearest rank', () {
+      expect(percentile([5, 1, 4, 2, 3], 0.5), 3);
+      expect(percentile([5, 1, 4, 2, 3], 0.95), 5);
+      expect(percentile([], 0.5), 0);
+    });
+  });
+
+  test('generates the requested family shape', () async {
+    final tempDir = await Directory.systemTemp.createTemp('vertree_bench_');
+    addTearDown(() => tempDir.delete(recursive: true));
+    const shape = VersionFamilyShape(
+      depth: 7,
+      branchEvery: 3,
+      branchFanOut: 2,
+      branchDepth: 2,
+      noiseFiles: 4,
+      noiseFamilies: 1,
+      noiseDirectories: 1,
+    );
+
+    final family = generateVersionFamily(tempDir.path, shape);
+
+    expect(family.versionPaths, hasLength(shape.versionCount));
+    expect(shape.versionCount, 7 + 2 * 2 * 2);
+    expect(
+      family.versionPaths.map(path.basename),
+      containsAll(['doc.0.0.txt', 'doc.0.6.txt', 'doc.0.6-2.1.txt']),
+    );
+    expect(path.basename(family.latestPath), 'doc.0.6.txt');
+    expect(family.noisePaths, hasLength(7 + 4 + 3));
+    for (final versionPath in family.versionPaths) {
+      final size = File(versionPath).lengthSync();
+      expect(size, inInclusiveRange(shape.minFileBytes, shape.maxFileBytes));
+    }
+  });
+}
@@ -0,0 +1,474 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:path/path.dart' as path;
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Monitor.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/main.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/FileBatchService.dart';
+import 'package:vertree/service/LanFileShareServer.dart';
+
+import 'benchmark_report.dart';
+import 'workload.dart';
+
+/// 核心操作的基准：建树、safeBackup、监控从写入到快照的延迟、大批快照的复制、
+/// 多选文件的批量备份、保留策略清理、局域网下载吞吐。
+///
+/// 在 Linux 上运行：
+///
+///     flutter test test/benchmark/core_benchmark_test.dart
+///
+/// 环境变量：
+/// - `VERTREE_BENCH_SCALE`：工作量倍数，默认 1
+/// - `VERTREE_BENCH_OUT`：结果 JSON 路径，默认
+///   `build/benchmarks/core_benchmark.json`
+/// - `VERTREE_BENCH_BASELINE`：基线 JSON（以前某次的输出），设置后逐项比较，
+///   任一指标变差超过 `VERTREE_BENCH_TOLERANCE`（默认 0.25）即失败
+void main() {
+  final environment = Platform.environment;
+  final scale = int.tryParse(environment['VERTREE_BENCH_SCALE'] ?? '') ?? 1;
+  final outputPath =
+      environment['VERTREE_BENCH_OUT'] ??
+      path.join('build', 'benchmarks', 'core_benchmark.json');
+  final baselinePath = environment['VERTREE_BENCH_BASELINE'];
+  final tolerance =
+      double.tryParse(environment['VERTREE_BENCH_TOLERANCE'] ?? '') ?? 0.25;
+  final report = BenchmarkReport('core', environment: {'scale': scale});
+  late Directory tempDir;
+
+  setUpAll(() async {
+    TestWidgetsFlutterBinding.ensureInitialized();
+    // 测试绑定默认拦截所有 HTTP 请求，下载基准需要真实的本机连接
+    HttpOverrides.global = null;
+    tempDir = await Directory.systemTemp.createTemp('vertree_bench_');
+    final supportDir = Directory(path.join(tempDir.path, 'support'))
+      ..createSync();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+        .setMockMethodCallHandler(
+          const MethodChannel('plugins.flutter.io/path_provider'),
+          (call) async => supportDir.path,
+        );
+    await configer.init();
+    await logger.init();
+  });
+
+  tearDownAll(() async {
+    final baseline = baselinePath == null
+        ? null
+        : BenchmarkReport.loadSync(baselinePath);
+    report.writeSync(outputPath, baseline: baseline);
+    // ignore: avoid_print
+    print('Benchmark results written to ${File(outputPath).absolute.path}');
+    await tempDir.delete(recursive: true);
+  });
+
+  const shapes = {
+    'linear': VersionFamilyShape(depth: 100, branchEvery: 0, noiseFiles: 20),
+    'branchy': VersionFamilyShape(
+      depth: 60,
+      branchEvery: 3,
+      branchFanOut: 3,
+      branchDepth: 4,
+      minFileBytes: 512,
+      maxFileBytes: 4096,
+      noiseFiles: 200,
+      noiseFamilies: 5,
+    ),
+  };
+
+  for (final MapEntry(key: label, value: baseShape) in shapes.entries) {
+    test('buildTree on a $label family', () async {
+      final shape = VersionFamilyShape(
+        depth: baseShape.depth * scale,
+        branchEvery: baseShape.branchEvery,
+        branchFanOut: baseShape.branchFanOut,
+        branchDepth: baseShape.branchDepth,
+        minFileBytes: baseShape.minFileBytes,
+        maxFileBytes: baseShape.maxFileBytes,
+        noiseFiles: baseShape.noiseFiles * scale,
+        noiseFamilies: baseShape.noiseFamilies,
+      );
+      final family = generateVersionFamily(
+        path.join(tempDir.path, 'tree_$label'),
+        shape,
+      );
+
+      final samples = <double>[];
+      for (var round = 0; round < 15; round++) {
+        final stopwatch = Stopwatch()..start();
+        final root = (await buildTree(family.latestPath)).unwrap();
+        samples.add(stopwatch.elapsedMicroseconds / 1000);
+        expect(_countNodes(root), shape.versionCount);
+      }
+      report.add(
+        BenchmarkResult.fromSamples(
+          'buildTree.$label',
+          'ms',
+          samples,
+          parameters: shape.toJson(),
+        ),
+      );
+    });
+  }
+
+  test('safeBackup along the main line and into branches', () async {
+    final family = generateVersionFamily(
+      path.join(tempDir.path, 'backup'),
+      const VersionFamilyShape(
+        depth: 5,
+        branchEvery: 0,
+        minFileBytes: 256 * 1024,
+        maxFileBytes: 256 * 1024,
+        noiseFiles: 0,
+        noiseFamilies: 0,
+        noiseDirectories: 0,
+      ),
+    );
+    final root = (await buildTree(family.rootPath)).unwrap();
+    var tail = root;
+    while (tail.child != null) {
+      tail = tail.child!;
+    }
+
+    final operations = 20 * scale;
+    final backupSamples = <double>[];
+    final branchSamples = <double>[];
+    for (var round = 0; round < operations; round++) {
+      var stopwatch = Stopwatch()..start();
+      tail = (await tail.safeBackup()).unwrap();
+      backupSamples.add(stopwatch.elapsedMicroseconds / 1000);
+
+      // 根节点已有长子，safeBackup 会改为创建分支
+      stopwatch = Stopwatch()..start();
+      (await root.safeBackup()).unwrap();
+      branchSamples.add(stopwatch.elapsedMicroseconds / 1000);
+    }
+    final parameters = {'fileBytes': 256 * 1024, 'operations': operations};
+    report
+      ..add(
+        BenchmarkResult.fromSamples(
+          'safeBackup.backup',
+          'ms',
+          backupSamples,
+          parameters: parameters,
+        ),
+      )
+      ..add(
+        BenchmarkResult.fromSamples(
+          'safeBackup.branch',
+          'ms',
+          branchSamples,
+          parameters: parameters,
+        ),
+      );
+  });
+
+  test('monitor latency from a write burst to its snapshot', () async {
+    configer.set('monitorRate', 0);
+    configer.set('monitorMaxSize', 1000);
+    final filePath = writeRandomFile(
+      path.join(tempDir.path, 'monitor', 'scene.psd'),
+      64 * 1024,
+    );
+    final snapshots = <DateTime>[];
+    final subscription = activityEventHub.stream
+        .where(
+          (event) =>
+              event.type == ActivityEventType.snapshotFinished &&
+              event.data['filePath'] == filePath &&
+              event.data['success'] == true,
+        )
+        .listen((event) => snapshots.add(event.occurredAt));
+    final monitor = Monitor(filePath)..start();
+    addTearDown(() async {
+      monitor.stop();
+      await subscription.cancel();
+    });
+    // 等待文件监听真正挂上
+    await Future<void>.delayed(const Duration(milliseconds: 200));
+
+    final workload = MonitorWorkload(bursts: 10 * scale);
+    final bursts = await workload.run(filePath);
+    await Future<void>.delayed(const Duration(milliseconds: 200));
+
+    // first：突发中第一次写入开始到第一个快照完成；
+    // last：最后一次写入开始到最后一个快照完成，即最终内容被保存下来的延迟
+    final firstSnapshotSamples = <double>[];
+    final lastSnapshotSamples = <double>[];
+    for (var index = 0; index < bursts.length; index++) {
+      final burst = bursts[index];
+      // 每次突发的快照只算到下一次突发开始之前
+      final end = index + 1 < bursts.length
+          ? bursts[index + 1].startedAt
+          : DateTime.now();
+      final inBurst = snapshots
+          .where((at) => !at.isBefore(burst.startedAt) && at.isBefore(end))
+          .toList();
+      if (inBurst.isEmpty) {
+        continue;
+      }
+      firstSnapshotSamples.add(
+        inBurst.first.difference(burst.startedAt).inMicroseconds / 1000,
+      );
+      if (!inBurst.last.isBefore(burst.lastWriteAt)) {
+        lastSnapshotSamples.add(
+          inBurst.last.difference(burst.lastWriteAt).inMicroseconds / 1000,
+        );
+      }
+    }
+    expect(firstSnapshotSamples, isNotEmpty);
+    report
+      ..add(
+        BenchmarkResult.fromSamples(
+          'monitor.firstSnapshotLatency',
+          'ms',
+          firstSnapshotSamples,
+          parameters: workload.toJson(),
+        ),
+      )
+      ..add(
+        BenchmarkResult.fromSamples(
+          'monitor.lastSnapshotLatency',
+          'ms',
+          lastSnapshotSamples,
+          parameters: workload.toJson(),
+        ),
+      )
+      ..add(
+        BenchmarkResult(
+          name: 'monitor.snapshotsPerBurst',
+          unit: 'count',
+          value: snapshots.length / bursts.length,
+          parameters: workload.toJson(),
+        ),
+      );
+  });
+
+  test('snapshot burst copied one by one and as a batch', () async {
+    // 源码树式的大小分布：多数几 KB，每十个有一个 256 KB，每百个有一个 4 MB
+    final files = 1000 * scale;
+    final burstDir = path.join(tempDir.path, 'burst');
+    final noise = File(
+      writeRandomFile(path.join(burstDir, 'noise.bin'), 4 << 20),
+    ).readAsBytesSync();
+    final sources = <String>[];
+    for (var i = 0; i < files; i++) {
+      final bytes = i % 100 == 0
+          ? 4 << 20
+          : i % 10 == 0
+          ? 256 << 10
+          : 1024 + (i % 16) * 1024;
+      final source = File(path.join(burstDir, 'src', 'file_$i.txt'))
+        ..parent.createSync(recursive: true)
+        ..writeAsBytesSync(Uint8List.sublistView(noise, i % 1024, bytes));
+      sources.add(source.path);
+    }
+    List<(String, String)> pairsFor(int round) => [
+      for (var i = 0; i < files; i++)
+        (sources[i], path.join(burstDir, 'dst_$round', 'file_$i.txt')),
+    ];
+
+    final sequentialSamples = <double>[];
+    final batchSamples = <double>[];
+    for (var round = 0; round < 3; round++) {
+      // 原来的路径：在监控所在的 isolate 中逐个 copySync
+      var pairs = pairsFor(round * 2);
+      Directory(path.dirname(pairs.first.$2)).createSync(recursive: true);
+      var stopwatch = Stopwatch()..start();
+      for (final (source, target) in pairs) {
+        FileChecksum.copySync(source, target);
+      }
+      sequentialSamples.add(stopwatch.elapsedMicroseconds / 1000);
+
+      pairs = pairsFor(round * 2 + 1);
+      Directory(path.dirname(pairs.first.$2)).createSync(recursive: true);
+      stopwatch = Stopwatch()..start();
+      final copied = await FileChecksum.copyAll(pairs);
+      batchSamples.add(stopwatch.elapsedMicroseconds / 1000);
+      expect(copied.every((checksum) => checksum != null), isTrue);
+    }
+    final parameters = {'files': files};
+    report
+      ..add(
+        BenchmarkResult.fromSamples(
+          'snapshotBurst.sequential',
+          'ms',
+          sequentialSamples,
+          parameters: parameters,
+        ),
+      )
+      ..add(
+        BenchmarkResult.fromSamples(
+          'snapshotBurst.batch',
+          'ms',
+          batchSamples,
+          parameters: parameters,
+        ),
+      );
+  });
+
+  test('express backup of a large file selection', () async {
+    // 文件管理器中多选的一批互不相关的文档，各自是一个版本家族
+    final files = 200 * scale;
+    final batchService = FileBatchService(
+      backup: (filePath, label) async {
+        final result = await FileNode(filePath).safeBackup(label);
+        return result.isErr
+            ? Result.eMsg(result.msg)
+            : Result.ok(result.unwrap().mate.fullPath);
+      },
+      monit: (filePath) async => Result.eMsg('not measured'),
+      concurrency: 4,
+    );
+    List<String> selectionFor(int round) => [
+      for (var i = 0; i < files; i++)
+        writeRandomFile(
+          path.join(tempDir.path, 'selection_$round', 'doc_$i.txt'),
+          64 * 1024,
+          seed: i,
+        ),
+    ];
+
+    final sequentialSamples = <double>[];
+    final batchSamples = <double>[];
+    for (var round = 0; round < 3; round++) {
+      // 原来的路径：每个文件一个请求，逐个备份
+      var selection = selectionFor(round * 2);
+      var stopwatch = Stopwatch()..start();
+      for (final filePath in selection) {
+        final result = await FileNode(filePath).safeBackup();
+        expect(result.isOk, isTrue);
+      }
+      sequentialSamples.add(files / stopwatch.elapsedMicroseconds * 1e6);
+
+      selection = selectionFor(round * 2 + 1);
+      stopwatch = Stopwatch()..start();
+      final batch = await batchService.run(FileBatchAction.backup, selection);
+      batchSamples.add(files / stopwatch.elapsedMicroseconds * 1e6);
+      expect(batch.failedCount, 0);
+    }
+    final parameters = {'files': files, 'concurrency': 4};
+    report
+      ..add(
+        BenchmarkResult.fromSamples(
+          'selectionBackup.sequential',
+          'files/s',
+          sequentialSamples,
+          lowerIsBetter: false,
+          parameters: parameters,
+        ),
+      )
+      ..add(
+        BenchmarkResult.fromSamples(
+          'selectionBackup.batch',
+          'files/s',
+          batchSamples,
+          lowerIsBetter: false,
+          parameters: parameters,
+        ),
+      );
+  });
+
+  test('retention cleanup of an overgrown backup directory', () async {
+    final count = 2000 * scale;
+    const keep = 50;
+    final samples = <double>[];
+    for (var round = 0; round < 3; round++) {
+      final backupDir = path.join(tempDir.path, 'retention_$round');
+      generateBackups(backupDir, 'scene.psd', count: count, seed: round);
+
+      final stopwatch = Stopwatch()..start();
+      final deleted = Monitor.pruneOldBackups(backupDir, keep);
+      samples.add(stopwatch.elapsedMicroseconds / 1000);
+
+      expect(deleted, hasLength(count - keep));
+      expect(Directory(backupDir).listSync(), hasLength(keep));
+    }
+    report.add(
+      BenchmarkResult.fromSamples(
+        'retention.prune',
+        'ms',
+        samples,
+        parameters: {'backups': count, 'keep': keep},
+      ),
+    );
+  });
+
+  test('LAN share download throughput', () async {
+    final bytes = 32 * 1024 * 1024 * scale;
+    final filePath = writeRandomFile(
+      path.join(tempDir.path, 'share', 'render.0.1.mov'),
+      bytes,
+    );
+    final server = LanFileShareServer(
+      addressResolver: () async => ['127.0.0.1'],
+      wifiNameResolver: () async => null,
+    );
+    addTearDown(server.dispose);
+    final share = (await server.createShare(filePath)).unwrap();
+    final downloadUrl = Uri.parse(
+      ((share['directDownloads'] as List<dynamic>).first
+              as Map<String, dynamic>)['downloadUrl']
+          as String,
+    );
+
+    final client = HttpClient();
+    addTearDown(client.close);
+    final samples = <double>[];
+    for (var round = 0; round < 3; round++) {
+      final stopwatch = Stopwatch()..start();
+      final response = await (await client.getUrl(downloadUrl)).close();
+      expect(response.statusCode, HttpStatus.ok);
+      var received = 0;
+      await for (final chunk in response) {
+        received += chunk.length;
+      }
+      final seconds = stopwatch.elapsedMicroseconds / 1e6;
+      expect(received, bytes);
+      samples.add(bytes / (1024 * 1024) / seconds);
+    }
+    report.add(
+      BenchmarkResult.fromSamples(
+        'lanShare.download',
+        'MB/s',
+        samples,
+        lowerIsBetter: false,
+        parameters: {'bytes': bytes},
+      ),
+    );
+  });
+
+  test('no benchmark regressed beyond the tolerance', () {
+    if (baselinePath == null) {
+      return;
+    }
+    final baseline = BenchmarkReport.loadSync(baselinePath);
+    expect(baseline, isNotNull, reason: 'Baseline not found: $baselinePath');
+    final regressions = [
+      for (final comparison in report.compareTo(baseline!))
+        if (comparison.regression > tolerance)
+          '${comparison.current.name}: ${comparison.baseline.value} -> '
+              '${comparison.current.value} ${comparison.current.unit}',
+    ];
+    expect(regressions, isEmpty);
+  });
+}
+
+int _countNodes(FileNode node) {
+  var count = 1;
+  final child = node.child;
+  if (child != null) {
+    count += _countNodes(child);
+  }
+  for (final branch in node.branches) {
+    count += _countNodes(branch);
+  }
+  return count;
+}
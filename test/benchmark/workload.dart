@@ -0,0 +1,330 @@
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+
+/// 生成的版本家族形状
+class VersionFamilyShape {
+  const VersionFamilyShape({
+    this.name = 'doc',
+    this.extension = 'txt',
+    this.depth = 20,
+    this.branchEvery = 5,
+    this.branchFanOut = 2,
+    this.branchDepth = 3,
+    this.minFileBytes = 1024,
+    this.maxFileBytes = 16 * 1024,
+    this.noiseFiles = 50,
+    this.noiseFamilies = 2,
+    this.noiseDirectories = 5,
+    this.seed = 1,
+  });
+
+  final String name;
+  final String extension;
+
+  /// 主线版本数：`name.0.0` 到 `name.0.<depth - 1>`
+  final int depth;
+
+  /// 每隔多少个主线版本分出一组分支，0 表示没有分支
+  final int branchEvery;
+
+  /// 每个分叉点的分支数，分支号从 1 开始
+  final int branchFanOut;
+
+  /// 每条分支上的版本数
+  final int branchDepth;
+  final int minFileBytes;
+  final int maxFileBytes;
+
+  /// 同目录下与家族无关的普通文件数
+  final int noiseFiles;
+
+  /// 同目录下其他版本家族的数量，每个家族的版本数与主线相同
+  final int noiseFamilies;
+
+  /// 同目录下的子目录数，每个子目录放三个文件
+  final int noiseDirectories;
+  final int seed;
+
+  int get branchPointCount =>
+      branchEvery <= 0 ? 0 : (depth - 1) ~/ branchEvery;
+
+  int get versionCount => depth + branchPointCount * branchFanOut * branchDepth;
+
+  Map<String, dynamic> toJson() => {
+    'depth': depth,
+    'branchEvery': branchEvery,
+    'branchFanOut': branchFanOut,
+    'branchDepth': branchDepth,
+    'versionCount': versionCount,
+    'minFileBytes': minFileBytes,
+    'maxFileBytes': maxFileBytes,
+    'noiseFiles': noiseFiles,
+    'noiseFamilies': noiseFamilies,
+    'noiseDirectories': noiseDirectories,
+  };
+}
+
+class GeneratedFamily {
+  GeneratedFamily({
+    required this.directory,
+    required this.rootPath,
+    required this.latestPath,
+    required this.versionPaths,
+    required this.noisePaths,
+    required this.totalBytes,
+  });
+
+  final String directory;
+  final String rootPath;
+
+  /// 主线上最新的版本
+  final String latestPath;
+  final List<String> versionPaths;
+  final List<String> noisePaths;
+  final int totalBytes;
+}
+
+/// 在 [directory] 中按 [shape] 生成一个版本家族和干扰文件。
+///
+/// 版本内容是逐步修改的文本：每个版本在父版本基础上改写少量行，
+/// 大小在 [VersionFamilyShape.minFileBytes] 与 `maxFileBytes` 之间；
+/// 相同的 seed 生成完全相同的文件。
+GeneratedFamily generateVersionFamily(
+  String directory,
+  VersionFamilyShape shape,
+) {
+  Directory(directory).createSync(recursive: true);
+  final random = Random(shape.seed);
+  final versionPaths = <String>[];
+  var totalBytes = 0;
+
+  String write(String fileName, Uint8List content) {
+    final filePath = path.join(directory, fileName);
+    File(filePath).writeAsBytesSync(content);
+    totalBytes += content.length;
+    return filePath;
+  }
+
+  String versionName(String version) =>
+      '${shape.name}.$version.${shape.extension}';
+
+  var content = _textOfSize(random, _sizeFor(random, shape));
+  final mainline = <Uint8List>[];
+  for (var index = 0; index < shape.depth; index++) {
+    if (index > 0) {
+      content = _mutate(random, content, shape);
+    }
+    mainline.add(content);
+    versionPaths.add(write(versionName('0.$index'), content));
+  }
+
+  for (var point = 1; point <= shape.branchPointCount; point++) {
+    final parent = point * shape.branchEvery;
+    for (var branch = 1; branch <= shape.branchFanOut; branch++) {
+      var branchContent = mainline[parent];
+      for (var version = 0; version < shape.branchDepth; version++) {
+        branchContent = _mutate(random, branchContent, shape);
+        versionPaths.add(
+          write(versionName('0.$parent-$branch.$version'), branchContent),
+        );
+      }
+    }
+  }
+
+  final noisePaths = <String>[];
+  for (var family = 0; family < shape.noiseFamilies; family++) {
+    for (var index = 0; index < shape.depth; index++) {
+      noisePaths.add(
+        write(
+          '${shape.name}_other$family.0.$index.${shape.extension}',
+          _textOfSize(random, shape.minFileBytes),
+        ),
+      );
+    }
+  }
+  for (var index = 0; index < shape.noiseFiles; index++) {
+    noisePaths.add(
+      write('notes_$index.dat', _textOfSize(random, shape.minFileBytes)),
+    );
+  }
+  for (var index = 0; index < shape.noiseDirectories; index++) {
+    final subdirectory = path.join(directory, 'assets_$index');
+    Directory(subdirectory).createSync();
+    for (var file = 0; file < 3; file++) {
+      final filePath = path.join(subdirectory, 'asset_$file.bin');
+      File(filePath).writeAsBytesSync(_textOfSize(random, 256));
+      noisePaths.add(filePath);
+    }
+  }
+
+  return GeneratedFamily(
+    directory: directory,
+    rootPath: versionPaths.first,
+    latestPath: versionPaths[shape.depth - 1],
+    versionPaths: versionPaths,
+    noisePaths: noisePaths,
+    totalBytes: totalBytes,
+  );
+}
+
+/// 一组连续写入
+class WriteBurst {
+  WriteBurst(this.writeStarts, this.finishedAt);
+
+  /// 每次写入开始的时间
+  final List<DateTime> writeStarts;
+
+  /// 最后一次写入完成的时间
+  final DateTime finishedAt;
+
+  DateTime get startedAt => writeStarts.first;
+
+  DateTime get lastWriteAt => writeStarts.last;
+}
+
+/// 模拟用户编辑被监控的文件：每次突发连续写入若干次，突发之间停顿，
+/// 每次写入都以截断后整体重写的方式保存，和大多数编辑器的保存行为一致。
+class MonitorWorkload {
+  const MonitorWorkload({
+    this.bursts = 5,
+    this.writesPerBurst = 3,
+    this.writeInterval = const Duration(milliseconds: 20),
+    this.burstInterval = const Duration(milliseconds: 400),
+    this.bytesPerWrite = 64 * 1024,
+    this.seed = 3,
+  });
+
+  final int bursts;
+  final int writesPerBurst;
+  final Duration writeInterval;
+  final Duration burstInterval;
+  final int bytesPerWrite;
+  final int seed;
+
+  Map<String, dynamic> toJson() => {
+    'bursts': bursts,
+    'writesPerBurst': writesPerBurst,
+    'writeIntervalMs': writeInterval.inMilliseconds,
+    'burstIntervalMs': burstInterval.inMilliseconds,
+    'bytesPerWrite': bytesPerWrite,
+  };
+
+  /// 对 [filePath] 执行全部突发写入，[afterBurst] 在每次突发后、停顿前调用
+  Future<List<WriteBurst>> run(
+    String filePath, {
+    Future<void> Function(WriteBurst burst)? afterBurst,
+  }) async {
+    final random = Random(seed);
+    final result = <WriteBurst>[];
+    for (var burst = 0; burst < bursts; burst++) {
+      final writeStarts = <DateTime>[];
+      for (var write = 0; write < writesPerBurst; write++) {
+        if (write > 0) {
+          await Future<void>.delayed(writeInterval);
+        }
+        final content = _textOfSize(random, bytesPerWrite);
+        writeStarts.add(DateTime.now());
+        await File(filePath).writeAsBytes(content, flush: true);
+      }
+      final current = WriteBurst(writeStarts, DateTime.now());
+      result.add(current);
+      await afterBurst?.call(current);
+      await Future<void>.delayed(burstInterval);
+    }
+    return result;
+  }
+}
+
+/// 写入 [count] 个旧快照，修改时间按写入顺序递增
+List<String> generateBackups(
+  String backupDirPath,
+  String baseName, {
+  required int count,
+  int bytes = 1024,
+  int seed = 5,
+}) {
+  Directory(backupDirPath).createSync(recursive: true);
+  final random = Random(seed);
+  final start = DateTime.now().subtract(Duration(minutes: count + 1));
+  final extension = path.extension(baseName);
+  final backupPaths = <String>[];
+  for (var index = 0; index < count; index++) {
+    final modified = start.add(Duration(minutes: index));
+    final timestamp = modified.toIso8601String().replaceAll(':', '-');
+    final file = File(
+      path.join(backupDirPath, '${baseName}_$timestamp.bak$extension'),
+    );
+    file.writeAsBytesSync(_textOfSize(random, bytes));
+    file.setLastModifiedSync(modified);
+    backupPaths.add(file.path);
+  }
+  return backupPaths;
+}
+
+/// 写入 [bytes] 字节的随机内容，不可压缩
+String writeRandomFile(String filePath, int bytes, {int seed = 9}) {
+  final random = Random(seed);
+  final file = File(filePath);
+  file.parent.createSync(recursive: true);
+  final sink = file.openSync(mode: FileMode.write);
+  try {
+    final block = Uint8List(1 << 20);
+    for (var written = 0; written < bytes; written += block.length) {
+      for (var index = 0; index < block.length; index++) {
+        block[index] = random.nextInt(256);
+      }
+      sink.writeFromSync(block, 0, min(block.length, bytes - written));
+    }
+  } finally {
+    sink.closeSync();
+  }
+  return filePath;
+}
+
+final List<String> _words =
+    'vertree branch version snapshot draft review monitor backup scene '
+            'chapter layer export commit merge label'
+        .split(' ');
+
+int _sizeFor(Random random, VersionFamilyShape shape) {
+  final span = max(0, shape.maxFileBytes - shape.minFileBytes);
+  return shape.minFileBytes + (span == 0 ? 0 : random.nextInt(span + 1));
+}
+
+Uint8List _textOfSize(Random random, int bytes) {
+  final builder = BytesBuilder(copy: false);
+  var length = 0;
+  while (length < bytes) {
+    final line = List.generate(
+      8,
+      (_) => _words[random.nextInt(_words.length)],
+    ).join(' ');
+    final encoded = Uint8List.fromList('$line\n'.codeUnits);
+    builder.add(encoded);
+    length += encoded.length;
+  }
+  return Uint8List.sublistView(builder.takeBytes(), 0, bytes);
+}
+
+/// 改写约 5% 的行，并让长度在形状允许的范围内浮动
+Uint8List _mutate(Random random, Uint8List parent, VersionFamilyShape shape) {
+  final target = _sizeFor(random, shape);
+  final lines = String.fromCharCodes(parent).split('\n');
+  final edits = max(1, lines.length ~/ 20);
+  for (var edit = 0; edit < edits; edit++) {
+    lines[random.nextInt(lines.length)] = String.fromCharCodes(
+      _textOfSize(random, 48),
+    ).trim();
+  }
+  final mutated = Uint8List.fromList(lines.join('\n').codeUnits);
+  if (mutated.length >= target) {
+    return Uint8List.sublistView(mutated, 0, target);
+  }
+  return Uint8List.fromList([
+    ...mutated,
+    ..._textOfSize(random, target - mutated.length),
+  ]);
+}
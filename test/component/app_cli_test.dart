@@ -41,9 +41,32 @@ void main() {
       expect(service!.action, AppCliAction.viewtree);
     });
 
+    test('keeps every path of a multi-selection', () {
+      final express = parseAppCliArgs([
+        'express-backup',
+        '/tmp/a.txt',
+        '/tmp/b.txt',
+      ]);
+      final menu = parseAppCliArgs([
+        '--menu',
+        'monit',
+        '/tmp/a.txt',
+        '/tmp/b.txt',
+        '/tmp/c.txt',
+      ]);
+
+      expect(express!.paths, ['/tmp/a.txt', '/tmp/b.txt']);
+      expect(express.path, '/tmp/a.txt');
+      expect(express.action.supportsBatch, isTrue);
+      expect(menu!.action, AppCliAction.monit);
+      expect(menu.paths, hasLength(3));
+      expect(AppCliAction.share.supportsBatch, isFalse);
+    });
+
     test('rejects incomplete or unsupported forms', () {
       expect(parseAppCliArgs([]), isNull);
       expect(parseAppCliArgs(['backup']), isNull);
+      expect(parseAppCliArgs(['--menu', 'backup']), isNull);
       expect(parseAppCliArgs(['--unknown', '/tmp/demo.txt']), isNull);
     });
   });
@@ -0,0 +1,71 @@
+import 'package:test/test.dart';
+import 'package:vertree/component/MetricsRegistry.dart';
+
+void main() {
+  group('MetricsRegistry', () {
+    test('renders counters and gauges with labels', () {
+      final registry = MetricsRegistry();
+      final counter = registry.counter(
+        'demo_requests_total',
+        'Requests.',
+        labelNames: const ['route'],
+      );
+      final gauge = registry.gauge('demo_tasks', 'Tasks.');
+
+      counter.inc(const ['/health']);
+      counter.inc(const ['/health'], 2);
+      counter.inc(const ['/say "hi"']);
+      gauge.bind(() => 7);
+
+      final text = registry.renderPrometheusText();
+      expect(text, contains('# TYPE demo_requests_total counter'));
+      expect(text, contains('demo_requests_total{route="/health"} 3'));
+      expect(text, contains(r'demo_requests_total{route="/say \"hi\""} 1'));
+      expect(text, contains('demo_tasks 7'));
+    });
+
+    test('histogram buckets are cumulative and include +Inf', () {
+      final registry = MetricsRegistry();
+      final histogram = registry.histogram(
+        'demo_seconds',
+        'Latency.',
+        buckets: const [0.1, 1],
+      );
+
+      histogram.observe(0.05);
+      histogram.observe(0.1);
+      histogram.observe(0.5);
+      histogram.observe(3);
+
+      final text = registry.renderPrometheusText();
+      expect(text, contains('demo_seconds_bucket{le="0.1"} 2'));
+      expect(text, contains('demo_seconds_bucket{le="1"} 3'));
+      expect(text, contains('demo_seconds_bucket{le="+Inf"} 4'));
+      expect(text, contains('demo_seconds_sum 3.65'));
+      expect(text, contains('demo_seconds_count 4'));
+    });
+
+    test('registering the same name twice returns the same metric', () {
+      final registry = MetricsRegistry();
+      final first = registry.counter('demo_total', 'Demo.');
+      final second = registry.counter('demo_total', 'Demo.');
+
+      expect(identical(first, second), isTrue);
+      expect(
+        () => registry.gauge('demo_total', 'Demo.'),
+        throwsArgumentError,
+      );
+    });
+
+    test('rejects mismatched label arity', () {
+      final registry = MetricsRegistry();
+      final counter = registry.counter(
+        'demo_total',
+        'Demo.',
+        labelNames: const ['a', 'b'],
+      );
+
+      expect(() => counter.inc(const ['only-one']), throwsArgumentError);
+    });
+  });
+}
@@ -0,0 +1,95 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+
+void main() {
+  group('ChecksumManifest', () {
+    late Directory tempDir;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_manifest_');
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    ChecksumEntry entry(String name, String hash, {int size = 3}) {
+      return ChecksumEntry(
+        name: name,
+        hash: hash,
+        size: size,
+        modifiedMicros: 1700000000000000,
+      );
+    }
+
+    test('names hidden manifests that buildTree ignores', () {
+      final family = ChecksumManifest.familyManifestPath(
+        path.join('work', 'story#draft.0.1-0.0.txt'),
+      );
+
+      expect(family, path.join('work', '.story.txt.vertree.sums'));
+      expect(FileMeta.isSupportedTreeFilePath(family), isFalse);
+      expect(ChecksumManifest.isManifestPath(family), isTrue);
+      expect(
+        ChecksumManifest.isManifestPath(
+          ChecksumManifest.backupManifestPath('story_bak'),
+        ),
+        isTrue,
+      );
+      expect(ChecksumManifest.isManifestPath('story.0.0.txt'), isFalse);
+    });
+
+    test('later lines replace earlier ones and tombstones remove', () {
+      final manifestPath = path.join(tempDir.path, '.vertree.sums');
+      ChecksumManifest.appendSync(manifestPath, [
+        entry('a b.txt', '0000000000000001'),
+        entry('c.txt', '0000000000000002'),
+      ]);
+      ChecksumManifest.appendSync(manifestPath, [
+        entry('a b.txt', '0000000000000003', size: 9),
+      ]);
+      ChecksumManifest.appendRemovalsSync(manifestPath, ['c.txt']);
+
+      final manifest = ChecksumManifest.loadSync(manifestPath);
+      expect(manifest.entries.keys, ['a b.txt']);
+      expect(manifest.entries['a b.txt']!.hash, '0000000000000003');
+      expect(manifest.entries['a b.txt']!.size, 9);
+      expect(manifest.lineCount, 4);
+      expect(
+        File(manifestPath).readAsLinesSync().first,
+        ChecksumManifest.header,
+      );
+
+      manifest.compactSync();
+      final compacted = ChecksumManifest.loadSync(manifestPath);
+      expect(compacted.lineCount, 1);
+      expect(compacted.entries['a b.txt']!.hash, '0000000000000003');
+      expect(File('$manifestPath.tmp').existsSync(), isFalse);
+    });
+
+    test('records backups and branches with the hash of the copy', () async {
+      final source = File(path.join(tempDir.path, 'plan.0.0.txt'))
+        ..writeAsStringSync('first draft');
+      final node = FileNode(source.path);
+
+      final child = (await node.backup()).unwrap();
+      final branch = (await node.branch('alt')).unwrap();
+
+      final manifest = ChecksumManifest.loadSync(
+        ChecksumManifest.familyManifestPath(source.path),
+      );
+      expect(manifest.entries.keys.toSet(), {
+        'plan.0.0.txt',
+        path.basename(child.mate.fullPath),
+        path.basename(branch.mate.fullPath),
+      });
+      final hashes = manifest.entries.values.map((e) => e.hash).toSet();
+      expect(hashes, hasLength(1));
+      expect(manifest.entries['plan.0.0.txt']!.size, 11);
+    });
+  });
+}
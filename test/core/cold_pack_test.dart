@@ -0,0 +1,194 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/ColdPack.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+
+void main() {
+  group('ColdPack', () {
+    late Directory tempDir;
+    late String backupDir;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_cold_pack_');
+      backupDir = path.join(tempDir.path, 'scene_bak');
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    /// 按监控的命名方式写一个平铺快照并记入清单
+    String writeSnapshot(DateTime createdAt, String content) {
+      final timestamp = createdAt.toIso8601String().replaceAll(':', '-');
+      final file = File(path.join(backupDir, 'scene.txt_$timestamp.bak.txt'));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(content);
+      file.setLastModifiedSync(createdAt);
+      ChecksumManifest.appendSync(
+        ChecksumManifest.backupManifestPath(backupDir),
+        [ChecksumEntry.ofFile(file.path, FileChecksum.ofFileSync(file.path))],
+      );
+      return file.path;
+    }
+
+    test('packs old snapshots by month and restores each one', () {
+      final march = writeSnapshot(DateTime(2024, 3, 1), 'scene v1 ' * 200);
+      final april = writeSnapshot(DateTime(2024, 4, 2), 'scene v2');
+      final recent = writeSnapshot(DateTime(2024, 6, 1), 'scene v3');
+
+      final result = ColdPack.packSync(
+        backupDir,
+        olderThan: DateTime(2024, 5, 1),
+      );
+      SnapshotIndex.recordRemovalsSync(backupDir, result.removedNames);
+
+      expect(result.packedCount, 2);
+      expect(result.removedNames, [
+        path.basename(march),
+        path.basename(april),
+      ]);
+      expect(result.looseBytes, 1808);
+      // 两个打包文件、冷存储目录和索引
+      expect(result.createdFileCount, 4);
+      expect(result.inodesSaved, -2);
+      expect(result.bytesSaved, greaterThan(0));
+      expect(File(march).existsSync(), isFalse);
+      expect(File(recent).existsSync(), isTrue);
+      expect(
+        SnapshotIndex.snapshotsSync(
+          backupDir,
+        ).map((snapshot) => snapshot.name),
+        [path.basename(recent)],
+      );
+
+      final cold = ColdPack.loadSync(backupDir);
+      expect(cold.sorted.map((entry) => entry.pack), [
+        '2024-03.vtcold',
+        '2024-04.vtcold',
+      ]);
+      final first = cold.sorted.first;
+      expect(first.data.compressed, isTrue);
+      expect(first.createdAt, DateTime(2024, 3, 1));
+
+      final restored = path.join(tempDir.path, 'restored.txt');
+      cold.extractSync(first, restored);
+      expect(File(restored).readAsStringSync(), 'scene v1 ' * 200);
+      expect(File(restored).lastModifiedSync(), DateTime(2024, 3, 1));
+      expect(SnapshotIndex.isMetadataPath(cold.packPath(first)), isTrue);
+    });
+
+    test('appends to existing packs and drops an unindexed tail', () {
+      writeSnapshot(DateTime(2024, 3, 1), 'first');
+      ColdPack.packSync(backupDir, olderThan: DateTime(2024, 3, 2));
+      final second = writeSnapshot(DateTime(2024, 3, 5), 'second');
+
+      // 模拟上次写数据后、追加索引前中断
+      final packPath = path.join(
+        ColdPack.directoryPath(backupDir),
+        '2024-03.vtcold',
+      );
+      File(packPath).writeAsStringSync('garbage', mode: FileMode.append);
+
+      final result = ColdPack.packSync(
+        backupDir,
+        olderThan: DateTime(2024, 4, 1),
+      );
+
+      expect(result.packedCount, 1);
+      expect(result.createdFileCount, 0);
+      expect(File(second).existsSync(), isFalse);
+      final cold = ColdPack.loadSync(backupDir);
+      expect(cold.entries.length, 2);
+      final last = cold.sorted.last;
+      expect(File(packPath).lengthSync(), last.data.offset + last.size);
+      for (final entry in cold.sorted) {
+        final target = path.join(tempDir.path, 'out', entry.name);
+        File(target).parent.createSync(recursive: true);
+        cold.extractSync(entry, target);
+      }
+      expect(
+        File(
+          path.join(tempDir.path, 'out', path.basename(second)),
+        ).readAsStringSync(),
+        'second',
+      );
+    });
+
+    test('drops pruned entries and deletes emptied packs', () {
+      final march = writeSnapshot(DateTime(2024, 3, 1), 'march');
+      final april = writeSnapshot(DateTime(2024, 4, 2), 'april');
+      final april2 = writeSnapshot(DateTime(2024, 4, 3), 'april again');
+      ColdPack.packSync(backupDir, olderThan: DateTime(2024, 5, 1));
+
+      ColdPack.recordRemovalsSync(backupDir, [
+        path.basename(march),
+        path.basename(april),
+      ]);
+
+      final cold = ColdPack.loadSync(backupDir);
+      expect(cold.entries.keys, [path.basename(april2)]);
+      expect(cold.lineCount, 5);
+      final directory = ColdPack.directoryPath(backupDir);
+      expect(
+        File(path.join(directory, '2024-03.vtcold')).existsSync(),
+        isFalse,
+      );
+      final remaining = cold.entries.values.single;
+      final restored = path.join(tempDir.path, 'restored.txt');
+      cold.extractSync(remaining, restored);
+      expect(File(restored).readAsStringSync(), 'april again');
+    });
+
+    test('runs packing and pruning of one directory one at a time', () async {
+      final events = <String>[];
+      final first = Completer<void>();
+      final packing = ColdPack.runLocked(backupDir, () async {
+        events.add('pack start');
+        await first.future;
+        events.add('pack end');
+      });
+      final pruning = ColdPack.runLocked('$backupDir/', () {
+        events.add('prune');
+        return 3;
+      });
+      final otherDir = path.join(tempDir.path, 'other_bak');
+      final other = ColdPack.runLocked(otherDir, () => events.add('other'));
+
+      await other;
+      expect(events, ['pack start', 'other']);
+      first.complete();
+      await packing;
+      expect(await pruning, 3);
+      expect(events, ['pack start', 'other', 'pack end', 'prune']);
+    });
+
+    test('keeps snapshots that no longer match their checksum', () {
+      final damaged = writeSnapshot(DateTime(2024, 3, 1), 'original');
+      File(damaged)
+        ..writeAsStringSync('tampered')
+        ..setLastModifiedSync(DateTime(2024, 3, 1));
+      final packed = writeSnapshot(DateTime(2024, 3, 2), 'intact');
+
+      final result = ColdPack.packSync(
+        backupDir,
+        olderThan: DateTime(2024, 4, 1),
+      );
+
+      expect(result.skippedCount, 1);
+      expect(result.removedNames, [path.basename(packed)]);
+      expect(File(damaged).existsSync(), isTrue);
+      final cold = ColdPack.loadSync(backupDir);
+      expect(cold.entries.keys, [path.basename(packed)]);
+      final entry = cold.entries.values.single;
+      expect(
+        File(cold.packPath(entry)).lengthSync(),
+        entry.data.offset + entry.data.storedSize,
+      );
+    });
+  });
+}
@@ -0,0 +1,154 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FilePoller.dart';
+
+void main() {
+  group('FilePoller', () {
+    FilePoller? poller;
+
+    tearDown(() {
+      poller?.dispose();
+      poller = null;
+    });
+
+    test('reports modifications, deletions and re-creations', () async {
+      final tempDir = await Directory.systemTemp.createTemp('vertree_poll_');
+      addTearDown(() => tempDir.delete(recursive: true));
+      final filePath = path.join(tempDir.path, 'design.psd');
+      File(filePath).writeAsStringSync('one');
+
+      // 定时器不会触发，每轮都手动执行
+      final current = poller = FilePoller(tick: const Duration(hours: 1));
+      final events = <FileSystemEvent>[];
+      final subscription = current.watch(filePath).listen(events.add);
+      addTearDown(subscription.cancel);
+
+      await current.pollNow(all: true);
+      File(filePath).writeAsStringSync('three');
+      await current.pollNow(all: true);
+      await current.pollNow(all: true);
+      File(filePath).deleteSync();
+      await current.pollNow(all: true);
+      File(filePath).writeAsStringSync('back');
+      await current.pollNow(all: true);
+      await Future<void>.delayed(Duration.zero);
+
+      expect(events.map((event) => event.type), [
+        FileSystemEvent.modify,
+        FileSystemEvent.delete,
+        FileSystemEvent.create,
+      ]);
+      expect(events.every((event) => event.path == filePath), isTrue);
+      expect(current.status()['detectedChanges'], 3);
+    });
+
+    test('backs off quiet files and resets after a change', () async {
+      var size = 1;
+      final current = poller = FilePoller(
+        minInterval: const Duration(seconds: 1),
+        maxInterval: const Duration(seconds: 4),
+        backoff: 2,
+        tick: const Duration(hours: 1),
+        statBatch: (paths) async => [
+          for (final _ in paths) PolledFileStat(exists: true, size: size),
+        ],
+      );
+      final subscription = current.watch('/remote/a.txt').listen((_) {});
+      addTearDown(subscription.cancel);
+
+      final intervals = <Duration?>[];
+      for (var round = 0; round < 3; round++) {
+        await current.pollNow(all: true);
+        intervals.add(current.intervalOf('/remote/a.txt'));
+      }
+      size = 2;
+      await current.pollNow(all: true);
+      intervals.add(current.intervalOf('/remote/a.txt'));
+
+      expect(intervals, const [
+        Duration(seconds: 2),
+        Duration(seconds: 4),
+        Duration(seconds: 4),
+        Duration(seconds: 1),
+      ]);
+    });
+
+    test('stats at most the round budget, oldest due files first', () async {
+      final batches = <List<String>>[];
+      final current = poller = FilePoller(
+        tick: const Duration(seconds: 10),
+        statsPerSecond: 1,
+        statBatch: (paths) async {
+          batches.add(paths);
+          return List.filled(paths.length, PolledFileStat.missing);
+        },
+      );
+      final paths = [for (var index = 0; index < 25; index++) '/nfs/$index'];
+      final subscriptions = [
+        for (final filePath in paths) current.watch(filePath).listen((_) {}),
+      ];
+      addTearDown(() async {
+        for (final subscription in subscriptions) {
+          await subscription.cancel();
+        }
+      });
+
+      for (var round = 0; round < 3; round++) {
+        await current.pollNow(all: true);
+      }
+
+      expect(current.roundBudget, 10);
+      expect(batches.map((batch) => batch.length), [10, 10, 10]);
+      expect({...batches[0], ...batches[1]}, hasLength(20));
+      expect({...batches[0], ...batches[1], ...batches[2]}, paths.toSet());
+    });
+
+    test('stops polling files whose listeners are gone', () async {
+      final current = poller = FilePoller(
+        tick: const Duration(hours: 1),
+        statBatch: (paths) async =>
+            List.filled(paths.length, PolledFileStat.missing),
+      );
+      final first = current.watch('/nfs/a').listen((_) {});
+      final second = current.watch('/nfs/a').listen((_) {});
+      expect(current.fileCount, 1);
+
+      await first.cancel();
+      expect(current.fileCount, 1);
+      await second.cancel();
+      expect(current.fileCount, 0);
+      expect(current.intervalOf('/nfs/a'), isNull);
+    });
+  });
+
+  group('FilePoller.kindFromMountTable', () {
+    const mounts = r'''
+/dev/sda1 / ext4 rw,relatime 0 0
+server:/export /mnt/nfs nfs4 rw,relatime 0 0
+tmpfs /mnt/nfs/cache tmpfs rw 0 0
+//nas/design /mnt/design\040share cifs rw 0 0
+me@host:/srv /home/me/remote fuse.sshfs rw 0 0
+''';
+
+    test('uses the longest mount point that contains the path', () {
+      final expectations = {
+        '/home/me/doc.txt': FilesystemKind.local,
+        '/mnt/nfs/plan.psd': FilesystemKind.network,
+        '/mnt/nfs': FilesystemKind.network,
+        '/mnt/nfs/cache/plan.psd': FilesystemKind.local,
+        '/mnt/nfsish/plan.psd': FilesystemKind.local,
+        '/mnt/design share/logo.ai': FilesystemKind.network,
+        '/home/me/remote/notes.md': FilesystemKind.fuse,
+      };
+      for (final MapEntry(key: filePath, value: kind) in expectations.entries) {
+        expect(
+          FilePoller.kindFromMountTable(filePath, mounts),
+          kind,
+          reason: filePath,
+        );
+      }
+    });
+  });
+}
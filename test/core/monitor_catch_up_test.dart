@@ -0,0 +1,142 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FilePoller.dart';
+import 'package:vertree/core/MonitorCatchUp.dart';
+
+void main() {
+  group('MonitorCatchUp', () {
+    late Directory tempDir;
+    late List<String> hashed;
+    late MonitorCatchUp catchUp;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_catch_up_');
+      hashed = [];
+      catchUp = MonitorCatchUp(
+        statBatchSize: 2,
+        hashFile: (filePath) async {
+          hashed.add(filePath);
+          return FileChecksum.ofFileSync(filePath).hex;
+        },
+      );
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    String writeFile(String name, String content, DateTime modified) {
+      final file = File(path.join(tempDir.path, name));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(content);
+      file.setLastModifiedSync(modified);
+      return file.path;
+    }
+
+    FileFingerprint fingerprintOf(String filePath) {
+      return FileFingerprint.fromStat(
+        FilePoller.statFilesSync([filePath]).single!,
+        hash: FileChecksum.ofFileSync(filePath).hex,
+      );
+    }
+
+    test('compares stat first and hashes only ambiguous files', () async {
+      final same = writeFile('same.txt', 'alpha', DateTime(2024, 1, 1));
+      final grown = writeFile('grown.txt', 'alpha', DateTime(2024, 1, 1));
+      final touched = writeFile('touched.txt', 'alpha', DateTime(2024, 1, 1));
+      final edited = writeFile('edited.txt', 'alpha', DateTime(2024, 1, 1));
+      final targets = [
+        for (final filePath in [same, grown, touched, edited])
+          CatchUpTarget(
+            filePath: filePath,
+            fingerprint: fingerprintOf(filePath),
+          ),
+      ];
+
+      writeFile('grown.txt', 'alpha beta', DateTime(2024, 1, 2));
+      writeFile('touched.txt', 'alpha', DateTime(2024, 1, 2));
+      writeFile('edited.txt', 'omega', DateTime(2024, 1, 2));
+      final results = await catchUp.scan(targets);
+
+      expect(results.map((result) => result.state), [
+        CatchUpState.unchanged,
+        CatchUpState.changed,
+        CatchUpState.unchanged,
+        CatchUpState.changed,
+      ]);
+      expect(hashed, unorderedEquals([touched, edited]));
+      expect(results[0].fingerprint, isNull);
+      expect(
+        results[2].fingerprint!.modifiedNs,
+        DateTime(2024, 1, 2).microsecondsSinceEpoch * 1000,
+      );
+      expect(results[2].fingerprint!.hash, targets[2].fingerprint!.hash);
+    });
+
+    test('reports missing files without touching them', () async {
+      final results = await catchUp.scan([
+        CatchUpTarget(
+          filePath: path.join(tempDir.path, 'gone.psd'),
+          fingerprint: const FileFingerprint(
+            size: 1,
+            modifiedNs: 1,
+            fileId: 1,
+          ),
+        ),
+      ]);
+
+      expect(results.single.state, CatchUpState.missing);
+      expect(hashed, isEmpty);
+    });
+
+    test('tasks without a fingerprint use their newest snapshot', () async {
+      final backupDir = path.join(tempDir.path, 'scene_bak');
+      writeFile('scene_bak/scene_1.blend', 'v1', DateTime(2024, 3, 1));
+      writeFile('scene_bak/scene_2.blend', 'v2', DateTime(2024, 3, 5));
+      final older = writeFile('scene.blend', 'v2', DateTime(2024, 3, 4));
+      final newer = writeFile('newer.blend', 'v3', DateTime(2024, 3, 6));
+      final fresh = writeFile('fresh.blend', 'v1', DateTime(2024, 3, 6));
+
+      final results = await catchUp.scan([
+        CatchUpTarget(filePath: older, backupDirPath: backupDir),
+        CatchUpTarget(filePath: newer, backupDirPath: backupDir),
+        CatchUpTarget(
+          filePath: fresh,
+          backupDirPath: path.join(tempDir.path, 'fresh_bak'),
+        ),
+      ]);
+
+      expect(results.map((result) => result.state), [
+        CatchUpState.unchanged,
+        CatchUpState.changed,
+        CatchUpState.unchanged,
+      ]);
+      // 未变化的旧任务记下当前状态，下次启动直接按指纹比较
+      expect(results[0].fingerprint!.size, 2);
+      expect(results[0].fingerprint!.hash, isNull);
+      expect(results[2].fingerprint, isNotNull);
+      expect(hashed, isEmpty);
+    });
+
+    test('fingerprints round-trip through the task config', () {
+      const fingerprint = FileFingerprint(
+        size: 42,
+        modifiedNs: 1700000000123456789,
+        fileId: 99,
+        hash: '0123456789abcdef',
+      );
+
+      final restored = FileFingerprint.fromJson(fingerprint.toJson())!;
+
+      expect(restored.size, 42);
+      expect(restored.modifiedNs, 1700000000123456789);
+      expect(restored.fileId, 99);
+      expect(restored.hash, '0123456789abcdef');
+      expect(FileFingerprint.fromJson({'size': 'x'}), isNull);
+      expect(FileFingerprint.fromJson(null), isNull);
+    });
+  });
+}
@@ -0,0 +1,101 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:test/test.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/SnapshotCopyQueue.dart';
+
+void main() {
+  group('SnapshotCopyQueue', () {
+    test('groups requests that arrive while a batch is copying', () async {
+      final batches = <List<String>>[];
+      final release = Completer<void>();
+      final queue = SnapshotCopyQueue(
+        copyBatch: (pairs) async {
+          batches.add([for (final (source, _) in pairs) source]);
+          if (batches.length == 1) {
+            await release.future;
+          }
+          return [
+            for (final (source, _) in pairs)
+              FileChecksum(hash: source.hashCode, size: source.length),
+          ];
+        },
+      );
+
+      final first = [queue.copy('a', 'a.bak'), queue.copy('b', 'b.bak')];
+      await Future<void>.delayed(Duration.zero);
+      final second = [
+        queue.copy('c', 'c.bak'),
+        queue.copy('d', 'd.bak'),
+        queue.copy('e', 'e.bak'),
+      ];
+      expect(queue.pendingCount, 3);
+      release.complete();
+
+      final results = await Future.wait([...first, ...second]);
+      expect(batches, [
+        ['a', 'b'],
+        ['c', 'd', 'e'],
+      ]);
+      expect(results.map((checksum) => checksum.size), [1, 1, 1, 1, 1]);
+      expect(queue.pendingCount, 0);
+    });
+
+    test('splits large bursts into batches of maxBatch', () async {
+      final sizes = <int>[];
+      final queue = SnapshotCopyQueue(
+        maxBatch: 4,
+        copyBatch: (pairs) async {
+          sizes.add(pairs.length);
+          return [
+            for (final _ in pairs) const FileChecksum(hash: 0, size: 0),
+          ];
+        },
+      );
+
+      await Future.wait([
+        for (var i = 0; i < 10; i++) queue.copy('$i', '$i.bak'),
+      ]);
+
+      expect(sizes, [4, 4, 2]);
+    });
+
+    test('fails only the requests whose copy failed', () async {
+      var calls = 0;
+      final queue = SnapshotCopyQueue(
+        copyBatch: (pairs) async {
+          calls += 1;
+          if (calls == 2) {
+            throw const FileSystemException('批量复制失败');
+          }
+          return [
+            for (final (source, _) in pairs)
+              source == 'bad' ? null : const FileChecksum(hash: 1, size: 1),
+          ];
+        },
+      );
+
+      final good = queue.copy('good', 'good.bak');
+      final bad = queue.copy('bad', 'bad.bak');
+      expect((await good).size, 1);
+      await expectLater(
+        bad,
+        throwsA(
+          isA<FileSystemException>().having(
+            (error) => error.path,
+            'path',
+            'bad',
+          ),
+        ),
+      );
+
+      // 整批失败时这一批的请求全部失败，之后的批次不受影响
+      await expectLater(
+        queue.copy('later', 'later.bak'),
+        throwsA(isA<FileSystemException>()),
+      );
+      expect((await queue.copy('again', 'again.bak')).hash, 1);
+    });
+  });
+}
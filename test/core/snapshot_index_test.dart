@@ -0,0 +1,233 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+
+void main() {
+  group('SnapshotIndex', () {
+    late Directory tempDir;
+    late String backupDir;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_snapshot_');
+      backupDir = path.join(tempDir.path, 'scene_bak');
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    /// 按监控的命名方式写一个平铺快照并记入清单
+    String writeSnapshot(DateTime createdAt, String content) {
+      final timestamp = createdAt.toIso8601String().replaceAll(':', '-');
+      final file = File(path.join(backupDir, 'scene.txt_$timestamp.bak.txt'));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(content);
+      ChecksumManifest.appendSync(
+        ChecksumManifest.backupManifestPath(backupDir),
+        [ChecksumEntry.ofFile(file.path, FileChecksum.ofFileSync(file.path))],
+      );
+      return file.path;
+    }
+
+    SnapshotRecord record(String name, DateTime createdAt, {int size = 1}) {
+      return SnapshotRecord(
+        name: name,
+        createdMicros: createdAt.microsecondsSinceEpoch,
+        size: size,
+      );
+    }
+
+    test('migrates a flat directory into date shards in place', () {
+      final first = writeSnapshot(DateTime(2024, 3, 1, 9), 'one');
+      writeSnapshot(DateTime(2024, 3, 1, 18, 30), 'two');
+      writeSnapshot(DateTime(2024, 12, 31, 23, 59, 59, 123), 'three');
+      File(path.join(backupDir, 'notes.txt'))
+        ..writeAsStringSync('loose')
+        ..setLastModifiedSync(DateTime(2025, 1, 2));
+
+      expect(SnapshotIndex.isShardedSync(backupDir), isFalse);
+      final migration = SnapshotIndex.migrateSync(backupDir);
+
+      expect(migration.snapshotCount, 4);
+      expect(migration.movedCount, 4);
+      expect(SnapshotIndex.isShardedSync(backupDir), isTrue);
+      expect(File(first).existsSync(), isFalse);
+
+      final snapshots = SnapshotIndex.snapshotsSync(backupDir);
+      expect(snapshots.map((snapshot) => snapshot.name), [
+        '2024/03/01/${path.basename(first)}',
+        startsWith('2024/03/01/'),
+        startsWith('2024/12/31/'),
+        '2025/01/02/notes.txt',
+      ]);
+      for (final snapshot in snapshots) {
+        expect(File(snapshot.pathIn(backupDir)).existsSync(), isTrue);
+      }
+      expect(snapshots.first.createdAt, DateTime(2024, 3, 1, 9));
+      expect(
+        snapshots.first.hash,
+        FileChecksum.ofFileSync(snapshots.first.pathIn(backupDir)).hex,
+      );
+      expect(snapshots.last.hash, isNull);
+
+      // 校验记录随文件改到新名字下
+      final manifest = ChecksumManifest.loadSync(
+        ChecksumManifest.backupManifestPath(backupDir),
+      );
+      expect(
+        manifest.entries.keys,
+        unorderedEquals(snapshots.take(3).map((snapshot) => snapshot.name)),
+      );
+
+      // 再次迁移不移动任何文件，索引保持不变
+      final again = SnapshotIndex.migrateSync(backupDir);
+      expect(again.movedCount, 0);
+      expect(
+        SnapshotIndex.snapshotsSync(backupDir).map((snapshot) => snapshot.name),
+        snapshots.map((snapshot) => snapshot.name),
+      );
+    });
+
+    test('answers latest and time ranges from the index', () {
+      Directory(backupDir).createSync(recursive: true);
+      SnapshotIndex.appendSync(backupDir, [
+        record('2024/05/02/b.txt', DateTime(2024, 5, 2)),
+        record('2024/05/01/a.txt', DateTime(2024, 5, 1)),
+        record('2024/05/03/c.txt', DateTime(2024, 5, 3)),
+      ]);
+
+      expect(SnapshotIndex.latestSync(backupDir)!.name, '2024/05/03/c.txt');
+      expect(
+        SnapshotIndex.rangeSync(
+          backupDir,
+          from: DateTime(2024, 5, 2),
+          to: DateTime(2024, 5, 3),
+        ).map((snapshot) => snapshot.name),
+        ['2024/05/02/b.txt'],
+      );
+      expect(
+        SnapshotIndex.rangeSync(backupDir, from: DateTime(2024, 5, 2)).length,
+        2,
+      );
+    });
+
+    test('records removals, drops empty shards and compacts', () {
+      final names = <String>[];
+      for (var day = 1; day <= 20; day++) {
+        final name = SnapshotIndex.shardNameFor(
+          'scene_$day.txt',
+          DateTime(2024, 6, day),
+        );
+        final file = File(path.joinAll([backupDir, ...name.split('/')]));
+        file.parent.createSync(recursive: true);
+        file.writeAsStringSync('$day');
+        SnapshotIndex.appendSync(backupDir, [
+          record(name, DateTime(2024, 6, day)),
+        ]);
+        names.add(name);
+      }
+
+      final removed = names.take(19).toList();
+      for (final name in removed) {
+        File(path.joinAll([backupDir, ...name.split('/')])).deleteSync();
+      }
+      SnapshotIndex.recordRemovalsSync(backupDir, removed);
+
+      final index = SnapshotIndex.loadSync(backupDir);
+      expect(index.records.keys, [names.last]);
+      expect(index.lineCount, 1);
+      final june = path.join(backupDir, '2024', '06');
+      expect(Directory(path.join(june, '01')).existsSync(), isFalse);
+      expect(Directory(june).existsSync(), isTrue);
+    });
+
+    test('reads flat directories without an index', () {
+      final older = writeSnapshot(DateTime(2024, 1, 1), 'old');
+      final newer = writeSnapshot(DateTime(2024, 1, 2), 'new');
+      File(older).setLastModifiedSync(DateTime(2024, 1, 1));
+      File(newer).setLastModifiedSync(DateTime(2024, 1, 2));
+
+      final snapshots = SnapshotIndex.snapshotsSync(backupDir);
+
+      expect(snapshots.map((snapshot) => snapshot.name), [
+        path.basename(older),
+        path.basename(newer),
+      ]);
+      expect(
+        SnapshotIndex.latestSync(backupDir)!.createdAt,
+        DateTime(2024, 1, 2),
+      );
+      expect(SnapshotIndex.isShardedSync(backupDir), isFalse);
+      expect(
+        SnapshotIndex.snapshotsSync(path.join(tempDir.path, 'none_bak')),
+        isEmpty,
+      );
+    });
+
+    test('lists both layouts after an interrupted migration', () {
+      final moved = writeSnapshot(DateTime(2024, 3, 1, 9), 'one');
+      final flat = writeSnapshot(DateTime(2024, 3, 2, 9), 'two');
+      // 模拟移走第一个快照后、写出索引前中断，且没有留下标记
+      final shardName = SnapshotIndex.shardNameFor(
+        path.basename(moved),
+        DateTime(2024, 3, 1, 9),
+      );
+      final shardPath = path.joinAll([backupDir, ...shardName.split('/')]);
+      Directory(path.dirname(shardPath)).createSync(recursive: true);
+      File(moved).renameSync(shardPath);
+
+      expect(SnapshotIndex.isShardedSync(backupDir), isFalse);
+      expect(SnapshotIndex.isMigrationIncompleteSync(backupDir), isTrue);
+      expect(
+        SnapshotIndex.snapshotsSync(backupDir).map((snapshot) => snapshot.name),
+        [shardName, path.basename(flat)],
+      );
+
+      // 带标记的中断：索引已写出也不算分片布局
+      File(
+        SnapshotIndex.migrationMarkerPath(backupDir),
+      ).writeAsStringSync('interrupted\n');
+      SnapshotIndex.appendSync(backupDir, [
+        record(shardName, DateTime(2024, 3, 1, 9)),
+      ]);
+      expect(SnapshotIndex.isShardedSync(backupDir), isFalse);
+      expect(SnapshotIndex.snapshotsSync(backupDir), hasLength(2));
+
+      final migration = SnapshotIndex.migrateSync(backupDir);
+      expect(migration.snapshotCount, 2);
+      expect(migration.movedCount, 1);
+      expect(SnapshotIndex.isShardedSync(backupDir), isTrue);
+      expect(SnapshotIndex.isMigrationIncompleteSync(backupDir), isFalse);
+      expect(
+        File(SnapshotIndex.migrationMarkerPath(backupDir)).existsSync(),
+        isFalse,
+      );
+      expect(
+        SnapshotIndex.snapshotsSync(backupDir).map((snapshot) => snapshot.name),
+        [
+          shardName,
+          SnapshotIndex.shardNameFor(
+            path.basename(flat),
+            DateTime(2024, 3, 2, 9),
+          ),
+        ],
+      );
+    });
+
+    test('parses the timestamp in monitor snapshot names', () {
+      expect(
+        SnapshotIndex.createdAtFromName(
+          'a_b.txt_2024-07-08T09-10-11.250.bak.txt',
+        ),
+        DateTime(2024, 7, 8, 9, 10, 11, 250),
+      );
+      expect(SnapshotIndex.createdAtFromName('a.bak.txt'), isNull);
+      expect(BackupLayout.parse(' Sharded '), BackupLayout.sharded);
+      expect(BackupLayout.parse(null), BackupLayout.flat);
+    });
+  });
+}
@@ -0,0 +1,225 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/VersionCopy.dart';
+import 'package:vertree/core/Xxh64.dart';
+
+Uint8List _pattern(int length) {
+  final bytes = Uint8List(length);
+  for (var i = 0; i < length; i++) {
+    bytes[i] = (i * 31 + (i >> 9)) & 0xff;
+  }
+  return bytes;
+}
+
+void main() {
+  group('VersionCopy', () {
+    late Directory tempDir;
+    late String sourcePath;
+    late String targetPath;
+    late Uint8List content;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_version_copy_');
+      content = _pattern(1000003);
+      sourcePath = path.join(tempDir.path, 'scene.0.1.psd');
+      File(sourcePath).writeAsBytesSync(content);
+      targetPath = path.join(tempDir.path, 'scene.0.2.psd');
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    List<String> leftovers() => [
+      for (final entity in tempDir.listSync())
+        if (VersionCopy.isPartPath(entity.path)) path.basename(entity.path),
+    ];
+
+    void writeJournal(int verifiedBytes) {
+      final stat = File(sourcePath).statSync();
+      File(VersionCopy.journalPathOf(targetPath)).writeAsStringSync(
+        jsonEncode({
+          'sourcePath': sourcePath,
+          'sourceSize': stat.size,
+          'sourceModifiedMicros': stat.modified.microsecondsSinceEpoch,
+          'verifiedBytes': verifiedBytes,
+          'verifiedHash': Xxh64.hexOf(
+            Xxh64.hashBytes(Uint8List.sublistView(content, 0, verifiedBytes)),
+          ),
+        }),
+      );
+    }
+
+    test('streams large files through a temp file and renames it', () async {
+      final states = <VersionCopyState>[];
+      final subscription = VersionCopy.updates.listen(
+        (task) => states.add(task.state),
+      );
+      addTearDown(subscription.cancel);
+
+      final checksum = await VersionCopy.copy(
+        sourcePath,
+        targetPath,
+        chunkBytes: 16 * 1024,
+        checkpointBytes: 64 * 1024,
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      expect(File(targetPath).readAsBytesSync(), content);
+      expect(checksum.size, content.length);
+      expect(checksum.hash, Xxh64.hashBytes(content));
+      expect(leftovers(), isEmpty);
+      expect(VersionCopy.active, isEmpty);
+      expect(states.first, VersionCopyState.copying);
+      expect(states.last, VersionCopyState.finished);
+    });
+
+    test('copies small files in one go', () async {
+      final checksum = await VersionCopy.copy(sourcePath, targetPath);
+
+      expect(File(targetPath).readAsBytesSync(), content);
+      expect(checksum.hash, Xxh64.hashBytes(content));
+      expect(leftovers(), isEmpty);
+    });
+
+    test('resumes from the last verified offset', () async {
+      const verified = 300000;
+      // 检查点之后写入的内容没有记录，续传时应丢弃
+      File(VersionCopy.partPathOf(targetPath)).writeAsBytesSync([
+        ...Uint8List.sublistView(content, 0, verified),
+        ...List.filled(5000, 7),
+      ]);
+      writeJournal(verified);
+      final resumed = <int>[];
+      final subscription = VersionCopy.updates.listen(
+        (task) => resumed.add(task.resumedFromBytes),
+      );
+      addTearDown(subscription.cancel);
+
+      final checksum = await VersionCopy.copy(
+        sourcePath,
+        targetPath,
+        chunkBytes: 16 * 1024,
+        checkpointBytes: 64 * 1024,
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      expect(resumed, contains(verified));
+      expect(File(targetPath).readAsBytesSync(), content);
+      expect(checksum.hash, Xxh64.hashBytes(content));
+      expect(leftovers(), isEmpty);
+    });
+
+    test('resumes under another label and sweeps stale temp files', () async {
+      const verified = 300000;
+      File(
+        VersionCopy.partPathOf(targetPath),
+      ).writeAsBytesSync(Uint8List.sublistView(content, 0, verified));
+      writeJournal(verified);
+      // 按旧规则带备注命名的，以及对应版本已经存在的临时文件
+      final legacy = path.join(tempDir.path, '.scene#draft.0.2.psd.vtpart');
+      File(legacy).writeAsStringSync('legacy');
+      File('$legacy.json').writeAsStringSync('{}');
+      File(path.join(tempDir.path, 'scene.0.3.psd')).writeAsStringSync('v3');
+      File(
+        path.join(tempDir.path, '.scene.0.3.psd.vtpart'),
+      ).writeAsStringSync('done');
+      final labeledPath = path.join(tempDir.path, 'scene#final.0.2.psd');
+      final resumed = <int>[];
+      final subscription = VersionCopy.updates.listen(
+        (task) => resumed.add(task.resumedFromBytes),
+      );
+      addTearDown(subscription.cancel);
+
+      await VersionCopy.copy(
+        sourcePath,
+        labeledPath,
+        chunkBytes: 16 * 1024,
+        checkpointBytes: 64 * 1024,
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      expect(resumed, contains(verified));
+      expect(File(labeledPath).readAsBytesSync(), content);
+      expect(leftovers(), isEmpty);
+    });
+
+    test('starts over when the temp file does not match its record', () async {
+      File(
+        VersionCopy.partPathOf(targetPath),
+      ).writeAsBytesSync(List.filled(300000, 1));
+      writeJournal(300000);
+      final resumed = <int>[];
+      final subscription = VersionCopy.updates.listen(
+        (task) => resumed.add(task.resumedFromBytes),
+      );
+      addTearDown(subscription.cancel);
+
+      final checksum = await VersionCopy.copy(
+        sourcePath,
+        targetPath,
+        chunkBytes: 16 * 1024,
+        checkpointBytes: 64 * 1024,
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      expect(resumed.every((offset) => offset == 0), isTrue);
+      expect(File(targetPath).readAsBytesSync(), content);
+      expect(checksum.hash, Xxh64.hashBytes(content));
+    });
+
+    test('cancel removes the temp file and creates no version', () async {
+      final subscription = VersionCopy.updates.listen((task) {
+        if (task.state == VersionCopyState.copying) {
+          task.cancel();
+        }
+      });
+      addTearDown(subscription.cancel);
+
+      await expectLater(
+        VersionCopy.copy(
+          sourcePath,
+          targetPath,
+          chunkBytes: 4096,
+          checkpointBytes: 64 * 1024,
+        ),
+        throwsA(isA<VersionCopyCancelled>()),
+      );
+      expect(File(targetPath).existsSync(), isFalse);
+      expect(leftovers(), isEmpty);
+      expect(VersionCopy.active, isEmpty);
+    });
+
+    test('never overwrites an existing version', () async {
+      File(targetPath).writeAsStringSync('existing');
+
+      await expectLater(
+        VersionCopy.copy(sourcePath, targetPath),
+        throwsA(isA<FileSystemException>()),
+      );
+      expect(File(targetPath).readAsStringSync(), 'existing');
+    });
+
+    test('temp files are not version files', () {
+      final partPath = VersionCopy.partPathOf(targetPath);
+      expect(path.basename(partPath), '.scene.0.2.psd.vtpart');
+      expect(VersionCopy.isPartPath(partPath), isTrue);
+      expect(
+        VersionCopy.isPartPath(VersionCopy.journalPathOf(targetPath)),
+        isTrue,
+      );
+      expect(VersionCopy.isPartPath(targetPath), isFalse);
+      expect(
+        VersionCopy.partPathOf(path.join(tempDir.path, 'scene#x.0.2.psd')),
+        partPath,
+      );
+      expect(FileMeta.isSupportedTreeFilePath(partPath), isFalse);
+    });
+  });
+}
@@ -0,0 +1,225 @@
+import 'dart:math';
+
+import 'package:test/test.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/core/VersionKey.dart';
+
+void main() {
+  group('VersionKey', () {
+    test('orders keys exactly like the segment-wise comparison', () {
+      final random = Random(40);
+      for (var round = 0; round < 5000; round++) {
+        final a = _randomSegments(random);
+        final b = random.nextInt(4) == 0
+            ? _mutateSegments(random, a)
+            : _randomSegments(random);
+        final keyA = VersionKey.encode(a);
+        final keyB = VersionKey.encode(b);
+
+        expect(
+          keyA.compareTo(keyB).sign,
+          _referenceCompare(a, b).sign,
+          reason: '${_format(a)} vs ${_format(b)}',
+        );
+        expect(keyA == keyB, _referenceCompare(a, b) == 0);
+        expect(VersionKey.decode(keyA), a);
+      }
+    });
+
+    test('derives the parent that isChild and isDirectBranch describe', () {
+      final random = Random(41);
+      for (var round = 0; round < 3000; round++) {
+        final version = FileVersion.fromSegments(_randomSegments(random));
+        final parentKey = VersionKey.parentOf(version.key);
+        final last = version.segments.last;
+
+        if (last.version == 0 && version.segments.length == 1) {
+          expect(parentKey, isNull, reason: version.toString());
+          continue;
+        }
+        final parent = FileVersion.fromSegments(
+          last.version > 0
+              ? [
+                  ...version.segments.take(version.segments.length - 1),
+                  Segment(last.branch, last.version - 1),
+                ]
+              : version.segments.take(version.segments.length - 1).toList(),
+        );
+        expect(parentKey, parent.key, reason: version.toString());
+        expect(
+          parent.isChild(version) || parent.isDirectBranch(version),
+          isTrue,
+          reason: version.toString(),
+        );
+      }
+    });
+
+    test('radix sort matches a stable comparison sort', () {
+      final random = Random(42);
+      for (var round = 0; round < 200; round++) {
+        final length = random.nextInt(300);
+        final items = [
+          for (var index = 0; index < length; index++)
+            (FileVersion.fromSegments(_randomSegments(random)), index),
+        ];
+        final expected = [...items]
+          ..sort((a, b) {
+            final order = _referenceCompare(a.$1.segments, b.$1.segments);
+            return order != 0 ? order : a.$2 - b.$2;
+          });
+
+        VersionKey.sort(items, (item) => item.$1.key);
+
+        expect(items, expected);
+      }
+    });
+  });
+
+  group('assembleTree', () {
+    test('builds the same tree as the recursive push on complete families', () {
+      final random = Random(43);
+      for (var round = 0; round < 200; round++) {
+        final versions = _randomFamily(random);
+        final paths = [
+          for (final version in versions) '/vertree/doc.$version.txt',
+        ]..shuffle(random);
+
+        final root = assembleTree([for (final p in paths) FileNode(p)])!;
+
+        expect(
+          root.toTreeString(),
+          _referenceTree(paths).toTreeString(),
+          reason: paths.join('\n'),
+        );
+        expect(_countNodes(root), versions.length);
+      }
+    });
+
+    test('keeps the push semantics for gaps and duplicate versions', () {
+      final random = Random(44);
+      for (var round = 0; round < 200; round++) {
+        final versions = _randomFamily(random);
+        final paths = <String>[];
+        for (final (index, version) in versions.indexed) {
+          // 随机删掉中间版本，并给部分版本加上同版本号的带备注副本
+          if (index > 0 && random.nextInt(6) == 0) {
+            continue;
+          }
+          paths.add('/vertree/doc.$version.txt');
+          if (random.nextInt(8) == 0) {
+            paths.add('/vertree/doc#copy.$version.txt');
+          }
+        }
+        paths.shuffle(random);
+
+        final root = assembleTree([for (final p in paths) FileNode(p)])!;
+
+        expect(
+          root.toTreeString(),
+          _referenceTree(paths).toTreeString(),
+          reason: paths.join('\n'),
+        );
+      }
+    });
+  });
+}
+
+/// 原来的逐段比较
+int _referenceCompare(List<Segment> a, List<Segment> b) {
+  final minLen = min(a.length, b.length);
+  for (var i = 0; i < minLen; i++) {
+    final diffBranch = a[i].branch - b[i].branch;
+    if (diffBranch != 0) return diffBranch;
+    final diffVer = a[i].version - b[i].version;
+    if (diffVer != 0) return diffVer;
+  }
+  return a.length - b.length;
+}
+
+/// 原来的建树方式：按版本排序（相同版本保持输入顺序）后逐个从根递归挂载
+FileNode _referenceTree(List<String> paths) {
+  final nodes = [for (final p in paths) FileNode(p)];
+  final indexed = nodes.indexed.toList()
+    ..sort((a, b) {
+      final order = _referenceCompare(
+        a.$2.mate.version.segments,
+        b.$2.mate.version.segments,
+      );
+      return order != 0 ? order : a.$1 - b.$1;
+    });
+  final root = indexed.first.$2;
+  for (final (_, node) in indexed) {
+    root.push(node);
+  }
+  return root;
+}
+
+/// 从 `0.0` 出发随机续写版本或开分支得到的完整家族
+List<FileVersion> _randomFamily(Random random) {
+  final versions = [FileVersion('0.0')];
+  final seen = {'0.0'};
+  final count = 1 + random.nextInt(80);
+  while (versions.length < count) {
+    final base = versions[random.nextInt(versions.length)];
+    final next = random.nextInt(3) == 0
+        ? base.branchVersion(random.nextInt(4))
+        : base.nextVersion();
+    if (seen.add(next.toString())) {
+      versions.add(next);
+    }
+  }
+  return versions;
+}
+
+/// 偏向小数字，也覆盖多字节编码的边界
+int _randomNumber(Random random) {
+  switch (random.nextInt(10)) {
+    case 0:
+      return 235 + random.nextInt(30);
+    case 1:
+      return random.nextInt(1 << 20);
+    case 2:
+      return random.nextInt(1 << 32) * (1 << 10) + random.nextInt(1 << 10);
+    default:
+      return random.nextInt(5);
+  }
+}
+
+List<Segment> _randomSegments(Random random) {
+  return List.generate(
+    1 + random.nextInt(4),
+    (_) => Segment(_randomNumber(random), _randomNumber(random)),
+  );
+}
+
+/// 与 [segments] 共享前缀的版本，用来覆盖前缀与延伸的比较
+List<Segment> _mutateSegments(Random random, List<Segment> segments) {
+  final prefix = segments.take(random.nextInt(segments.length + 1)).toList();
+  switch (random.nextInt(3)) {
+    case 0:
+      return prefix.isEmpty ? segments : prefix;
+    case 1:
+      return [...segments, Segment(0, _randomNumber(random))];
+    default:
+      return [
+        ...prefix,
+        Segment(_randomNumber(random), _randomNumber(random)),
+      ];
+  }
+}
+
+String _format(List<Segment> segments) =>
+    FileVersion.fromSegments(segments).toString();
+
+int _countNodes(FileNode node) {
+  var count = 1;
+  final child = node.child;
+  if (child != null) {
+    count += _countNodes(child);
+  }
+  for (final branch in node.branches) {
+    count += _countNodes(branch);
+  }
+  return count;
+}
@@ -0,0 +1,231 @@
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/core/VersionPack.dart';
+
+void main() {
+  group('VersionPack', () {
+    late Directory tempDir;
+    late String sourceDir;
+    late String packPath;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_pack_');
+      sourceDir = path.join(tempDir.path, 'source');
+      packPath = path.join(tempDir.path, 'doc.vtpack');
+
+      final files = {
+        'doc.0.0.txt': 'first draft\n' * 400,
+        'doc.0.1.txt': 'second draft\n' * 400,
+        'doc#review.0.1-0.0.txt': 'review branch\n' * 400,
+        'doc.0.2.txt': 'tiny',
+        'notes.0.0.txt': 'another family',
+        'doc.0.1_bak/doc.0.1.txt_2026-01-01T10-00-00.bak.txt': 'snapshot',
+      };
+      for (final MapEntry(key: name, value: content) in files.entries) {
+        final file = File(path.joinAll([sourceDir, ...name.split('/')]));
+        await file.parent.create(recursive: true);
+        await file.writeAsString(content);
+      }
+      // 随机内容压缩不了，应原样存放并从页边界开始
+      final random = Random(7);
+      await File(path.join(sourceDir, 'doc.0.3.txt')).writeAsBytes(
+        Uint8List.fromList(
+          List.generate(200 * 1024, (_) => random.nextInt(256)),
+        ),
+      );
+    });
+
+    tearDown(() async {
+      if (tempDir.existsSync()) {
+        await tempDir.delete(recursive: true);
+      }
+    });
+
+    test('exports the family with a readable footer index', () async {
+      final exported = VersionPack.exportFamilySync(
+        path.join(sourceDir, 'doc.0.1.txt'),
+        packPath,
+        includeBackups: true,
+      );
+      final pack = VersionPack.openSync(packPath);
+
+      expect(pack.name, 'doc');
+      expect(pack.fileExtension, 'txt');
+      expect(
+        pack.versions.map((entry) => entry.name),
+        unorderedEquals([
+          'doc.0.0.txt',
+          'doc.0.1.txt',
+          'doc#review.0.1-0.0.txt',
+          'doc.0.2.txt',
+          'doc.0.3.txt',
+        ]),
+      );
+      expect(pack.backups.map((entry) => entry.name), [
+        'doc.0.1_bak/doc.0.1.txt_2026-01-01T10-00-00.bak.txt',
+      ]);
+      expect(exported.entries.length, pack.entries.length);
+      expect(File('$packPath.tmp').existsSync(), isFalse);
+
+      final repetitive = pack.entry('doc.0.0.txt')!;
+      expect(repetitive.compressed, isTrue);
+      expect(repetitive.storedSize, lessThan(repetitive.size));
+      expect(pack.entry('doc.0.2.txt')!.compressed, isFalse);
+
+      final large = pack.entry('doc.0.3.txt')!;
+      expect(large.compressed, isFalse);
+      expect(large.offset % VersionPack.pageAlignment, 0);
+      for (final entry in pack.entries) {
+        expect(entry.offset % VersionPack.alignment, 0);
+      }
+
+      expect(
+        String.fromCharCodes(await pack.read(pack.entry('doc.0.2.txt')!)),
+        'tiny',
+      );
+      expect(
+        await pack.read(large),
+        await File(path.join(sourceDir, 'doc.0.3.txt')).readAsBytes(),
+      );
+      final streamed = await pack
+          .openRead(repetitive)
+          .expand((chunk) => chunk)
+          .toList();
+      expect(String.fromCharCodes(streamed), 'first draft\n' * 400);
+    });
+
+    test('leaves backups out unless requested', () {
+      VersionPack.exportFamilySync(
+        path.join(sourceDir, 'doc.0.0.txt'),
+        packPath,
+      );
+
+      expect(VersionPack.openSync(packPath).backups, isEmpty);
+    });
+
+    test('builds the version tree straight from the pack', () async {
+      VersionPack.exportFamilySync(
+        path.join(sourceDir, 'doc.0.0.txt'),
+        packPath,
+      );
+
+      final result = await buildTreeFromPack(packPath);
+
+      expect(result.isOk, isTrue);
+      final root = result.unwrap();
+      expect(root.mate.fullPath, path.join(packPath, 'doc.0.0.txt'));
+      expect(root.mate.fileSize, 'first draft\n'.length * 400);
+      expect(root.child?.mate.version.toString(), '0.1');
+      expect(root.child?.child?.mate.version.toString(), '0.2');
+      expect(root.child?.branches.single.mate.label, 'review');
+      expect(VersionPack.isEntryPath(root.mate.fullPath), isTrue);
+      expect(VersionPack.splitEntryPath(root.mate.fullPath), (
+        packPath,
+        'doc.0.0.txt',
+      ));
+    });
+
+    test('imports under the original names and records checksums', () {
+      VersionPack.exportFamilySync(
+        path.join(sourceDir, 'doc.0.0.txt'),
+        packPath,
+        includeBackups: true,
+      );
+      final targetDir = path.join(tempDir.path, 'restored');
+
+      final report = VersionPack.importPackSync(
+        packPath,
+        targetDirectory: targetDir,
+      );
+
+      expect(report.restored, hasLength(6));
+      expect(report.conflicts, isEmpty);
+      final review = File(path.join(targetDir, 'doc#review.0.1-0.0.txt'));
+      expect(review.readAsStringSync(), 'review branch\n' * 400);
+      final backup = File(
+        path.join(
+          targetDir,
+          'doc.0.1_bak',
+          'doc.0.1.txt_2026-01-01T10-00-00.bak.txt',
+        ),
+      );
+      expect(backup.readAsStringSync(), 'snapshot');
+      expect(
+        File(path.join(targetDir, 'doc.0.0.txt')).lastModifiedSync(),
+        File(path.join(sourceDir, 'doc.0.0.txt')).lastModifiedSync(),
+      );
+
+      final manifest = ChecksumManifest.loadSync(
+        ChecksumManifest.familyManifestPath(
+          path.join(targetDir, 'doc.0.0.txt'),
+        ),
+      );
+      final pack = VersionPack.openSync(packPath);
+      expect(
+        manifest.entries['doc.0.2.txt']?.hash,
+        pack.entry('doc.0.2.txt')!.hash,
+      );
+      expect(
+        ChecksumManifest.loadSync(
+          ChecksumManifest.backupManifestPath(backup.parent.path),
+        ).entries,
+        hasLength(1),
+      );
+    });
+
+    test('never overwrites existing files on import', () {
+      VersionPack.exportFamilySync(
+        path.join(sourceDir, 'doc.0.0.txt'),
+        packPath,
+      );
+      File(path.join(sourceDir, 'doc.0.2.txt')).writeAsStringSync('edited');
+
+      final report = VersionPack.importPackSync(
+        packPath,
+        targetDirectory: sourceDir,
+      );
+
+      expect(report.restored, isEmpty);
+      expect(report.conflicts, ['doc.0.2.txt']);
+      expect(report.skipped, hasLength(4));
+      expect(
+        File(path.join(sourceDir, 'doc.0.2.txt')).readAsStringSync(),
+        'edited',
+      );
+    });
+
+    test('detects corrupted entries and truncated packs', () async {
+      VersionPack.exportFamilySync(
+        path.join(sourceDir, 'doc.0.0.txt'),
+        packPath,
+        compress: false,
+      );
+      final pack = VersionPack.openSync(packPath);
+      final entry = pack.entry('doc.0.1.txt')!;
+
+      final corrupted = File(packPath).readAsBytesSync();
+      corrupted[entry.offset + 3] ^= 0x21;
+      File(packPath).writeAsBytesSync(corrupted);
+
+      await expectLater(pack.read(entry), throwsFormatException);
+      final targetPath = path.join(tempDir.path, 'out.txt');
+      await expectLater(
+        pack.extractEntry(entry, targetPath),
+        throwsFormatException,
+      );
+      expect(File(targetPath).existsSync(), isFalse);
+
+      File(packPath).writeAsBytesSync(
+        corrupted.sublist(0, corrupted.length - 5),
+      );
+      expect(() => VersionPack.openSync(packPath), throwsFormatException);
+      expect((await buildTreeFromPack(packPath)).isErr, isTrue);
+    });
+  });
+}
@@ -0,0 +1,113 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/Xxh64.dart';
+
+/// 与 native/test/checksum_test.cpp 相同的生成规则
+Uint8List _pattern(int length) {
+  return Uint8List.fromList([
+    for (var i = 0; i < length; i++) ((i * i * 31 + i * 7) >> 3) & 0xff,
+  ]);
+}
+
+void main() {
+  group('Xxh64', () {
+    test('matches the reference digests', () {
+      String hex(List<int> bytes) => Xxh64.hexOf(Xxh64.hashBytes(bytes));
+
+      expect(hex([]), 'ef46db3751d8e999');
+      expect(hex(utf8.encode('a')), 'd24ec4f1a98c6e5b');
+      expect(hex(utf8.encode('abc')), '44bc2cf5ad770999');
+      expect(hex(_pattern(31)), 'b5429a83e33c39a3');
+      expect(hex(_pattern(32)), 'e724bf51de2dd891');
+      expect(hex(_pattern(33)), '5cbcdb6956716fa7');
+      expect(hex(_pattern(100)), '61eebf0a5ab1f0b9');
+      expect(hex(_pattern(1048576 + 37)), '2f9200bcf036fcbd');
+    });
+
+    test('gives the same digest however the input is split', () {
+      final bytes = _pattern(1000);
+      final whole = Xxh64.hashBytes(bytes);
+      for (final step in const [1, 7, 31, 32, 33, 200]) {
+        final hash = Xxh64();
+        for (var offset = 0; offset < bytes.length; offset += step) {
+          final end = offset + step < bytes.length
+              ? offset + step
+              : bytes.length;
+          hash.addBytes(bytes.sublist(offset, end));
+        }
+        expect(hash.value, whole, reason: 'step $step');
+        expect(hash.length, bytes.length);
+      }
+    });
+  });
+
+  group('FileChecksum', () {
+    late Directory tempDir;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_checksum_');
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    test('hashes while copying', () async {
+      final source = File(path.join(tempDir.path, 'source.bin'))
+        ..writeAsBytesSync(_pattern(3 * 1048576 + 5));
+      final target = path.join(tempDir.path, 'target.bin');
+
+      final copied = await FileChecksum.copy(source.path, target);
+      final reread = await FileChecksum.ofFile(target, lowPriority: true);
+
+      expect(File(target).readAsBytesSync(), source.readAsBytesSync());
+      expect(copied.size, 3 * 1048576 + 5);
+      expect(copied.hash, reread.hash);
+      expect(copied.hash, Xxh64.hashBytes(source.readAsBytesSync()));
+    });
+
+    test('copies a batch with per-file results', () async {
+      final pairs = <(String, String)>[];
+      for (var i = 0; i < 20; i++) {
+        final source = path.join(tempDir.path, 'source_$i.bin');
+        File(source).writeAsBytesSync(_pattern(i * 70001));
+        pairs.add((source, path.join(tempDir.path, 'target_$i.bin')));
+      }
+      final missingTarget = path.join(tempDir.path, 'missing_target.bin');
+      pairs.add((path.join(tempDir.path, 'missing.bin'), missingTarget));
+
+      final copied = await FileChecksum.copyAll(pairs);
+
+      expect(copied, hasLength(pairs.length));
+      for (var i = 0; i < 20; i++) {
+        final (source, target) = pairs[i];
+        final bytes = File(source).readAsBytesSync();
+        expect(File(target).readAsBytesSync(), bytes);
+        expect(copied[i]!.size, bytes.length);
+        expect(copied[i]!.hash, Xxh64.hashBytes(bytes));
+      }
+      expect(copied.last, isNull);
+      expect(File(missingTarget).existsSync(), isFalse);
+    });
+
+    test('fails without leaving a target behind', () async {
+      final missing = path.join(tempDir.path, 'missing.bin');
+      final target = path.join(tempDir.path, 'target.bin');
+
+      await expectLater(
+        FileChecksum.copy(missing, target),
+        throwsA(isA<FileSystemException>()),
+      );
+      expect(File(target).existsSync(), isFalse);
+      expect(
+        () => FileChecksum.ofFileSync(missing),
+        throwsA(isA<FileSystemException>()),
+      );
+    });
+  });
+}
@@ -0,0 +1,153 @@
+@TestOn('linux')
+library;
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/platform/linux_shell_ipc_server.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+import 'package:vertree/service/ShellIndexService.dart';
+
+void main() {
+  group('LinuxShellIpcServer', () {
+    late Directory tempDir;
+    late StreamController<String> createdVersions;
+    late ShellIndexService indexService;
+    late List<List<String>> actions;
+    late LinuxShellIpcServer server;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_shell_ipc_');
+      createdVersions = StreamController<String>.broadcast();
+      indexService = ShellIndexService(
+        targetsResolver: () => const <DiskUsageTarget>[],
+        createdVersions: createdVersions.stream,
+      );
+      actions = [];
+      server = LinuxShellIpcServer(
+        indexService: indexService,
+        onAction: actions.add,
+        socketPath: path.join(tempDir.path, 'run', 'shell.sock'),
+      );
+      expect(await server.start(), isTrue);
+    });
+
+    tearDown(() async {
+      await server.stop();
+      await indexService.dispose();
+      await createdVersions.close();
+      await tempDir.delete(recursive: true);
+    });
+
+    Future<(Socket, StreamIterator<String>)> connect() async {
+      final socket = await Socket.connect(
+        InternetAddress(server.socketPath, type: InternetAddressType.unix),
+        0,
+      );
+      addTearDown(socket.destroy);
+      final lines = StreamIterator(
+        socket
+            .cast<List<int>>()
+            .transform(utf8.decoder)
+            .transform(const LineSplitter()),
+      );
+      return (socket, lines);
+    }
+
+    Future<String> nextLine(StreamIterator<String> lines) async {
+      final hasLine = await lines.moveNext().timeout(
+        const Duration(seconds: 5),
+      );
+      expect(hasLine, isTrue);
+      return lines.current;
+    }
+
+    test('answers a directory query in one reply', () async {
+      final dirPath = path.join(tempDir.path, 'docs\twith tab');
+      Directory(dirPath).createSync();
+      File(path.join(dirPath, 'plan.0.0.txt')).writeAsStringSync('a');
+      File(path.join(dirPath, 'plan.0.1.txt')).writeAsStringSync('b');
+      File(path.join(dirPath, 'other.txt')).writeAsStringSync('c');
+      final (socket, lines) = await connect();
+
+      socket.write('query\t${LinuxShellIpcServer.encodeField(dirPath)}\n');
+
+      final header = (await nextLine(lines)).split('\t');
+      expect(header, ['dir', LinuxShellIpcServer.encodeField(dirPath), '2']);
+      final entries = [await nextLine(lines), await nextLine(lines)]
+          .map((line) => line.split('\t'))
+          .toList()
+        ..sort((a, b) => a[0].compareTo(b[0]));
+      expect(entries[0].take(3), ['plan.0.0.txt', '2', '0']);
+      expect(entries[1].take(3), ['plan.0.1.txt', '2', '0']);
+      expect(int.parse(entries[0][3]), greaterThan(0));
+    });
+
+    test('forwards menu actions as command line arguments', () async {
+      final (socket, _) = await connect();
+      final filePath = path.join(tempDir.path, 'a\\b.txt');
+
+      socket.write(
+        'action\tbackup\t${LinuxShellIpcServer.encodeField(filePath)}\n',
+      );
+      await socket.flush();
+      for (var i = 0; i < 50 && actions.isEmpty; i++) {
+        await Future<void>.delayed(const Duration(milliseconds: 10));
+      }
+
+      expect(actions, [
+        ['backup', filePath],
+      ]);
+    });
+
+    test('forwards a multi-selection as one action', () async {
+      final (socket, _) = await connect();
+      final paths = [
+        for (var i = 0; i < 3; i++) path.join(tempDir.path, 'doc $i.txt'),
+      ];
+
+      final fields = paths.map(LinuxShellIpcServer.encodeField).join('\t');
+      socket.write('action\tmonit\t$fields\n');
+      await socket.flush();
+      for (var i = 0; i < 50 && actions.isEmpty; i++) {
+        await Future<void>.delayed(const Duration(milliseconds: 10));
+      }
+
+      expect(actions, [
+        ['monit', ...paths],
+      ]);
+    });
+
+    test('pushes changed directories to connected extensions', () async {
+      final (_, lines) = await connect();
+      for (var i = 0; i < 50 && server.clientCount == 0; i++) {
+        await Future<void>.delayed(const Duration(milliseconds: 10));
+      }
+
+      createdVersions.add(path.join(tempDir.path, 'plan.0.2.txt'));
+
+      expect(await nextLine(lines), 'changed\t${tempDir.path}');
+    });
+
+    test('a second server does not take over a live socket', () async {
+      final second = LinuxShellIpcServer(
+        indexService: indexService,
+        onAction: actions.add,
+        socketPath: server.socketPath,
+      );
+      expect(await second.start(), isFalse);
+      expect(server.isRunning, isTrue);
+    });
+
+    test('fields round-trip through escaping', () {
+      const value = 'a\\b\tc\nd\re';
+      final encoded = LinuxShellIpcServer.encodeField(value);
+      expect(encoded, isNot(contains('\t')));
+      expect(encoded, isNot(contains('\n')));
+      expect(LinuxShellIpcServer.decodeField(encoded), value);
+    });
+  });
+}
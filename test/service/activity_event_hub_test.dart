@@ -0,0 +1,74 @@
+import 'package:test/test.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+
+void main() {
+  group('ActivityEventHub', () {
+    test('assigns monotonic ids and delivers events asynchronously', () async {
+      final hub = ActivityEventHub();
+      final received = <ActivityEvent>[];
+      final subscription = hub.stream.listen(received.add);
+
+      final first = hub.emit(ActivityEventType.snapshotStarted, {'n': 1});
+      final second = hub.emit(ActivityEventType.snapshotFinished, {'n': 2});
+
+      expect(first.id, 1);
+      expect(second.id, 2);
+      expect(received, isEmpty);
+
+      await Future<void>.delayed(Duration.zero);
+      expect(received.map((event) => event.id), [1, 2]);
+
+      await subscription.cancel();
+      await hub.dispose();
+    });
+
+    test('replaySince returns missed events with optional type filter', () {
+      final hub = ActivityEventHub();
+      hub.emit(ActivityEventType.fileEventObserved);
+      hub.emit(ActivityEventType.snapshotStarted);
+      hub.emit(ActivityEventType.snapshotFinished);
+
+      final replay = hub.replaySince(1);
+      expect(replay.isComplete, isTrue);
+      expect(replay.events.map((event) => event.id), [2, 3]);
+
+      final filtered = hub.replaySince(
+        0,
+        types: {ActivityEventType.snapshotFinished},
+      );
+      expect(filtered.events.single.type, ActivityEventType.snapshotFinished);
+    });
+
+    test('bounded buffer reports a gap once old events are evicted', () {
+      final hub = ActivityEventHub(replayCapacity: 2);
+      for (var index = 0; index < 5; index++) {
+        hub.emit(ActivityEventType.retentionPruned);
+      }
+
+      expect(hub.bufferedEventCount, 2);
+      expect(hub.oldestBufferedEventId, 4);
+
+      final stale = hub.replaySince(1);
+      expect(stale.isComplete, isFalse);
+      expect(stale.events.map((event) => event.id), [4, 5]);
+
+      final recent = hub.replaySince(3);
+      expect(recent.isComplete, isTrue);
+
+      final restarted = hub.replaySince(99);
+      expect(restarted.isComplete, isFalse);
+      expect(restarted.events.map((event) => event.id), [4, 5]);
+    });
+
+    test('toServerSentEvent encodes id, event and data lines', () {
+      final hub = ActivityEventHub(now: () => DateTime.utc(2025, 1, 2));
+      final frame = hub
+          .emit(ActivityEventType.shareDownloaded, {'fileName': 'a.0.0.txt'})
+          .toServerSentEvent();
+
+      expect(frame, startsWith('id: 1\nevent: share.downloaded\ndata: {'));
+      expect(frame, contains('"fileName":"a.0.0.txt"'));
+      expect(frame, endsWith('\n\n'));
+    });
+  });
+}
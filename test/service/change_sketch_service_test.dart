@@ -0,0 +1,155 @@
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/Fnv1a64.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/service/ChangeSketchService.dart';
+
+/// 用逐行哈希代替原生分块，便于在没有原生库的环境下验证缓存与估算逻辑
+ChangeSketch _lineSketch(List<String> lines, {int size = 128}) {
+  final hashes = <int>{
+    for (final line in lines)
+      (Fnv1a64()..addField(line)).value & 0x7fffffffffffffff,
+  }.toList()..sort();
+  return ChangeSketch(
+    fileSize: lines.length,
+    scannedBytes: lines.length,
+    chunkCount: lines.length,
+    hashes: Int64List.fromList(hashes.take(size).toList()),
+  );
+}
+
+List<String> _lines(int count, String prefix) {
+  return List.generate(count, (index) => '$prefix $index');
+}
+
+void main() {
+  group('ChangeSketch', () {
+    test('estimates the share of replaced chunks', () {
+      final original = _lines(4000, 'line');
+      final edited = [...original.sublist(0, 3600), ..._lines(400, 'new')];
+
+      expect(
+        ChangeSketch.estimateChange(
+          _lineSketch(original),
+          _lineSketch(original),
+        ),
+        0,
+      );
+      final estimate = ChangeSketch.estimateChange(
+        _lineSketch(original),
+        _lineSketch(edited),
+      );
+      expect(estimate, inInclusiveRange(0.03, 0.2));
+      expect(
+        ChangeSketch.estimateChange(
+          _lineSketch(original),
+          _lineSketch(_lines(4000, 'other')),
+        ),
+        greaterThan(0.9),
+      );
+      expect(
+        ChangeSketch.estimateChange(_lineSketch(original), _lineSketch([])),
+        1,
+      );
+    });
+
+    test('round-trips through bytes and rejects other formats', () {
+      final sketch = _lineSketch(_lines(50, 'line'));
+      final decoded = ChangeSketch.fromBytes(sketch.toBytes())!;
+
+      expect(decoded.fileSize, sketch.fileSize);
+      expect(decoded.chunkCount, sketch.chunkCount);
+      expect(decoded.hashes, sketch.hashes);
+      expect(ChangeSketch.fromBytes(Uint8List(8)), isNull);
+      expect(
+        ChangeSketch.fromBytes(
+          Uint8List.fromList(sketch.toBytes()..[0] = 99),
+        ),
+        isNull,
+      );
+    });
+  });
+
+  group('ChangeSketchService', () {
+    late Directory tempDir;
+    late List<String> computed;
+    late ChangeSketchService service;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_sketch_');
+      computed = [];
+      service = ChangeSketchService(
+        openPack: () async => null,
+        computeSketch: (filePath) async {
+          computed.add(path.basename(filePath));
+          final file = File(filePath);
+          if (!file.existsSync()) {
+            return null;
+          }
+          return _lineSketch(await file.readAsLines());
+        },
+      );
+    });
+
+    tearDown(() async {
+      if (tempDir.existsSync()) {
+        await tempDir.delete(recursive: true);
+      }
+    });
+
+    FileMeta writeVersion(String name, List<String> lines) {
+      final file = File(path.join(tempDir.path, name))
+        ..writeAsStringSync(lines.join('\n'));
+      return FileMeta(file.path);
+    }
+
+    test('computes each version once and shares pending work', () async {
+      final base = writeVersion('doc.0.0.bin', _lines(1000, 'line'));
+      final next = writeVersion('doc.0.1.bin', [
+        ..._lines(900, 'line'),
+        ..._lines(100, 'new'),
+      ]);
+
+      final estimates = await Future.wait([
+        service.estimateChange(base, next),
+        service.estimateChange(base, next),
+      ]);
+
+      expect(estimates[0], estimates[1]);
+      expect(estimates[0], inInclusiveRange(0.02, 0.25));
+      expect(computed, unorderedEquals(['doc.0.0.bin', 'doc.0.1.bin']));
+      expect(service.peek(base), isNotNull);
+      expect(service.status()['computed'], 2);
+    });
+
+    test('returns null when a version cannot be sketched', () async {
+      final base = writeVersion('doc.0.0.bin', _lines(10, 'line'));
+      final missing = FileMeta(path.join(tempDir.path, 'doc.0.1.bin'));
+
+      expect(await service.estimateChange(base, missing), isNull);
+      expect(service.status()['failed'], 1);
+    });
+
+    test('estimates every version of a tree against its parent', () async {
+      writeVersion('doc.0.0.bin', _lines(1000, 'line'));
+      writeVersion('doc.0.1.bin', _lines(1000, 'line'));
+      writeVersion('doc.0.0-0.0.bin', _lines(1000, 'other'));
+
+      final root = (await buildTree(
+        path.join(tempDir.path, 'doc.0.0.bin'),
+      )).unwrap();
+      final estimates = await service.estimateTree(root);
+
+      expect(estimates, hasLength(2));
+      expect(estimates[path.join(tempDir.path, 'doc.0.1.bin')], 0);
+      expect(
+        estimates[path.join(tempDir.path, 'doc.0.0-0.0.bin')],
+        greaterThan(0.9),
+      );
+    });
+  });
+}
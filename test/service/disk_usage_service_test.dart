@@ -0,0 +1,207 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+
+void main() {
+  group('DiskUsageService', () {
+    late Directory tempDir;
+    late String cachePath;
+    late List<DiskUsageTarget> monitored;
+    late ActivityEventHub hub;
+    late StreamController<String> createdVersions;
+    late DiskUsageService service;
+
+    DiskUsageService createService() {
+      return DiskUsageService(
+        targetsResolver: () => monitored,
+        activityEvents: hub.stream,
+        createdVersions: createdVersions.stream,
+        cachePathResolver: () async => cachePath,
+        concurrency: 2,
+        refreshDelay: const Duration(milliseconds: 20),
+      );
+    }
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_usage_');
+      cachePath = path.join(tempDir.path, 'support', 'disk_usage.json');
+      monitored = [];
+      hub = ActivityEventHub();
+      createdVersions = StreamController<String>.broadcast();
+      service = createService();
+    });
+
+    tearDown(() async {
+      await service.dispose();
+      await createdVersions.close();
+      await tempDir.delete(recursive: true);
+    });
+
+    String writeFile(String name, List<int> bytes, {DateTime? modified}) {
+      final file = File(path.join(tempDir.path, name));
+      file.parent.createSync(recursive: true);
+      file.writeAsBytesSync(bytes);
+      if (modified != null) {
+        file.setLastModifiedSync(modified);
+      }
+      return file.path;
+    }
+
+    /// 模拟监控：复制到备份目录并记入清单
+    String snapshot(
+      String filePath,
+      String backupDir,
+      String name, {
+      DateTime? modified,
+    }) {
+      Directory(backupDir).createSync(recursive: true);
+      final backupPath = path.join(backupDir, name);
+      final checksum = FileChecksum.copySync(filePath, backupPath);
+      if (modified != null) {
+        File(backupPath).setLastModifiedSync(modified);
+      }
+      ChecksumManifest.appendSync(
+        ChecksumManifest.backupManifestPath(backupDir),
+        [ChecksumEntry.ofFile(backupPath, checksum)],
+      );
+      return backupPath;
+    }
+
+    DiskUsageTarget monitor(String filePath) {
+      final target = DiskUsageTarget(
+        filePath: filePath,
+        backupDirPath: path.join(
+          path.dirname(filePath),
+          '${path.basenameWithoutExtension(filePath)}_bak',
+        ),
+      );
+      monitored.add(target);
+      return target;
+    }
+
+    test('counts snapshots, versions, growth and duplicates', () async {
+      final now = DateTime.now();
+      final doc = writeFile('doc.0.1.txt', List.filled(4000, 0x61));
+      writeFile('doc.0.0.txt', List.filled(1000, 0x62));
+      writeFile('other.0.0.txt', List.filled(500, 0x63));
+      final backupDir = monitor(doc).backupDirPath!;
+      snapshot(
+        doc,
+        backupDir,
+        'doc.0.1_1.bak.txt',
+        modified: now.subtract(const Duration(days: 20)),
+      );
+      snapshot(doc, backupDir, 'doc.0.1_2.bak.txt');
+      // 没有记入清单的快照不参与去重
+      writeFile(
+        'doc.0.1_bak/doc.0.1_3.bak.txt',
+        List.filled(2000, 0x64),
+        modified: now.subtract(const Duration(days: 40)),
+      );
+
+      final report = await service.refresh();
+      final usage = report.taskFor(doc)!;
+
+      expect(usage.error, isNull);
+      expect(usage.snapshotCount, 3);
+      expect(usage.backupBytes, 10000);
+      expect(usage.versionCount, 2);
+      expect(usage.versionBytes, 5000);
+      expect(usage.totalBytes, 15000);
+      expect(usage.bytesAddedLast7Days, 4000);
+      expect(usage.bytesAddedLast30Days, 8000);
+      expect(usage.duplicateBytes, 4000);
+      expect(usage.unhashedBytes, 7000);
+      expect(usage.largestSnapshots.first.size, 4000);
+      expect(usage.largestSnapshots.last.size, 2000);
+      expect(usage.sampledCompressionRatio, lessThan(0.1));
+      expect(usage.compressionSavingsBytes, greaterThan(9000));
+      expect(report.snapshotCount, 3);
+      expect(report.history.single.$2, 15000);
+      expect(File(cachePath).existsSync(), isTrue);
+    });
+
+    test('does not expect savings from incompressible data', () async {
+      final random = Random(11);
+      final bytes = Uint8List.fromList(
+        List.generate(64 * 1024, (_) => random.nextInt(256)),
+      );
+      final doc = writeFile('photo.0.0.bin', bytes);
+      final backupDir = monitor(doc).backupDirPath!;
+      snapshot(doc, backupDir, 'photo.0.0_1.bak.bin');
+
+      final usage = (await service.refresh()).taskFor(doc)!;
+
+      expect(usage.compressionSavingsBytes, 0);
+      expect(usage.sampledCompressionRatio, 1.0);
+    });
+
+    test('serves the persisted report before any scan', () async {
+      final doc = writeFile('doc.0.0.txt', List.filled(100, 0x61));
+      snapshot(doc, monitor(doc).backupDirPath!, 'doc.0.0_1.bak.txt');
+      expect(await service.cachedReport(), isNull);
+      await service.refresh();
+
+      final restarted = createService();
+      addTearDown(restarted.dispose);
+      final cached = await restarted.cachedReport();
+
+      expect(cached, isNotNull);
+      expect(cached!.taskFor(doc)!.backupBytes, 100);
+      expect(restarted.status()['scanCount'], 0);
+    });
+
+    test('rescans only the task named by backup events', () async {
+      final doc = writeFile('doc.0.0.txt', List.filled(100, 0x61));
+      final notes = writeFile('notes.0.0.txt', List.filled(100, 0x62));
+      final docBackups = monitor(doc).backupDirPath!;
+      final notesBackups = monitor(notes).backupDirPath!;
+      await service.refresh();
+
+      snapshot(doc, docBackups, 'doc.0.0_1.bak.txt');
+      snapshot(notes, notesBackups, 'notes.0.0_1.bak.txt');
+      hub.emit(ActivityEventType.snapshotFinished, {
+        'filePath': doc,
+        'success': true,
+      });
+      final report = await service.updates.first;
+
+      expect(report.taskFor(doc)!.snapshotCount, 1);
+      expect(report.taskFor(notes)!.snapshotCount, 0);
+      expect(service.status()['pendingTaskCount'], 0);
+    });
+
+    test('rescans the family when a new version is created', () async {
+      final doc = writeFile('doc.0.0.txt', List.filled(100, 0x61));
+      monitor(doc);
+      await service.refresh();
+
+      final created = writeFile('doc.0.1.txt', List.filled(50, 0x61));
+      createdVersions.add(created);
+      final report = await service.updates.first;
+
+      expect(report.taskFor(doc)!.versionCount, 2);
+      expect(report.taskFor(doc)!.versionBytes, 150);
+    });
+
+    test('drops tasks that are no longer monitored', () async {
+      final doc = writeFile('doc.0.0.txt', List.filled(100, 0x61));
+      monitor(doc);
+      await service.refresh();
+
+      monitored.clear();
+      final report = await service.refresh(filePaths: const []);
+
+      expect(report.tasks, isEmpty);
+      expect(report.history.single.$2, 0);
+    });
+  });
+}
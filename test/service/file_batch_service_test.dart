@@ -0,0 +1,124 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/Result.dart';
+import 'package:vertree/service/FileBatchService.dart';
+
+void main() {
+  group('FileBatchService', () {
+    late Directory tempDir;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_file_batch_');
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    String writeFile(String name) {
+      final file = File(path.join(tempDir.path, name));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(name);
+      return file.path;
+    }
+
+    test('reports every path in request order', () async {
+      final a = writeFile('a.txt');
+      final b = writeFile('b.txt');
+      final missing = path.join(tempDir.path, 'missing.txt');
+      final backedUp = <String>[];
+      final service = FileBatchService(
+        backup: (filePath, label) async {
+          backedUp.add(filePath);
+          return filePath == b
+              ? Result.eMsg('disk full')
+              : Result.ok('$filePath.bak');
+        },
+        monit: (filePath) async => Result.eMsg('unexpected'),
+      );
+
+      final report = await service.run(FileBatchAction.backup, [
+        a,
+        missing,
+        tempDir.path,
+        b,
+        a,
+      ]);
+
+      expect(report.items.map((item) => item.path), [
+        a,
+        missing,
+        tempDir.path,
+        b,
+      ]);
+      expect(backedUp, unorderedEquals([a, b]));
+      expect(report.succeededCount, 1);
+      expect(report.failedCount, 3);
+      expect(report.items.first.output, '$a.bak');
+      expect(report.firstFailure!.path, missing);
+      expect(report.items[3].error, 'disk full');
+    });
+
+    test('runs version families in order and others in parallel', () async {
+      final family = [
+        writeFile('plan.0.0.txt'),
+        writeFile('plan.0.1.txt'),
+        writeFile('plan.0.2.txt'),
+      ];
+      final others = [for (var i = 0; i < 6; i++) writeFile('doc_$i.txt')];
+      var running = 0;
+      var peak = 0;
+      var familyRunning = 0;
+      var familyPeak = 0;
+      final service = FileBatchService(
+        backup: (filePath, label) async => Result.eMsg('unexpected'),
+        monit: (filePath) async {
+          final inFamily = family.contains(filePath);
+          running += 1;
+          if (inFamily) familyRunning += 1;
+          peak = running > peak ? running : peak;
+          familyPeak = familyRunning > familyPeak ? familyRunning : familyPeak;
+          await Future<void>.delayed(const Duration(milliseconds: 5));
+          running -= 1;
+          if (inFamily) familyRunning -= 1;
+          return Result.ok(null);
+        },
+        concurrency: 3,
+      );
+
+      final report = await service.run(FileBatchAction.monit, [
+        ...family,
+        ...others,
+      ]);
+
+      expect(report.failedCount, 0);
+      expect(report.concurrency, 3);
+      expect(peak, 3);
+      expect(familyPeak, 1);
+    });
+
+    test('calls onFinished once with the whole report', () async {
+      final files = [for (var i = 0; i < 4; i++) writeFile('scene_$i.blend')];
+      final finished = <FileBatchReport>[];
+      final service = FileBatchService(
+        backup: (filePath, label) async => Result.ok('$filePath@$label'),
+        monit: (filePath) async => Result.ok(null),
+        onFinished: (report) async => finished.add(report),
+      );
+
+      final report = await service.run(
+        FileBatchAction.fromToken('express-backup')!,
+        files,
+        label: 'draft',
+      );
+
+      expect(finished, [report]);
+      expect(report.items.first.output, '${files.first}@draft');
+      expect(report.toJson()['action'], 'backup');
+      expect(report.toJson()['succeededCount'], 4);
+    });
+  });
+}
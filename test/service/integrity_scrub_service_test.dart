@@ -0,0 +1,199 @@
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/ChecksumManifest.dart';
+import 'package:vertree/core/FileChecksum.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/SnapshotIndex.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/IntegrityScrubService.dart';
+
+void main() {
+  group('IntegrityScrubService', () {
+    late Directory tempDir;
+    late List<String> events;
+    late IntegrityScrubService service;
+    late List<ScrubTarget> monitored;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_scrub_');
+      events = [];
+      monitored = [];
+      service = IntegrityScrubService(
+        targetsResolver: () => monitored,
+        onEvent: (type, data) => events.add(type),
+        concurrency: 2,
+        batchFiles: 2,
+      );
+    });
+
+    tearDown(() async {
+      service.dispose();
+      await tempDir.delete(recursive: true);
+    });
+
+    String writeFile(String name, String content) {
+      final file = File(path.join(tempDir.path, name));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(content);
+      return file.path;
+    }
+
+    /// 保持修改时间不变地改写内容，模拟静默损坏
+    void corrupt(String filePath, String content) {
+      final file = File(filePath);
+      final modified = file.lastModifiedSync();
+      file.writeAsStringSync(content);
+      file.setLastModifiedSync(modified);
+    }
+
+    /// 模拟监控：复制到备份目录并记入清单
+    String snapshot(String filePath, String backupDir, String name) {
+      Directory(backupDir).createSync(recursive: true);
+      final backupPath = path.join(backupDir, name);
+      final checksum = FileChecksum.copySync(filePath, backupPath);
+      ChecksumManifest.appendSync(
+        ChecksumManifest.backupManifestPath(backupDir),
+        [ChecksumEntry.ofFile(backupPath, checksum)],
+      );
+      return backupPath;
+    }
+
+    test('verifies versions and snapshots recorded at copy time', () async {
+      final first = writeFile('doc.0.0.txt', 'version one');
+      final node = FileNode(first);
+      final second = (await node.backup()).unwrap().mate.fullPath;
+      final backupDir = path.join(tempDir.path, 'doc.0.0_bak');
+      for (var index = 0; index < 3; index++) {
+        snapshot(first, backupDir, 'doc.0.0.txt_$index.bak.txt');
+      }
+      writeFile('other.0.0.txt', 'unrelated family');
+      monitored = ScrubTarget.forFile(first);
+
+      final report = (await service.scrub()).unwrap();
+
+      expect(report.targetCount, 2);
+      expect(report.fileCount, 5);
+      expect(report.verifiedCount, 5);
+      expect(report.problemCount, 0);
+      expect(report.bytesRead, 5 * 'version one'.length);
+      expect(events, [
+        ActivityEventType.scrubStarted,
+        ActivityEventType.scrubFinished,
+      ]);
+      expect(service.lastReport, same(report));
+      expect(File(second).existsSync(), isTrue);
+    });
+
+    test('reports corrupted, truncated and missing files', () async {
+      final first = writeFile('doc.0.0.txt', 'stable content');
+      final node = FileNode(first);
+      final second = (await node.backup()).unwrap();
+      final third = (await second.backup()).unwrap().mate.fullPath;
+      final backupDir = path.join(tempDir.path, 'doc.0.0_bak');
+      final kept = snapshot(first, backupDir, 'kept.bak.txt');
+      final lost = snapshot(first, backupDir, 'lost.bak.txt');
+
+      corrupt(second.mate.fullPath, 'stable c0ntent');
+      corrupt(kept, 'stable');
+      File(lost).deleteSync();
+      File(third).deleteSync();
+
+      final report = (await service.scrub(
+        targets: ScrubTarget.forFile(first),
+      )).unwrap();
+
+      final statuses = {
+        for (final problem in report.problems)
+          path.basename(problem.path): problem.status,
+      };
+      expect(statuses, {
+        path.basename(second.mate.fullPath): ScrubStatus.corrupted,
+        'kept.bak.txt': ScrubStatus.corrupted,
+        'lost.bak.txt': ScrubStatus.missing,
+        path.basename(third): ScrubStatus.missing,
+      });
+      expect(report.verifiedCount, 1);
+      expect(report.corruptedCount, 2);
+      expect(report.missingCount, 2);
+
+      // 缺失项仍留在清单里，直到明确要求移除
+      final again = (await service.scrub(
+        targets: ScrubTarget.forFile(first),
+        dropMissing: true,
+      )).unwrap();
+      expect(again.missingCount, 2);
+      expect(again.droppedCount, 2);
+      final last = (await service.scrub(
+        targets: ScrubTarget.forFile(first),
+      )).unwrap();
+      expect(last.missingCount, 0);
+      expect(last.corruptedCount, 2);
+    });
+
+    test('records edits and unknown files instead of flagging them', () async {
+      final first = writeFile('doc.0.0.txt', 'draft');
+      (await FileNode(first).backup()).unwrap();
+      writeFile('doc.0.5.txt', 'copied in by hand');
+      File(first)
+        ..writeAsStringSync('draft, edited later')
+        ..setLastModifiedSync(DateTime.now().add(const Duration(minutes: 1)));
+
+      final report = (await service.scrub(
+        targets: [ScrubTarget.family(first)],
+      )).unwrap();
+
+      expect(report.problemCount, 0);
+      expect(report.updatedCount, 1);
+      expect(report.recordedCount, 1);
+      expect(report.verifiedCount, 1);
+
+      final rerun = (await service.scrub(
+        targets: [ScrubTarget.family(first)],
+      )).unwrap();
+      expect(rerun.verifiedCount, 3);
+    });
+
+    test('follows snapshots into date shards after migration', () async {
+      final first = writeFile('doc.0.0.txt', 'sharded content');
+      final backupDir = path.join(tempDir.path, 'doc.0.0_bak');
+      final flat = [
+        for (final day in [1, 2])
+          snapshot(
+            first,
+            backupDir,
+            'doc.0.0.txt_2024-04-0${day}T08-00-00.bak.txt',
+          ),
+      ];
+      SnapshotIndex.migrateSync(backupDir);
+      final moved = SnapshotIndex.snapshotsSync(backupDir);
+
+      corrupt(moved.last.pathIn(backupDir), 'sharded c0ntent');
+      final report = (await service.scrub(
+        targets: [ScrubTarget.backupDirectory(backupDir)],
+      )).unwrap();
+
+      expect(File(flat.first).existsSync(), isFalse);
+      expect(report.fileCount, 2);
+      expect(report.verifiedCount, 1);
+      expect(report.missingCount, 0);
+      expect(report.problems.single.path, moved.last.pathIn(backupDir));
+      expect(report.problems.single.status, ScrubStatus.corrupted);
+    });
+
+    test('refuses to start while another scrub runs', () async {
+      writeFile('doc.0.0.txt', 'content');
+      monitored = ScrubTarget.forFile(path.join(tempDir.path, 'doc.0.0.txt'));
+
+      final running = service.scrub();
+      final second = await service.scrub();
+      expect(second.isErr, isTrue);
+      expect(service.status()['running'], isTrue);
+
+      expect((await running).isErr, isFalse);
+      expect(service.status()['running'], isFalse);
+      expect(service.status()['lastReport'], isNotNull);
+    });
+  });
+}
@@ -0,0 +1,107 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/service/LineDiffService.dart';
+
+void main() {
+  group('LineDiffHunk', () {
+    test('formats headers like unified diff', () {
+      const hunk = LineDiffHunk(
+        oldStart: 3,
+        oldCount: 1,
+        newStart: 2,
+        newCount: 0,
+        lines: [],
+      );
+      expect(hunk.header, '@@ -3 +2,0 @@');
+    });
+  });
+
+  // 需要先 `cmake -S native` 构建动态库，并用 VERTREE_NATIVE_LIBRARY 指向它
+  group('LineDiffService', () {
+    const service = LineDiffService();
+    late Directory tempDir;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_line_diff_');
+    });
+
+    tearDown(() async {
+      if (tempDir.existsSync()) {
+        await tempDir.delete(recursive: true);
+      }
+    });
+
+    Future<(String, String)> writePair(String oldText, String newText) async {
+      final oldPath = path.join(tempDir.path, 'doc.0.0.txt');
+      final newPath = path.join(tempDir.path, 'doc.0.1.txt');
+      await File(oldPath).writeAsString(oldText);
+      await File(newPath).writeAsString(newText);
+      return (oldPath, newPath);
+    }
+
+    test(
+      'returns structured hunks with 1-based line numbers',
+      () async {
+        final (oldPath, newPath) = await writePair(
+          'a\nb\nc\nd\n',
+          'a\nB\nc\nd\ne\n',
+        );
+        final result = await service.compare(oldPath, newPath);
+        final diff = result.unwrap();
+
+        expect(diff.removedLines, 1);
+        expect(diff.addedLines, 2);
+        expect(diff.truncated, isFalse);
+        expect(diff.hunks, hasLength(1));
+        expect(diff.hunks.single.header, '@@ -1,4 +1,5 @@');
+        final removed = diff.hunks.single.lines.firstWhere(
+          (line) => line.kind == LineDiffLineKind.removed,
+        );
+        expect(removed.text, 'b');
+        expect(removed.oldLine, 2);
+        expect(removed.newLine, isNull);
+      },
+      skip: service.isAvailable ? false : LineDiffService.unavailableMessage,
+    );
+
+    test(
+      'truncates structured output at the line budget',
+      () async {
+        final (oldPath, newPath) = await writePair(
+          List.generate(100, (i) => 'old $i\n').join(),
+          List.generate(100, (i) => 'new $i\n').join(),
+        );
+        final diff = (await service.compare(
+          oldPath,
+          newPath,
+          maxLines: 10,
+        )).unwrap();
+
+        expect(diff.truncated, isTrue);
+        expect(diff.hunkCount, 1);
+        expect(diff.hunks.single.lines, hasLength(10));
+      },
+      skip: service.isAvailable ? false : LineDiffService.unavailableMessage,
+    );
+
+    test(
+      'streams unified output and reports errors as stream events',
+      () async {
+        final (oldPath, newPath) = await writePair('x\n', 'y\n');
+        final text = await utf8.decodeStream(
+          service.unified(oldPath, newPath),
+        );
+        expect(text, '@@ -1 +1 @@\n-x\n+y\n');
+
+        expect(
+          service.unified(oldPath, path.join(tempDir.path, 'missing')).drain(),
+          throwsA(isA<LineDiffException>()),
+        );
+      },
+      skip: service.isAvailable ? false : LineDiffService.unavailableMessage,
+    );
+  });
+}
@@ -0,0 +1,165 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/service/LiveVersionTree.dart';
+
+void main() {
+  group('LiveVersionTree', () {
+    late Directory tempDir;
+    late StreamController<FileSystemEvent> watchEvents;
+    late FileNode root;
+    late LiveVersionTree liveTree;
+
+    String filePath(String name) => path.join(tempDir.path, name);
+
+    String write(String name) {
+      File(filePath(name)).writeAsStringSync(name);
+      return filePath(name);
+    }
+
+    Future<void> expectSameAsRebuilt() async {
+      final rebuilt = (await buildTree(liveTree.root!.mate.fullPath)).unwrap();
+      expect(liveTree.root!.toTreeString(), rebuilt.toTreeString());
+    }
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_live_tree_');
+      for (final name in [
+        'doc.0.0.txt',
+        'doc.0.1.txt',
+        'doc.0.2.txt',
+        'doc.0.1-1.0.txt',
+        'notes.0.0.txt',
+      ]) {
+        write(name);
+      }
+      watchEvents = StreamController<FileSystemEvent>.broadcast();
+      root = (await buildTree(filePath('doc.0.0.txt'))).unwrap();
+      liveTree = LiveVersionTree(
+        root,
+        watchDirectory: (_) => watchEvents.stream,
+        debounce: const Duration(milliseconds: 20),
+      );
+      await liveTree.start();
+    });
+
+    tearDown(() async {
+      await liveTree.dispose();
+      await watchEvents.close();
+      await tempDir.delete(recursive: true);
+    });
+
+    test('attaches new versions and branches to the existing nodes', () async {
+      final mainline = root.child!;
+      final update = await liveTree.applyPaths([
+        write('doc.0.3.txt'),
+        write('doc.0.1-1.1.txt'),
+        write('doc.0.2-1.0.txt'),
+        write('notes.0.1.txt'),
+      ]);
+
+      expect(update.rootReplaced, isFalse);
+      expect(liveTree.root, same(root));
+      expect(root.child, same(mainline));
+      expect(update.inserted.map((node) => node.mate.version.toString()), [
+        '0.1-1.1',
+        '0.2-1.0',
+        '0.3',
+      ]);
+      expect(mainline.child!.child!.mate.fullName, 'doc.0.3.txt');
+      expect(mainline.child!.branchIndex, 1);
+      await expectSameAsRebuilt();
+    });
+
+    test('removes leaves and follows renames in place', () async {
+      final branch = root.child!.branches.single;
+      final mainTail = root.child!.child!;
+      File(filePath('doc.0.1-1.0.txt')).deleteSync();
+      File(
+        filePath('doc.0.2.txt'),
+      ).renameSync(filePath('doc#final.0.2.txt'));
+
+      final update = await liveTree.applyPaths([
+        filePath('doc.0.1-1.0.txt'),
+        filePath('doc.0.2.txt'),
+        filePath('doc#final.0.2.txt'),
+      ]);
+
+      expect(update.rootReplaced, isFalse);
+      expect(update.removed, [branch]);
+      expect(update.renamed, [mainTail]);
+      expect(root.child!.branches, isEmpty);
+      expect(root.child!.branchIndex, -1);
+      expect(root.child!.child, same(mainTail));
+      expect(mainTail.mate.label, 'final');
+      expect(liveTree.nodeForPath(filePath('doc#final.0.2.txt')), mainTail);
+      await expectSameAsRebuilt();
+    });
+
+    test('reassembles when a middle version disappears', () async {
+      File(filePath('doc.0.1.txt')).deleteSync();
+
+      final update = await liveTree.applyPaths([filePath('doc.0.1.txt')]);
+
+      expect(update.rootReplaced, isTrue);
+      expect(update.root!.child, isNull);
+      await expectSameAsRebuilt();
+
+      // 补回中间版本后，之前挂不上的版本重新接上
+      write('doc.0.1.txt');
+      final restored = await liveTree.applyPaths([filePath('doc.0.1.txt')]);
+
+      expect(restored.rootReplaced, isTrue);
+      expect(restored.root!.child!.child!.mate.version.toString(), '0.2');
+      await expectSameAsRebuilt();
+    });
+
+    test('reassembles when the root changes', () async {
+      File(filePath('doc.0.0.txt')).deleteSync();
+
+      final update = await liveTree.applyPaths([filePath('doc.0.0.txt')]);
+
+      expect(update.rootReplaced, isTrue);
+      expect(update.root!.mate.version.toString(), '0.1');
+      await expectSameAsRebuilt();
+
+      write('doc.0.0.txt');
+      final restored = await liveTree.applyPaths([filePath('doc.0.0.txt')]);
+
+      expect(restored.rootReplaced, isTrue);
+      expect(restored.root!.mate.version.toString(), '0.0');
+      await expectSameAsRebuilt();
+    });
+
+    test('ignores versions already added by the tree itself', () async {
+      final created = (await root.child!.child!.backup()).unwrap();
+
+      final update = await liveTree.applyPaths([created.mate.fullPath]);
+
+      expect(update.inserted, isEmpty);
+      expect(update.updated, [created]);
+      expect(root.child!.child!.child, same(created));
+    });
+
+    test('batches watch events into one update', () async {
+      final updates = <LiveVersionTreeUpdate>[];
+      final subscription = liveTree.updates.listen(updates.add);
+      addTearDown(subscription.cancel);
+
+      final created = write('doc.0.3.txt');
+      watchEvents
+        ..add(FileSystemCreateEvent(created, false))
+        ..add(FileSystemModifyEvent(created, false, true))
+        ..add(FileSystemCreateEvent(write('doc.0.4.txt'), false));
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+
+      expect(updates, hasLength(1));
+      expect(updates.single.inserted, hasLength(2));
+      await expectSameAsRebuilt();
+    });
+  });
+}
@@ -0,0 +1,135 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/DiskUsageService.dart';
+import 'package:vertree/service/ShellIndexService.dart';
+
+void main() {
+  group('ShellIndexService', () {
+    late Directory tempDir;
+    late List<DiskUsageTarget> monitored;
+    late ActivityEventHub hub;
+    late StreamController<String> createdVersions;
+    late ShellIndexService service;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_shell_index_');
+      monitored = [];
+      hub = ActivityEventHub();
+      createdVersions = StreamController<String>.broadcast();
+      service = ShellIndexService(
+        targetsResolver: () => monitored,
+        activityEvents: hub.stream,
+        createdVersions: createdVersions.stream,
+      );
+    });
+
+    tearDown(() async {
+      await service.dispose();
+      await createdVersions.close();
+      await tempDir.delete(recursive: true);
+    });
+
+    String writeFile(String name, DateTime modified) {
+      final file = File(path.join(tempDir.path, name));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(name);
+      file.setLastModifiedSync(modified);
+      return file.path;
+    }
+
+    test('reports version families and skips lone files', () async {
+      writeFile('report.0.0.docx', DateTime(2024, 1, 1));
+      writeFile('report.0.1.docx', DateTime(2024, 1, 2));
+      writeFile('report.1.0.docx', DateTime(2024, 1, 3));
+      writeFile('report.0.0.pdf', DateTime(2024, 1, 4));
+      writeFile('notes.txt', DateTime(2024, 1, 5));
+      writeFile('.hidden.0.1.txt', DateTime(2024, 1, 6));
+      writeFile('.hidden.0.2.txt', DateTime(2024, 1, 7));
+
+      final entries = await service.directory(tempDir.path);
+
+      expect(
+        entries.keys,
+        unorderedEquals([
+          'report.0.0.docx',
+          'report.0.1.docx',
+          'report.1.0.docx',
+        ]),
+      );
+      expect(entries['report.1.0.docx']!.versionCount, 3);
+      expect(entries['report.1.0.docx']!.lastBackupAt, DateTime(2024, 1, 2));
+      expect(entries['report.0.0.docx']!.lastBackupAt, DateTime(2024, 1, 3));
+      expect(entries['report.0.1.docx']!.monitored, isFalse);
+    });
+
+    test('marks monitored files with their newest snapshot', () async {
+      final filePath = writeFile('scene.blend', DateTime(2024, 2, 1));
+      final backupDir = path.join(tempDir.path, 'scene_bak');
+      writeFile('scene_bak/scene_1.blend', DateTime(2024, 2, 2));
+      writeFile('scene_bak/scene_2.blend', DateTime(2024, 2, 3));
+      monitored.add(
+        DiskUsageTarget(filePath: filePath, backupDirPath: backupDir),
+      );
+
+      final entries = await service.directory(tempDir.path);
+
+      expect(
+        entries['scene.blend'],
+        ShellFileStatus(
+          versionCount: 1,
+          monitored: true,
+          lastBackupAt: DateTime(2024, 2, 3),
+        ),
+      );
+    });
+
+    test('snapshot events drop the cached directory', () async {
+      final filePath = writeFile('scene.blend', DateTime(2024, 2, 1));
+      final backupDir = path.join(tempDir.path, 'scene_bak');
+      Directory(backupDir).createSync();
+      monitored.add(
+        DiskUsageTarget(filePath: filePath, backupDirPath: backupDir),
+      );
+      final changed = <String>[];
+      final subscription = service.changedDirectories.listen(changed.add);
+      addTearDown(subscription.cancel);
+
+      final before = await service.directory(tempDir.path);
+      expect(before['scene.blend']!.lastBackupAt, isNull);
+
+      // 快照写在 _bak 子目录里，目录本身的修改时间不变
+      writeFile('scene_bak/scene_1.blend', DateTime(2024, 2, 2));
+      hub.emit(ActivityEventType.snapshotFinished, {
+        'filePath': filePath,
+        'success': true,
+      });
+      await Future<void>.delayed(Duration.zero);
+
+      expect(changed, [path.normalize(tempDir.path)]);
+      final after = await service.directory(tempDir.path);
+      expect(after['scene.blend']!.lastBackupAt, DateTime(2024, 2, 2));
+    });
+
+    test('created versions notify their directory', () async {
+      final changed = <String>[];
+      final subscription = service.changedDirectories.listen(changed.add);
+      addTearDown(subscription.cancel);
+
+      createdVersions.add(path.join(tempDir.path, 'report.0.2.docx'));
+      await Future<void>.delayed(Duration.zero);
+
+      expect(changed, [path.normalize(tempDir.path)]);
+    });
+
+    test('answers nothing for missing directories', () async {
+      final entries = await service.directory(
+        path.join(tempDir.path, 'missing'),
+      );
+      expect(entries, isEmpty);
+    });
+  });
+}
@@ -0,0 +1,92 @@
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/service/ThumbnailPack.dart';
+
+void main() {
+  group('ThumbnailPack', () {
+    late Directory tempDir;
+    late String packPath;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_thumb_pack_');
+      packPath = path.join(tempDir.path, 'thumbnails.pack');
+    });
+
+    tearDown(() async {
+      if (tempDir.existsSync()) {
+        await tempDir.delete(recursive: true);
+      }
+    });
+
+    Uint8List bytesOf(int length, int seed) {
+      return Uint8List.fromList(
+        List<int>.generate(length, (index) => (index * 31 + seed) & 0xff),
+      );
+    }
+
+    test('reads back records after reopening with aligned records', () async {
+      final pack = ThumbnailPack(packPath);
+      await pack.open();
+      await pack.write('a', bytesOf(13, 1));
+      await pack.write('b', bytesOf(300, 2));
+      await pack.write('a', bytesOf(21, 3));
+      await pack.close();
+
+      expect(File(packPath).lengthSync() % ThumbnailPack.alignment, 0);
+
+      final reopened = ThumbnailPack(packPath);
+      await reopened.open();
+      expect(reopened.entryCount, 2);
+      expect(await reopened.read('a'), bytesOf(21, 3));
+      expect(await reopened.read('b'), bytesOf(300, 2));
+      expect(await reopened.read('missing'), isNull);
+      await reopened.close();
+    });
+
+    test('drops a torn trailing record on open', () async {
+      final pack = ThumbnailPack(packPath);
+      await pack.open();
+      await pack.write('kept', bytesOf(64, 4));
+      await pack.close();
+
+      final intactLength = File(packPath).lengthSync();
+      final raf = File(packPath).openSync(mode: FileMode.append);
+      raf.writeFromSync([0x56, 0x54, 0x48, 0x52, 10, 0, 0, 0, 99, 0]);
+      raf.closeSync();
+
+      final reopened = ThumbnailPack(packPath);
+      await reopened.open();
+      expect(reopened.entryCount, 1);
+      expect(reopened.fileBytes, intactLength);
+      expect(await reopened.read('kept'), bytesOf(64, 4));
+      await reopened.close();
+    });
+
+    test('compacts to the most recently used entries when full', () async {
+      final pack = ThumbnailPack(packPath, maxBytes: 4096);
+      await pack.open();
+      for (var index = 0; index < 12; index++) {
+        await pack.write('entry-$index', bytesOf(400, index));
+        if (index == 8) {
+          // 读取会刷新最近使用顺序，下一次写入触发压缩时它应被保留
+          await pack.read('entry-0');
+        }
+      }
+
+      expect(pack.fileBytes, lessThanOrEqualTo(4096));
+      expect(pack.contains('entry-11'), isTrue);
+      expect(pack.contains('entry-0'), isTrue);
+      expect(pack.contains('entry-1'), isFalse);
+      expect(await pack.read('entry-11'), bytesOf(400, 11));
+      await pack.close();
+
+      final reopened = ThumbnailPack(packPath, maxBytes: 4096);
+      await reopened.open();
+      expect(await reopened.read('entry-11'), bytesOf(400, 11));
+      await reopened.close();
+    });
+  });
+}
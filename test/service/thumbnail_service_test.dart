@@ -0,0 +1,71 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:vertree/service/ThumbnailService.dart';
+
+class _FakeGenerator implements ThumbnailGenerator {
+  final List<String> generated = [];
+
+  @override
+  bool supports(String filePath) => filePath.endsWith('.png');
+
+  @override
+  Future<Uint8List?> generate(String filePath, int maxDimension) async {
+    generated.add(filePath);
+    return Uint8List.fromList(filePath.codeUnits);
+  }
+}
+
+void main() {
+  group('ThumbnailService', () {
+    late _FakeGenerator generator;
+    late Completer<void> idle;
+    late ThumbnailService service;
+    final modifiedAt = DateTime.utc(2025, 1, 1);
+
+    setUp(() {
+      generator = _FakeGenerator();
+      idle = Completer<void>();
+      service = ThumbnailService(
+        generators: [generator],
+        openPack: () async => null,
+        yieldToIdle: () => idle.future,
+        maxConcurrentJobs: 1,
+      );
+    });
+
+    test('shares one job per key and then serves from memory', () async {
+      final first = service.request('/a.png', 10, modifiedAt);
+      final second = service.request('/a.png', 10, modifiedAt);
+      idle.complete();
+
+      expect(await first.result, isNotNull);
+      expect(await second.result, isNotNull);
+      expect(generator.generated, ['/a.png']);
+      expect(service.peek('/a.png', 10, modifiedAt), isNotNull);
+      expect(service.peek('/a.png', 11, modifiedAt), isNull);
+    });
+
+    test('drops queued jobs whose requests were all cancelled', () async {
+      final running = service.request('/running.png', 1, modifiedAt);
+      final scrolledAway = service.request('/gone.png', 1, modifiedAt);
+      final visible = service.request('/visible.png', 1, modifiedAt);
+
+      scrolledAway.cancel();
+      idle.complete();
+
+      expect(await running.result, isNotNull);
+      expect(await scrolledAway.result, isNull);
+      expect(await visible.result, isNotNull);
+      expect(generator.generated, isNot(contains('/gone.png')));
+      expect(service.status()['cancelled'], 1);
+    });
+
+    test('ignores unsupported files', () async {
+      final request = service.request('/notes.txt', 1, modifiedAt);
+      expect(await request.result, isNull);
+      expect(generator.generated, isEmpty);
+    });
+  });
+}
@@ -0,0 +1,106 @@
+import 'dart:convert';
+
+import 'package:test/test.dart';
+import 'package:vertree/service/TrigramIndex.dart';
+
+void main() {
+  group('TrigramIndex', () {
+    TrigramIndex build(Map<String, String> documents) {
+      final index = TrigramIndex();
+      documents.forEach((path, text) => index.add(path, utf8.encode(text)));
+      return index;
+    }
+
+    test('returns documents holding every trigram of every literal', () {
+      final index = build({
+        'a': 'The opening scene starts at dawn',
+        'b': 'The OPENING scene was cut',
+        'c': 'Closing credits',
+      });
+
+      expect(index.candidates(['opening scene']), ['a', 'b']);
+      expect(index.candidates(['opening', 'dawn']), ['a']);
+      expect(index.candidates(['credits']), ['c']);
+      expect(index.candidates(['missing']), isEmpty);
+      // 短于三个字节的字面量无法筛选，所有文档都是候选
+      expect(index.candidates(['at']), ['a', 'b', 'c']);
+      expect(index.candidates([]), ['a', 'b', 'c']);
+    });
+
+    test('stores similar consecutive documents as shared runs', () {
+      final index = TrigramIndex();
+      for (var version = 0; version < 100; version++) {
+        index.add('v$version', utf8.encode('shared body text'));
+      }
+
+      expect(index.documentCount, 100);
+      expect(index.runCount, index.trigramCount);
+      expect(index.candidates(['body']), hasLength(100));
+    });
+
+    test('replaces, removes and compacts documents', () {
+      final index = build({
+        'a': 'alpha beta',
+        'b': 'alpha gamma',
+        'c': 'alpha delta',
+      });
+      index
+        ..add('a', utf8.encode('alpha epsilon'))
+        ..remove('b');
+
+      expect(index.candidates(['beta']), isEmpty);
+      expect(index.candidates(['alpha']), ['c', 'a']);
+      expect(index.removedCount, 2);
+
+      index.compact();
+      expect(index.removedCount, 0);
+      expect(index.documentCount, 2);
+      expect(index.candidates(['alpha']), ['c', 'a']);
+      expect(index.candidates(['epsilon']), ['a']);
+      expect(index.candidates(['gamma']), isEmpty);
+
+      index.add('d', utf8.encode('alpha'));
+      expect(index.candidates(['alpha']), ['c', 'a', 'd']);
+    });
+  });
+
+  group('requiredRegexLiterals', () {
+    test('keeps literal runs that every match must contain', () {
+      expect(requiredRegexLiterals('foo.*bar'), ['foo', 'bar']);
+      expect(requiredRegexLiterals('colou?r'), ['colo', 'r']);
+      expect(requiredRegexLiterals('a+bc'), ['a', 'bc']);
+      expect(requiredRegexLiterals('x{2}yz'), ['x', 'yz']);
+      expect(requiredRegexLiterals('x{0,2}yz'), ['yz']);
+      expect(requiredRegexLiterals(r'^chapter\s+\d+\.txt$'), [
+        'chapter',
+        '.txt',
+      ]);
+      expect(requiredRegexLiterals(r'[abc]xyz(?:one|two)end'), [
+        'xyz',
+        'end',
+      ]);
+    });
+
+    test('does not treat escape payloads as literals', () {
+      expect(requiredRegexLiterals(r'\x41bcd'), ['bcd']);
+      expect(requiredRegexLiterals(r'\u0041bcd'), ['bcd']);
+      expect(requiredRegexLiterals(r'(a)\1bcd'), ['bcd']);
+    });
+
+    test('gives up on top-level alternation', () {
+      expect(requiredRegexLiterals('foo|bar'), isEmpty);
+    });
+
+    test('splits at non-ASCII characters when ignoring case', () {
+      expect(
+        requiredRegexLiterals('Café menu', caseSensitive: false),
+        ['Caf', ' menu'],
+      );
+      expect(foldableLiterals('Café menu', caseSensitive: false), [
+        'Caf',
+        ' menu',
+      ]);
+      expect(foldableLiterals('Café menu'), ['Café menu']);
+    });
+  });
+}
@@ -0,0 +1,133 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/service/TrigramIndex.dart';
+import 'package:vertree/service/VersionSearchService.dart';
+
+/// 在 1k / 5k 个版本上测量三元组索引的体积与筛选耗时，并在 2k 个真实文件上
+/// 测量包括读取确认在内的端到端查询耗时。
+///
+/// 运行 `dart test test/service/version_search_benchmark_test.dart` 查看输出。
+void main() {
+  const marker = 'the lighthouse keeper counted ships';
+
+  for (final versionCount in const [1000, 5000]) {
+    test('indexes $versionCount versions and filters candidates', () {
+      final index = TrigramIndex();
+      var sourceBytes = 0;
+      final build = Stopwatch()..start();
+      for (final (version, text) in _evolve(versionCount, marker)) {
+        final bytes = utf8.encode(text);
+        sourceBytes += bytes.length;
+        index.add('doc.0.$version.txt', bytes);
+      }
+      build.stop();
+
+      double medianMicros(List<String> literals) {
+        final samples = <int>[];
+        for (var round = 0; round < 21; round++) {
+          final stopwatch = Stopwatch()..start();
+          index.candidates(literals);
+          samples.add(stopwatch.elapsedMicroseconds);
+        }
+        samples.sort();
+        return samples[samples.length ~/ 2].toDouble();
+      }
+
+      final substring = index.candidates(['lighthouse keeper']);
+      final regex = index.candidates(
+        requiredRegexLiterals(r'light\w+ keeper counted'),
+      );
+      // ignore: avoid_print
+      print(
+        'TrigramIndex versions=$versionCount '
+        'sourceMB=${(sourceBytes / 1048576).toStringAsFixed(1)} '
+        'buildMs=${build.elapsedMilliseconds} '
+        'trigrams=${index.trigramCount} runs=${index.runCount} '
+        'postingKB=${(index.postingBytes / 1024).toStringAsFixed(0)} '
+        'substringUs=${medianMicros(['lighthouse keeper'])} '
+        'regexUs=${medianMicros(requiredRegexLiterals(r'light\w+ keeper'))} '
+        'candidates=${substring.length}/${regex.length}',
+      );
+
+      // 标记句只出现在 100 个版本中；随机词汇可能凑出少量假阳性
+      expect(substring.length, inInclusiveRange(100, 150));
+      expect(regex.length, inInclusiveRange(100, 150));
+      // 相邻版本共享区间，倒排表远小于原文
+      expect(index.postingBytes, lessThan(sourceBytes ~/ 20));
+    });
+  }
+
+  test('searches 2000 version files end to end', () async {
+    final tempDir = await Directory.systemTemp.createTemp('vertree_search_');
+    addTearDown(() => tempDir.delete(recursive: true));
+    final service = VersionSearchService(
+      rescanInterval: const Duration(hours: 1),
+    );
+    addTearDown(service.dispose);
+
+    for (final (version, text) in _evolve(2000, marker)) {
+      File(
+        path.join(tempDir.path, 'doc.0.$version.txt'),
+      ).writeAsStringSync(text);
+    }
+    final firstPath = path.join(tempDir.path, 'doc.0.0.txt');
+
+    Future<(VersionSearchResult, int)> timed(VersionSearchQuery query) async {
+      final stopwatch = Stopwatch()..start();
+      final result = (await service.search(firstPath, query)).unwrap();
+      return (result, stopwatch.elapsedMilliseconds);
+    }
+
+    final (cold, coldMs) = await timed(const VersionSearchQuery(text: marker));
+    final (warm, warmMs) = await timed(const VersionSearchQuery(text: marker));
+    final (regex, regexMs) = await timed(
+      const VersionSearchQuery(text: r'lighthouse \w+ counted', regex: true),
+    );
+    // ignore: avoid_print
+    print(
+      'VersionSearchService versions=2000 '
+      'coldMs=$coldMs warmMs=$warmMs regexMs=$regexMs '
+      'warm: filterUs=${warm.filterElapsed.inMicroseconds} '
+      'verifyMs=${warm.verifyElapsed.inMilliseconds} '
+      'candidates=${warm.candidateCount} '
+      'postingKB=${(warm.index['postingBytes'] as int) ~/ 1024}',
+    );
+
+    expect(cold.matches, hasLength(100));
+    expect(warm.matches, hasLength(100));
+    expect(regex.matches, hasLength(100));
+    expect(warm.documentCount, 2000);
+  });
+}
+
+/// 模拟一份不断修改的文档：每个版本改写两行，每十个版本新增一行；
+/// 第 300 ~ 399 个版本的开头多出一句 [marker]
+Iterable<(int, String)> _evolve(int versionCount, String marker) sync* {
+  final random = Random(7);
+  final vocabulary = List.generate(400, (_) {
+    final length = 3 + random.nextInt(7);
+    return String.fromCharCodes(
+      List.generate(length, (_) => 0x61 + random.nextInt(26)),
+    );
+  });
+  String sentence() => List.generate(
+    8,
+    (_) => vocabulary[random.nextInt(vocabulary.length)],
+  ).join(' ');
+
+  final lines = List.generate(300, (_) => sentence());
+  for (var version = 0; version < versionCount; version++) {
+    for (var edit = 0; edit < 2; edit++) {
+      lines[random.nextInt(lines.length)] = sentence();
+    }
+    if (version % 10 == 0) {
+      lines.insert(random.nextInt(lines.length), sentence());
+    }
+    final hasMarker = version >= 300 && version < 400;
+    yield (version, '${hasMarker ? '$marker\n' : ''}${lines.join('\n')}\n');
+  }
+}
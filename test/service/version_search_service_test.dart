@@ -0,0 +1,173 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/FileVersionTree.dart';
+import 'package:vertree/service/ActivityEventHub.dart';
+import 'package:vertree/service/VersionSearchService.dart';
+
+void main() {
+  group('VersionSearchService', () {
+    late Directory tempDir;
+    late StreamController<ActivityEvent> events;
+    late VersionSearchService service;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_search_');
+      events = StreamController<ActivityEvent>.broadcast();
+      service = VersionSearchService(
+        activityEvents: events.stream,
+        rescanInterval: const Duration(hours: 1),
+      );
+    });
+
+    tearDown(() async {
+      service.dispose();
+      await events.close();
+      if (tempDir.existsSync()) {
+        await tempDir.delete(recursive: true);
+      }
+    });
+
+    String writeFile(String name, String content) {
+      final file = File(path.join(tempDir.path, name));
+      file.parent.createSync(recursive: true);
+      file.writeAsStringSync(content);
+      return file.path;
+    }
+
+    Future<VersionSearchResult> search(
+      String filePath,
+      String text, {
+      bool regex = false,
+      bool caseSensitive = false,
+      bool includeBackups = false,
+      int maxResults = 200,
+    }) async {
+      final result = await service.search(
+        filePath,
+        VersionSearchQuery(
+          text: text,
+          regex: regex,
+          caseSensitive: caseSensitive,
+          includeBackups: includeBackups,
+          maxResults: maxResults,
+        ),
+      );
+      return result.unwrap();
+    }
+
+    List<String> names(VersionSearchResult result) {
+      return result.matches.map((match) => path.basename(match.path)).toList();
+    }
+
+    test('finds versions by substring and reports matching lines', () async {
+      final first = writeFile('doc.0.0.txt', 'intro\nThe old paragraph\n');
+      writeFile('doc.0.1.txt', 'intro\nthe OLD paragraph, edited\n');
+      writeFile('doc.0.2.txt', 'intro\nA new paragraph\n');
+      writeFile('other.0.0.txt', 'The old paragraph\n');
+
+      final result = await search(first, 'old paragraph');
+
+      expect(names(result), ['doc.0.0.txt', 'doc.0.1.txt']);
+      expect(result.documentCount, 3);
+      expect(result.candidateCount, 2);
+      expect(result.matches.first.snippets.single.line, 2);
+      expect(result.matches.first.snippets.single.text, 'The old paragraph');
+      expect(result.matchedPaths, contains(first));
+
+      final exact = await search(first, 'OLD', caseSensitive: true);
+      expect(names(exact), ['doc.0.1.txt']);
+    });
+
+    test('verifies regex candidates against the content', () async {
+      final first = writeFile('doc.0.0.txt', 'total: 12 items\n');
+      writeFile('doc.0.1.txt', 'total: many items\n');
+      writeFile('doc.0.0-0.0.txt', 'Total: 7 items\ntotal: 8 items\n');
+
+      final result = await search(first, r'total: \d+ items', regex: true);
+
+      expect(names(result), ['doc.0.0.txt', 'doc.0.0-0.0.txt']);
+      expect(result.candidateCount, 3);
+      expect(result.matches.last.matchCount, 2);
+      expect(result.matches.last.snippets.map((s) => s.line), [1, 2]);
+
+      final invalid = await service.search(
+        first,
+        const VersionSearchQuery(text: '(unclosed', regex: true),
+      );
+      expect(invalid.isErr, isTrue);
+      final empty = await service.search(
+        first,
+        const VersionSearchQuery(text: ''),
+      );
+      expect(empty.isErr, isTrue);
+    });
+
+    test('skips binary files and truncates at the result limit', () async {
+      final first = writeFile('doc.0.0.txt', 'needle\n');
+      for (var revision = 1; revision < 5; revision++) {
+        writeFile('doc.0.$revision.txt', 'needle $revision\n');
+      }
+      File(
+        path.join(tempDir.path, 'doc.0.5.txt'),
+      ).writeAsBytesSync([0x6e, 0x65, 0x65, 0x64, 0x6c, 0x65, 0]);
+
+      final result = await search(first, 'needle', maxResults: 3);
+
+      expect(result.documentCount, 5);
+      expect(result.matches, hasLength(3));
+      expect(result.truncated, isTrue);
+    });
+
+    test('indexes versions created by backup without a rescan', () async {
+      final first = writeFile('doc.0.0.txt', 'first draft\n');
+      expect(await search(first, 'draft'), isNotNull);
+
+      final node = FileNode(first);
+      File(first).writeAsStringSync('second draft\n');
+      (await node.backup()).unwrap();
+      await Future<void>.delayed(Duration.zero);
+
+      final result = await search(first, 'second draft');
+      // 源文件本身的修改要等到下一次全量核对才会被发现
+      expect(names(result), ['doc.0.1.txt']);
+    });
+
+    test('includes monitor snapshots only when asked', () async {
+      final first = writeFile('doc.0.0.txt', 'current text\n');
+      writeFile(path.join('doc.0.0_bak', 'old.bak.txt'), 'lost sentence\n');
+
+      expect((await search(first, 'lost sentence')).matches, isEmpty);
+      final withBackups = await search(
+        first,
+        'lost sentence',
+        includeBackups: true,
+      );
+      expect(withBackups.matches.single.isBackup, isTrue);
+
+      final snapshot = writeFile(
+        path.join('custom_bak', 'doc.bak.txt'),
+        'another lost sentence\n',
+      );
+      events.add(
+        ActivityEvent(
+          id: 1,
+          type: ActivityEventType.snapshotFinished,
+          occurredAt: DateTime.now(),
+          data: {'filePath': first, 'backupPath': snapshot, 'success': true},
+        ),
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      final updated = await search(
+        first,
+        'lost sentence',
+        includeBackups: true,
+      );
+      expect(updated.matches, hasLength(2));
+      expect(updated.matches.every((match) => match.isBackup), isTrue);
+    });
+  });
+}
@@ -0,0 +1,197 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+import 'package:test/test.dart';
+import 'package:vertree/core/TreeBuilder.dart';
+import 'package:vertree/service/VersionTreeCache.dart';
+
+void main() {
+  group('VersionTreeCache', () {
+    late Directory tempDir;
+    late String selectedPath;
+    late StreamController<FileSystemEvent> watchEvents;
+    late int buildCount;
+    late VersionTreeCache cache;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('vertree_tree_cache_');
+      await _copyDirectory(
+        Directory(
+          path.join(
+            Directory.current.path,
+            '.sample',
+            'file_version_tree',
+            'storyboard',
+          ),
+        ),
+        tempDir,
+      );
+      selectedPath = path.join(tempDir.path, 'storyboard.0.0.txt');
+      watchEvents = StreamController<FileSystemEvent>.broadcast();
+      buildCount = 0;
+      cache = VersionTreeCache(
+        builder: (filePath) {
+          buildCount += 1;
+          return buildTree(filePath);
+        },
+        watchDirectory: (_) => watchEvents.stream,
+      );
+    });
+
+    tearDown(() async {
+      await cache.clear();
+      await watchEvents.close();
+      if (tempDir.existsSync()) {
+        await tempDir.delete(recursive: true);
+      }
+    });
+
+    test('reuses the tree and ETag until the directory changes', () async {
+      expect(cache.peekETag(selectedPath), isNull);
+
+      final first = (await cache.load(selectedPath)).unwrap();
+      final second = (await cache.load(selectedPath)).unwrap();
+
+      expect(buildCount, 1);
+      expect(second.etag, first.etag);
+      expect(cache.peekETag(selectedPath), first.etag);
+
+      await File(
+        path.join(tempDir.path, 'storyboard.0.3.txt'),
+      ).writeAsString('new version');
+      watchEvents.add(
+        FileSystemCreateEvent(
+          path.join(tempDir.path, 'storyboard.0.3.txt'),
+          false,
+        ),
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      expect(cache.peekETag(selectedPath), isNull);
+      final rebuilt = (await cache.load(selectedPath)).unwrap();
+      expect(buildCount, 2);
+      expect(rebuilt.etag, isNot(first.etag));
+    });
+
+    test('pages through flat nodes with cursors', () async {
+      final snapshot = (await cache.load(selectedPath)).unwrap();
+      final totalNodes = snapshot.summary['totalNodes'] as int;
+
+      final versions = <String>[];
+      String? cursor;
+      do {
+        final query = VersionTreeQuery(flat: true, limit: 5, cursor: cursor);
+        final page = _decode(snapshot.render(query).unwrap());
+        final nodes = page['nodes'] as List;
+        expect(nodes.length, lessThanOrEqualTo(5));
+        versions.addAll(nodes.map((node) => node['version'] as String));
+        cursor = page['page']['nextCursor'] as String?;
+      } while (cursor != null);
+
+      expect(versions.length, totalNodes);
+      expect(versions.toSet().length, totalNodes);
+      expect(versions.first, '0.0');
+    });
+
+    test('limits branch depth and reports truncated branches', () async {
+      final snapshot = (await cache.load(selectedPath)).unwrap();
+
+      final page = _decode(
+        snapshot
+            .render(const VersionTreeQuery(flat: true, maxDepth: 0))
+            .unwrap(),
+      );
+      final nodes = (page['nodes'] as List).cast<Map<String, dynamic>>();
+
+      expect(nodes.map((node) => node['version']), ['0.0', '0.1', '0.2']);
+      expect(nodes.every((node) => node['relation'] != 'branch'), isTrue);
+      expect(nodes[1]['truncatedBranchCount'], greaterThan(0));
+
+      final nested = _decode(
+        snapshot.render(const VersionTreeQuery(maxBranches: 1)).unwrap(),
+      );
+      final mainChild = nested['root']['child'] as Map<String, dynamic>;
+      expect(mainChild['branches'], hasLength(1));
+      expect(mainChild['truncatedBranchCount'], greaterThan(0));
+    });
+
+    test('adds change estimates only when requested', () async {
+      final snapshot = (await cache.load(selectedPath)).unwrap();
+      final childPath = snapshot.root.child!.mate.fullPath;
+      snapshot.changeEstimates = {childPath: 0.123456};
+
+      final plain = _decode(
+        snapshot.render(const VersionTreeQuery(flat: true)).unwrap(),
+      );
+      expect(
+        (plain['nodes'] as List).first as Map<String, dynamic>,
+        isNot(contains('changeFromParent')),
+      );
+
+      final flat = _decode(
+        snapshot
+            .render(const VersionTreeQuery(flat: true, includeChanges: true))
+            .unwrap(),
+      );
+      final nodes = (flat['nodes'] as List).cast<Map<String, dynamic>>();
+      expect(nodes[0]['changeFromParent'], isNull);
+      expect(nodes[0], contains('changeFromParent'));
+      final child = nodes.firstWhere((node) => node['path'] == childPath);
+      expect(child['changeFromParent'], 0.1235);
+
+      final nested = _decode(
+        snapshot.render(const VersionTreeQuery(includeChanges: true)).unwrap(),
+      );
+      expect(nested['root']['child']['changeFromParent'], 0.1235);
+    });
+
+    test('rejects cursors issued for a different tree state', () async {
+      final snapshot = (await cache.load(selectedPath)).unwrap();
+      final firstPage = _decode(
+        snapshot.render(const VersionTreeQuery(flat: true, limit: 2)).unwrap(),
+      );
+      final cursor = firstPage['page']['nextCursor'] as String;
+
+      await File(
+        path.join(tempDir.path, 'storyboard.0.3.txt'),
+      ).writeAsString('new version');
+      watchEvents.add(
+        FileSystemCreateEvent(
+          path.join(tempDir.path, 'storyboard.0.3.txt'),
+          false,
+        ),
+      );
+      await Future<void>.delayed(Duration.zero);
+
+      final rebuilt = (await cache.load(selectedPath)).unwrap();
+      final result = rebuilt.render(
+        VersionTreeQuery(flat: true, limit: 2, cursor: cursor),
+      );
+
+      expect(result.isErr, isTrue);
+      expect(
+        rebuilt.render(const VersionTreeQuery(flat: true, cursor: 'x')).isErr,
+        isTrue,
+      );
+    });
+  });
+}
+
+Map<String, dynamic> _decode(Map<String, dynamic> data) {
+  return jsonDecode(jsonEncode(data)) as Map<String, dynamic>;
+}
+
+Future<void> _copyDirectory(Directory source, Directory destination) async {
+  await destination.create(recursive: true);
+
+  await for (final entity in source.list(recursive: false)) {
+    final targetPath = path.join(destination.path, path.basename(entity.path));
+    if (entity is Directory) {
+      await _copyDirectory(entity, Directory(targetPath));
+    } else if (entity is File) {
+      await entity.copy(targetPath);
+    }
+  }
+}
@@ -0,0 +1,37 @@
+import 'dart:ui';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:vertree/view/component/tree/SpatialGridIndex.dart';
+
+void main() {
+  group('SpatialGridIndex', () {
+    test('returns only items overlapping the query area', () {
+      final index = SpatialGridIndex<String>(cellSize: 100);
+      index.insert('a', const Rect.fromLTWH(10, 10, 50, 50));
+      index.insert('b', const Rect.fromLTWH(250, 10, 50, 50));
+      index.insert('wide', const Rect.fromLTWH(-150, 200, 600, 40));
+
+      expect(index.query(const Rect.fromLTWH(0, 0, 100, 100)), ['a']);
+      expect(
+        index.query(const Rect.fromLTWH(0, 0, 400, 300)),
+        unorderedEquals(['a', 'b', 'wide']),
+      );
+      expect(index.query(const Rect.fromLTWH(-140, 210, 10, 10)), ['wide']);
+      expect(index.query(const Rect.fromLTWH(1000, 1000, 10, 10)), isEmpty);
+    });
+
+    test('moves items when they are re-inserted and forgets removed ones', () {
+      final index = SpatialGridIndex<int>(cellSize: 64);
+      index.insert(1, const Rect.fromLTWH(0, 0, 10, 10));
+      index.insert(1, const Rect.fromLTWH(500, 500, 10, 10));
+
+      expect(index.length, 1);
+      expect(index.query(const Rect.fromLTWH(0, 0, 20, 20)), isEmpty);
+      expect(index.query(const Rect.fromLTWH(490, 490, 30, 30)), [1]);
+
+      index.remove(1);
+      expect(index.length, 0);
+      expect(index.query(const Rect.fromLTWH(490, 490, 30, 30)), isEmpty);
+    });
+  });
+}
@@ -0,0 +1,240 @@
+import 'package:flutter/gestures.dart';
+import 'package:flutter/material.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:vertree/view/component/tree/Canvas.dart';
+import 'package:vertree/view/component/tree/CanvasComponent.dart';
+import 'package:vertree/view/component/tree/CanvasManager.dart';
+import 'package:vertree/view/component/tree/EdgePainter.dart';
+
+/// 在 1k / 10k / 50k 个节点（以及同等数量连线）上测量 TreeCanvas 的首帧与平移帧耗时。
+///
+/// 运行 `flutter test test/view/tree_canvas_benchmark_test.dart` 查看输出。
+void main() {
+  const viewportSize = Size(1200, 800);
+  const nodeSize = Size(160, 56);
+  const columns = 250;
+  const horizontalPitch = 200.0;
+  const verticalPitch = 90.0;
+
+  /// 按网格排列 [nodeCount] 个节点，同一行相邻节点之间连线
+  (List<CanvasComponentContainer>, List<Edge>, Size) buildScene(
+    TreeCanvasManager manager,
+    int nodeCount,
+  ) {
+    final containers = <CanvasComponentContainer>[];
+    final edges = <Edge>[];
+    GlobalKey<CanvasComponentState>? previousKey;
+    Rect? previousBounds;
+    for (var index = 0; index < nodeCount; index++) {
+      final position = Offset(
+        (index % columns) * horizontalPitch,
+        (index ~/ columns) * verticalPitch,
+      );
+      final key = GlobalKey<CanvasComponentState>();
+      final bounds = position & nodeSize;
+      containers.add(
+        CanvasComponentContainer.component(
+          _BenchmarkNode(
+            key: key,
+            treeCanvasManager: manager,
+            position: position,
+            componentId: 'node-$index',
+          ),
+          bounds: bounds,
+        ),
+      );
+      if (previousKey != null && index % columns != 0) {
+        edges.add(
+          Edge(
+            previousKey,
+            key,
+            id: 'node-${index - 1}->node-$index',
+            startCenter: previousBounds!.center,
+            endCenter: bounds.center,
+          ),
+        );
+      }
+      previousKey = key;
+      previousBounds = bounds;
+    }
+    final rows = (nodeCount / columns).ceil();
+    return (
+      containers,
+      edges,
+      Size(columns * horizontalPitch, rows * verticalPitch),
+    );
+  }
+
+  for (final nodeCount in const [1000, 10000, 50000]) {
+    testWidgets('pans a $nodeCount node tree building only visible nodes', (
+      tester,
+    ) async {
+      tester.view.physicalSize = viewportSize;
+      tester.view.devicePixelRatio = 1;
+      addTearDown(tester.view.reset);
+
+      final manager = TreeCanvasManager();
+      final (containers, edges, sceneSize) = buildScene(manager, nodeCount);
+
+      final initialBuild = Stopwatch()..start();
+      await tester.pumpWidget(
+        MaterialApp(
+          home: Scaffold(
+            body: TreeCanvas(
+              manager: manager,
+              width: viewportSize.width,
+              height: viewportSize.height,
+              sceneSize: sceneSize,
+              children: containers,
+              edges: edges,
+              refresh: () async {},
+            ),
+          ),
+        ),
+      );
+      initialBuild.stop();
+
+      final mountedAfterBuild = find
+          .byType(_BenchmarkNode, skipOffstage: false)
+          .evaluate()
+          .length;
+
+      final gesture = await tester.startGesture(
+        tester.getCenter(find.byType(TreeCanvas)),
+      );
+      await gesture.moveBy(const Offset(-40, -20));
+      await tester.pump();
+
+      final frameTimes = <double>[];
+      for (var frame = 0; frame < 60; frame++) {
+        await gesture.moveBy(const Offset(-45, -18));
+        final stopwatch = Stopwatch()..start();
+        await tester.pump();
+        stopwatch.stop();
+        frameTimes.add(stopwatch.elapsedMicroseconds / 1000);
+      }
+      await gesture.up();
+      await tester.pump();
+
+      final mountedAfterPan = find
+          .byType(_BenchmarkNode, skipOffstage: false)
+          .evaluate()
+          .length;
+
+      frameTimes.sort();
+      double percentile(double p) =>
+          frameTimes[((frameTimes.length - 1) * p).round()];
+      // ignore: avoid_print
+      print(
+        'TreeCanvas nodes=$nodeCount edges=${edges.length} '
+        'initialBuildMs=${initialBuild.elapsedMilliseconds} '
+        'panFrameMs p50=${percentile(0.5).toStringAsFixed(2)} '
+        'p90=${percentile(0.9).toStringAsFixed(2)} '
+        'max=${frameTimes.last.toStringAsFixed(2)} '
+        'mounted=$mountedAfterBuild/$mountedAfterPan',
+      );
+
+      // 视口（含外扩边距）大约容纳 12 列 × 15 行，节点再多也只构建这一小部分
+      expect(mountedAfterBuild, lessThan(400));
+      expect(mountedAfterPan, lessThan(400));
+      expect(mountedAfterBuild, greaterThan(0));
+    });
+  }
+
+  testWidgets('draws a zoomed-out 50000 node tree without building cards', (
+    tester,
+  ) async {
+    tester.view.physicalSize = viewportSize;
+    tester.view.devicePixelRatio = 1;
+    addTearDown(tester.view.reset);
+
+    final manager = TreeCanvasManager();
+    final (containers, edges, sceneSize) = buildScene(manager, 50000);
+    await tester.pumpWidget(
+      MaterialApp(
+        home: Scaffold(
+          body: TreeCanvas(
+            manager: manager,
+            width: viewportSize.width,
+            height: viewportSize.height,
+            sceneSize: sceneSize,
+            children: containers,
+            edges: edges,
+            refresh: () async {},
+          ),
+        ),
+      ),
+    );
+    manager.setScale(0.2);
+    await tester.pump();
+
+    int mountedNodes() =>
+        find.byType(_BenchmarkNode, skipOffstage: false).evaluate().length;
+    expect(mountedNodes(), 0);
+
+    final gesture = await tester.startGesture(
+      tester.getCenter(find.byType(TreeCanvas)),
+    );
+    final frameTimes = <double>[];
+    for (var frame = 0; frame < 60; frame++) {
+      await gesture.moveBy(const Offset(-45, -18));
+      final stopwatch = Stopwatch()..start();
+      await tester.pump();
+      stopwatch.stop();
+      frameTimes.add(stopwatch.elapsedMicroseconds / 1000);
+    }
+    await gesture.up();
+    await tester.pump();
+    expect(mountedNodes(), 0);
+
+    frameTimes.sort();
+    // ignore: avoid_print
+    print(
+      'TreeCanvas overview nodes=50000 '
+      'panFrameMs p50=${frameTimes[frameTimes.length ~/ 2].toStringAsFixed(2)} '
+      'max=${frameTimes.last.toStringAsFixed(2)}',
+    );
+
+    // 悬停到某个色块上时只构建这一张卡片
+    final origin = tester.getTopLeft(find.byType(TreeCanvas));
+    final mouse = await tester.createGesture(kind: PointerDeviceKind.mouse);
+    addTearDown(mouse.removePointer);
+    await mouse.addPointer(location: origin + const Offset(600, 400));
+    await mouse.moveTo(origin + const Offset(601, 401));
+    await tester.pump();
+    expect(mountedNodes(), lessThanOrEqualTo(1));
+
+    await mouse.moveTo(origin + const Offset(5000, 5000));
+    await tester.pump();
+    expect(mountedNodes(), 0);
+  });
+}
+
+class _BenchmarkNode extends CanvasComponent {
+  _BenchmarkNode({
+    required super.key,
+    required super.treeCanvasManager,
+    super.position,
+    super.componentId,
+  });
+
+  @override
+  _BenchmarkNodeState createState() => _BenchmarkNodeState();
+}
+
+class _BenchmarkNodeState extends CanvasComponentState<_BenchmarkNode> {
+  @override
+  Widget buildComponent() {
+    return SizedBox(
+      width: 160,
+      height: 56,
+      child: DecoratedBox(
+        decoration: BoxDecoration(
+          color: Colors.blueGrey.shade50,
+          borderRadius: BorderRadius.circular(8),
+        ),
+        child: Center(child: Text(widget.id)),
+      ),
+    );
+  }
+}
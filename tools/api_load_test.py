@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""Load generator for the local Vertree HTTP API.
+
+Sends requests from several worker threads and reports requests per second
+plus latency percentiles. Each worker either reuses one keep-alive
+connection (default) or opens a new connection per request, so the same
+script measures connection reuse against the previous behaviour. Results can
+be written as JSON and compared against an earlier run.
+
+Examples:
+
+    python tools/api_load_test.py --requests 5000 --concurrency 8
+    python tools/api_load_test.py --path /version-trees --query path=D:/a/b.0.1.txt
+    python tools/api_load_test.py --output after.json --baseline before.json
+"""
+
+from __future__ import annotations
+
+import argparse
+import http.client
+import json
+import socket
+import statistics
+import sys
+import threading
+import time
+import urllib.parse
+from pathlib import Path
+from typing import Any
+
+
+DEFAULT_HOST = "127.0.0.1"
+DEFAULT_PORT = 31414
+API_PREFIX = "/api/v1"
+
+
+class _Worker(threading.Thread):
+    def __init__(
+        self,
+        *,
+        host: str,
+        port: int,
+        method: str,
+        target: str,
+        body: bytes | None,
+        keep_alive: bool,
+        requests: int,
+        timeout: float,
+    ) -> None:
+        super().__init__(daemon=True)
+        self._host = host
+        self._port = port
+        self._method = method
+        self._target = target
+        self._body = body
+        self._keep_alive = keep_alive
+        self._requests = requests
+        self._timeout = timeout
+        self.latencies_ms: list[float] = []
+        self.errors = 0
+        self.status_counts: dict[int, int] = {}
+        self.connections_opened = 0
+
+    def _connect(self) -> http.client.HTTPConnection:
+        self.connections_opened += 1
+        connection = http.client.HTTPConnection(
+            self._host, self._port, timeout=self._timeout
+        )
+        connection.connect()
+        # Small request/response pairs on a reused connection otherwise hit
+        # Nagle + delayed ACK stalls that would dominate the measurement.
+        connection.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        return connection
+
+    def run(self) -> None:
+        headers = {"Connection": "keep-alive" if self._keep_alive else "close"}
+        if self._body is not None:
+            headers["Content-Type"] = "application/json"
+
+        connection: http.client.HTTPConnection | None = None
+        for _ in range(self._requests):
+            if connection is None:
+                connection = self._connect()
+            started = time.perf_counter()
+            try:
+                connection.request(
+                    self._method, self._target, body=self._body, headers=headers
+                )
+                response = connection.getresponse()
+                response.read()
+                elapsed = (time.perf_counter() - started) * 1000
+                self.latencies_ms.append(elapsed)
+                self.status_counts[response.status] = (
+                    self.status_counts.get(response.status, 0) + 1
+                )
+                if response.status >= 500:
+                    self.errors += 1
+                if not self._keep_alive or response.will_close:
+                    connection.close()
+                    connection = None
+            except (OSError, http.client.HTTPException):
+                self.errors += 1
+                if connection is not None:
+                    connection.close()
+                connection = None
+        if connection is not None:
+            connection.close()
+
+
+def _percentile(sorted_values: list[float], percentile: float) -> float:
+    if not sorted_values:
+        return 0.0
+    rank = max(0, min(len(sorted_values) - 1, round(percentile * (len(sorted_values) - 1))))
+    return sorted_values[rank]
+
+
+def _build_target(path: str, query: list[str]) -> str:
+    normalized = path if path.startswith("/") else f"/{path}"
+    if not normalized.startswith(API_PREFIX):
+        normalized = f"{API_PREFIX}{normalized.rstrip('/') if normalized != '/' else ''}"
+    pairs = []
+    for item in query:
+        key, _, value = item.partition("=")
+        pairs.append((key, value))
+    if pairs:
+        normalized = f"{normalized}?{urllib.parse.urlencode(pairs)}"
+    return normalized
+
+
+def run_load(args: argparse.Namespace) -> dict[str, Any]:
+    target = _build_target(args.path, args.query)
+    body = args.body.encode("utf-8") if args.body is not None else None
+    per_worker = max(1, args.requests // args.concurrency)
+    workers = [
+        _Worker(
+            host=args.host,
+            port=args.port,
+            method=args.method,
+            target=target,
+            body=body,
+            keep_alive=not args.no_keep_alive,
+            requests=per_worker,
+            timeout=args.timeout,
+        )
+        for _ in range(args.concurrency)
+    ]
+
+    # Warm up once so route compilation and caches are not part of the run.
+    warmup = _Worker(
+        host=args.host,
+        port=args.port,
+        method=args.method,
+        target=target,
+        body=body,
+        keep_alive=True,
+        requests=min(20, per_worker),
+        timeout=args.timeout,
+    )
+    warmup.run()
+
+    started = time.perf_counter()
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    wall_seconds = time.perf_counter() - started
+
+    latencies = sorted(
+        latency for worker in workers for latency in worker.latencies_ms
+    )
+    status_counts: dict[str, int] = {}
+    for worker in workers:
+        for status, count in worker.status_counts.items():
+            status_counts[str(status)] = status_counts.get(str(status), 0) + count
+
+    completed = len(latencies)
+    return {
+        "target": f"{args.method} {target}",
+        "keepAlive": not args.no_keep_alive,
+        "concurrency": args.concurrency,
+        "requests": completed,
+        "errors": sum(worker.errors for worker in workers),
+        "connectionsOpened": sum(worker.connections_opened for worker in workers),
+        "statusCounts": status_counts,
+        "wallSeconds": round(wall_seconds, 4),
+        "requestsPerSecond": round(completed / wall_seconds, 1) if wall_seconds else 0,
+        "latencyMs": {
+            "min": round(latencies[0], 3) if latencies else 0,
+            "mean": round(statistics.fmean(latencies), 3) if latencies else 0,
+            "p50": round(_percentile(latencies, 0.50), 3),
+            "p90": round(_percentile(latencies, 0.90), 3),
+            "p99": round(_percentile(latencies, 0.99), 3),
+            "max": round(latencies[-1], 3) if latencies else 0,
+        },
+    }
+
+
+def _print_report(report: dict[str, Any], baseline: dict[str, Any] | None) -> None:
+    latency = report["latencyMs"]
+    print(f"target           {report['target']}")
+    print(f"keep-alive       {report['keepAlive']}")
+    print(f"concurrency      {report['concurrency']}")
+    print(f"requests         {report['requests']} ({report['errors']} errors)")
+    print(f"connections      {report['connectionsOpened']}")
+    print(f"requests/sec     {report['requestsPerSecond']}")
+    print(
+        "latency ms       "
+        f"p50={latency['p50']} p90={latency['p90']} p99={latency['p99']} max={latency['max']}"
+    )
+    if baseline is None:
+        return
+
+    base_rps = baseline.get("requestsPerSecond") or 0
+    base_p99 = (baseline.get("latencyMs") or {}).get("p99") or 0
+    if base_rps:
+        change = (report["requestsPerSecond"] - base_rps) / base_rps * 100
+        print(f"vs baseline rps  {base_rps} -> {report['requestsPerSecond']} ({change:+.1f}%)")
+    if base_p99:
+        change = (latency["p99"] - base_p99) / base_p99 * 100
+        print(f"vs baseline p99  {base_p99} -> {latency['p99']} ms ({change:+.1f}%)")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default=DEFAULT_HOST)
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--method", default="GET")
+    parser.add_argument(
+        "--path",
+        default="/health",
+        help="API path, with or without the /api/v1 prefix (default: /health)",
+    )
+    parser.add_argument(
+        "--query",
+        action="append",
+        default=[],
+        metavar="KEY=VALUE",
+        help="query parameter, may be repeated",
+    )
+    parser.add_argument("--body", help="raw JSON request body")
+    parser.add_argument("--requests", type=int, default=2000)
+    parser.add_argument("--concurrency", type=int, default=4)
+    parser.add_argument("--timeout", type=float, default=10.0)
+    parser.add_argument(
+        "--no-keep-alive",
+        action="store_true",
+        help="open a new connection for every request",
+    )
+    parser.add_argument("--output", type=Path, help="write the JSON report here")
+    parser.add_argument(
+        "--baseline", type=Path, help="compare against an earlier JSON report"
+    )
+    args = parser.parse_args()
+
+    if args.concurrency < 1 or args.requests < 1:
+        parser.error("--requests and --concurrency must be positive")
+
+    try:
+        report = run_load(args)
+    except ConnectionRefusedError:
+        print(
+            f"Cannot connect to {args.host}:{args.port}; is the local HTTP API enabled?",
+            file=sys.stderr,
+        )
+        return 1
+
+    baseline = None
+    if args.baseline is not None:
+        baseline = json.loads(args.baseline.read_text(encoding="utf-8"))
+    _print_report(report, baseline)
+
+    if args.output is not None:
+        args.output.write_text(json.dumps(report, indent=2), encoding="utf-8")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -353,11 +353,26 @@ std::wstring BuildArgs(const std::wstring& verb, const std::wstring& path) {
   return std::wstring(verb) + L" " + quoted;
 }
 
-std::wstring GetFirstItemPath(IShellItemArray* items) {
+// ShellExecute passes at most 32767 characters to the new process; leave
+// room for the quoted executable path.
+constexpr size_t kMaxArgsLength = 30000;
+
+// Verbs the app can run on a multi-selection as one batch.
+bool IsBatchVerb(const std::wstring& verb) {
+  return verb == kCmdBackup || verb == kCmdExpressBackup || verb == kCmdMonitor;
+}
+
+DWORD GetItemCount(IShellItemArray* items) {
+  DWORD count = 0;
+  if (!items || FAILED(items->GetCount(&count))) return 0;
+  return count;
+}
+
+std::wstring GetItemPath(IShellItemArray* items, DWORD index) {
   if (!items) return L"";
   IShellItem* item = nullptr;
-  if (FAILED(items->GetItemAt(0, &item)) || !item) {
-    LogLine(L"GetFirstItemPath: GetItemAt failed");
+  if (FAILED(items->GetItemAt(index, &item)) || !item) {
+    LogLine(L"GetItemPath: GetItemAt failed");
     return L"";
   }
   wchar_t* path = nullptr;
@@ -368,11 +383,46 @@ std::wstring GetFirstItemPath(IShellItemArray* items) {
   }
   item->Release();
   if (result.empty()) {
-    LogLine(L"GetFirstItemPath: empty path");
+    LogLine(L"GetItemPath: empty path");
   }
   return result;
 }
 
+std::wstring GetFirstItemPath(IShellItemArray* items) {
+  return GetItemPath(items, 0);
+}
+
+std::vector<std::wstring> GetItemPaths(IShellItemArray* items) {
+  std::vector<std::wstring> paths;
+  const DWORD count = GetItemCount(items);
+  paths.reserve(count);
+  for (DWORD i = 0; i < count; ++i) {
+    std::wstring path = GetItemPath(items, i);
+    if (!path.empty()) paths.push_back(std::move(path));
+  }
+  return paths;
+}
+
+// Splits a multi-selection into as few command lines as fit the limit,
+// normally just one. The app merges launches that arrive together into one
+// batch.
+std::vector<std::wstring> BuildBatchArgs(const std::wstring& verb,
+                                         const std::vector<std::wstring>& paths) {
+  std::vector<std::wstring> commands;
+  std::wstring args;
+  for (const std::wstring& path : paths) {
+    const std::wstring quoted = L" \"" + path + L"\"";
+    if (!args.empty() && args.size() + quoted.size() > kMaxArgsLength) {
+      commands.push_back(std::move(args));
+      args.clear();
+    }
+    if (args.empty()) args = verb;
+    args += quoted;
+  }
+  if (!args.empty()) commands.push_back(std::move(args));
+  return commands;
+}
+
 class ComObjectBase {
  public:
   ComObjectBase() { InterlockedIncrement(&g_module_lock); }
@@ -452,10 +502,12 @@ class LeafCommand : public IExplorerCommand, public ComObjectBase {
     return S_OK;
   }
 
-  HRESULT STDMETHODCALLTYPE GetState(IShellItemArray*, BOOL, EXPCMDSTATE* state) override {
+  HRESULT STDMETHODCALLTYPE GetState(IShellItemArray* items, BOOL, EXPCMDSTATE* state) override {
     LogLine(L"LeafCommand GetState");
     if (!state) return E_POINTER;
-    const bool enabled = IsWin11MenuEnabled();
+    // Share and view tree act on one file; hide them for a multi-selection.
+    const bool enabled = IsWin11MenuEnabled() &&
+                         (IsBatchVerb(verb_) || GetItemCount(items) <= 1);
     *state = enabled ? ECS_ENABLED : ECS_HIDDEN;
     return S_OK;
   }
@@ -463,6 +515,16 @@ class LeafCommand : public IExplorerCommand, public ComObjectBase {
   HRESULT STDMETHODCALLTYPE Invoke(IShellItemArray* items, IBindCtx*) override {
     LogLine(L"LeafCommand Invoke");
     if (!items) return E_FAIL;
+    if (IsBatchVerb(verb_) && GetItemCount(items) > 1) {
+      const std::vector<std::wstring> paths = GetItemPaths(items);
+      if (paths.empty()) return E_FAIL;
+      bool ok = true;
+      for (const std::wstring& args : BuildBatchArgs(verb_, paths)) {
+        ok = LaunchAppWithArgs(args) && ok;
+      }
+      LogLine(ok ? L"LeafCommand Invoke batch ok" : L"LeafCommand Invoke batch failed");
+      return ok ? S_OK : E_FAIL;
+    }
     std::wstring path = GetFirstItemPath(items);
     if (path.empty()) return E_FAIL;
     std::wstring args = BuildArgs(verb_, path);